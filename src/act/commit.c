@@ -12,6 +12,7 @@
 #include "../base/table.h"
 #include "../base/sum.h"
 #include <limits.h>
+#include <string.h>
 
 
 struct ledger_commit_pair {
@@ -239,8 +240,25 @@ int ledger_commit_acquire_lines
         unsigned char check_number[64];
         int ledger_index, account_index;
         int ledger_id, account_id;
-        ledger_table_fetch_id(act_mark, 0, &ledger_index);
-        ledger_table_fetch_id(act_mark, 1, &account_index);
+        /* fetch the transaction line */{
+          struct ledger_table_field line[4];
+          memset(line, 0, sizeof(line));
+          line[0].column = 0;
+          line[0].type = LEDGER_TABLE_ID;
+          line[1].column = 1;
+          line[1].type = LEDGER_TABLE_ID;
+          line[2].column = 3;
+          line[2].type = LEDGER_TABLE_BIGNUM;
+          line[2].bignum = tmp_bignum;
+          line[3].column = 4;
+          line[3].type = LEDGER_TABLE_USTR;
+          line[3].buf = check_number;
+          line[3].len = sizeof(check_number);
+          if (!ledger_table_fetch_row(act_mark, 4, line)) break;
+          if (line[3].text_length >= (int)sizeof(check_number)) break;
+          ledger_index = line[0].id;
+          account_index = line[1].id;
+        }
         /* allocate the account row */{
           int ok;
           struct ledger_ledger* ledger =
@@ -259,38 +277,35 @@ int ledger_commit_acquire_lines
           if (!ok){
             ledger_table_mark_free(next_mark);
             break;
-          } else do {
-            /* push the information */
-            /* journal identifier */{
-              ok = ledger_table_put_id(next_mark, 0, journal_id);
-              if (!ok) break;
-            }
-            /* entry identifier */{
-              ok = ledger_table_put_id(next_mark, 1, commit->entry_id);
-              if (!ok) break;
-            }
-            /* amount */{
-              ok = ledger_table_fetch_bignum(act_mark, 3, tmp_bignum);
-              if (!ok) break;
-              ok = ledger_table_put_bignum(next_mark, 2, tmp_bignum);
-              if (!ok) break;
-            }
-            /* check number */{
-              unsigned char check_number[64];
-              ok = ledger_table_fetch_string
-                (act_mark, 4, check_number, sizeof(check_number));
-              if (ok < 0 || ok >= sizeof(check_number)) break;
-              ok = ledger_table_put_string(next_mark, 3, check_number);
-              if (!ok) break;
-            }
-            /* date */{
-              ok = ledger_table_put_string(next_mark, 4, date);
-              if (!ok) break;
-            }
-          } while (0);
+          } else /* push the information */{
+            struct ledger_table_field row[5];
+            memset(row, 0, sizeof(row));
+            /* journal identifier */
+            row[0].column = 0;
+            row[0].type = LEDGER_TABLE_ID;
+            row[0].id = journal_id;
+            /* entry identifier */
+            row[1].column = 1;
+            row[1].type = LEDGER_TABLE_ID;
+            row[1].id = commit->entry_id;
+            /* amount */
+            row[2].column = 2;
+            row[2].type = LEDGER_TABLE_BIGNUM;
+            row[2].bignum = tmp_bignum;
+            /* check number */
+            row[3].column = 3;
+            row[3].type = LEDGER_TABLE_USTR;
+            row[3].text = check_number;
+            /* date */
+            row[4].column = 4;
+            row[4].type = LEDGER_TABLE_USTR;
+            row[4].text = date;
+            ok = ledger_table_put_row(next_mark, 5, row);
+          }
           if (!ok){
             ledger_table_drop_row(next_mark);
             ledger_table_mark_free(next_mark);
+            break;
           } else {
             /* persist the mark */
             commit->pairs[i].ledger = next_mark;
@@ -306,41 +321,35 @@ int ledger_commit_acquire_lines
           if (!ok){
             ledger_table_mark_free(next_mark);
             break;
-          } else do {
-            /* push the information */
-            /* entry identifier */{
-              ok = ledger_table_put_id(next_mark, 0, commit->entry_id);
-              if (!ok) break;
-            }
-            /* ledger identifier */{
-              ok = ledger_table_put_id(next_mark, 1, ledger_id);
-              if (!ok) break;
-            }
-            /* account identifier */{
-              ok = ledger_table_put_id(next_mark, 2, account_id);
-              if (!ok) break;
-            }
-            /* amount */{
-              /*
-              ok = ledger_table_fetch_bignum(act_mark, 3, tmp_bignum);
-              if (!ok) break;
-              */
-              ok = ledger_table_put_bignum(next_mark, 3, tmp_bignum);
-              if (!ok) break;
-            }
-            /* check number */{
-              /*
-              ok = ledger_table_fetch_string
-                (act_mark, 4, check_number, sizeof(check_number));
-              if (ok < 0 || ok >= sizeof(check_number)) break;
-              */
-              ok = ledger_table_put_string(next_mark, 4, check_number);
-              if (!ok) break;
-            }
-          } while (0);
+          } else /* push the information */{
+            struct ledger_table_field row[5];
+            memset(row, 0, sizeof(row));
+            /* entry identifier */
+            row[0].column = 0;
+            row[0].type = LEDGER_TABLE_ID;
+            row[0].id = commit->entry_id;
+            /* ledger identifier */
+            row[1].column = 1;
+            row[1].type = LEDGER_TABLE_ID;
+            row[1].id = ledger_id;
+            /* account identifier */
+            row[2].column = 2;
+            row[2].type = LEDGER_TABLE_ID;
+            row[2].id = account_id;
+            /* amount */
+            row[3].column = 3;
+            row[3].type = LEDGER_TABLE_BIGNUM;
+            row[3].bignum = tmp_bignum;
+            /* check number */
+            row[4].column = 4;
+            row[4].type = LEDGER_TABLE_USTR;
+            row[4].text = check_number;
+            ok = ledger_table_put_row(next_mark, 5, row);
+          }
           if (!ok){
             ledger_table_drop_row(next_mark);
             ledger_table_mark_free(next_mark);
+            break;
           } else {
             /* persist the mark */
             commit->pairs[i].journal = next_mark;
@@ -405,12 +414,19 @@ void ledger_commit_rollback
   int const journal_index = ledger_transaction_get_journal(act);
   struct ledger_journal* const active_journal =
     ledger_book_get_journal(book, journal_index);
+  struct ledger_table* const active_j_table =
+    ledger_journal_get_table(active_journal);
+  int const tombstones_tf = ledger_table_get_tombstones(active_j_table);
+  /* every line lands in the journal, so compact it once at the end */
+  ledger_table_set_tombstones(active_j_table, 1);
   for (i = 0; i < commit->pair_count; ++i){
     if (commit->pairs[i].ledger != NULL)
       ledger_table_drop_row(commit->pairs[i].ledger);
     if (commit->pairs[i].journal != NULL)
       ledger_table_drop_row(commit->pairs[i].journal);
   }
+  ledger_table_vacuum(active_j_table);
+  ledger_table_set_tombstones(active_j_table, tombstones_tf);
   result = ledger_journal_set_entry_count
     (active_journal, commit->entry_index);
   if (!result){
@@ -430,14 +446,22 @@ int ledger_commit_transaction
 {
   int result;
   struct ledger_commit commit;
+  /* readers holding the book see the whole transaction or none of it */
+  ledger_book_write_lock(book);
   /* first pass: resolve account names */{
     result = ledger_commit_verify(book, act);
-    if (!result) return 0;
+    if (!result){
+      ledger_book_write_unlock(book);
+      return 0;
+    }
   }
   ledger_commit_init(&commit);
   /* second pass: confirm journal entry */{
     result = ledger_commit_acquire_entry(&commit, book, act);
-    if (!result) return 0;
+    if (!result){
+      ledger_book_write_unlock(book);
+      return 0;
+    }
   }
   /* third pass: allocate lines across accounts and journal tables */do {
     result = ledger_commit_acquire_lines(&commit, book, act);
@@ -447,6 +471,7 @@ int ledger_commit_transaction
     ledger_commit_rollback(&commit, book, act);
   }
   ledger_commit_clear(&commit);
+  ledger_book_write_unlock(book);
   return result;
 }
 
@@ -14,7 +14,8 @@ struct ledger_transaction;
 struct ledger_book;
 
 /*
- * Apply a transaction to a book.
+ * Apply a transaction to a book. The book stays locked for writing
+ * until the transaction is fully applied.
  * - book the book into which to write
  * - act the transaction to apply
  * @return one on success, zero otherwise
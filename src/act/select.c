@@ -12,7 +12,7 @@
  * @return nonzero if the check passes, zero otherwise
  */
 int ledger_select_check_cond
-  ( struct ledger_table_mark* m, struct ledger_select_cond cnd);
+  ( struct ledger_table_mark const* m, struct ledger_select_cond cnd);
 
 /*
  * Check a table row against a condition.
@@ -23,7 +23,7 @@ int ledger_select_check_cond
  * @return a possibly-allocated string on success,
  */
 unsigned char* ledger_select_buf_fetch_str
-  ( struct ledger_table_mark* m, int i, unsigned char* buf, int len);
+  ( struct ledger_table_mark const* m, int i, unsigned char* buf, int len);
 
 /*
  * Free a possibly-allocated string.
@@ -33,12 +33,56 @@ unsigned char* ledger_select_buf_fetch_str
 void ledger_select_buf_free
   (unsigned char* ptr, unsigned char* buf);
 
+/*
+ * Check a table row against several conditions.
+ * - m a mark pointing to the row to check
+ * - len length of selector conditions
+ * - cond condition array
+ * @return one if all checks pass, zero if a check fails,
+ *   or negative one on error
+ */
+int ledger_select_check_all
+  ( struct ledger_table_mark const* m,
+    int len, struct ledger_select_cond const cond[]);
+
+/*
+ * Find candidate rows through the first condition that can use
+ * a secondary column index.
+ * - t table to search
+ * - len length of selector conditions
+ * - cond condition array
+ * - positions array to receive the candidate row positions,
+ *   in ascending order
+ * @return the number of candidates, or negative one if the
+ *   whole table must be searched
+ */
+int ledger_select_index_find
+  ( struct ledger_table const* t, int len,
+    struct ledger_select_cond const cond[], int** positions);
 
 
+/*
+ * Mark the rows that pass every condition that a column filter can
+ * check (see `ledger_table_filter_column`).
+ * - t table to search
+ * - len length of selector conditions
+ * - cond condition array
+ * - bits bitmap of at least `ledger_table_count_rows(t)/8+1` bytes,
+ *   to receive one bit per row position
+ * - rest array of `len` conditions, to receive the conditions left
+ *   to check row by row
+ * @return the number of conditions left to check row by row, or -1
+ *   if no condition can use a column filter
+ */
+int ledger_select_filter_find
+  ( struct ledger_table const* t, int len,
+    struct ledger_select_cond const cond[], unsigned char* bits,
+    struct ledger_select_cond rest[]);
+
 /* BEGIN static implementation */
 
 unsigned char* ledger_select_buf_fetch_str
-  ( struct ledger_table_mark* m, int i, unsigned char* buf, int len)
+  ( struct ledger_table_mark const* m, int i, unsigned char* buf, int len)
 {
   int used_length;
   used_length = ledger_table_fetch_string(m, i, buf, len);
@@ -60,7 +104,7 @@ void ledger_select_buf_free(unsigned char* ptr, unsigned char* buf){
 }
 
 int ledger_select_check_cond
-  ( struct ledger_table_mark* m, struct ledger_select_cond cnd)
+  ( struct ledger_table_mark const* m, struct ledger_select_cond cnd)
 {
   int yes;
   switch (cnd.cmp&(~15u)){
@@ -193,6 +237,41 @@ int ledger_select_check_cond
       ledger_bignum_free(cnd_value);
       ledger_bignum_free(bignum_stash);
     }break;
+  case LEDGER_SELECT_DATE:
+    {
+      long long int cnd_value, date_stash;
+      if (!ledger_util_date_from_text(cnd.value, &cnd_value)
+      ||  !ledger_table_fetch_date(m, cnd.column, &date_stash))
+      {
+        yes = -1;
+      } else {
+        int const sign = (date_stash < cnd_value)
+          ? -1 : (date_stash > cnd_value ? +1 : 0);
+        switch (cnd.cmp&15u){
+        case LEDGER_SELECT_EQUAL:
+          yes = (sign == 0) ? 1 : 0;
+          break;
+        case LEDGER_SELECT_LESS:
+          yes = (sign < 0) ? 1 : 0;
+          break;
+        case LEDGER_SELECT_MORE:
+          yes = (sign > 0) ? 1 : 0;
+          break;
+        case LEDGER_SELECT_NOTEQUAL:
+          yes = (sign != 0) ? 1 : 0;
+          break;
+        case LEDGER_SELECT_NOTLESS:
+          yes = (sign >= 0) ? 1 : 0;
+          break;
+        case LEDGER_SELECT_NOTMORE:
+          yes = (sign <= 0) ? 1 : 0;
+          break;
+        default:
+          yes = 0;
+          break;
+        }
+      }
+    }break;
   case LEDGER_SELECT_STRING:
   default:
     switch (cnd.cmp&15u){
@@ -271,6 +350,169 @@ int ledger_select_check_cond
   return yes;
 }
 
+int ledger_select_check_all
+  ( struct ledger_table_mark const* m,
+    int len, struct ledger_select_cond const cond[])
+{
+  int cond_i;
+  int yes = 1;
+  for (cond_i = 0; yes == 1 && cond_i < len; ++cond_i){
+    yes = ledger_select_check_cond(m, cond[cond_i]);
+  }
+  return yes;
+}
+
+int ledger_select_index_find
+  ( struct ledger_table const* t, int len,
+    struct ledger_select_cond const cond[], int** positions)
+{
+  int cond_i;
+  for (cond_i = 0; cond_i < len; ++cond_i){
+    struct ledger_select_cond const* const cnd = cond+cond_i;
+    int const kind = ledger_table_get_column_index(t, cnd->column);
+    int const type = ledger_table_get_column_type(t, cnd->column);
+    struct ledger_table_field bound;
+    if (kind == 0) continue;
+    bound.column = cnd->column;
+    bound.id = -1;
+    bound.date = -1;
+    bound.text = NULL;
+    /* the index must sort the way the condition compares */
+    switch (cnd->cmp&(~15u)){
+    case LEDGER_SELECT_ID:
+    case LEDGER_SELECT_INDEX:
+      if (type != LEDGER_TABLE_ID && type != LEDGER_TABLE_INDEX)
+        continue;
+      bound.type = LEDGER_TABLE_ID;
+      bound.id = ledger_util_atoi(cnd->value);
+      break;
+    case LEDGER_SELECT_STRING:
+      if (type != LEDGER_TABLE_USTR || cnd->value == NULL)
+        continue;
+      bound.type = LEDGER_TABLE_USTR;
+      bound.text = cnd->value;
+      break;
+    case LEDGER_SELECT_DATE:
+      if (type != LEDGER_TABLE_DATE
+      ||  !ledger_util_date_from_text(cnd->value, &bound.date))
+        continue;
+      bound.type = LEDGER_TABLE_DATE;
+      break;
+    default:
+      continue;
+    }
+    switch (cnd->cmp&15u){
+    case LEDGER_SELECT_EQUAL:
+      return ledger_table_find_in_column_index
+        (t, cnd->column, &bound, 1, &bound, 1, positions);
+    case LEDGER_SELECT_LESS:
+    case LEDGER_SELECT_NOTMORE:
+      if (kind != LEDGER_TABLE_ORDERED_INDEX) continue;
+      return ledger_table_find_in_column_index
+        ( t, cnd->column, NULL, 0,
+          &bound, (cnd->cmp&15u) == LEDGER_SELECT_NOTMORE, positions);
+    case LEDGER_SELECT_MORE:
+    case LEDGER_SELECT_NOTLESS:
+      if (kind != LEDGER_TABLE_ORDERED_INDEX) continue;
+      return ledger_table_find_in_column_index
+        ( t, cnd->column, &bound, (cnd->cmp&15u) == LEDGER_SELECT_NOTLESS,
+          NULL, 0, positions);
+    default:
+      continue;
+    }
+  }
+  return -1;
+}
+
+int ledger_select_filter_find
+  ( struct ledger_table const* t, int len,
+    struct ledger_select_cond const cond[], unsigned char* bits,
+    struct ledger_select_cond rest[])
+{
+  int const byte_count = ledger_table_count_rows(t)/8+1;
+  unsigned char* scratch = NULL;
+  int filtered_tf = 0;
+  int rest_len = 0;
+  int cond_i;
+  if (len > 1){
+    scratch = (unsigned char*)ledger_util_malloc(byte_count);
+    if (scratch == NULL) return -1;
+  }
+  for (cond_i = 0; cond_i < len; ++cond_i){
+    struct ledger_select_cond const* const cnd = cond+cond_i;
+    unsigned char* const target = filtered_tf ? scratch : bits;
+    struct ledger_bignum* number = NULL;
+    struct ledger_table_field bound;
+    int marked = -1;
+    bound.column = cnd->column;
+    bound.type = 0;
+    bound.id = -1;
+    bound.date = -1;
+    bound.bignum = NULL;
+    bound.text = NULL;
+    /* the filter must compare the way the condition compares */
+    switch (cnd->cmp&(~15u)){
+    case LEDGER_SELECT_ID:
+    case LEDGER_SELECT_INDEX:
+      bound.type = LEDGER_TABLE_ID;
+      bound.id = ledger_util_atoi(cnd->value);
+      break;
+    case LEDGER_SELECT_BIGNUM:
+      number = ledger_bignum_new();
+      if (number != NULL && ledger_bignum_set_text(number, cnd->value, NULL)){
+        bound.type = LEDGER_TABLE_BIGNUM;
+        bound.bignum = number;
+      }
+      break;
+    case LEDGER_SELECT_DATE:
+      if (ledger_util_date_from_text(cnd->value, &bound.date))
+        bound.type = LEDGER_TABLE_DATE;
+      break;
+    default:
+      break;
+    }
+    if (bound.type != 0) switch (cnd->cmp&15u){
+    case LEDGER_SELECT_EQUAL:
+    case LEDGER_SELECT_NOTEQUAL:
+      marked = ledger_table_filter_column
+        (t, cnd->column, &bound, 1, &bound, 1, target);
+      break;
+    case LEDGER_SELECT_LESS:
+    case LEDGER_SELECT_NOTMORE:
+      marked = ledger_table_filter_column
+        ( t, cnd->column, NULL, 0,
+          &bound, (cnd->cmp&15u) == LEDGER_SELECT_NOTMORE, target);
+      break;
+    case LEDGER_SELECT_MORE:
+    case LEDGER_SELECT_NOTLESS:
+      marked = ledger_table_filter_column
+        ( t, cnd->column, &bound, (cnd->cmp&15u) == LEDGER_SELECT_NOTLESS,
+          NULL, 0, target);
+      break;
+    default:
+      break;
+    }
+    ledger_bignum_free(number);
+    if (marked < 0){
+      rest[rest_len] = *cnd;
+      rest_len += 1;
+    } else {
+      int i;
+      if ((cnd->cmp&15u) == LEDGER_SELECT_NOTEQUAL){
+        for (i = 0; i < byte_count; ++i)
+          target[i] = (unsigned char)~target[i];
+      }
+      if (filtered_tf){
+        for (i = 0; i < byte_count; ++i)
+          bits[i] &= scratch[i];
+      }
+      filtered_tf = 1;
+    }
+  }
+  ledger_util_free(scratch);
+  return filtered_tf ? rest_len : -1;
+}
+
 /* END   static implementation */
 
 /* BEGIN implementation */
@@ -282,6 +524,8 @@ int ledger_select_by_cond
   int result = 0;
   struct ledger_table_mark* cur, * end;
   int used_direction;
+  int* positions = NULL;
+  int candidate_count;
   if (dir < 0){
     cur = ledger_table_end(t);
     if (cur != NULL)
@@ -296,14 +540,58 @@ int ledger_select_by_cond
     ledger_table_mark_free(cur);
     ledger_table_mark_free(end);
     return -1;
+  } else if ((candidate_count = ledger_select_index_find
+      (t, len, cond, &positions)) >= 0
+    &&  candidate_count <= ledger_table_count_rows(t)/2)
+  {
+    /* NOTE wider selections scan faster than they mark */
+    /* mark every candidate first, so that the marks follow
+     * any changes made by the callback */
+    struct ledger_table_mark** marks = NULL;
+    int made = 0;
+    if (candidate_count > 0){
+      marks = (struct ledger_table_mark**)ledger_util_malloc
+        (candidate_count*sizeof(struct ledger_table_mark*));
+      if (marks == NULL) result = -1;
+    }
+    for (made = 0; marks != NULL && made < candidate_count; ++made){
+      marks[made] = ledger_table_begin(t);
+      if (marks[made] == NULL) break;
+      if (!ledger_table_mark_seek(marks[made], positions[made])){
+        ledger_table_mark_free(marks[made]);
+        break;
+      }
+    }
+    if (made < candidate_count){
+      result = -1;
+    } else {
+      int pos_i;
+      struct ledger_table_mark const* prev = NULL;
+      for (pos_i = 0; pos_i < candidate_count; ++pos_i){
+        struct ledger_table_mark const* const candidate = marks[
+            (used_direction > 0) ? pos_i : candidate_count-1-pos_i];
+        int yes;
+        if (ledger_table_mark_is_equal(candidate, end)
+        ||  (prev != NULL && ledger_table_mark_is_equal(candidate, prev)))
+          /* row dropped or already visited */continue;
+        prev = candidate;
+        yes = ledger_select_check_all(candidate, len, cond);
+        if (yes == 1){
+          result = (*cb)(arg, candidate);
+          if (result != 0) break;
+        } else if (yes == -1){
+          result = -1;
+        }
+      }
+    }
+    for (; made > 0; --made){
+      ledger_table_mark_free(marks[made-1]);
+    }
+    ledger_util_free(marks);
   } else for (; !ledger_table_mark_is_equal(cur, end);
         ledger_table_mark_move(cur, used_direction))
   {
-    int cond_i;
-    int yes = 1;
-    for (cond_i = 0; yes == 1 && cond_i < len; ++cond_i){
-      yes = ledger_select_check_cond(cur, cond[cond_i]);
-    }
+    int const yes = ledger_select_check_all(cur, len, cond);
     if (yes == 1){
       result = (*cb)(arg, cur);
       if (result != 0) break;
@@ -313,6 +601,7 @@ int ledger_select_by_cond
   }
   ledger_table_mark_free(cur);
   ledger_table_mark_free(end);
+  ledger_util_free(positions);
   return result;
 }
 
@@ -322,30 +611,76 @@ int ledger_select_by_cond_c
     int len, struct ledger_select_cond const cond[], int dir)
 {
   int result = 0;
-  struct ledger_table_mark* cur, * end;
+  struct ledger_table_cursor cursor;
+  struct ledger_table_mark const* cur;
   int used_direction;
+  int* positions = NULL;
+  int candidate_count;
+  unsigned char* bits = NULL;
+  struct ledger_select_cond* rest = NULL;
+  int rest_len = -1;
+  int row_count = 0;
+  ledger_table_read_lock(t);
   if (dir < 0){
-    cur = ledger_table_end_c(t);
-    if (cur != NULL)
-      ledger_table_mark_move(cur, -1);
+    ledger_table_cursor_end(&cursor, t);
+    ledger_table_cursor_move(&cursor, -1);
     used_direction = -1;
   } else {
-    cur = ledger_table_begin_c(t);
+    ledger_table_cursor_begin(&cursor, t);
     used_direction = +1;
   }
-  end = ledger_table_end_c(t);
-  if (cur == NULL || end == NULL){
-    ledger_table_mark_free(cur);
-    ledger_table_mark_free(end);
-    return -1;
-  } else for (; !ledger_table_mark_is_equal(cur, end);
-        ledger_table_mark_move(cur, used_direction))
-  {
-    int cond_i;
-    int yes = 1;
-    for (cond_i = 0; yes == 1 && cond_i < len; ++cond_i){
-      yes = ledger_select_check_cond(cur, cond[cond_i]);
+  cur = ledger_table_cursor_mark(&cursor);
+  candidate_count = ledger_select_index_find(t, len, cond, &positions);
+  if (candidate_count < 0 && len > 0){
+    /* otherwise filter whole columns at once */
+    row_count = ledger_table_count_rows(t);
+    bits = (unsigned char*)ledger_util_malloc(row_count/8+1);
+    rest = (struct ledger_select_cond*)ledger_util_malloc
+      (len*sizeof(struct ledger_select_cond));
+    if (bits != NULL && rest != NULL)
+      rest_len = ledger_select_filter_find(t, len, cond, bits, rest);
+  }
+  if (candidate_count >= 0){
+    int pos_i;
+    for (pos_i = 0; pos_i < candidate_count; ++pos_i){
+      int yes;
+      if (!ledger_table_cursor_seek(&cursor, positions[
+            (used_direction > 0) ? pos_i : candidate_count-1-pos_i]))
+      {
+        result = -1;
+        break;
+      }
+      yes = ledger_select_check_all(cur, len, cond);
+      if (yes == 1){
+        result = (*cb)(arg, cur);
+        if (result != 0) break;
+      } else if (yes == -1){
+        result = -1;
+      }
+    }
+  } else if (rest_len >= 0){
+    int step;
+    for (step = 0; step < row_count; ++step){
+      int const pos = (used_direction > 0) ? step : row_count-1-step;
+      int yes;
+      if (!((bits[pos>>3] >> (pos&7)) & 1u))
+        continue;
+      if (!ledger_table_cursor_seek(&cursor, pos)){
+        result = -1;
+        break;
+      }
+      yes = ledger_select_check_all(cur, rest_len, rest);
+      if (yes == 1){
+        result = (*cb)(arg, cur);
+        if (result != 0) break;
+      } else if (yes == -1){
+        result = -1;
+      }
     }
+  } else for (; !ledger_table_cursor_is_end(&cursor);
+        ledger_table_cursor_move(&cursor, used_direction))
+  {
+    int const yes = ledger_select_check_all(cur, len, cond);
     if (yes == 1){
       result = (*cb)(arg, cur);
       if (result != 0) break;
@@ -353,8 +688,10 @@ int ledger_select_by_cond_c
       result = -1;
     }
   }
-  ledger_table_mark_free(cur);
-  ledger_table_mark_free(end);
+  ledger_table_read_unlock(t);
+  ledger_util_free(positions);
+  ledger_util_free(bits);
+  ledger_util_free(rest);
   return result;
 }
 
@@ -41,7 +41,9 @@ enum ledger_select_cmp_type {
   /* unsigned character string  */
   LEDGER_SELECT_STRING = 48,
   /* array index integer */
-  LEDGER_SELECT_INDEX = 64
+  LEDGER_SELECT_INDEX = 64,
+  /* date, compared in packed form */
+  LEDGER_SELECT_DATE = 80
 };
 
 
@@ -79,7 +81,10 @@ int ledger_select_by_cond
     int len, struct ledger_select_cond const cond[], int dir);
 
 /*
- * Select certain rows from a table.
+ * Select certain rows from a table. The mark passed to the callback
+ * is borrowed from a cursor: it is valid only during the callback
+ * and cannot be acquired. The table stays locked for reading during
+ * the whole selection, so the callback must not modify the table.
  * - table table to search
  * - arg callback argument
  * - cb callback
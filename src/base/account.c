@@ -1,6 +1,7 @@
 
 #include "account.h"
 #include "util.h"
+#include "find.h"
 #include "table.h"
 
 /*
@@ -11,6 +12,10 @@ struct ledger_account {
   unsigned char *description;
   int item_id;
   struct ledger_table *table;
+  /* number of extra owners sharing the account */
+  int shares;
+  /* lookup index of the ledger holding the account */
+  struct ledger_find_index* find_index;
 };
 
 static int ledger_account_schema[] =
@@ -18,7 +23,7 @@ static int ledger_account_schema[] =
     LEDGER_TABLE_ID /* transaction ID */,
     LEDGER_TABLE_BIGNUM /* amount (+ debit, - credit) */,
     LEDGER_TABLE_USTR /* check number */,
-    LEDGER_TABLE_USTR /* date */
+    LEDGER_TABLE_DATE /* date */
   };
 
 /*
@@ -40,6 +45,14 @@ static void ledger_account_clear(struct ledger_account* a);
  */
 static void ledger_account_free_cb(void* a);
 
+/*
+ * Copy an account, sharing its table with the copy.
+ * - a account to copy
+ * @return the copy on success, NULL otherwise
+ */
+static struct ledger_account* ledger_account_fork
+  (struct ledger_account const* a);
+
 
 /* BEGIN static implementation */
 
@@ -54,16 +67,24 @@ int ledger_account_init(struct ledger_account* a){
   a->name = NULL;
   a->item_id = -1;
   a->table = NULL;
+  a->shares = 0;
+  a->find_index = NULL;
   /* prepare the table */{
     int ok = 0;
     int const schema_size = sizeof(ledger_account_schema)/
         sizeof(ledger_account_schema[0]);
-    struct ledger_table *new_table = ledger_table_new();
+    struct ledger_table *new_table = ledger_table_new_columnar();
     if (new_table == NULL) return 0;
     else do {
       if (!ledger_table_set_column_types
           (new_table, schema_size, ledger_account_schema))
         break;
+      /* keep the balance at hand */
+      if (!ledger_table_add_column_aggregate(new_table, 2))
+        break;
+      /* and the balance as of any date */
+      if (!ledger_table_add_column_prefix(new_table, 2, 4))
+        break;
       ok = 1;
     } while (0);
     if (!ok){
@@ -77,16 +98,46 @@ int ledger_account_init(struct ledger_account* a){
 }
 
 void ledger_account_clear(struct ledger_account* a){
-  ledger_table_free(a->table);
+  ledger_table_drop_share(a->table);
   a->table = NULL;
   ledger_util_free(a->description);
   a->description = NULL;
   ledger_util_free(a->name);
   a->description = NULL;
   a->item_id = -1;
+  ledger_find_index_free(a->find_index);
+  a->find_index = NULL;
   return;
 }
 
+struct ledger_account* ledger_account_fork(struct ledger_account const* a){
+  struct ledger_account* b = (struct ledger_account* )ledger_util_ref_malloc
+    (sizeof(struct ledger_account), ledger_account_free_cb);
+  if (b != NULL){
+    int ok = 0;
+    b->name = NULL;
+    b->description = NULL;
+    b->item_id = a->item_id;
+    b->shares = 0;
+    b->find_index = NULL;
+    b->table = ledger_table_share(a->table);
+    do {
+      int dup_ok;
+      if (b->table == NULL) break;
+      b->name = ledger_util_ustrdup(a->name, &dup_ok);
+      if (!dup_ok) break;
+      b->description = ledger_util_ustrdup(a->description, &dup_ok);
+      if (!dup_ok) break;
+      ok = 1;
+    } while (0);
+    if (!ok){
+      ledger_util_ref_free(b);
+      b = NULL;
+    }
+  }
+  return b;
+}
+
 /* END   static implementation */
 
 /* BEGIN implementation */
@@ -114,6 +165,29 @@ void ledger_account_free(struct ledger_account* a){
   }
 }
 
+struct ledger_account* ledger_account_share(struct ledger_account* a){
+  if (ledger_account_acquire(a) == NULL) return NULL;
+  ledger_util_share_add(&a->shares, +1);
+  return a;
+}
+
+void ledger_account_drop_share(struct ledger_account* a){
+  if (a != NULL){
+    ledger_util_share_add(&a->shares, -1);
+    ledger_account_free(a);
+  }
+  return;
+}
+
+struct ledger_account* ledger_account_own(struct ledger_account* a){
+  struct ledger_account* copy;
+  if (ledger_util_share_add(&a->shares, 0) == 0) return a;
+  copy = ledger_account_fork(a);
+  if (copy == NULL) return NULL;
+  ledger_account_drop_share(a);
+  return copy;
+}
+
 unsigned char const* ledger_account_get_description
   (struct ledger_account const* a)
 {
@@ -146,6 +220,8 @@ int ledger_account_set_name
   if (ok){
     ledger_util_free(a->name);
     a->name = new_desc;
+    ledger_find_touch
+      (a->find_index, ledger_util_share_add(&a->shares, 0) > 0);
     return 1;
   } else return 0;
 }
@@ -160,6 +236,18 @@ void ledger_account_set_id(struct ledger_account* a, int item_id){
   } else {
     a->item_id = item_id;
   }
+  ledger_find_touch
+    (a->find_index, ledger_util_share_add(&a->shares, 0) > 0);
+  return;
+}
+
+void ledger_account_set_find_index
+  (struct ledger_account* a, struct ledger_find_index* x)
+{
+  if (a->find_index != x){
+    ledger_find_index_free(a->find_index);
+    a->find_index = ledger_find_index_acquire(x);
+  }
   return;
 }
 
@@ -185,7 +273,10 @@ int ledger_account_is_equal
 }
 
 struct ledger_table* ledger_account_get_table(struct ledger_account* a){
-  return a->table;
+  struct ledger_table* const t = ledger_table_own(a->table);
+  if (t != NULL)
+    a->table = t;
+  return t;
 }
 
 struct ledger_table const* ledger_account_get_table_c
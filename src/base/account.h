@@ -10,6 +10,8 @@
 extern "C" {
 #endif /*__cplusplus*/
 
+struct ledger_find_index;
+
 /*
  * brief: Account
  */
@@ -34,6 +36,31 @@ struct ledger_account* ledger_account_acquire(struct ledger_account* a);
  */
 void ledger_account_free(struct ledger_account* a);
 
+/*
+ * Acquire an account for another owner, such as a ledger copy.
+ * An owner must call `ledger_account_own` before changing an account.
+ * - a the account to share
+ * @return the account on success, otherwise NULL
+ */
+struct ledger_account* ledger_account_share(struct ledger_account* a);
+
+/*
+ * Release an account held by one of its owners.
+ * - a the account to release
+ */
+void ledger_account_drop_share(struct ledger_account* a);
+
+/*
+ * Prepare an account for changes by one of its owners. An account
+ * that other owners still share is copied, and the copy replaces the
+ * owner's hold on the original. The copy shares the account's table
+ * until one of them changes it.
+ * - a the account held by the owner
+ * @return the account itself if unshared, a private copy otherwise,
+ *   or NULL if the copy failed (the owner keeps the original)
+ */
+struct ledger_account* ledger_account_own(struct ledger_account* a);
+
 /*
  * Query the description of an account.
  * - a account to query
@@ -82,6 +109,15 @@ int ledger_account_get_id(struct ledger_account const* a);
  */
 void ledger_account_set_id(struct ledger_account* a, int item_id);
 
+/*
+ * Attach an account to the lookup index of the ledger holding it, so that
+ * changes to its name or identifier mark that index stale.
+ * - a account to modify
+ * - x the lookup index, or NULL to detach
+ */
+void ledger_account_set_find_index
+  (struct ledger_account* a, struct ledger_find_index* x);
+
 /*
  * Compare two accounts for equality.
  * - a an account
@@ -94,9 +130,9 @@ int ledger_account_is_equal
 /*
  * Modify an account's transaction table. The user should acquire a
  *     reference to the table by calling `ledger_table_acquire` after
- *     this function.
+ *     this function. A table shared with a snapshot is copied first.
  * - a account to modify
- * @return the transaction table
+ * @return the transaction table, or NULL if the copy failed
  */
 struct ledger_table* ledger_account_get_table(struct ledger_account* a);
 
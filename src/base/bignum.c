@@ -14,13 +14,32 @@
 #  error "LEDGER_BIGNUM_DIGIT_MAX too large"
 #endif /*LEDGER_BIGNUM_DIGIT_MAX*/
 
+/*
+ * largest magnitude of a fixed-point value (eighteen decimal digits)
+ */
+#define LEDGER_BIGNUM_FIXED_MAX 999999999999999999ULL
+
+/*
+ * base of a limb, as a power of one hundred
+ */
+#define LEDGER_BIGNUM_LIMB_DIGITS 9
+
+/*
+ * base of a limb (one hundred to the ninth power)
+ */
+#define LEDGER_BIGNUM_LIMB_BASE 1000000000000000000ULL
+
 /*
  * Actualization of the big number structure
  */
 struct ledger_bignum {
-  /* base-100 digits, stored in little-endian order */
-  unsigned char *digits;
-  /* number of digits, equal to the number of bytes */
+  /*
+   * base-10^18 limbs, stored in little-endian order, with the
+   * centesimal point on a limb boundary; unused base-100 digits
+   * below the last fractional digit are kept at zero
+   */
+  unsigned long long int *limbs;
+  /* number of base-100 digits */
   int digit_count;
   /* position of the centesimal point, in digits */
   int point_place;
@@ -28,6 +47,107 @@ struct ledger_bignum {
   char negative;
 };
 
+/*
+ * number of additions an accumulator takes between carry folds;
+ * a folded limb plus seventeen more limbs stays below 2^64
+ */
+#define LEDGER_BIGNUM_ACCUM_FOLD 17
+
+/*
+ * most limbs that a number of at most LEDGER_BIGNUM_DIGIT_MAX
+ *   digits can span
+ */
+#define LEDGER_BIGNUM_LIMB_MAX \
+  ((LEDGER_BIGNUM_DIGIT_MAX+2*LEDGER_BIGNUM_LIMB_DIGITS-2) \
+    / LEDGER_BIGNUM_LIMB_DIGITS)
+
+/*
+ * Actualization of the accumulator structure
+ */
+struct ledger_bignum_accum {
+  /*
+   * two sets of limbs with deferred carries: first the sum of positive
+   * addends, then the sum of negative addends; each set is laid out as
+   * a big number's limbs, with a spare limb on top to catch carries
+   */
+  unsigned long long int *limbs;
+  /* number of limbs per set, including the spare limb */
+  int limb_count;
+  /* number of limbs per set below the centesimal point */
+  int fraction_limbs;
+  /* most centesimal places among the addends */
+  int point_place;
+  /* most integral base-100 digits among the addends */
+  int integral_digits;
+  /* additions since the last carry fold */
+  int pending;
+};
+
+/*
+ * base of a rate word (ten to the ninth power), so that the product
+ *   of two words fits in an unsigned long long
+ */
+#define LEDGER_BIGNUM_WORD_BASE 1000000000UL
+
+/*
+ * decimal digits of a rate word
+ */
+#define LEDGER_BIGNUM_WORD_DIGITS 9
+
+/*
+ * Actualization of the rate structure
+ */
+struct ledger_bignum_rate {
+  /*
+   * magnitudes of the numerator then the denominator, each as a
+   * whole number in base-10^9 words stored in little-endian order
+   */
+  unsigned long int *words;
+  /* number of numerator words */
+  int numerator_count;
+  /* number of denominator words */
+  int denominator_count;
+  /*
+   * centesimal exponent of the ratio of the whole numbers,
+   *   plus the centesimal places of each product
+   */
+  int shift;
+  /* centesimal places of each product */
+  int point_place;
+  /* one if the rate is negative, zero otherwise */
+  char negative;
+  /* working space for products and quotients */
+  unsigned long int *work;
+  /* number of words of working space */
+  int work_size;
+};
+
+/*
+ * powers of one hundred, up to a full limb
+ */
+static unsigned long long int const ledger_bignum_hundreds[] = {
+  1ULL, 100ULL, 10000ULL, 1000000ULL, 100000000ULL,
+  10000000000ULL, 1000000000000ULL, 100000000000000ULL,
+  10000000000000000ULL, 1000000000000000000ULL
+};
+
+/*
+ * powers of ten, below a full rate word
+ */
+static unsigned long int const ledger_bignum_tens[] = {
+  1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL, 1000000UL, 10000000UL,
+  100000000UL
+};
+
+/*
+ * decimal text of each base-100 digit
+ */
+static char const ledger_bignum_pairs[] =
+  "00010203040506070809101112131415161718192021222324"
+  "25262728293031323334353637383940414243444546474849"
+  "50515253545556575859606162636465666768697071727374"
+  "75767778798081828384858687888990919293949596979899";
+
 /*
  * Initialize a number.
  * - n number to initialize
@@ -48,10 +168,32 @@ static void ledger_bignum_clear(struct ledger_bignum* n);
 static void ledger_bignum_zero_all(struct ledger_bignum* n);
 
 /*
- * Zero out the fractional part of a number.
- * - n number to zero
+ * Count the limbs below the centesimal point.
+ * - n number to query
+ * @return a count of fractional limbs
  */
-static void ledger_bignum_zero_cents(struct ledger_bignum* n);
+static int ledger_bignum_fraction_limbs(struct ledger_bignum const* n);
+
+/*
+ * Count the limbs of a number.
+ * - n number to query
+ * @return a count of fractional and integral limbs
+ */
+static int ledger_bignum_count_limbs(struct ledger_bignum const* n);
+
+/*
+ * Count the base-100 digits needed to write a magnitude.
+ * - v magnitude to measure
+ * @return a count of digits, zero for a zero magnitude
+ */
+static int ledger_bignum_measure(unsigned long long int v);
+
+/*
+ * Check whether a number is zero, regardless of sign.
+ * - n number to check
+ * @return one if all limbs are zero, zero otherwise
+ */
+static int ledger_bignum_is_zero(struct ledger_bignum const* n);
 
 /*
  * Allocate and partition only more space for a big number.
@@ -78,12 +220,83 @@ static int ledger_bignum_alloc_unchecked
   (struct ledger_bignum* n, int digits, int point_place);
 
 /*
- * Fetch a centesimal digit from a big number.
+ * Fetch a limb from a big number.
  * - n number to read
- * - i digit place
- * @return the digit, or zero if `i` is out of range
+ * - i limb place, relative to the centesimal point
+ * @return the limb, or zero if `i` is out of range
+ */
+static unsigned long long int ledger_bignum_fetch_zero
+  (struct ledger_bignum const* n, int i);
+
+/*
+ * Write a magnitude into zeroed limbs of a big number.
+ * - n number to modify; must have room for the magnitude
+ * - v magnitude to write
+ * - i base-100 digit place of the magnitude's lowest digit
+ */
+static void ledger_bignum_place
+  (struct ledger_bignum* n, unsigned long long int v, int i);
+
+/*
+ * Clip a number to its base-100 digit count, dropping any
+ *   digits above and below the count.
+ * - n number to clip
  */
-static int ledger_bignum_fetch_zero(struct ledger_bignum const* n, int i);
+static void ledger_bignum_clip(struct ledger_bignum* n);
+
+/*
+ * Parse eight decimal digits at once, as lanes of one word.
+ * - text digits to parse
+ * @return the value of the digits
+ */
+static unsigned long int ledger_bignum_scan_eight(unsigned char const* text);
+
+/*
+ * Parse decimal digits into a limb value.
+ * - text digits to parse
+ * - count number of digits to parse, at most eighteen
+ * @return the value of the digits
+ */
+static unsigned long long int ledger_bignum_scan
+  (unsigned char const* text, size_t count);
+
+/*
+ * Count the significant decimal digits of a limb value.
+ * - v limb value to measure
+ * @return a count of decimal digits, at least one
+ */
+static int ledger_bignum_limb_width(unsigned long long int v);
+
+/*
+ * Measure the text form of a big number.
+ * - n number to measure
+ * - want_plus whether to count a forced plus sign
+ * - top to receive the count of limbs up to the highest nonzero
+ *     integral limb
+ * @return the number of bytes in the text, not including the NUL
+ */
+static int ledger_bignum_measure_text
+  (struct ledger_bignum const* n, int want_plus, int* top);
+
+/*
+ * Write decimal digits of a limb value, backward from a point.
+ * - p end of the space to receive the digits
+ * - v limb value to write
+ * - skip number of low base-100 digits to leave out
+ * - count number of decimal digits to write above the skipped digits
+ * @return the start of the written digits
+ */
+static unsigned char* ledger_bignum_emit
+  (unsigned char* p, unsigned long long int v, int skip, int count);
+
+/*
+ * Widen a number to hold another number's places, keeping its value.
+ * - n number to widen
+ * - other number whose places must fit
+ * @return one on success, zero otherwise
+ */
+static int ledger_bignum_widen
+  (struct ledger_bignum* n, struct ledger_bignum const* other);
 
 /*
  * Add two magnitudes together, used for general purposes.
@@ -103,10 +316,125 @@ static int ledger_bignum_gp_add
 static int ledger_bignum_gp_subtract
   ( struct ledger_bignum* dst, struct ledger_bignum const* right);
 
+/*
+ * Make room in an accumulator for an addend's places, keeping the
+ *   sum accumulated so far.
+ * - a accumulator to modify
+ * - point_place centesimal places of the addend
+ * - integral_digits integral base-100 digits of the addend
+ * @return one on success, zero otherwise
+ */
+static int ledger_bignum_accum_reserve
+  (struct ledger_bignum_accum* a, int point_place, int integral_digits);
+
+/*
+ * Propagate the deferred carries of an accumulator, bringing every
+ *   limb but the topmost of each set below the limb base.
+ * - a accumulator to fold
+ */
+static void ledger_bignum_accum_fold(struct ledger_bignum_accum* a);
+
+
+/*
+ * Initialize a rate, equal to one with no centesimal places.
+ * - r rate to initialize
+ * @return one on success, zero on failure
+ */
+static int ledger_bignum_rate_init(struct ledger_bignum_rate* r);
+
+/*
+ * Clear out a rate.
+ * - r rate to clear
+ */
+static void ledger_bignum_rate_clear(struct ledger_bignum_rate* r);
+
+/*
+ * Make room in a rate's working space.
+ * - r rate to modify
+ * - size number of words needed
+ * @return one on success, zero otherwise
+ */
+static int ledger_bignum_rate_reserve(struct ledger_bignum_rate* r, int size);
+
+/*
+ * Load the limbs of a big number as a whole number of rate words.
+ * - w words to receive the whole number; must have room for
+ *     two words per limb
+ * - n number to load
+ * @return the count of words, without leading zero words
+ */
+static int ledger_bignum_words_load
+  (unsigned long int* w, struct ledger_bignum const* n);
+
+/*
+ * Divide out the factors of one hundred from a whole number of
+ *   rate words.
+ * - w words to reduce
+ * - count to hold the count of words in `w`, updated to the count
+ *     of words after reduction
+ * @return the number of factors of one hundred divided out
+ */
+static int ledger_bignum_words_strip(unsigned long int* w, int* count);
+
+/*
+ * Multiply two whole numbers of rate words.
+ * - dst words to receive the product; must have room for
+ *     `a_count+b_count` words and not overlap either factor
+ * - a one factor
+ * - a_count count of words in `a`
+ * - b another factor
+ * - b_count count of words in `b`
+ * @return the count of product words, without leading zero words
+ */
+static int ledger_bignum_words_multiply
+  ( unsigned long int* dst, unsigned long int const* a, int a_count,
+    unsigned long int const* b, int b_count);
+
+/*
+ * Multiply a whole number of rate words by a power of one hundred.
+ * - w words to scale; must have room for the product
+ * - count count of words in `w`
+ * - places exponent of one hundred, at least zero
+ * @return the count of product words
+ */
+static int ledger_bignum_words_scale
+  (unsigned long int* w, int count, int places);
+
+/*
+ * Divide one whole number of rate words by another, rounding the
+ *   quotient with halves away from zero.
+ * - q words to receive the quotient; must have room for
+ *     `u_count-v_count+2` words, and at least one word
+ * - u the dividend, overwritten with scratch values; must have room
+ *     for `u_count+1` words, and at least `v_count` words
+ * - u_count count of words in `u`
+ * - v the divisor, without leading zero words, overwritten with
+ *     scratch values
+ * - v_count count of words in `v`, at least one
+ * - t scratch space of `v_count` words
+ * @return the count of quotient words, without leading zero words
+ */
+static int ledger_bignum_words_divide
+  ( unsigned long int* q, unsigned long int* u, int u_count,
+    unsigned long int* v, int v_count, unsigned long int* t);
+
+/*
+ * Multiply a whole number of rate words by a rate.
+ * - r the rate
+ * - s the whole number to multiply
+ * - s_count count of words in `s`
+ * - s_place centesimal places of the whole number
+ * - q to receive the rounded product, in the working space of the
+ *     rate, in units of 100^(-point_place) of the rate
+ * @return the count of product words on success, negative otherwise
+ */
+static int ledger_bignum_rate_run
+  ( struct ledger_bignum_rate* r, unsigned long int const* s, int s_count,
+    int s_place, unsigned long int** q);
 /* BEGIN static implementation */
 
 int ledger_bignum_init(struct ledger_bignum* n){
-  n->digits = NULL;
+  n->limbs = NULL;
   n->digit_count = 0;
   n->point_place = 0;
   n->negative = 0;
@@ -114,8 +442,8 @@ int ledger_bignum_init(struct ledger_bignum* n){
 }
 
 void ledger_bignum_clear(struct ledger_bignum* n){
-  ledger_util_free(n->digits);
-  n->digits = NULL;
+  ledger_util_free(n->limbs);
+  n->limbs = NULL;
   n->digit_count = 0;
   n->point_place = 0;
   n->negative = 0;
@@ -123,11 +451,40 @@ void ledger_bignum_clear(struct ledger_bignum* n){
 }
 
 void ledger_bignum_zero_all(struct ledger_bignum* n){
-  memset(n->digits,0,n->digit_count*sizeof(unsigned char));
+  int const limb_count = ledger_bignum_count_limbs(n);
+  if (limb_count > 0)
+    memset(n->limbs,0,limb_count*sizeof(unsigned long long int));
+}
+
+int ledger_bignum_fraction_limbs(struct ledger_bignum const* n){
+  return (int)(((unsigned int)n->point_place+LEDGER_BIGNUM_LIMB_DIGITS-1)
+    / LEDGER_BIGNUM_LIMB_DIGITS);
 }
 
-void ledger_bignum_zero_cents(struct ledger_bignum* n){
-  memset(n->digits,0,n->point_place*sizeof(unsigned char));
+int ledger_bignum_count_limbs(struct ledger_bignum const* n){
+  unsigned int const integral_digits =
+    (unsigned int)(n->digit_count-n->point_place);
+  return ledger_bignum_fraction_limbs(n)
+    + (int)((integral_digits+LEDGER_BIGNUM_LIMB_DIGITS-1)
+      / LEDGER_BIGNUM_LIMB_DIGITS);
+}
+
+int ledger_bignum_measure(unsigned long long int v){
+  int digit_count = 0;
+  while (v > 0){
+    v /= 100u;
+    digit_count += 1;
+  }
+  return digit_count;
+}
+
+int ledger_bignum_is_zero(struct ledger_bignum const* n){
+  int const limb_count = ledger_bignum_count_limbs(n);
+  int i;
+  for (i = 0; i < limb_count; ++i){
+    if (n->limbs[i] != 0) return 0;
+  }
+  return 1;
 }
 
 int ledger_bignum_extend
@@ -167,75 +524,266 @@ int ledger_bignum_alloc_unchecked
   (struct ledger_bignum* n, int digits, int point_place)
 {
   if (digits > 0){
-    /* allocate new digit space */
-    unsigned char* new_digits = (unsigned char*)ledger_util_malloc
-      (sizeof(unsigned char)*(digits));
-    if (new_digits == NULL){
-      return 0;
-    } else {
-      ledger_util_free(n->digits);
-      n->digits = new_digits;
-      n->digit_count = digits;
-      n->point_place = point_place;
-      ledger_bignum_zero_all(n);
-      return 1;
+    struct ledger_bignum layout;
+    int limb_count;
+    ledger_bignum_init(&layout);
+    layout.digit_count = digits;
+    layout.point_place = point_place;
+    limb_count = ledger_bignum_count_limbs(&layout);
+    if (n->limbs == NULL || limb_count != ledger_bignum_count_limbs(n)){
+      /* allocate new limb space */
+      unsigned long long int* new_limbs =
+        (unsigned long long int*)ledger_util_malloc
+          (sizeof(unsigned long long int)*limb_count);
+      if (new_limbs == NULL){
+        return 0;
+      }
+      ledger_util_free(n->limbs);
+      n->limbs = new_limbs;
     }
+    n->digit_count = digits;
+    n->point_place = point_place;
+    ledger_bignum_zero_all(n);
+    return 1;
   } else {
-    /* free up the digits */
-    ledger_util_free(n->digits);
-    n->digits = NULL;
+    /* free up the limbs */
+    ledger_util_free(n->limbs);
+    n->limbs = NULL;
     n->digit_count = 0;
     n->point_place = 0;
     return 1;
   }
 }
 
-int ledger_bignum_fetch_zero(struct ledger_bignum const* n, int i){
-  if (i < 0 || i >= n->digit_count) return 0;
-  else return n->digits[i];
+unsigned long long int ledger_bignum_fetch_zero
+  (struct ledger_bignum const* n, int i)
+{
+  int const fraction_limbs = ledger_bignum_fraction_limbs(n);
+  i += fraction_limbs;
+  if (i < 0 || i >= ledger_bignum_count_limbs(n)) return 0;
+  else return n->limbs[i];
+}
+
+void ledger_bignum_place
+  (struct ledger_bignum* n, unsigned long long int v, int i)
+{
+  int const limb_count = ledger_bignum_count_limbs(n);
+  int const pos = i + ledger_bignum_fraction_limbs(n)
+    *LEDGER_BIGNUM_LIMB_DIGITS - n->point_place;
+  int const limb_i = pos/LEDGER_BIGNUM_LIMB_DIGITS;
+  int const shift = pos%LEDGER_BIGNUM_LIMB_DIGITS;
+  unsigned long long int const split =
+    ledger_bignum_hundreds[LEDGER_BIGNUM_LIMB_DIGITS-shift];
+  if (limb_i < limb_count)
+    n->limbs[limb_i] = (v%split)*ledger_bignum_hundreds[shift];
+  if (limb_i+1 < limb_count && v/split > 0)
+    n->limbs[limb_i+1] = v/split;
+  return;
+}
+
+void ledger_bignum_clip(struct ledger_bignum* n){
+  int const limb_count = ledger_bignum_count_limbs(n);
+  int const fraction_limbs = ledger_bignum_fraction_limbs(n);
+  int const low_digits =
+    fraction_limbs*LEDGER_BIGNUM_LIMB_DIGITS - n->point_place;
+  int const high_digits = n->digit_count - n->point_place
+    - (limb_count-fraction_limbs-1)*LEDGER_BIGNUM_LIMB_DIGITS;
+  if (limb_count == 0)
+    return;
+  if (low_digits > 0)
+    n->limbs[0] -= n->limbs[0]%ledger_bignum_hundreds[low_digits];
+  if (limb_count > fraction_limbs && high_digits < LEDGER_BIGNUM_LIMB_DIGITS)
+    n->limbs[limb_count-1] %= ledger_bignum_hundreds[high_digits];
+  return;
+}
+
+unsigned long int ledger_bignum_scan_eight(unsigned char const* text){
+  /* first digit in the lowest byte, whatever the byte order */
+  unsigned long long int chunk =
+      ((unsigned long long int)text[0])
+    | ((unsigned long long int)text[1]<<8)
+    | ((unsigned long long int)text[2]<<16)
+    | ((unsigned long long int)text[3]<<24)
+    | ((unsigned long long int)text[4]<<32)
+    | ((unsigned long long int)text[5]<<40)
+    | ((unsigned long long int)text[6]<<48)
+    | ((unsigned long long int)text[7]<<56);
+  chunk -= 0x3030303030303030ULL;
+  /* merge neighboring lanes: digits, then pairs, then quadruples */
+  chunk = (chunk*10u + (chunk>>8)) & 0x00FF00FF00FF00FFULL;
+  chunk = (chunk*100u + (chunk>>16)) & 0x0000FFFF0000FFFFULL;
+  chunk = (chunk*10000u + (chunk>>32)) & 0xFFFFFFFFULL;
+  return (unsigned long int)chunk;
+}
+
+unsigned long long int ledger_bignum_scan
+  (unsigned char const* text, size_t count)
+{
+  unsigned long long int v = 0;
+  for (; count >= 8; count -= 8, text += 8){
+    v = v*100000000u + ledger_bignum_scan_eight(text);
+  }
+  for (; count > 0; --count, ++text){
+    v = v*10u + (*text-'0');
+  }
+  return v;
+}
+
+int ledger_bignum_limb_width(unsigned long long int v){
+  int count;
+  for (count = 1; count < LEDGER_BIGNUM_LIMB_DIGITS; ++count){
+    if (v < ledger_bignum_hundreds[count]) break;
+  }
+  /* drop the front zero */
+  return (v < ledger_bignum_hundreds[count-1]*10u) ? count*2-1 : count*2;
+}
+
+int ledger_bignum_measure_text
+  (struct ledger_bignum const* n, int want_plus, int* top)
+{
+  int const fraction_limbs = ledger_bignum_fraction_limbs(n);
+  int byte_count;
+  int i;
+  for (i = ledger_bignum_count_limbs(n); i > fraction_limbs; --i){
+    if (n->limbs[i-1] != 0) break;
+  }
+  *top = i;
+  if (i > fraction_limbs){
+    byte_count = (i-1-fraction_limbs)*2*LEDGER_BIGNUM_LIMB_DIGITS
+      + ledger_bignum_limb_width(n->limbs[i-1]);
+  } else {
+    /* add front zero */
+    byte_count = 1;
+  }
+  if (n->negative || want_plus){
+    /* add minus sign */
+    byte_count += 1;
+  }
+  if (n->point_place > 0){
+    /* add decimal point */
+    byte_count += 1+n->point_place*2;
+  }
+  return byte_count;
+}
+
+unsigned char* ledger_bignum_emit
+  (unsigned char* p, unsigned long long int v, int skip, int count)
+{
+  unsigned long int pairs[LEDGER_BIGNUM_LIMB_DIGITS+3];
+  unsigned long int parts[3];
+  int const last = skip+(count+1)/2;
+  int i;
+  /* split into parts of four base-100 digits each */
+  if (v < 100000000u){
+    parts[0] = (unsigned long int)v;
+    parts[1] = 0;
+    parts[2] = 0;
+  } else if (skip >= 8){
+    parts[2] = (unsigned long int)(v/10000000000000000u);
+  } else {
+    parts[0] = (unsigned long int)(v%100000000u);
+    v /= 100000000u;
+    parts[1] = (unsigned long int)(v%100000000u);
+    parts[2] = (unsigned long int)(v/100000000u);
+  }
+  /* convert the parts by halves, keeping the divisions independent */
+  for (i = skip/4; i*4 < last; ++i){
+    unsigned long int const high = parts[i]/10000u;
+    unsigned long int const low = parts[i]%10000u;
+    pairs[i*4] = low%100u;
+    pairs[i*4+1] = low/100u;
+    pairs[i*4+2] = high%100u;
+    pairs[i*4+3] = high/100u;
+  }
+  for (i = skip; i < last; ++i){
+    if (i == last-1 && count%2 != 0){
+      /* put one digit */
+      *(--p) = (unsigned char)('0'+pairs[i]);
+    } else {
+      p -= 2;
+      memcpy(p, ledger_bignum_pairs+pairs[i]*2, 2);
+    }
+  }
+  return p;
+}
+
+int ledger_bignum_widen
+  (struct ledger_bignum* n, struct ledger_bignum const* other)
+{
+  int ok;
+  struct ledger_bignum tmp;
+  if (other->point_place <= n->point_place
+  &&  other->digit_count-other->point_place
+        <= n->digit_count-n->point_place)
+  {
+    /* already wide enough */
+    return 1;
+  }
+  ledger_bignum_init(&tmp);
+  ok = ledger_bignum_extend(&tmp, n->digit_count, n->point_place)
+    &&  ledger_bignum_extend(&tmp, other->digit_count, other->point_place);
+  if (ok){
+    ledger_bignum_truncate(&tmp, n);
+    ledger_bignum_swap(n, &tmp);
+  }
+  ledger_bignum_clear(&tmp);
+  return ok;
 }
 
 int ledger_bignum_gp_add
   ( struct ledger_bignum* dst, struct ledger_bignum const* right)
 {
-  unsigned int carry = 0;
-  int point_shift;
+  unsigned long long int carry = 0;
+  int const dst_count = ledger_bignum_count_limbs(dst);
+  int const right_count = ledger_bignum_count_limbs(right);
   int dst_i, right_i;
   int ok = 1;
   /*
    * right point_place will always be less or equal to dst point_place,
    * since dst was extended to contain both left and right
    */
-  point_shift = dst->point_place-right->point_place;
-  for (dst_i = point_shift, right_i = 0; right_i < right->digit_count;
-      ++dst_i, ++right_i)
-  {
-    carry += dst->digits[dst_i];
-    carry += right->digits[right_i];
-    dst->digits[dst_i] = carry%100;
-    carry /= 100;
+  dst_i = ledger_bignum_fraction_limbs(dst)
+    - ledger_bignum_fraction_limbs(right);
+  for (right_i = 0; right_i < right_count; ++dst_i, ++right_i){
+    unsigned long long int place =
+      dst->limbs[dst_i] + right->limbs[right_i] + carry;
+    if (place >= LEDGER_BIGNUM_LIMB_BASE){
+      place -= LEDGER_BIGNUM_LIMB_BASE;
+      carry = 1;
+    } else carry = 0;
+    dst->limbs[dst_i] = place;
   }
-  /* carry forward */if (carry > 0 && dst_i < dst->digit_count){
-    for (; dst_i < dst->digit_count; ++dst_i){
-      carry += dst->digits[dst_i];
-      dst->digits[dst_i] = carry%100;
-      carry /= 100;
-    }
+  /* carry forward */
+  for (; carry > 0 && dst_i < dst_count; ++dst_i){
+    dst->limbs[dst_i] += carry;
+    if (dst->limbs[dst_i] >= LEDGER_BIGNUM_LIMB_BASE){
+      dst->limbs[dst_i] -= LEDGER_BIGNUM_LIMB_BASE;
+    } else carry = 0;
   }
-  /* extend */if (carry /*still*/ > 0
-  &&  dst->digit_count < LEDGER_BIGNUM_DIGIT_MAX)
-  {
+  if (dst->digit_count >= LEDGER_BIGNUM_DIGIT_MAX){
+    /* drop the carry */
+    ledger_bignum_clip(dst);
+  } else if (carry /*still*/ > 0){
+    /* extend by a limb */
     struct ledger_bignum tmp;
-    int const digit_count = dst->digit_count;
     ledger_bignum_init(&tmp);
-    ok = ledger_bignum_alloc_unchecked(&tmp, digit_count+1, dst->point_place);
+    ok = ledger_bignum_alloc_unchecked
+      (&tmp, dst->digit_count+1, dst->point_place);
     if (ok){
       tmp.negative = dst->negative;
-      memcpy(tmp.digits, dst->digits, sizeof(unsigned char)*digit_count);
-      tmp.digits[digit_count] = carry;
+      memcpy(tmp.limbs, dst->limbs,
+        sizeof(unsigned long long int)*dst_count);
+      tmp.limbs[dst_count] = carry;
       ledger_bignum_swap(&tmp, dst);
     }
     ledger_bignum_clear(&tmp);
+  } else if (dst_count > ledger_bignum_fraction_limbs(dst)){
+    /* extend by a digit within the top limb */
+    int const high_digits = dst->digit_count - dst->point_place
+      - (dst_count-ledger_bignum_fraction_limbs(dst)-1)
+        *LEDGER_BIGNUM_LIMB_DIGITS;
+    if (dst->limbs[dst_count-1] >= ledger_bignum_hundreds[high_digits])
+      dst->digit_count += 1;
   }
   return ok;
 }
@@ -243,49 +791,50 @@ int ledger_bignum_gp_add
 int ledger_bignum_gp_subtract
   ( struct ledger_bignum* dst, struct ledger_bignum const* right)
 {
-  unsigned int debt = 0;
-  int point_shift;
+  unsigned long long int debt = 0;
+  int const dst_count = ledger_bignum_count_limbs(dst);
+  int const right_count = ledger_bignum_count_limbs(right);
   int dst_i, right_i;
   int ok = 1;
   /*
    * right point_place will always be less or equal to dst point_place,
    * since dst was extended to contain both left and right
    */
-  point_shift = dst->point_place-right->point_place;
-  for (dst_i = point_shift, right_i = 0; right_i < right->digit_count;
-      ++dst_i, ++right_i)
-  {
-    unsigned int place;
-    place = dst->digits[dst_i];
-    place -= debt;
-    place -= right->digits[right_i];
-    if (place >= 100){
+  dst_i = ledger_bignum_fraction_limbs(dst)
+    - ledger_bignum_fraction_limbs(right);
+  for (right_i = 0; right_i < right_count; ++dst_i, ++right_i){
+    unsigned long long int const take = right->limbs[right_i] + debt;
+    if (dst->limbs[dst_i] < take){
       /* wrap occurred; borrow */
+      dst->limbs[dst_i] += LEDGER_BIGNUM_LIMB_BASE - take;
       debt = 1;
-      place += 100;
-    } else debt = 0;
-    dst->digits[dst_i] = place;
-  }
-  /* refinance the debt */if (debt == 1 && dst_i < dst->digit_count){
-    for (; dst_i < dst->digit_count; ++dst_i){
-      unsigned int place;
-      place = dst->digits[dst_i];
-      place -= debt;
-      if (place >= 100){
-        /* wrap occurred; borrow */
-        debt = 1;
-        place += 100;
-      } else debt = 0;
-      dst->digits[dst_i] = place;
-    }
-  }
-  /* execute 2's complement */if (debt /*still*/ == 1){
-    unsigned int carry = 1;
+    } else {
+      dst->limbs[dst_i] -= take;
+      debt = 0;
+    }
+  }
+  /* refinance the debt */
+  for (; debt == 1 && dst_i < dst_count; ++dst_i){
+    if (dst->limbs[dst_i] == 0){
+      dst->limbs[dst_i] = LEDGER_BIGNUM_LIMB_BASE-1;
+    } else {
+      dst->limbs[dst_i] -= 1;
+      debt = 0;
+    }
+  }
+  /* execute 10's complement */if (debt /*still*/ == 1){
+    unsigned long long int carry = 1;
     dst->negative = !dst->negative;
-    for (dst_i = 0; dst_i < dst->digit_count; ++dst_i){
-      carry += (99-dst->digits[dst_i]);
-      dst->digits[dst_i] = carry%100;
-      carry /= 100;
+    for (dst_i = 0; dst_i < dst_count; ++dst_i){
+      unsigned long long int const place =
+        (LEDGER_BIGNUM_LIMB_BASE-1-dst->limbs[dst_i]) + carry;
+      if (place >= LEDGER_BIGNUM_LIMB_BASE){
+        dst->limbs[dst_i] = place - LEDGER_BIGNUM_LIMB_BASE;
+        carry = 1;
+      } else {
+        dst->limbs[dst_i] = place;
+        carry = 0;
+      }
     }
     /*
      * carry == 0 since the destination was already extended to
@@ -296,6 +845,349 @@ int ledger_bignum_gp_subtract
   return ok;
 }
 
+int ledger_bignum_accum_reserve
+  (struct ledger_bignum_accum* a, int point_place, int integral_digits)
+{
+  int fraction_limbs, limb_count;
+  if (point_place < a->point_place)
+    point_place = a->point_place;
+  if (integral_digits < a->integral_digits)
+    integral_digits = a->integral_digits;
+  fraction_limbs = (point_place+LEDGER_BIGNUM_LIMB_DIGITS-1)
+    / LEDGER_BIGNUM_LIMB_DIGITS;
+  limb_count = fraction_limbs + 1
+    + (integral_digits+LEDGER_BIGNUM_LIMB_DIGITS-1)
+      / LEDGER_BIGNUM_LIMB_DIGITS;
+  if (fraction_limbs > a->fraction_limbs
+  ||  limb_count-fraction_limbs > a->limb_count-a->fraction_limbs)
+  {
+    /* move the limbs to a wider layout */
+    int const shift = fraction_limbs-a->fraction_limbs;
+    size_t const set_size =
+      sizeof(unsigned long long int)*(size_t)limb_count;
+    unsigned long long int* const new_limbs =
+      (unsigned long long int*)ledger_util_malloc(2*set_size);
+    if (new_limbs == NULL)
+      return 0;
+    memset(new_limbs, 0, 2*set_size);
+    if (a->limbs != NULL){
+      size_t const old_size =
+        sizeof(unsigned long long int)*(size_t)a->limb_count;
+      /* the old spare limb may land below the new top, so fold first */
+      ledger_bignum_accum_fold(a);
+      memcpy(new_limbs+shift, a->limbs, old_size);
+      memcpy(new_limbs+limb_count+shift, a->limbs+a->limb_count, old_size);
+      ledger_util_free(a->limbs);
+    }
+    a->limbs = new_limbs;
+    a->limb_count = limb_count;
+    a->fraction_limbs = fraction_limbs;
+  }
+  a->point_place = point_place;
+  a->integral_digits = integral_digits;
+  return 1;
+}
+
+void ledger_bignum_accum_fold(struct ledger_bignum_accum* a){
+  int const limb_count = a->limb_count;
+  int set;
+  for (set = 0; set < 2 && limb_count > 0; ++set){
+    unsigned long long int* const limbs = a->limbs + set*limb_count;
+    unsigned long long int carry = 0;
+    int i;
+    for (i = 0; i < limb_count-1; ++i){
+      unsigned long long int const place = limbs[i] + carry;
+      limbs[i] = place%LEDGER_BIGNUM_LIMB_BASE;
+      carry = place/LEDGER_BIGNUM_LIMB_BASE;
+    }
+    limbs[i] += carry;
+  }
+  a->pending = 0;
+  return;
+}
+
+int ledger_bignum_rate_init(struct ledger_bignum_rate* r){
+  r->words = NULL;
+  r->numerator_count = 0;
+  r->denominator_count = 0;
+  r->shift = 0;
+  r->point_place = 0;
+  r->negative = 0;
+  r->work = NULL;
+  r->work_size = 0;
+  /* start as one over one */
+  r->words = (unsigned long int*)ledger_util_malloc
+    (sizeof(unsigned long int)*2);
+  if (r->words == NULL) return 0;
+  r->words[0] = 1u;
+  r->words[1] = 1u;
+  r->numerator_count = 1;
+  r->denominator_count = 1;
+  return 1;
+}
+
+void ledger_bignum_rate_clear(struct ledger_bignum_rate* r){
+  ledger_util_free(r->work);
+  r->work = NULL;
+  r->work_size = 0;
+  ledger_util_free(r->words);
+  r->words = NULL;
+  r->numerator_count = 0;
+  r->denominator_count = 0;
+  return;
+}
+
+int ledger_bignum_rate_reserve(struct ledger_bignum_rate* r, int size){
+  unsigned long int* new_work;
+  if (size <= r->work_size) return 1;
+  new_work = (unsigned long int*)ledger_util_malloc
+    (sizeof(unsigned long int)*(size_t)size);
+  if (new_work == NULL) return 0;
+  ledger_util_free(r->work);
+  r->work = new_work;
+  r->work_size = size;
+  return 1;
+}
+
+int ledger_bignum_words_load
+  (unsigned long int* w, struct ledger_bignum const* n)
+{
+  int const limb_count = ledger_bignum_count_limbs(n);
+  int count = limb_count*2;
+  int i;
+  for (i = 0; i < limb_count; ++i){
+    w[i*2] = (unsigned long int)(n->limbs[i]%LEDGER_BIGNUM_WORD_BASE);
+    w[i*2+1] = (unsigned long int)(n->limbs[i]/LEDGER_BIGNUM_WORD_BASE);
+  }
+  while (count > 0 && w[count-1] == 0) count -= 1;
+  return count;
+}
+
+int ledger_bignum_words_strip(unsigned long int* w, int* count){
+  int places = 0;
+  while (*count > 0 && w[0]%100u == 0u){
+    unsigned long long int rest = 0;
+    int i;
+    for (i = *count-1; i >= 0; --i){
+      unsigned long long int const place = rest*LEDGER_BIGNUM_WORD_BASE + w[i];
+      w[i] = (unsigned long int)(place/100u);
+      rest = place%100u;
+    }
+    if (w[*count-1] == 0u) *count -= 1;
+    places += 1;
+  }
+  return places;
+}
+
+int ledger_bignum_words_multiply
+  ( unsigned long int* dst, unsigned long int const* a, int a_count,
+    unsigned long int const* b, int b_count)
+{
+  int count = a_count+b_count;
+  int i, j;
+  if (a_count == 0 || b_count == 0) return 0;
+  memset(dst, 0, sizeof(unsigned long int)*(size_t)count);
+  for (i = 0; i < a_count; ++i){
+    unsigned long long int carry = 0;
+    for (j = 0; j < b_count; ++j){
+      unsigned long long int const place = dst[i+j]
+        + (unsigned long long int)a[i]*b[j] + carry;
+      dst[i+j] = (unsigned long int)(place%LEDGER_BIGNUM_WORD_BASE);
+      carry = place/LEDGER_BIGNUM_WORD_BASE;
+    }
+    dst[i+b_count] = (unsigned long int)carry;
+  }
+  while (count > 0 && dst[count-1] == 0) count -= 1;
+  return count;
+}
+
+int ledger_bignum_words_scale
+  (unsigned long int* w, int count, int places)
+{
+  int const shift = (places*2)/LEDGER_BIGNUM_WORD_DIGITS;
+  unsigned long int const factor =
+    ledger_bignum_tens[(places*2)%LEDGER_BIGNUM_WORD_DIGITS];
+  if (count == 0) return 0;
+  if (shift > 0){
+    memmove(w+shift, w, sizeof(unsigned long int)*(size_t)count);
+    memset(w, 0, sizeof(unsigned long int)*(size_t)shift);
+    count += shift;
+  }
+  if (factor > 1u){
+    unsigned long long int carry = 0;
+    int i;
+    for (i = shift; i < count; ++i){
+      unsigned long long int const place =
+        (unsigned long long int)w[i]*factor + carry;
+      w[i] = (unsigned long int)(place%LEDGER_BIGNUM_WORD_BASE);
+      carry = place/LEDGER_BIGNUM_WORD_BASE;
+    }
+    if (carry > 0){
+      w[count] = (unsigned long int)carry;
+      count += 1;
+    }
+  }
+  return count;
+}
+
+int ledger_bignum_words_divide
+  ( unsigned long int* q, unsigned long int* u, int u_count,
+    unsigned long int* v, int v_count, unsigned long int* t)
+{
+  unsigned long long int const base = LEDGER_BIGNUM_WORD_BASE;
+  int q_count = 0;
+  int up_tf = 1;
+  int i, j;
+  if (u_count < v_count){
+    /* the quotient is zero, and the dividend is the remainder */
+    for (i = u_count; i < v_count; ++i) u[i] = 0u;
+  } else if (v_count == 1){
+    unsigned long long int rest = 0;
+    for (i = u_count-1; i >= 0; --i){
+      unsigned long long int const place = rest*base + u[i];
+      q[i] = (unsigned long int)(place/v[0]);
+      rest = place%v[0];
+    }
+    u[0] = (unsigned long int)rest;
+    q_count = u_count;
+  } else /* Knuth's algorithm D */{
+    unsigned long long int const d = base/(v[v_count-1]+1u);
+    unsigned long long int carry;
+    /* normalize so that the top divisor word is at least base/2 */
+    carry = 0;
+    for (i = 0; i < v_count; ++i){
+      unsigned long long int const place = v[i]*d + carry;
+      v[i] = (unsigned long int)(place%base);
+      carry = place/base;
+    }
+    carry = 0;
+    for (i = 0; i < u_count; ++i){
+      unsigned long long int const place = u[i]*d + carry;
+      u[i] = (unsigned long int)(place%base);
+      carry = place/base;
+    }
+    u[u_count] = (unsigned long int)carry;
+    for (j = u_count-v_count; j >= 0; --j){
+      unsigned long long int const top =
+        (unsigned long long int)u[j+v_count]*base + u[j+v_count-1];
+      unsigned long long int qhat = top/v[v_count-1];
+      unsigned long long int rhat = top%v[v_count-1];
+      unsigned long long int take;
+      int borrow = 0;
+      /* estimate the quotient word from the top two divisor words */
+      while (qhat >= base
+      ||  qhat*v[v_count-2] > rhat*base + u[j+v_count-2])
+      {
+        qhat -= 1;
+        rhat += v[v_count-1];
+        if (rhat >= base) break;
+      }
+      /* multiply and subtract */
+      carry = 0;
+      for (i = 0; i < v_count; ++i){
+        unsigned long long int const place = qhat*v[i] + carry;
+        take = place%base + borrow;
+        carry = place/base;
+        if (u[i+j] < take){
+          u[i+j] = (unsigned long int)(u[i+j] + base - take);
+          borrow = 1;
+        } else {
+          u[i+j] = (unsigned long int)(u[i+j] - take);
+          borrow = 0;
+        }
+      }
+      take = carry + borrow;
+      if (u[j+v_count] < take){
+        /* the estimate was one too large; add back a divisor */
+        unsigned long long int const top_word = u[j+v_count];
+        carry = 0;
+        for (i = 0; i < v_count; ++i){
+          unsigned long long int const place =
+            (unsigned long long int)u[i+j] + v[i] + carry;
+          u[i+j] = (unsigned long int)(place%base);
+          carry = place/base;
+        }
+        u[j+v_count] = (unsigned long int)(top_word + carry - take);
+        qhat -= 1;
+      } else {
+        u[j+v_count] = (unsigned long int)(u[j+v_count] - take);
+      }
+      q[j] = (unsigned long int)qhat;
+    }
+    q_count = u_count-v_count+1;
+  }
+  /* round up if the remainder is at least what the divisor leaves */{
+    int borrow = 0;
+    for (i = 0; i < v_count; ++i){
+      unsigned long long int const take = (unsigned long long int)u[i]+borrow;
+      if (v[i] < take){
+        t[i] = (unsigned long int)(v[i] + base - take);
+        borrow = 1;
+      } else {
+        t[i] = (unsigned long int)(v[i] - take);
+        borrow = 0;
+      }
+    }
+    for (i = v_count-1; i >= 0; --i){
+      if (u[i] != t[i]){
+        up_tf = (u[i] > t[i]);
+        break;
+      }
+    }
+  }
+  while (q_count > 0 && q[q_count-1] == 0) q_count -= 1;
+  if (up_tf){
+    for (i = 0; i < q_count && q[i] == base-1u; ++i)
+      q[i] = 0u;
+    if (i < q_count){
+      q[i] += 1u;
+    } else {
+      q[q_count] = 1u;
+      q_count += 1;
+    }
+  }
+  return q_count;
+}
+
+int ledger_bignum_rate_run
+  ( struct ledger_bignum_rate* r, unsigned long int const* s, int s_count,
+    int s_place, unsigned long int** q)
+{
+  /* places to move from the divisor to the dividend */
+  int const places = r->shift - s_place;
+  int const b_size = r->denominator_count
+    + ((places < 0) ? (-places*2)/LEDGER_BIGNUM_WORD_DIGITS+1 : 0);
+  int a_size = s_count + r->numerator_count
+    + ((places > 0) ? (places*2)/LEDGER_BIGNUM_WORD_DIGITS+1 : 0);
+  int q_size;
+  unsigned long int *a, *b, *t;
+  int a_count, b_count, q_count;
+  if (a_size < b_size) a_size = b_size;
+  a_size += 1;
+  /* leave room to move the quotient onto a limb boundary */
+  q_size = a_size + 3;
+  if (!ledger_bignum_rate_reserve(r, a_size+b_size*2+q_size)) return -1;
+  a = r->work;
+  b = a+a_size;
+  t = b+b_size;
+  *q = t+b_size;
+  a_count = ledger_bignum_words_multiply
+    (a, s, s_count, r->words, r->numerator_count);
+  if (a_count == 0){
+    /* zero times anything */
+    return 0;
+  }
+  b_count = r->denominator_count;
+  memcpy(b, r->words+r->numerator_count,
+    sizeof(unsigned long int)*(size_t)b_count);
+  if (places > 0)
+    a_count = ledger_bignum_words_scale(a, a_count, places);
+  else if (places < 0)
+    b_count = ledger_bignum_words_scale(b, b_count, -places);
+  q_count = ledger_bignum_words_divide(*q, a, a_count, b, b_count, t);
+  return q_count;
+}
+
 /* END   static implementation */
 
 /* BEGIN implementation */
@@ -322,12 +1214,10 @@ void ledger_bignum_free(struct ledger_bignum* n){
 int ledger_bignum_compare
   (struct ledger_bignum const* a, struct ledger_bignum const* b)
 {
-  int a_start, a_end;
-  int b_start, b_end;
+  int top, bottom;
   int sign;
   /* ensure that signed zeroes compare equal */{
-    if (ledger_util_uiszero(a->digits,a->digit_count)
-    &&  ledger_util_uiszero(b->digits,b->digit_count))
+    if (ledger_bignum_is_zero(a) && ledger_bignum_is_zero(b))
       return 0;
   }
   /* optimize for sign differences */
@@ -340,39 +1230,21 @@ int ledger_bignum_compare
     sign = a->negative?-1:+1;
   }
 
-  /* align starts */{
-    if (a->point_place < b->point_place){
-      /* `a` has less digits */
-      a_start = (a->point_place - b->point_place);
-      b_start = 0;
-    } else {
-      /* `b` has less digits */
-      a_start = 0;
-      b_start = (b->point_place - a->point_place);
-    }
-  }
-  /* align ends */{
-    int const a_integral = a->digit_count - a->point_place;
-    int const b_integral = b->digit_count - b->point_place;
-    if (a_integral < b_integral){
-      /* `a` has less integer digits */
-      a_end = a->digit_count + (b_integral - a_integral);
-      b_end = b->digit_count;
-    } else {
-      /* `b` has less integer digits */
-      a_end = a->digit_count;
-      b_end = b->digit_count + (a_integral - b_integral);
-    }
+  /* align limbs at the centesimal point */{
+    int const a_fraction = ledger_bignum_fraction_limbs(a);
+    int const b_fraction = ledger_bignum_fraction_limbs(b);
+    int const a_integral = ledger_bignum_count_limbs(a) - a_fraction;
+    int const b_integral = ledger_bignum_count_limbs(b) - b_fraction;
+    top = (a_integral < b_integral) ? b_integral : a_integral;
+    bottom = (a_fraction < b_fraction) ? -b_fraction : -a_fraction;
   }
   /* compare from end */{
-    int a_i, b_i;
-    for (a_i = a_end-1, b_i = b_end-1; a_i >= a_start && b_i >= b_start;
-          --a_i, --b_i)
-    {
-      int const a_char = ledger_bignum_fetch_zero(a,a_i);
-      int const b_char = ledger_bignum_fetch_zero(b,b_i);
-      if (a_char < b_char) return -1*sign;
-      else if (a_char > b_char) return +1*sign;
+    int i;
+    for (i = top-1; i >= bottom; --i){
+      unsigned long long int const a_limb = ledger_bignum_fetch_zero(a,i);
+      unsigned long long int const b_limb = ledger_bignum_fetch_zero(b,i);
+      if (a_limb < b_limb) return -1*sign;
+      else if (a_limb > b_limb) return +1*sign;
     }
   }
   return 0;
@@ -380,46 +1252,27 @@ int ledger_bignum_compare
 
 int ledger_bignum_set_long(struct ledger_bignum* n, long int v){
   if (v == 0){
-    if (n->digits != NULL)
-      memset(n->digits,0,sizeof(unsigned char)*(n->digit_count));
+    ledger_bignum_zero_all(n);
     n->negative = 0;
     return 1;
   } else /* compute space needed to store the number */{
     unsigned long int nv;
     int neg;
-    int digit_count = 0;
     /* convert to unsigned */
     if (v < 0){
       neg = 1;
-      nv = (unsigned long int)-v;
+      nv = 0u-(unsigned long int)v;
     } else {
       neg = 0;
       nv = (unsigned long int)+v;
     }
-    /* count the digits */{
-      unsigned long int modal_nv = nv;
-      while (modal_nv > 0){
-        modal_nv /= 100;
-        digit_count += 1;
-      }
-    }
     /* allocate if needed */{
       int const ok = ledger_bignum_extend
-        (n,digit_count+n->point_place,n->point_place);
+        (n,ledger_bignum_measure(nv)+n->point_place,n->point_place);
       if (!ok) return 0;
     }
-    /* set the number value */{
-      int pos;
-      unsigned long int modal_nv = nv;
-      /* clear the decimal portion */
-      ledger_bignum_zero_cents(n);
-      /* place the rest of the digits */
-      for (pos = n->point_place; pos < n->digit_count; ++pos){
-        unsigned char next_digit = (unsigned char)(modal_nv%100u);
-        n->digits[pos] = next_digit;
-        modal_nv /= 100u;
-      }
-    }
+    /* set the number value */
+    ledger_bignum_place(n, nv, n->point_place);
     /* set the sign */
     n->negative = neg?1:0;
     /* done */
@@ -430,20 +1283,18 @@ int ledger_bignum_set_long(struct ledger_bignum* n, long int v){
 long int ledger_bignum_get_long(struct ledger_bignum const* n){
   long int out;
   /* ignore the fractional part */{
-    unsigned long int modal_out = 0;
+    unsigned long long int modal_out = 0;
+    int const fraction_limbs = ledger_bignum_fraction_limbs(n);
     int pos;
-    for (pos = n->digit_count-1; pos >= n->point_place; --pos){
-      unsigned char const next_digit = n->digits[pos];
-      if (modal_out >= ULONG_MAX/100){
+    for (pos = ledger_bignum_count_limbs(n)-1; pos >= fraction_limbs; --pos){
+      unsigned long long int const next_limb = n->limbs[pos];
+      if (next_limb > ULONG_MAX
+      ||  modal_out > (ULONG_MAX-next_limb)/LEDGER_BIGNUM_LIMB_BASE)
+      {
         modal_out = ULONG_MAX;
         break;
       }
-      modal_out *= 100u;
-      if (modal_out >= ULONG_MAX-next_digit){
-        modal_out = ULONG_MAX;
-        break;
-      }
-      modal_out += next_digit;
+      modal_out = modal_out*LEDGER_BIGNUM_LIMB_BASE + next_limb;
     }
     if (n->negative){
       if (modal_out > (unsigned long int)LONG_MAX)
@@ -543,68 +1394,32 @@ int ledger_bignum_set_text
     int const digit_count = (int)(str_count/2);
     int const point_place = (int)(fraction_count/2);
     int const ok = ledger_bignum_extend(n,digit_count,point_place);
-    int real_execution_start;
+    int const fraction_limbs = ledger_bignum_fraction_limbs(n);
+    size_t const integral_length =
+      (str_extent-fraction_extent-dot_extent-complement_extent);
+    unsigned char const* digits = text+complement_extent;
     if (!ok) return 0;
-    real_execution_start = n->point_place+(digit_count-point_place);
     /* transfer number */{
-      int i, read_point = 0;
+      size_t i;
+      int limb_i;
       if (complement_extent){
-        switch (text[read_point]){
-          case '-':
-            n->negative = 1;
-            break;
-          case '+':
-            n->negative = 0;
-            break;
-        }
-        read_point += 1;
+        n->negative = (text[0] == '-') ? 1 : 0;
       } else n->negative = 0;
-      /* put the integral portion */{
-        if (real_execution_start == n->point_place){
-          /* fetch a zero */;
-          i = real_execution_start;
-        } else {
-          /* first digit */{
-            unsigned char next_digit;
-            size_t const integral_length =
-              (str_extent-fraction_extent-dot_extent-complement_extent);
-            i = real_execution_start-1;
-            if (integral_length%2 == 0){
-              /* get two digits */
-              if (read_point < str_extent)
-                next_digit = (text[read_point++]-'0')*10;
-              if (read_point < str_extent)
-                next_digit += (text[read_point++]-'0');
-            } else {
-              /* get one digit */
-              if (read_point < str_extent)
-                next_digit = (text[read_point++]-'0');
-            }
-            n->digits[i] = next_digit;
-          }
-          for (; i > n->point_place; --i){
-            /* get two digits */
-            unsigned char next_digit = 0;
-            if (read_point < str_extent)
-              next_digit = (text[read_point++]-'0')*10;
-            if (read_point < str_extent)
-              next_digit += (text[read_point++]-'0');
-            n->digits[i-1] = next_digit;
-          }
-        }
+      /* put the integral portion, from the point upward */
+      for (i = integral_length, limb_i = fraction_limbs; i > 0; ++limb_i){
+        size_t const count = (i < 18) ? i : 18;
+        i -= count;
+        n->limbs[limb_i] = ledger_bignum_scan(digits+i, count);
       }
-      /* put the fractional portion */if (text[read_point] == '.'){
-        read_point += 1;
-        i -= 1;
-        for (; i >= 0; --i){
-          /* get two digits */
-          unsigned char next_digit = 0;
-          if (read_point < str_extent)
-            next_digit = (text[read_point++]-'0')*10;
-          if (read_point < str_extent)
-            next_digit += (text[read_point++]-'0');
-          n->digits[i] = next_digit;
-        }
+      /* put the fractional portion, from the point downward */
+      digits += integral_length+dot_extent;
+      for (i = 0, limb_i = fraction_limbs-1; i < fraction_extent; --limb_i){
+        size_t const count =
+          (fraction_extent-i < 18) ? fraction_extent-i : 18;
+        n->limbs[limb_i] = ledger_bignum_scan(digits+i, count)
+          * ledger_bignum_hundreds[(18-count)/2]
+          * (((18-count)%2 != 0) ? 10u : 1u);
+        i += count;
       }
     }/* end transfer number */
   } else {
@@ -613,103 +1428,66 @@ int ledger_bignum_set_text
   return 1;
 }
 
+int ledger_bignum_text_length
+  (struct ledger_bignum const* n, int want_plus)
+{
+  int top;
+  return ledger_bignum_measure_text(n, want_plus, &top);
+}
+
 int ledger_bignum_get_text
   (struct ledger_bignum const* n, unsigned char* buf, int len, int want_plus)
 {
-  int byte_count;
-  int real_execution_start;
-  /* compute number of bytes needed to represent the number */{
-    if (n->digit_count > 0){
-      int i;
-      byte_count = n->digit_count*2;
-      for (i = n->digit_count; i > n->point_place; --i){
-        if (n->digits[i-1] > 0)
-          break;
-        else byte_count -= 2;
+  unsigned char text[2*LEDGER_BIGNUM_DIGIT_MAX+24];
+  unsigned char* read_point;
+  int const fraction_limbs = ledger_bignum_fraction_limbs(n);
+  int top;
+  int const byte_count = ledger_bignum_measure_text(n, want_plus, &top);
+  /* compose the text from the end */if (buf != NULL && len > 0){
+    int i;
+    /* write in place if the whole number fits */
+    read_point = ((byte_count < len) ? buf : text)+byte_count;
+    *read_point = 0;
+    /* put the fractional portion */if (n->point_place > 0){
+      int const low_digits =
+        fraction_limbs*LEDGER_BIGNUM_LIMB_DIGITS - n->point_place;
+      read_point = ledger_bignum_emit(read_point, n->limbs[0],
+        low_digits, (LEDGER_BIGNUM_LIMB_DIGITS-low_digits)*2);
+      for (i = 1; i < fraction_limbs; ++i){
+        read_point = ledger_bignum_emit
+          (read_point, n->limbs[i], 0, 2*LEDGER_BIGNUM_LIMB_DIGITS);
       }
-      if (i > n->point_place){
-        if (n->digits[i-1] < 10){
-          /* drop front zero */
-          byte_count -= 1;
-        }
-      } else {
-        /* add front zero */
-        byte_count += 1;
+      *(--read_point) = '.';
+    }
+    /* put the integral portion */if (top > fraction_limbs){
+      for (i = fraction_limbs; i < top-1; ++i){
+        read_point = ledger_bignum_emit
+          (read_point, n->limbs[i], 0, 2*LEDGER_BIGNUM_LIMB_DIGITS);
       }
-      real_execution_start = i;
+      read_point = ledger_bignum_emit(read_point, n->limbs[top-1],
+        0, ledger_bignum_limb_width(n->limbs[top-1]));
     } else {
-      byte_count = 1;
+      /* plop a zero down */
+      *(--read_point) = '0';
     }
-    if (n->negative || want_plus){
-      /* add minus sign */
-      byte_count += 1;
-    }
-    if (n->point_place > 0){
-      /* add decimal point */
-      byte_count += 1;
-    }
-  }
-  /* construct the string */if (buf != NULL && len > 0){
-    int i, write_point = 0;
     if (n->negative){
-      if (write_point < len) buf[write_point++] = '-';
+      *(--read_point) = '-';
     } else if (want_plus){
-      if (write_point < len) buf[write_point++] = '+';
+      *(--read_point) = '+';
     }
-    /* put the integral portion */if (n->digit_count > 0){
-      if (real_execution_start == n->point_place){
-        /* plop a zero down */
-        if (write_point < len) buf[write_point++] = '0';
-        i = real_execution_start;
-      } else {
-        /* first digit */
-        if (n->digits[real_execution_start-1] >= 10){
-          /* put two digits */
-          if (write_point < len)
-            buf[write_point++] = '0'+(n->digits[real_execution_start-1]/10);
-          if (write_point < len)
-            buf[write_point++] = '0'+(n->digits[real_execution_start-1]%10);
-        } else {
-          /* put one digit */
-          if (write_point < len)
-            buf[write_point++] = '0'+(n->digits[real_execution_start-1]);
-        }
-        i = real_execution_start-1;
-        for (; i > n->point_place; --i){
-          /* put two digits */
-          if (write_point < len)
-            buf[write_point++] = '0'+(n->digits[i-1]/10);
-          if (write_point < len)
-            buf[write_point++] = '0'+(n->digits[i-1]%10);
-        }
-      }
-    } else {
-      if (write_point < len)
-        buf[write_point++] = '0';
-    }
-    /* put the fractional portion */if (n->point_place > 0){
-      if (write_point < len) buf[write_point++] = '.';
-      i -= 1;
-      for (; i >= 0; --i){
-        /* put two digits */
-        if (write_point < len)
-          buf[write_point++] = '0'+(n->digits[i]/10);
-        if (write_point < len)
-          buf[write_point++] = '0'+(n->digits[i]%10);
-      }
-    }
-    /* NUL-terminate the string */{
-      if (write_point < len) buf[write_point] = 0;
-      else buf[len-1] = 0;
+    /* truncate the string */
+    if (read_point != buf){
+      memcpy(buf, read_point, len-1);
+      buf[len-1] = 0;
     }
   }
   return byte_count;
 }
 
 void ledger_bignum_swap(struct ledger_bignum* n, struct ledger_bignum* n2){
-  unsigned char *tmp_p;
+  unsigned long long int *tmp_p;
   int tmp_i;
-  tmp_p = n->digits; n->digits = n2->digits; n2->digits = tmp_p;
+  tmp_p = n->limbs; n->limbs = n2->limbs; n2->limbs = tmp_p;
   tmp_i = n->digit_count;n->digit_count=n2->digit_count;n2->digit_count=tmp_i;
   tmp_i = n->point_place;n->point_place=n2->point_place;n2->point_place=tmp_i;
   tmp_i = n->negative;n->negative=n2->negative;n2->negative=tmp_i;
@@ -719,11 +1497,12 @@ void ledger_bignum_swap(struct ledger_bignum* n, struct ledger_bignum* n2){
 int ledger_bignum_copy
   (struct ledger_bignum* dst, struct ledger_bignum const* src)
 {
-  int const digit_count = src->digit_count;
+  int const limb_count = ledger_bignum_count_limbs(src);
   int ok =
-    ledger_bignum_alloc_unchecked(dst, digit_count, src->point_place);
+    ledger_bignum_alloc_unchecked(dst, src->digit_count, src->point_place);
   if (!ok) return 0;
-  memcpy(dst->digits, src->digits, digit_count);
+  if (limb_count > 0)
+    memcpy(dst->limbs, src->limbs, sizeof(unsigned long long int)*limb_count);
   dst->negative = src->negative;
   return 1;
 }
@@ -731,12 +1510,16 @@ int ledger_bignum_copy
 int ledger_bignum_assign
   (struct ledger_bignum* dst, struct ledger_bignum const* src)
 {
-  int const digit_count = src->digit_count;
+  int const limb_count = ledger_bignum_count_limbs(src);
   int ok =
-    ledger_bignum_extend(dst, digit_count, src->point_place);
-  int const disparity = dst->point_place-src->point_place;
+    ledger_bignum_extend(dst, src->digit_count, src->point_place);
+  int const disparity = ledger_bignum_fraction_limbs(dst)
+    - ledger_bignum_fraction_limbs(src);
   if (!ok) return 0;
-  memcpy(dst->digits+disparity, src->digits, digit_count);
+  if (limb_count > 0){
+    memcpy(dst->limbs+disparity, src->limbs,
+      sizeof(unsigned long long int)*limb_count);
+  }
   dst->negative = src->negative;
   return 1;
 }
@@ -744,19 +1527,35 @@ int ledger_bignum_assign
 int ledger_bignum_truncate
   (struct ledger_bignum* dst, struct ledger_bignum const* src)
 {
-  int digit_count = src->digit_count;
-  int initial_digit = 0;
-  int disparity = dst->point_place-src->point_place;
+  int limb_count = ledger_bignum_count_limbs(src);
+  int const dst_count = ledger_bignum_count_limbs(dst);
+  int initial_limb = 0;
+  int disparity = ledger_bignum_fraction_limbs(dst)
+    - ledger_bignum_fraction_limbs(src);
   if (disparity < 0){
-    initial_digit = -disparity;
-    digit_count += disparity;
+    initial_limb = -disparity;
+    limb_count += disparity;
     disparity = 0;
   }
-  if (digit_count+disparity > dst->digit_count){
-    digit_count = dst->digit_count-disparity;
+  if (limb_count+disparity > dst_count){
+    limb_count = dst_count-disparity;
+  }
+  if (limb_count <= 0){
+    ledger_bignum_zero_all(dst);
+  } else {
+    /* zero the limbs outside of the copy */
+    if (disparity > 0)
+      memset(dst->limbs, 0, sizeof(unsigned long long int)*disparity);
+    if (disparity+limb_count < dst_count){
+      memset(dst->limbs+disparity+limb_count, 0,
+        sizeof(unsigned long long int)*(dst_count-disparity-limb_count));
+    }
+    memcpy(dst->limbs+disparity, src->limbs+initial_limb,
+      sizeof(unsigned long long int)*limb_count);
+    if (src->point_place > dst->point_place
+    ||  src->digit_count-src->point_place > dst->digit_count-dst->point_place)
+      ledger_bignum_clip(dst);
   }
-  if (digit_count > 0)
-    memcpy(dst->digits+disparity, src->digits+initial_digit, digit_count);
   dst->negative = src->negative;
   return 1;
 }
@@ -789,8 +1588,10 @@ int ledger_bignum_add
   ledger_bignum_init(&tmp);
   if (!ledger_bignum_extend(&tmp, left->digit_count, left->point_place))
     return 0;
-  if (!ledger_bignum_extend(&tmp, right->digit_count, right->point_place))
+  if (!ledger_bignum_extend(&tmp, right->digit_count, right->point_place)){
+    ledger_bignum_clear(&tmp);
     return 0;
+  }
   do {
     ledger_bignum_truncate(&tmp, left);
     if (tmp.negative == right->negative)
@@ -816,8 +1617,10 @@ int ledger_bignum_subtract
   ledger_bignum_init(&tmp);
   if (!ledger_bignum_extend(&tmp, left->digit_count, left->point_place))
     return 0;
-  if (!ledger_bignum_extend(&tmp, right->digit_count, right->point_place))
+  if (!ledger_bignum_extend(&tmp, right->digit_count, right->point_place)){
+    ledger_bignum_clear(&tmp);
     return 0;
+  }
   do {
     ledger_bignum_truncate(&tmp, left);
     if (tmp.negative == right->negative)
@@ -834,4 +1637,551 @@ int ledger_bignum_subtract
   return ok;
 }
 
+int ledger_bignum_add_assign
+  (struct ledger_bignum* dst, struct ledger_bignum const* right)
+{
+  if (!ledger_bignum_widen(dst, right))
+    return 0;
+  else if (dst->negative == right->negative)
+    return ledger_bignum_gp_add(dst, right);
+  else
+    return ledger_bignum_gp_subtract(dst, right);
+}
+
+int ledger_bignum_subtract_assign
+  (struct ledger_bignum* dst, struct ledger_bignum const* right)
+{
+  if (!ledger_bignum_widen(dst, right))
+    return 0;
+  else if (dst->negative == right->negative)
+    return ledger_bignum_gp_subtract(dst, right);
+  else
+    return ledger_bignum_gp_add(dst, right);
+}
+
+int ledger_bignum_get_fixed
+  (struct ledger_bignum const* n, long long int* value, int* point_place)
+{
+  unsigned long long int magnitude;
+  int const limb_count = ledger_bignum_count_limbs(n);
+  int const low_digits = ledger_bignum_fraction_limbs(n)
+    *LEDGER_BIGNUM_LIMB_DIGITS - n->point_place;
+  unsigned long long int const low = (limb_count > 0) ? n->limbs[0] : 0u;
+  unsigned long long int const high = (limb_count > 1) ? n->limbs[1] : 0u;
+  /* look past the lowest two limbs */{
+    int i;
+    for (i = 2; i < limb_count; ++i){
+      if (n->limbs[i] != 0)
+        /* too many digits */
+        return 0;
+    }
+  }
+  if (low == 0 && high == 0 && n->negative){
+    /* negative zero has no fixed-point form */
+    return 0;
+  } else if (high >= ledger_bignum_hundreds[low_digits]){
+    /* too many digits */
+    return 0;
+  }
+  /* shift out the unused digits */
+  magnitude = high*ledger_bignum_hundreds[LEDGER_BIGNUM_LIMB_DIGITS-low_digits]
+    + low/ledger_bignum_hundreds[low_digits];
+  *value = n->negative
+    ? -(long long int)magnitude : +(long long int)magnitude;
+  *point_place = n->point_place;
+  return 1;
+}
+
+int ledger_bignum_set_fixed
+  (struct ledger_bignum* n, long long int value, int point_place)
+{
+  unsigned long long int magnitude;
+  int digit_count;
+  if (point_place < 0 || point_place > LEDGER_BIGNUM_DIGIT_MAX)
+    return 0;
+  /* convert to unsigned */
+  if (value < 0){
+    magnitude = 0u-(unsigned long long int)value;
+  } else {
+    magnitude = (unsigned long long int)value;
+  }
+  /* count the digits */{
+    digit_count = ledger_bignum_measure(magnitude);
+    if (digit_count < point_place)
+      digit_count = point_place;
+  }
+  /* allocate if needed */{
+    int const ok = ledger_bignum_extend(n, digit_count, point_place);
+    if (!ok) return 0;
+  }
+  /* place the digits */
+  ledger_bignum_place(n, magnitude, n->point_place-point_place);
+  n->negative = (value < 0)?1:0;
+  return 1;
+}
+
+int ledger_bignum_fixed_from_text
+  (unsigned char const* text, long long int* value, int* point_place)
+{
+  unsigned long long int magnitude = 0;
+  int negative = 0;
+  int digit_tf;
+  unsigned char const* start;
+  size_t significant_count, fraction_count = 0;
+  /* recognize the sign */
+  if (*text == '-'){
+    negative = 1;
+    ++text;
+  } else if (*text == '+'){
+    ++text;
+  }
+  /* skip the leading zeroes */
+  for (start = text; *text == '0'; ++text)
+    continue;
+  digit_tf = (text != start);
+  /* integral portion */
+  for (start = text; *text >= '0' && *text <= '9'; ++text){
+    magnitude = magnitude*10u + (*text-'0');
+  }
+  significant_count = text-start;
+  /* fractional portion */if (*text == '.'){
+    unsigned char const* const fraction = ++text;
+    if (significant_count == 0){
+      for (; *text == '0'; ++text)
+        continue;
+    }
+    for (start = text; *text >= '0' && *text <= '9'; ++text){
+      magnitude = magnitude*10u + (*text-'0');
+    }
+    significant_count += text-start;
+    fraction_count = text-fraction;
+  }
+  if (!digit_tf && significant_count == 0 && fraction_count == 0){
+    /* no number here */
+    return 0;
+  }
+  /*
+   * eighteen significant digits always fit, with room for the pad
+   * to whole centesimal places; longer runs wrapped harmlessly
+   */
+  if (significant_count+fraction_count%2 > 18)
+    return 0;
+  if (fraction_count%2 != 0){
+    magnitude *= 10u;
+    fraction_count += 1;
+  }
+  if (negative && magnitude == 0){
+    /* negative zero has no fixed-point form */
+    return 0;
+  }
+  *value = negative
+    ? -(long long int)magnitude : +(long long int)magnitude;
+  *point_place = (int)(fraction_count/2);
+  return 1;
+}
+
+int ledger_bignum_fixed_to_text
+  ( long long int value, int point_place,
+    unsigned char* buf, int len, int want_plus)
+{
+  unsigned char text[2*LEDGER_BIGNUM_DIGIT_MAX+24];
+  int const byte_count =
+    ledger_bignum_fixed_text_length(value, point_place, want_plus);
+  if (byte_count < 0)
+    return -1;
+  /* compose the text from the end */if (buf != NULL && len > 0){
+    unsigned long long int magnitude = (value < 0)
+      ? 0u-(unsigned long long int)value : (unsigned long long int)value;
+    /* write in place if the whole number fits */
+    unsigned char* read_point = ((byte_count < len) ? buf : text)+byte_count;
+    int i;
+    *read_point = 0;
+    /* put the fractional portion, a base-100 digit at a time */
+    for (i = 0; i < point_place; ++i){
+      read_point -= 2;
+      memcpy(read_point, ledger_bignum_pairs+(magnitude%100u)*2, 2);
+      magnitude /= 100u;
+    }
+    if (point_place > 0){
+      *(--read_point) = '.';
+    }
+    /* put the integral portion */
+    for (; magnitude >= 100u; magnitude /= 100u){
+      read_point -= 2;
+      memcpy(read_point, ledger_bignum_pairs+(magnitude%100u)*2, 2);
+    }
+    if (magnitude >= 10u){
+      read_point -= 2;
+      memcpy(read_point, ledger_bignum_pairs+magnitude*2, 2);
+    } else {
+      *(--read_point) = (unsigned char)('0'+magnitude);
+    }
+    if (value < 0){
+      *(--read_point) = '-';
+    } else if (want_plus){
+      *(--read_point) = '+';
+    }
+    /* truncate the string */
+    if (read_point != buf){
+      memcpy(buf, read_point, len-1);
+      buf[len-1] = 0;
+    }
+  }
+  return byte_count;
+}
+
+int ledger_bignum_fixed_text_length
+  (long long int value, int point_place, int want_plus)
+{
+  unsigned long long int const magnitude = (value < 0)
+    ? 0u-(unsigned long long int)value : (unsigned long long int)value;
+  int digit_width, byte_count;
+  if (point_place < 0 || point_place > LEDGER_BIGNUM_DIGIT_MAX)
+    return -1;
+  /* count the decimal digits without dividing */
+  digit_width = (magnitude >= LEDGER_BIGNUM_LIMB_BASE)
+    ? 2*LEDGER_BIGNUM_LIMB_DIGITS+1 : ledger_bignum_limb_width(magnitude);
+  /* keep at least the front zero of the integral portion */
+  byte_count = digit_width - point_place*2;
+  if (byte_count < 1)
+    byte_count = 1;
+  if (point_place > 0){
+    /* add decimal point */
+    byte_count += 1+point_place*2;
+  }
+  if (value < 0 || want_plus){
+    /* add sign */
+    byte_count += 1;
+  }
+  return byte_count;
+}
+
+struct ledger_bignum_accum* ledger_bignum_accum_new(void){
+  struct ledger_bignum_accum* a = (struct ledger_bignum_accum*)
+    ledger_util_malloc(sizeof(struct ledger_bignum_accum));
+  if (a != NULL){
+    a->limbs = NULL;
+    a->limb_count = 0;
+    a->fraction_limbs = 0;
+    a->point_place = 0;
+    a->integral_digits = 0;
+    a->pending = 0;
+  }
+  return a;
+}
+
+void ledger_bignum_accum_free(struct ledger_bignum_accum* a){
+  if (a != NULL){
+    ledger_util_free(a->limbs);
+    ledger_util_free(a);
+  }
+  return;
+}
+
+void ledger_bignum_accum_zero(struct ledger_bignum_accum* a){
+  if (a->limbs != NULL){
+    memset(a->limbs, 0,
+      2*sizeof(unsigned long long int)*(size_t)a->limb_count);
+  }
+  a->point_place = 0;
+  a->integral_digits = 0;
+  a->pending = 0;
+  return;
+}
+
+int ledger_bignum_accum_add
+  (struct ledger_bignum_accum* a, struct ledger_bignum const* n)
+{
+  int const limb_count = ledger_bignum_count_limbs(n);
+  unsigned long long int* limbs;
+  int i;
+  if (!ledger_bignum_accum_reserve
+      (a, n->point_place, n->digit_count-n->point_place))
+    return 0;
+  if (a->pending >= LEDGER_BIGNUM_ACCUM_FOLD)
+    ledger_bignum_accum_fold(a);
+  limbs = a->limbs + (n->negative ? a->limb_count : 0)
+    + (a->fraction_limbs-ledger_bignum_fraction_limbs(n));
+  for (i = 0; i < limb_count; ++i){
+    limbs[i] += n->limbs[i];
+  }
+  a->pending += 1;
+  return 1;
+}
+
+int ledger_bignum_accum_add_fixed
+  (struct ledger_bignum_accum* a, long long int value, int point_place)
+{
+  unsigned long long int limbs[LEDGER_BIGNUM_LIMB_MAX];
+  struct ledger_bignum n;
+  unsigned long long int magnitude;
+  if (point_place < 0 || point_place > LEDGER_BIGNUM_DIGIT_MAX)
+    return 0;
+  /* convert to unsigned */
+  if (value < 0){
+    magnitude = 0u-(unsigned long long int)value;
+  } else {
+    magnitude = (unsigned long long int)value;
+  }
+  /* lay out the number on the stack, as `ledger_bignum_set_fixed` would */
+  n.limbs = limbs;
+  n.digit_count = ledger_bignum_measure(magnitude);
+  if (n.digit_count < point_place)
+    n.digit_count = point_place;
+  n.point_place = point_place;
+  n.negative = (value < 0)?1:0;
+  ledger_bignum_zero_all(&n);
+  ledger_bignum_place(&n, magnitude, 0);
+  return ledger_bignum_accum_add(a, &n);
+}
+
+int ledger_bignum_accum_get
+  (struct ledger_bignum_accum* a, struct ledger_bignum* n)
+{
+  struct ledger_bignum total, debt;
+  int ok = 0;
+  ledger_bignum_accum_fold(a);
+  ledger_bignum_init(&total);
+  ledger_bignum_init(&debt);
+  do {
+    /* lay out the limbs exactly as the sets, which may be wider */
+    int const digits = a->limb_count*LEDGER_BIGNUM_LIMB_DIGITS;
+    int const places = a->fraction_limbs*LEDGER_BIGNUM_LIMB_DIGITS;
+    int integral_digits = a->integral_digits;
+    int i;
+    if (!ledger_bignum_alloc_unchecked(&total, digits, places))
+      break;
+    if (!ledger_bignum_alloc_unchecked(&debt, digits, places))
+      break;
+    if (a->limb_count > 0){
+      memcpy(total.limbs, a->limbs,
+        sizeof(unsigned long long int)*(size_t)a->limb_count);
+      memcpy(debt.limbs, a->limbs+a->limb_count,
+        sizeof(unsigned long long int)*(size_t)a->limb_count);
+    }
+    /* settle the negative addends */
+    if (!ledger_bignum_gp_subtract(&total, &debt))
+      break;
+    /* count the integral digits that the carries produced */
+    for (i = a->limb_count-1; i >= a->fraction_limbs; --i){
+      if (total.limbs[i] != 0){
+        int const carried = (i-a->fraction_limbs)*LEDGER_BIGNUM_LIMB_DIGITS
+          + ledger_bignum_measure(total.limbs[i]);
+        if (carried > integral_digits)
+          integral_digits = carried;
+        break;
+      }
+    }
+    if (!ledger_bignum_extend
+        (n, a->point_place+integral_digits, a->point_place))
+      break;
+    ok = ledger_bignum_truncate(n, &total);
+  } while (0);
+  ledger_bignum_clear(&debt);
+  ledger_bignum_clear(&total);
+  return ok;
+}
+
+int ledger_bignum_round
+  (struct ledger_bignum* dst, struct ledger_bignum const* src, int point_place)
+{
+  int ok = 0;
+  struct ledger_bignum tmp;
+  int digits;
+  if (point_place < 0 || point_place > LEDGER_BIGNUM_DIGIT_MAX)
+    return 0;
+  digits = src->digit_count - src->point_place + point_place;
+  if (digits > LEDGER_BIGNUM_DIGIT_MAX)
+    return 0;
+  else if (digits < 1)
+    /* leave room for a carry into the units */digits = 1;
+  ledger_bignum_init(&tmp);
+  if (!ledger_bignum_alloc_unchecked(&tmp, digits, point_place))
+    return 0;
+  do {
+    ok = ledger_bignum_truncate(&tmp, src);
+    if (!ok) break;
+    if (src->point_place > point_place){
+      /* read the first dropped digit */
+      int const pos = ledger_bignum_fraction_limbs(src)
+        *LEDGER_BIGNUM_LIMB_DIGITS - point_place - 1;
+      unsigned long long int const digit =
+        (src->limbs[pos/LEDGER_BIGNUM_LIMB_DIGITS]
+          / ledger_bignum_hundreds[pos%LEDGER_BIGNUM_LIMB_DIGITS]) % 100u;
+      if (digit >= 50u){
+        /* add one in the last place kept, away from zero */
+        unsigned long long int limbs[LEDGER_BIGNUM_LIMB_MAX];
+        struct ledger_bignum unit;
+        unit.limbs = limbs;
+        unit.digit_count = (point_place > 0) ? point_place : 1;
+        unit.point_place = point_place;
+        unit.negative = tmp.negative;
+        ledger_bignum_zero_all(&unit);
+        ledger_bignum_place(&unit, 1u, 0);
+        ok = ledger_bignum_gp_add(&tmp, &unit);
+        if (ok && ledger_bignum_is_zero(&tmp))
+          /* the carry ran past the digit limit */ok = 0;
+        if (!ok) break;
+      }
+    }
+    if (ledger_bignum_is_zero(&tmp))
+      tmp.negative = 0;
+  } while (0);
+  if (ok){
+    ledger_bignum_swap(dst, &tmp);
+  }
+  ledger_bignum_clear(&tmp);
+  return ok;
+}
+
+int ledger_bignum_multiply_ratio
+  ( struct ledger_bignum* dst, struct ledger_bignum const* src,
+    struct ledger_bignum const* numerator,
+    struct ledger_bignum const* denominator, int point_place)
+{
+  int ok;
+  struct ledger_bignum_rate rate;
+  if (!ledger_bignum_rate_init(&rate))
+    return 0;
+  ok = ledger_bignum_rate_set(&rate, numerator, denominator, point_place)
+    &&  ledger_bignum_rate_apply(&rate, dst, src);
+  ledger_bignum_rate_clear(&rate);
+  return ok;
+}
+
+struct ledger_bignum_rate* ledger_bignum_rate_new(void){
+  struct ledger_bignum_rate* r = (struct ledger_bignum_rate*)
+    ledger_util_malloc(sizeof(struct ledger_bignum_rate));
+  if (r != NULL){
+    if (!ledger_bignum_rate_init(r)){
+      ledger_util_free(r);
+      r = NULL;
+    }
+  }
+  return r;
+}
+
+void ledger_bignum_rate_free(struct ledger_bignum_rate* r){
+  if (r != NULL){
+    ledger_bignum_rate_clear(r);
+    ledger_util_free(r);
+  }
+  return;
+}
+
+int ledger_bignum_rate_set
+  ( struct ledger_bignum_rate* r, struct ledger_bignum const* numerator,
+    struct ledger_bignum const* denominator, int point_place)
+{
+  unsigned long int* words;
+  int numerator_count, denominator_count;
+  int shift;
+  if (point_place < 0 || point_place > LEDGER_BIGNUM_DIGIT_MAX)
+    return 0;
+  else if (ledger_bignum_is_zero(denominator))
+    return 0;
+  words = (unsigned long int*)ledger_util_malloc
+    ( sizeof(unsigned long int)*2*(size_t)
+        ( ledger_bignum_count_limbs(numerator)
+        + ledger_bignum_count_limbs(denominator)));
+  if (words == NULL) return 0;
+  /* the limbs hold whole numbers in units of their fraction limbs */
+  shift = point_place
+    + ledger_bignum_fraction_limbs(denominator)*LEDGER_BIGNUM_LIMB_DIGITS
+    - ledger_bignum_fraction_limbs(numerator)*LEDGER_BIGNUM_LIMB_DIGITS;
+  /* keep the whole numbers short, so that most divisors fit a word */
+  numerator_count = ledger_bignum_words_load(words, numerator);
+  shift += ledger_bignum_words_strip(words, &numerator_count);
+  denominator_count = ledger_bignum_words_load
+    (words+numerator_count, denominator);
+  shift -= ledger_bignum_words_strip
+    (words+numerator_count, &denominator_count);
+  ledger_util_free(r->words);
+  r->words = words;
+  r->numerator_count = numerator_count;
+  r->denominator_count = denominator_count;
+  r->shift = shift;
+  r->point_place = point_place;
+  r->negative = (numerator->negative != denominator->negative);
+  return 1;
+}
+
+int ledger_bignum_rate_apply
+  ( struct ledger_bignum_rate* r, struct ledger_bignum* dst,
+    struct ledger_bignum const* src)
+{
+  unsigned long int s[LEDGER_BIGNUM_LIMB_MAX*2];
+  unsigned long int* q;
+  int const fraction_limbs =
+    (r->point_place+LEDGER_BIGNUM_LIMB_DIGITS-1)/LEDGER_BIGNUM_LIMB_DIGITS;
+  int const s_count = ledger_bignum_words_load(s, src);
+  char const negative = (src->negative != r->negative);
+  int q_count;
+  int limb_count, integral_digits = 0;
+  int i;
+  /* skip the zero limbs below the lowest digit */
+  for (i = 0; i*2+1 < s_count && s[i*2] == 0u && s[i*2+1] == 0u; ++i)
+    continue;
+  q_count = ledger_bignum_rate_run(r, s+i*2, s_count-i*2,
+    (ledger_bignum_fraction_limbs(src)-i)*LEDGER_BIGNUM_LIMB_DIGITS, &q);
+  if (q_count < 0) return 0;
+  /* move the quotient onto a limb boundary */
+  q_count = ledger_bignum_words_scale(q, q_count,
+    fraction_limbs*LEDGER_BIGNUM_LIMB_DIGITS - r->point_place);
+  limb_count = (q_count+1)/2;
+  if (limb_count > fraction_limbs){
+    unsigned long long int top = q[limb_count*2-2];
+    if (limb_count*2-1 < q_count)
+      top += (unsigned long long int)q[limb_count*2-1]
+        * LEDGER_BIGNUM_WORD_BASE;
+    integral_digits = (limb_count-fraction_limbs-1)*LEDGER_BIGNUM_LIMB_DIGITS
+      + ledger_bignum_measure(top);
+  }
+  if (integral_digits > LEDGER_BIGNUM_DIGIT_MAX-r->point_place)
+    return 0;
+  if (!ledger_bignum_alloc_unchecked
+      (dst, integral_digits+r->point_place, r->point_place))
+    return 0;
+  for (i = 0; i < limb_count; ++i){
+    unsigned long long int limb = q[i*2];
+    if (i*2+1 < q_count)
+      limb += (unsigned long long int)q[i*2+1]*LEDGER_BIGNUM_WORD_BASE;
+    dst->limbs[i] = limb;
+  }
+  dst->negative = (q_count > 0) ? negative : 0;
+  return 1;
+}
+
+int ledger_bignum_rate_apply_fixed
+  (struct ledger_bignum_rate* r, long long int* value, int* point_place)
+{
+  unsigned long int s[3];
+  unsigned long int* q;
+  unsigned long long int magnitude;
+  int s_count = 0;
+  int q_count;
+  if (*point_place < 0 || *point_place > LEDGER_BIGNUM_DIGIT_MAX)
+    return 0;
+  /* convert to unsigned */
+  if (*value < 0){
+    magnitude = 0u-(unsigned long long int)*value;
+  } else {
+    magnitude = (unsigned long long int)*value;
+  }
+  for (; magnitude > 0; ++s_count){
+    s[s_count] = (unsigned long int)(magnitude%LEDGER_BIGNUM_WORD_BASE);
+    magnitude /= LEDGER_BIGNUM_WORD_BASE;
+  }
+  q_count = ledger_bignum_rate_run(r, s, s_count, *point_place, &q);
+  if (q_count < 0 || q_count > 2)
+    /* two words hold at most eighteen digits */return 0;
+  magnitude = (q_count > 0) ? q[0] : 0u;
+  if (q_count > 1)
+    magnitude += (unsigned long long int)q[1]*LEDGER_BIGNUM_WORD_BASE;
+  *value = ((*value < 0) != r->negative)
+    ? -(long long int)magnitude : +(long long int)magnitude;
+  *point_place = r->point_place;
+  return 1;
+}
+
 /* END   implementation */
@@ -15,6 +15,16 @@ extern "C" {
  */
 struct ledger_bignum;
 
+/*
+ * Accumulator for summing many big numbers
+ */
+struct ledger_bignum_accum;
+
+/*
+ * Exact rational rate, applied to many big numbers
+ */
+struct ledger_bignum_rate;
+
 
 /*
  * Construct a new big number, equal to zero.
@@ -101,6 +111,15 @@ int ledger_bignum_set_text
 int ledger_bignum_get_text
   (struct ledger_bignum const* n, unsigned char* buf, int len, int want_plus);
 
+/*
+ * Measure the text form of a big number without writing it.
+ * - n the number to measure
+ * - want_plus whether to count a forced plus sign
+ * @return the number of bytes `ledger_bignum_get_text` would need,
+ *   not including the NUL terminator
+ */
+int ledger_bignum_text_length(struct ledger_bignum const* n, int want_plus);
+
 /*
  * Swap two big numbers.
  * - n a number
@@ -167,6 +186,215 @@ int ledger_bignum_subtract
   ( struct ledger_bignum* dst,
     struct ledger_bignum const* left, struct ledger_bignum const* right);
 
+/*
+ * Add a big number to another in place. The destination keeps its
+ * storage, growing only when the addend has more places or the sum
+ * carries past the destination's digits.
+ * - dst number to accumulate into
+ * - right the addend
+ * @return one on success, zero otherwise
+ */
+int ledger_bignum_add_assign
+  (struct ledger_bignum* dst, struct ledger_bignum const* right);
+
+/*
+ * Subtract a big number from another in place. The destination keeps
+ * its storage, growing only when the subtrahend has more places or
+ * the difference carries past the destination's digits.
+ * - dst number to subtract from
+ * - right the subtrahend
+ * @return one on success, zero otherwise
+ */
+int ledger_bignum_subtract_assign
+  (struct ledger_bignum* dst, struct ledger_bignum const* right);
+
+/*
+ * Retrieve a big number as a fixed-point integer.
+ * - n the number to read
+ * - value integer to receive the number, in units of 100^(-point_place)
+ * - point_place integer to receive the number of centesimal places
+ * @return one on success, zero if the number does not fit
+ *   in eighteen decimal digits or is a negative zero
+ */
+int ledger_bignum_get_fixed
+  (struct ledger_bignum const* n, long long int* value, int* point_place);
+
+/*
+ * Assign a fixed-point integer to a big number. As with the other
+ * assignments, the number keeps any extra centesimal places it
+ * already has, and reuses its digit space whenever it can.
+ * - n the number to modify
+ * - value integer in units of 100^(-point_place)
+ * - point_place number of centesimal places
+ * @return one on success, zero otherwise
+ */
+int ledger_bignum_set_fixed
+  (struct ledger_bignum* n, long long int value, int point_place);
+
+/*
+ * Parse text as a fixed-point integer, as `ledger_bignum_set_text`
+ * would parse it into a fresh number.
+ * - text the text to parse
+ * - value integer to receive the number, in units of 100^(-point_place)
+ * - point_place integer to receive the number of centesimal places
+ * @return one on success, zero if the text holds no number or the
+ *   number does not fit in eighteen decimal digits
+ */
+int ledger_bignum_fixed_from_text
+  (unsigned char const* text, long long int* value, int* point_place);
+
+/*
+ * Write a fixed-point integer as text, formatted as
+ * `ledger_bignum_get_text` would format the same number.
+ * - value integer in units of 100^(-point_place)
+ * - point_place number of centesimal places
+ * - buf buffer to receive the text
+ * - len size of the buffer
+ * - want_plus nonzero if a plus sign is desired for positive numbers
+ * @return the number of bytes needed to hold the string, not including
+ *   the NUL terminator, or negative on error
+ */
+int ledger_bignum_fixed_to_text
+  ( long long int value, int point_place,
+    unsigned char* buf, int len, int want_plus);
+
+/*
+ * Measure the text form of a fixed-point integer without writing it.
+ * - value integer in units of 100^(-point_place)
+ * - point_place number of centesimal places
+ * - want_plus nonzero if a plus sign is desired for positive numbers
+ * @return the number of bytes `ledger_bignum_fixed_to_text` would need,
+ *   not including the NUL terminator, or negative on error
+ */
+int ledger_bignum_fixed_text_length
+  (long long int value, int point_place, int want_plus);
+
+/*
+ * Construct a new accumulator, holding a sum of zero.
+ * @return the accumulator on success, otherwise NULL
+ */
+struct ledger_bignum_accum* ledger_bignum_accum_new(void);
+
+/*
+ * Destroy an accumulator.
+ * - a the accumulator to destroy
+ */
+void ledger_bignum_accum_free(struct ledger_bignum_accum* a);
+
+/*
+ * Reset an accumulator to a sum of zero, keeping its storage.
+ * - a the accumulator to reset
+ */
+void ledger_bignum_accum_zero(struct ledger_bignum_accum* a);
+
+/*
+ * Add a big number to an accumulator. Carries between digits are
+ * deferred until the sum is read.
+ * - a the accumulator
+ * - n the addend
+ * @return one on success, zero otherwise
+ */
+int ledger_bignum_accum_add
+  (struct ledger_bignum_accum* a, struct ledger_bignum const* n);
+
+/*
+ * Add a fixed-point integer to an accumulator.
+ * - a the accumulator
+ * - value integer in units of 100^(-point_place)
+ * - point_place number of centesimal places
+ * @return one on success, zero otherwise
+ */
+int ledger_bignum_accum_add_fixed
+  (struct ledger_bignum_accum* a, long long int value, int point_place);
+
+/*
+ * Read the sum held by an accumulator. The number receives at least
+ * the centesimal places and integral digits of the widest addend,
+ * keeping any extra places it already has.
+ * - a the accumulator
+ * - n number to receive the sum
+ * @return one on success, zero otherwise
+ */
+int ledger_bignum_accum_get
+  (struct ledger_bignum_accum* a, struct ledger_bignum* n);
+
+/*
+ * Round a big number to a number of centesimal places, with halves
+ * rounded away from zero.
+ * - dst number to overwrite
+ * - src number to round
+ * - point_place centesimal places of the result
+ * @return one on success, zero otherwise
+ */
+int ledger_bignum_round
+  (struct ledger_bignum* dst, struct ledger_bignum const* src, int point_place);
+
+/*
+ * Multiply a big number by an exact ratio of two big numbers. The
+ * product is rounded to a number of centesimal places, with halves
+ * rounded away from zero.
+ * - dst number to overwrite
+ * - src number to multiply
+ * - numerator numerator of the ratio
+ * - denominator denominator of the ratio; must not be zero
+ * - point_place centesimal places of the result
+ * @return one on success, zero otherwise
+ */
+int ledger_bignum_multiply_ratio
+  ( struct ledger_bignum* dst, struct ledger_bignum const* src,
+    struct ledger_bignum const* numerator,
+    struct ledger_bignum const* denominator, int point_place);
+
+/*
+ * Construct a new rate, equal to one with no centesimal places.
+ * @return the rate on success, otherwise NULL
+ */
+struct ledger_bignum_rate* ledger_bignum_rate_new(void);
+
+/*
+ * Destroy a rate.
+ * - r the rate to destroy
+ */
+void ledger_bignum_rate_free(struct ledger_bignum_rate* r);
+
+/*
+ * Configure a rate as an exact ratio of two big numbers.
+ * - r the rate to configure
+ * - numerator numerator of the ratio
+ * - denominator denominator of the ratio; must not be zero
+ * - point_place centesimal places of each product
+ * @return one on success, zero otherwise
+ */
+int ledger_bignum_rate_set
+  ( struct ledger_bignum_rate* r, struct ledger_bignum const* numerator,
+    struct ledger_bignum const* denominator, int point_place);
+
+/*
+ * Multiply a big number by a rate, as `ledger_bignum_multiply_ratio`
+ * would. The rate keeps its working space between calls, and the
+ * destination keeps its storage whenever the product fits.
+ * - r the rate
+ * - dst number to overwrite; may be the same as `src`
+ * - src number to multiply
+ * @return one on success, zero otherwise
+ */
+int ledger_bignum_rate_apply
+  ( struct ledger_bignum_rate* r, struct ledger_bignum* dst,
+    struct ledger_bignum const* src);
+
+/*
+ * Multiply a fixed-point integer by a rate.
+ * - r the rate
+ * - value integer in units of 100^(-point_place), to receive the
+ *     product in units of the rate's centesimal places
+ * - point_place number of centesimal places, to receive the
+ *     rate's centesimal places
+ * @return one on success, zero if the product does not fit in
+ *   eighteen decimal digits (both integers are then left unchanged)
+ */
+int ledger_bignum_rate_apply_fixed
+  (struct ledger_bignum_rate* r, long long int* value, int* point_place);
+
 #ifdef __cplusplus
 };
 #endif /*__cplusplus*/
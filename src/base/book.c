@@ -3,6 +3,9 @@
 #include "util.h"
 #include "ledger.h"
 #include "journal.h"
+#include "account.h"
+#include "table.h"
+#include "find.h"
 #include <limits.h>
 
 /*
@@ -37,6 +40,22 @@ struct ledger_book {
    * brief: array of journals
    */
   struct ledger_journal** journals;
+  /*
+   * brief: lock for the book's own fields
+   */
+  struct ledger_util_lock* lock;
+  /*
+   * brief: string pool shared by the book's tables, or NULL
+   */
+  struct ledger_table_pool* strings;
+  /*
+   * brief: lookup index over the ledgers
+   */
+  struct ledger_find_index* ledger_index;
+  /*
+   * brief: lookup index over the journals
+   */
+  struct ledger_find_index* journal_index;
 };
 
 /*
@@ -58,6 +77,22 @@ static void ledger_book_clear(struct ledger_book* book);
  */
 static void ledger_book_free_cb(void* b);
 
+/*
+ * Resize the ledger array, with the book already locked.
+ * - b book to modify
+ * - n new number of ledgers
+ * @return one on success, zero otherwise
+ */
+static int ledger_book_set_ledger_count_sub(struct ledger_book* b, int n);
+
+/*
+ * Resize the journal array, with the book already locked.
+ * - b book to modify
+ * - n new number of journals
+ * @return one on success, zero otherwise
+ */
+static int ledger_book_set_journal_count_sub(struct ledger_book* b, int n);
+
 
 /* BEGIN static implementation */
 
@@ -74,156 +109,39 @@ int ledger_book_init(struct ledger_book* book){
   book->ledger_count = 0;
   book->journals = NULL;
   book->journal_count = 0;
+  book->strings = NULL;
+  book->ledger_index = NULL;
+  book->journal_index = NULL;
+  book->lock = ledger_util_lock_new();
+  if (book->lock == NULL) return 0;
+  book->ledger_index = ledger_find_index_new();
+  if (book->ledger_index == NULL) return 0;
+  book->journal_index = ledger_find_index_new();
+  if (book->journal_index == NULL) return 0;
   return 1;
 }
 
 void ledger_book_clear(struct ledger_book* book){
-  ledger_book_set_journal_count(book,0);
-  ledger_book_set_ledger_count(book,0);
+  /* NOTE no other references remain, so no lock necessary */
+  ledger_book_set_journal_count_sub(book,0);
+  ledger_book_set_ledger_count_sub(book,0);
   ledger_util_free(book->description);
   book->description = NULL;
   ledger_util_free(book->notes);
   book->notes = NULL;
   book->sequence_id = 0;
+  ledger_table_pool_free(book->strings);
+  book->strings = NULL;
+  ledger_find_index_free(book->journal_index);
+  book->journal_index = NULL;
+  ledger_find_index_free(book->ledger_index);
+  book->ledger_index = NULL;
+  ledger_util_lock_free(book->lock);
+  book->lock = NULL;
   return;
 }
 
-/* END   static implementation */
-
-/* BEGIN implementation */
-
-struct ledger_book* ledger_book_new(void){
-  struct ledger_book* book = (struct ledger_book* )ledger_util_ref_malloc
-    (sizeof(struct ledger_book), ledger_book_free_cb);
-  if (book != NULL){
-    if (!ledger_book_init(book)){
-      ledger_util_ref_free(book);
-      book = NULL;
-    }
-  }
-  return book;
-}
-
-struct ledger_book* ledger_book_acquire(struct ledger_book* b){
-  return (struct ledger_book*)ledger_util_ref_acquire(b);
-}
-
-void ledger_book_free(struct ledger_book* book){
-  if (book != NULL){
-    /* NOTE ledger_book_clear(book); called indirectly */
-    ledger_util_ref_free(book);
-  }
-}
-
-unsigned char const* ledger_book_get_description
-  (struct ledger_book const* book)
-{
-  return book->description;
-}
-
-int ledger_book_set_description
-  (struct ledger_book* book, unsigned char const* desc)
-{
-  int ok;
-  unsigned char* new_desc = ledger_util_ustrdup(desc,&ok);
-  if (ok){
-    ledger_util_free(book->description);
-    book->description = new_desc;
-    return 1;
-  } else return 0;
-}
-
-unsigned char const* ledger_book_get_notes(struct ledger_book const* book){
-  return book->notes;
-}
-
-int ledger_book_set_notes
-  (struct ledger_book* book, unsigned char const* notes)
-{
-  int ok;
-  unsigned char* new_notes = ledger_util_ustrdup(notes,&ok);
-  if (ok){
-    ledger_util_free(book->notes);
-    book->notes = new_notes;
-    return 1;
-  } else return 0;
-}
-
-int ledger_book_is_equal
-  (struct ledger_book const* a, struct ledger_book const* b)
-{
-  /* trivial books */
-  if (a == NULL && b == NULL) return 1;
-  else if (a == NULL || b == NULL) return 0;
-  /* compare top-level features */{
-    if (ledger_util_ustrcmp(a->description, b->description) != 0)
-      return 0;
-    if (ledger_util_ustrcmp(a->notes, b->notes) != 0)
-      return 0;
-  }
-  /* compare ledgers */{
-    int i;
-    if (a->ledger_count != b->ledger_count) return 0;
-    else for (i = 0; i < a->ledger_count; ++i){
-      if (!ledger_ledger_is_equal(a->ledgers[i], b->ledgers[i]))
-        break;
-    }
-    if (i < a->ledger_count) return 0;
-  }
-  /* compare journals */{
-    int i;
-    if (a->journal_count != b->journal_count) return 0;
-    else for (i = 0; i < a->journal_count; ++i){
-      if (!ledger_journal_is_equal(a->journals[i], b->journals[i]))
-        break;
-    }
-    if (i < a->journal_count) return 0;
-  }
-  return 1;
-}
-
-int ledger_book_get_sequence(struct ledger_book const* b){
-  return b->sequence_id;
-}
-
-int ledger_book_set_sequence(struct ledger_book* b, int item_id){
-  if (item_id < 0) return 0;
-  b->sequence_id = item_id;
-  return 1;
-}
-
-int ledger_book_alloc_id(struct ledger_book* b){
-  if (b->sequence_id < INT_MAX){
-    int out;
-    out = b->sequence_id;
-    b->sequence_id += 1;
-    return out;
-  } else return -1;
-}
-
-int ledger_book_get_ledger_count(struct ledger_book const* b){
-  return b->ledger_count;
-}
-
-struct ledger_ledger* ledger_book_get_ledger(struct ledger_book* b, int i){
-  if (i < 0 || i >= b->ledger_count){
-    return NULL;
-  } else {
-    return b->ledgers[i];
-  }
-}
-
-struct ledger_ledger const* ledger_book_get_ledger_c
-  (struct ledger_book const* b, int i)
-{
-  if (i < 0 || i >= b->ledger_count){
-    return NULL;
-  } else {
-    return b->ledgers[i];
-  }
-}
-
-int ledger_book_set_ledger_count(struct ledger_book* b, int n){
+int ledger_book_set_ledger_count_sub(struct ledger_book* b, int n){
   if (n >= INT_MAX/sizeof(struct ledger_ledger*)){
     return 0;
   } else if (n < 0){
@@ -231,7 +149,7 @@ int ledger_book_set_ledger_count(struct ledger_book* b, int n){
   } else if (n == 0){
     int i;
     for (i = 0; i < b->ledger_count; ++i){
-      ledger_ledger_free(b->ledgers[i]);
+      ledger_ledger_drop_share(b->ledgers[i]);
     }
     ledger_util_free(b->ledgers);
     b->ledgers = NULL;
@@ -249,7 +167,7 @@ int ledger_book_set_ledger_count(struct ledger_book* b, int n){
     }
     /* free rest of the ledgers */
     for (; i < b->ledger_count; ++i){
-      ledger_ledger_free(b->ledgers[i]);
+      ledger_ledger_drop_share(b->ledgers[i]);
     }
     ledger_util_free(b->ledgers);
     b->ledgers = new_array;
@@ -271,6 +189,7 @@ int ledger_book_set_ledger_count(struct ledger_book* b, int n){
       new_array[i] = ledger_ledger_new();
       if (new_array[i] == NULL) break;
       ledger_ledger_set_id(new_array[i], next_id);
+      ledger_ledger_set_find_index(new_array[i], b->ledger_index);
     }
     /* rollback and quit */if (i < n){
       int j;
@@ -294,30 +213,7 @@ int ledger_book_set_ledger_count(struct ledger_book* b, int n){
   } else return 1 /*since n == b->ledger_count */;
 }
 
-
-int ledger_book_get_journal_count(struct ledger_book const* b){
-  return b->journal_count;
-}
-
-struct ledger_journal* ledger_book_get_journal(struct ledger_book* b, int i){
-  if (i < 0 || i >= b->journal_count){
-    return NULL;
-  } else {
-    return b->journals[i];
-  }
-}
-
-struct ledger_journal const* ledger_book_get_journal_c
-  (struct ledger_book const* b, int i)
-{
-  if (i < 0 || i >= b->journal_count){
-    return NULL;
-  } else {
-    return b->journals[i];
-  }
-}
-
-int ledger_book_set_journal_count(struct ledger_book* b, int n){
+int ledger_book_set_journal_count_sub(struct ledger_book* b, int n){
   if (n >= INT_MAX/sizeof(struct ledger_journal*)){
     return 0;
   } else if (n < 0){
@@ -325,7 +221,7 @@ int ledger_book_set_journal_count(struct ledger_book* b, int n){
   } else if (n == 0){
     int i;
     for (i = 0; i < b->journal_count; ++i){
-      ledger_journal_free(b->journals[i]);
+      ledger_journal_drop_share(b->journals[i]);
     }
     ledger_util_free(b->journals);
     b->journals = NULL;
@@ -343,7 +239,7 @@ int ledger_book_set_journal_count(struct ledger_book* b, int n){
     }
     /* free rest of the journals */
     for (; i < b->journal_count; ++i){
-      ledger_journal_free(b->journals[i]);
+      ledger_journal_drop_share(b->journals[i]);
     }
     ledger_util_free(b->journals);
     b->journals = new_array;
@@ -365,6 +261,7 @@ int ledger_book_set_journal_count(struct ledger_book* b, int n){
       new_array[i] = ledger_journal_new();
       if (new_array[i] == NULL) break;
       ledger_journal_set_id(new_array[i], next_id);
+      ledger_journal_set_find_index(new_array[i], b->journal_index);
     }
     /* rollback and quit */if (i < n){
       int j;
@@ -388,4 +285,372 @@ int ledger_book_set_journal_count(struct ledger_book* b, int n){
   } else return 1 /*since n == b->journal_count */;
 }
 
+/* END   static implementation */
+
+/* BEGIN implementation */
+
+struct ledger_book* ledger_book_new(void){
+  struct ledger_book* book = (struct ledger_book* )ledger_util_ref_malloc
+    (sizeof(struct ledger_book), ledger_book_free_cb);
+  if (book != NULL){
+    if (!ledger_book_init(book)){
+      ledger_util_ref_free(book);
+      book = NULL;
+    }
+  }
+  return book;
+}
+
+struct ledger_book* ledger_book_acquire(struct ledger_book* b){
+  return (struct ledger_book*)ledger_util_ref_acquire(b);
+}
+
+void ledger_book_read_lock(struct ledger_book const* book){
+  ledger_util_lock_shared(book->lock);
+  return;
+}
+
+void ledger_book_read_unlock(struct ledger_book const* book){
+  ledger_util_unlock_shared(book->lock);
+  return;
+}
+
+void ledger_book_write_lock(struct ledger_book const* book){
+  ledger_util_lock_exclusive(book->lock);
+  return;
+}
+
+void ledger_book_write_unlock(struct ledger_book const* book){
+  ledger_util_unlock_exclusive(book->lock);
+  return;
+}
+
+void ledger_book_free(struct ledger_book* book){
+  if (book != NULL){
+    /* NOTE ledger_book_clear(book); called indirectly */
+    ledger_util_ref_free(book);
+  }
+}
+
+struct ledger_book* ledger_book_snapshot(struct ledger_book const* book){
+  struct ledger_book* out = ledger_book_new();
+  if (out != NULL){
+    int ok = 0;
+    /* writers hold the book for whole transactions */
+    ledger_util_lock_shared(book->lock);
+    do {
+      int i;
+      int dup_ok;
+      out->sequence_id = book->sequence_id;
+      if (book->strings != NULL)
+        out->strings = ledger_table_pool_acquire(book->strings);
+      out->description = ledger_util_ustrdup(book->description, &dup_ok);
+      if (!dup_ok) break;
+      out->notes = ledger_util_ustrdup(book->notes, &dup_ok);
+      if (!dup_ok) break;
+      if (book->ledger_count > 0){
+        out->ledgers = (struct ledger_ledger**)ledger_util_malloc
+          (book->ledger_count*sizeof(struct ledger_ledger*));
+        if (out->ledgers == NULL) break;
+        for (i = 0; i < book->ledger_count; ++i){
+          out->ledgers[i] = ledger_ledger_share(book->ledgers[i]);
+          if (out->ledgers[i] == NULL) break;
+        }
+        /* keep only the ledgers actually shared */
+        out->ledger_count = i;
+        if (i < book->ledger_count) break;
+      }
+      if (book->journal_count > 0){
+        out->journals = (struct ledger_journal**)ledger_util_malloc
+          (book->journal_count*sizeof(struct ledger_journal*));
+        if (out->journals == NULL) break;
+        for (i = 0; i < book->journal_count; ++i){
+          out->journals[i] = ledger_journal_share(book->journals[i]);
+          if (out->journals[i] == NULL) break;
+        }
+        /* keep only the journals actually shared */
+        out->journal_count = i;
+        if (i < book->journal_count) break;
+      }
+      ok = 1;
+    } while (0);
+    ledger_util_unlock_shared(book->lock);
+    if (!ok){
+      ledger_book_free(out);
+      out = NULL;
+    }
+  }
+  return out;
+}
+
+unsigned char const* ledger_book_get_description
+  (struct ledger_book const* book)
+{
+  unsigned char const* desc;
+  ledger_util_lock_shared(book->lock);
+  desc = book->description;
+  ledger_util_unlock_shared(book->lock);
+  return desc;
+}
+
+int ledger_book_set_description
+  (struct ledger_book* book, unsigned char const* desc)
+{
+  int ok;
+  unsigned char* new_desc = ledger_util_ustrdup(desc,&ok);
+  if (ok){
+    ledger_util_lock_exclusive(book->lock);
+    ledger_util_free(book->description);
+    book->description = new_desc;
+    ledger_util_unlock_exclusive(book->lock);
+    return 1;
+  } else return 0;
+}
+
+unsigned char const* ledger_book_get_notes(struct ledger_book const* book){
+  unsigned char const* notes;
+  ledger_util_lock_shared(book->lock);
+  notes = book->notes;
+  ledger_util_unlock_shared(book->lock);
+  return notes;
+}
+
+int ledger_book_set_notes
+  (struct ledger_book* book, unsigned char const* notes)
+{
+  int ok;
+  unsigned char* new_notes = ledger_util_ustrdup(notes,&ok);
+  if (ok){
+    ledger_util_lock_exclusive(book->lock);
+    ledger_util_free(book->notes);
+    book->notes = new_notes;
+    ledger_util_unlock_exclusive(book->lock);
+    return 1;
+  } else return 0;
+}
+
+int ledger_book_is_equal
+  (struct ledger_book const* a, struct ledger_book const* b)
+{
+  int result = 0;
+  /* trivial books */
+  if (a == NULL && b == NULL) return 1;
+  else if (a == NULL || b == NULL) return 0;
+  ledger_util_lock_shared(a->lock);
+  ledger_util_lock_shared(b->lock);
+  do {
+    /* compare top-level features */{
+      if (ledger_util_ustrcmp(a->description, b->description) != 0)
+        break;
+      if (ledger_util_ustrcmp(a->notes, b->notes) != 0)
+        break;
+    }
+    /* compare ledgers */{
+      int i;
+      if (a->ledger_count != b->ledger_count) break;
+      else for (i = 0; i < a->ledger_count; ++i){
+        if (!ledger_ledger_is_equal(a->ledgers[i], b->ledgers[i]))
+          break;
+      }
+      if (i < a->ledger_count) break;
+    }
+    /* compare journals */{
+      int i;
+      if (a->journal_count != b->journal_count) break;
+      else for (i = 0; i < a->journal_count; ++i){
+        if (!ledger_journal_is_equal(a->journals[i], b->journals[i]))
+          break;
+      }
+      if (i < a->journal_count) break;
+    }
+    result = 1;
+  } while (0);
+  ledger_util_unlock_shared(b->lock);
+  ledger_util_unlock_shared(a->lock);
+  return result;
+}
+
+int ledger_book_get_sequence(struct ledger_book const* b){
+  int item_id;
+  ledger_util_lock_shared(b->lock);
+  item_id = b->sequence_id;
+  ledger_util_unlock_shared(b->lock);
+  return item_id;
+}
+
+int ledger_book_set_sequence(struct ledger_book* b, int item_id){
+  if (item_id < 0) return 0;
+  ledger_util_lock_exclusive(b->lock);
+  b->sequence_id = item_id;
+  ledger_util_unlock_exclusive(b->lock);
+  return 1;
+}
+
+int ledger_book_alloc_id(struct ledger_book* b){
+  int out;
+  ledger_util_lock_exclusive(b->lock);
+  if (b->sequence_id < INT_MAX){
+    out = b->sequence_id;
+    b->sequence_id += 1;
+  } else out = -1;
+  ledger_util_unlock_exclusive(b->lock);
+  return out;
+}
+
+int ledger_book_get_ledger_count(struct ledger_book const* b){
+  int n;
+  ledger_util_lock_shared(b->lock);
+  n = b->ledger_count;
+  ledger_util_unlock_shared(b->lock);
+  return n;
+}
+
+struct ledger_ledger* ledger_book_get_ledger(struct ledger_book* b, int i){
+  struct ledger_ledger* l;
+  /* a shared ledger gets replaced by a private copy */
+  ledger_util_lock_exclusive(b->lock);
+  if (i < 0 || i >= b->ledger_count){
+    l = NULL;
+  } else {
+    l = ledger_ledger_own(b->ledgers[i]);
+    if (l != NULL){
+      b->ledgers[i] = l;
+      ledger_ledger_set_find_index(l, b->ledger_index);
+    }
+  }
+  ledger_util_unlock_exclusive(b->lock);
+  return l;
+}
+
+struct ledger_ledger const* ledger_book_get_ledger_c
+  (struct ledger_book const* b, int i)
+{
+  struct ledger_ledger const* l;
+  ledger_util_lock_shared(b->lock);
+  if (i < 0 || i >= b->ledger_count){
+    l = NULL;
+  } else {
+    l = b->ledgers[i];
+  }
+  ledger_util_unlock_shared(b->lock);
+  return l;
+}
+
+int ledger_book_set_ledger_count(struct ledger_book* b, int n){
+  int result;
+  ledger_util_lock_exclusive(b->lock);
+  result = ledger_book_set_ledger_count_sub(b, n);
+  ledger_find_touch(b->ledger_index, 0);
+  ledger_util_unlock_exclusive(b->lock);
+  return result;
+}
+
+struct ledger_find_index* ledger_book_get_ledger_index
+  (struct ledger_book const* b)
+{
+  return b->ledger_index;
+}
+
+
+
+int ledger_book_get_journal_count(struct ledger_book const* b){
+  int n;
+  ledger_util_lock_shared(b->lock);
+  n = b->journal_count;
+  ledger_util_unlock_shared(b->lock);
+  return n;
+}
+
+struct ledger_journal* ledger_book_get_journal(struct ledger_book* b, int i){
+  struct ledger_journal* j;
+  /* a shared journal gets replaced by a private copy */
+  ledger_util_lock_exclusive(b->lock);
+  if (i < 0 || i >= b->journal_count){
+    j = NULL;
+  } else {
+    j = ledger_journal_own(b->journals[i]);
+    if (j != NULL){
+      b->journals[i] = j;
+      ledger_journal_set_find_index(j, b->journal_index);
+    }
+  }
+  ledger_util_unlock_exclusive(b->lock);
+  return j;
+}
+
+struct ledger_journal const* ledger_book_get_journal_c
+  (struct ledger_book const* b, int i)
+{
+  struct ledger_journal const* j;
+  ledger_util_lock_shared(b->lock);
+  if (i < 0 || i >= b->journal_count){
+    j = NULL;
+  } else {
+    j = b->journals[i];
+  }
+  ledger_util_unlock_shared(b->lock);
+  return j;
+}
+
+int ledger_book_set_journal_count(struct ledger_book* b, int n){
+  int result;
+  ledger_util_lock_exclusive(b->lock);
+  result = ledger_book_set_journal_count_sub(b, n);
+  ledger_find_touch(b->journal_index, 0);
+  ledger_util_unlock_exclusive(b->lock);
+  return result;
+}
+
+struct ledger_find_index* ledger_book_get_journal_index
+  (struct ledger_book const* b)
+{
+  return b->journal_index;
+}
+
+int ledger_book_intern_strings(struct ledger_book* b){
+  int ok = 1;
+  int i;
+  ledger_util_lock_exclusive(b->lock);
+  if (b->strings == NULL)
+    b->strings = ledger_table_pool_new();
+  if (b->strings == NULL)
+    ok = 0;
+  for (i = 0; ok && i < b->ledger_count; ++i){
+    struct ledger_ledger* const l = ledger_book_get_ledger(b, i);
+    int j;
+    int const account_count =
+      (l != NULL) ? ledger_ledger_get_account_count(l) : 0;
+    if (l == NULL) ok = 0;
+    for (j = 0; ok && j < account_count; ++j){
+      struct ledger_account* const a = ledger_ledger_get_account(l, j);
+      struct ledger_table* const t =
+        (a != NULL) ? ledger_account_get_table(a) : NULL;
+      if (t == NULL) ok = 0;
+      else if (ledger_table_get_pool(t) != b->strings)
+        ledger_table_set_pool(t, b->strings);
+    }
+  }
+  for (i = 0; ok && i < b->journal_count; ++i){
+    struct ledger_journal* const j = ledger_book_get_journal(b, i);
+    struct ledger_table* const t =
+      (j != NULL) ? ledger_journal_get_table(j) : NULL;
+    if (t == NULL) ok = 0;
+    else if (ledger_table_get_pool(t) != b->strings)
+      ledger_table_set_pool(t, b->strings);
+  }
+  ledger_util_unlock_exclusive(b->lock);
+  return ok;
+}
+
+struct ledger_table_pool* ledger_book_get_string_pool
+  (struct ledger_book const* b)
+{
+  struct ledger_table_pool* p;
+  ledger_util_lock_shared(b->lock);
+  p = b->strings;
+  ledger_util_unlock_shared(b->lock);
+  return p;
+}
+
+
 /* END   implementation */
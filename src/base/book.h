@@ -12,6 +12,8 @@ extern "C" {
 
 struct ledger_ledger;
 struct ledger_journal;
+struct ledger_table_pool;
+struct ledger_find_index;
 
 /*
  * brief: Account and transaction book
@@ -38,6 +40,52 @@ struct ledger_book* ledger_book_acquire(struct ledger_book* a);
  */
 void ledger_book_free(struct ledger_book* book);
 
+/*
+ * Take a point-in-time snapshot of a book, such as for a report or
+ * a backup. The snapshot shares its ledgers, journals and tables with
+ * the book; whichever side changes a shared part first gets a private
+ * copy of that part, so neither book sees the other's later changes.
+ * Read the snapshot through the constant accessors to avoid copies.
+ * Pointers fetched from the book before the snapshot must be fetched
+ * again before they are used to change the book.
+ * - book the book to snapshot
+ * @return the snapshot on success, otherwise NULL
+ */
+struct ledger_book* ledger_book_snapshot(struct ledger_book const* book);
+
+/*
+ * Hold a book for reading. Book functions lock the book on their own;
+ * hold this lock to keep several calls consistent while other threads
+ * might modify the book, and to keep strings, ledgers and journals
+ * returned by the book alive while in use. Committing a transaction
+ * holds the book for writing. Locks nest within a thread, and a thread
+ * holding the read lock must not modify the book. That includes
+ * ledger_book_get_ledger and ledger_book_get_journal, which may swap
+ * in a private copy and need the book exclusive: upgrading a read
+ * lock to a write lock is forbidden.
+ * - book the book to lock
+ */
+void ledger_book_read_lock(struct ledger_book const* book);
+
+/*
+ * Release a book held for reading.
+ * - book the book to unlock
+ */
+void ledger_book_read_unlock(struct ledger_book const* book);
+
+/*
+ * Hold a book for writing, keeping other threads out of the book
+ * over several modifications. Locks nest within a thread.
+ * - book the book to lock
+ */
+void ledger_book_write_lock(struct ledger_book const* book);
+
+/*
+ * Release a book held for writing.
+ * - book the book to unlock
+ */
+void ledger_book_write_unlock(struct ledger_book const* book);
+
 /*
  * Query the description of a book.
  * - book book to query
@@ -119,10 +167,11 @@ int ledger_book_get_ledger_count(struct ledger_book const* b);
 int ledger_book_set_ledger_count(struct ledger_book* b, int n);
 
 /*
- * Get a ledger.
+ * Get a ledger for modification. A ledger shared with a
+ * snapshot is copied first.
  * - b book to adjust
  * - i array index
- * @return the ledger at that array index
+ * @return the ledger at that array index, or NULL if the copy failed
  */
 struct ledger_ledger* ledger_book_get_ledger(struct ledger_book* b, int i);
 
@@ -135,6 +184,15 @@ struct ledger_ledger* ledger_book_get_ledger(struct ledger_book* b, int i);
 struct ledger_ledger const* ledger_book_get_ledger_c
   (struct ledger_book const* b, int i);
 
+/*
+ * Get the lookup index over a book's ledgers, for use by the
+ * find functions.
+ * - b book to query
+ * @return the lookup index
+ */
+struct ledger_find_index* ledger_book_get_ledger_index
+  (struct ledger_book const* b);
+
 
 
 /*
@@ -153,10 +211,11 @@ int ledger_book_get_journal_count(struct ledger_book const* b);
 int ledger_book_set_journal_count(struct ledger_book* b, int n);
 
 /*
- * Get a journal.
+ * Get a journal for modification. A journal shared with a
+ * snapshot is copied first.
  * - b book to adjust
  * - i array index
- * @return the journal at that array index
+ * @return the journal at that array index, or NULL if the copy failed
  */
 struct ledger_journal* ledger_book_get_journal(struct ledger_book* b, int i);
 
@@ -169,6 +228,34 @@ struct ledger_journal* ledger_book_get_journal(struct ledger_book* b, int i);
 struct ledger_journal const* ledger_book_get_journal_c
   (struct ledger_book const* b, int i);
 
+/*
+ * Get the lookup index over a book's journals, for use by the
+ * find functions.
+ * - b book to query
+ * @return the lookup index
+ */
+struct ledger_find_index* ledger_book_get_journal_index
+  (struct ledger_book const* b);
+
+/*
+ * Share long strings, such as repeated check numbers, between the
+ * tables of a book through one string pool. Each distinct string is
+ * then stored once. Tables already in the book join the pool now;
+ * call again after adding ledgers, accounts or journals to bring
+ * their tables in as well.
+ * - b book to modify
+ * @return one on success, zero otherwise
+ */
+int ledger_book_intern_strings(struct ledger_book* b);
+
+/*
+ * Get the string pool of a book.
+ * - b book to query
+ * @return the pool, or NULL if the book does not pool its strings
+ */
+struct ledger_table_pool* ledger_book_get_string_pool
+  (struct ledger_book const* b);
+
 #ifdef __cplusplus
 };
 #endif /*__cplusplus*/
@@ -1,6 +1,7 @@
 
 #include "entry.h"
 #include "util.h"
+#include "find.h"
 
 /*
  * Actualization of the entry structure
@@ -10,6 +11,10 @@ struct ledger_entry {
   unsigned char *description;
   unsigned char *date;
   int item_id;
+  /* number of extra owners sharing the entry */
+  int shares;
+  /* lookup index of the journal holding the entry */
+  struct ledger_find_index* find_index;
 };
 
 /*
@@ -31,6 +36,13 @@ static void ledger_entry_clear(struct ledger_entry* a);
  */
 static void ledger_entry_free_cb(void* t);
 
+/*
+ * Copy an entry.
+ * - a entry to copy
+ * @return the copy on success, NULL otherwise
+ */
+static struct ledger_entry* ledger_entry_fork(struct ledger_entry const* a);
+
 /* BEGIN static implementation */
 
 void ledger_entry_free_cb(void* t){
@@ -44,6 +56,8 @@ int ledger_entry_init(struct ledger_entry* a){
   a->name = NULL;
   a->item_id = -1;
   a->date = NULL;
+  a->shares = 0;
+  a->find_index = NULL;
   return 1;
 }
 
@@ -55,9 +69,34 @@ void ledger_entry_clear(struct ledger_entry* a){
   ledger_util_free(a->date);
   a->date = NULL;
   a->item_id = -1;
+  ledger_find_index_free(a->find_index);
+  a->find_index = NULL;
   return;
 }
 
+struct ledger_entry* ledger_entry_fork(struct ledger_entry const* a){
+  struct ledger_entry* b = ledger_entry_new();
+  if (b != NULL){
+    int ok = 0;
+    do {
+      int dup_ok;
+      b->item_id = a->item_id;
+      b->name = ledger_util_ustrdup(a->name, &dup_ok);
+      if (!dup_ok) break;
+      b->description = ledger_util_ustrdup(a->description, &dup_ok);
+      if (!dup_ok) break;
+      b->date = ledger_util_ustrdup(a->date, &dup_ok);
+      if (!dup_ok) break;
+      ok = 1;
+    } while (0);
+    if (!ok){
+      ledger_entry_free(b);
+      b = NULL;
+    }
+  }
+  return b;
+}
+
 /* END   static implementation */
 
 /* BEGIN implementation */
@@ -85,6 +124,29 @@ void ledger_entry_free(struct ledger_entry* a){
   }
 }
 
+struct ledger_entry* ledger_entry_share(struct ledger_entry* a){
+  if (ledger_entry_acquire(a) == NULL) return NULL;
+  ledger_util_share_add(&a->shares, +1);
+  return a;
+}
+
+void ledger_entry_drop_share(struct ledger_entry* a){
+  if (a != NULL){
+    ledger_util_share_add(&a->shares, -1);
+    ledger_entry_free(a);
+  }
+  return;
+}
+
+struct ledger_entry* ledger_entry_own(struct ledger_entry* a){
+  struct ledger_entry* copy;
+  if (ledger_util_share_add(&a->shares, 0) == 0) return a;
+  copy = ledger_entry_fork(a);
+  if (copy == NULL) return NULL;
+  ledger_entry_drop_share(a);
+  return copy;
+}
+
 unsigned char const* ledger_entry_get_description
   (struct ledger_entry const* a)
 {
@@ -117,6 +179,8 @@ int ledger_entry_set_name
   if (ok){
     ledger_util_free(a->name);
     a->name = new_desc;
+    ledger_find_touch
+      (a->find_index, ledger_util_share_add(&a->shares, 0) > 0);
     return 1;
   } else return 0;
 }
@@ -149,6 +213,18 @@ void ledger_entry_set_id(struct ledger_entry* a, int item_id){
   } else {
     a->item_id = item_id;
   }
+  ledger_find_touch
+    (a->find_index, ledger_util_share_add(&a->shares, 0) > 0);
+  return;
+}
+
+void ledger_entry_set_find_index
+  (struct ledger_entry* a, struct ledger_find_index* x)
+{
+  if (a->find_index != x){
+    ledger_find_index_free(a->find_index);
+    a->find_index = ledger_find_index_acquire(x);
+  }
   return;
 }
 
@@ -10,6 +10,8 @@
 extern "C" {
 #endif /*__cplusplus*/
 
+struct ledger_find_index;
+
 /*
  * brief: Journal entry descriptor
  */
@@ -34,6 +36,30 @@ struct ledger_entry* ledger_entry_acquire(struct ledger_entry* a);
  */
 void ledger_entry_free(struct ledger_entry* a);
 
+/*
+ * Acquire an entry for another owner, such as a journal copy.
+ * An owner must call `ledger_entry_own` before changing an entry.
+ * - a the entry to share
+ * @return the entry on success, otherwise NULL
+ */
+struct ledger_entry* ledger_entry_share(struct ledger_entry* a);
+
+/*
+ * Release an entry held by one of its owners.
+ * - a the entry to release
+ */
+void ledger_entry_drop_share(struct ledger_entry* a);
+
+/*
+ * Prepare an entry for changes by one of its owners. An entry that
+ * other owners still share is copied, and the copy replaces the
+ * owner's hold on the original.
+ * - a the entry held by the owner
+ * @return the entry itself if unshared, a private copy otherwise,
+ *   or NULL if the copy failed (the owner keeps the original)
+ */
+struct ledger_entry* ledger_entry_own(struct ledger_entry* a);
+
 /*
  * Query the description of an entry.
  * - a entry to query
@@ -100,6 +126,15 @@ int ledger_entry_get_id(struct ledger_entry const* a);
  */
 void ledger_entry_set_id(struct ledger_entry* a, int item_id);
 
+/*
+ * Attach an entry to the lookup index of the journal holding it, so that
+ * changes to its name or identifier mark that index stale.
+ * - a entry to modify
+ * - x the lookup index, or NULL to detach
+ */
+void ledger_entry_set_find_index
+  (struct ledger_entry* a, struct ledger_find_index* x);
+
 /*
  * Compare two entries for equality.
  * - a an entry
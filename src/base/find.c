@@ -6,135 +6,585 @@
 #include "journal.h"
 #include "account.h"
 #include "entry.h"
+#include <limits.h>
+
+#ifndef LEDGER_FIND_INDEX_MIN
+/*
+ * smallest item array worth a lookup index; shorter arrays get
+ *   searched linearly
+ */
+#  define LEDGER_FIND_INDEX_MIN 16
+#endif /*LEDGER_FIND_INDEX_MIN*/
+
+/*
+ * kinds of item arrays
+ */
+enum ledger_find_kind {
+  LEDGER_FIND_LEDGER = 0,
+  LEDGER_FIND_JOURNAL = 1,
+  LEDGER_FIND_ACCOUNT = 2,
+  LEDGER_FIND_ENTRY = 3
+};
+
+/*
+ * states of a lookup index
+ */
+enum ledger_find_state {
+  /* nothing known */
+  LEDGER_FIND_EMPTY = 0,
+  /* stamp and count seen once, tables not yet built */
+  LEDGER_FIND_SEEN = 1,
+  /* tables describe the items as of the stamp and count */
+  LEDGER_FIND_BUILT = 2
+};
+
+/*
+ * Slot of a lookup table.
+ */
+struct ledger_find_slot {
+  /* identifier, or hash of the name */
+  unsigned int key;
+  /* array index, or -1 for an empty slot */
+  int index;
+};
+
+/*
+ * Actualization of the lookup index
+ */
+struct ledger_find_index {
+  /*
+   * brief: lock for the index; lookups hold their container shared,
+   *   so the index needs a lock of its own, held shared to probe
+   *   and exclusive to build
+   */
+  struct ledger_util_lock* lock;
+  /*
+   * brief: index state
+   */
+  int state;
+  /*
+   * brief: change stamp of the item array
+   */
+  unsigned int changes;
+  /*
+   * brief: change stamp of the item array when last seen or built
+   */
+  unsigned int stamp;
+  /*
+   * brief: stamp for shared items when last seen or built
+   */
+  unsigned int shared_stamp;
+  /*
+   * brief: item count when last seen or built
+   */
+  int count;
+  /*
+   * brief: number of slots in each table, a power of two
+   */
+  int capacity;
+  /*
+   * brief: identifier table, followed by the name table
+   */
+  struct ledger_find_slot* slots;
+};
+
+/*
+ * change stamp for items shared between item arrays
+ */
+static unsigned int ledger_find_stamp = 0;
+
+/*
+ * Callback for releasing a lookup index.
+ * - x the index to clear
+ */
+static void ledger_find_index_free_cb(void* x);
+
+/*
+ * Hash a name.
+ * - name the name to hash
+ * @return the hash
+ */
+static unsigned int ledger_find_hash(unsigned char const* name);
+
+/*
+ * Get the lookup index of an item array.
+ * - c the book, ledger or journal holding the array
+ * - kind kind of item array
+ * @return the index, or NULL if the container has none
+ */
+static struct ledger_find_index* ledger_find_get_index
+  (void const* c, int kind);
+
+/*
+ * Hold an item array for reading.
+ * - c the book, ledger or journal holding the array
+ * - kind kind of item array
+ */
+static void ledger_find_lock(void const* c, int kind);
+
+/*
+ * Release an item array held for reading.
+ * - c the book, ledger or journal holding the array
+ * - kind kind of item array
+ */
+static void ledger_find_unlock(void const* c, int kind);
+
+/*
+ * Get the length of an item array.
+ * - c the book, ledger or journal holding the array
+ * - kind kind of item array
+ * @return the number of items
+ */
+static int ledger_find_count(void const* c, int kind);
+
+/*
+ * Read the identifier and name of an item.
+ * - c the book, ledger or journal holding the array
+ * - kind kind of item array
+ * - i array index
+ * - item_id to receive the identifier
+ * - name to receive the name
+ * @return one on success, zero if there is no such item
+ */
+static int ledger_find_key
+  ( void const* c, int kind, int i,
+    int* item_id, unsigned char const** name);
+
+/*
+ * Search an item array from the start.
+ * - c the book, ledger or journal holding the array
+ * - kind kind of item array
+ * - item_id identifier to find, used when `name` is NULL
+ * - name name to find, or NULL
+ * @return the index of the first match, or -1 if not found
+ */
+static int ledger_find_scan
+  (void const* c, int kind, int item_id, unsigned char const* name);
+
+/*
+ * Fill the tables of a lookup index from an item array. Only the
+ * first of several items with the same key goes in the tables.
+ * - x the index to fill, already locked
+ * - c the book, ledger or journal holding the array
+ * - kind kind of item array
+ * - count number of items
+ * @return one on success, zero otherwise
+ */
+static int ledger_find_build
+  (struct ledger_find_index* x, void const* c, int kind, int count);
+
+/*
+ * Search the tables of a lookup index.
+ * - x the index to search, already locked
+ * - c the book, ledger or journal holding the array
+ * - kind kind of item array
+ * - item_id identifier to find, used when `name` is NULL
+ * - name name to find, or NULL
+ * @return the index of the first match, or -1 if not found
+ */
+static int ledger_find_probe
+  ( struct ledger_find_index* x, void const* c, int kind,
+    int item_id, unsigned char const* name);
+
+/*
+ * Search an item array, through its lookup index when that helps.
+ * - c the book, ledger or journal holding the array
+ * - kind kind of item array
+ * - item_id identifier to find, used when `name` is NULL
+ * - name name to find, or NULL
+ * @return the index of the first match, or -1 if not found
+ */
+static int ledger_find_lookup
+  (void const* c, int kind, int item_id, unsigned char const* name);
 
 
 /* BEGIN static implementation */
 
+void ledger_find_index_free_cb(void* x){
+  struct ledger_find_index* const index = (struct ledger_find_index*)x;
+  ledger_util_free(index->slots);
+  index->slots = NULL;
+  ledger_util_lock_free(index->lock);
+  index->lock = NULL;
+  return;
+}
 
-/* END   static implementation */
+unsigned int ledger_find_hash(unsigned char const* name){
+  /* FNV-1a */
+  unsigned int h = 2166136261u;
+  for (; *name != 0; ++name){
+    h ^= *name;
+    h = (h*16777619u)&0xFFFFFFFFu;
+  }
+  return h;
+}
 
-/* BEGIN implementation */
+struct ledger_find_index* ledger_find_get_index(void const* c, int kind){
+  switch (kind){
+  case LEDGER_FIND_LEDGER:
+    return ledger_book_get_ledger_index((struct ledger_book const*)c);
+  case LEDGER_FIND_JOURNAL:
+    return ledger_book_get_journal_index((struct ledger_book const*)c);
+  case LEDGER_FIND_ACCOUNT:
+    return ledger_ledger_get_account_index((struct ledger_ledger const*)c);
+  case LEDGER_FIND_ENTRY:
+    return ledger_journal_get_entry_index((struct ledger_journal const*)c);
+  default:
+    return NULL;
+  }
+}
 
-int ledger_find_ledger_by_name
-  (struct ledger_book const* b, unsigned char const* name)
+void ledger_find_lock(void const* c, int kind){
+  switch (kind){
+  case LEDGER_FIND_LEDGER:
+  case LEDGER_FIND_JOURNAL:
+    ledger_book_read_lock((struct ledger_book const*)c);
+    break;
+  case LEDGER_FIND_ACCOUNT:
+    ledger_ledger_read_lock((struct ledger_ledger const*)c);
+    break;
+  case LEDGER_FIND_ENTRY:
+    ledger_journal_read_lock((struct ledger_journal const*)c);
+    break;
+  }
+  return;
+}
+
+void ledger_find_unlock(void const* c, int kind){
+  switch (kind){
+  case LEDGER_FIND_LEDGER:
+  case LEDGER_FIND_JOURNAL:
+    ledger_book_read_unlock((struct ledger_book const*)c);
+    break;
+  case LEDGER_FIND_ACCOUNT:
+    ledger_ledger_read_unlock((struct ledger_ledger const*)c);
+    break;
+  case LEDGER_FIND_ENTRY:
+    ledger_journal_read_unlock((struct ledger_journal const*)c);
+    break;
+  }
+  return;
+}
+
+int ledger_find_count(void const* c, int kind){
+  switch (kind){
+  case LEDGER_FIND_LEDGER:
+    return ledger_book_get_ledger_count((struct ledger_book const*)c);
+  case LEDGER_FIND_JOURNAL:
+    return ledger_book_get_journal_count((struct ledger_book const*)c);
+  case LEDGER_FIND_ACCOUNT:
+    return ledger_ledger_get_account_count((struct ledger_ledger const*)c);
+  case LEDGER_FIND_ENTRY:
+    return ledger_journal_get_entry_count((struct ledger_journal const*)c);
+  default:
+    return 0;
+  }
+}
+
+int ledger_find_key
+  ( void const* c, int kind, int i,
+    int* item_id, unsigned char const** name)
+{
+  switch (kind){
+  case LEDGER_FIND_LEDGER:
+    {
+      struct ledger_ledger const* const ledger =
+        ledger_book_get_ledger_c((struct ledger_book const*)c, i);
+      if (ledger == NULL) return 0;
+      *item_id = ledger_ledger_get_id(ledger);
+      *name = ledger_ledger_get_name(ledger);
+    }break;
+  case LEDGER_FIND_JOURNAL:
+    {
+      struct ledger_journal const* const journal =
+        ledger_book_get_journal_c((struct ledger_book const*)c, i);
+      if (journal == NULL) return 0;
+      *item_id = ledger_journal_get_id(journal);
+      *name = ledger_journal_get_name(journal);
+    }break;
+  case LEDGER_FIND_ACCOUNT:
+    {
+      struct ledger_account const* const account =
+        ledger_ledger_get_account_c((struct ledger_ledger const*)c, i);
+      if (account == NULL) return 0;
+      *item_id = ledger_account_get_id(account);
+      *name = ledger_account_get_name(account);
+    }break;
+  case LEDGER_FIND_ENTRY:
+    {
+      struct ledger_entry const* const entry =
+        ledger_journal_get_entry_c((struct ledger_journal const*)c, i);
+      if (entry == NULL) return 0;
+      *item_id = ledger_entry_get_id(entry);
+      *name = ledger_entry_get_name(entry);
+    }break;
+  default:
+    return 0;
+  }
+  return 1;
+}
+
+int ledger_find_scan
+  (void const* c, int kind, int item_id, unsigned char const* name)
 {
   /* linear search */
   int i;
-  int const ledger_count = ledger_book_get_ledger_count(b);
-  if (name == NULL) return -1;
-  else for (i = 0; i < ledger_count; ++i){
-    struct ledger_ledger const* ledger = ledger_book_get_ledger_c(b, i);
-    if (ledger_util_ustrcmp(ledger_ledger_get_name(ledger), name) == 0){
+  int const count = ledger_find_count(c, kind);
+  for (i = 0; i < count; ++i){
+    int next_id;
+    unsigned char const* next_name;
+    if (!ledger_find_key(c, kind, i, &next_id, &next_name))
+      continue;
+    if (name != NULL){
+      if (ledger_util_ustrcmp(next_name, name) == 0)
+        return i;
+    } else if (next_id == item_id){
       return i;
     }
   }
   return -1;
 }
 
-int ledger_find_ledger_by_id(struct ledger_book const* b, int item_id){
-  /* linear search */
+int ledger_find_build
+  (struct ledger_find_index* x, void const* c, int kind, int count)
+{
+  int capacity = LEDGER_FIND_INDEX_MIN;
   int i;
-  int const ledger_count = ledger_book_get_ledger_count(b);
-  if (item_id < 0) return -1;
-  else for (i = 0; i < ledger_count; ++i){
-    struct ledger_ledger const* ledger = ledger_book_get_ledger_c(b, i);
-    if (ledger_ledger_get_id(ledger) == item_id){
-      return i;
+  /* keep the tables at most half full */
+  while (capacity/2 < count){
+    if (capacity > INT_MAX/(4*(int)sizeof(struct ledger_find_slot)))
+      return 0;
+    capacity *= 2;
+  }
+  if (capacity != x->capacity){
+    struct ledger_find_slot* const new_slots =
+      (struct ledger_find_slot*)ledger_util_malloc
+        (2*capacity*sizeof(struct ledger_find_slot));
+    if (new_slots == NULL) return 0;
+    ledger_util_free(x->slots);
+    x->slots = new_slots;
+    x->capacity = capacity;
+  }
+  for (i = 0; i < 2*capacity; ++i){
+    x->slots[i].index = -1;
+  }
+  for (i = 0; i < count; ++i){
+    int item_id;
+    unsigned char const* name;
+    unsigned int const mask = (unsigned int)capacity-1u;
+    unsigned int j;
+    if (!ledger_find_key(c, kind, i, &item_id, &name))
+      continue;
+    if (item_id >= 0){
+      struct ledger_find_slot* const ids = x->slots;
+      for (j = (unsigned int)item_id&mask; ids[j].index >= 0;
+          j = (j+1u)&mask)
+      {
+        if (ids[j].key == (unsigned int)item_id) break;
+      }
+      if (ids[j].index < 0){
+        ids[j].key = (unsigned int)item_id;
+        ids[j].index = i;
+      }
+    }
+    if (name != NULL){
+      struct ledger_find_slot* const names = x->slots+capacity;
+      unsigned int const h = ledger_find_hash(name);
+      for (j = h&mask; names[j].index >= 0; j = (j+1u)&mask){
+        int other_id;
+        unsigned char const* other_name;
+        if (names[j].key == h
+        &&  ledger_find_key(c, kind, names[j].index, &other_id, &other_name)
+        &&  ledger_util_ustrcmp(other_name, name) == 0)
+          break;
+      }
+      if (names[j].index < 0){
+        names[j].key = h;
+        names[j].index = i;
+      }
+    }
+  }
+  return 1;
+}
+
+int ledger_find_probe
+  ( struct ledger_find_index* x, void const* c, int kind,
+    int item_id, unsigned char const* name)
+{
+  unsigned int const mask = (unsigned int)x->capacity-1u;
+  unsigned int const h = (name != NULL)
+    ? ledger_find_hash(name) : (unsigned int)item_id;
+  struct ledger_find_slot const* const table = (name != NULL)
+    ? x->slots+x->capacity : x->slots;
+  unsigned int j;
+  for (j = h&mask; table[j].index >= 0; j = (j+1u)&mask){
+    int next_id;
+    unsigned char const* next_name;
+    if (table[j].key != h)
+      continue;
+    /* check against the item itself */
+    if (!ledger_find_key(c, kind, table[j].index, &next_id, &next_name))
+      continue;
+    if (name != NULL){
+      if (ledger_util_ustrcmp(next_name, name) == 0)
+        return table[j].index;
+    } else if (next_id == item_id){
+      return table[j].index;
     }
   }
   return -1;
 }
 
+int ledger_find_lookup
+  (void const* c, int kind, int item_id, unsigned char const* name)
+{
+  int out;
+  struct ledger_find_index* const x = ledger_find_get_index(c, kind);
+  ledger_find_lock(c, kind);
+  do {
+    int const count = ledger_find_count(c, kind);
+    unsigned int stamp, shared_stamp;
+    if (x == NULL || count < LEDGER_FIND_INDEX_MIN){
+      out = ledger_find_scan(c, kind, item_id, name);
+      break;
+    }
+    /* read the stamps before any item, to err on the side of staleness */
+    stamp = ledger_util_stamp_add(&x->changes, 0);
+    shared_stamp = ledger_util_stamp_add(&ledger_find_stamp, 0);
+    /* probe a current index alongside other lookups */
+    ledger_util_lock_shared(x->lock);
+    if (x->state == LEDGER_FIND_BUILT && x->stamp == stamp
+    &&  x->shared_stamp == shared_stamp && x->count == count)
+    {
+      out = ledger_find_probe(x, c, kind, item_id, name);
+      ledger_util_unlock_shared(x->lock);
+      break;
+    }
+    ledger_util_unlock_shared(x->lock);
+    /* changing the index needs it exclusive; the lock does not upgrade,
+     * so check the state again once held */
+    ledger_util_lock_exclusive(x->lock);
+    if (x->state == LEDGER_FIND_EMPTY || x->stamp != stamp
+    ||  x->shared_stamp != shared_stamp || x->count != count)
+    {
+      /* build on the second lookup without changes in between,
+       * so that alternating edits and lookups cost no more than
+       * linear searches */
+      x->state = LEDGER_FIND_SEEN;
+      x->stamp = stamp;
+      x->shared_stamp = shared_stamp;
+      x->count = count;
+    } else if (x->state == LEDGER_FIND_SEEN){
+      x->state = ledger_find_build(x, c, kind, count)
+        ? LEDGER_FIND_BUILT : LEDGER_FIND_EMPTY;
+    }
+    if (x->state == LEDGER_FIND_BUILT){
+      out = ledger_find_probe(x, c, kind, item_id, name);
+    } else {
+      out = ledger_find_scan(c, kind, item_id, name);
+    }
+    ledger_util_unlock_exclusive(x->lock);
+  } while (0);
+  ledger_find_unlock(c, kind);
+  return out;
+}
+
+/* END   static implementation */
+
+/* BEGIN implementation */
+
+struct ledger_find_index* ledger_find_index_new(void){
+  struct ledger_find_index* x = (struct ledger_find_index*)
+    ledger_util_ref_malloc
+      (sizeof(struct ledger_find_index), ledger_find_index_free_cb);
+  if (x != NULL){
+    x->state = LEDGER_FIND_EMPTY;
+    x->changes = 0;
+    x->stamp = 0;
+    x->shared_stamp = 0;
+    x->count = 0;
+    x->capacity = 0;
+    x->slots = NULL;
+    x->lock = ledger_util_lock_new();
+    if (x->lock == NULL){
+      ledger_util_ref_free(x);
+      x = NULL;
+    }
+  }
+  return x;
+}
+
+struct ledger_find_index* ledger_find_index_acquire
+  (struct ledger_find_index* x)
+{
+  if (x == NULL) return NULL;
+  else return (struct ledger_find_index*)ledger_util_ref_acquire(x);
+}
+
+void ledger_find_index_free(struct ledger_find_index* x){
+  if (x != NULL){
+    /* NOTE ledger_find_index_free_cb(x); called indirectly */
+    ledger_util_ref_free(x);
+  }
+  return;
+}
+
+void ledger_find_touch(struct ledger_find_index* x, int shared_tf){
+  if (x != NULL)
+    ledger_util_stamp_add(&x->changes, 1);
+  if (shared_tf)
+    ledger_util_stamp_add(&ledger_find_stamp, 1);
+  return;
+}
+
+int ledger_find_ledger_by_name
+  (struct ledger_book const* b, unsigned char const* name)
+{
+  if (name == NULL) return -1;
+  else return ledger_find_lookup(b, LEDGER_FIND_LEDGER, -1, name);
+}
+
+int ledger_find_ledger_by_id(struct ledger_book const* b, int item_id){
+  if (item_id < 0) return -1;
+  else return ledger_find_lookup(b, LEDGER_FIND_LEDGER, item_id, NULL);
+}
+
 int ledger_find_journal_by_name
   (struct ledger_book const* b, unsigned char const* name)
 {
-  /* linear search */
-  int i;
-  int const journal_count = ledger_book_get_journal_count(b);
   if (name == NULL) return -1;
-  else for (i = 0; i < journal_count; ++i){
-    struct ledger_journal const* journal = ledger_book_get_journal_c(b, i);
-    if (ledger_util_ustrcmp(ledger_journal_get_name(journal), name) == 0){
-      return i;
-    }
-  }
-  return -1;
+  else return ledger_find_lookup(b, LEDGER_FIND_JOURNAL, -1, name);
 }
 
 int ledger_find_journal_by_id(struct ledger_book const* b, int item_id){
-  /* linear search */
-  int i;
-  int const journal_count = ledger_book_get_journal_count(b);
   if (item_id < 0) return -1;
-  else for (i = 0; i < journal_count; ++i){
-    struct ledger_journal const* journal = ledger_book_get_journal_c(b, i);
-    if (ledger_journal_get_id(journal) == item_id){
-      return i;
-    }
-  }
-  return -1;
+  else return ledger_find_lookup(b, LEDGER_FIND_JOURNAL, item_id, NULL);
 }
 
 
 int ledger_find_account_by_name
   (struct ledger_ledger const* b, unsigned char const* name)
 {
-  /* linear search */
-  int i;
-  int const account_count = ledger_ledger_get_account_count(b);
   if (name == NULL) return -1;
-  else for (i = 0; i < account_count; ++i){
-    struct ledger_account const* account = ledger_ledger_get_account_c(b, i);
-    if (ledger_util_ustrcmp(ledger_account_get_name(account), name) == 0){
-      return i;
-    }
-  }
-  return -1;
+  else return ledger_find_lookup(b, LEDGER_FIND_ACCOUNT, -1, name);
 }
 
 int ledger_find_account_by_id(struct ledger_ledger const* b, int item_id){
-  /* linear search */
-  int i;
-  int const account_count = ledger_ledger_get_account_count(b);
   if (item_id < 0) return -1;
-  else for (i = 0; i < account_count; ++i){
-    struct ledger_account const* account = ledger_ledger_get_account_c(b, i);
-    if (ledger_account_get_id(account) == item_id){
-      return i;
-    }
-  }
-  return -1;
+  else return ledger_find_lookup(b, LEDGER_FIND_ACCOUNT, item_id, NULL);
 }
 
 
 int ledger_find_entry_by_name
   (struct ledger_journal const* b, unsigned char const* name)
 {
-  /* linear search */
-  int i;
-  int const entry_count = ledger_journal_get_entry_count(b);
   if (name == NULL) return -1;
-  else for (i = 0; i < entry_count; ++i){
-    struct ledger_entry const* entry = ledger_journal_get_entry_c(b, i);
-    if (ledger_util_ustrcmp(ledger_entry_get_name(entry), name) == 0){
-      return i;
-    }
-  }
-  return -1;
+  else return ledger_find_lookup(b, LEDGER_FIND_ENTRY, -1, name);
 }
 
 int ledger_find_entry_by_id(struct ledger_journal const* b, int item_id){
-  /* linear search */
-  int i;
-  int const entry_count = ledger_journal_get_entry_count(b);
   if (item_id < 0) return -1;
-  else for (i = 0; i < entry_count; ++i){
-    struct ledger_entry const* entry = ledger_journal_get_entry_c(b, i);
-    if (ledger_entry_get_id(entry) == item_id){
-      return i;
-    }
-  }
-  return -1;
+  else return ledger_find_lookup(b, LEDGER_FIND_ENTRY, item_id, NULL);
 }
 
 /* END   implementation */
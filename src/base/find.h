@@ -14,6 +14,46 @@ struct ledger_ledger;
 struct ledger_journal;
 struct ledger_book;
 
+/*
+ * brief: Lookup index from identifiers and names to array indices.
+ *   Books, ledgers and journals each keep one per item array; the
+ *   find functions below build it on demand and rebuild it after
+ *   an item in the array gets renamed or the array gets resized.
+ *   Items keep a reference to the index of the array holding them.
+ */
+struct ledger_find_index;
+
+/*
+ * Construct a new lookup index.
+ * @return the index on success, otherwise NULL
+ */
+struct ledger_find_index* ledger_find_index_new(void);
+
+/*
+ * Acquire a reference to a lookup index.
+ * - x the index to acquire, or NULL
+ * @return the index, or NULL
+ */
+struct ledger_find_index* ledger_find_index_acquire
+  (struct ledger_find_index* x);
+
+/*
+ * Release a reference to a lookup index.
+ * - x the index to release, or NULL
+ */
+void ledger_find_index_free(struct ledger_find_index* x);
+
+/*
+ * Note a change to the name or identifier of a ledger, journal,
+ * account or entry, or to the size of an array of them. The lookup
+ * index of the array gets rebuilt when next needed.
+ * - x index of the array holding the item, or NULL
+ * - shared_tf nonzero for an item that other arrays may share since
+ *   a snapshot; every lookup index then gets rebuilt
+ */
+void ledger_find_touch(struct ledger_find_index* x, int shared_tf);
+
+
 /*
  * Find a ledger by name.
  * - b book to read
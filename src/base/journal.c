@@ -3,6 +3,7 @@
 #include "util.h"
 #include "table.h"
 #include "entry.h"
+#include "find.h"
 #include <limits.h>
 
 /*
@@ -25,6 +26,22 @@ struct ledger_journal {
    * next id to use
    */
   int sequence_id;
+  /*
+   * brief: lock for the journal's own fields
+   */
+  struct ledger_util_lock* lock;
+  /*
+   * brief: number of extra owners sharing the journal
+   */
+  int shares;
+  /*
+   * brief: lookup index over the entries
+   */
+  struct ledger_find_index* entry_index;
+  /*
+   * brief: lookup index of the book holding the journal
+   */
+  struct ledger_find_index* find_index;
 };
 
 static int ledger_journal_schema[] =
@@ -54,6 +71,22 @@ static void ledger_journal_clear(struct ledger_journal* a);
  */
 static void ledger_journal_free_cb(void* j);
 
+/*
+ * Resize the entry array, with the journal already locked.
+ * - a journal to modify
+ * - n new number of entries
+ * @return one on success, zero otherwise
+ */
+static int ledger_journal_set_entry_count_sub
+  (struct ledger_journal* a, int n);
+
+/*
+ * Copy a journal, sharing its entries and table with the copy.
+ * - a journal to copy
+ * @return the copy on success, NULL otherwise
+ */
+static struct ledger_journal* ledger_journal_fork(struct ledger_journal* a);
+
 
 
 /* BEGIN static implementation */
@@ -72,11 +105,18 @@ int ledger_journal_init(struct ledger_journal* a){
   a->entries = NULL;
   a->entry_count = 0;
   a->table = NULL;
+  a->shares = 0;
+  a->entry_index = NULL;
+  a->find_index = NULL;
+  a->lock = ledger_util_lock_new();
+  if (a->lock == NULL) return 0;
+  a->entry_index = ledger_find_index_new();
+  if (a->entry_index == NULL) return 0;
   /* prepare the table */{
     int ok = 0;
     int const schema_size = sizeof(ledger_journal_schema)/
         sizeof(ledger_journal_schema[0]);
-    struct ledger_table *new_table = ledger_table_new();
+    struct ledger_table *new_table = ledger_table_new_columnar();
     if (new_table == NULL) return 0;
     else do {
       if (!ledger_table_set_column_types
@@ -95,8 +135,9 @@ int ledger_journal_init(struct ledger_journal* a){
 }
 
 void ledger_journal_clear(struct ledger_journal* a){
-  ledger_journal_set_entry_count(a,0);
-  ledger_table_free(a->table);
+  /* NOTE no other references remain, so no lock necessary */
+  ledger_journal_set_entry_count_sub(a,0);
+  ledger_table_drop_share(a->table);
   a->table = NULL;
   ledger_util_free(a->description);
   a->description = NULL;
@@ -104,9 +145,130 @@ void ledger_journal_clear(struct ledger_journal* a){
   a->name = NULL;
   a->item_id = -1;
   a->sequence_id = 0;
+  ledger_find_index_free(a->entry_index);
+  a->entry_index = NULL;
+  ledger_find_index_free(a->find_index);
+  a->find_index = NULL;
+  ledger_util_lock_free(a->lock);
+  a->lock = NULL;
   return;
 }
 
+int ledger_journal_set_entry_count_sub(struct ledger_journal* a, int n){
+  if (n >= INT_MAX/sizeof(struct ledger_entry*)){
+    return 0;
+  } else if (n < 0){
+    return 0;
+  } else if (n == 0){
+    int i;
+    for (i = 0; i < a->entry_count; ++i){
+      ledger_entry_drop_share(a->entries[i]);
+    }
+    ledger_util_free(a->entries);
+    a->entries = NULL;
+    a->entry_count = 0;
+    return 1;
+  } else if (n < a->entry_count){
+    int i;
+    /* allocate smaller array */
+    struct ledger_entry** new_array = (struct ledger_entry** )
+      ledger_util_malloc(n*sizeof(struct ledger_entry*));
+    if (new_array == NULL) return 0;
+    /* move old entries to new array */
+    for (i = 0; i < n; ++i){
+      new_array[i] = a->entries[i];
+    }
+    /* free rest of the entries */
+    for (; i < a->entry_count; ++i){
+      ledger_entry_drop_share(a->entries[i]);
+    }
+    ledger_util_free(a->entries);
+    a->entries = new_array;
+    a->entry_count = n;
+    return 1;
+  } else if (n >= a->entry_count){
+    int save_id;
+    int i;
+    /* allocate larger array */
+    struct ledger_entry** new_array = (struct ledger_entry** )
+      ledger_util_malloc(n*sizeof(struct ledger_entry*));
+    if (new_array == NULL) return 0;
+    /* save the sequence number in case of rollback */
+    save_id = a->sequence_id;
+    /* make new entries */
+    for (i = a->entry_count; i < n; ++i){
+      int next_id = ledger_journal_alloc_id(a);
+      if (next_id == -1) break;
+      new_array[i] = ledger_entry_new();
+      if (new_array[i] == NULL) break;
+      ledger_entry_set_id(new_array[i], next_id);
+      ledger_entry_set_find_index(new_array[i], a->entry_index);
+    }
+    /* rollback and quit */if (i < n){
+      int j;
+      /* rollback */
+      for (j = a->entry_count; j < i; ++j){
+        ledger_entry_free(new_array[i]);
+      }
+      a->sequence_id = save_id;
+      /* quit */
+      return 0;
+    }
+    /* transfer old entries */
+    for (i = 0; i < a->entry_count; ++i){
+      new_array[i] = a->entries[i];
+    }
+    /* continue */
+    ledger_util_free(a->entries);
+    a->entries = new_array;
+    a->entry_count = n;
+    return 1;
+  } else return 1 /*since n == a->entry_count */;
+}
+
+struct ledger_journal* ledger_journal_fork(struct ledger_journal* a){
+  struct ledger_journal* out = ledger_journal_new();
+  if (out != NULL){
+    int ok = 0;
+    ledger_util_lock_shared(a->lock);
+    do {
+      int i;
+      int dup_ok;
+      struct ledger_table* table;
+      out->item_id = a->item_id;
+      out->sequence_id = a->sequence_id;
+      out->name = ledger_util_ustrdup(a->name, &dup_ok);
+      if (!dup_ok) break;
+      out->description = ledger_util_ustrdup(a->description, &dup_ok);
+      if (!dup_ok) break;
+      /* share the table in place of the new one */
+      table = ledger_table_share(a->table);
+      if (table == NULL) break;
+      ledger_table_drop_share(out->table);
+      out->table = table;
+      if (a->entry_count > 0){
+        out->entries = (struct ledger_entry**)ledger_util_malloc
+          (a->entry_count*sizeof(struct ledger_entry*));
+        if (out->entries == NULL) break;
+        for (i = 0; i < a->entry_count; ++i){
+          out->entries[i] = ledger_entry_share(a->entries[i]);
+          if (out->entries[i] == NULL) break;
+        }
+        /* keep only the entries actually shared */
+        out->entry_count = i;
+        if (i < a->entry_count) break;
+      }
+      ok = 1;
+    } while (0);
+    ledger_util_unlock_shared(a->lock);
+    if (!ok){
+      ledger_journal_free(out);
+      out = NULL;
+    }
+  }
+  return out;
+}
+
 /* END   static implementation */
 
 /* BEGIN implementation */
@@ -134,10 +296,57 @@ void ledger_journal_free(struct ledger_journal* a){
   }
 }
 
+struct ledger_journal* ledger_journal_share(struct ledger_journal* a){
+  if (ledger_journal_acquire(a) == NULL) return NULL;
+  ledger_util_share_add(&a->shares, +1);
+  return a;
+}
+
+void ledger_journal_drop_share(struct ledger_journal* a){
+  if (a != NULL){
+    ledger_util_share_add(&a->shares, -1);
+    ledger_journal_free(a);
+  }
+  return;
+}
+
+struct ledger_journal* ledger_journal_own(struct ledger_journal* a){
+  struct ledger_journal* copy;
+  if (ledger_util_share_add(&a->shares, 0) == 0) return a;
+  copy = ledger_journal_fork(a);
+  if (copy == NULL) return NULL;
+  ledger_journal_drop_share(a);
+  return copy;
+}
+
+void ledger_journal_read_lock(struct ledger_journal const* a){
+  ledger_util_lock_shared(a->lock);
+  return;
+}
+
+void ledger_journal_read_unlock(struct ledger_journal const* a){
+  ledger_util_unlock_shared(a->lock);
+  return;
+}
+
+void ledger_journal_write_lock(struct ledger_journal const* a){
+  ledger_util_lock_exclusive(a->lock);
+  return;
+}
+
+void ledger_journal_write_unlock(struct ledger_journal const* a){
+  ledger_util_unlock_exclusive(a->lock);
+  return;
+}
+
 unsigned char const* ledger_journal_get_description
   (struct ledger_journal const* a)
 {
-  return a->description;
+  unsigned char const* desc;
+  ledger_util_lock_shared(a->lock);
+  desc = a->description;
+  ledger_util_unlock_shared(a->lock);
+  return desc;
 }
 
 int ledger_journal_set_description
@@ -146,8 +355,10 @@ int ledger_journal_set_description
   int ok;
   unsigned char* new_desc = ledger_util_ustrdup(desc,&ok);
   if (ok){
+    ledger_util_lock_exclusive(a->lock);
     ledger_util_free(a->description);
     a->description = new_desc;
+    ledger_util_unlock_exclusive(a->lock);
     return 1;
   } else return 0;
 }
@@ -155,7 +366,11 @@ int ledger_journal_set_description
 unsigned char const* ledger_journal_get_name
   (struct ledger_journal const* a)
 {
-  return a->name;
+  unsigned char const* name;
+  ledger_util_lock_shared(a->lock);
+  name = a->name;
+  ledger_util_unlock_shared(a->lock);
+  return name;
 }
 
 int ledger_journal_set_name
@@ -164,57 +379,96 @@ int ledger_journal_set_name
   int ok;
   unsigned char* new_desc = ledger_util_ustrdup(desc,&ok);
   if (ok){
+    ledger_util_lock_exclusive(a->lock);
     ledger_util_free(a->name);
     a->name = new_desc;
+    ledger_find_touch
+      (a->find_index, ledger_util_share_add(&a->shares, 0) > 0);
+    ledger_util_unlock_exclusive(a->lock);
     return 1;
   } else return 0;
 }
 
 int ledger_journal_get_id(struct ledger_journal const* a){
-  return a->item_id;
+  int item_id;
+  ledger_util_lock_shared(a->lock);
+  item_id = a->item_id;
+  ledger_util_unlock_shared(a->lock);
+  return item_id;
 }
 
 void ledger_journal_set_id(struct ledger_journal* a, int item_id){
+  ledger_util_lock_exclusive(a->lock);
   if (item_id < 0){
     a->item_id = -1;
   } else {
     a->item_id = item_id;
   }
+  ledger_find_touch
+    (a->find_index, ledger_util_share_add(&a->shares, 0) > 0);
+  ledger_util_unlock_exclusive(a->lock);
+  return;
+}
+
+void ledger_journal_set_find_index
+  (struct ledger_journal* a, struct ledger_find_index* x)
+{
+  ledger_util_lock_exclusive(a->lock);
+  if (a->find_index != x){
+    ledger_find_index_free(a->find_index);
+    a->find_index = ledger_find_index_acquire(x);
+  }
+  ledger_util_unlock_exclusive(a->lock);
   return;
 }
 
 int ledger_journal_is_equal
   (struct ledger_journal const* a, struct ledger_journal const* b)
 {
+  int result = 0;
   /* trivial journals */
   if (a == NULL && b == NULL) return 1;
   else if (a == NULL || b == NULL) return 0;
-  /* compare top-level features */{
-    if (a->item_id != b->item_id)
-      return 0;
-    if (ledger_util_ustrcmp(a->name, b->name) != 0)
-      return 0;
-    if (ledger_util_ustrcmp(a->description, b->description) != 0)
-      return 0;
-  }
-  /* compare tables */{
-    if (!ledger_table_is_equal(a->table, b->table))
-      return 0;
-  }
-  /* compare entries */{
-    int i;
-    if (a->entry_count != b->entry_count) return 0;
-    else for (i = 0; i < a->entry_count; ++i){
-      if (!ledger_entry_is_equal(a->entries[i], b->entries[i]))
+  ledger_util_lock_shared(a->lock);
+  ledger_util_lock_shared(b->lock);
+  do {
+    /* compare top-level features */{
+      if (a->item_id != b->item_id)
+        break;
+      if (ledger_util_ustrcmp(a->name, b->name) != 0)
+        break;
+      if (ledger_util_ustrcmp(a->description, b->description) != 0)
         break;
     }
-    if (i < a->entry_count) return 0;
-  }
-  return 1;
+    /* compare tables */{
+      if (!ledger_table_is_equal(a->table, b->table))
+        break;
+    }
+    /* compare entries */{
+      int i;
+      if (a->entry_count != b->entry_count) break;
+      else for (i = 0; i < a->entry_count; ++i){
+        if (!ledger_entry_is_equal(a->entries[i], b->entries[i]))
+          break;
+      }
+      if (i < a->entry_count) break;
+    }
+    result = 1;
+  } while (0);
+  ledger_util_unlock_shared(b->lock);
+  ledger_util_unlock_shared(a->lock);
+  return result;
 }
 
 struct ledger_table* ledger_journal_get_table(struct ledger_journal* a){
-  return a->table;
+  struct ledger_table* t;
+  /* a shared table gets replaced by a private copy */
+  ledger_util_lock_exclusive(a->lock);
+  t = ledger_table_own(a->table);
+  if (t != NULL)
+    a->table = t;
+  ledger_util_unlock_exclusive(a->lock);
+  return t;
 }
 
 struct ledger_table const* ledger_journal_get_table_c
@@ -225,118 +479,88 @@ struct ledger_table const* ledger_journal_get_table_c
 
 
 int ledger_journal_get_sequence(struct ledger_journal const* a){
-  return a->sequence_id;
+  int item_id;
+  ledger_util_lock_shared(a->lock);
+  item_id = a->sequence_id;
+  ledger_util_unlock_shared(a->lock);
+  return item_id;
 }
 
 int ledger_journal_set_sequence(struct ledger_journal* a, int item_id){
   if (item_id < 0) return 0;
+  ledger_util_lock_exclusive(a->lock);
   a->sequence_id = item_id;
+  ledger_util_unlock_exclusive(a->lock);
   return 1;
 }
 
 int ledger_journal_alloc_id(struct ledger_journal* a){
+  int out;
+  ledger_util_lock_exclusive(a->lock);
   if (a->sequence_id < INT_MAX){
-    int out;
     out = a->sequence_id;
     a->sequence_id += 1;
-    return out;
-  } else return -1;
+  } else out = -1;
+  ledger_util_unlock_exclusive(a->lock);
+  return out;
 }
 
 int ledger_journal_get_entry_count(struct ledger_journal const* a){
-  return a->entry_count;
+  int n;
+  ledger_util_lock_shared(a->lock);
+  n = a->entry_count;
+  ledger_util_unlock_shared(a->lock);
+  return n;
 }
 
 struct ledger_entry* ledger_journal_get_entry
   (struct ledger_journal* a, int i)
 {
+  struct ledger_entry* e;
+  /* a shared entry gets replaced by a private copy */
+  ledger_util_lock_exclusive(a->lock);
   if (i < 0 || i >= a->entry_count){
-    return NULL;
+    e = NULL;
   } else {
-    return a->entries[i];
+    e = ledger_entry_own(a->entries[i]);
+    if (e != NULL){
+      a->entries[i] = e;
+      ledger_entry_set_find_index(e, a->entry_index);
+    }
   }
+  ledger_util_unlock_exclusive(a->lock);
+  return e;
 }
 
 struct ledger_entry const* ledger_journal_get_entry_c
   (struct ledger_journal const* a, int i)
 {
+  struct ledger_entry const* e;
+  ledger_util_lock_shared(a->lock);
   if (i < 0 || i >= a->entry_count){
-    return NULL;
+    e = NULL;
   } else {
-    return a->entries[i];
+    e = a->entries[i];
   }
+  ledger_util_unlock_shared(a->lock);
+  return e;
 }
 
 int ledger_journal_set_entry_count(struct ledger_journal* a, int n){
-  if (n >= INT_MAX/sizeof(struct ledger_entry*)){
-    return 0;
-  } else if (n < 0){
-    return 0;
-  } else if (n == 0){
-    int i;
-    for (i = 0; i < a->entry_count; ++i){
-      ledger_entry_free(a->entries[i]);
-    }
-    ledger_util_free(a->entries);
-    a->entries = NULL;
-    a->entry_count = 0;
-    return 1;
-  } else if (n < a->entry_count){
-    int i;
-    /* allocate smaller array */
-    struct ledger_entry** new_array = (struct ledger_entry** )
-      ledger_util_malloc(n*sizeof(struct ledger_entry*));
-    if (new_array == NULL) return 0;
-    /* move old entries to new array */
-    for (i = 0; i < n; ++i){
-      new_array[i] = a->entries[i];
-    }
-    /* free rest of the entries */
-    for (; i < a->entry_count; ++i){
-      ledger_entry_free(a->entries[i]);
-    }
-    ledger_util_free(a->entries);
-    a->entries = new_array;
-    a->entry_count = n;
-    return 1;
-  } else if (n >= a->entry_count){
-    int save_id;
-    int i;
-    /* allocate larger array */
-    struct ledger_entry** new_array = (struct ledger_entry** )
-      ledger_util_malloc(n*sizeof(struct ledger_entry*));
-    if (new_array == NULL) return 0;
-    /* save the sequence number in case of rollback */
-    save_id = a->sequence_id;
-    /* make new entries */
-    for (i = a->entry_count; i < n; ++i){
-      int next_id = ledger_journal_alloc_id(a);
-      if (next_id == -1) break;
-      new_array[i] = ledger_entry_new();
-      if (new_array[i] == NULL) break;
-      ledger_entry_set_id(new_array[i], next_id);
-    }
-    /* rollback and quit */if (i < n){
-      int j;
-      /* rollback */
-      for (j = a->entry_count; j < i; ++j){
-        ledger_entry_free(new_array[i]);
-      }
-      a->sequence_id = save_id;
-      /* quit */
-      return 0;
-    }
-    /* transfer old entries */
-    for (i = 0; i < a->entry_count; ++i){
-      new_array[i] = a->entries[i];
-    }
-    /* continue */
-    ledger_util_free(a->entries);
-    a->entries = new_array;
-    a->entry_count = n;
-    return 1;
-  } else return 1 /*since n == a->entry_count */;
+  int result;
+  ledger_util_lock_exclusive(a->lock);
+  result = ledger_journal_set_entry_count_sub(a, n);
+  ledger_find_touch(a->entry_index, 0);
+  ledger_util_unlock_exclusive(a->lock);
+  return result;
+}
+
+struct ledger_find_index* ledger_journal_get_entry_index
+  (struct ledger_journal const* a)
+{
+  return a->entry_index;
 }
 
 
+
 /* END   implementation */
@@ -10,6 +10,8 @@
 extern "C" {
 #endif /*__cplusplus*/
 
+struct ledger_find_index;
+
 /*
  * brief: Journal
  */
@@ -34,6 +36,63 @@ struct ledger_journal* ledger_journal_acquire(struct ledger_journal* a);
  */
 void ledger_journal_free(struct ledger_journal* a);
 
+/*
+ * Acquire a journal for another owner, such as a book snapshot.
+ * An owner must call `ledger_journal_own` before changing a journal.
+ * - a the journal to share
+ * @return the journal on success, otherwise NULL
+ */
+struct ledger_journal* ledger_journal_share(struct ledger_journal* a);
+
+/*
+ * Release a journal held by one of its owners.
+ * - a the journal to release
+ */
+void ledger_journal_drop_share(struct ledger_journal* a);
+
+/*
+ * Prepare a journal for changes by one of its owners. A journal that
+ * other owners still share is copied, and the copy replaces the
+ * owner's hold on the original. The copy shares the journal's entries
+ * and table until one of them changes.
+ * - a the journal held by the owner
+ * @return the journal itself if unshared, a private copy otherwise,
+ *   or NULL if the copy failed (the owner keeps the original)
+ */
+struct ledger_journal* ledger_journal_own(struct ledger_journal* a);
+
+/*
+ * Hold a journal for reading. Journal functions lock the journal on
+ * their own; hold this lock to keep several calls consistent while other
+ * threads might modify the journal, and to keep strings and entries
+ * returned by the journal alive while in use. Locks nest within a thread,
+ * and a thread holding the read lock must not modify the journal. That
+ * includes ledger_journal_get_entry, which may swap in a private copy
+ * and needs the journal exclusive: upgrading a read lock to a write
+ * lock is forbidden.
+ * - a the journal to lock
+ */
+void ledger_journal_read_lock(struct ledger_journal const* a);
+
+/*
+ * Release a journal held for reading.
+ * - a the journal to unlock
+ */
+void ledger_journal_read_unlock(struct ledger_journal const* a);
+
+/*
+ * Hold a journal for writing, keeping other threads out of the journal
+ * over several modifications. Locks nest within a thread.
+ * - a the journal to lock
+ */
+void ledger_journal_write_lock(struct ledger_journal const* a);
+
+/*
+ * Release a journal held for writing.
+ * - a the journal to unlock
+ */
+void ledger_journal_write_unlock(struct ledger_journal const* a);
+
 /*
  * Query the description of a journal.
  * - a journal to query
@@ -82,6 +141,15 @@ int ledger_journal_get_id(struct ledger_journal const* a);
  */
 void ledger_journal_set_id(struct ledger_journal* a, int item_id);
 
+/*
+ * Attach a journal to the lookup index of the book holding it, so that
+ * changes to its name or identifier mark that index stale.
+ * - a journal to modify
+ * - x the lookup index, or NULL to detach
+ */
+void ledger_journal_set_find_index
+  (struct ledger_journal* a, struct ledger_find_index* x);
+
 /*
  * Compare two journals for equality.
  * - a a journal
@@ -92,9 +160,10 @@ int ledger_journal_is_equal
   (struct ledger_journal const* a, struct ledger_journal const* b);
 
 /*
- * Modify a journal's transaction table.
+ * Modify a journal's transaction table. A table shared with
+ * a snapshot is copied first.
  * - a journal to modify
- * @return the transaction table
+ * @return the transaction table, or NULL if the copy failed
  */
 struct ledger_table* ledger_journal_get_table(struct ledger_journal* a);
 
@@ -147,10 +216,11 @@ int ledger_journal_get_entry_count(struct ledger_journal const* a);
 int ledger_journal_set_entry_count(struct ledger_journal* a, int n);
 
 /*
- * Get an entry.
+ * Get an entry for modification. An entry shared with a
+ * snapshot is copied first.
  * - a journal to adjust
  * - i array index
- * @return the entry at that array index
+ * @return the entry at that array index, or NULL if the copy failed
  */
 struct ledger_entry* ledger_journal_get_entry
   (struct ledger_journal* a, int i);
@@ -164,6 +234,15 @@ struct ledger_entry* ledger_journal_get_entry
 struct ledger_entry const* ledger_journal_get_entry_c
   (struct ledger_journal const* a, int i);
 
+/*
+ * Get the lookup index over a journal's entries, for use by the
+ * find functions.
+ * - a journal to query
+ * @return the lookup index
+ */
+struct ledger_find_index* ledger_journal_get_entry_index
+  (struct ledger_journal const* a);
+
 
 #ifdef __cplusplus
 };
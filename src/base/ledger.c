@@ -2,6 +2,7 @@
 #include "ledger.h"
 #include "util.h"
 #include "account.h"
+#include "find.h"
 #include <limits.h>
 
 /*
@@ -23,6 +24,22 @@ struct ledger_ledger {
    * next id to use
    */
   int sequence_id;
+  /*
+   * brief: lock for the ledger's own fields
+   */
+  struct ledger_util_lock* lock;
+  /*
+   * brief: number of extra owners sharing the ledger
+   */
+  int shares;
+  /*
+   * brief: lookup index over the accounts
+   */
+  struct ledger_find_index* account_index;
+  /*
+   * brief: lookup index of the book holding the ledger
+   */
+  struct ledger_find_index* find_index;
 };
 
 /*
@@ -44,6 +61,22 @@ static int ledger_ledger_init(struct ledger_ledger* l);
  */
 static void ledger_ledger_clear(struct ledger_ledger* l);
 
+/*
+ * Resize the account array, with the ledger already locked.
+ * - l ledger to modify
+ * - n new number of accounts
+ * @return one on success, zero otherwise
+ */
+static int ledger_ledger_set_account_count_sub
+  (struct ledger_ledger* l, int n);
+
+/*
+ * Copy a ledger, sharing its accounts with the copy.
+ * - l ledger to copy
+ * @return the copy on success, NULL otherwise
+ */
+static struct ledger_ledger* ledger_ledger_fork(struct ledger_ledger* l);
+
 
 /* BEGIN static implementation */
 
@@ -60,20 +93,143 @@ int ledger_ledger_init(struct ledger_ledger* l){
   l->sequence_id = 0;
   l->accounts = NULL;
   l->account_count = 0;
+  l->shares = 0;
+  l->account_index = NULL;
+  l->find_index = NULL;
+  l->lock = ledger_util_lock_new();
+  if (l->lock == NULL) return 0;
+  l->account_index = ledger_find_index_new();
+  if (l->account_index == NULL) return 0;
   return 1;
 }
 
 void ledger_ledger_clear(struct ledger_ledger* l){
-  ledger_ledger_set_account_count(l,0);
+  /* NOTE no other references remain, so no lock necessary */
+  ledger_ledger_set_account_count_sub(l,0);
   ledger_util_free(l->description);
   l->description = NULL;
   ledger_util_free(l->name);
   l->description = NULL;
   l->item_id = -1;
   l->sequence_id = 0;
+  ledger_find_index_free(l->account_index);
+  l->account_index = NULL;
+  ledger_find_index_free(l->find_index);
+  l->find_index = NULL;
+  ledger_util_lock_free(l->lock);
+  l->lock = NULL;
   return;
 }
 
+int ledger_ledger_set_account_count_sub(struct ledger_ledger* l, int n){
+  if (n >= INT_MAX/sizeof(struct ledger_account*)){
+    return 0;
+  } else if (n < 0){
+    return 0;
+  } else if (n == 0){
+    int i;
+    for (i = 0; i < l->account_count; ++i){
+      ledger_account_drop_share(l->accounts[i]);
+    }
+    ledger_util_free(l->accounts);
+    l->accounts = NULL;
+    l->account_count = 0;
+    return 1;
+  } else if (n < l->account_count){
+    int i;
+    /* allocate smaller array */
+    struct ledger_account** new_array = (struct ledger_account** )
+      ledger_util_malloc(n*sizeof(struct ledger_account*));
+    if (new_array == NULL) return 0;
+    /* move old accounts to new array */
+    for (i = 0; i < n; ++i){
+      new_array[i] = l->accounts[i];
+    }
+    /* free rest of the accounts */
+    for (; i < l->account_count; ++i){
+      ledger_account_drop_share(l->accounts[i]);
+    }
+    ledger_util_free(l->accounts);
+    l->accounts = new_array;
+    l->account_count = n;
+    return 1;
+  } else if (n >= l->account_count){
+    int save_id;
+    int i;
+    /* allocate larger array */
+    struct ledger_account** new_array = (struct ledger_account** )
+      ledger_util_malloc(n*sizeof(struct ledger_account*));
+    if (new_array == NULL) return 0;
+    /* save the sequence number in case of rollback */
+    save_id = l->sequence_id;
+    /* make new accounts */
+    for (i = l->account_count; i < n; ++i){
+      int next_id = ledger_ledger_alloc_id(l);
+      if (next_id == -1) break;
+      new_array[i] = ledger_account_new();
+      if (new_array[i] == NULL) break;
+      ledger_account_set_id(new_array[i], next_id);
+      ledger_account_set_find_index(new_array[i], l->account_index);
+    }
+    /* rollback and quit */if (i < n){
+      int j;
+      /* rollback */
+      for (j = l->account_count; j < i; ++j){
+        ledger_account_free(new_array[i]);
+      }
+      l->sequence_id = save_id;
+      /* quit */
+      return 0;
+    }
+    /* transfer old accounts */
+    for (i = 0; i < l->account_count; ++i){
+      new_array[i] = l->accounts[i];
+    }
+    /* continue */
+    ledger_util_free(l->accounts);
+    l->accounts = new_array;
+    l->account_count = n;
+    return 1;
+  } else return 1 /*since n == l->account_count */;
+}
+
+struct ledger_ledger* ledger_ledger_fork(struct ledger_ledger* l){
+  struct ledger_ledger* out = ledger_ledger_new();
+  if (out != NULL){
+    int ok = 0;
+    ledger_util_lock_shared(l->lock);
+    do {
+      int i;
+      int dup_ok;
+      out->item_id = l->item_id;
+      out->sequence_id = l->sequence_id;
+      out->name = ledger_util_ustrdup(l->name, &dup_ok);
+      if (!dup_ok) break;
+      out->description = ledger_util_ustrdup(l->description, &dup_ok);
+      if (!dup_ok) break;
+      if (l->account_count > 0){
+        out->accounts = (struct ledger_account**)ledger_util_malloc
+          (l->account_count*sizeof(struct ledger_account*));
+        if (out->accounts == NULL) break;
+        for (i = 0; i < l->account_count; ++i){
+          out->accounts[i] = ledger_account_share(l->accounts[i]);
+          if (out->accounts[i] == NULL) break;
+        }
+        /* keep only the accounts actually shared */
+        out->account_count = i;
+        if (i < l->account_count) break;
+      }
+      ok = 1;
+    } while (0);
+    ledger_util_unlock_shared(l->lock);
+    if (!ok){
+      ledger_ledger_free(out);
+      out = NULL;
+    }
+  }
+  return out;
+}
+
 /* END   static implementation */
 
 /* BEGIN implementation */
@@ -101,10 +257,57 @@ void ledger_ledger_free(struct ledger_ledger* l){
   }
 }
 
+struct ledger_ledger* ledger_ledger_share(struct ledger_ledger* l){
+  if (ledger_ledger_acquire(l) == NULL) return NULL;
+  ledger_util_share_add(&l->shares, +1);
+  return l;
+}
+
+void ledger_ledger_drop_share(struct ledger_ledger* l){
+  if (l != NULL){
+    ledger_util_share_add(&l->shares, -1);
+    ledger_ledger_free(l);
+  }
+  return;
+}
+
+struct ledger_ledger* ledger_ledger_own(struct ledger_ledger* l){
+  struct ledger_ledger* copy;
+  if (ledger_util_share_add(&l->shares, 0) == 0) return l;
+  copy = ledger_ledger_fork(l);
+  if (copy == NULL) return NULL;
+  ledger_ledger_drop_share(l);
+  return copy;
+}
+
+void ledger_ledger_read_lock(struct ledger_ledger const* l){
+  ledger_util_lock_shared(l->lock);
+  return;
+}
+
+void ledger_ledger_read_unlock(struct ledger_ledger const* l){
+  ledger_util_unlock_shared(l->lock);
+  return;
+}
+
+void ledger_ledger_write_lock(struct ledger_ledger const* l){
+  ledger_util_lock_exclusive(l->lock);
+  return;
+}
+
+void ledger_ledger_write_unlock(struct ledger_ledger const* l){
+  ledger_util_unlock_exclusive(l->lock);
+  return;
+}
+
 unsigned char const* ledger_ledger_get_description
   (struct ledger_ledger const* l)
 {
-  return l->description;
+  unsigned char const* desc;
+  ledger_util_lock_shared(l->lock);
+  desc = l->description;
+  ledger_util_unlock_shared(l->lock);
+  return desc;
 }
 
 int ledger_ledger_set_description
@@ -113,8 +316,10 @@ int ledger_ledger_set_description
   int ok;
   unsigned char* new_desc = ledger_util_ustrdup(desc,&ok);
   if (ok){
+    ledger_util_lock_exclusive(l->lock);
     ledger_util_free(l->description);
     l->description = new_desc;
+    ledger_util_unlock_exclusive(l->lock);
     return 1;
   } else return 0;
 }
@@ -122,7 +327,11 @@ int ledger_ledger_set_description
 unsigned char const* ledger_ledger_get_name
   (struct ledger_ledger const* l)
 {
-  return l->name;
+  unsigned char const* name;
+  ledger_util_lock_shared(l->lock);
+  name = l->name;
+  ledger_util_unlock_shared(l->lock);
+  return name;
 }
 
 int ledger_ledger_set_name
@@ -131,166 +340,168 @@ int ledger_ledger_set_name
   int ok;
   unsigned char* new_desc = ledger_util_ustrdup(desc,&ok);
   if (ok){
+    ledger_util_lock_exclusive(l->lock);
     ledger_util_free(l->name);
     l->name = new_desc;
+    ledger_find_touch
+      (l->find_index, ledger_util_share_add(&l->shares, 0) > 0);
+    ledger_util_unlock_exclusive(l->lock);
     return 1;
   } else return 0;
 }
 
 int ledger_ledger_get_id(struct ledger_ledger const* l){
-  return l->item_id;
+  int item_id;
+  ledger_util_lock_shared(l->lock);
+  item_id = l->item_id;
+  ledger_util_unlock_shared(l->lock);
+  return item_id;
 }
 
 void ledger_ledger_set_id(struct ledger_ledger* l, int item_id){
+  ledger_util_lock_exclusive(l->lock);
   if (item_id < 0){
     l->item_id = -1;
   } else {
     l->item_id = item_id;
   }
+  ledger_find_touch
+    (l->find_index, ledger_util_share_add(&l->shares, 0) > 0);
+  ledger_util_unlock_exclusive(l->lock);
+  return;
+}
+
+void ledger_ledger_set_find_index
+  (struct ledger_ledger* l, struct ledger_find_index* x)
+{
+  ledger_util_lock_exclusive(l->lock);
+  if (l->find_index != x){
+    ledger_find_index_free(l->find_index);
+    l->find_index = ledger_find_index_acquire(x);
+  }
+  ledger_util_unlock_exclusive(l->lock);
   return;
 }
 
 int ledger_ledger_is_equal
   (struct ledger_ledger const* a, struct ledger_ledger const* b)
 {
+  int result = 0;
   /* trivial ledgers */
   if (a == NULL && b == NULL) return 1;
   else if (a == NULL || b == NULL) return 0;
-  /* compare top-level features */{
-    if (a->item_id != b->item_id)
-      return 0;
-    if (ledger_util_ustrcmp(a->name, b->name) != 0)
-      return 0;
-    if (ledger_util_ustrcmp(a->description, b->description) != 0)
-      return 0;
-  }
-  /* compare accounts */{
-    int i;
-    if (a->account_count != b->account_count) return 0;
-    else for (i = 0; i < a->account_count; ++i){
-      if (!ledger_account_is_equal(a->accounts[i], b->accounts[i]))
+  ledger_util_lock_shared(a->lock);
+  ledger_util_lock_shared(b->lock);
+  do {
+    /* compare top-level features */{
+      if (a->item_id != b->item_id)
+        break;
+      if (ledger_util_ustrcmp(a->name, b->name) != 0)
+        break;
+      if (ledger_util_ustrcmp(a->description, b->description) != 0)
         break;
     }
-    if (i < a->account_count) return 0;
-  }
-  return 1;
+    /* compare accounts */{
+      int i;
+      if (a->account_count != b->account_count) break;
+      else for (i = 0; i < a->account_count; ++i){
+        if (!ledger_account_is_equal(a->accounts[i], b->accounts[i]))
+          break;
+      }
+      if (i < a->account_count) break;
+    }
+    result = 1;
+  } while (0);
+  ledger_util_unlock_shared(b->lock);
+  ledger_util_unlock_shared(a->lock);
+  return result;
 }
 
 
 int ledger_ledger_get_sequence(struct ledger_ledger const* l){
-  return l->sequence_id;
+  int item_id;
+  ledger_util_lock_shared(l->lock);
+  item_id = l->sequence_id;
+  ledger_util_unlock_shared(l->lock);
+  return item_id;
 }
 
 int ledger_ledger_set_sequence(struct ledger_ledger* l, int item_id){
   if (item_id < 0) return 0;
+  ledger_util_lock_exclusive(l->lock);
   l->sequence_id = item_id;
+  ledger_util_unlock_exclusive(l->lock);
   return 1;
 }
 
 int ledger_ledger_alloc_id(struct ledger_ledger* l){
+  int out;
+  ledger_util_lock_exclusive(l->lock);
   if (l->sequence_id < INT_MAX){
-    int out;
     out = l->sequence_id;
     l->sequence_id += 1;
-    return out;
-  } else return -1;
+  } else out = -1;
+  ledger_util_unlock_exclusive(l->lock);
+  return out;
 }
 
 int ledger_ledger_get_account_count(struct ledger_ledger const* l){
-  return l->account_count;
+  int n;
+  ledger_util_lock_shared(l->lock);
+  n = l->account_count;
+  ledger_util_unlock_shared(l->lock);
+  return n;
 }
 
 struct ledger_account* ledger_ledger_get_account
   (struct ledger_ledger* l, int i)
 {
+  struct ledger_account* a;
+  /* a shared account gets replaced by a private copy */
+  ledger_util_lock_exclusive(l->lock);
   if (i < 0 || i >= l->account_count){
-    return NULL;
+    a = NULL;
   } else {
-    return l->accounts[i];
+    a = ledger_account_own(l->accounts[i]);
+    if (a != NULL){
+      l->accounts[i] = a;
+      ledger_account_set_find_index(a, l->account_index);
+    }
   }
+  ledger_util_unlock_exclusive(l->lock);
+  return a;
 }
 
 struct ledger_account const* ledger_ledger_get_account_c
   (struct ledger_ledger const* l, int i)
 {
+  struct ledger_account const* a;
+  ledger_util_lock_shared(l->lock);
   if (i < 0 || i >= l->account_count){
-    return NULL;
+    a = NULL;
   } else {
-    return l->accounts[i];
+    a = l->accounts[i];
   }
+  ledger_util_unlock_shared(l->lock);
+  return a;
 }
 
 int ledger_ledger_set_account_count(struct ledger_ledger* l, int n){
-  if (n >= INT_MAX/sizeof(struct ledger_account*)){
-    return 0;
-  } else if (n < 0){
-    return 0;
-  } else if (n == 0){
-    int i;
-    for (i = 0; i < l->account_count; ++i){
-      ledger_account_free(l->accounts[i]);
-    }
-    ledger_util_free(l->accounts);
-    l->accounts = NULL;
-    l->account_count = 0;
-    return 1;
-  } else if (n < l->account_count){
-    int i;
-    /* allocate smaller array */
-    struct ledger_account** new_array = (struct ledger_account** )
-      ledger_util_malloc(n*sizeof(struct ledger_account*));
-    if (new_array == NULL) return 0;
-    /* move old accounts to new array */
-    for (i = 0; i < n; ++i){
-      new_array[i] = l->accounts[i];
-    }
-    /* free rest of the accounts */
-    for (; i < l->account_count; ++i){
-      ledger_account_free(l->accounts[i]);
-    }
-    ledger_util_free(l->accounts);
-    l->accounts = new_array;
-    l->account_count = n;
-    return 1;
-  } else if (n >= l->account_count){
-    int save_id;
-    int i;
-    /* allocate larger array */
-    struct ledger_account** new_array = (struct ledger_account** )
-      ledger_util_malloc(n*sizeof(struct ledger_account*));
-    if (new_array == NULL) return 0;
-    /* save the sequence number in case of rollback */
-    save_id = l->sequence_id;
-    /* make new accounts */
-    for (i = l->account_count; i < n; ++i){
-      int next_id = ledger_ledger_alloc_id(l);
-      if (next_id == -1) break;
-      new_array[i] = ledger_account_new();
-      if (new_array[i] == NULL) break;
-      ledger_account_set_id(new_array[i], next_id);
-    }
-    /* rollback and quit */if (i < n){
-      int j;
-      /* rollback */
-      for (j = l->account_count; j < i; ++j){
-        ledger_account_free(new_array[i]);
-      }
-      l->sequence_id = save_id;
-      /* quit */
-      return 0;
-    }
-    /* transfer old accounts */
-    for (i = 0; i < l->account_count; ++i){
-      new_array[i] = l->accounts[i];
-    }
-    /* continue */
-    ledger_util_free(l->accounts);
-    l->accounts = new_array;
-    l->account_count = n;
-    return 1;
-  } else return 1 /*since n == l->account_count */;
+  int result;
+  ledger_util_lock_exclusive(l->lock);
+  result = ledger_ledger_set_account_count_sub(l, n);
+  ledger_find_touch(l->account_index, 0);
+  ledger_util_unlock_exclusive(l->lock);
+  return result;
+}
+
+struct ledger_find_index* ledger_ledger_get_account_index
+  (struct ledger_ledger const* l)
+{
+  return l->account_index;
 }
 
 
 
+
 /* END   implementation */
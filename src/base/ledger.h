@@ -10,6 +10,8 @@
 extern "C" {
 #endif /*__cplusplus*/
 
+struct ledger_find_index;
+
 /*
  * brief: Ledger (holder of accounts)
  */
@@ -34,6 +36,63 @@ struct ledger_ledger* ledger_ledger_acquire(struct ledger_ledger* a);
  */
 void ledger_ledger_free(struct ledger_ledger* l);
 
+/*
+ * Acquire a ledger for another owner, such as a book snapshot.
+ * An owner must call `ledger_ledger_own` before changing a ledger.
+ * - l the ledger to share
+ * @return the ledger on success, otherwise NULL
+ */
+struct ledger_ledger* ledger_ledger_share(struct ledger_ledger* l);
+
+/*
+ * Release a ledger held by one of its owners.
+ * - l the ledger to release
+ */
+void ledger_ledger_drop_share(struct ledger_ledger* l);
+
+/*
+ * Prepare a ledger for changes by one of its owners. A ledger that
+ * other owners still share is copied, and the copy replaces the
+ * owner's hold on the original. The copy shares the ledger's accounts
+ * until one of them changes.
+ * - l the ledger held by the owner
+ * @return the ledger itself if unshared, a private copy otherwise,
+ *   or NULL if the copy failed (the owner keeps the original)
+ */
+struct ledger_ledger* ledger_ledger_own(struct ledger_ledger* l);
+
+/*
+ * Hold a ledger for reading. Ledger functions lock the ledger on their
+ * own; hold this lock to keep several calls consistent while other
+ * threads might modify the ledger, and to keep strings and accounts
+ * returned by the ledger alive while in use. Locks nest within a thread,
+ * and a thread holding the read lock must not modify the ledger. That
+ * includes ledger_ledger_get_account, which may swap in a private copy
+ * and needs the ledger exclusive: upgrading a read lock to a write
+ * lock is forbidden.
+ * - l the ledger to lock
+ */
+void ledger_ledger_read_lock(struct ledger_ledger const* l);
+
+/*
+ * Release a ledger held for reading.
+ * - l the ledger to unlock
+ */
+void ledger_ledger_read_unlock(struct ledger_ledger const* l);
+
+/*
+ * Hold a ledger for writing, keeping other threads out of the ledger
+ * over several modifications. Locks nest within a thread.
+ * - l the ledger to lock
+ */
+void ledger_ledger_write_lock(struct ledger_ledger const* l);
+
+/*
+ * Release a ledger held for writing.
+ * - l the ledger to unlock
+ */
+void ledger_ledger_write_unlock(struct ledger_ledger const* l);
+
 /*
  * Query the description of a ledger.
  * - l ledger to query
@@ -82,6 +141,15 @@ int ledger_ledger_get_id(struct ledger_ledger const* l);
  */
 void ledger_ledger_set_id(struct ledger_ledger* l, int item_id);
 
+/*
+ * Attach a ledger to the lookup index of the book holding it, so that
+ * changes to its name or identifier mark that index stale.
+ * - l ledger to modify
+ * - x the lookup index, or NULL to detach
+ */
+void ledger_ledger_set_find_index
+  (struct ledger_ledger* l, struct ledger_find_index* x);
+
 /*
  * Compare two ledgers for equality.
  * - a a ledger
@@ -131,10 +199,11 @@ int ledger_ledger_get_account_count(struct ledger_ledger const* l);
 int ledger_ledger_set_account_count(struct ledger_ledger* l, int n);
 
 /*
- * Get an account.
+ * Get an account for modification. An account shared with a
+ * snapshot is copied first.
  * - l ledger to adjust
  * - i array index
- * @return the account at that array index
+ * @return the account at that array index, or NULL if the copy failed
  */
 struct ledger_account* ledger_ledger_get_account
   (struct ledger_ledger* l, int i);
@@ -148,6 +217,15 @@ struct ledger_account* ledger_ledger_get_account
 struct ledger_account const* ledger_ledger_get_account_c
   (struct ledger_ledger const* l, int i);
 
+/*
+ * Get the lookup index over a ledger's accounts, for use by the
+ * find functions.
+ * - l ledger to query
+ * @return the lookup index
+ */
+struct ledger_find_index* ledger_ledger_get_account_index
+  (struct ledger_ledger const* l);
+
 
 #ifdef __cplusplus
 };
@@ -1,31 +1,198 @@
 
-
 #include "table.h"
 #include "bignum.h"
 #include "util.h"
+#include "account.h"
+#include <limits.h>
+
+/*
+ * Add a fixed-point value to a fixed-point sum.
+ * - sum the running sum
+ * - sum_place centesimal places of the running sum
+ * - value the addend
+ * - point_place centesimal places of the addend
+ * @return one on success, zero on overflow
+ */
+static int ledger_sum_add_fixed
+  ( long long int* sum, int* sum_place, long long int value, int point_place);
+
+/*
+ * Extend a date with no time of day to the last moment of that day.
+ * - date packed date
+ * @return the greatest packed date on the same day, or `date` itself
+ *   if it has a time of day
+ */
+static long long int ledger_sum_day_end(long long int date);
+
+/*
+ * Sum the lines of an account table through a date, marking the lines
+ * in one pass over the date column and summing them in one pass over
+ * the amount column.
+ * - out output number, to hold the balance
+ * - table the account's table
+ * - bound inclusive upper bound on the packed line dates
+ * @return one on success, zero if the columns cannot be scanned
+ *   or on failure
+ */
+static int ledger_sum_scan_as_of
+  ( struct ledger_bignum* out, struct ledger_table const* table,
+    long long int bound);
+
+/* BEGIN static implementation */
+
+int ledger_sum_add_fixed
+  ( long long int* sum, int* sum_place, long long int value, int point_place)
+{
+  long long int left = *sum;
+  int place = *sum_place;
+  /* align the centesimal points */
+  for (; place < point_place; ++place){
+    if (left > LLONG_MAX/100 || left < -(LLONG_MAX/100))
+      return 0;
+    left *= 100;
+  }
+  for (; point_place < place; ++point_place){
+    if (value > LLONG_MAX/100 || value < -(LLONG_MAX/100))
+      return 0;
+    value *= 100;
+  }
+  /* add */
+  if (value > 0 && left > LLONG_MAX-value)
+    return 0;
+  else if (value < 0 && left < -LLONG_MAX-value)
+    return 0;
+  *sum = left+value;
+  *sum_place = place;
+  return 1;
+}
+
+long long int ledger_sum_day_end(long long int date){
+  /* see `ledger_util_date_from_text`: the low two bits hold the form,
+   * above them the seconds, minutes and hours (19 bits in all) */
+  if (date >= 0 && (date & 3) == 0)
+    return date | 0x7FFFF;
+  else return date;
+}
+
+int ledger_sum_scan_as_of
+  ( struct ledger_bignum* out, struct ledger_table const* table,
+    long long int bound)
+{
+  int ok = 0;
+  unsigned char* bits;
+  struct ledger_table_field limit;
+  limit.column = 4;
+  limit.type = LEDGER_TABLE_DATE;
+  limit.id = -1;
+  limit.date = bound;
+  limit.bignum = NULL;
+  limit.text = NULL;
+  ledger_table_read_lock(table);
+  bits = (unsigned char*)ledger_util_malloc
+    (ledger_table_count_rows(table)/8+1);
+  if (bits != NULL
+  &&  ledger_table_filter_column(table, 4, NULL, 0, &limit, 1, bits) >= 0
+  &&  ledger_table_scan_column(table, 2, bits, out, NULL, NULL, NULL))
+  {
+    ok = 1;
+  }
+  ledger_table_read_unlock(table);
+  ledger_util_free(bits);
+  return ok;
+}
+
+/* END   static implementation */
+
+/* BEGIN implementation */
 
 int ledger_sum_table_column
   (struct ledger_bignum* out, struct ledger_table const* table, int column)
 {
   int ok = 0;
-  struct ledger_table_mark* mark, * end;
+  struct ledger_table_cursor cursor;
+  struct ledger_table_mark const* mark;
   struct ledger_bignum* addend;
-  mark = ledger_table_begin_c(table);
-  end = ledger_table_end_c(table);
+  struct ledger_bignum_accum* accum;
+  long long int fixed_sum = 0;
+  int fixed_place = 0;
+  /* use the running sum if the table keeps one */
+  if (ledger_table_fetch_column_aggregate(table, column, out, NULL, NULL, NULL))
+    return 1;
+  /* numeric columns sum in one pass over their cells */
+  if (ledger_table_scan_column(table, column, NULL, out, NULL, NULL, NULL))
+    return 1;
+  ledger_table_read_lock(table);
+  ledger_table_cursor_begin(&cursor, table);
+  mark = ledger_table_cursor_mark(&cursor);
   addend = ledger_bignum_new();
-  if (addend != NULL && mark != NULL && end != NULL) {
+  accum = ledger_bignum_accum_new();
+  if (addend != NULL && accum != NULL) {
     ok = 1;
-    ledger_bignum_set_long(out, 0);
-    while (!ledger_table_mark_is_equal(mark, end)){
-      ok = ledger_table_fetch_bignum(mark, column, addend);
-      if (!ok) break;
-      ok = ledger_bignum_add(out, out, addend);
+    while (!ledger_table_cursor_is_end(&cursor)){
+      long long int value;
+      int point_place;
+      if (ledger_table_fetch_fixed(mark, column, &value, &point_place)){
+        /* fast path, spilling to the accumulator on overflow */
+        if (!ledger_sum_add_fixed(&fixed_sum, &fixed_place, value, point_place))
+          ok = ledger_bignum_accum_add_fixed(accum, value, point_place);
+      } else {
+        ok = ledger_table_fetch_bignum(mark, column, addend);
+        if (ok) ok = ledger_bignum_accum_add(accum, addend);
+      }
       if (!ok) break;
-      ledger_table_mark_move(mark, +1);
+      ledger_table_cursor_move(&cursor, +1);
     }
+    /* merge the fixed-point sum, then carry once */
+    if (ok && (fixed_sum != 0 || fixed_place > 0))
+      ok = ledger_bignum_accum_add_fixed(accum, fixed_sum, fixed_place);
+    if (ok) ok = ledger_bignum_accum_get(accum, out);
   }
+  ledger_table_read_unlock(table);
+  ledger_bignum_accum_free(accum);
   ledger_bignum_free(addend);
-  ledger_table_mark_free(mark);
-  ledger_table_mark_free(end);
   return ok;
 }
+
+int ledger_sum_as_of
+  ( struct ledger_bignum* out, struct ledger_account const* account,
+    long long int date)
+{
+  int ok = 0;
+  struct ledger_table const* const table =
+    ledger_account_get_table_c(account);
+  struct ledger_table_cursor cursor;
+  struct ledger_table_mark const* mark;
+  struct ledger_bignum* addend;
+  struct ledger_bignum_accum* accum;
+  long long int const bound = ledger_sum_day_end(date);
+  /* use the prefix sums if the table keeps them */
+  if (ledger_table_fetch_column_prefix(table, 2, 4, bound, out))
+    return 1;
+  /* otherwise filter the dates, then sum the marked lines */
+  if (ledger_sum_scan_as_of(out, table, bound))
+    return 1;
+  ledger_table_read_lock(table);
+  ledger_table_cursor_begin(&cursor, table);
+  mark = ledger_table_cursor_mark(&cursor);
+  addend = ledger_bignum_new();
+  accum = ledger_bignum_accum_new();
+  if (addend != NULL && accum != NULL){
+    ok = 1;
+    while (ok && !ledger_table_cursor_is_end(&cursor)){
+      long long int line_date;
+      ok = ledger_table_fetch_date(mark, 4, &line_date);
+      if (ok && line_date <= bound){
+        ok = ledger_table_fetch_bignum(mark, 2, addend);
+        if (ok) ok = ledger_bignum_accum_add(accum, addend);
+      }
+      ledger_table_cursor_move(&cursor, +1);
+    }
+    if (ok) ok = ledger_bignum_accum_get(accum, out);
+  }
+  ledger_table_read_unlock(table);
+  ledger_bignum_accum_free(accum);
+  ledger_bignum_free(addend);
+  return ok;
+}
+
+/* END   implementation */
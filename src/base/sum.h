@@ -12,9 +12,11 @@ extern "C" {
 
 struct ledger_bignum;
 struct ledger_table;
+struct ledger_account;
 
 /*
- * Sum a column of big numbers.
+ * Sum a column of big numbers. Columns that keep aggregates
+ * (see `ledger_table_add_column_aggregate`) answer without a scan.
  * - out output number, to hold the sum
  * - table table over which to sum
  * - column column selector
@@ -23,6 +25,19 @@ struct ledger_table;
 int ledger_sum_table_column
   (struct ledger_bignum* out, struct ledger_table const* table, int column);
 
+/*
+ * Compute an account balance as of a date. Lines dated on or before
+ * the date count, as do lines with no date; a date with no time of day
+ * covers the whole day.
+ * - out output number, to hold the balance
+ * - account the account to sum
+ * - date packed date (see `ledger_util_date_from_text`)
+ * @return one on success, zero otherwise
+ */
+int ledger_sum_as_of
+  ( struct ledger_bignum* out, struct ledger_account const* account,
+    long long int date);
+
 #ifdef __cplusplus
 };
 #endif /*__cplusplus*/
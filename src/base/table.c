@@ -3,6 +3,7 @@
 #include "util.h"
 #include "bignum.h"
 #include <string.h>
+#include <stdlib.h>
 #include <limits.h>
 
 
@@ -16,12 +17,33 @@
 #  error "LEDGER_TABLE_SCHEMA_MAX too large"
 #endif /*LEDGER_TABLE_SCHEMA_MAX*/
 
+/*
+ * longest unmerged tail scanned by an ordered index lookup
+ */
+#ifndef LEDGER_TABLE_INDEX_TAIL
+#  define LEDGER_TABLE_INDEX_TAIL 32
+#endif /*LEDGER_TABLE_INDEX_TAIL*/
+
+/*
+ * cells gathered per call of a column scan kernel, when the cells
+ * do not lie in one array; a multiple of eight, so that each group
+ * starts a new byte of a row bitmap
+ */
+#ifndef LEDGER_TABLE_SCAN_GROUP
+#  define LEDGER_TABLE_SCAN_GROUP 256
+#endif /*LEDGER_TABLE_SCAN_GROUP*/
+#if (LEDGER_TABLE_SCAN_GROUP <= 0) || (LEDGER_TABLE_SCAN_GROUP%8 != 0)
+#  error "LEDGER_TABLE_SCAN_GROUP must be a positive multiple of eight"
+#endif /*LEDGER_TABLE_SCAN_GROUP*/
+
 /*
  * Row schema.
  */
 struct ledger_table_schema {
-  /* lock flag */
-  int lock_tf;
+  /* table lock, shared by every schema of the table */
+  struct ledger_util_lock* lock;
+  /* lock for caches updated by readers (mark lists and row positions) */
+  struct ledger_util_lock* cache_lock;
   /* whether the schema is outdated (0-no, 1-drop only, 2-yes)*/
   int outdated_tf;
   /* column line */
@@ -30,6 +52,56 @@ struct ledger_table_schema {
   int types[];
 };
 
+/*
+ * Special states of a cash amount
+ */
+enum ledger_table_amount_state {
+  /* no value stored */
+  LEDGER_TABLE_AMOUNT_NONE = -1,
+  /* value promoted to a full big number */
+  LEDGER_TABLE_AMOUNT_BIG = -2
+};
+
+/*
+ * Cash amount, kept inline as a fixed-point integer when it fits
+ */
+struct ledger_table_amount {
+  union {
+    /* inline value, in units of 100^(-point_place) */
+    long long int fixed;
+    /* promoted value */
+    struct ledger_bignum* bignum;
+  } value;
+  /* centesimal places of the inline value, or an amount state */
+  int point_place;
+};
+
+/*
+ * Special states of a string
+ */
+enum ledger_table_ustr_state {
+  /* length of the longest string kept inline */
+  LEDGER_TABLE_USTR_INLINE = 15,
+  /* string kept in a string pool */
+  LEDGER_TABLE_USTR_SHARED = 254,
+  /* string kept out of line, or unset */
+  LEDGER_TABLE_USTR_SPILL = 255
+};
+
+/*
+ * UTF-8 string, kept inline when short
+ */
+struct ledger_table_ustr {
+  union {
+    /* out-of-line string, or NULL if unset */
+    unsigned char* heap;
+    /* inline string; the last byte holds the unused length,
+     * or LEDGER_TABLE_USTR_SPILL for out-of-line strings,
+     * or LEDGER_TABLE_USTR_SHARED for pooled strings */
+    unsigned char text[LEDGER_TABLE_USTR_INLINE+1];
+  } value;
+};
+
 /*
  * Table item
  */
@@ -37,9 +109,25 @@ union ledger_table_item {
   /* identifier */
   int item_id;
   /* cash amount */
-  struct ledger_bignum* bignum;
+  struct ledger_table_amount amount;
+  /* UTF-8 string */
+  struct ledger_table_ustr string;
+  /* packed date, or -1 if unset */
+  long long int date;
+};
+
+/*
+ * Pointer to a table cell, or to the first cell of a column
+ */
+union ledger_table_cell {
+  /* identifier or array index */
+  int* item_id;
+  /* cash amount */
+  struct ledger_table_amount* amount;
   /* UTF-8 string */
-  unsigned char* string;
+  struct ledger_table_ustr* string;
+  /* packed date */
+  long long int* date;
 };
 
 /*
@@ -54,33 +142,353 @@ struct ledger_table_row {
   struct ledger_table_schema* schema;
   /* root flag */
   int root_tf;
+  /* cached position in the table's row index, or -1 if dropped;
+   * dropped rows leave the table at once, but keep references to
+   * their former neighbors for any marks still on them */
+  int position;
   /* data content (C99 feature) */
   union ledger_table_item data[];
 };
 
+/*
+ * Column store, used by columnar tables
+ */
+struct ledger_table_store {
+  /* row schema */
+  struct ledger_table_schema* schema;
+  /* number of rows in use */
+  int rows;
+  /* number of rows allocated for each column */
+  int capacity;
+  /* marks currently pointing into this store */
+  struct ledger_table_mark* marks;
+  /* storage for string cells, released with the store */
+  struct ledger_util_arena* strings;
+  /* per-row flags of dropped rows awaiting a vacuum, or NULL */
+  unsigned char* dead;
+  /* number of dropped rows awaiting a vacuum */
+  int dead_count;
+  /* row indexes of the live rows, or NULL if not built */
+  int* live;
+  /* contiguous cell arrays, one per column (C99 feature) */
+  unsigned char* columns[];
+};
+
+/*
+ * Hash index slot
+ */
+struct ledger_table_column_slot {
+  /* hash of the row's value */
+  unsigned int hash;
+  /* row position, or a slot state */
+  int position;
+};
+
+/*
+ * Special states of a hash index slot
+ */
+enum ledger_table_column_slot_state {
+  /* slot never used */
+  LEDGER_TABLE_SLOT_EMPTY = -1,
+  /* slot of a removed row */
+  LEDGER_TABLE_SLOT_REMOVED = -2
+};
+
+/*
+ * Secondary index on one table column. Entries are row positions,
+ * and values are read from the cells themselves. Rows added or changed
+ * since the last lookup wait in an unsorted tail until then.
+ */
+struct ledger_table_column_index {
+  /* next index of the same table */
+  struct ledger_table_column_index* next;
+  /* indexed column */
+  int column;
+  /* index kind, from `enum ledger_table_index_kind` */
+  int kind;
+  /* whether to rebuild the index before the next lookup */
+  int stale_tf;
+  /* merged row positions sorted by value (ordered indexes only) */
+  int* order;
+  /* open-addressed slots (hash indexes only) */
+  struct ledger_table_column_slot* slots;
+  /* number of merged rows */
+  int count;
+  /* number of positions or slots allocated */
+  int capacity;
+  /* number of slots used, including those of removed rows */
+  int used;
+  /* row positions added or changed since the last merge */
+  int* tail;
+  /* number of positions in the tail */
+  int tail_count;
+  /* number of positions allocated for the tail */
+  int tail_capacity;
+};
+
+/*
+ * Value of an indexed cell
+ */
+struct ledger_table_key {
+  /* identifier, array index or packed date */
+  long long int id;
+  /* UTF-8 string, with unset strings read as empty */
+  unsigned char const* text;
+};
+
+/*
+ * Running totals of one numeric table column. Unset big numbers
+ * hold no value, so they add nothing to the count or the extremes.
+ */
+struct ledger_table_column_aggregate {
+  /* next aggregate of the same table */
+  struct ledger_table_column_aggregate* next;
+  /* aggregated column */
+  int column;
+  /* whether to rescan the column before the next query */
+  int stale_tf;
+  /* whether the least or greatest value left the column */
+  int extremes_stale_tf;
+  /* number of cells holding a value */
+  int count;
+  /* sum of the values */
+  struct ledger_bignum* sum;
+  /* least value, if the count is positive */
+  struct ledger_bignum* min;
+  /* greatest value, if the count is positive */
+  struct ledger_bignum* max;
+  /* register for cell values */
+  struct ledger_bignum* value;
+};
+
+/*
+ * Prefix sums of one numeric column over rows ordered by a key column,
+ * kept as a Fenwick tree. Rows from `covered` onward wait until the
+ * next query, which appends them if their keys come last.
+ */
+struct ledger_table_column_prefix {
+  /* next prefix index of the same table */
+  struct ledger_table_column_prefix* next;
+  /* summed column */
+  int column;
+  /* key column */
+  int key_column;
+  /* whether to rebuild the tree before the next query */
+  int stale_tf;
+  /* number of leading rows in the tree */
+  int covered;
+  /* number of entries in the tree */
+  int count;
+  /* number of entries allocated */
+  int capacity;
+  /* number of tree nodes allocated */
+  int allocated;
+  /* entry keys, in ascending order */
+  long long int* keys;
+  /* tree nodes; node `i` sums the `i & -i` entries ending at entry `i` */
+  struct ledger_bignum** tree;
+  /* register for cell values */
+  struct ledger_bignum* value;
+};
+
+/*
+ * Pending row for a prefix index
+ */
+struct ledger_table_prefix_row {
+  /* key of the row */
+  long long int key;
+  /* row position */
+  int position;
+};
+
+/*
+ * State of a one-pass column scan
+ */
+struct ledger_table_scan {
+  /* column type */
+  int type;
+  /* rows to read, one bit per row position, or NULL for every row */
+  unsigned char const* bits;
+  /* bitmap to receive the rows within the bounds */
+  unsigned char* marks;
+  /* number of cells holding a value, or of rows within the bounds */
+  int count;
+  /* sum of the inline values, in units of 100^(-sum_place) */
+  long long int sum;
+  /* centesimal places of the inline sum */
+  int sum_place;
+  /* sum of the values that overflow the inline sum, or NULL if none */
+  struct ledger_bignum_accum* accum;
+  /* least value, if the count is positive */
+  struct ledger_table_amount min;
+  /* greatest value, if the count is positive */
+  struct ledger_table_amount max;
+  /* inclusive lower bound of identifier and date cells */
+  long long int low;
+  /* inclusive upper bound of identifier and date cells */
+  long long int high;
+  /* lower bound of amount cells */
+  struct ledger_table_amount low_amount;
+  /* upper bound of amount cells */
+  struct ledger_table_amount high_amount;
+  /* least comparison with `low_amount` to accept, or -1 for no bound */
+  int low_least;
+  /* greatest comparison with `high_amount` to accept, or +1 for no bound */
+  int high_most;
+  /* registers for amounts that do not fit inline */
+  struct ledger_bignum* registers[2];
+};
+
+/*
+ * Column scan kernel.
+ * - sc the scan state
+ * - cells the first of a run of cells, in row order
+ * - position row position of the first cell, a multiple of eight
+ * - n number of cells in the run
+ * @return one on success, zero otherwise
+ */
+typedef int (*ledger_table_scan_cb)
+  ( struct ledger_table_scan* sc, union ledger_table_cell cells,
+    int position, int n);
+
+/*
+ * Pooled string
+ */
+struct ledger_table_pool_entry {
+  /* next entry in the same bucket */
+  struct ledger_table_pool_entry* next;
+  /* pool holding the entry */
+  struct ledger_table_pool* pool;
+  /* number of cells holding the string */
+  int refs;
+  /* hash of the string */
+  unsigned int hash;
+  /* length of the string in bytes */
+  int length;
+  /* NUL-terminated text (C99 feature) */
+  unsigned char text[];
+};
+
+/*
+ * Actualization of the string pool
+ */
+struct ledger_table_pool {
+  /* lock for the buckets and reference counts */
+  struct ledger_util_lock* lock;
+  /* hash buckets; the count is a power of two */
+  struct ledger_table_pool_entry** buckets;
+  /* number of buckets */
+  int bucket_count;
+  /* number of distinct strings */
+  int count;
+};
+
+/*
+ * Registered table observer
+ */
+struct ledger_table_observer {
+  /* next observer of the same table */
+  struct ledger_table_observer* next;
+  /* callback, or NULL once dropped during a notification */
+  ledger_table_observer_cb cb;
+  /* callback argument */
+  void* arg;
+};
+
+/*
+ * Observers of a table, kept by the private copies that copy-on-write
+ * makes of the table
+ */
+struct ledger_table_observer_list {
+  /* lock for the list, held through notifications */
+  struct ledger_util_lock* lock;
+  /* first observer */
+  struct ledger_table_observer* first;
+  /* number of notifications in progress */
+  int depth;
+};
+
 /*
  * Actualization of the table structure
  */
 struct ledger_table {
-  /* lock value */
-  int lock_tf;
+  /* table lock */
+  struct ledger_util_lock* lock;
+  /* lock for caches updated by readers */
+  struct ledger_util_lock* cache_lock;
   /* column schema */
   struct ledger_table_schema *schema;
   /* row count cache */
   int rows;
   /* double-linked list of table rows */
   struct ledger_table_row *root;
+  /* column store (columnar tables only) */
+  struct ledger_table_store *store;
+  /* whether dropped rows wait for a vacuum to leave the storage */
+  int tombstones_tf;
+  /* row position index (linked tables only), or NULL if not built */
+  struct ledger_table_row **positions;
+  /* number of rows in the position index */
+  int position_count;
+  /* number of rows allocated for the position index */
+  int position_capacity;
+  /* rows from this position onward may have stale cached positions */
+  int position_stale;
+  /* number of extra owners sharing the table */
+  int shares;
+  /* secondary column indexes */
+  struct ledger_table_column_index* column_indexes;
+  /* running column aggregates */
+  struct ledger_table_column_aggregate* column_aggregates;
+  /* key-ordered prefix sums */
+  struct ledger_table_column_prefix* column_prefixes;
+  /* sum of the hashes of all set cells */
+  unsigned long long int fingerprint;
+  /* whether to rescan the cells before the next fingerprint query */
+  int fingerprint_stale_tf;
+  /* pool for long strings, or NULL */
+  struct ledger_table_pool* pool;
+  /* change observers, or NULL if none were ever added */
+  struct ledger_table_observer_list* observers;
 };
 
+/*
+ * NOTE Locking: each table has one shared/exclusive lock, which its
+ * schemata also hold so that marks can outlive the table. Functions that
+ * change rows or cells hold the lock exclusive, and functions that only
+ * read hold it shared. Readers may still update a few caches: the list of
+ * marks attached to a column store, the row position index, the
+ * secondary column indexes, the column aggregates and the prefix
+ * sums. Those
+ * updates happen under the shared lock plus the cache lock.
+ */
+
 /*
  * Table row iterator.
  */
 struct ledger_table_mark {
   struct ledger_table const* source;
+  /* current row (linked tables only) */
   struct ledger_table_row* row;
+  /* column store (columnar tables only) */
+  struct ledger_table_store* store;
+  /* row index in the column store, or -1 for the end of the table */
+  int index;
+  /* links to other marks registered with the same store */
+  struct ledger_table_mark* prev_mark;
+  struct ledger_table_mark* next_mark;
   unsigned char mutable_flag;
+  /* whether the mark is a cursor, holding no references */
+  unsigned char borrowed_tf;
 };
 
+/*
+ * Compile-time check that a cursor can hold a mark.
+ */
+typedef char ledger_table_cursor_size_check
+  [(sizeof(struct ledger_table_mark) <= sizeof(struct ledger_table_cursor))
+    ? 1 : -1];
+
 /*
  * Callback for cleaning up a table.
  * - t pointer to a table
@@ -90,9 +498,10 @@ static void ledger_table_free_cb(void* t);
 /*
  * Initialize a table.
  * - t table to initialize
+ * - columnar_tf nonzero to use a column store instead of linked rows
  * @return one on success, zero on failure
  */
-static int ledger_table_init(struct ledger_table* t);
+static int ledger_table_init(struct ledger_table* t, int columnar_tf);
 
 /*
  * Clear out a table.
@@ -103,17 +512,21 @@ static void ledger_table_clear(struct ledger_table* t);
 /*
  * Lock a table for modification.
  * - t table to lock
- * @return one on success, zero on failure
  */
 static void ledger_table_lock(struct ledger_table const* t);
 
 /*
- * Lock two table schemata simultaneously for modification.
+ * Lock a table for reading.
+ * - t table to lock
+ */
+static void ledger_table_lock_shared(struct ledger_table const* t);
+
+/*
+ * Lock two table schemata simultaneously for reading.
  * - t first table schema to lock
  * - t2 second table schema to lock
- * @return one on success, zero on failure
  */
-static void ledger_table_schema_lock2
+static void ledger_table_schema_lock_shared2
   (struct ledger_table_schema const* t, struct ledger_table_schema const* t2);
 
 /*
@@ -122,511 +535,4582 @@ static void ledger_table_schema_lock2
  */
 static void ledger_table_unlock(struct ledger_table const* t);
 
+/*
+ * Unlock a table for reading.
+ * - t table to unlock
+ */
+static void ledger_table_unlock_shared(struct ledger_table const* t);
+
 /*
  * Construct a new mark.
  * - t table to use
- * - row row pointer
+ * - row row pointer (linked tables)
+ * - index row index (columnar tables)
  * @return the mark on success, NULL otherwise
  */
 static struct ledger_table_mark* ledger_table_mark_new
   ( struct ledger_table const* t, struct ledger_table_row const* r,
-    int mutable_flag);
+    int index, int mutable_flag);
 
 /*
  * Construct a new mark in place.
  * - t table to use
- * - row row pointer
+ * - row row pointer (linked tables)
+ * - index row index (columnar tables)
  * - mutable_flag whether the mark should be allowed to modify the table
  * - ptr pointer to the mark structrue
  * @return one on success, zero otherwise
  */
 static int ledger_table_mark_init
   ( struct ledger_table const* t, struct ledger_table_row const* r,
-    int mutable_flag, struct ledger_table_mark* ptr);
+    int index, int mutable_flag, struct ledger_table_mark* ptr);
 
 /*
- * Clear a mark.
- * - m the mark to clear
+ * Get the schema for the rows a mark can visit.
+ * - mark the mark to query
+ * @return the schema
  */
-void ledger_table_mark_clear(struct ledger_table_mark* m);
+static struct ledger_table_schema* ledger_table_mark_schema
+  (struct ledger_table_mark const* mark);
 
 /*
- * Clear a mark.
- * - m the mark to clear
+ * Check whether a mark points to the end of the table.
+ * - mark the mark to query
+ * @return one if the mark is at the end, zero otherwise
  */
-void ledger_table_mark_free_cb(void* m);
+static int ledger_table_mark_at_end(struct ledger_table_mark const* mark);
 
 /*
- * Construct a row given a schema.
- * - schema array of data types
- * @return the row on success
+ * Locate a cell in the row referenced by a mark.
+ * - mark the mark to use
+ * - i column index
+ * - cell cell pointer to fill
+ * @return the column type, or zero if the cell is unavailable
  */
-static struct ledger_table_row* ledger_table_row_new
-  (struct ledger_table_schema const* schema);
+static int ledger_table_mark_cell
+  ( struct ledger_table_mark const* mark, int i,
+    union ledger_table_cell* cell);
 
 /*
- * Destroy a row.
- * - r row to free
+ * Locate a cell in a row.
+ * - row the row to use
+ * - i column index
+ * - cell cell pointer to fill
+ * @return the column type, or zero if the cell is unavailable
  */
-static void ledger_table_row_free
-  (struct ledger_table_row* r);
+static int ledger_table_row_cell
+  ( struct ledger_table_row* row, int i, union ledger_table_cell* cell);
 
 /*
- * Destroy the contents of a row given a schema.
- * - r row to clear
- * - n row length
- * - schema array of data types
+ * Query the centesimal places held by an amount.
+ * - a the amount to query
+ * @return a count of centesimal places
  */
-static void ledger_table_row_clear
-  (struct ledger_table_row* r, int n, int const* schema);
+static int ledger_table_amount_point(struct ledger_table_amount const* a);
 
 /*
- * Callback for row destruction.
- * - ptr pointer to row structure
+ * Scale a fixed-point value to more centesimal places.
+ * - value the value to scale
+ * - from current number of centesimal places
+ * - to target number of centesimal places, at least `from`
+ * @return one on success, zero on overflow
  */
-static void ledger_table_row_free_cb(void* ptr);
+static int ledger_table_amount_scale(long long int* value, int from, int to);
 
 /*
- * Acquire a reference to a row.
- * - r target row
- * @return the row on success, NULL otherwise
+ * Put a fixed-point value to an amount, keeping the amount's
+ * centesimal places as the big number assignments do.
+ * - a the amount to modify
+ * - value fixed-point value
+ * - point_place centesimal places of the value
+ * @return one if the value was stored inline, zero if it does not fit
  */
-static struct ledger_table_row* ledger_table_row_acquire
-  (struct ledger_table_row* r);
+static int ledger_table_amount_put_fixed
+  (struct ledger_table_amount* a, long long int value, int point_place);
 
+/*
+ * Promote an amount to a full big number.
+ * - a the amount to promote
+ * @return the big number on success, NULL otherwise
+ */
+static struct ledger_bignum* ledger_table_amount_promote
+  (struct ledger_table_amount* a);
 
 /*
- * Drop all rows from a table.
- * - table table to clear out
+ * Load an amount into a big number, as `ledger_bignum_assign` would.
+ * Unset amounts load as zero.
+ * - n the number to modify
+ * - a the amount to read
+ * @return one on success, zero otherwise
  */
-static void ledger_table_drop_all_rows(struct ledger_table* table);
+static int ledger_table_amount_fetch
+  (struct ledger_bignum* n, struct ledger_table_amount const* a);
 
 /*
- * Construct a new table schema.
- * - columns number of columns to use
- * @return the schema on success, NULL otherwise
+ * Compare two amounts. Unset amounts compare as zero.
+ * - a one amount
+ * - b another amount
+ * @return one if equal, zero otherwise
  */
-static struct ledger_table_schema* ledger_table_schema_new
-  (int columns, int const* types);
+static int ledger_table_amount_is_equal
+  (struct ledger_table_amount const* a, struct ledger_table_amount const* b);
 
 /*
- * Acquire a table schema.
- * - sch the schema to acquire
- * @return the schema on success, NULL otherwise
+ * Compare two amounts. Unset amounts compare as zero.
+ * - a one amount
+ * - b another amount
+ * - registers two numbers to hold amounts that do not fit inline
+ * - sign integer to receive -1 if `a` is less than `b`, zero if
+ *   equal, or +1 if greater
+ * @return one on success, zero otherwise
  */
-static struct ledger_table_schema* ledger_table_schema_acquire
-  (struct ledger_table_schema* sch);
+static int ledger_table_amount_compare
+  ( struct ledger_table_amount const* a, struct ledger_table_amount const* b,
+    struct ledger_bignum* registers[2], int* sign);
 
 /*
- * Clear out a schema.
- * - sch the schema to clear
+ * Initialize a cell to its empty value.
+ * - type column type
+ * - cell the cell to initialize
  */
-static void ledger_table_schema_clear(struct ledger_table_schema* sch);
+static void ledger_table_cell_init(int type, union ledger_table_cell cell);
 
 /*
- * Release a schema.
- * - sch the schema to release
+ * Release the contents of a cell.
+ * - type column type
+ * - cell the cell to clear
  */
-static void ledger_table_schema_free(struct ledger_table_schema* sch);
+static void ledger_table_cell_clear(int type, union ledger_table_cell cell);
 
 /*
- * Compare two schemata for equality.
- * - a one schema
- * - b another schema
- * @return nonzero if the schemata are equal, zero otherwise
+ * Compare two cells of the same type.
+ * - type column type
+ * - a one cell
+ * - b another cell
+ * @return one if the cells are equal, zero otherwise
  */
-int ledger_table_schema_is_equal
-  (struct ledger_table_schema const* a, struct ledger_table_schema const* b);
+static int ledger_table_cell_is_equal
+  (int type, union ledger_table_cell a, union ledger_table_cell b);
 
 /*
- * Recursively lock a table schema for modification of rows.
- * - t table schema to lock
+ * Copy a cell into an empty cell of the same type.
+ * - mark the mark pointing to the destination cell's row
+ * - type column type
+ * - dst the cell to fill
+ * - src the cell to copy
+ * @return one on success, zero otherwise
  */
-static void ledger_table_schema_lock(struct ledger_table_schema const* t);
+static int ledger_table_cell_copy
+  ( struct ledger_table_mark const* mark, int type,
+    union ledger_table_cell dst, union ledger_table_cell src);
 
 /*
- * Outdate a table schema.
- * - t table schema
- * @return whether the caller acquired closing rights
+ * Query the size of a single cell in a column store.
+ * - type column type
+ * @return a size in bytes
  */
-static int ledger_table_schema_outdate(struct ledger_table_schema* t);
+static size_t ledger_table_cell_size(int type);
 
 /*
- * Check whether a schema is outdated.
- * - t table schema to query
- * @return one if the schema is outdated, zero otherwise
+ * Read the string held by a cell.
+ * - s the string cell to read
+ * @return the string, or NULL if unset
  */
-int ledger_table_schema_is_outdated(struct ledger_table_schema const* t);
+static unsigned char const* ledger_table_ustr_get
+  (struct ledger_table_ustr const* s);
 
 /*
- * Unlock a table schema for modification.
- * - t table schema to unlock
+ * Mark a string cell as unset, without releasing its contents.
+ * - s the string cell to reset
  */
-static void ledger_table_schema_unlock(struct ledger_table_schema const* t);
+static void ledger_table_ustr_reset(struct ledger_table_ustr* s);
 
 /*
- * Close a schema from further modification.
- * - t the schema to close
+ * Get space for a new string in a cell. The space becomes the
+ * cell's string, so the caller must fill it in completely.
+ * - mark the mark pointing to the cell's row
+ * - s the string cell to modify
+ * - len length of the new string, not including the NUL terminator
+ * @return space for `len+1` bytes on success, otherwise NULL
  */
-void ledger_table_schema_close(struct ledger_table_schema* t);
+static unsigned char* ledger_table_mark_string_reserve
+  (struct ledger_table_mark const* mark, struct ledger_table_ustr* s,
+    size_t len);
 
 /*
- * Subroutine for table row insertion.
- * - mark mark pointing to the neighboring row
- * @return one on success, zero otherwise
+ * Release the string held by a cell, leaving the cell unset.
+ * - mark the mark pointing to the cell's row
+ * - s the string cell to release
  */
-static int ledger_table_add_row_sub(struct ledger_table_mark* mark);
+static void ledger_table_mark_string_release
+  (struct ledger_table_mark const* mark, struct ledger_table_ustr* s);
 
 /*
- * Subroutine for table row deletion.
- * - mark mark pointing to the row to delete
+ * Put a string to a cell, sharing it through the table's string pool
+ * when the table has one and the string does not fit inline.
+ * - mark the mark pointing to the cell's row
+ * - s the string cell to modify
+ * - text the new string
+ * - len length of the new string, not including the NUL terminator
  * @return one on success, zero otherwise
  */
-static int ledger_table_drop_row_sub(struct ledger_table_mark* mark);
+static int ledger_table_mark_string_put
+  ( struct ledger_table_mark const* mark, struct ledger_table_ustr* s,
+    unsigned char const* text, size_t len);
 
 /*
- * Subroutine for fetching strings from a field.
- * - mark mark pointing to the row to read
- * - i field index
- * - buf output buffer
- * - len length of buffer in bytes
- * @return one on success, zero otherwise
+ * Destroy a string pool.
+ * - p the pool to destroy
  */
-static int ledger_table_fetch_string_sub
-  (struct ledger_table_mark const* mark, int i, unsigned char* buf, int len);
+static void ledger_table_pool_free_cb(void* p);
 
 /*
- * Subroutine for putting identifiers to a field.
- * - mark mark pointing to the row to write
- * - i field index
- * - value identifier to put
- * @return one on success, zero otherwise
+ * Look up or add a string in a pool.
+ * - p the pool to use
+ * - text the string
+ * - len length of the string, not including the NUL terminator
+ * @return the pooled text, with a new reference, or NULL on failure
  */
-static int ledger_table_put_id_sub
-  ( struct ledger_table_mark const* mark, int i, int value);
+static unsigned char* ledger_table_pool_intern
+  ( struct ledger_table_pool* p, unsigned char const* text, size_t len);
 
 /*
- * Subroutine for fetching identifiers from a field.
- * - mark mark pointing to the row to read
- * - i field index
- * - n place to stored the fetched identifier
- * @return one on success, zero otherwise
+ * Take another reference to a pooled string.
+ * - text the pooled text
  */
-static int ledger_table_fetch_id_sub
-  (struct ledger_table_mark const* mark, int i, int* n);
+static void ledger_table_pool_share(unsigned char* text);
 
 /*
- * Subroutine for putting big numbers to a field.
- * - mark mark pointing to the row to write
- * - i field index
- * - value number to put
- * @return one on success, zero otherwise
+ * Release a reference to a pooled string.
+ * - text the pooled text
  */
-static int ledger_table_put_bignum_sub
-  ( struct ledger_table_mark const* mark, int i,
-    struct ledger_bignum const* value);
+static void ledger_table_pool_release(unsigned char* text);
 
 /*
- * Subroutine for fetching big numbers from a field.
- * - mark mark pointing to the row to read
- * - i field index
- * - n place to stored the fetched number
- * @return one on success, zero otherwise
+ * Find the pool entry of a pooled string.
+ * - text the pooled text
+ * @return the entry
  */
-static int ledger_table_fetch_bignum_sub
-  (struct ledger_table_mark const* mark, int i, struct ledger_bignum* n);
+static struct ledger_table_pool_entry* ledger_table_pool_entry_of
+  (unsigned char const* text);
 
 /*
- * Subroutine for putting strings to a field.
- * - mark mark pointing to the row to write
- * - i field index
- * - value string to put
- * @return one on success, zero otherwise
+ * Release the contents of a column store cell.
+ * - type column type
+ * - cell the cell to clear
  */
-static int ledger_table_put_string_sub
-  (struct ledger_table_mark const* mark, int i, unsigned char const* value);
+static void ledger_table_store_cell_clear
+  (int type, union ledger_table_cell cell);
 
 /*
- * Exchange mark pointer.
- * - mark the mark to edit
- * - new_row the new row
+ * Construct a new column store.
+ * - schema row schema to use
+ * @return the store on success, NULL otherwise
  */
-static void ledger_table_mark_exchange
-  (struct ledger_table_mark *mark, struct ledger_table_row* new_row);
+static struct ledger_table_store* ledger_table_store_new
+  (struct ledger_table_schema* schema);
 
 /*
- * Add one to the mark, ensuring that the mark is still valid.
- * - m the mark to advance
- * @return one on success, zero if the mark is caught
+ * Acquire a column store.
+ * - s the store to acquire
+ * @return the store on success, NULL otherwise
  */
-static int ledger_table_mark_add_one_checked(struct ledger_table_mark* m);
+static struct ledger_table_store* ledger_table_store_acquire
+  (struct ledger_table_store* s);
 
-/* BEGIN static implementation */
+/*
+ * Release a column store.
+ * - s the store to release
+ */
+static void ledger_table_store_free(struct ledger_table_store* s);
 
-void ledger_table_lock(struct ledger_table const* t){
-  ((struct ledger_table*)t)->lock_tf += 1;
-  return;
-}
+/*
+ * Callback for column store destruction.
+ * - ptr pointer to column store
+ */
+static void ledger_table_store_free_cb(void* ptr);
 
-void ledger_table_unlock(struct ledger_table const* t){
-  ((struct ledger_table*)t)->lock_tf -= 1;
-  return;
-}
+/*
+ * Ensure that a column store can hold a number of rows.
+ * - s the store to extend
+ * - n the required number of rows
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_store_reserve(struct ledger_table_store* s, int n);
 
-void ledger_table_free_cb(void* t){
-  ledger_table_clear((struct ledger_table*) t);
-  return;
+/*
+ * Locate a cell in a column store.
+ * - s the store to use
+ * - i column index
+ * - index row index
+ * - cell cell pointer to fill
+ * @return the column type
+ */
+static int ledger_table_store_cell
+  ( struct ledger_table_store const* s, int i, int index,
+    union ledger_table_cell* cell);
+
+/*
+ * Insert an empty row into a column store.
+ * - s the store to modify
+ * - index position of the new row
+ * - mark the mark performing the insertion
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_store_insert
+  (struct ledger_table_store* s, int index, struct ledger_table_mark* mark);
+
+/*
+ * Remove a row from a column store.
+ * - s the store to modify
+ * - index position of the row to remove
+ */
+static void ledger_table_store_erase(struct ledger_table_store* s, int index);
+
+/*
+ * Drop a row from a column store, leaving a tombstone in its place.
+ * The row's cells are released at once, and its slot at the next vacuum.
+ * - s the store to modify
+ * - index position of the row to drop
+ * - mark the mark performing the drop
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_store_bury
+  (struct ledger_table_store* s, int index, struct ledger_table_mark* mark);
+
+/*
+ * Find the nearest live row of a column store.
+ * - s the store to search
+ * - index row index to start from
+ * - n direction of the search, +1 or -1
+ * @return the first live row at or past `index` in that direction,
+ *   or -1 for the end of the table
+ */
+static int ledger_table_store_live_row
+  (struct ledger_table_store const* s, int index, int n);
+
+/*
+ * Move a row index of a column store over a number of live rows.
+ * - s the store to use
+ * - index row index to move, or -1 for the end of the table
+ * - n number of rows to move
+ * @return the new row index, or -1 for the end of the table
+ */
+static int ledger_table_store_move
+  (struct ledger_table_store const* s, int index, int n);
+
+/*
+ * Build the list of live rows of a column store. Callers hold the
+ * table lock exclusive, or shared along with the cache lock.
+ * - s the store to use
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_store_live_build(struct ledger_table_store* s);
+
+/*
+ * Compute the table position of a column store row. A tombstone
+ * shares the position of the next live row.
+ * - s the store to use
+ * - index row index, or -1 for the end of the table
+ * @return the position on success, -1 otherwise
+ */
+static int ledger_table_store_position
+  (struct ledger_table_store* s, int index);
+
+/*
+ * Find the column store row at a table position.
+ * - s the store to use
+ * - position table position, up to the number of live rows
+ * - index row index to fill, with -1 for the end of the table
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_store_locate
+  (struct ledger_table_store* s, int position, int* index);
+
+/*
+ * Move the out-of-line strings of a column store into a fresh arena,
+ * one column after another in row order.
+ * - s the store to modify
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_store_repack(struct ledger_table_store* s);
+
+/*
+ * Move the live rows of a column store over its tombstones.
+ * - s the store to compact
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_store_vacuum(struct ledger_table_store* s);
+
+/*
+ * Register a mark with a column store.
+ * - s the store
+ * - mark the mark to register
+ */
+static void ledger_table_store_attach_mark
+  (struct ledger_table_store* s, struct ledger_table_mark* mark);
+
+/*
+ * Unregister a mark from a column store.
+ * - s the store
+ * - mark the mark to unregister
+ */
+static void ledger_table_store_detach_mark
+  (struct ledger_table_store* s, struct ledger_table_mark* mark);
+
+/*
+ * Clear a mark.
+ * - m the mark to clear
+ */
+void ledger_table_mark_clear(struct ledger_table_mark* m);
+
+/*
+ * Clear a mark.
+ * - m the mark to clear
+ */
+void ledger_table_mark_free_cb(void* m);
+
+/*
+ * Construct a row given a schema.
+ * - schema array of data types
+ * @return the row on success
+ */
+static struct ledger_table_row* ledger_table_row_new
+  (struct ledger_table_schema const* schema);
+
+/*
+ * Destroy a row.
+ * - r row to free
+ */
+static void ledger_table_row_free
+  (struct ledger_table_row* r);
+
+/*
+ * Destroy the contents of a row given a schema.
+ * - r row to clear
+ * - n row length
+ * - schema array of data types
+ */
+static void ledger_table_row_clear
+  (struct ledger_table_row* r, int n, int const* schema);
+
+/*
+ * Take a row out of its table, keeping references to its neighbors.
+ * - r row to detach
+ */
+static void ledger_table_row_detach(struct ledger_table_row* r);
+
+/*
+ * Callback for row destruction.
+ * - ptr pointer to row structure
+ */
+static void ledger_table_row_free_cb(void* ptr);
+
+/*
+ * Acquire a reference to a row.
+ * - r target row
+ * @return the row on success, NULL otherwise
+ */
+static struct ledger_table_row* ledger_table_row_acquire
+  (struct ledger_table_row* r);
+
+
+/*
+ * Drop all rows from a table.
+ * - table table to clear out
+ */
+static void ledger_table_drop_all_rows(struct ledger_table* table);
+
+/*
+ * Build the row position index of a linked table, if not yet built.
+ * - t the table to index
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_index_build(struct ledger_table* t);
+
+/*
+ * Release the row position index of a linked table.
+ * - t the table to modify
+ */
+static void ledger_table_index_release(struct ledger_table* t);
+
+/*
+ * Find the position of a row in the row position index.
+ * - t the table to query
+ * - r the row to find
+ * @return the row's position, or -1 if the row is not in the index
+ */
+static int ledger_table_index_find
+  (struct ledger_table* t, struct ledger_table_row* r);
+
+/*
+ * Add a new row to the row position index, if the index is built.
+ * - t the table to modify
+ * - r the new row
+ * - next the row just after the new row
+ */
+static void ledger_table_index_insert
+  ( struct ledger_table* t, struct ledger_table_row* r,
+    struct ledger_table_row* next);
+
+/*
+ * Remove a row from the row position index, if the index is built.
+ * - t the table to modify
+ * - r the row to remove
+ */
+static void ledger_table_index_erase
+  (struct ledger_table* t, struct ledger_table_row* r);
+
+/*
+ * Read the value of an indexed cell.
+ * - t the table to read, with its row position index built if linked
+ * - column column to read
+ * - position row position
+ * - key value to fill
+ * @return the column type on success, zero otherwise
+ */
+static int ledger_table_key_at
+  ( struct ledger_table const* t, int column, int position,
+    struct ledger_table_key* key);
+
+/*
+ * Compare two indexed values.
+ * - type column type
+ * - a a value
+ * - b another value
+ * @return negative if `a` sorts first, positive if `b` sorts first,
+ *   zero if equal
+ */
+static int ledger_table_key_compare
+  ( int type, struct ledger_table_key const* a,
+    struct ledger_table_key const* b);
+
+/*
+ * Hash an indexed value.
+ * - type column type
+ * - key value to hash
+ * @return a hash code
+ */
+static unsigned int ledger_table_key_hash
+  (int type, struct ledger_table_key const* key);
+
+/*
+ * Check whether an indexed value lies within a range.
+ * - type column type
+ * - key value to check
+ * - low lower bound, or NULL for none
+ * - low_inclusive_tf nonzero to accept values equal to the lower bound
+ * - high upper bound, or NULL for none
+ * - high_inclusive_tf nonzero to accept values equal to the upper bound
+ * @return one if within range, zero otherwise
+ */
+static int ledger_table_key_in_range
+  ( int type, struct ledger_table_key const* key,
+    struct ledger_table_key const* low, int low_inclusive_tf,
+    struct ledger_table_key const* high, int high_inclusive_tf);
+
+/*
+ * Compare two rows by the value of an indexed column, then by position.
+ * - t the table to read
+ * - ci the column index
+ * - a a row position
+ * - b another row position
+ * @return negative if `a` sorts first, positive if `b` sorts first,
+ *   zero if the same row
+ */
+static int ledger_table_key_order
+  ( struct ledger_table const* t,
+    struct ledger_table_column_index const* ci, int a, int b);
+
+/*
+ * Sort row positions by the value of an indexed column.
+ * - t the table to read
+ * - ci the column index
+ * - a positions to sort
+ * - n number of positions
+ * - tmp scratch space for `n` positions
+ */
+static void ledger_table_key_sort
+  ( struct ledger_table const* t,
+    struct ledger_table_column_index const* ci, int* a, int n, int* tmp);
+
+/*
+ * Compare two row positions, for `qsort`.
+ * - a a position
+ * - b another position
+ * @return negative, zero or positive
+ */
+static int ledger_table_position_compare(void const* a, void const* b);
+
+/*
+ * Allocate an array of row positions.
+ * - n number of positions
+ * @return the array on success, NULL otherwise
+ */
+static int* ledger_table_position_alloc(int n);
+
+/*
+ * Count the rows of a table, building the row position index
+ *   of a linked table if needed.
+ * - t the table to query
+ * @return the row count, or -1 on failure
+ */
+static int ledger_table_position_count(struct ledger_table* t);
+
+/*
+ * Find the row position of a mark, building the row position index
+ *   of a linked table if needed.
+ * - mark the mark to query
+ * @return the row position, the row count for the end of the table,
+ *   or -1 if the row is not in the table or on failure
+ */
+static int ledger_table_mark_position(struct ledger_table_mark const* mark);
+
+/*
+ * Find the secondary index on a column.
+ * - t the table to query
+ * - column column to find
+ * @return the index if available, otherwise NULL
+ */
+static struct ledger_table_column_index* ledger_table_column_index_find
+  (struct ledger_table const* t, int column);
+
+/*
+ * Drop the entries of a secondary index, leaving it to be rebuilt.
+ * - ci the index to reset
+ */
+static void ledger_table_column_index_reset
+  (struct ledger_table_column_index* ci);
+
+/*
+ * Destroy a secondary index.
+ * - ci the index to free
+ */
+static void ledger_table_column_index_free
+  (struct ledger_table_column_index* ci);
+
+/*
+ * Destroy all secondary indexes of a table.
+ * - t the table to modify
+ */
+static void ledger_table_column_index_release(struct ledger_table* t);
+
+/*
+ * Rebuild a secondary index from the table's cells.
+ * - t the table to read
+ * - ci the index to rebuild
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_column_index_build
+  (struct ledger_table* t, struct ledger_table_column_index* ci);
+
+/*
+ * Add a row position to the tail of a secondary index. Indexes
+ *   whose tail outgrows the merged part are left to be rebuilt.
+ * - ci the index to modify
+ * - position row position to add
+ */
+static void ledger_table_column_index_push
+  (struct ledger_table_column_index* ci, int position);
+
+/*
+ * Add a row to the slots of a hash index.
+ * - t the table to read
+ * - ci the index to modify
+ * - position row position to add
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_column_index_slot_put
+  ( struct ledger_table const* t, struct ledger_table_column_index* ci,
+    int position);
+
+/*
+ * Merge the tail of a secondary index into its merged part.
+ * - t the table to read
+ * - ci the index to modify
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_column_index_merge
+  (struct ledger_table const* t, struct ledger_table_column_index* ci);
+
+/*
+ * Remove a row from the merged part of a secondary index, while the
+ *   row still holds the value it was merged with.
+ * - t the table to read
+ * - ci the index to modify
+ * - position row position to remove
+ * @return one if the row was merged, zero otherwise
+ */
+static int ledger_table_column_index_detach
+  ( struct ledger_table const* t, struct ledger_table_column_index* ci,
+    int position);
+
+/*
+ * Move the row positions of a secondary index.
+ * - ci the index to modify
+ * - from first position to move
+ * - n distance to move
+ */
+static void ledger_table_column_index_shift
+  (struct ledger_table_column_index* ci, int from, int n);
+
+/*
+ * Update the secondary indexes of a table before a cell changes.
+ * - mark mark on the row to change
+ * - column column to change
+ */
+static void ledger_table_column_index_note_put
+  (struct ledger_table_mark const* mark, int column);
+
+/*
+ * Update the secondary indexes of a table after a row is added.
+ * - t the table to modify
+ * - position position of the new row, or -1 if unknown
+ * - at_end_tf nonzero if the row was added after all others
+ */
+static void ledger_table_column_index_note_add
+  (struct ledger_table* t, int position, int at_end_tf);
+
+/*
+ * Update the secondary indexes of a table before a row is dropped.
+ * - t the table to modify
+ * - position position of the row to drop, or -1 if unknown
+ */
+static void ledger_table_column_index_note_drop
+  (struct ledger_table* t, int position);
+
+/*
+ * Look up rows through a secondary index.
+ * - t the table to read
+ * - ci the index to use
+ * - type column type
+ * - low lower bound, or NULL for none
+ * - low_inclusive_tf nonzero to accept values equal to the lower bound
+ * - high upper bound, or NULL for none
+ * - high_inclusive_tf nonzero to accept values equal to the upper bound
+ * - positions array to receive the matching row positions
+ * @return the number of matching rows, or -1 on failure
+ */
+static int ledger_table_column_index_lookup
+  ( struct ledger_table* t, struct ledger_table_column_index* ci,
+    int type, struct ledger_table_key const* low, int low_inclusive_tf,
+    struct ledger_table_key const* high, int high_inclusive_tf,
+    int** positions);
+
+/*
+ * Find the aggregate of a column.
+ * - t table to search
+ * - column the column
+ * @return the aggregate, or NULL if the column has none
+ */
+static struct ledger_table_column_aggregate* ledger_table_column_aggregate_find
+  (struct ledger_table const* t, int column);
+
+/*
+ * Free a column aggregate.
+ * - ca the aggregate to free
+ */
+static void ledger_table_column_aggregate_free
+  (struct ledger_table_column_aggregate* ca);
+
+/*
+ * Free all column aggregates of a table.
+ * - t the table
+ */
+static void ledger_table_column_aggregate_release(struct ledger_table* t);
+
+/*
+ * Read a cell as a number for an aggregate.
+ * - mark the row to read
+ * - column the column to read
+ * - n number to receive the value
+ * @return one if the cell holds a value, zero if it holds none,
+ *   or -1 on failure
+ */
+static int ledger_table_column_aggregate_value
+  (struct ledger_table_mark const* mark, int column, struct ledger_bignum* n);
+
+/*
+ * Account for a value entering or leaving an aggregate.
+ * - ca the aggregate to update
+ * - n the value
+ * - direction positive if the value enters, negative if it leaves
+ * @return one on success, zero on failure
+ */
+static int ledger_table_column_aggregate_apply
+  ( struct ledger_table_column_aggregate* ca, struct ledger_bignum const* n,
+    int direction);
+
+/*
+ * Scan a column to rebuild its aggregate.
+ * - t the table
+ * - ca the aggregate to rebuild
+ * @return one on success, zero on failure
+ */
+static int ledger_table_column_aggregate_build
+  (struct ledger_table const* t, struct ledger_table_column_aggregate* ca);
+
+/*
+ * Account for a cell entering or leaving the column aggregates.
+ * Call with a negative direction before changing the cell, and
+ * with a positive direction after.
+ * - mark the row of the cell
+ * - column the column of the cell
+ * - direction positive if the cell enters, negative if it leaves
+ */
+static void ledger_table_column_aggregate_note
+  (struct ledger_table_mark const* mark, int column, int direction);
+
+/*
+ * Account for a row entering or leaving the column aggregates.
+ * - mark the row
+ * - direction positive if the row enters, negative if it leaves
+ */
+static void ledger_table_column_aggregate_note_row
+  (struct ledger_table_mark const* mark, int direction);
+
+/*
+ * Prepare a column scan.
+ * - sc the scan state to initialize
+ * - type column type
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_scan_init(struct ledger_table_scan* sc, int type);
+
+/*
+ * Release the resources of a column scan.
+ * - sc the scan state
+ */
+static void ledger_table_scan_clear(struct ledger_table_scan* sc);
+
+/*
+ * Add a fixed-point value to the sum of a column scan.
+ * - sc the scan state
+ * - value the addend
+ * - point_place centesimal places of the addend
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_scan_add_fixed
+  (struct ledger_table_scan* sc, long long int value, int point_place);
+
+/*
+ * Account for an amount in the extremes of a column scan, before
+ * the amount joins the count.
+ * - sc the scan state
+ * - a the amount
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_scan_note_extremes
+  (struct ledger_table_scan* sc, struct ledger_table_amount const* a);
+
+/*
+ * Check an amount against the bounds of a column scan.
+ * - sc the scan state
+ * - a the amount
+ * - yes integer to receive one if the amount is within the bounds,
+ *   zero otherwise
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_scan_check_amount
+  ( struct ledger_table_scan* sc, struct ledger_table_amount const* a,
+    int* yes);
+
+/*
+ * Sum identifier cells (see `ledger_table_scan_cb`).
+ */
+static int ledger_table_scan_sum_ids
+  ( struct ledger_table_scan* sc, union ledger_table_cell cells,
+    int position, int n);
+
+/*
+ * Sum amount cells (see `ledger_table_scan_cb`).
+ */
+static int ledger_table_scan_sum_amounts
+  ( struct ledger_table_scan* sc, union ledger_table_cell cells,
+    int position, int n);
+
+/*
+ * Mark the identifier cells within bounds (see `ledger_table_scan_cb`).
+ */
+static int ledger_table_scan_filter_ids
+  ( struct ledger_table_scan* sc, union ledger_table_cell cells,
+    int position, int n);
+
+/*
+ * Mark the date cells within bounds (see `ledger_table_scan_cb`).
+ */
+static int ledger_table_scan_filter_dates
+  ( struct ledger_table_scan* sc, union ledger_table_cell cells,
+    int position, int n);
+
+/*
+ * Mark the amount cells within bounds (see `ledger_table_scan_cb`).
+ */
+static int ledger_table_scan_filter_amounts
+  ( struct ledger_table_scan* sc, union ledger_table_cell cells,
+    int position, int n);
+
+/*
+ * Copy a cell into a group of gathered cells.
+ * - type column type
+ * - group the first cell of the group
+ * - i index of the cell in the group
+ * - cell the cell to copy
+ */
+static void ledger_table_scan_gather
+  ( int type, union ledger_table_cell group, int i,
+    union ledger_table_cell cell);
+
+/*
+ * Run a scan kernel over every row of a column. A columnar table
+ * without tombstones passes its cell array in one run; other tables
+ * pass their cells in gathered groups.
+ * - t the table
+ * - column the column to scan
+ * - sc the scan state
+ * - cb the kernel
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_scan_run
+  ( struct ledger_table const* t, int column, struct ledger_table_scan* sc,
+    ledger_table_scan_cb cb);
+
+/*
+ * Compute the aggregates of a column in one pass, without locking.
+ * - t the table
+ * - column the column
+ * - bits rows to include, or NULL for every row
+ * - sum number to receive the sum, or NULL
+ * - min number to receive the least value, or NULL
+ * - max number to receive the greatest value, or NULL
+ * - count to receive the number of values, or NULL
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_scan_column_sub
+  ( struct ledger_table const* t, int column, unsigned char const* bits,
+    struct ledger_bignum* sum, struct ledger_bignum* min,
+    struct ledger_bignum* max, int* count);
+
+/*
+ * Multiply a run of amounts by a rate, in place.
+ * - rate the rate
+ * - a the first amount of the run
+ * - n number of amounts in the run
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_scale_amounts
+  (struct ledger_bignum_rate* rate, struct ledger_table_amount* a, int n);
+
+/*
+ * Find a prefix index.
+ * - t table to search
+ * - column summed column
+ * - key_column key column
+ * @return the prefix index, or NULL if the table has none
+ */
+static struct ledger_table_column_prefix* ledger_table_column_prefix_find
+  (struct ledger_table const* t, int column, int key_column);
+
+/*
+ * Free a prefix index.
+ * - cp the prefix index to free
+ */
+static void ledger_table_column_prefix_free
+  (struct ledger_table_column_prefix* cp);
+
+/*
+ * Free all prefix indexes of a table.
+ * - t the table
+ */
+static void ledger_table_column_prefix_release(struct ledger_table* t);
+
+/*
+ * Read a key cell for a prefix index.
+ * - mark the row to read
+ * - column the key column
+ * - key to receive the key
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_column_prefix_key
+  (struct ledger_table_mark const* mark, int column, long long int* key);
+
+/*
+ * Compare pending rows by key, then by position.
+ * - a the first row
+ * - b the second row
+ * @return negative if `a` goes first, positive if `b` goes first
+ */
+static int ledger_table_prefix_row_compare(void const* a, void const* b);
+
+/*
+ * Append an entry to a prefix tree.
+ * - cp the prefix index
+ * - key the entry's key, no less than the last key
+ * - n the entry's value
+ * @return one on success, zero on failure
+ */
+static int ledger_table_column_prefix_push
+  ( struct ledger_table_column_prefix* cp, long long int key,
+    struct ledger_bignum const* n);
+
+/*
+ * Bring a prefix tree up to date with the table.
+ * - t the table
+ * - cp the prefix index
+ * @return one on success, zero on failure
+ */
+static int ledger_table_column_prefix_update
+  (struct ledger_table const* t, struct ledger_table_column_prefix* cp);
+
+/*
+ * Note a change to a cell, for the prefix indexes.
+ * - mark the row of the cell
+ * - column the column of the cell
+ */
+static void ledger_table_column_prefix_note_put
+  (struct ledger_table_mark const* mark, int column);
+
+/*
+ * Note a row entering or leaving the table, for the prefix indexes.
+ * - t the table
+ * - position the row's position, or -1 if unknown
+ */
+static void ledger_table_column_prefix_note_row
+  (struct ledger_table* t, int position);
+
+/*
+ * Construct an empty observer list.
+ * @return the list on success, NULL otherwise
+ */
+static struct ledger_table_observer_list* ledger_table_observer_list_new
+  (void);
+
+/*
+ * Callback for releasing an observer list.
+ * - list the list to clear
+ */
+static void ledger_table_observer_list_free_cb(void* list);
+
+/*
+ * Free the observers in a list.
+ * - list the observer list, already locked
+ * - dropped_tf nonzero to free only the dropped observers
+ */
+static void ledger_table_observer_release
+  (struct ledger_table_observer_list* list, int dropped_tf);
+
+/*
+ * Tell the observers of a table about a change.
+ * - t the table
+ * - event the change, from `enum ledger_table_event`
+ * - mark the row that changed, or NULL for none
+ * - column the column that changed, or -1 for none
+ */
+static void ledger_table_observer_notify
+  ( struct ledger_table* t, int event, struct ledger_table_mark const* mark,
+    int column);
+
+/*
+ * Tell the observers of a table about a cell change.
+ * - mark the row of the cell
+ * - column the column of the cell
+ */
+static void ledger_table_observer_note_put
+  (struct ledger_table_mark const* mark, int column);
+
+/*
+ * Scramble a 64-bit value for the table fingerprint.
+ * - x the value to scramble
+ * @return the scrambled value
+ */
+static unsigned long long int ledger_table_fingerprint_mix
+  (unsigned long long int x);
+
+/*
+ * Hash an amount by its numeric value, so that amounts comparing
+ * equal hash equal.
+ * - a the amount to hash
+ * - h to receive the hash, zero for a zero amount
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_fingerprint_amount
+  (struct ledger_table_amount const* a, unsigned long long int* h);
+
+/*
+ * Hash a cell for the table fingerprint. Cells in their
+ * initial state hash to zero.
+ * - mark the row of the cell
+ * - column the column of the cell
+ * - h to receive the hash
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_fingerprint_cell
+  ( struct ledger_table_mark const* mark, int column,
+    unsigned long long int* h);
+
+/*
+ * Account for a cell entering or leaving the table fingerprint.
+ * - mark the row of the cell
+ * - column the column of the cell
+ * - direction positive if the cell enters, negative if it leaves
+ */
+static void ledger_table_fingerprint_note
+  (struct ledger_table_mark const* mark, int column, int direction);
+
+/*
+ * Account for a row entering or leaving the table fingerprint.
+ * - mark the row
+ * - direction positive if the row enters, negative if it leaves
+ */
+static void ledger_table_fingerprint_note_row
+  (struct ledger_table_mark const* mark, int direction);
+
+/*
+ * Recompute a table fingerprint from its cells.
+ * - t the table to scan
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_fingerprint_build(struct ledger_table const* t);
+
+/*
+ * Query a table fingerprint, rescanning the table if needed.
+ * The caller must hold the table lock.
+ * - t the table to query
+ * - fingerprint to receive the fingerprint
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_fingerprint_get
+  (struct ledger_table const* t, unsigned long long int* fingerprint);
+
+/*
+ * Construct a new table schema.
+ * - t table to use the schema, for its locks
+ * - columns number of columns to use
+ * - types array of column types
+ * @return the schema on success, NULL otherwise
+ */
+static struct ledger_table_schema* ledger_table_schema_new
+  (struct ledger_table const* t, int columns, int const* types);
+
+/*
+ * Acquire a table schema.
+ * - sch the schema to acquire
+ * @return the schema on success, NULL otherwise
+ */
+static struct ledger_table_schema* ledger_table_schema_acquire
+  (struct ledger_table_schema* sch);
+
+/*
+ * Clear out a schema.
+ * - sch the schema to clear
+ */
+static void ledger_table_schema_clear(struct ledger_table_schema* sch);
+
+/*
+ * Release a schema.
+ * - sch the schema to release
+ */
+static void ledger_table_schema_free(struct ledger_table_schema* sch);
+
+/*
+ * Compare two schemata for equality.
+ * - a one schema
+ * - b another schema
+ * @return nonzero if the schemata are equal, zero otherwise
+ */
+int ledger_table_schema_is_equal
+  (struct ledger_table_schema const* a, struct ledger_table_schema const* b);
+
+/*
+ * Recursively lock a table schema for modification of rows.
+ * - t table schema to lock
+ */
+static void ledger_table_schema_lock(struct ledger_table_schema const* t);
+
+/*
+ * Recursively lock a table schema for reading rows.
+ * - t table schema to lock
+ */
+static void ledger_table_schema_lock_shared
+  (struct ledger_table_schema const* t);
+
+/*
+ * Outdate a table schema.
+ * - t table schema
+ * @return whether the caller acquired closing rights
+ */
+static int ledger_table_schema_outdate(struct ledger_table_schema* t);
+
+/*
+ * Check whether a schema is outdated.
+ * - t table schema to query
+ * @return one if the schema is outdated, zero otherwise
+ */
+int ledger_table_schema_is_outdated(struct ledger_table_schema const* t);
+
+/*
+ * Check whether a schema is outdated, with its lock already held.
+ * - t table schema to query
+ * @return one if the schema is outdated, zero otherwise
+ */
+static int ledger_table_schema_is_outdated_sub
+  (struct ledger_table_schema const* t);
+
+/*
+ * Unlock a table schema for modification.
+ * - t table schema to unlock
+ */
+static void ledger_table_schema_unlock(struct ledger_table_schema const* t);
+
+/*
+ * Unlock a table schema for reading.
+ * - t table schema to unlock
+ */
+static void ledger_table_schema_unlock_shared
+  (struct ledger_table_schema const* t);
+
+/*
+ * Close a schema from further modification.
+ * - t the schema to close
+ */
+void ledger_table_schema_close(struct ledger_table_schema* t);
+
+/*
+ * Subroutine for table row insertion.
+ * - mark mark pointing to the neighboring row
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_add_row_sub(struct ledger_table_mark* mark);
+
+/*
+ * Subroutine for table row deletion.
+ * - mark mark pointing to the row to delete
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_drop_row_sub(struct ledger_table_mark* mark);
+
+/*
+ * Subroutine for fetching strings from a field.
+ * - mark mark pointing to the row to read
+ * - i field index
+ * - buf output buffer
+ * - len length of buffer in bytes
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_fetch_string_sub
+  (struct ledger_table_mark const* mark, int i, unsigned char* buf, int len);
+
+/*
+ * Subroutine for putting identifiers to a field.
+ * - mark mark pointing to the row to write
+ * - i field index
+ * - value identifier to put
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_put_id_sub
+  ( struct ledger_table_mark const* mark, int i, int value);
+
+/*
+ * Subroutine for fetching identifiers from a field.
+ * - mark mark pointing to the row to read
+ * - i field index
+ * - n place to stored the fetched identifier
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_fetch_id_sub
+  (struct ledger_table_mark const* mark, int i, int* n);
+
+/*
+ * Subroutine for putting packed dates to a field.
+ * - mark mark pointing to the row to write
+ * - i field index
+ * - value packed date to put, or negative to unset
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_put_date_sub
+  ( struct ledger_table_mark const* mark, int i, long long int value);
+
+/*
+ * Subroutine for fetching packed dates from a field.
+ * - mark mark pointing to the row to read
+ * - i field index
+ * - value place to store the packed date, or -1 if unset
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_fetch_date_sub
+  (struct ledger_table_mark const* mark, int i, long long int* value);
+
+/*
+ * Subroutine for putting big numbers to a field.
+ * - mark mark pointing to the row to write
+ * - i field index
+ * - value number to put
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_put_bignum_sub
+  ( struct ledger_table_mark const* mark, int i,
+    struct ledger_bignum const* value);
+
+/*
+ * Subroutine for fetching big numbers from a field.
+ * - mark mark pointing to the row to read
+ * - i field index
+ * - n place to stored the fetched number
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_fetch_bignum_sub
+  (struct ledger_table_mark const* mark, int i, struct ledger_bignum* n);
+
+/*
+ * Subroutine for fetching fixed-point numbers from a field.
+ * - mark mark pointing to the row to read
+ * - i field index
+ * - value place to store the fixed-point value
+ * - point_place place to store the number of centesimal places
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_fetch_fixed_sub
+  ( struct ledger_table_mark const* mark, int i,
+    long long int* value, int* point_place);
+
+/*
+ * Subroutine for putting strings to a field.
+ * - mark mark pointing to the row to write
+ * - i field index
+ * - value string to put
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_put_string_sub
+  (struct ledger_table_mark const* mark, int i, unsigned char const* value);
+
+/*
+ * Subroutine for fetching several items from a row.
+ * - mark any mark
+ * - n number of fields
+ * - fields fields to fill
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_fetch_row_sub
+  ( struct ledger_table_mark const* mark, int n,
+    struct ledger_table_field* fields);
+
+/*
+ * Subroutine for putting several items to a row.
+ * - mark a mutable mark
+ * - n number of fields
+ * - fields fields to put
+ * @return one on success, zero otherwise
+ */
+static int ledger_table_put_row_sub
+  ( struct ledger_table_mark const* mark, int n,
+    struct ledger_table_field const* fields);
+
+/*
+ * Exchange mark pointer.
+ * - mark the mark to edit
+ * - new_row the new row
+ */
+static void ledger_table_mark_exchange
+  (struct ledger_table_mark *mark, struct ledger_table_row* new_row);
+
+/*
+ * Add one to the mark, ensuring that the mark is still valid.
+ * - m the mark to advance
+ * @return one on success, zero if the mark is caught
+ */
+static int ledger_table_mark_add_one_checked(struct ledger_table_mark* m);
+
+/* BEGIN static implementation */
+
+void ledger_table_lock(struct ledger_table const* t){
+  ledger_util_lock_exclusive(t->lock);
+  return;
+}
+
+void ledger_table_lock_shared(struct ledger_table const* t){
+  ledger_util_lock_shared(t->lock);
+  return;
+}
+
+void ledger_table_unlock(struct ledger_table const* t){
+  ledger_util_unlock_exclusive(t->lock);
+  return;
+}
+
+void ledger_table_unlock_shared(struct ledger_table const* t){
+  ledger_util_unlock_shared(t->lock);
+  return;
+}
+
+void ledger_table_free_cb(void* t){
+  ledger_table_clear((struct ledger_table*) t);
+  return;
+}
+
+int ledger_table_init(struct ledger_table* t, int columnar_tf){
+  /* NOTE pre-clear compatible */
+  t->schema = NULL;
+  t->rows = 0;
+  t->root = NULL;
+  t->store = NULL;
+  t->lock = NULL;
+  t->cache_lock = NULL;
+  t->positions = NULL;
+  t->position_count = 0;
+  t->position_capacity = 0;
+  t->position_stale = 0;
+  t->shares = 0;
+  t->column_indexes = NULL;
+  t->column_aggregates = NULL;
+  t->column_prefixes = NULL;
+  t->fingerprint = 0u;
+  t->fingerprint_stale_tf = 0;
+  t->pool = NULL;
+  t->tombstones_tf = 0;
+  t->observers = NULL;
+  /* allocate the locks */{
+    t->lock = ledger_util_lock_new();
+    if (t->lock == NULL) return 0;
+    t->cache_lock = ledger_util_lock_new();
+    if (t->cache_lock == NULL) return 0;
+  }
+  /* allocate a root */{
+    struct ledger_table_row* root;
+    struct ledger_table_schema* schema = ledger_table_schema_new(t,0,NULL);
+    if (schema == NULL) return 0;
+    if (columnar_tf){
+      struct ledger_table_store* store = ledger_table_store_new(schema);
+      if (store == NULL){
+        ledger_table_schema_free(schema);
+        return 0;
+      }
+      t->store = store;
+    } else {
+      root = ledger_table_row_new(schema);
+      if (root == NULL){
+        ledger_table_schema_free(schema);
+        return 0;
+      }
+      root->root_tf = 1;
+      t->root = root;
+    }
+    t->schema = schema;
+  }
+  /* POST_CONDITION table has a schema */
+  return 1;
+}
+
+void ledger_table_clear(struct ledger_table* t){
+  if (t->schema == NULL){
+    /* rows never made */
+  } else if (t->store != NULL){
+    /* cells are released with the last reference to the store */
+    if (ledger_table_schema_outdate(t->schema)){
+      ledger_table_schema_close(t->schema);
+    }
+    ledger_table_store_free(t->store);
+    ledger_table_schema_free(t->schema);
+    t->store = NULL;
+    t->schema = NULL;
+  } else {
+    /* if only one reference held on this table, then no lock necessary */
+    if (ledger_table_schema_outdate(t->schema)){
+      if (t->root != NULL){
+        ledger_table_drop_all_rows(t);
+      }
+      ledger_table_schema_close(t->schema);
+    }
+    ledger_table_row_free(t->root);
+    ledger_table_schema_free(t->schema);
+    ledger_table_index_release(t);
+    t->root = NULL;
+    t->schema = NULL;
+  }
+  ledger_table_column_index_release(t);
+  ledger_table_column_aggregate_release(t);
+  ledger_table_column_prefix_release(t);
+  /* private copies may keep the observers */
+  if (t->observers != NULL)
+    ledger_util_ref_free(t->observers);
+  t->observers = NULL;
+  /* pooled strings keep their own references to the pool */
+  ledger_table_pool_free(t->pool);
+  t->pool = NULL;
+  /* schemata and marks may still hold the locks */
+  ledger_util_lock_free(t->cache_lock);
+  t->cache_lock = NULL;
+  ledger_util_lock_free(t->lock);
+  t->lock = NULL;
+  return;
+}
+
+struct ledger_table_mark* ledger_table_mark_new
+  ( struct ledger_table const* t, struct ledger_table_row const* r,
+    int index, int mutable_flag)
+{
+  struct ledger_table_mark* ptr;
+  ptr = (struct ledger_table_mark*)
+    ledger_util_ref_malloc(sizeof(struct ledger_table_mark),
+        ledger_table_mark_free_cb);
+  if (ptr == NULL) return NULL;
+  if (!ledger_table_mark_init(t,r,index,mutable_flag,ptr)){
+    ledger_util_ref_free(ptr);
+    ptr = NULL;
+  }
+  return ptr;
+}
+
+int ledger_table_mark_init
+  ( struct ledger_table const* t, struct ledger_table_row const* r,
+    int index, int mutable_flag, struct ledger_table_mark* ptr)
+{
+  ptr->prev_mark = NULL;
+  ptr->next_mark = NULL;
+  ptr->index = 0;
+  ptr->borrowed_tf = 0;
+  if (t->store != NULL){
+    struct ledger_table_store* store = ledger_table_store_acquire(t->store);
+    ptr->row = NULL;
+    if (store == NULL){
+      ptr->source = 0;
+      ptr->store = NULL;
+      ptr->mutable_flag = 0;
+      return 0;
+    }
+    /* put mark contents */{
+      ptr->source = t;
+      ptr->store = store;
+      ptr->index = (index >= 0 && index < store->rows)
+        ? ledger_table_store_live_row(store, index, +1) : -1;
+      ptr->mutable_flag = mutable_flag;
+      ledger_table_store_attach_mark(store, ptr);
+    }
+  } else {
+    struct ledger_table_row* row =
+      ledger_table_row_acquire((struct ledger_table_row*)r);
+    ptr->store = NULL;
+    if (row == NULL){
+      ptr->source = 0;
+      ptr->row = NULL;
+      ptr->mutable_flag = 0;
+      return 0;
+    }
+    /* put mark contents */{
+      ptr->source = t;
+      ptr->row = (struct ledger_table_row*)r;
+      ptr->mutable_flag = mutable_flag;
+    }
+  }
+  return 1;
+}
+
+void ledger_table_mark_clear(struct ledger_table_mark* m){
+  if (m->store != NULL){
+    ledger_table_store_detach_mark(m->store, m);
+    ledger_table_store_free(m->store);
+    m->store = NULL;
+  } else {
+    ledger_table_row_free(m->row);
+  }
+  return;
+}
+
+void ledger_table_mark_free_cb(void* m){
+  ledger_table_mark_clear((struct ledger_table_mark*)m);
+}
+
+int ledger_table_mark_add_one_checked(struct ledger_table_mark* m){
+  int consistent_tf;
+  if (m->store != NULL){
+    struct ledger_table_store *const store = m->store;
+    ledger_table_schema_lock_shared(store->schema);
+    m->index = ledger_table_store_move(store, m->index, +1);
+    consistent_tf = 1;
+    ledger_table_schema_unlock_shared(store->schema);
+  } else {
+    struct ledger_table_row *const row = m->row;
+    ledger_table_schema_lock_shared(row->schema);
+    if (row->next != row){
+      ledger_table_mark_exchange(m, row->next);
+      consistent_tf = 1;
+    } else consistent_tf = 0;
+    ledger_table_schema_unlock_shared(row->schema);
+  }
+  return consistent_tf;
+}
+
+struct ledger_table_schema* ledger_table_mark_schema
+  (struct ledger_table_mark const* mark)
+{
+  if (mark->store != NULL)
+    return mark->store->schema;
+  else
+    return mark->row->schema;
+}
+
+int ledger_table_mark_at_end(struct ledger_table_mark const* mark){
+  if (mark->store != NULL)
+    return mark->index < 0;
+  else
+    return mark->row->root_tf;
+}
+
+int ledger_table_mark_cell
+  ( struct ledger_table_mark const* mark, int i,
+    union ledger_table_cell* cell)
+{
+  if (mark->store != NULL){
+    struct ledger_table_store const* const store = mark->store;
+    if (mark->index < 0
+    ||  mark->index >= store->rows
+    ||  (store->dead != NULL && store->dead[mark->index])
+    ||  i < 0
+    ||  i >= store->schema->columns)
+      return 0;
+    else return ledger_table_store_cell(store, i, mark->index, cell);
+  } else {
+    if (mark->row->root_tf)
+      return 0;
+    else return ledger_table_row_cell(mark->row, i, cell);
+  }
+}
+
+int ledger_table_row_cell
+  ( struct ledger_table_row* row, int i, union ledger_table_cell* cell)
+{
+  struct ledger_table_schema const* const schema = row->schema;
+  int const columns = ((schema!=NULL)?schema->columns:0);
+  if (i < 0
+  ||  i >= columns)
+    return 0;
+  switch (schema->types[i]){
+  case LEDGER_TABLE_ID:
+  case LEDGER_TABLE_INDEX:
+    cell->item_id = &row->data[i].item_id;
+    break;
+  case LEDGER_TABLE_BIGNUM:
+    cell->amount = &row->data[i].amount;
+    break;
+  case LEDGER_TABLE_USTR:
+    cell->string = &row->data[i].string;
+    break;
+  case LEDGER_TABLE_DATE:
+    cell->date = &row->data[i].date;
+    break;
+  default:
+    return 0;
+  }
+  return schema->types[i];
+}
+
+int ledger_table_amount_point(struct ledger_table_amount const* a){
+  switch (a->point_place){
+  case LEDGER_TABLE_AMOUNT_NONE:
+    return 0;
+  case LEDGER_TABLE_AMOUNT_BIG:
+    return ledger_bignum_find_point(a->value.bignum);
+  default:
+    return a->point_place;
+  }
+}
+
+int ledger_table_amount_scale(long long int* value, int from, int to){
+  long long int v = *value;
+  for (; from < to; ++from){
+    if (v > LLONG_MAX/100 || v < -(LLONG_MAX/100))
+      return 0;
+    v *= 100;
+  }
+  *value = v;
+  return 1;
+}
+
+int ledger_table_amount_put_fixed
+  (struct ledger_table_amount* a, long long int value, int point_place)
+{
+  int const old_point = ledger_table_amount_point(a);
+  if (old_point > point_place){
+    if (!ledger_table_amount_scale(&value, point_place, old_point))
+      return 0;
+    point_place = old_point;
+  }
+  if (a->point_place == LEDGER_TABLE_AMOUNT_BIG){
+    ledger_bignum_free(a->value.bignum);
+  }
+  a->value.fixed = value;
+  a->point_place = point_place;
+  return 1;
+}
+
+struct ledger_bignum* ledger_table_amount_promote
+  (struct ledger_table_amount* a)
+{
+  struct ledger_bignum* n;
+  if (a->point_place == LEDGER_TABLE_AMOUNT_BIG)
+    return a->value.bignum;
+  n = ledger_bignum_new();
+  if (n == NULL) return NULL;
+  if (a->point_place != LEDGER_TABLE_AMOUNT_NONE
+  &&  !ledger_bignum_set_fixed(n, a->value.fixed, a->point_place))
+  {
+    ledger_bignum_free(n);
+    return NULL;
+  }
+  a->value.bignum = n;
+  a->point_place = LEDGER_TABLE_AMOUNT_BIG;
+  return n;
+}
+
+int ledger_table_amount_fetch
+  (struct ledger_bignum* n, struct ledger_table_amount const* a)
+{
+  switch (a->point_place){
+  case LEDGER_TABLE_AMOUNT_NONE:
+    return ledger_bignum_set_long(n, 0);
+  case LEDGER_TABLE_AMOUNT_BIG:
+    return ledger_bignum_assign(n, a->value.bignum);
+  default:
+    return ledger_bignum_set_fixed(n, a->value.fixed, a->point_place);
+  }
+}
+
+int ledger_table_amount_is_equal
+  (struct ledger_table_amount const* a, struct ledger_table_amount const* b)
+{
+  if (a->point_place != LEDGER_TABLE_AMOUNT_BIG
+  &&  b->point_place != LEDGER_TABLE_AMOUNT_BIG)
+  {
+    /* compare inline */
+    long long int a_value = 0, b_value = 0;
+    int a_point = 0, b_point = 0;
+    if (a->point_place != LEDGER_TABLE_AMOUNT_NONE){
+      a_value = a->value.fixed;
+      a_point = a->point_place;
+    }
+    if (b->point_place != LEDGER_TABLE_AMOUNT_NONE){
+      b_value = b->value.fixed;
+      b_point = b->point_place;
+    }
+    if (a_point < b_point){
+      if (ledger_table_amount_scale(&a_value, a_point, b_point))
+        return a_value == b_value;
+    } else {
+      if (ledger_table_amount_scale(&b_value, b_point, a_point))
+        return a_value == b_value;
+    }
+    /* a value overflowed, so the magnitudes differ */
+    return 0;
+  } else {
+    /* compare as big numbers */
+    int result = 0;
+    struct ledger_bignum* a_number = ledger_bignum_new();
+    struct ledger_bignum* b_number = ledger_bignum_new();
+    if (a_number != NULL && b_number != NULL
+    &&  ledger_table_amount_fetch(a_number, a)
+    &&  ledger_table_amount_fetch(b_number, b))
+    {
+      result = (ledger_bignum_compare(a_number, b_number) == 0);
+    }
+    ledger_bignum_free(a_number);
+    ledger_bignum_free(b_number);
+    return result;
+  }
+}
+
+int ledger_table_amount_compare
+  ( struct ledger_table_amount const* a, struct ledger_table_amount const* b,
+    struct ledger_bignum* registers[2], int* sign)
+{
+  if (a->point_place != LEDGER_TABLE_AMOUNT_BIG
+  &&  b->point_place != LEDGER_TABLE_AMOUNT_BIG)
+  {
+    /* compare inline */
+    long long int a_value = 0, b_value = 0;
+    int a_point = 0, b_point = 0;
+    if (a->point_place != LEDGER_TABLE_AMOUNT_NONE){
+      a_value = a->value.fixed;
+      a_point = a->point_place;
+    }
+    if (b->point_place != LEDGER_TABLE_AMOUNT_NONE){
+      b_value = b->value.fixed;
+      b_point = b->point_place;
+    }
+    if (a_point < b_point
+    &&  !ledger_table_amount_scale(&a_value, a_point, b_point))
+    {
+      /* `a` overflowed, so its magnitude is the greater */
+      *sign = (a_value < 0) ? -1 : +1;
+    } else if (b_point < a_point
+    &&  !ledger_table_amount_scale(&b_value, b_point, a_point))
+    {
+      /* `b` overflowed, so its magnitude is the greater */
+      *sign = (b_value < 0) ? +1 : -1;
+    } else {
+      *sign = (a_value < b_value) ? -1 : (a_value > b_value ? +1 : 0);
+    }
+    return 1;
+  } else {
+    /* compare as big numbers */
+    int cmp;
+    if (!ledger_table_amount_fetch(registers[0], a)
+    ||  !ledger_table_amount_fetch(registers[1], b))
+      return 0;
+    cmp = ledger_bignum_compare(registers[0], registers[1]);
+    *sign = (cmp < 0) ? -1 : (cmp > 0 ? +1 : 0);
+    return 1;
+  }
+}
+
+void ledger_table_cell_init(int type, union ledger_table_cell cell){
+  switch (type){
+  case LEDGER_TABLE_ID:
+  case LEDGER_TABLE_INDEX:
+    *cell.item_id = 0;
+    break;
+  case LEDGER_TABLE_BIGNUM:
+    cell.amount->point_place = LEDGER_TABLE_AMOUNT_NONE;
+    break;
+  case LEDGER_TABLE_USTR:
+    ledger_table_ustr_reset(cell.string);
+    break;
+  case LEDGER_TABLE_DATE:
+    *cell.date = -1;
+    break;
+  }
+  return;
+}
+
+void ledger_table_cell_clear(int type, union ledger_table_cell cell){
+  switch (type){
+  case LEDGER_TABLE_ID:
+  case LEDGER_TABLE_INDEX:
+    *cell.item_id = 0;
+    break;
+  case LEDGER_TABLE_BIGNUM:
+    if (cell.amount->point_place == LEDGER_TABLE_AMOUNT_BIG)
+      ledger_bignum_free(cell.amount->value.bignum);
+    cell.amount->point_place = LEDGER_TABLE_AMOUNT_NONE;
+    break;
+  case LEDGER_TABLE_USTR:
+    if (cell.string->value.text[LEDGER_TABLE_USTR_INLINE]
+        == LEDGER_TABLE_USTR_SPILL)
+      ledger_util_free(cell.string->value.heap);
+    else if (cell.string->value.text[LEDGER_TABLE_USTR_INLINE]
+        == LEDGER_TABLE_USTR_SHARED)
+      ledger_table_pool_release(cell.string->value.heap);
+    ledger_table_ustr_reset(cell.string);
+    break;
+  case LEDGER_TABLE_DATE:
+    *cell.date = -1;
+    break;
+  }
+  return;
+}
+
+int ledger_table_cell_is_equal
+  (int type, union ledger_table_cell a, union ledger_table_cell b)
+{
+  switch (type){
+  case LEDGER_TABLE_ID:
+  case LEDGER_TABLE_INDEX:
+    return (*a.item_id == *b.item_id);
+  case LEDGER_TABLE_BIGNUM:
+    return ledger_table_amount_is_equal(a.amount, b.amount);
+  case LEDGER_TABLE_USTR:
+    if (a.string->value.text[LEDGER_TABLE_USTR_INLINE]
+        == LEDGER_TABLE_USTR_SHARED
+    &&  b.string->value.text[LEDGER_TABLE_USTR_INLINE]
+        == LEDGER_TABLE_USTR_SHARED
+    &&  ledger_table_pool_entry_of(a.string->value.heap)->pool
+        == ledger_table_pool_entry_of(b.string->value.heap)->pool)
+    {
+      /* a pool holds each distinct string once */
+      return a.string->value.heap == b.string->value.heap;
+    }
+    return (ledger_util_ustrcmp
+      (ledger_table_ustr_get(a.string), ledger_table_ustr_get(b.string))
+      == 0);
+  case LEDGER_TABLE_DATE:
+    return (*a.date == *b.date);
+  default:
+    return 1;
+  }
+}
+
+int ledger_table_cell_copy
+  ( struct ledger_table_mark const* mark, int type,
+    union ledger_table_cell dst, union ledger_table_cell src)
+{
+  switch (type){
+  case LEDGER_TABLE_ID:
+  case LEDGER_TABLE_INDEX:
+    *dst.item_id = *src.item_id;
+    return 1;
+  case LEDGER_TABLE_DATE:
+    *dst.date = *src.date;
+    return 1;
+  case LEDGER_TABLE_BIGNUM:
+    if (src.amount->point_place == LEDGER_TABLE_AMOUNT_BIG){
+      struct ledger_bignum* const n = ledger_table_amount_promote(dst.amount);
+      if (n == NULL) return 0;
+      return ledger_bignum_copy(n, src.amount->value.bignum);
+    } else {
+      /* inline values copy directly */
+      *dst.amount = *src.amount;
+      return 1;
+    }
+  case LEDGER_TABLE_USTR:
+    /* copy the text */{
+      unsigned char const* const text = ledger_table_ustr_get(src.string);
+      if (text == NULL) return 1;
+      if (src.string->value.text[LEDGER_TABLE_USTR_INLINE]
+          == LEDGER_TABLE_USTR_SHARED
+      &&  ledger_table_pool_entry_of(text)->pool == mark->source->pool)
+      {
+        /* share the pooled string */
+        ledger_table_pool_share(src.string->value.heap);
+        ledger_table_mark_string_release(mark, dst.string);
+        dst.string->value.heap = src.string->value.heap;
+        dst.string->value.text[LEDGER_TABLE_USTR_INLINE] =
+          LEDGER_TABLE_USTR_SHARED;
+        return 1;
+      }
+      return ledger_table_mark_string_put
+        (mark, dst.string, text, ledger_util_ustrlen(text));
+    }
+  default:
+    return 1;
+  }
+}
+
+unsigned char const* ledger_table_ustr_get
+  (struct ledger_table_ustr const* s)
+{
+  if (s->value.text[LEDGER_TABLE_USTR_INLINE] == LEDGER_TABLE_USTR_SPILL
+  ||  s->value.text[LEDGER_TABLE_USTR_INLINE] == LEDGER_TABLE_USTR_SHARED)
+    return s->value.heap;
+  else return s->value.text;
+}
+
+void ledger_table_ustr_reset(struct ledger_table_ustr* s){
+  s->value.heap = NULL;
+  s->value.text[LEDGER_TABLE_USTR_INLINE] = LEDGER_TABLE_USTR_SPILL;
+  return;
+}
+
+unsigned char* ledger_table_mark_string_reserve
+  ( struct ledger_table_mark const* mark, struct ledger_table_ustr* s,
+    size_t len)
+{
+  struct ledger_table_store* const store = mark->store;
+  unsigned char* const old =
+    (s->value.text[LEDGER_TABLE_USTR_INLINE] == LEDGER_TABLE_USTR_SPILL)
+    ? s->value.heap : NULL;
+  unsigned char* new_string;
+  if (len >= 65534){
+    /* string too long */
+    return NULL;
+  } else if (len <= LEDGER_TABLE_USTR_INLINE){
+    /* keep the string inline */
+    ledger_table_mark_string_release(mark, s);
+    s->value.text[LEDGER_TABLE_USTR_INLINE] =
+      (unsigned char)(LEDGER_TABLE_USTR_INLINE-len);
+    return s->value.text;
+  } else if (store == NULL){
+    new_string = (unsigned char*)ledger_util_malloc(len+1);
+  } else if (old != NULL && ledger_util_ustrlen(old) >= len){
+    /* overwrite in place */
+    return old;
+  } else {
+    if (store->strings == NULL){
+      store->strings = ledger_util_arena_new(0);
+      if (store->strings == NULL) return NULL;
+    }
+    new_string =
+      (unsigned char*)ledger_util_arena_alloc(store->strings, len+1);
+  }
+  if (new_string != NULL){
+    ledger_table_mark_string_release(mark, s);
+    s->value.heap = new_string;
+  }
+  return new_string;
+}
+
+void ledger_table_mark_string_release
+  (struct ledger_table_mark const* mark, struct ledger_table_ustr* s)
+{
+  if (s->value.text[LEDGER_TABLE_USTR_INLINE] == LEDGER_TABLE_USTR_SHARED){
+    ledger_table_pool_release(s->value.heap);
+  } else if (mark->store == NULL
+  &&  s->value.text[LEDGER_TABLE_USTR_INLINE] == LEDGER_TABLE_USTR_SPILL)
+  {
+    ledger_util_free(s->value.heap);
+  } /* else the string stays in the arena until the store is freed */
+  ledger_table_ustr_reset(s);
+  return;
+}
+
+int ledger_table_mark_string_put
+  ( struct ledger_table_mark const* mark, struct ledger_table_ustr* s,
+    unsigned char const* text, size_t len)
+{
+  struct ledger_table_pool* const pool = mark->source->pool;
+  if (pool != NULL && len > LEDGER_TABLE_USTR_INLINE && len < 65534){
+    unsigned char* const shared = ledger_table_pool_intern(pool, text, len);
+    if (shared == NULL) return 0;
+    /* release after interning, as the text may be the old string */
+    ledger_table_mark_string_release(mark, s);
+    s->value.heap = shared;
+    s->value.text[LEDGER_TABLE_USTR_INLINE] = LEDGER_TABLE_USTR_SHARED;
+    return 1;
+  } else {
+    unsigned char* const new_string =
+      ledger_table_mark_string_reserve(mark, s, len);
+    if (new_string == NULL) return 0;
+    memmove(new_string, text, len);
+    new_string[len] = 0;
+    return 1;
+  }
+}
+
+void ledger_table_store_cell_clear(int type, union ledger_table_cell cell){
+  if (type == LEDGER_TABLE_USTR){
+    /* strings live inline, in the store's arena or in a pool */
+    if (cell.string->value.text[LEDGER_TABLE_USTR_INLINE]
+        == LEDGER_TABLE_USTR_SHARED)
+      ledger_table_pool_release(cell.string->value.heap);
+    ledger_table_ustr_reset(cell.string);
+  } else ledger_table_cell_clear(type, cell);
+  return;
+}
+
+void ledger_table_pool_free_cb(void* ptr){
+  struct ledger_table_pool* const p = (struct ledger_table_pool*)ptr;
+  /* entries hold references to the pool, so none remain */
+  ledger_util_free(p->buckets);
+  ledger_util_lock_free(p->lock);
+  return;
+}
+
+struct ledger_table_pool_entry* ledger_table_pool_entry_of
+  (unsigned char const* text)
+{
+  return (struct ledger_table_pool_entry*)
+    (text - offsetof(struct ledger_table_pool_entry, text));
+}
+
+unsigned char* ledger_table_pool_intern
+  ( struct ledger_table_pool* p, unsigned char const* text, size_t len)
+{
+  struct ledger_table_pool_entry* entry;
+  unsigned int hash = 2166136261u;
+  size_t i;
+  /* FNV-1a */
+  for (i = 0; i < len; ++i){
+    hash = (hash ^ text[i]) * 16777619u;
+  }
+  ledger_util_lock_exclusive(p->lock);
+  do {
+    for (entry = p->buckets[hash&(p->bucket_count-1)];
+        entry != NULL; entry = entry->next)
+    {
+      if (entry->hash == hash && entry->length == (int)len
+      &&  memcmp(entry->text, text, len) == 0)
+        break;
+    }
+    if (entry != NULL){
+      entry->refs += 1;
+      break;
+    }
+    /* grow the buckets at a load factor of one */
+    if (p->count >= p->bucket_count && p->bucket_count < (INT_MAX/2)){
+      int const new_count = p->bucket_count*2;
+      struct ledger_table_pool_entry** const new_buckets =
+        (struct ledger_table_pool_entry**)ledger_util_malloc
+          (new_count*sizeof(struct ledger_table_pool_entry*));
+      if (new_buckets != NULL){
+        int j;
+        for (j = 0; j < new_count; ++j){
+          new_buckets[j] = NULL;
+        }
+        for (j = 0; j < p->bucket_count; ++j){
+          while (p->buckets[j] != NULL){
+            struct ledger_table_pool_entry* const moved = p->buckets[j];
+            p->buckets[j] = moved->next;
+            moved->next = new_buckets[moved->hash&(new_count-1)];
+            new_buckets[moved->hash&(new_count-1)] = moved;
+          }
+        }
+        ledger_util_free(p->buckets);
+        p->buckets = new_buckets;
+        p->bucket_count = new_count;
+      } /* else keep the longer chains */
+    }
+    entry = (struct ledger_table_pool_entry*)ledger_util_malloc
+      (sizeof(struct ledger_table_pool_entry)+len+1);
+    if (entry == NULL) break;
+    entry->pool = ledger_table_pool_acquire(p);
+    entry->refs = 1;
+    entry->hash = hash;
+    entry->length = (int)len;
+    memcpy(entry->text, text, len);
+    entry->text[len] = 0;
+    entry->next = p->buckets[hash&(p->bucket_count-1)];
+    p->buckets[hash&(p->bucket_count-1)] = entry;
+    p->count += 1;
+  } while (0);
+  ledger_util_unlock_exclusive(p->lock);
+  return (entry != NULL) ? entry->text : NULL;
+}
+
+void ledger_table_pool_share(unsigned char* text){
+  struct ledger_table_pool_entry* const entry =
+    ledger_table_pool_entry_of(text);
+  ledger_util_lock_exclusive(entry->pool->lock);
+  entry->refs += 1;
+  ledger_util_unlock_exclusive(entry->pool->lock);
+  return;
+}
+
+void ledger_table_pool_release(unsigned char* text){
+  struct ledger_table_pool_entry* const entry =
+    ledger_table_pool_entry_of(text);
+  struct ledger_table_pool* const p = entry->pool;
+  int last_tf;
+  ledger_util_lock_exclusive(p->lock);
+  entry->refs -= 1;
+  last_tf = (entry->refs == 0);
+  if (last_tf){
+    struct ledger_table_pool_entry** link =
+      &p->buckets[entry->hash&(p->bucket_count-1)];
+    while (*link != entry){
+      link = &(*link)->next;
+    }
+    *link = entry->next;
+    p->count -= 1;
+  }
+  ledger_util_unlock_exclusive(p->lock);
+  if (last_tf){
+    ledger_util_free(entry);
+    /* the pool may go away with its last string */
+    ledger_table_pool_free(p);
+  }
+  return;
+}
+
+size_t ledger_table_cell_size(int type){
+  switch (type){
+  case LEDGER_TABLE_ID:
+  case LEDGER_TABLE_INDEX:
+    return sizeof(int);
+  case LEDGER_TABLE_BIGNUM:
+    return sizeof(struct ledger_table_amount);
+  case LEDGER_TABLE_USTR:
+    return sizeof(struct ledger_table_ustr);
+  case LEDGER_TABLE_DATE:
+    return sizeof(long long int);
+  default:
+    return 0;
+  }
+}
+
+struct ledger_table_store* ledger_table_store_new
+  (struct ledger_table_schema* schema)
+{
+  struct ledger_table_schema* new_schema;
+  struct ledger_table_store* s;
+  new_schema = ledger_table_schema_acquire(schema);
+  if (new_schema == NULL) return NULL;
+  s = (struct ledger_table_store*)ledger_util_ref_malloc
+    ( sizeof(struct ledger_table_store)
+        + new_schema->columns*sizeof(unsigned char*),
+      ledger_table_store_free_cb);
+  if (s == NULL){
+    ledger_table_schema_free(new_schema);
+    return NULL;
+  } else {
+    int i;
+    s->schema = new_schema;
+    s->rows = 0;
+    s->capacity = 0;
+    s->marks = NULL;
+    s->strings = NULL;
+    s->dead = NULL;
+    s->dead_count = 0;
+    s->live = NULL;
+    for (i = 0; i < new_schema->columns; ++i){
+      s->columns[i] = NULL;
+    }
+  }
+  return s;
+}
+
+struct ledger_table_store* ledger_table_store_acquire
+  (struct ledger_table_store* s)
+{
+  return (struct ledger_table_store*)ledger_util_ref_acquire(s);
+}
+
+void ledger_table_store_free(struct ledger_table_store* s){
+  if (s != NULL){
+    ledger_util_ref_free(s);
+  }
+  return;
+}
+
+void ledger_table_store_free_cb(void* ptr){
+  struct ledger_table_store* s = (struct ledger_table_store*)ptr;
+  int i;
+  int const columns = s->schema->columns;
+  /* free the cells */
+  for (i = 0; i < columns; ++i){
+    int const type = s->schema->types[i];
+    int j;
+    if (type == LEDGER_TABLE_BIGNUM || type == LEDGER_TABLE_USTR){
+      for (j = 0; j < s->rows; ++j){
+        union ledger_table_cell cell;
+        ledger_table_store_cell(s, i, j, &cell);
+        ledger_table_store_cell_clear(type, cell);
+      }
+    }
+    ledger_util_free(s->columns[i]);
+    s->columns[i] = NULL;
+  }
+  ledger_util_arena_free(s->strings);
+  s->strings = NULL;
+  ledger_util_free(s->dead);
+  s->dead = NULL;
+  s->dead_count = 0;
+  ledger_util_free(s->live);
+  s->live = NULL;
+  s->rows = 0;
+  s->capacity = 0;
+  /* release the schema */
+  ledger_table_schema_free(s->schema);
+  s->schema = NULL;
+  return;
+}
+
+int ledger_table_store_reserve(struct ledger_table_store* s, int n){
+  int new_capacity;
+  int i;
+  int const columns = s->schema->columns;
+  if (n <= s->capacity) return 1;
+  /* compute the new capacity */{
+    new_capacity = (s->capacity > 0) ? s->capacity : 8;
+    while (new_capacity < n){
+      if (new_capacity > INT_MAX/2) return 0;
+      new_capacity *= 2;
+    }
+  }
+  /* extend each column */
+  for (i = 0; i < columns; ++i){
+    size_t const cell_size = ledger_table_cell_size(s->schema->types[i]);
+    unsigned char* new_cells;
+    if ((size_t)new_capacity >= (~(size_t)0)/cell_size)
+      return 0;
+    new_cells = (unsigned char*)ledger_util_malloc(new_capacity*cell_size);
+    if (new_cells == NULL) return 0;
+    if (s->rows > 0){
+      memcpy(new_cells, s->columns[i], s->rows*cell_size);
+    }
+    ledger_util_free(s->columns[i]);
+    s->columns[i] = new_cells;
+  }
+  /* extend the tombstone flags */if (s->dead != NULL){
+    unsigned char* const new_dead =
+      (unsigned char*)ledger_util_malloc(new_capacity);
+    if (new_dead == NULL) return 0;
+    memcpy(new_dead, s->dead, s->rows);
+    memset(new_dead+s->rows, 0, new_capacity-s->rows);
+    ledger_util_free(s->dead);
+    s->dead = new_dead;
+  }
+  s->capacity = new_capacity;
+  return 1;
+}
+
+int ledger_table_store_cell
+  ( struct ledger_table_store const* s, int i, int index,
+    union ledger_table_cell* cell)
+{
+  int const type = s->schema->types[i];
+  switch (type){
+  case LEDGER_TABLE_ID:
+  case LEDGER_TABLE_INDEX:
+    cell->item_id = ((int*)s->columns[i])+index;
+    break;
+  case LEDGER_TABLE_BIGNUM:
+    cell->amount = ((struct ledger_table_amount*)s->columns[i])+index;
+    break;
+  case LEDGER_TABLE_USTR:
+    cell->string = ((struct ledger_table_ustr*)s->columns[i])+index;
+    break;
+  case LEDGER_TABLE_DATE:
+    cell->date = ((long long int*)s->columns[i])+index;
+    break;
+  }
+  return type;
+}
+
+int ledger_table_store_insert
+  (struct ledger_table_store* s, int index, struct ledger_table_mark* mark)
+{
+  int i;
+  int const columns = s->schema->columns;
+  if (s->rows >= INT_MAX-1) return 0;
+  if (!ledger_table_store_reserve(s, s->rows+1)) return 0;
+  /* open a gap in each column */
+  for (i = 0; i < columns; ++i){
+    int const type = s->schema->types[i];
+    size_t const cell_size = ledger_table_cell_size(type);
+    unsigned char* const cells = s->columns[i];
+    union ledger_table_cell cell;
+    if (index < s->rows){
+      memmove(cells+(index+1)*cell_size, cells+index*cell_size,
+          (s->rows-index)*cell_size);
+    }
+    ledger_table_store_cell(s, i, index, &cell);
+    ledger_table_cell_init(type, cell);
+  }
+  if (s->dead != NULL){
+    if (index < s->rows)
+      memmove(s->dead+index+1, s->dead+index, s->rows-index);
+    s->dead[index] = 0;
+  }
+  ledger_util_free(s->live);
+  s->live = NULL;
+  s->rows += 1;
+  /* keep the other marks on their rows */{
+    struct ledger_table_mark* m;
+    for (m = s->marks; m != NULL; m = m->next_mark){
+      if (m != mark && m->index >= index)
+        m->index += 1;
+    }
+    mark->index = index;
+  }
+  return 1;
+}
+
+void ledger_table_store_erase(struct ledger_table_store* s, int index){
+  int i;
+  int const columns = s->schema->columns;
+  /* close the gap in each column */
+  for (i = 0; i < columns; ++i){
+    int const type = s->schema->types[i];
+    size_t const cell_size = ledger_table_cell_size(type);
+    unsigned char* const cells = s->columns[i];
+    union ledger_table_cell cell;
+    ledger_table_store_cell(s, i, index, &cell);
+    ledger_table_store_cell_clear(type, cell);
+    if (index+1 < s->rows){
+      memmove(cells+index*cell_size, cells+(index+1)*cell_size,
+          (s->rows-index-1)*cell_size);
+    }
+  }
+  if (s->dead != NULL && index+1 < s->rows)
+    memmove(s->dead+index, s->dead+index+1, s->rows-index-1);
+  ledger_util_free(s->live);
+  s->live = NULL;
+  s->rows -= 1;
+  /* move marks on the dropped row to the previous row */{
+    struct ledger_table_mark* m;
+    for (m = s->marks; m != NULL; m = m->next_mark){
+      if (m->index > index)
+        m->index -= 1;
+      else if (m->index == index)
+        m->index = index-1;
+    }
+  }
+  return;
+}
+
+int ledger_table_store_bury
+  (struct ledger_table_store* s, int index, struct ledger_table_mark* mark)
+{
+  int i;
+  int const columns = s->schema->columns;
+  if (s->dead == NULL){
+    s->dead = (unsigned char*)ledger_util_malloc(s->capacity);
+    if (s->dead == NULL) return 0;
+    memset(s->dead, 0, s->capacity);
+  }
+  /* release the cells now, and the slot at the next vacuum */
+  for (i = 0; i < columns; ++i){
+    union ledger_table_cell cell;
+    int const type = ledger_table_store_cell(s, i, index, &cell);
+    ledger_table_store_cell_clear(type, cell);
+  }
+  s->dead[index] = 1;
+  s->dead_count += 1;
+  ledger_util_free(s->live);
+  s->live = NULL;
+  /* other marks on the row stay on the tombstone */
+  mark->index = index-1;
+  return 1;
+}
+
+int ledger_table_store_live_row
+  (struct ledger_table_store const* s, int index, int n)
+{
+  if (s->dead != NULL){
+    while (index >= 0 && index < s->rows && s->dead[index])
+      index += n;
+  }
+  return (index >= 0 && index < s->rows) ? index : -1;
+}
+
+int ledger_table_store_move
+  (struct ledger_table_store const* s, int index, int n)
+{
+  /* the end of the table sits between the last row and the first */
+  int const span = s->rows-s->dead_count+1;
+  if (s->dead_count == 0){
+    int pos = (index < 0) ? s->rows : index;
+    pos = (pos + (n % span) + span) % span;
+    return (pos == s->rows) ? -1 : pos;
+  }
+  /* step over the tombstones */
+  if (index < 0 || !s->dead[index])
+    n %= span;
+  for (; n > 0; --n){
+    index = ledger_table_store_live_row(s, (index < 0) ? 0 : index+1, +1);
+  }
+  for (; n < 0; ++n){
+    index = ledger_table_store_live_row
+      (s, (index < 0) ? s->rows-1 : index-1, -1);
+  }
+  return index;
+}
+
+int ledger_table_store_live_build(struct ledger_table_store* s){
+  int i, count = 0;
+  if (s->live != NULL || s->dead_count == 0) return 1;
+  s->live = ledger_table_position_alloc(s->rows-s->dead_count);
+  if (s->live == NULL) return 0;
+  for (i = 0; i < s->rows; ++i){
+    if (!s->dead[i]){
+      s->live[count] = i;
+      count += 1;
+    }
+  }
+  return 1;
+}
+
+int ledger_table_store_position(struct ledger_table_store* s, int index){
+  int const count = s->rows-s->dead_count;
+  if (index < 0 || index >= s->rows){
+    return count;
+  } else if (s->dead_count == 0){
+    return index;
+  } else if (!ledger_table_store_live_build(s)){
+    return -1;
+  } else /* find the first live row at or after the index */{
+    int low = 0, high = count;
+    while (low < high){
+      int const mid = low + (high-low)/2;
+      if (s->live[mid] < index)
+        low = mid+1;
+      else high = mid;
+    }
+    return low;
+  }
+}
+
+int ledger_table_store_locate
+  (struct ledger_table_store* s, int position, int* index)
+{
+  int const count = s->rows-s->dead_count;
+  if (position < 0 || position > count){
+    return 0;
+  } else if (position == count){
+    *index = -1;
+  } else if (s->dead_count == 0){
+    *index = position;
+  } else if (!ledger_table_store_live_build(s)){
+    return 0;
+  } else *index = s->live[position];
+  return 1;
+}
+
+int ledger_table_store_repack(struct ledger_table_store* s){
+  struct ledger_util_arena* strings = NULL;
+  unsigned char** moved = NULL;
+  int const columns = s->schema->columns;
+  int spilled = 0;
+  int i, j, k;
+  /* count the strings in the arena */
+  for (i = 0; i < columns; ++i){
+    struct ledger_table_ustr const* const cells =
+      (struct ledger_table_ustr const*)s->columns[i];
+    if (s->schema->types[i] != LEDGER_TABLE_USTR) continue;
+    for (j = 0; j < s->rows; ++j){
+      if (cells[j].value.text[LEDGER_TABLE_USTR_INLINE]
+          == LEDGER_TABLE_USTR_SPILL
+      &&  cells[j].value.heap != NULL)
+      {
+        if (spilled >= INT_MAX-1) return 0;
+        spilled += 1;
+      }
+    }
+  }
+  /* copy them, keeping the old ones until every copy succeeds */
+  if (spilled > 0){
+    if ((size_t)spilled >= (~(size_t)0)/sizeof(unsigned char*))
+      return 0;
+    moved = (unsigned char**)ledger_util_malloc
+      (spilled*sizeof(unsigned char*));
+    strings = ledger_util_arena_new(0);
+    if (moved == NULL || strings == NULL){
+      ledger_util_free(moved);
+      ledger_util_arena_free(strings);
+      return 0;
+    }
+    for (i = 0, k = 0; i < columns; ++i){
+      struct ledger_table_ustr const* const cells =
+        (struct ledger_table_ustr const*)s->columns[i];
+      if (s->schema->types[i] != LEDGER_TABLE_USTR) continue;
+      for (j = 0; j < s->rows; ++j){
+        size_t len;
+        if (cells[j].value.text[LEDGER_TABLE_USTR_INLINE]
+            != LEDGER_TABLE_USTR_SPILL
+        ||  cells[j].value.heap == NULL)
+          continue;
+        len = ledger_util_ustrlen(cells[j].value.heap);
+        moved[k] = (unsigned char*)ledger_util_arena_alloc(strings, len+1);
+        if (moved[k] == NULL){
+          ledger_util_free(moved);
+          ledger_util_arena_free(strings);
+          return 0;
+        }
+        memcpy(moved[k], cells[j].value.heap, len+1);
+        k += 1;
+      }
+    }
+    for (i = 0, k = 0; i < columns; ++i){
+      struct ledger_table_ustr* const cells =
+        (struct ledger_table_ustr*)s->columns[i];
+      if (s->schema->types[i] != LEDGER_TABLE_USTR) continue;
+      for (j = 0; j < s->rows; ++j){
+        if (cells[j].value.text[LEDGER_TABLE_USTR_INLINE]
+            == LEDGER_TABLE_USTR_SPILL
+        &&  cells[j].value.heap != NULL)
+        {
+          cells[j].value.heap = moved[k];
+          k += 1;
+        }
+      }
+    }
+    ledger_util_free(moved);
+  }
+  ledger_util_arena_free(s->strings);
+  s->strings = strings;
+  return 1;
+}
+
+int ledger_table_store_vacuum(struct ledger_table_store* s){
+  int const columns = s->schema->columns;
+  int const count = s->rows-s->dead_count;
+  int i, j;
+  if (!ledger_table_store_live_build(s)) return 0;
+  if (s->strings != NULL && !ledger_table_store_repack(s)) return 0;
+  if (s->dead_count == 0) return 1;
+  /* move the live rows over the tombstones */
+  for (i = 0; i < columns; ++i){
+    size_t const cell_size = ledger_table_cell_size(s->schema->types[i]);
+    unsigned char* const cells = s->columns[i];
+    for (j = 0; j < count; ++j){
+      if (s->live[j] != j){
+        memcpy(cells+j*cell_size, cells+((size_t)s->live[j])*cell_size,
+            cell_size);
+      }
+    }
+  }
+  /* move marks on tombstones to the previous row */{
+    struct ledger_table_mark* m;
+    for (m = s->marks; m != NULL; m = m->next_mark){
+      if (m->index >= 0){
+        int const position = ledger_table_store_position(s, m->index);
+        m->index = s->dead[m->index] ? position-1 : position;
+      }
+    }
+  }
+  s->rows = count;
+  s->dead_count = 0;
+  ledger_util_free(s->dead);
+  s->dead = NULL;
+  ledger_util_free(s->live);
+  s->live = NULL;
+  return 1;
+}
+
+void ledger_table_store_attach_mark
+  (struct ledger_table_store* s, struct ledger_table_mark* mark)
+{
+  ledger_table_schema_lock_shared(s->schema);
+  ledger_util_lock_exclusive(s->schema->cache_lock);
+  mark->prev_mark = NULL;
+  mark->next_mark = s->marks;
+  if (s->marks != NULL)
+    s->marks->prev_mark = mark;
+  s->marks = mark;
+  ledger_util_unlock_exclusive(s->schema->cache_lock);
+  ledger_table_schema_unlock_shared(s->schema);
+  return;
+}
+
+void ledger_table_store_detach_mark
+  (struct ledger_table_store* s, struct ledger_table_mark* mark)
+{
+  ledger_table_schema_lock_shared(s->schema);
+  ledger_util_lock_exclusive(s->schema->cache_lock);
+  if (mark->prev_mark != NULL)
+    mark->prev_mark->next_mark = mark->next_mark;
+  else
+    s->marks = mark->next_mark;
+  if (mark->next_mark != NULL)
+    mark->next_mark->prev_mark = mark->prev_mark;
+  mark->prev_mark = NULL;
+  mark->next_mark = NULL;
+  ledger_util_unlock_exclusive(s->schema->cache_lock);
+  ledger_table_schema_unlock_shared(s->schema);
+  return;
+}
+
+void ledger_table_row_free_cb(void* ptr){
+  struct ledger_table_row* r = (struct ledger_table_row*)ptr;
+  /*assert (r->schema != NULL);*/{
+    int n = r->schema->columns;
+    int const* schema = r->schema->types;
+    ledger_table_row_clear(r, n, schema);
+  }
+  return;
+}
+
+struct ledger_table_row* ledger_table_row_new
+  (struct ledger_table_schema const* sch)
+{
+  struct ledger_table_schema* new_schema;
+  struct ledger_table_row* new_row;
+  if (sch == NULL) return NULL;
+  else {
+    new_schema =
+      ledger_table_schema_acquire((struct ledger_table_schema*)sch);
+    if (new_schema == NULL) return NULL;
+  }
+  /* allocate the row */{
+    int const n = new_schema->columns;
+    new_row = (struct ledger_table_row*)ledger_util_ref_malloc
+        ( sizeof(struct ledger_table_row)+n*sizeof(union ledger_table_item),
+          ledger_table_row_free_cb);
+  }
+  if (new_row != NULL){
+    int const* const schema = new_schema->types;
+    int const n = new_schema->columns;
+    int ok = 0;
+    do {
+      int i;
+      int entry_ok = 1;
+      /* initialize row pointers */
+      new_row->next = new_row;
+      new_row->prev = new_row;
+      new_row->schema = new_schema;
+      new_row->root_tf = 0;
+      new_row->position = 0;
+      /* initialize each element in the row */
+      for (i = 0; i < n; ++i){
+        union ledger_table_cell cell;
+        if (ledger_table_row_cell(new_row, i, &cell) == schema[i]){
+          ledger_table_cell_init(schema[i], cell);
+          entry_ok = 1;
+        }
+        if (!entry_ok) break;
+      }
+      if (!entry_ok) break;
+      ok = 1;
+    } while (0);
+    if (!ok){
+      ledger_util_ref_free(new_row);
+      new_row = NULL;
+    }
+  } else ledger_table_schema_free(new_schema);
+  return new_row;
+  /* NOTE POST_CONDITION: row has a schema */
+}
+
+void ledger_table_row_free(struct ledger_table_row* r){
+  ledger_util_ref_free(r);
+  return;
+}
+
+void ledger_table_row_clear
+  (struct ledger_table_row* r, int n, int const* schema)
+{
+  /* NOTE PRE_CONDITION: row has a schema */
+  /* release the neighbors of a dropped row */if (r->position < 0){
+    ledger_table_row_free(r->prev);
+    ledger_table_row_free(r->next);
+    r->prev = r;
+    r->next = r;
+  }
+  /* free the row entries */{
+    int i;
+    for (i = 0; i < n; ++i){
+      union ledger_table_cell cell;
+      if (ledger_table_row_cell(r, i, &cell) == schema[i])
+        ledger_table_cell_clear(schema[i], cell);
+    }
+  }
+  /* release the schema */{
+    ledger_table_schema_free(r->schema);
+  }
+  return;
+}
+
+int ledger_table_row_attach
+  (struct ledger_table_row* new_row, struct ledger_table_row* old_row)
+{
+  /* refuse attachment of rows of different shapes */
+  if (new_row->schema != old_row->schema) return 0;
+  ledger_table_schema_lock(new_row->schema);
+  new_row->prev = old_row->prev;
+  new_row->next = old_row;
+  old_row->prev->next = new_row;
+  old_row->prev = new_row;
+  ledger_table_schema_unlock(new_row->schema);
+  return 1;
+}
+
+void ledger_table_row_detach(struct ledger_table_row* r){
+  /* NOTE the neighbors are held for marks still on this row */
+  ledger_table_row_acquire(r->prev);
+  ledger_table_row_acquire(r->next);
+  r->prev->next = r->next;
+  r->next->prev = r->prev;
+  r->position = -1;
+  return;
+}
+
+struct ledger_table_row* ledger_table_row_acquire
+  (struct ledger_table_row* r)
+{
+  return (struct ledger_table_row*)ledger_util_ref_acquire(r);
+}
+
+void ledger_table_drop_all_rows(struct ledger_table* table){
+  ledger_table_index_release(table);
+  if (table->root != NULL){
+    struct ledger_table_observer_list* const observers = table->observers;
+    struct ledger_table_mark* slow_mark = ledger_table_end(table);
+    if (slow_mark == NULL){
+      /* give up and */return;
+    }
+    /* observers hear of the reset, not of each row */
+    table->observers = NULL;
+    ledger_table_mark_move(slow_mark, -1);
+    while (slow_mark->row != table->root){
+      ledger_table_drop_row(slow_mark);
+    }
+    table->observers = observers;
+    ledger_table_mark_free(slow_mark);
+  }
+  return;
+}
+
+int ledger_table_index_build(struct ledger_table* t){
+  struct ledger_table_row* r;
+  int count = 0;
+  if (t->positions != NULL) return 1;
+  else if (t->root == NULL) return 0;
+  /* count the rows */
+  for (r = t->root->next; r != t->root; r = r->next){
+    if (count >= INT_MAX-1) return 0;
+    count += 1;
+  }
+  /* allocate the index */{
+    int const capacity = (count > 0) ? count : 8;
+    if ((size_t)capacity >= (~(size_t)0)/sizeof(struct ledger_table_row*))
+      return 0;
+    t->positions = (struct ledger_table_row**)ledger_util_malloc
+      (capacity*sizeof(struct ledger_table_row*));
+    if (t->positions == NULL) return 0;
+    t->position_capacity = capacity;
+  }
+  /* fill the index */
+  count = 0;
+  for (r = t->root->next; r != t->root; r = r->next){
+    r->position = count;
+    t->positions[count] = r;
+    count += 1;
+  }
+  t->position_count = count;
+  t->position_stale = count;
+  return 1;
+}
+
+void ledger_table_index_release(struct ledger_table* t){
+  ledger_util_free(t->positions);
+  t->positions = NULL;
+  t->position_count = 0;
+  t->position_capacity = 0;
+  t->position_stale = 0;
+  return;
+}
+
+int ledger_table_index_find
+  (struct ledger_table* t, struct ledger_table_row* r)
+{
+  int position = r->position;
+  if (position < 0 || t->positions == NULL){
+    return -1;
+  } else if (position < t->position_stale
+    &&  t->positions[position] == r)
+  {
+    return position;
+  } else {
+    /* refresh the stale positions */
+    int i;
+    for (i = t->position_stale; i < t->position_count; ++i){
+      t->positions[i]->position = i;
+    }
+    t->position_stale = t->position_count;
+    position = r->position;
+    if (position < t->position_count && t->positions[position] == r)
+      return position;
+    else return -1;
+  }
+}
+
+void ledger_table_index_insert
+  ( struct ledger_table* t, struct ledger_table_row* r,
+    struct ledger_table_row* next)
+{
+  int position;
+  if (t->positions == NULL) return;
+  position = next->root_tf
+    ? t->position_count : ledger_table_index_find(t, next);
+  if (position < 0 || t->position_count >= INT_MAX-1){
+    /* rebuild later */
+    ledger_table_index_release(t);
+    return;
+  }
+  if (t->position_count >= t->position_capacity){
+    struct ledger_table_row** new_positions;
+    int new_capacity = t->position_capacity;
+    if (new_capacity > INT_MAX/2
+    ||  (size_t)new_capacity*2 >=
+          (~(size_t)0)/sizeof(struct ledger_table_row*))
+    {
+      ledger_table_index_release(t);
+      return;
+    }
+    new_capacity *= 2;
+    new_positions = (struct ledger_table_row**)ledger_util_malloc
+      (new_capacity*sizeof(struct ledger_table_row*));
+    if (new_positions == NULL){
+      ledger_table_index_release(t);
+      return;
+    }
+    memcpy(new_positions, t->positions,
+        t->position_count*sizeof(struct ledger_table_row*));
+    ledger_util_free(t->positions);
+    t->positions = new_positions;
+    t->position_capacity = new_capacity;
+  }
+  memmove(t->positions+position+1, t->positions+position,
+      (t->position_count-position)*sizeof(struct ledger_table_row*));
+  t->positions[position] = r;
+  r->position = position;
+  t->position_count += 1;
+  if (t->position_stale >= position)
+    t->position_stale = position+1;
+  return;
+}
+
+void ledger_table_index_erase
+  (struct ledger_table* t, struct ledger_table_row* r)
+{
+  int position;
+  if (t->positions == NULL) return;
+  position = ledger_table_index_find(t, r);
+  if (position < 0){
+    /* rebuild later */
+    ledger_table_index_release(t);
+    return;
+  }
+  memmove(t->positions+position, t->positions+position+1,
+      (t->position_count-position-1)*sizeof(struct ledger_table_row*));
+  t->position_count -= 1;
+  if (t->position_stale > position)
+    t->position_stale = position;
+  return;
+}
+
+int ledger_table_key_at
+  ( struct ledger_table const* t, int column, int position,
+    struct ledger_table_key* key)
+{
+  union ledger_table_cell cell;
+  int type;
+  if (t->store != NULL){
+    int index;
+    if (!ledger_table_store_locate(t->store, position, &index) || index < 0)
+      return 0;
+    type = ledger_table_store_cell(t->store, column, index, &cell);
+  } else {
+    if (position < 0 || position >= t->position_count) return 0;
+    type = ledger_table_row_cell(t->positions[position], column, &cell);
+  }
+  switch (type){
+  case LEDGER_TABLE_ID:
+  case LEDGER_TABLE_INDEX:
+    key->id = *cell.item_id;
+    key->text = NULL;
+    break;
+  case LEDGER_TABLE_DATE:
+    key->id = *cell.date;
+    key->text = NULL;
+    break;
+  case LEDGER_TABLE_USTR:
+    key->id = -1;
+    key->text = ledger_table_ustr_get(cell.string);
+    if (key->text == NULL)
+      key->text = (unsigned char const*)"";
+    break;
+  default:
+    return 0;
+  }
+  return type;
+}
+
+int ledger_table_key_compare
+  ( int type, struct ledger_table_key const* a,
+    struct ledger_table_key const* b)
+{
+  if (type == LEDGER_TABLE_USTR)
+    return ledger_util_ustrcmp(a->text, b->text);
+  else if (a->id < b->id)
+    return -1;
+  else return (a->id > b->id) ? +1 : 0;
+}
+
+unsigned int ledger_table_key_hash
+  (int type, struct ledger_table_key const* key)
+{
+  /* FNV-1a */
+  unsigned int h = 2166136261u;
+  if (type == LEDGER_TABLE_USTR){
+    unsigned char const* p;
+    for (p = key->text; *p != 0; ++p){
+      h = (h ^ *p) * 16777619u;
+    }
+  } else {
+    unsigned long long int v = (unsigned long long int)key->id;
+    int i;
+    for (i = 0; i < 8; ++i, v >>= 8){
+      h = (h ^ (v&255u)) * 16777619u;
+    }
+  }
+  return h;
+}
+
+int ledger_table_key_in_range
+  ( int type, struct ledger_table_key const* key,
+    struct ledger_table_key const* low, int low_inclusive_tf,
+    struct ledger_table_key const* high, int high_inclusive_tf)
+{
+  if (low != NULL){
+    int const cmp = ledger_table_key_compare(type, key, low);
+    if (cmp < 0 || (cmp == 0 && !low_inclusive_tf))
+      return 0;
+  }
+  if (high != NULL){
+    int const cmp = ledger_table_key_compare(type, key, high);
+    if (cmp > 0 || (cmp == 0 && !high_inclusive_tf))
+      return 0;
+  }
+  return 1;
+}
+
+int ledger_table_key_order
+  ( struct ledger_table const* t,
+    struct ledger_table_column_index const* ci, int a, int b)
+{
+  struct ledger_table_key key_a, key_b;
+  int const type = ledger_table_key_at(t, ci->column, a, &key_a);
+  int cmp;
+  if (type == 0 || ledger_table_key_at(t, ci->column, b, &key_b) != type)
+    cmp = 0;
+  else cmp = ledger_table_key_compare(type, &key_a, &key_b);
+  if (cmp != 0)
+    return cmp;
+  else if (a < b)
+    return -1;
+  else return (a > b) ? +1 : 0;
+}
+
+void ledger_table_key_sort
+  ( struct ledger_table const* t,
+    struct ledger_table_column_index const* ci, int* a, int n, int* tmp)
+{
+  /* bottom-up merge sort, since `qsort` takes no context */
+  int width;
+  int* src = a;
+  int* dst = tmp;
+  for (width = 1; width < n; width = (width > n/2) ? n : width*2){
+    int start;
+    for (start = 0; start < n; start += 2*width){
+      int const mid = (n-start > width) ? start+width : n;
+      int const stop = (n-mid > width) ? mid+width : n;
+      int i = start, j = mid, k = start;
+      while (i < mid && j < stop){
+        if (ledger_table_key_order(t, ci, src[j], src[i]) < 0)
+          dst[k++] = src[j++];
+        else
+          dst[k++] = src[i++];
+      }
+      while (i < mid) dst[k++] = src[i++];
+      while (j < stop) dst[k++] = src[j++];
+    }
+    /* swap the roles */{
+      int* const swap = src;
+      src = dst;
+      dst = swap;
+    }
+  }
+  if (src != a)
+    memcpy(a, src, n*sizeof(int));
+  return;
+}
+
+int ledger_table_position_compare(void const* a, void const* b){
+  int const x = *(int const*)a;
+  int const y = *(int const*)b;
+  if (x < y) return -1;
+  else return (x > y) ? +1 : 0;
+}
+
+int* ledger_table_position_alloc(int n){
+  if (n < 1) n = 1;
+  if ((size_t)n >= (~(size_t)0)/sizeof(int))
+    return NULL;
+  else return (int*)ledger_util_malloc(n*sizeof(int));
+}
+
+int ledger_table_position_count(struct ledger_table* t){
+  if (t->store != NULL)
+    return t->store->rows-t->store->dead_count;
+  else if (!ledger_table_index_build(t))
+    return -1;
+  else return t->position_count;
+}
+
+int ledger_table_mark_position(struct ledger_table_mark const* mark){
+  struct ledger_table* const t = (struct ledger_table*)mark->source;
+  if (mark->store != NULL){
+    return ledger_table_store_position(mark->store, mark->index);
+  } else if (!mark->row->root_tf && mark->row->position < 0){
+    /* row already dropped */
+    return -1;
+  } else if (!ledger_table_index_build(t)){
+    return -1;
+  } else if (mark->row->root_tf){
+    return t->position_count;
+  } else return ledger_table_index_find(t, mark->row);
+}
+
+struct ledger_table_column_index* ledger_table_column_index_find
+  (struct ledger_table const* t, int column)
+{
+  struct ledger_table_column_index* ci;
+  for (ci = t->column_indexes; ci != NULL; ci = ci->next){
+    if (ci->column == column) break;
+  }
+  return ci;
+}
+
+void ledger_table_column_index_reset(struct ledger_table_column_index* ci){
+  ledger_util_free(ci->order);
+  ci->order = NULL;
+  ledger_util_free(ci->slots);
+  ci->slots = NULL;
+  ci->count = 0;
+  ci->capacity = 0;
+  ci->used = 0;
+  ledger_util_free(ci->tail);
+  ci->tail = NULL;
+  ci->tail_count = 0;
+  ci->tail_capacity = 0;
+  ci->stale_tf = 1;
+  return;
+}
+
+void ledger_table_column_index_free(struct ledger_table_column_index* ci){
+  if (ci != NULL){
+    ledger_table_column_index_reset(ci);
+    ledger_util_free(ci);
+  }
+  return;
+}
+
+void ledger_table_column_index_release(struct ledger_table* t){
+  while (t->column_indexes != NULL){
+    struct ledger_table_column_index* const ci = t->column_indexes;
+    t->column_indexes = ci->next;
+    ledger_table_column_index_free(ci);
+  }
+  return;
+}
+
+int ledger_table_column_index_build
+  (struct ledger_table* t, struct ledger_table_column_index* ci)
+{
+  int const rows = ledger_table_position_count(t);
+  int i;
+  ledger_table_column_index_reset(ci);
+  if (rows < 0) return 0;
+  if (ci->kind == LEDGER_TABLE_ORDERED_INDEX){
+    int* tmp;
+    ci->order = ledger_table_position_alloc(rows);
+    if (ci->order == NULL) return 0;
+    ci->capacity = rows;
+    tmp = ledger_table_position_alloc(rows);
+    if (tmp == NULL){
+      ledger_table_column_index_reset(ci);
+      return 0;
+    }
+    for (i = 0; i < rows; ++i){
+      ci->order[i] = i;
+    }
+    ledger_table_key_sort(t, ci, ci->order, rows, tmp);
+    ledger_util_free(tmp);
+    ci->count = rows;
+  } else {
+    for (i = 0; i < rows; ++i){
+      if (!ledger_table_column_index_slot_put(t, ci, i)){
+        ledger_table_column_index_reset(ci);
+        return 0;
+      }
+    }
+  }
+  ci->stale_tf = 0;
+  return 1;
+}
+
+void ledger_table_column_index_push
+  (struct ledger_table_column_index* ci, int position)
+{
+  if (ci->tail_count >= LEDGER_TABLE_INDEX_TAIL
+  &&  ci->tail_count >= ci->count)
+  {
+    /* rebuilding costs less than merging */
+    ledger_table_column_index_reset(ci);
+    return;
+  }
+  if (ci->tail_count >= ci->tail_capacity){
+    int* new_tail;
+    int new_capacity = ci->tail_capacity;
+    if (new_capacity > INT_MAX/2){
+      ledger_table_column_index_reset(ci);
+      return;
+    }
+    new_capacity = (new_capacity > 0) ? new_capacity*2 : 8;
+    new_tail = ledger_table_position_alloc(new_capacity);
+    if (new_tail == NULL){
+      ledger_table_column_index_reset(ci);
+      return;
+    }
+    if (ci->tail_count > 0)
+      memcpy(new_tail, ci->tail, ci->tail_count*sizeof(int));
+    ledger_util_free(ci->tail);
+    ci->tail = new_tail;
+    ci->tail_capacity = new_capacity;
+  }
+  ci->tail[ci->tail_count] = position;
+  ci->tail_count += 1;
+  return;
+}
+
+int ledger_table_column_index_slot_put
+  ( struct ledger_table const* t, struct ledger_table_column_index* ci,
+    int position)
+{
+  struct ledger_table_key key;
+  unsigned int hash, mask;
+  int const type = ledger_table_key_at(t, ci->column, position, &key);
+  if (type == 0) return 0;
+  hash = ledger_table_key_hash(type, &key);
+  /* keep the load factor under three quarters */
+  if (ci->used >= ci->capacity/4*3){
+    struct ledger_table_column_slot* new_slots;
+    int new_capacity = 16;
+    int i;
+    while (new_capacity/4*3 <= ci->count+1){
+      if (new_capacity > INT_MAX/2) return 0;
+      new_capacity *= 2;
+    }
+    if ((size_t)new_capacity >=
+        (~(size_t)0)/sizeof(struct ledger_table_column_slot))
+      return 0;
+    new_slots = (struct ledger_table_column_slot*)ledger_util_malloc
+      (new_capacity*sizeof(struct ledger_table_column_slot));
+    if (new_slots == NULL) return 0;
+    for (i = 0; i < new_capacity; ++i){
+      new_slots[i].position = LEDGER_TABLE_SLOT_EMPTY;
+    }
+    /* move the live slots */
+    mask = (unsigned int)new_capacity-1u;
+    for (i = 0; i < ci->capacity; ++i){
+      if (ci->slots[i].position >= 0){
+        unsigned int j = ci->slots[i].hash & mask;
+        while (new_slots[j].position != LEDGER_TABLE_SLOT_EMPTY){
+          j = (j+1u) & mask;
+        }
+        new_slots[j] = ci->slots[i];
+      }
+    }
+    ledger_util_free(ci->slots);
+    ci->slots = new_slots;
+    ci->capacity = new_capacity;
+    ci->used = ci->count;
+  }
+  /* add the row */{
+    unsigned int j;
+    mask = (unsigned int)ci->capacity-1u;
+    j = hash & mask;
+    while (ci->slots[j].position >= 0){
+      j = (j+1u) & mask;
+    }
+    if (ci->slots[j].position == LEDGER_TABLE_SLOT_EMPTY)
+      ci->used += 1;
+    ci->slots[j].hash = hash;
+    ci->slots[j].position = position;
+    ci->count += 1;
+  }
+  return 1;
+}
+
+int ledger_table_column_index_merge
+  (struct ledger_table const* t, struct ledger_table_column_index* ci)
+{
+  if (ci->tail_count == 0){
+    return 1;
+  } else if (ci->kind == LEDGER_TABLE_ORDERED_INDEX){
+    int const total = ci->count + ci->tail_count;
+    int* const merged = ledger_table_position_alloc(total);
+    int* const tmp = ledger_table_position_alloc(ci->tail_count);
+    int i = 0, j = 0, k = 0;
+    if (merged == NULL || tmp == NULL){
+      ledger_util_free(merged);
+      ledger_util_free(tmp);
+      return 0;
+    }
+    ledger_table_key_sort(t, ci, ci->tail, ci->tail_count, tmp);
+    ledger_util_free(tmp);
+    while (i < ci->count && j < ci->tail_count){
+      if (ledger_table_key_order(t, ci, ci->tail[j], ci->order[i]) < 0)
+        merged[k++] = ci->tail[j++];
+      else
+        merged[k++] = ci->order[i++];
+    }
+    while (i < ci->count) merged[k++] = ci->order[i++];
+    while (j < ci->tail_count) merged[k++] = ci->tail[j++];
+    ledger_util_free(ci->order);
+    ci->order = merged;
+    ci->count = total;
+    ci->capacity = total;
+    ci->tail_count = 0;
+    return 1;
+  } else {
+    int j;
+    for (j = 0; j < ci->tail_count; ++j){
+      if (!ledger_table_column_index_slot_put(t, ci, ci->tail[j]))
+        return 0;
+    }
+    ci->tail_count = 0;
+    return 1;
+  }
+}
+
+int ledger_table_column_index_detach
+  ( struct ledger_table const* t, struct ledger_table_column_index* ci,
+    int position)
+{
+  if (ci->kind == LEDGER_TABLE_ORDERED_INDEX){
+    int low = 0, high = ci->count;
+    while (low < high){
+      int const mid = low + (high-low)/2;
+      if (ledger_table_key_order(t, ci, ci->order[mid], position) < 0)
+        low = mid+1;
+      else high = mid;
+    }
+    if (low >= ci->count || ci->order[low] != position)
+      return 0;
+    memmove(ci->order+low, ci->order+low+1,
+        (ci->count-low-1)*sizeof(int));
+    ci->count -= 1;
+    return 1;
+  } else if (ci->capacity > 0){
+    struct ledger_table_key key;
+    unsigned int hash, mask, j;
+    int const type = ledger_table_key_at(t, ci->column, position, &key);
+    if (type == 0) return 0;
+    hash = ledger_table_key_hash(type, &key);
+    mask = (unsigned int)ci->capacity-1u;
+    for (j = hash & mask; ci->slots[j].position != LEDGER_TABLE_SLOT_EMPTY;
+        j = (j+1u) & mask)
+    {
+      if (ci->slots[j].position == position){
+        ci->slots[j].position = LEDGER_TABLE_SLOT_REMOVED;
+        ci->count -= 1;
+        return 1;
+      }
+    }
+    return 0;
+  } else return 0;
+}
+
+void ledger_table_column_index_shift
+  (struct ledger_table_column_index* ci, int from, int n)
+{
+  int i;
+  if (ci->order != NULL){
+    for (i = 0; i < ci->count; ++i){
+      if (ci->order[i] >= from) ci->order[i] += n;
+    }
+  }
+  if (ci->slots != NULL){
+    for (i = 0; i < ci->capacity; ++i){
+      if (ci->slots[i].position >= from) ci->slots[i].position += n;
+    }
+  }
+  for (i = 0; i < ci->tail_count; ++i){
+    if (ci->tail[i] >= from) ci->tail[i] += n;
+  }
+  return;
+}
+
+void ledger_table_column_index_note_put
+  (struct ledger_table_mark const* mark, int column)
+{
+  struct ledger_table* t;
+  struct ledger_table_column_index* ci;
+  int position;
+  if (ledger_table_schema_is_outdated_sub(ledger_table_mark_schema(mark)))
+    return;
+  t = (struct ledger_table*)mark->source;
+  ci = ledger_table_column_index_find(t, column);
+  if (ci == NULL || ci->stale_tf || ledger_table_mark_at_end(mark))
+    return;
+  if (mark->store == NULL && mark->row->position < 0)
+    /* row no longer in the table */return;
+  position = ledger_table_mark_position(mark);
+  if (position < 0){
+    ledger_table_column_index_reset(ci);
+  } else if (ledger_table_column_index_detach(t, ci, position)){
+    ledger_table_column_index_push(ci, position);
+  } /* else the row waits in the tail already */
+  return;
+}
+
+void ledger_table_column_index_note_add
+  (struct ledger_table* t, int position, int at_end_tf)
+{
+  struct ledger_table_column_index* ci;
+  for (ci = t->column_indexes; ci != NULL; ci = ci->next){
+    if (ci->stale_tf){
+      continue;
+    } else if (position < 0){
+      ledger_table_column_index_reset(ci);
+      continue;
+    }
+    if (!at_end_tf)
+      ledger_table_column_index_shift(ci, position, +1);
+    ledger_table_column_index_push(ci, position);
+  }
+  return;
+}
+
+void ledger_table_column_index_note_drop
+  (struct ledger_table* t, int position)
+{
+  struct ledger_table_column_index* ci;
+  for (ci = t->column_indexes; ci != NULL; ci = ci->next){
+    if (ci->stale_tf){
+      continue;
+    } else if (position < 0){
+      ledger_table_column_index_reset(ci);
+      continue;
+    }
+    if (!ledger_table_column_index_detach(t, ci, position)){
+      /* remove the row from the tail */
+      int i;
+      for (i = 0; i < ci->tail_count; ++i){
+        if (ci->tail[i] == position) break;
+      }
+      if (i < ci->tail_count){
+        ci->tail[i] = ci->tail[ci->tail_count-1];
+        ci->tail_count -= 1;
+      }
+    }
+    ledger_table_column_index_shift(ci, position+1, -1);
+  }
+  return;
+}
+
+int ledger_table_column_index_lookup
+  ( struct ledger_table* t, struct ledger_table_column_index* ci,
+    int type, struct ledger_table_key const* low, int low_inclusive_tf,
+    struct ledger_table_key const* high, int high_inclusive_tf,
+    int** positions)
+{
+  int first = 0, stop = 0;
+  int count = 0;
+  int* out;
+  int i;
+  if (ci->stale_tf && !ledger_table_column_index_build(t, ci))
+    return -1;
+  if (t->store == NULL && !ledger_table_index_build(t))
+    return -1;
+  if (ci->kind != LEDGER_TABLE_ORDERED_INDEX
+  ||  ci->tail_count > LEDGER_TABLE_INDEX_TAIL)
+  {
+    if (!ledger_table_column_index_merge(t, ci)){
+      ledger_table_column_index_reset(ci);
+      return -1;
+    }
+  }
+  /* count the candidates */
+  if (ci->kind == LEDGER_TABLE_ORDERED_INDEX){
+    int high_mark = ci->count;
+    stop = ci->count;
+    while (first < stop){
+      int const mid = first + (stop-first)/2;
+      struct ledger_table_key key;
+      ledger_table_key_at(t, ci->column, ci->order[mid], &key);
+      if (ledger_table_key_in_range
+          (type, &key, low, low_inclusive_tf, NULL, 0))
+        stop = mid;
+      else first = mid+1;
+    }
+    stop = first;
+    while (stop < high_mark){
+      int const mid = stop + (high_mark-stop)/2;
+      struct ledger_table_key key;
+      ledger_table_key_at(t, ci->column, ci->order[mid], &key);
+      if (ledger_table_key_in_range
+          (type, &key, NULL, 0, high, high_inclusive_tf))
+        stop = mid+1;
+      else high_mark = mid;
+    }
+    count = stop-first;
+  } else if (ci->capacity > 0){
+    unsigned int const hash = ledger_table_key_hash(type, low);
+    unsigned int const mask = (unsigned int)ci->capacity-1u;
+    unsigned int j;
+    for (j = hash & mask; ci->slots[j].position != LEDGER_TABLE_SLOT_EMPTY;
+        j = (j+1u) & mask)
+    {
+      struct ledger_table_key key;
+      if (ci->slots[j].position < 0 || ci->slots[j].hash != hash)
+        continue;
+      ledger_table_key_at(t, ci->column, ci->slots[j].position, &key);
+      if (ledger_table_key_compare(type, &key, low) == 0)
+        count += 1;
+    }
+  }
+  out = ledger_table_position_alloc(count + ci->tail_count);
+  if (out == NULL) return -1;
+  /* collect the candidates */
+  if (ci->kind == LEDGER_TABLE_ORDERED_INDEX){
+    memcpy(out, ci->order+first, count*sizeof(int));
+  } else if (count > 0){
+    unsigned int const hash = ledger_table_key_hash(type, low);
+    unsigned int const mask = (unsigned int)ci->capacity-1u;
+    unsigned int j;
+    count = 0;
+    for (j = hash & mask; ci->slots[j].position != LEDGER_TABLE_SLOT_EMPTY;
+        j = (j+1u) & mask)
+    {
+      struct ledger_table_key key;
+      if (ci->slots[j].position < 0 || ci->slots[j].hash != hash)
+        continue;
+      ledger_table_key_at(t, ci->column, ci->slots[j].position, &key);
+      if (ledger_table_key_compare(type, &key, low) == 0)
+        out[count++] = ci->slots[j].position;
+    }
+  }
+  for (i = 0; i < ci->tail_count; ++i){
+    struct ledger_table_key key;
+    ledger_table_key_at(t, ci->column, ci->tail[i], &key);
+    if (ledger_table_key_in_range
+        (type, &key, low, low_inclusive_tf, high, high_inclusive_tf))
+      out[count++] = ci->tail[i];
+  }
+  qsort(out, count, sizeof(int), ledger_table_position_compare);
+  *positions = out;
+  return count;
+}
+
+void ledger_table_schema_free_cb(void* ptr){
+  ledger_table_schema_clear((struct ledger_table_schema*)ptr);
+  return;
+}
+
+struct ledger_table_column_aggregate* ledger_table_column_aggregate_find
+  (struct ledger_table const* t, int column)
+{
+  struct ledger_table_column_aggregate* ca;
+  for (ca = t->column_aggregates; ca != NULL; ca = ca->next){
+    if (ca->column == column) return ca;
+  }
+  return NULL;
+}
+
+void ledger_table_column_aggregate_free
+  (struct ledger_table_column_aggregate* ca)
+{
+  if (ca != NULL){
+    ledger_bignum_free(ca->sum);
+    ledger_bignum_free(ca->min);
+    ledger_bignum_free(ca->max);
+    ledger_bignum_free(ca->value);
+    ledger_util_free(ca);
+  }
+  return;
+}
+
+void ledger_table_column_aggregate_release(struct ledger_table* t){
+  while (t->column_aggregates != NULL){
+    struct ledger_table_column_aggregate* const ca = t->column_aggregates;
+    t->column_aggregates = ca->next;
+    ledger_table_column_aggregate_free(ca);
+  }
+  return;
+}
+
+int ledger_table_column_aggregate_value
+  (struct ledger_table_mark const* mark, int column, struct ledger_bignum* n)
+{
+  union ledger_table_cell cell;
+  switch (ledger_table_mark_cell(mark, column, &cell)){
+  case LEDGER_TABLE_ID:
+  case LEDGER_TABLE_INDEX:
+    return ledger_bignum_set_long(n, *cell.item_id) ? 1 : -1;
+  case LEDGER_TABLE_BIGNUM:
+    if (cell.amount->point_place == LEDGER_TABLE_AMOUNT_NONE)
+      return 0;
+    return ledger_table_amount_fetch(n, cell.amount) ? 1 : -1;
+  default:
+    return -1;
+  }
+}
+
+int ledger_table_column_aggregate_apply
+  ( struct ledger_table_column_aggregate* ca, struct ledger_bignum const* n,
+    int direction)
+{
+  if (direction > 0){
+    if (!ledger_bignum_add_assign(ca->sum, n)) return 0;
+    ca->count += 1;
+    if (ca->extremes_stale_tf){
+      /* wait for the rescan */;
+    } else if (ca->count == 1){
+      if (!ledger_bignum_assign(ca->min, n)) return 0;
+      if (!ledger_bignum_assign(ca->max, n)) return 0;
+    } else {
+      if (ledger_bignum_compare(n, ca->min) < 0
+      &&  !ledger_bignum_assign(ca->min, n))
+        return 0;
+      if (ledger_bignum_compare(n, ca->max) > 0
+      &&  !ledger_bignum_assign(ca->max, n))
+        return 0;
+    }
+  } else {
+    if (!ledger_bignum_subtract_assign(ca->sum, n)) return 0;
+    ca->count -= 1;
+    if (ca->count == 0){
+      ca->extremes_stale_tf = 0;
+    } else if (ledger_bignum_compare(n, ca->min) == 0
+      ||  ledger_bignum_compare(n, ca->max) == 0)
+    {
+      ca->extremes_stale_tf = 1;
+    }
+  }
+  return 1;
+}
+
+int ledger_table_column_aggregate_build
+  (struct ledger_table const* t, struct ledger_table_column_aggregate* ca)
+{
+  ca->stale_tf = 1;
+  ca->extremes_stale_tf = 0;
+  if (!ledger_table_scan_column_sub
+      (t, ca->column, NULL, ca->sum, ca->min, ca->max, &ca->count))
+    return 0;
+  ca->stale_tf = 0;
+  return 1;
+}
+
+void ledger_table_column_aggregate_note
+  (struct ledger_table_mark const* mark, int column, int direction)
+{
+  struct ledger_table* t;
+  struct ledger_table_column_aggregate* ca;
+  int has_value;
+  if (ledger_table_schema_is_outdated_sub(ledger_table_mark_schema(mark)))
+    return;
+  t = (struct ledger_table*)mark->source;
+  ca = ledger_table_column_aggregate_find(t, column);
+  if (ca == NULL || ca->stale_tf || ledger_table_mark_at_end(mark))
+    return;
+  if (mark->store == NULL && mark->row->position < 0)
+    /* row no longer in the table */return;
+  has_value = ledger_table_column_aggregate_value(mark, column, ca->value);
+  if (has_value < 0
+  ||  (has_value > 0
+    && !ledger_table_column_aggregate_apply(ca, ca->value, direction)))
+  {
+    ca->stale_tf = 1;
+  }
+  return;
+}
+
+void ledger_table_column_aggregate_note_row
+  (struct ledger_table_mark const* mark, int direction)
+{
+  struct ledger_table_column_aggregate const* ca;
+  for (ca = mark->source->column_aggregates; ca != NULL; ca = ca->next){
+    ledger_table_column_aggregate_note(mark, ca->column, direction);
+  }
+  return;
+}
+
+int ledger_table_scan_init(struct ledger_table_scan* sc, int type){
+  sc->type = type;
+  sc->bits = NULL;
+  sc->marks = NULL;
+  sc->count = 0;
+  sc->sum = 0;
+  sc->sum_place = 0;
+  sc->accum = NULL;
+  sc->min.value.fixed = 0;
+  sc->min.point_place = 0;
+  sc->max = sc->min;
+  sc->low = LLONG_MIN;
+  sc->high = LLONG_MAX;
+  sc->low_amount = sc->min;
+  sc->high_amount = sc->min;
+  sc->low_least = -1;
+  sc->high_most = +1;
+  sc->registers[0] = NULL;
+  sc->registers[1] = NULL;
+  if (type == LEDGER_TABLE_BIGNUM){
+    sc->registers[0] = ledger_bignum_new();
+    sc->registers[1] = ledger_bignum_new();
+    if (sc->registers[0] == NULL || sc->registers[1] == NULL){
+      ledger_table_scan_clear(sc);
+      return 0;
+    }
+  }
+  return 1;
+}
+
+void ledger_table_scan_clear(struct ledger_table_scan* sc){
+  ledger_bignum_accum_free(sc->accum);
+  sc->accum = NULL;
+  ledger_bignum_free(sc->registers[0]);
+  ledger_bignum_free(sc->registers[1]);
+  sc->registers[0] = NULL;
+  sc->registers[1] = NULL;
+  return;
+}
+
+int ledger_table_scan_add_fixed
+  (struct ledger_table_scan* sc, long long int value, int point_place)
+{
+  long long int left = sc->sum;
+  long long int right = value;
+  int place = sc->sum_place;
+  int fits;
+  /* align the centesimal points */
+  if (place < point_place){
+    fits = ledger_table_amount_scale(&left, place, point_place);
+    place = point_place;
+  } else fits = ledger_table_amount_scale(&right, point_place, place);
+  if (fits
+  &&  (right > 0 ? left <= LLONG_MAX-right : left >= -LLONG_MAX-right))
+  {
+    sc->sum = left+right;
+    sc->sum_place = place;
+    return 1;
+  }
+  /* spill to the accumulator */
+  if (sc->accum == NULL){
+    sc->accum = ledger_bignum_accum_new();
+    if (sc->accum == NULL) return 0;
+  }
+  return ledger_bignum_accum_add_fixed(sc->accum, value, point_place);
+}
+
+int ledger_table_scan_note_extremes
+  (struct ledger_table_scan* sc, struct ledger_table_amount const* a)
+{
+  int sign;
+  if (sc->count == 0){
+    sc->min = *a;
+    sc->max = *a;
+    return 1;
+  }
+  if (!ledger_table_amount_compare(a, &sc->min, sc->registers, &sign))
+    return 0;
+  if (sign < 0){
+    sc->min = *a;
+    return 1;
+  }
+  if (!ledger_table_amount_compare(a, &sc->max, sc->registers, &sign))
+    return 0;
+  if (sign > 0)
+    sc->max = *a;
+  return 1;
+}
+
+int ledger_table_scan_check_amount
+  ( struct ledger_table_scan* sc, struct ledger_table_amount const* a,
+    int* yes)
+{
+  int sign;
+  *yes = 0;
+  if (sc->low_least >= 0){
+    if (!ledger_table_amount_compare(a, &sc->low_amount, sc->registers, &sign))
+      return 0;
+    if (sign < sc->low_least) return 1;
+  }
+  if (sc->high_most <= 0){
+    if (!ledger_table_amount_compare(a, &sc->high_amount, sc->registers, &sign))
+      return 0;
+    if (sign > sc->high_most) return 1;
+  }
+  *yes = 1;
+  return 1;
 }
 
-int ledger_table_init(struct ledger_table* t){
-  /* NOTE pre-clear compatible */
-  t->schema = NULL;
-  t->rows = 0;
-  t->root = NULL;
-  t->lock_tf = 0;
-  /* allocate a root */{
-    struct ledger_table_row* root;
-    struct ledger_table_schema* schema = ledger_table_schema_new(0,NULL);
-    if (schema == NULL) return 0;
-    root = ledger_table_row_new(schema);
-    if (root == NULL){
-      ledger_table_schema_free(schema);
-      return 0;
+int ledger_table_scan_sum_ids
+  ( struct ledger_table_scan* sc, union ledger_table_cell cells,
+    int position, int n)
+{
+  int const* const ids = cells.item_id;
+  long long int sum = 0;
+  int least = INT_MAX, greatest = INT_MIN;
+  int count = 0;
+  int i;
+  if (sc->bits == NULL){
+    /* plain loop, left for the compiler to vectorize */
+    for (i = 0; i < n; ++i){
+      int const v = ids[i];
+      sum += v;
+      least = (v < least) ? v : least;
+      greatest = (v > greatest) ? v : greatest;
     }
-    root->root_tf = 1;
-    t->root = root;
-    t->schema = schema;
+    count = n;
+  } else for (i = 0; i < n; ++i){
+    int const bit = position+i;
+    int const v = ids[i];
+    if (!((sc->bits[bit>>3] >> (bit&7)) & 1u)) continue;
+    sum += v;
+    least = (v < least) ? v : least;
+    greatest = (v > greatest) ? v : greatest;
+    count += 1;
   }
-  /* POST_CONDITION table has a schema */
-  return 1;
+  if (count == 0) return 1;
+  /* identifiers are whole, so the extremes compare inline */
+  if (sc->count == 0 || least < sc->min.value.fixed)
+    sc->min.value.fixed = least;
+  if (sc->count == 0 || greatest > sc->max.value.fixed)
+    sc->max.value.fixed = greatest;
+  sc->count += count;
+  return ledger_table_scan_add_fixed(sc, sum, 0);
 }
 
-void ledger_table_clear(struct ledger_table* t){
-  if (t->schema == NULL){
-    /* rows never made */
-  } else {
-    /* if only one reference held on this table, then no lock necessary */
-    if (ledger_table_schema_outdate(t->schema)){
-      if (t->root != NULL){
-        ledger_table_drop_all_rows(t);
+int ledger_table_scan_sum_amounts
+  ( struct ledger_table_scan* sc, union ledger_table_cell cells,
+    int position, int n)
+{
+  int i;
+  for (i = 0; i < n; ++i){
+    struct ledger_table_amount const* const a = cells.amount+i;
+    int const point_place = a->point_place;
+    if (sc->bits != NULL){
+      int const bit = position+i;
+      if (!((sc->bits[bit>>3] >> (bit&7)) & 1u)) continue;
+    }
+    if (point_place == LEDGER_TABLE_AMOUNT_NONE){
+      continue;
+    } else if (point_place == LEDGER_TABLE_AMOUNT_BIG){
+      if (sc->accum == NULL){
+        sc->accum = ledger_bignum_accum_new();
+        if (sc->accum == NULL) return 0;
+      }
+      if (!ledger_bignum_accum_add(sc->accum, a->value.bignum)) return 0;
+      if (!ledger_table_scan_note_extremes(sc, a)) return 0;
+    } else {
+      long long int const v = a->value.fixed;
+      /* fast path: same places as the running sum, and no overflow */
+      if (point_place == sc->sum_place
+      &&  (v > 0 ? sc->sum <= LLONG_MAX-v : sc->sum >= -LLONG_MAX-v))
+      {
+        sc->sum += v;
+      } else if (!ledger_table_scan_add_fixed(sc, v, point_place)){
+        return 0;
+      }
+      if (sc->count > 0
+      &&  sc->min.point_place == point_place
+      &&  sc->max.point_place == point_place)
+      {
+        if (v < sc->min.value.fixed) sc->min = *a;
+        else if (v > sc->max.value.fixed) sc->max = *a;
+      } else if (!ledger_table_scan_note_extremes(sc, a)){
+        return 0;
       }
-      ledger_table_schema_close(t->schema);
     }
-    ledger_table_row_free(t->root);
-    ledger_table_schema_free(t->schema);
-    t->root = NULL;
-    t->schema = NULL;
+    sc->count += 1;
   }
-  /*assert(t->lock_tf == 0);*/
-  return;
+  return 1;
 }
 
-struct ledger_table_mark* ledger_table_mark_new
-  ( struct ledger_table const* t, struct ledger_table_row const* r,
-    int mutable_flag)
+int ledger_table_scan_filter_ids
+  ( struct ledger_table_scan* sc, union ledger_table_cell cells,
+    int position, int n)
 {
-  struct ledger_table_mark* ptr;
-  ptr = (struct ledger_table_mark*)
-    ledger_util_ref_malloc(sizeof(struct ledger_table_mark),
-        ledger_table_mark_free_cb);
-  if (!ledger_table_mark_init(t,r,mutable_flag,ptr)){
-    ledger_util_ref_free(ptr);
-    ptr = NULL;
+  int const* const ids = cells.item_id;
+  unsigned char* const marks = sc->marks + (position>>3);
+  long long int const low = sc->low;
+  long long int const high = sc->high;
+  int count = 0;
+  int i;
+  /* one byte of marks per eight cells */
+  for (i = 0; i < n; i += 8){
+    int const stop = (n-i < 8) ? n-i : 8;
+    unsigned int byte = 0;
+    int j;
+    for (j = 0; j < stop; ++j){
+      unsigned int const yes = (ids[i+j] >= low) & (ids[i+j] <= high);
+      byte |= yes << j;
+      count += yes;
+    }
+    marks[i>>3] = (unsigned char)byte;
   }
-  return ptr;
+  sc->count += count;
+  return 1;
 }
 
-int ledger_table_mark_init
-  ( struct ledger_table const* t, struct ledger_table_row const* r,
-    int mutable_flag, struct ledger_table_mark* ptr)
+int ledger_table_scan_filter_dates
+  ( struct ledger_table_scan* sc, union ledger_table_cell cells,
+    int position, int n)
 {
-  struct ledger_table_row* row =
-    ledger_table_row_acquire((struct ledger_table_row*)r);
-  if (row == NULL){
-    ptr->source = 0;
-    ptr->row = NULL;
-    ptr->mutable_flag = 0;
-    return 0;
+  long long int const* const dates = cells.date;
+  unsigned char* const marks = sc->marks + (position>>3);
+  long long int const low = sc->low;
+  long long int const high = sc->high;
+  int count = 0;
+  int i;
+  /* one byte of marks per eight cells */
+  for (i = 0; i < n; i += 8){
+    int const stop = (n-i < 8) ? n-i : 8;
+    unsigned int byte = 0;
+    int j;
+    for (j = 0; j < stop; ++j){
+      unsigned int const yes = (dates[i+j] >= low) & (dates[i+j] <= high);
+      byte |= yes << j;
+      count += yes;
+    }
+    marks[i>>3] = (unsigned char)byte;
   }
-  /* put mark contents */{
-    ptr->source = t;
-    ptr->row = (struct ledger_table_row*)r;
-    ptr->mutable_flag = mutable_flag;
+  sc->count += count;
+  return 1;
+}
+
+int ledger_table_scan_filter_amounts
+  ( struct ledger_table_scan* sc, union ledger_table_cell cells,
+    int position, int n)
+{
+  unsigned char* const marks = sc->marks + (position>>3);
+  int i;
+  for (i = 0; i < n; i += 8){
+    int const stop = (n-i < 8) ? n-i : 8;
+    unsigned int byte = 0;
+    int j;
+    for (j = 0; j < stop; ++j){
+      int yes;
+      if (!ledger_table_scan_check_amount(sc, cells.amount+i+j, &yes))
+        return 0;
+      byte |= (unsigned int)yes << j;
+      sc->count += yes;
+    }
+    marks[i>>3] = (unsigned char)byte;
   }
   return 1;
 }
 
-void ledger_table_mark_clear(struct ledger_table_mark* m){
-  ledger_table_row_free(m->row);
+void ledger_table_scan_gather
+  ( int type, union ledger_table_cell group, int i,
+    union ledger_table_cell cell)
+{
+  switch (type){
+  case LEDGER_TABLE_BIGNUM:
+    group.amount[i] = *cell.amount;
+    break;
+  case LEDGER_TABLE_DATE:
+    group.date[i] = *cell.date;
+    break;
+  default:
+    group.item_id[i] = *cell.item_id;
+    break;
+  }
   return;
 }
 
-void ledger_table_mark_free_cb(void* m){
-  ledger_table_mark_clear((struct ledger_table_mark*)m);
+int ledger_table_scan_run
+  ( struct ledger_table const* t, int column, struct ledger_table_scan* sc,
+    ledger_table_scan_cb cb)
+{
+  union {
+    int item_id[LEDGER_TABLE_SCAN_GROUP];
+    struct ledger_table_amount amount[LEDGER_TABLE_SCAN_GROUP];
+    long long int date[LEDGER_TABLE_SCAN_GROUP];
+  } group;
+  union ledger_table_cell cells;
+  struct ledger_table_store const* const s = t->store;
+  int position = 0, n = 0;
+  if (s != NULL && s->dead_count == 0){
+    /* the column is one array: scan it in place */
+    if (s->rows == 0) return 1;
+    ledger_table_store_cell(s, column, 0, &cells);
+    return (*cb)(sc, cells, 0, s->rows);
+  }
+  switch (sc->type){
+  case LEDGER_TABLE_BIGNUM:
+    cells.amount = group.amount;
+    break;
+  case LEDGER_TABLE_DATE:
+    cells.date = group.date;
+    break;
+  default:
+    cells.item_id = group.item_id;
+    break;
+  }
+  if (s != NULL){
+    int i;
+    for (i = 0; i < s->rows; ++i){
+      union ledger_table_cell cell;
+      if (s->dead[i]) continue;
+      ledger_table_store_cell(s, column, i, &cell);
+      ledger_table_scan_gather(sc->type, cells, n, cell);
+      n += 1;
+      if (n == LEDGER_TABLE_SCAN_GROUP){
+        if (!(*cb)(sc, cells, position, n)) return 0;
+        position += n;
+        n = 0;
+      }
+    }
+  } else if (t->root != NULL){
+    struct ledger_table_row* r;
+    for (r = t->root->next; r != t->root; r = r->next){
+      union ledger_table_cell cell;
+      if (ledger_table_row_cell(r, column, &cell) != sc->type) return 0;
+      ledger_table_scan_gather(sc->type, cells, n, cell);
+      n += 1;
+      if (n == LEDGER_TABLE_SCAN_GROUP){
+        if (!(*cb)(sc, cells, position, n)) return 0;
+        position += n;
+        n = 0;
+      }
+    }
+  }
+  return (n > 0) ? (*cb)(sc, cells, position, n) : 1;
 }
 
-int ledger_table_mark_add_one_checked(struct ledger_table_mark* m){
-  int consistent_tf;
-  struct ledger_table_row *const row = m->row;
-  ledger_table_schema_lock(row->schema);
-  if (row->next != row){
-    ledger_table_mark_exchange(m, row->next);
-    consistent_tf = 1;
-  } else consistent_tf = 0;
-  ledger_table_schema_unlock(row->schema);
-  return consistent_tf;
+int ledger_table_scan_column_sub
+  ( struct ledger_table const* t, int column, unsigned char const* bits,
+    struct ledger_bignum* sum, struct ledger_bignum* min,
+    struct ledger_bignum* max, int* count)
+{
+  int ok;
+  struct ledger_table_scan sc;
+  int type;
+  if (column < 0 || column >= t->schema->columns) return 0;
+  type = t->schema->types[column];
+  if (!ledger_table_scan_init(&sc, type)) return 0;
+  sc.bits = bits;
+  switch (type){
+  case LEDGER_TABLE_ID:
+  case LEDGER_TABLE_INDEX:
+    ok = ledger_table_scan_run(t, column, &sc, ledger_table_scan_sum_ids);
+    break;
+  case LEDGER_TABLE_BIGNUM:
+    ok = ledger_table_scan_run(t, column, &sc, ledger_table_scan_sum_amounts);
+    break;
+  default:
+    ok = 0;
+    break;
+  }
+  if (ok && sum != NULL){
+    if (sc.accum == NULL){
+      ok = ledger_bignum_set_fixed(sum, sc.sum, sc.sum_place);
+    } else {
+      /* merge the inline sum, then carry once */
+      ok = ledger_bignum_accum_add_fixed(sc.accum, sc.sum, sc.sum_place)
+        && ledger_bignum_accum_get(sc.accum, sum);
+    }
+  }
+  if (ok && min != NULL){
+    ok = (sc.count > 0)
+      ? ledger_table_amount_fetch(min, &sc.min)
+      : ledger_bignum_set_long(min, 0);
+  }
+  if (ok && max != NULL){
+    ok = (sc.count > 0)
+      ? ledger_table_amount_fetch(max, &sc.max)
+      : ledger_bignum_set_long(max, 0);
+  }
+  if (ok && count != NULL)
+    *count = sc.count;
+  ledger_table_scan_clear(&sc);
+  return ok;
 }
 
-void ledger_table_row_free_cb(void* ptr){
-  struct ledger_table_row* r = (struct ledger_table_row*)ptr;
-  /*assert (r->schema != NULL);*/{
-    int n = r->schema->columns;
-    int const* schema = r->schema->types;
-    ledger_table_row_clear(r, n, schema);
+int ledger_table_scale_amounts
+  (struct ledger_bignum_rate* rate, struct ledger_table_amount* a, int n)
+{
+  int i;
+  for (i = 0; i < n; ++i){
+    struct ledger_table_amount* const amount = a+i;
+    struct ledger_bignum* bignum;
+    long long int fixed;
+    int point_place;
+    if (amount->point_place == LEDGER_TABLE_AMOUNT_NONE)
+      continue;
+    if (amount->point_place != LEDGER_TABLE_AMOUNT_BIG){
+      fixed = amount->value.fixed;
+      point_place = amount->point_place;
+      if (ledger_bignum_rate_apply_fixed(rate, &fixed, &point_place)){
+        amount->value.fixed = fixed;
+        amount->point_place = point_place;
+        continue;
+      }
+    }
+    /* the product needs a full big number */
+    bignum = ledger_table_amount_promote(amount);
+    if (bignum == NULL
+    ||  !ledger_bignum_rate_apply(rate, bignum, bignum))
+      return 0;
+    if (ledger_bignum_get_fixed(bignum, &fixed, &point_place)){
+      /* the product fits inline again */
+      ledger_bignum_free(bignum);
+      amount->value.fixed = fixed;
+      amount->point_place = point_place;
+    }
+  }
+  return 1;
+}
+
+struct ledger_table_column_prefix* ledger_table_column_prefix_find
+  (struct ledger_table const* t, int column, int key_column)
+{
+  struct ledger_table_column_prefix* cp;
+  for (cp = t->column_prefixes; cp != NULL; cp = cp->next){
+    if (cp->column == column && cp->key_column == key_column) return cp;
+  }
+  return NULL;
+}
+
+void ledger_table_column_prefix_free(struct ledger_table_column_prefix* cp){
+  if (cp != NULL){
+    int i;
+    for (i = 0; i < cp->allocated; ++i){
+      ledger_bignum_free(cp->tree[i]);
+    }
+    ledger_util_free(cp->tree);
+    ledger_util_free(cp->keys);
+    ledger_bignum_free(cp->value);
+    ledger_util_free(cp);
   }
   return;
 }
 
-struct ledger_table_row* ledger_table_row_new
-  (struct ledger_table_schema const* sch)
+void ledger_table_column_prefix_release(struct ledger_table* t){
+  while (t->column_prefixes != NULL){
+    struct ledger_table_column_prefix* const cp = t->column_prefixes;
+    t->column_prefixes = cp->next;
+    ledger_table_column_prefix_free(cp);
+  }
+  return;
+}
+
+int ledger_table_column_prefix_key
+  (struct ledger_table_mark const* mark, int column, long long int* key)
 {
-  struct ledger_table_schema* new_schema;
-  struct ledger_table_row* new_row;
-  if (sch == NULL) return NULL;
-  else {
-    new_schema =
-      ledger_table_schema_acquire((struct ledger_table_schema*)sch);
-    if (new_schema == NULL) return NULL;
+  union ledger_table_cell cell;
+  switch (ledger_table_mark_cell(mark, column, &cell)){
+  case LEDGER_TABLE_ID:
+  case LEDGER_TABLE_INDEX:
+    *key = *cell.item_id;
+    return 1;
+  case LEDGER_TABLE_DATE:
+    *key = *cell.date;
+    return 1;
+  default:
+    return 0;
   }
-  /* allocate the row */{
-    int const n = new_schema->columns;
-    new_row = (struct ledger_table_row*)ledger_util_ref_malloc
-        ( sizeof(struct ledger_table_row)+n*sizeof(union ledger_table_item),
-          ledger_table_row_free_cb);
+}
+
+int ledger_table_prefix_row_compare(void const* a, void const* b){
+  struct ledger_table_prefix_row const* const x =
+    (struct ledger_table_prefix_row const*)a;
+  struct ledger_table_prefix_row const* const y =
+    (struct ledger_table_prefix_row const*)b;
+  if (x->key != y->key) return (x->key < y->key) ? -1 : +1;
+  else return ledger_table_position_compare(&x->position, &y->position);
+}
+
+int ledger_table_column_prefix_push
+  ( struct ledger_table_column_prefix* cp, long long int key,
+    struct ledger_bignum const* n)
+{
+  int const i = cp->count+1;
+  int step;
+  struct ledger_bignum* node;
+  if (cp->count >= cp->capacity){
+    int new_capacity;
+    long long int* new_keys;
+    struct ledger_bignum** new_tree;
+    if (cp->capacity >= INT_MAX/2) return 0;
+    new_capacity = (cp->capacity > 0) ? cp->capacity*2 : 16;
+    if ((size_t)new_capacity >= (~(size_t)0)/sizeof(long long int))
+      return 0;
+    new_keys = (long long int*)ledger_util_malloc
+      (new_capacity*sizeof(long long int));
+    if (new_keys == NULL) return 0;
+    new_tree = (struct ledger_bignum**)ledger_util_malloc
+      (new_capacity*sizeof(struct ledger_bignum*));
+    if (new_tree == NULL){
+      ledger_util_free(new_keys);
+      return 0;
+    }
+    if (cp->count > 0)
+      memcpy(new_keys, cp->keys, cp->count*sizeof(long long int));
+    if (cp->allocated > 0){
+      memcpy(new_tree, cp->tree,
+        cp->allocated*sizeof(struct ledger_bignum*));
+    }
+    ledger_util_free(cp->keys);
+    ledger_util_free(cp->tree);
+    cp->keys = new_keys;
+    cp->tree = new_tree;
+    cp->capacity = new_capacity;
   }
-  if (new_row != NULL){
-    int const* const schema = new_schema->types;
-    int const n = new_schema->columns;
-    int ok = 0;
-    do {
-      int i;
-      int entry_ok = 1;
-      /* initialize row pointers */
-      new_row->next = new_row;
-      new_row->prev = new_row;
-      new_row->schema = new_schema;
-      new_row->root_tf = 0;
-      /* initialize each element in the row */
-      for (i = 0; i < n; ++i){
-        switch (schema[i]){
-        case LEDGER_TABLE_ID:
-        case LEDGER_TABLE_INDEX:
-          new_row->data[i].item_id = 0;
-          entry_ok = 1;
-          break;
-        case LEDGER_TABLE_BIGNUM:
-          new_row->data[i].bignum = NULL;
-          entry_ok = 1;
-          break;
-        case LEDGER_TABLE_USTR:
-          new_row->data[i].string = NULL;
-          entry_ok = 1;
-          break;
-        }
-        if (!entry_ok) break;
-      }
-      if (!entry_ok) break;
-      ok = 1;
-    } while (0);
-    if (!ok){
-      ledger_util_ref_free(new_row);
-      new_row = NULL;
+  if (cp->count >= cp->allocated){
+    cp->tree[cp->allocated] = ledger_bignum_new();
+    if (cp->tree[cp->allocated] == NULL) return 0;
+    cp->allocated += 1;
+  }
+  /* the node covers this entry and the nodes just below it */
+  node = cp->tree[i-1];
+  if (!ledger_bignum_assign(node, n)) return 0;
+  for (step = 1; step < (i & -i); step <<= 1){
+    if (!ledger_bignum_add_assign(node, cp->tree[i-step-1])) return 0;
+  }
+  cp->keys[cp->count] = key;
+  cp->count = i;
+  return 1;
+}
+
+int ledger_table_column_prefix_update
+  (struct ledger_table const* t, struct ledger_table_column_prefix* cp)
+{
+  int ok = 1;
+  int pending;
+  int sorted_tf = 1;
+  int i;
+  struct ledger_table_prefix_row* rows = NULL;
+  struct ledger_table_cursor cursor;
+  struct ledger_table_mark const* const mark =
+    ledger_table_cursor_mark(&cursor);
+  if (cp->stale_tf){
+    cp->count = 0;
+    cp->covered = 0;
+    cp->stale_tf = 0;
+  }
+  pending = t->rows - cp->covered;
+  if (pending <= 0) return 1;
+  rows = (struct ledger_table_prefix_row*)ledger_util_malloc
+    (pending*sizeof(struct ledger_table_prefix_row));
+  if (rows == NULL){
+    cp->stale_tf = 1;
+    return 0;
+  }
+  /* read the keys of the pending rows */
+  ledger_table_cursor_begin(&cursor, t);
+  if (!ledger_table_cursor_seek(&cursor, cp->covered))
+    ok = 0;
+  for (i = 0; ok && i < pending; ++i, ledger_table_cursor_move(&cursor, +1)){
+    rows[i].position = cp->covered+i;
+    if (!ledger_table_column_prefix_key(mark, cp->key_column, &rows[i].key))
+      ok = 0;
+    else if (i > 0 && rows[i].key < rows[i-1].key)
+      sorted_tf = 0;
+  }
+  if (ok && !sorted_tf)
+    qsort(rows, pending, sizeof(*rows), ledger_table_prefix_row_compare);
+  if (ok && cp->count > 0 && rows[0].key < cp->keys[cp->count-1]){
+    /* keys out of order need a rebuild */
+    ledger_util_free(rows);
+    cp->stale_tf = 1;
+    return ledger_table_column_prefix_update(t, cp);
+  }
+  /* append the rows in key order */
+  for (i = 0; ok && i < pending; ++i){
+    int has_value;
+    if (!ledger_table_cursor_seek(&cursor, rows[i].position)){
+      ok = 0;
+      break;
     }
-  } else ledger_table_schema_free(new_schema);
-  return new_row;
-  /* NOTE POST_CONDITION: row has a schema */
+    has_value =
+      ledger_table_column_aggregate_value(mark, cp->column, cp->value);
+    if (has_value < 0
+    ||  (has_value == 0 && !ledger_bignum_set_long(cp->value, 0)))
+    {
+      ok = 0;
+      break;
+    }
+    ok = ledger_table_column_prefix_push(cp, rows[i].key, cp->value);
+  }
+  ledger_util_free(rows);
+  if (ok) cp->covered = t->rows;
+  else cp->stale_tf = 1;
+  return ok;
 }
 
-void ledger_table_row_free(struct ledger_table_row* r){
-  ledger_util_ref_free(r);
+void ledger_table_column_prefix_note_put
+  (struct ledger_table_mark const* mark, int column)
+{
+  struct ledger_table* t;
+  struct ledger_table_column_prefix* cp;
+  int position = -2;
+  if (ledger_table_schema_is_outdated_sub(ledger_table_mark_schema(mark)))
+    return;
+  t = (struct ledger_table*)mark->source;
+  for (cp = t->column_prefixes; cp != NULL; cp = cp->next){
+    if (cp->stale_tf || cp->covered == 0
+    ||  (cp->column != column && cp->key_column != column))
+      continue;
+    if (position == -2){
+      if (ledger_table_mark_at_end(mark)
+      ||  (mark->store == NULL && mark->row->position < 0))
+        /* row not in the table */return;
+      position = ledger_table_mark_position(mark);
+    }
+    /* changes to rows in the tree need a rebuild */
+    if (position < 0 || position < cp->covered)
+      cp->stale_tf = 1;
+  }
   return;
 }
 
-void ledger_table_row_clear
-  (struct ledger_table_row* r, int n, int const* schema)
+void ledger_table_column_prefix_note_row
+  (struct ledger_table* t, int position)
 {
-  /* NOTE PRE_CONDITION: row has a schema */
-  /* detach the row */{
-    ledger_table_schema_lock(r->schema);
-    r->prev->next = r->next;
-    r->next->prev = r->prev;
-    ledger_table_schema_unlock(r->schema);
+  struct ledger_table_column_prefix* cp;
+  for (cp = t->column_prefixes; cp != NULL; cp = cp->next){
+    if (position < 0 || position < cp->covered)
+      cp->stale_tf = 1;
   }
-  /* free the row entries */{
-    int i;
-    for (i = 0; i < n; ++i){
-      switch (schema[i]){
-      case LEDGER_TABLE_ID:
-      case LEDGER_TABLE_INDEX:
-        r->data[i].item_id = 0;
-        break;
-      case LEDGER_TABLE_BIGNUM:
-        ledger_bignum_free(r->data[i].bignum);
-        break;
-      case LEDGER_TABLE_USTR:
-        ledger_util_free(r->data[i].string);
-        break;
-      }
+  return;
+}
+
+struct ledger_table_observer_list* ledger_table_observer_list_new(void){
+  struct ledger_table_observer_list* list =
+    (struct ledger_table_observer_list*)ledger_util_ref_malloc
+      ( sizeof(struct ledger_table_observer_list),
+        ledger_table_observer_list_free_cb);
+  if (list != NULL){
+    list->first = NULL;
+    list->depth = 0;
+    list->lock = ledger_util_lock_new();
+    if (list->lock == NULL){
+      ledger_util_ref_free(list);
+      list = NULL;
     }
   }
-  /* release the schema */{
-    ledger_table_schema_free(r->schema);
+  return list;
+}
+
+void ledger_table_observer_list_free_cb(void* list){
+  struct ledger_table_observer_list* const l =
+    (struct ledger_table_observer_list*)list;
+  ledger_table_observer_release(l, 0);
+  ledger_util_lock_free(l->lock);
+  l->lock = NULL;
+  return;
+}
+
+void ledger_table_observer_release
+  (struct ledger_table_observer_list* list, int dropped_tf)
+{
+  struct ledger_table_observer** link = &list->first;
+  while (*link != NULL){
+    struct ledger_table_observer* const ob = *link;
+    if (dropped_tf && ob->cb != NULL){
+      link = &ob->next;
+    } else {
+      *link = ob->next;
+      ledger_util_free(ob);
+    }
   }
   return;
 }
 
-int ledger_table_row_attach
-  (struct ledger_table_row* new_row, struct ledger_table_row* old_row)
+void ledger_table_observer_notify
+  ( struct ledger_table* t, int event, struct ledger_table_mark const* mark,
+    int column)
 {
-  /* refuse attachment of rows of different shapes */
-  if (new_row->schema != old_row->schema) return 0;
-  ledger_table_schema_lock(new_row->schema);
-  new_row->prev = old_row->prev;
-  new_row->next = old_row;
-  old_row->prev->next = new_row;
-  old_row->prev = new_row;
-  ledger_table_schema_unlock(new_row->schema);
+  struct ledger_table_observer const* ob;
+  struct ledger_table_observer_list* const list = t->observers;
+  int const row = (mark != NULL) ? ledger_table_mark_position(mark) : -1;
+  if (list == NULL) return;
+  /* the list may be shared with other copies of the table */
+  ledger_util_lock_exclusive(list->lock);
+  list->depth += 1;
+  for (ob = list->first; ob != NULL; ob = ob->next){
+    if (ob->cb != NULL)
+      (*ob->cb)(ob->arg, event, mark, row, column);
+  }
+  list->depth -= 1;
+  if (list->depth == 0)
+    ledger_table_observer_release(list, 1);
+  ledger_util_unlock_exclusive(list->lock);
+  return;
+}
+
+void ledger_table_observer_note_put
+  (struct ledger_table_mark const* mark, int column)
+{
+  struct ledger_table* t;
+  if (ledger_table_schema_is_outdated_sub(ledger_table_mark_schema(mark)))
+    return;
+  t = (struct ledger_table*)mark->source;
+  if (t->observers == NULL || ledger_table_mark_at_end(mark))
+    return;
+  if (mark->store == NULL && mark->row->position < 0)
+    /* row no longer in the table */return;
+  ledger_table_observer_notify(t, LEDGER_TABLE_CELL_PUT, mark, column);
+  return;
+}
+
+unsigned long long int ledger_table_fingerprint_mix
+  (unsigned long long int x)
+{
+  /* splitmix64 finalizer */
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ull;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebull;
+  x ^= x >> 31;
+  return x;
+}
+
+int ledger_table_fingerprint_amount
+  (struct ledger_table_amount const* a, unsigned long long int* h)
+{
+  long long int value = 0;
+  int point = 0;
+  if (a->point_place == LEDGER_TABLE_AMOUNT_BIG){
+    unsigned char buf[48];
+    unsigned char* text = buf;
+    unsigned char const* p;
+    int const len = ledger_bignum_text_length(a->value.bignum, 0)+1;
+    int negative = 0, fraction = 0, fraction_zeroes = 0, fits = 1;
+    unsigned long long int text_hash;
+    if (len > (int)sizeof(buf)){
+      text = (unsigned char*)ledger_util_malloc(len);
+      if (text == NULL) return 0;
+    }
+    ledger_bignum_get_text(a->value.bignum, text, len, 0);
+    /* FNV-1a over the digits, without leading or trailing zeroes */
+    text_hash = 14695981039346656037ull;
+    p = text;
+    if (*p == '-'){
+      negative = 1;
+      ++p;
+    }
+    for (; *p == '0'; ++p) continue;
+    for (; *p != 0; ++p){
+      int const digit = *p - '0';
+      if (*p == '.'){
+        fraction = 1;
+        continue;
+      } else if (fraction && digit == 0){
+        /* hold back zeroes until a later digit needs them */
+        fraction_zeroes += 1;
+        continue;
+      } else if (fraction == 1){
+        text_hash = (text_hash ^ '.') * 1099511628211ull;
+        fraction = 2;
+      }
+      for (; fraction_zeroes > 0; --fraction_zeroes){
+        if (value > LLONG_MAX/10) fits = 0;
+        else value *= 10;
+        point += 1;
+        text_hash = (text_hash ^ '0') * 1099511628211ull;
+      }
+      if (value > (LLONG_MAX-digit)/10) fits = 0;
+      else value = value*10 + digit;
+      if (fraction) point += 1;
+      text_hash = (text_hash ^ *p) * 1099511628211ull;
+    }
+    if (text != buf)
+      ledger_util_free(text);
+    if (!fits){
+      *h = negative ? ~text_hash : text_hash;
+      return 1;
+    }
+    /* convert decimal places to centesimal places */
+    if (point%2 != 0){
+      if (value > LLONG_MAX/10){
+        *h = negative ? ~text_hash : text_hash;
+        return 1;
+      }
+      value *= 10;
+      point += 1;
+    }
+    point /= 2;
+    if (negative) value = -value;
+  } else if (a->point_place != LEDGER_TABLE_AMOUNT_NONE){
+    value = a->value.fixed;
+    point = a->point_place;
+  }
+  if (value == 0){
+    *h = 0u;
+    return 1;
+  }
+  /* drop trailing zeroes */
+  for (; point > 0 && value%100 == 0; --point){
+    value /= 100;
+  }
+  *h = ledger_table_fingerprint_mix((unsigned long long int)value)
+    ^ (unsigned long long int)point;
+  return 1;
+}
+
+int ledger_table_fingerprint_cell
+  ( struct ledger_table_mark const* mark, int column,
+    unsigned long long int* h)
+{
+  union ledger_table_cell cell;
+  unsigned long long int value;
+  switch (ledger_table_mark_cell(mark, column, &cell)){
+  case LEDGER_TABLE_ID:
+  case LEDGER_TABLE_INDEX:
+    value = (unsigned long long int)*cell.item_id;
+    break;
+  case LEDGER_TABLE_DATE:
+    value = (unsigned long long int)(*cell.date + 1);
+    break;
+  case LEDGER_TABLE_BIGNUM:
+    if (!ledger_table_fingerprint_amount(cell.amount, &value))
+      return 0;
+    break;
+  case LEDGER_TABLE_USTR:
+    /* FNV-1a */{
+      unsigned char const* p = ledger_table_ustr_get(cell.string);
+      if (p == NULL){
+        value = 0u;
+        break;
+      }
+      value = 14695981039346656037ull;
+      for (; *p != 0; ++p){
+        value = (value ^ *p) * 1099511628211ull;
+      }
+    }break;
+  default:
+    return 0;
+  }
+  *h = (value == 0u) ? 0u : ledger_table_fingerprint_mix
+      (value ^ ((unsigned long long int)(column+1) * 0x9e3779b97f4a7c15ull));
   return 1;
 }
 
-struct ledger_table_row* ledger_table_row_acquire
-  (struct ledger_table_row* r)
+void ledger_table_fingerprint_note
+  (struct ledger_table_mark const* mark, int column, int direction)
 {
-  return (struct ledger_table_row*)ledger_util_ref_acquire(r);
+  struct ledger_table* t;
+  unsigned long long int h;
+  if (ledger_table_schema_is_outdated_sub(ledger_table_mark_schema(mark)))
+    return;
+  t = (struct ledger_table*)mark->source;
+  if (t->fingerprint_stale_tf || ledger_table_mark_at_end(mark))
+    return;
+  if (mark->store == NULL && mark->row->position < 0)
+    /* row no longer in the table */return;
+  if (!ledger_table_fingerprint_cell(mark, column, &h))
+    t->fingerprint_stale_tf = 1;
+  else if (direction > 0)
+    t->fingerprint += h;
+  else
+    t->fingerprint -= h;
+  return;
 }
 
-void ledger_table_drop_all_rows(struct ledger_table* table){
-  if (table->root != NULL){
-    struct ledger_table_mark* slow_mark = ledger_table_end(table);
-    if (slow_mark == NULL){
-      /* give up and */return;
-    }
-    ledger_table_mark_move(slow_mark, -1);
-    while (slow_mark->row != table->root){
-      ledger_table_drop_row(slow_mark);
-    }
-    ledger_table_mark_free(slow_mark);
+void ledger_table_fingerprint_note_row
+  (struct ledger_table_mark const* mark, int direction)
+{
+  int i;
+  int const columns = ledger_table_mark_schema(mark)->columns;
+  for (i = 0; i < columns; ++i){
+    ledger_table_fingerprint_note(mark, i, direction);
   }
   return;
 }
 
-void ledger_table_schema_free_cb(void* ptr){
-  ledger_table_schema_clear((struct ledger_table_schema*)ptr);
-  return;
+int ledger_table_fingerprint_build(struct ledger_table const* t){
+  struct ledger_table* const mt = (struct ledger_table*)t;
+  struct ledger_table_cursor cursor;
+  struct ledger_table_mark const* const mark =
+    ledger_table_cursor_mark(&cursor);
+  unsigned long long int sum = 0u;
+  int const columns = t->schema->columns;
+  for (ledger_table_cursor_begin(&cursor, t);
+      !ledger_table_cursor_is_end(&cursor);
+      ledger_table_cursor_move(&cursor, +1))
+  {
+    int i;
+    for (i = 0; i < columns; ++i){
+      unsigned long long int h;
+      if (!ledger_table_fingerprint_cell(mark, i, &h))
+        return 0;
+      sum += h;
+    }
+  }
+  mt->fingerprint = sum;
+  mt->fingerprint_stale_tf = 0;
+  return 1;
+}
+
+int ledger_table_fingerprint_get
+  (struct ledger_table const* t, unsigned long long int* fingerprint)
+{
+  int ok = 1;
+  ledger_util_lock_exclusive(t->cache_lock);
+  if (t->fingerprint_stale_tf)
+    ok = ledger_table_fingerprint_build(t);
+  if (ok)
+    *fingerprint = t->fingerprint;
+  ledger_util_unlock_exclusive(t->cache_lock);
+  return ok;
 }
 
 struct ledger_table_schema* ledger_table_schema_new
-  (int columns, int const* types)
+  (struct ledger_table const* t, int columns, int const* types)
 {
   /* NOTE pre-clear compatible */
   struct ledger_table_schema* new_schema = (struct ledger_table_schema*)
@@ -635,7 +5119,8 @@ struct ledger_table_schema* ledger_table_schema_new
           ledger_table_schema_free_cb);
   if (new_schema != NULL){
     int i;
-    new_schema->lock_tf = 0;
+    new_schema->lock = ledger_util_lock_acquire(t->lock);
+    new_schema->cache_lock = ledger_util_lock_acquire(t->cache_lock);
     new_schema->outdated_tf = 0;
     new_schema->columns = columns;
     for (i = 0; i < columns; ++i){
@@ -663,7 +5148,10 @@ void ledger_table_schema_clear(struct ledger_table_schema* sch){
   for (i = 0; i < sch->columns; ++i){
     sch->types[i] = -1;
   }
-  /*assert(sch->lock_tf == 0);*/
+  ledger_util_lock_free(sch->cache_lock);
+  sch->cache_lock = NULL;
+  ledger_util_lock_free(sch->lock);
+  sch->lock = NULL;
   return;
 }
 
@@ -683,30 +5171,40 @@ int ledger_table_schema_is_equal
 }
 
 void ledger_table_schema_lock(struct ledger_table_schema const* t){
-  ((struct ledger_table_schema*)t)->lock_tf += 1;
+  ledger_util_lock_exclusive(t->lock);
+  return;
+}
+
+void ledger_table_schema_lock_shared(struct ledger_table_schema const* t){
+  ledger_util_lock_shared(t->lock);
   return;
 }
 
-void ledger_table_schema_lock2
+void ledger_table_schema_lock_shared2
   (struct ledger_table_schema const* t, struct ledger_table_schema const* t2)
 {
-  unsigned char buf[sizeof(struct ledger_table_schema const*)];
-  unsigned char buf2[sizeof(struct ledger_table_schema const*)];
-  memcpy(buf,&t,sizeof(t));
-  memcpy(buf2,&t2,sizeof(t2));
+  unsigned char buf[sizeof(struct ledger_util_lock*)];
+  unsigned char buf2[sizeof(struct ledger_util_lock*)];
+  memcpy(buf,&t->lock,sizeof(t->lock));
+  memcpy(buf2,&t2->lock,sizeof(t2->lock));
   /* create a fixed locking order to eliminate deadlocks */
-  if (memcmp(buf,buf2,sizeof(t)) < 0){
-    ledger_table_schema_lock(t);
-    ledger_table_schema_lock(t2);
+  if (memcmp(buf,buf2,sizeof(buf)) < 0){
+    ledger_table_schema_lock_shared(t);
+    ledger_table_schema_lock_shared(t2);
   } else {
-    ledger_table_schema_lock(t2);
-    ledger_table_schema_lock(t);
+    ledger_table_schema_lock_shared(t2);
+    ledger_table_schema_lock_shared(t);
   }
   return;
 }
 
 void ledger_table_schema_unlock(struct ledger_table_schema const* t){
-  ((struct ledger_table_schema*)t)->lock_tf -= 1;
+  ledger_util_unlock_exclusive(t->lock);
+  return;
+}
+
+void ledger_table_schema_unlock_shared(struct ledger_table_schema const* t){
+  ledger_util_unlock_shared(t->lock);
   return;
 }
 
@@ -730,22 +5228,69 @@ void ledger_table_schema_close(struct ledger_table_schema* t){
 
 int ledger_table_schema_is_outdated(struct ledger_table_schema const* t){
   int outdate;
-  ledger_table_schema_lock(t);
+  ledger_table_schema_lock_shared(t);
   outdate = t->outdated_tf;
-  ledger_table_schema_unlock(t);
+  ledger_table_schema_unlock_shared(t);
   return outdate;
 }
 
+int ledger_table_schema_is_outdated_sub(struct ledger_table_schema const* t){
+  return t->outdated_tf;
+}
+
 int ledger_table_add_row_sub(struct ledger_table_mark* mark){
-  if (mark->mutable_flag){
+  if (!mark->mutable_flag){
+    return 0;
+  } else if (mark->store != NULL){
+    int result;
+    struct ledger_table* const table = (struct ledger_table *)mark->source;
+    struct ledger_table_store* const store = mark->store;
+    if (ledger_table_schema_is_outdated_sub(store->schema)){
+      result = 0;
+    } else {
+      int const index = (mark->index < 0) ? store->rows : mark->index;
+      int const at_end_tf = (index == store->rows);
+      int const position = ledger_table_store_position(store, mark->index);
+      result = ledger_table_store_insert(store, index, mark);
+      if (result){
+        /* cache the new row count */
+        ledger_table_lock(mark->source);
+        table->rows += 1;
+        if (table->column_indexes != NULL)
+          ledger_table_column_index_note_add(table, position, at_end_tf);
+        if (table->column_aggregates != NULL)
+          ledger_table_column_aggregate_note_row(mark, +1);
+        if (table->column_prefixes != NULL)
+          ledger_table_column_prefix_note_row(table, position);
+        if (table->observers != NULL)
+          ledger_table_observer_notify(table, LEDGER_TABLE_ROW_ADDED, mark, -1);
+        ledger_table_unlock(mark->source);
+      }
+    }
+    return result;
+  } else {
     int result = 0;
     struct ledger_table* const table = (struct ledger_table *)mark->source;
-    struct ledger_table_row * const old_row = mark->row;
+    struct ledger_table_row * old_row = mark->row;
     struct ledger_table_row *new_row = NULL;
     struct ledger_table_schema const* const schema = old_row->schema;
-    if (ledger_table_schema_is_outdated(schema)){
+    int position = -1;
+    int at_end_tf = 0;
+    /* insert before the first row still in the table */
+    while (old_row->position < 0){
+      old_row = old_row->next;
+    }
+    if (ledger_table_schema_is_outdated_sub(schema)){
       result = 0;
     } else do {
+      /* find the new row's position for the column indexes */
+      if ((table->column_indexes != NULL || table->column_prefixes != NULL)
+      &&  ledger_table_index_build(table))
+      {
+        at_end_tf = old_row->root_tf;
+        position = at_end_tf
+          ? table->position_count : ledger_table_index_find(table, old_row);
+      }
       /* allocate the row */
       new_row = ledger_table_row_new(schema);
       if (new_row == NULL) break;
@@ -758,9 +5303,18 @@ int ledger_table_add_row_sub(struct ledger_table_mark* mark){
       ledger_table_mark_exchange(mark, new_row);
       /* drop the reference for this function */
       ledger_table_row_free(new_row);
-      /* cache the new row count */{
+      /* cache the new row count and position */{
         ledger_table_lock(mark->source);
         table->rows += 1;
+        ledger_table_index_insert(table, new_row, old_row);
+        if (table->column_indexes != NULL)
+          ledger_table_column_index_note_add(table, position, at_end_tf);
+        if (table->column_aggregates != NULL)
+          ledger_table_column_aggregate_note_row(mark, +1);
+        if (table->column_prefixes != NULL)
+          ledger_table_column_prefix_note_row(table, position);
+        if (table->observers != NULL)
+          ledger_table_observer_notify(table, LEDGER_TABLE_ROW_ADDED, mark, -1);
         ledger_table_unlock(mark->source);
       }
       result = 1;
@@ -769,24 +5323,88 @@ int ledger_table_add_row_sub(struct ledger_table_mark* mark){
       ledger_table_row_free(new_row);
     }
     return result;
-  } else return 0;
+  }
 }
 
 int ledger_table_drop_row_sub(struct ledger_table_mark* mark){
-  if (mark->mutable_flag){
+  if (!mark->mutable_flag){
+    return 0;
+  } else if (mark->store != NULL){
+    int result;
+    struct ledger_table* const table = (struct ledger_table *)mark->source;
+    struct ledger_table_store* const store = mark->store;
+    if (ledger_table_schema_is_outdated_sub(store->schema)){
+      result = 0;
+    } else if (mark->index < 0
+    ||  (store->dead != NULL && store->dead[mark->index]))
+    {
+      /* don't allow it */;
+      result = 0;
+    } else /* remove the row */{
+      /* tombstones keep the rows in place until the vacuum, so the
+       * position caches start over instead of shifting at each drop */
+      int const position = table->tombstones_tf
+        ? -1 : ledger_table_mark_position(mark);
+      if (table->column_indexes != NULL)
+        ledger_table_column_index_note_drop(table, position);
+      if (table->column_aggregates != NULL)
+        ledger_table_column_aggregate_note_row(mark, -1);
+      if (table->column_prefixes != NULL)
+        ledger_table_column_prefix_note_row(table, position);
+      ledger_table_fingerprint_note_row(mark, -1);
+      if (table->observers != NULL){
+        ledger_table_observer_notify
+          (table, LEDGER_TABLE_ROW_DROPPED, mark, -1);
+      }
+      /* NOTE also moves the mark */
+      if (!table->tombstones_tf
+      ||  !ledger_table_store_bury(store, mark->index, mark))
+        ledger_table_store_erase(store, mark->index);
+      /* cache the new row count */
+      ledger_table_lock(mark->source);
+      table->rows -= 1;
+      ledger_table_unlock(mark->source);
+      /* done */
+      result = 1;
+    }
+    return result;
+  } else {
     int result;
     struct ledger_table* const table = (struct ledger_table *)mark->source;
     struct ledger_table_row * const old_row = mark->row;
     struct ledger_table_schema const* const schema = old_row->schema;
-    if (ledger_table_schema_is_outdated(schema)){
+    if (ledger_table_schema_is_outdated_sub(schema)){
       result = 0;
-    } else if (old_row->root_tf){
+    } else if (old_row->root_tf || old_row->position < 0){
       /* don't allow it */;
       result = 0;
     } else /* remove the row */{
+      /* forget the row's position and detach the row */
+      ledger_table_lock(mark->source);
+      if (table->column_indexes != NULL){
+        ledger_table_column_index_note_drop(table, table->tombstones_tf
+          ? -1 : ledger_table_mark_position(mark));
+      }
+      if (table->column_aggregates != NULL)
+        ledger_table_column_aggregate_note_row(mark, -1);
+      if (table->column_prefixes != NULL){
+        ledger_table_column_prefix_note_row(table, table->tombstones_tf
+          ? -1 : ledger_table_mark_position(mark));
+      }
+      ledger_table_fingerprint_note_row(mark, -1);
+      if (table->observers != NULL){
+        ledger_table_observer_notify
+          (table, LEDGER_TABLE_ROW_DROPPED, mark, -1);
+      }
+      /* linked rows leave at once, so tombstones only put off reindexing */
+      if (table->tombstones_tf)
+        ledger_table_index_release(table);
+      else ledger_table_index_erase(table, old_row);
+      ledger_table_row_detach(old_row);
+      ledger_table_unlock(mark->source);
       /* move the mark */
       ledger_table_mark_exchange(mark, old_row->prev);
-      /* free the row (NOTE also detaches) */
+      /* release the table's reference to the row */
       ledger_table_row_free(old_row);
       /* cache the new row count */
       ledger_table_lock(mark->source);
@@ -796,7 +5414,7 @@ int ledger_table_drop_row_sub(struct ledger_table_mark* mark){
       result = 1;
     }
     return result;
-  } else return 0;
+  }
 }
 
 int ledger_table_fetch_string_sub
@@ -804,45 +5422,67 @@ int ledger_table_fetch_string_sub
 {
   /* const or mutable accepted */{
     int result;
-    struct ledger_table_row * const old_row = mark->row;
-    struct ledger_table_schema const* const schema = old_row->schema;
-    int const columns = ((schema!=NULL)?schema->columns:0);
-    int const* const types = ((schema!=NULL)?schema->types:0);
-    if (old_row->root_tf
-    ||  i < 0
-    ||  i >= columns)
-    {
+    union ledger_table_cell cell;
+    int const type = ledger_table_mark_cell(mark, i, &cell);
+    if (type == 0){
       /* don't allow it */;
       result = -1;
     } else /* fetch the string */{
-      switch (types[i]){
+      switch (type){
       case LEDGER_TABLE_ID:
       case LEDGER_TABLE_INDEX:
-        if (old_row->data[i].item_id < 0){
+        if (*cell.item_id < 0){
           result = 0;
           if (len > 0) buf[0] = 0;
         } else {
-          result = (int)ledger_util_itoa(old_row->data[i].item_id,buf,len,0);
+          result = (int)ledger_util_itoa(*cell.item_id,buf,len,0);
         }break;
       case LEDGER_TABLE_BIGNUM:
-        if (old_row->data[i].bignum == NULL){
+        if (cell.amount->point_place == LEDGER_TABLE_AMOUNT_NONE){
           result = 0;
           if (len > 0) buf[0] = 0;
-        } else {
+        } else if (cell.amount->point_place == LEDGER_TABLE_AMOUNT_BIG){
           result =
-            ledger_bignum_get_text(old_row->data[i].bignum, buf, len,0);
+            ledger_bignum_get_text(cell.amount->value.bignum, buf, len,0);
+        } else {
+          result = ledger_bignum_fixed_to_text(cell.amount->value.fixed,
+              cell.amount->point_place, buf, len, 0);
         }break;
-      case LEDGER_TABLE_USTR:
-        if (old_row->data[i].string == NULL){
+      case LEDGER_TABLE_DATE:
+        if (*cell.date < -1)
+          /* copy the kept text */{
+          unsigned char const* const str =
+            ledger_util_date_kept_text(*cell.date);
+          if (str == NULL){
+            result = 0;
+            if (len > 0) buf[0] = 0;
+          } else {
+            result = ledger_util_ustrlen(str);
+            if (len > 0){
+              int truncated_result = result>=len?len-1:result;
+              memcpy(buf, str, truncated_result*sizeof(unsigned char));
+              buf[truncated_result] = 0;
+            }
+          }
+        } else if (*cell.date < 0){
           result = 0;
           if (len > 0) buf[0] = 0;
         } else {
-          result = ledger_util_ustrlen(old_row->data[i].string);
-          if (len > 0){
-            int truncated_result = result>=len?len-1:result;
-            memcpy(buf, old_row->data[i].string,
-                truncated_result*sizeof(unsigned char));
-            buf[truncated_result] = 0;
+          result = (int)ledger_util_date_to_text(*cell.date, buf, len);
+        }break;
+      case LEDGER_TABLE_USTR:
+        /* copy the string */{
+          unsigned char const* const str = ledger_table_ustr_get(cell.string);
+          if (str == NULL){
+            result = 0;
+            if (len > 0) buf[0] = 0;
+          } else {
+            result = ledger_util_ustrlen(str);
+            if (len > 0){
+              int truncated_result = result>=len?len-1:result;
+              memcpy(buf, str, truncated_result*sizeof(unsigned char));
+              buf[truncated_result] = 0;
+            }
           }
         }break;
       }
@@ -856,98 +5496,157 @@ int ledger_table_put_string_sub
 {
   if (mark->mutable_flag){
     int result;
-    struct ledger_table_row * const old_row = mark->row;
-    struct ledger_table_schema const* const schema = old_row->schema;
-    int const columns = ((schema!=NULL)?schema->columns:0);
-    int const* const types = ((schema!=NULL)?schema->types:0);
-    if (old_row->root_tf
-    ||  i < 0
-    ||  i >= columns)
-    {
+    union ledger_table_cell cell;
+    int const type = ledger_table_mark_cell(mark, i, &cell);
+    if (type != 0){
+      ledger_table_column_index_note_put(mark, i);
+      ledger_table_column_aggregate_note(mark, i, -1);
+      ledger_table_column_prefix_note_put(mark, i);
+      ledger_table_fingerprint_note(mark, i, -1);
+    }
+    if (type == 0){
       /* don't allow it */;
       result = -1;
     } else /* put the string */{
-      switch (types[i]){
+      switch (type){
       case LEDGER_TABLE_ID:
       case LEDGER_TABLE_INDEX:
         if (value == NULL || *value == 0){
-          old_row->data[i].item_id = -1;
+          *cell.item_id = -1;
           result = 1;
         } else {
-          old_row->data[i].item_id = ledger_util_atoi(value);
+          *cell.item_id = ledger_util_atoi(value);
           result = 1;
         }break;
       case LEDGER_TABLE_BIGNUM:
         if (value == NULL || *value == 0){
-          ledger_bignum_free(old_row->data[i].bignum);
-          old_row->data[i].bignum = NULL;
+          ledger_table_cell_clear(type, cell);
           result = 1;
         } else {
-          int is_new_ptr = 0;
-          struct ledger_bignum* bignum = old_row->data[i].bignum;
-          if (bignum == NULL){
-            bignum = ledger_bignum_new();
-            if (bignum == NULL) break;
-            else is_new_ptr = 1;
-          }
-          /* put the big number */{
+          long long int fixed;
+          int point_place;
+          if (ledger_bignum_fixed_from_text(value, &fixed, &point_place)
+          &&  ledger_table_amount_put_fixed(cell.amount, fixed, point_place))
+          {
+            result = 1;
+          } else /* put the big number */{
+            int const was_none_tf =
+              (cell.amount->point_place == LEDGER_TABLE_AMOUNT_NONE);
+            struct ledger_bignum* bignum =
+              ledger_table_amount_promote(cell.amount);
+            if (bignum == NULL){
+              result = 0;
+              break;
+            }
             result = ledger_bignum_set_text(bignum, value, NULL);
-            if (result){
-              old_row->data[i].bignum = bignum;
-            } else if (is_new_ptr){
-              ledger_bignum_free(bignum);
+            if (!result && was_none_tf){
+              ledger_table_cell_clear(type, cell);
             }
           }
         }break;
+      case LEDGER_TABLE_DATE:
+        if (value == NULL || *value == 0){
+          *cell.date = -1;
+          result = 1;
+        } else if (ledger_util_date_from_text(value, cell.date)){
+          result = 1;
+        } else /* keep text that is not a date */{
+          result = ledger_util_date_keep_text(value, cell.date);
+        }break;
       case LEDGER_TABLE_USTR:
-        /* duplicate, free, replace */{
-          unsigned char *new_string = ledger_util_ustrdup(value,&result);
-          if (result){
-            ledger_util_free(old_row->data[i].string);
-            old_row->data[i].string = new_string;
-          }
+        if (value == NULL){
+          ledger_table_mark_string_release(mark, cell.string);
+          result = 1;
+        } else /* duplicate, free, replace */{
+          result = ledger_table_mark_string_put
+            (mark, cell.string, value, ledger_util_ustrlen(value));
         }break;
       }
     }
+    if (type != 0){
+      ledger_table_column_aggregate_note(mark, i, +1);
+      ledger_table_fingerprint_note(mark, i, +1);
+    }
+    if (result == 1)
+      ledger_table_observer_note_put(mark, i);
     return result;
   } else return 0;
 }
 
+int ledger_table_fetch_fixed_sub
+  ( struct ledger_table_mark const* mark, int i,
+    long long int* value, int* point_place)
+{
+  /* const or mutable accepted */{
+    int result = 0;
+    union ledger_table_cell cell;
+    int const type = ledger_table_mark_cell(mark, i, &cell);
+    switch (type){
+    case LEDGER_TABLE_ID:
+    case LEDGER_TABLE_INDEX:
+      *value = (*cell.item_id < 0) ? -1 : *cell.item_id;
+      *point_place = 0;
+      result = 1;
+      break;
+    case LEDGER_TABLE_BIGNUM:
+      if (cell.amount->point_place == LEDGER_TABLE_AMOUNT_NONE){
+        *value = 0;
+        *point_place = 0;
+        result = 1;
+      } else if (cell.amount->point_place == LEDGER_TABLE_AMOUNT_BIG){
+        result = ledger_bignum_get_fixed
+          (cell.amount->value.bignum, value, point_place);
+      } else {
+        *value = cell.amount->value.fixed;
+        *point_place = cell.amount->point_place;
+        result = 1;
+      }break;
+    case LEDGER_TABLE_USTR:
+      if (ledger_table_ustr_get(cell.string) == NULL){
+        *value = 0;
+        *point_place = 0;
+        result = 1;
+      } else {
+        result = ledger_bignum_fixed_from_text
+          (ledger_table_ustr_get(cell.string), value, point_place);
+      }break;
+    }
+    return result;
+  }
+}
+
 int ledger_table_fetch_bignum_sub
   (struct ledger_table_mark const* mark, int i, struct ledger_bignum* n)
 {
   /* const or mutable accepted */{
     int result;
-    struct ledger_table_row * const old_row = mark->row;
-    struct ledger_table_schema const* const schema = old_row->schema;
-    int const columns = ((schema!=NULL)?schema->columns:0);
-    int const* const types = ((schema!=NULL)?schema->types:0);
-    if (old_row->root_tf
-    ||  i < 0
-    ||  i >= columns)
-    {
+    union ledger_table_cell cell;
+    int const type = ledger_table_mark_cell(mark, i, &cell);
+    if (type == 0){
       /* don't allow it */;
       result = -1;
     } else /* fetch the string */{
-      switch (types[i]){
+      switch (type){
       case LEDGER_TABLE_ID:
       case LEDGER_TABLE_INDEX:
-        if (old_row->data[i].item_id < 0){
+        if (*cell.item_id < 0){
           result = ledger_bignum_set_long(n, -1);
         } else {
-          result = ledger_bignum_set_long(n, old_row->data[i].item_id);
+          result = ledger_bignum_set_long(n, *cell.item_id);
         }break;
       case LEDGER_TABLE_BIGNUM:
-        if (old_row->data[i].bignum == NULL){
-          result = ledger_bignum_set_long(n, 0);
-        } else {
-          result = ledger_bignum_assign(n, old_row->data[i].bignum);
-        }break;
+        result = ledger_table_amount_fetch(n, cell.amount);
+        break;
+      case LEDGER_TABLE_DATE:
+        /* dates are not numbers */
+        result = 0;
+        break;
       case LEDGER_TABLE_USTR:
-        if (old_row->data[i].string == NULL){
+        if (ledger_table_ustr_get(cell.string) == NULL){
           result = ledger_bignum_set_long(n, 0);
         } else {
-          result = ledger_bignum_set_text(n, old_row->data[i].string, NULL);
+          result = ledger_bignum_set_text
+            (n, ledger_table_ustr_get(cell.string), NULL);
         }break;
       }
     }
@@ -961,63 +5660,70 @@ int ledger_table_put_bignum_sub
 {
   if (mark->mutable_flag){
     int result;
-    struct ledger_table_row * const old_row = mark->row;
-    struct ledger_table_schema const* const schema = old_row->schema;
-    int const columns = ((schema!=NULL)?schema->columns:0);
-    int const* const types = ((schema!=NULL)?schema->types:0);
-    if (old_row->root_tf
-    ||  i < 0
-    ||  i >= columns)
-    {
+    union ledger_table_cell cell;
+    int const type = ledger_table_mark_cell(mark, i, &cell);
+    if (type != 0){
+      ledger_table_column_index_note_put(mark, i);
+      ledger_table_column_aggregate_note(mark, i, -1);
+      ledger_table_column_prefix_note_put(mark, i);
+      ledger_table_fingerprint_note(mark, i, -1);
+    }
+    if (type == 0){
       /* don't allow it */;
       result = -1;
     } else /* put the string */{
-      switch (types[i]){
+      switch (type){
       case LEDGER_TABLE_ID:
       case LEDGER_TABLE_INDEX:
         if (value == NULL){
-          old_row->data[i].item_id = 0;
+          *cell.item_id = 0;
           result = 1;
         } else {
-          old_row->data[i].item_id = ledger_bignum_get_long(value);
+          *cell.item_id = ledger_bignum_get_long(value);
           result = 1;
         }break;
       case LEDGER_TABLE_BIGNUM:
         if (value == NULL){
-          ledger_bignum_free(old_row->data[i].bignum);
-          old_row->data[i].bignum = NULL;
+          ledger_table_cell_clear(type, cell);
           result = 1;
         } else {
-          int is_new_ptr = 0;
-          struct ledger_bignum* bignum = old_row->data[i].bignum;
-          if (bignum == NULL){
-            bignum = ledger_bignum_new();
-            if (bignum == NULL) break;
-            else is_new_ptr = 1;
-          }
-          /* put the big number */{
+          long long int fixed;
+          int point_place;
+          if (ledger_bignum_get_fixed(value, &fixed, &point_place)
+          &&  ledger_table_amount_put_fixed(cell.amount, fixed, point_place))
+          {
+            result = 1;
+          } else /* put the big number */{
+            int const was_none_tf =
+              (cell.amount->point_place == LEDGER_TABLE_AMOUNT_NONE);
+            struct ledger_bignum* bignum =
+              ledger_table_amount_promote(cell.amount);
+            if (bignum == NULL){
+              result = 0;
+              break;
+            }
             result = ledger_bignum_assign(bignum, value);
-            if (result){
-              old_row->data[i].bignum = bignum;
-            } else if (is_new_ptr){
-              ledger_bignum_free(bignum);
+            if (!result && was_none_tf){
+              ledger_table_cell_clear(type, cell);
             }
           }
         }break;
+      case LEDGER_TABLE_DATE:
+        /* dates are not numbers */
+        result = 0;
+        break;
       case LEDGER_TABLE_USTR:
         /* construct the string */{
-          int len = ledger_bignum_get_text(value,NULL,0,0);
+          int len = ledger_bignum_text_length(value,0);
           if (len > 0){
-            unsigned char *new_string = ledger_util_malloc(len+1);
+            unsigned char *new_string =
+              ledger_table_mark_string_reserve(mark, cell.string, len);
             if (new_string != NULL){
               ledger_bignum_get_text(value,new_string,len+1,0);
-              ledger_util_free(old_row->data[i].string);
-              old_row->data[i].string = new_string;
               result = 1;
             } else result = 0;
           } else if (len == 0){
-            ledger_util_free(old_row->data[i].string);
-            old_row->data[i].string = NULL;
+            ledger_table_mark_string_release(mark, cell.string);
             result = 1;
           } else {
             result = 0;
@@ -1025,6 +5731,12 @@ int ledger_table_put_bignum_sub
         }break;
       }
     }
+    if (type != 0){
+      ledger_table_column_aggregate_note(mark, i, +1);
+      ledger_table_fingerprint_note(mark, i, +1);
+    }
+    if (result == 1)
+      ledger_table_observer_note_put(mark, i);
     return result;
   } else return 0;
 }
@@ -1035,41 +5747,49 @@ int ledger_table_fetch_id_sub
 {
   /* const or mutable accepted */{
     int result;
-    struct ledger_table_row * const old_row = mark->row;
-    struct ledger_table_schema const* const schema = old_row->schema;
-    int const columns = ((schema!=NULL)?schema->columns:0);
-    int const* const types = ((schema!=NULL)?schema->types:0);
-    if (old_row->root_tf
-    ||  i < 0
-    ||  i >= columns)
-    {
+    union ledger_table_cell cell;
+    int const type = ledger_table_mark_cell(mark, i, &cell);
+    if (type == 0){
       /* don't allow it */;
       result = -1;
     } else /* fetch the string */{
-      switch (types[i]){
+      switch (type){
       case LEDGER_TABLE_ID:
       case LEDGER_TABLE_INDEX:
-        if (old_row->data[i].item_id < 0){
+        if (*cell.item_id < 0){
           *n = -1;
           result = 1;
         } else {
-          *n = old_row->data[i].item_id;
+          *n = *cell.item_id;
           result = 1;
         }break;
       case LEDGER_TABLE_BIGNUM:
-        if (old_row->data[i].bignum == NULL){
+        if (cell.amount->point_place == LEDGER_TABLE_AMOUNT_NONE){
           *n = 0;
           result = 1;
+        } else if (cell.amount->point_place == LEDGER_TABLE_AMOUNT_BIG){
+          *n = (int)ledger_bignum_get_long(cell.amount->value.bignum);
+          result = 1;
         } else {
-          *n = (int)ledger_bignum_get_long(old_row->data[i].bignum);
+          /* drop the fractional part */
+          long long int fixed = cell.amount->value.fixed;
+          int j;
+          for (j = 0; j < cell.amount->point_place && fixed != 0; ++j){
+            fixed /= 100;
+          }
+          *n = (int)fixed;
           result = 1;
         }break;
+      case LEDGER_TABLE_DATE:
+        /* dates are not numbers */
+        result = 0;
+        break;
       case LEDGER_TABLE_USTR:
-        if (old_row->data[i].string == NULL){
+        if (ledger_table_ustr_get(cell.string) == NULL){
           *n = -1;
           result = 1;
         } else {
-          *n = ledger_util_atoi(old_row->data[i].string);
+          *n = ledger_util_atoi(ledger_table_ustr_get(cell.string));
           result = 1;
         }break;
       }
@@ -1083,59 +5803,62 @@ int ledger_table_put_id_sub
 {
   if (mark->mutable_flag){
     int result;
-    struct ledger_table_row * const old_row = mark->row;
-    struct ledger_table_schema const* const schema = old_row->schema;
-    int const columns = ((schema!=NULL)?schema->columns:0);
-    int const* const types = ((schema!=NULL)?schema->types:0);
-    if (old_row->root_tf
-    ||  i < 0
-    ||  i >= columns)
-    {
+    union ledger_table_cell cell;
+    int const type = ledger_table_mark_cell(mark, i, &cell);
+    if (type != 0){
+      ledger_table_column_index_note_put(mark, i);
+      ledger_table_column_aggregate_note(mark, i, -1);
+      ledger_table_column_prefix_note_put(mark, i);
+      ledger_table_fingerprint_note(mark, i, -1);
+    }
+    if (type == 0){
       /* don't allow it */;
       result = -1;
     } else /* put the string */{
-      switch (types[i]){
+      switch (type){
       case LEDGER_TABLE_ID:
       case LEDGER_TABLE_INDEX:
         if (value < 0){
-          old_row->data[i].item_id = -1;
+          *cell.item_id = -1;
           result = 1;
         } else {
-          old_row->data[i].item_id = value;
+          *cell.item_id = value;
           result = 1;
         }break;
       case LEDGER_TABLE_BIGNUM:
-        /* conversion is direct */{
-          int is_new_ptr = 0;
-          struct ledger_bignum* bignum = old_row->data[i].bignum;
+        /* conversion is direct */
+        if (ledger_table_amount_put_fixed(cell.amount, value, 0)){
+          result = 1;
+        } else /* put the big number */{
+          int const was_none_tf =
+            (cell.amount->point_place == LEDGER_TABLE_AMOUNT_NONE);
+          struct ledger_bignum* bignum =
+            ledger_table_amount_promote(cell.amount);
           if (bignum == NULL){
-            bignum = ledger_bignum_new();
-            if (bignum == NULL) break;
-            else is_new_ptr = 1;
+            result = 0;
+            break;
           }
-          /* put the big number */{
-            result = ledger_bignum_set_long(bignum, value);
-            if (result){
-              old_row->data[i].bignum = bignum;
-            } else if (is_new_ptr){
-              ledger_bignum_free(bignum);
-            }
+          result = ledger_bignum_set_long(bignum, value);
+          if (!result && was_none_tf){
+            ledger_table_cell_clear(type, cell);
           }
         }break;
+      case LEDGER_TABLE_DATE:
+        /* dates are not numbers */
+        result = 0;
+        break;
       case LEDGER_TABLE_USTR:
         /* construct the string */{
           int len = ledger_util_itoa(value,NULL,0,0);
           if (len > 0){
-            unsigned char *new_string = ledger_util_malloc(len+1);
+            unsigned char *new_string =
+              ledger_table_mark_string_reserve(mark, cell.string, len);
             if (new_string != NULL){
               ledger_util_itoa(value,new_string,len+1,0);
-              ledger_util_free(old_row->data[i].string);
-              old_row->data[i].string = new_string;
               result = 1;
             } else result = 0;
           } else if (len == 0){
-            ledger_util_free(old_row->data[i].string);
-            old_row->data[i].string = NULL;
+            ledger_table_mark_string_release(mark, cell.string);
             result = 1;
           } else {
             result = 0;
@@ -1143,15 +5866,168 @@ int ledger_table_put_id_sub
         }break;
       }
     }
+    if (type != 0){
+      ledger_table_column_aggregate_note(mark, i, +1);
+      ledger_table_fingerprint_note(mark, i, +1);
+    }
+    if (result == 1)
+      ledger_table_observer_note_put(mark, i);
+    return result;
+  } else return 0;
+}
+
+int ledger_table_put_date_sub
+  ( struct ledger_table_mark const* mark, int i, long long int value)
+{
+  if (mark->mutable_flag){
+    int result;
+    union ledger_table_cell cell;
+    int const type = ledger_table_mark_cell(mark, i, &cell);
+    if (type != 0){
+      ledger_table_column_index_note_put(mark, i);
+      ledger_table_column_prefix_note_put(mark, i);
+      ledger_table_fingerprint_note(mark, i, -1);
+    }
+    switch (type){
+    case LEDGER_TABLE_DATE:
+      if (value < -1 && ledger_util_date_kept_text(value) != NULL)
+        *cell.date = value;
+      else *cell.date = (value < 0) ? -1 : value;
+      result = 1;
+      break;
+    case LEDGER_TABLE_USTR:
+      if (value < -1 && ledger_util_date_kept_text(value) != NULL){
+        unsigned char const* const text = ledger_util_date_kept_text(value);
+        result = ledger_table_mark_string_put
+          (mark, cell.string, text, ledger_util_ustrlen(text));
+      } else if (value < 0){
+        ledger_table_mark_string_release(mark, cell.string);
+        result = 1;
+      } else /* format the date */{
+        unsigned char text[24];
+        size_t const len = ledger_util_date_to_text(value, text, sizeof(text));
+        if (len == 0){
+          result = 0;
+          break;
+        }
+        result = ledger_table_mark_string_put(mark, cell.string, text, len);
+      }break;
+    default:
+      /* don't allow it */
+      result = 0;
+      break;
+    }
+    if (type != 0)
+      ledger_table_fingerprint_note(mark, i, +1);
+    if (result == 1)
+      ledger_table_observer_note_put(mark, i);
     return result;
   } else return 0;
 }
 
+int ledger_table_fetch_date_sub
+  (struct ledger_table_mark const* mark, int i, long long int* value)
+{
+  union ledger_table_cell cell;
+  switch (ledger_table_mark_cell(mark, i, &cell)){
+  case LEDGER_TABLE_DATE:
+    *value = *cell.date;
+    return 1;
+  case LEDGER_TABLE_USTR:
+    if (ledger_table_ustr_get(cell.string) == NULL){
+      *value = -1;
+      return 1;
+    } else return ledger_util_date_from_text
+      (ledger_table_ustr_get(cell.string), value);
+  default:
+    return 0;
+  }
+}
+
+int ledger_table_fetch_row_sub
+  ( struct ledger_table_mark const* mark, int n,
+    struct ledger_table_field* fields)
+{
+  int j;
+  if (ledger_table_mark_at_end(mark)) return 0;
+  for (j = 0; j < n; ++j){
+    struct ledger_table_field* const field = fields+j;
+    switch (field->type){
+    case LEDGER_TABLE_ID:
+    case LEDGER_TABLE_INDEX:
+      if (ledger_table_fetch_id_sub(mark, field->column, &field->id) != 1)
+        return 0;
+      break;
+    case LEDGER_TABLE_BIGNUM:
+      if (ledger_table_fetch_bignum_sub(mark, field->column, field->bignum)
+          != 1)
+        return 0;
+      break;
+    case LEDGER_TABLE_USTR:
+      field->text_length = ledger_table_fetch_string_sub
+        (mark, field->column, field->buf, field->len);
+      if (field->text_length < 0)
+        return 0;
+      break;
+    case LEDGER_TABLE_DATE:
+      if (!ledger_table_fetch_date_sub(mark, field->column, &field->date))
+        return 0;
+      break;
+    default:
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int ledger_table_put_row_sub
+  ( struct ledger_table_mark const* mark, int n,
+    struct ledger_table_field const* fields)
+{
+  int j;
+  if (!mark->mutable_flag
+  ||  ledger_table_mark_at_end(mark))
+    return 0;
+  for (j = 0; j < n; ++j){
+    struct ledger_table_field const* const field = fields+j;
+    switch (field->type){
+    case LEDGER_TABLE_ID:
+    case LEDGER_TABLE_INDEX:
+      if (ledger_table_put_id_sub(mark, field->column, field->id) != 1)
+        return 0;
+      break;
+    case LEDGER_TABLE_BIGNUM:
+      if (field->bignum == NULL
+      &&  ledger_table_mark_get_type(mark, field->column)
+          != LEDGER_TABLE_BIGNUM)
+        return 0;
+      if (ledger_table_put_bignum_sub(mark, field->column, field->bignum)
+          != 1)
+        return 0;
+      break;
+    case LEDGER_TABLE_USTR:
+      if (ledger_table_put_string_sub(mark, field->column, field->text)
+          != 1)
+        return 0;
+      break;
+    case LEDGER_TABLE_DATE:
+      if (!ledger_table_put_date_sub(mark, field->column, field->date))
+        return 0;
+      break;
+    default:
+      return 0;
+    }
+  }
+  return 1;
+}
+
 void ledger_table_mark_exchange
   (struct ledger_table_mark *mark, struct ledger_table_row* new_row)
 {
-  ledger_table_row_acquire(new_row);
-  ledger_table_row_free(mark->row);
+  if (!mark->borrowed_tf){
+    ledger_table_row_acquire(new_row);
+    ledger_table_row_free(mark->row);
+  }
   mark->row = new_row;
   return;
 }
@@ -1164,7 +6040,19 @@ struct ledger_table* ledger_table_new(void){
   struct ledger_table* t = (struct ledger_table* )ledger_util_ref_malloc
     (sizeof(struct ledger_table), ledger_table_free_cb);
   if (t != NULL){
-    if (!ledger_table_init(t)){
+    if (!ledger_table_init(t, 0)){
+      ledger_util_ref_free(t);
+      t = NULL;
+    }
+  }
+  return t;
+}
+
+struct ledger_table* ledger_table_new_columnar(void){
+  struct ledger_table* t = (struct ledger_table* )ledger_util_ref_malloc
+    (sizeof(struct ledger_table), ledger_table_free_cb);
+  if (t != NULL){
+    if (!ledger_table_init(t, 1)){
       ledger_util_ref_free(t);
       t = NULL;
     }
@@ -1172,6 +6060,10 @@ struct ledger_table* ledger_table_new(void){
   return t;
 }
 
+int ledger_table_is_columnar(struct ledger_table const* t){
+  return t->store != NULL;
+}
+
 struct ledger_table* ledger_table_acquire(struct ledger_table* t){
   return (struct ledger_table*)ledger_util_ref_acquire(t);
 }
@@ -1183,6 +6075,124 @@ void ledger_table_free(struct ledger_table* t){
   }
 }
 
+void ledger_table_read_lock(struct ledger_table const* t){
+  ledger_table_lock_shared(t);
+  return;
+}
+
+void ledger_table_read_unlock(struct ledger_table const* t){
+  ledger_table_unlock_shared(t);
+  return;
+}
+
+void ledger_table_write_lock(struct ledger_table const* t){
+  ledger_table_lock(t);
+  return;
+}
+
+void ledger_table_write_unlock(struct ledger_table const* t){
+  ledger_table_unlock(t);
+  return;
+}
+
+struct ledger_table* ledger_table_copy(struct ledger_table const* t){
+  int ok = 0;
+  struct ledger_table* out;
+  struct ledger_table_mark* mark = NULL;
+  ledger_table_lock_shared(t);
+  out = (t->store != NULL)
+    ? ledger_table_new_columnar() : ledger_table_new();
+  if (out != NULL) do {
+    /* copies share the string pool, and with it the strings */
+    if (t->pool != NULL)
+      out->pool = ledger_table_pool_acquire(t->pool);
+    out->tombstones_tf = t->tombstones_tf;
+    struct ledger_table_cursor cursor;
+    struct ledger_table_mark const* const source =
+      ledger_table_cursor_mark(&cursor);
+    int const columns = t->schema->columns;
+    if (!ledger_table_set_column_types(out, columns, t->schema->types))
+      break;
+    /* marks made before the schema change would be outdated */
+    mark = ledger_table_end(out);
+    if (mark == NULL) break;
+    if (out->store != NULL && !ledger_table_store_reserve(out->store, t->rows))
+      break;
+    ok = 1;
+    for (ledger_table_cursor_begin(&cursor, t);
+        ok && !ledger_table_cursor_is_end(&cursor);
+        ledger_table_cursor_move(&cursor, +1))
+    {
+      int i;
+      ok = ledger_table_add_row(mark);
+      for (i = 0; ok && i < columns; ++i){
+        union ledger_table_cell src_cell, dst_cell;
+        int const type = ledger_table_mark_cell(source, i, &src_cell);
+        /* rows from older schemata keep only matching columns */
+        if (type != 0 && ledger_table_mark_cell(mark, i, &dst_cell) == type)
+          ok = ledger_table_cell_copy(mark, type, dst_cell, src_cell);
+      }
+      ledger_table_mark_move(mark, +1);
+    }
+    /* cells were copied directly, so sum them up */
+    if (ok) ok = ledger_table_fingerprint_build(out);
+    /* copy the column index definitions */{
+      struct ledger_table_column_index const* ci;
+      for (ci = t->column_indexes; ok && ci != NULL; ci = ci->next){
+        ok = ledger_table_add_column_index(out, ci->column, ci->kind);
+      }
+    }
+    /* copy the column aggregate definitions */{
+      struct ledger_table_column_aggregate const* ca;
+      for (ca = t->column_aggregates; ok && ca != NULL; ca = ca->next){
+        ok = ledger_table_add_column_aggregate(out, ca->column);
+      }
+    }
+    /* copy the prefix index definitions */{
+      struct ledger_table_column_prefix const* cp;
+      for (cp = t->column_prefixes; ok && cp != NULL; cp = cp->next){
+        ok = ledger_table_add_column_prefix(out, cp->column, cp->key_column);
+      }
+    }
+  } while (0);
+  ledger_table_unlock_shared(t);
+  ledger_table_mark_free(mark);
+  if (!ok){
+    ledger_table_free(out);
+    return NULL;
+  } else return out;
+}
+
+struct ledger_table* ledger_table_share(struct ledger_table* t){
+  if (ledger_table_acquire(t) == NULL) return NULL;
+  ledger_util_share_add(&t->shares, +1);
+  return t;
+}
+
+void ledger_table_drop_share(struct ledger_table* t){
+  if (t != NULL){
+    ledger_util_share_add(&t->shares, -1);
+    ledger_table_free(t);
+  }
+  return;
+}
+
+struct ledger_table* ledger_table_own(struct ledger_table* t){
+  struct ledger_table* copy;
+  if (ledger_util_share_add(&t->shares, 0) == 0) return t;
+  copy = ledger_table_copy(t);
+  if (copy == NULL) return NULL;
+  /* the copy replaces the table for its owner, observers included */
+  ledger_table_lock_shared(t);
+  if (t->observers != NULL){
+    copy->observers = (struct ledger_table_observer_list*)
+      ledger_util_ref_acquire(t->observers);
+  }
+  ledger_table_unlock_shared(t);
+  ledger_table_drop_share(t);
+  return copy;
+}
+
 int ledger_table_is_equal
   (struct ledger_table const* a, struct ledger_table const* b)
 {
@@ -1191,24 +6201,28 @@ int ledger_table_is_equal
   struct ledger_table_schema *b_schema;
   struct ledger_table_mark a_mark;
   struct ledger_table_mark b_mark;
+  int a_rows, b_rows;
+  unsigned long long int a_print, b_print;
+  int a_print_ok, b_print_ok;
   /* trivial tables */
-  if (a == NULL && b == NULL) return 1;
+  if (a == b) return 1;
   else if (a == NULL || b == NULL) return 0;
   /* compare top-level features */{
-    int a_rows, b_rows;
     /* lock and access A */{
-      ledger_table_lock(a);
+      ledger_table_lock_shared(a);
       a_rows = a->rows;
+      a_print_ok = ledger_table_fingerprint_get(a, &a_print);
       a_schema = ledger_table_schema_acquire(a->schema);
-      ledger_table_mark_init(a,a->root,0,&a_mark);
-      ledger_table_unlock(a);
+      ledger_table_mark_init(a,a->root,-1,0,&a_mark);
+      ledger_table_unlock_shared(a);
     }
     /* lock and access B */{
-      ledger_table_lock(b);
+      ledger_table_lock_shared(b);
       b_rows = b->rows;
+      b_print_ok = ledger_table_fingerprint_get(b, &b_print);
       b_schema = ledger_table_schema_acquire(b->schema);
-      ledger_table_mark_init(b,b->root,0,&b_mark);
-      ledger_table_unlock(b);
+      ledger_table_mark_init(b,b->root,-1,0,&b_mark);
+      ledger_table_unlock_shared(b);
     }
     result = 1;
     do {
@@ -1216,6 +6230,11 @@ int ledger_table_is_equal
         result = 0;
         break;
       }
+      /* tables with different cells have different fingerprints */
+      if (a_print_ok && b_print_ok && a_print != b_print){
+        result = 0;
+        break;
+      }
       if (a->schema == NULL || b->schema == NULL){
         /* failed to acquire PRE_CONDITION schema */
         result = 0;
@@ -1235,216 +6254,1002 @@ int ledger_table_is_equal
       return 0;
     }
   }
-  /* compare row by row */do {
-    result = 0;
-    /* perform initial consistency check */{
-      if (a_mark.row->root_tf)
-        /* pass */;
-      else if (!ledger_table_mark_add_one_checked(&a_mark))
-        break;
-      if (b_mark.row->root_tf)
-        /* pass */;
-      else if (!ledger_table_mark_add_one_checked(&b_mark))
-        break;
+  /* compare row by row */do {
+    result = 0;
+    /* move both marks to the first row */if (a_rows > 0){
+      if (!ledger_table_mark_add_one_checked(&a_mark))
+        break;
+      if (!ledger_table_mark_add_one_checked(&b_mark))
+        break;
+    }
+    result = 1;
+    while (!(ledger_table_mark_at_end(&a_mark)
+        ||  ledger_table_mark_at_end(&b_mark)))
+    {
+      int i;
+      struct ledger_table_schema *const a_row_schema =
+        ledger_table_mark_schema(&a_mark);
+      struct ledger_table_schema *const b_row_schema =
+        ledger_table_mark_schema(&b_mark);
+      int const *const types = a_row_schema->types;
+      int const columns = a_row_schema->columns;
+      ledger_table_schema_lock_shared2(a_row_schema, b_row_schema);
+      /* perform field-wise comparison */
+      for (i = 0; i < columns; ++i){
+        union ledger_table_cell a_cell, b_cell;
+        if (ledger_table_mark_cell(&a_mark, i, &a_cell) != types[i]
+        ||  ledger_table_mark_cell(&b_mark, i, &b_cell) != types[i])
+          result = 0;
+        else if (!ledger_table_cell_is_equal(types[i], a_cell, b_cell))
+          result = 0;
+        if (!result) break;
+      }
+      ledger_table_schema_unlock_shared(a_row_schema);
+      ledger_table_schema_unlock_shared(b_row_schema);
+      if (!result) break;
+      /* perform consistency check */{
+        if (!ledger_table_mark_add_one_checked(&a_mark)){
+          result = 0;
+          break;
+        }
+        if (!ledger_table_mark_add_one_checked(&b_mark)){
+          result = 0;
+          break;
+        }
+      }
+    }
+  } while(0);
+  ledger_table_mark_clear(&a_mark);
+  ledger_table_mark_clear(&b_mark);
+  return result;
+}
+
+struct ledger_table_mark* ledger_table_begin(struct ledger_table* t){
+  struct ledger_table_mark* m;
+  /* acquire the mark */
+  ledger_table_lock_shared(t);
+  m = ledger_table_mark_new(t, t->root, 0, 1);
+  ledger_table_unlock_shared(t);
+  /* move the mark */
+  if (m != NULL && m->store == NULL)
+    ledger_table_mark_move(m, +1);
+  return m;
+}
+
+struct ledger_table_mark* ledger_table_begin_c
+  (struct ledger_table const* t)
+{
+  struct ledger_table_mark* m;
+  /* acquire the mark */
+  ledger_table_lock_shared(t);
+  m = ledger_table_mark_new(t, t->root, 0, 0);
+  ledger_table_unlock_shared(t);
+  /* move the mark */
+  if (m != NULL && m->store == NULL)
+    ledger_table_mark_move(m, +1);
+  return m;
+}
+
+struct ledger_table_mark* ledger_table_end(struct ledger_table* t){
+  struct ledger_table_mark* m;
+  ledger_table_lock_shared(t);
+  m = ledger_table_mark_new(t, t->root, -1, 1);
+  ledger_table_unlock_shared(t);
+  return m;
+}
+
+struct ledger_table_mark* ledger_table_end_c(struct ledger_table const* t){
+  struct ledger_table_mark* m;
+  ledger_table_lock_shared(t);
+  m = ledger_table_mark_new(t, t->root, -1, 0);
+  ledger_table_unlock_shared(t);
+  return m;
+}
+
+int ledger_table_mark_is_equal
+  (struct ledger_table_mark const* a, struct ledger_table_mark const* b)
+{
+  int result;
+  struct ledger_table_schema *const a_schema = ledger_table_mark_schema(a);
+  struct ledger_table_schema *const b_schema = ledger_table_mark_schema(b);
+  if (a->source != b->source) return 0;
+  /* writers move columnar marks when rows come and go */
+  ledger_table_schema_lock_shared2(a_schema, b_schema);
+  result = (a->row == b->row
+      &&  a->store == b->store && a->index == b->index);
+  ledger_table_schema_unlock_shared(a_schema);
+  ledger_table_schema_unlock_shared(b_schema);
+  return result;
+}
+
+void ledger_table_mark_free(struct ledger_table_mark* m){
+  /* NOTE ledger_table_mark_clear(m); called by ledger_util_ref_free */
+  ledger_util_ref_free(m);
+}
+
+int ledger_table_get_column_count(struct ledger_table const* t){
+  int columns;
+  ledger_table_lock_shared(t);
+  columns = t->schema != NULL ? t->schema->columns : 0;
+  ledger_table_unlock_shared(t);
+  return columns;
+}
+
+int ledger_table_get_column_type(struct ledger_table const* t, int i){
+  int typ;
+  ledger_table_lock_shared(t);
+  /* get type value */{
+    struct ledger_table_schema const* const s = t->schema;
+    if (i < 0 || i >= s->columns) typ = 0;
+    else typ = s->types[i];
+  }
+  ledger_table_unlock_shared(t);
+  return typ;
+}
+
+int ledger_table_set_column_types
+  (struct ledger_table* t, int n, int const* types)
+{
+  struct ledger_table_schema *new_schema;
+  struct ledger_table_row *new_root = NULL;
+  struct ledger_table_store *new_store = NULL;
+  struct ledger_table_schema *old_schema;
+  struct ledger_table_row *old_root;
+  struct ledger_table_store *old_store;
+  /* validate the types */{
+    int i;
+    if (n > LEDGER_TABLE_SCHEMA_MAX) return 0;
+    for (i = 0; i < n; ++i){
+      if (types[i] >= 1 && types[i] <= 5)
+        continue;
+      else
+        break;
+    }
+    if (i < n) /* invalid schema so */return 0;
+  }
+  /* allocate the column schema */{
+    new_schema = ledger_table_schema_new(t, n, types);
+    if (new_schema == NULL) return 0;
+  }
+  if (t->store != NULL) /* allocate new column store */{
+    new_store = ledger_table_store_new(new_schema);
+    if (new_store == NULL){
+      ledger_table_schema_free(new_schema);
+      return 0;
+    }
+  } else /* allocate new root */{
+    new_root = ledger_table_row_new(new_schema);
+    if (new_root == NULL){
+      ledger_table_schema_free(new_schema);
+      return 0;
+    } else new_root->root_tf = 1;
+  }
+  /* reset the rows */if (ledger_table_schema_outdate(t->schema)){
+    if (t->store == NULL)
+      ledger_table_drop_all_rows(t);
+    ledger_table_schema_close(t->schema);
+  } else {
+    /* either the table is closing,
+     * or someone else is changing the schema */
+    if (new_store != NULL)
+      ledger_table_store_free(new_store);
+    else
+      ledger_table_row_free(new_root);
+    ledger_table_schema_free(new_schema);
+    return 0;
+  }
+  ledger_table_lock(t);
+  /* exchange pointers */{
+    old_root = t->root; t->root = new_root;
+    old_store = t->store; t->store = new_store;
+    old_schema = t->schema; t->schema = new_schema;
+    /* cells of the old store go away with its last mark */
+    if (old_store != NULL) t->rows = 0;
+    t->fingerprint = 0u;
+    t->fingerprint_stale_tf = 0;
+  }
+  /* keep the column indexes that still fit the schema */{
+    struct ledger_table_column_index** link = &t->column_indexes;
+    while (*link != NULL){
+      struct ledger_table_column_index* const ci = *link;
+      int const type = (ci->column < n) ? types[ci->column] : 0;
+      if (type == LEDGER_TABLE_ID
+      ||  type == LEDGER_TABLE_INDEX
+      ||  type == LEDGER_TABLE_USTR
+      ||  type == LEDGER_TABLE_DATE)
+      {
+        ledger_table_column_index_reset(ci);
+        link = &ci->next;
+      } else {
+        *link = ci->next;
+        ledger_table_column_index_free(ci);
+      }
+    }
+  }
+  /* keep the column aggregates that still fit the schema */{
+    struct ledger_table_column_aggregate** link = &t->column_aggregates;
+    while (*link != NULL){
+      struct ledger_table_column_aggregate* const ca = *link;
+      int const type = (ca->column < n) ? types[ca->column] : 0;
+      if (type == LEDGER_TABLE_ID
+      ||  type == LEDGER_TABLE_INDEX
+      ||  type == LEDGER_TABLE_BIGNUM)
+      {
+        ca->stale_tf = 1;
+        link = &ca->next;
+      } else {
+        *link = ca->next;
+        ledger_table_column_aggregate_free(ca);
+      }
+    }
+  }
+  /* keep the prefix indexes that still fit the schema */{
+    struct ledger_table_column_prefix** link = &t->column_prefixes;
+    while (*link != NULL){
+      struct ledger_table_column_prefix* const cp = *link;
+      int const type = (cp->column < n) ? types[cp->column] : 0;
+      int const key_type = (cp->key_column < n) ? types[cp->key_column] : 0;
+      if ((type == LEDGER_TABLE_ID
+        || type == LEDGER_TABLE_INDEX
+        || type == LEDGER_TABLE_BIGNUM)
+      &&  (key_type == LEDGER_TABLE_ID
+        || key_type == LEDGER_TABLE_INDEX
+        || key_type == LEDGER_TABLE_DATE))
+      {
+        cp->stale_tf = 1;
+        link = &cp->next;
+      } else {
+        *link = cp->next;
+        ledger_table_column_prefix_free(cp);
+      }
+    }
+  }
+  if (t->observers != NULL)
+    ledger_table_observer_notify(t, LEDGER_TABLE_SCHEMA_RESET, NULL, -1);
+  ledger_table_unlock(t);
+  /* drop the old root */if (old_store != NULL){
+    ledger_table_store_free(old_store);
+  } else {
+    ledger_table_row_free(old_root);
+  }
+  /* drop the old schema */{
+    ledger_table_schema_free(old_schema);
+  }
+  return 1;
+}
+
+int ledger_table_count_rows(struct ledger_table const* t){
+  int nrows;
+  ledger_table_lock_shared(t);
+  nrows = t->rows;
+  ledger_table_unlock_shared(t);
+  return nrows;
+}
+
+int ledger_table_add_column_index
+  (struct ledger_table* t, int column, int kind)
+{
+  int result = 0;
+  ledger_table_lock(t);
+  do {
+    struct ledger_table_column_index* ci;
+    int type;
+    if (kind != LEDGER_TABLE_HASH_INDEX
+    &&  kind != LEDGER_TABLE_ORDERED_INDEX)
+      break;
+    if (column < 0 || column >= t->schema->columns)
+      break;
+    type = t->schema->types[column];
+    if (type != LEDGER_TABLE_ID
+    &&  type != LEDGER_TABLE_INDEX
+    &&  type != LEDGER_TABLE_USTR
+    &&  type != LEDGER_TABLE_DATE)
+      break;
+    ci = ledger_table_column_index_find(t, column);
+    if (ci != NULL){
+      if (ci->kind != kind){
+        /* rebuild as the new kind */
+        ledger_table_column_index_reset(ci);
+        ci->kind = kind;
+      }
+      result = 1;
+      break;
+    }
+    ci = (struct ledger_table_column_index*)ledger_util_malloc
+      (sizeof(struct ledger_table_column_index));
+    if (ci == NULL) break;
+    ci->column = column;
+    ci->kind = kind;
+    ci->order = NULL;
+    ci->slots = NULL;
+    ci->tail = NULL;
+    /* build at the first lookup */
+    ledger_table_column_index_reset(ci);
+    ci->next = t->column_indexes;
+    t->column_indexes = ci;
+    result = 1;
+  } while (0);
+  ledger_table_unlock(t);
+  return result;
+}
+
+int ledger_table_drop_column_index(struct ledger_table* t, int column){
+  int result = 0;
+  struct ledger_table_column_index** link;
+  ledger_table_lock(t);
+  for (link = &t->column_indexes; *link != NULL; link = &(*link)->next){
+    if ((*link)->column == column){
+      struct ledger_table_column_index* const ci = *link;
+      *link = ci->next;
+      ledger_table_column_index_free(ci);
+      result = 1;
+      break;
+    }
+  }
+  ledger_table_unlock(t);
+  return result;
+}
+
+int ledger_table_get_column_index(struct ledger_table const* t, int column){
+  int kind;
+  ledger_table_lock_shared(t);
+  /* get the index kind */{
+    struct ledger_table_column_index const* const ci =
+      ledger_table_column_index_find(t, column);
+    kind = (ci != NULL) ? ci->kind : 0;
+  }
+  ledger_table_unlock_shared(t);
+  return kind;
+}
+
+int ledger_table_find_in_column_index
+  ( struct ledger_table const* t, int column,
+    struct ledger_table_field const* low, int low_inclusive_tf,
+    struct ledger_table_field const* high, int high_inclusive_tf,
+    int** positions)
+{
+  int result = -1;
+  struct ledger_table_key low_key, high_key;
+  *positions = NULL;
+  ledger_table_lock_shared(t);
+  do {
+    struct ledger_table_column_index* const ci =
+      ledger_table_column_index_find(t, column);
+    struct ledger_table_field const* const bounds[2] = {low, high};
+    struct ledger_table_key* const keys[2] = {&low_key, &high_key};
+    int type;
+    int i;
+    if (ci == NULL) break;
+    type = t->schema->types[column];
+    /* convert the bounds */
+    for (i = 0; i < 2; ++i){
+      struct ledger_table_field const* const bound = bounds[i];
+      if (bound == NULL){
+        continue;
+      } else if (type == LEDGER_TABLE_USTR){
+        if (bound->type != LEDGER_TABLE_USTR) break;
+        keys[i]->id = -1;
+        keys[i]->text = (bound->text != NULL)
+          ? bound->text : (unsigned char const*)"";
+      } else if (type == LEDGER_TABLE_DATE){
+        if (bound->type != LEDGER_TABLE_DATE) break;
+        keys[i]->id = bound->date;
+        keys[i]->text = NULL;
+      } else {
+        if (bound->type != LEDGER_TABLE_ID
+        &&  bound->type != LEDGER_TABLE_INDEX)
+          break;
+        keys[i]->id = bound->id;
+        keys[i]->text = NULL;
+      }
+    }
+    if (i < 2) break;
+    /* hash indexes only find equal values */
+    if (ci->kind == LEDGER_TABLE_HASH_INDEX
+    &&  (low == NULL || high == NULL
+      || !low_inclusive_tf || !high_inclusive_tf
+      || ledger_table_key_compare(type, &low_key, &high_key) != 0))
+      break;
+    ledger_util_lock_exclusive(t->cache_lock);
+    result = ledger_table_column_index_lookup
+      ( (struct ledger_table*)t, ci, type,
+        (low != NULL) ? &low_key : NULL, low_inclusive_tf,
+        (high != NULL) ? &high_key : NULL, high_inclusive_tf,
+        positions);
+    ledger_util_unlock_exclusive(t->cache_lock);
+  } while (0);
+  ledger_table_unlock_shared(t);
+  return result;
+}
+
+int ledger_table_add_column_aggregate(struct ledger_table* t, int column){
+  int result = 0;
+  ledger_table_lock(t);
+  do {
+    struct ledger_table_column_aggregate* ca;
+    int type;
+    if (column < 0 || column >= t->schema->columns)
+      break;
+    type = t->schema->types[column];
+    if (type != LEDGER_TABLE_ID
+    &&  type != LEDGER_TABLE_INDEX
+    &&  type != LEDGER_TABLE_BIGNUM)
+      break;
+    if (ledger_table_column_aggregate_find(t, column) != NULL){
+      result = 1;
+      break;
+    }
+    ca = (struct ledger_table_column_aggregate*)ledger_util_malloc
+      (sizeof(struct ledger_table_column_aggregate));
+    if (ca == NULL) break;
+    ca->column = column;
+    ca->sum = ledger_bignum_new();
+    ca->min = ledger_bignum_new();
+    ca->max = ledger_bignum_new();
+    ca->value = ledger_bignum_new();
+    if (ca->sum == NULL || ca->min == NULL
+    ||  ca->max == NULL || ca->value == NULL)
+    {
+      ledger_table_column_aggregate_free(ca);
+      break;
+    }
+    if (!ledger_table_column_aggregate_build(t, ca)){
+      ledger_table_column_aggregate_free(ca);
+      break;
+    }
+    ca->next = t->column_aggregates;
+    t->column_aggregates = ca;
+    result = 1;
+  } while (0);
+  ledger_table_unlock(t);
+  return result;
+}
+
+int ledger_table_drop_column_aggregate(struct ledger_table* t, int column){
+  int result = 0;
+  struct ledger_table_column_aggregate** link;
+  ledger_table_lock(t);
+  for (link = &t->column_aggregates; *link != NULL; link = &(*link)->next){
+    if ((*link)->column == column){
+      struct ledger_table_column_aggregate* const ca = *link;
+      *link = ca->next;
+      ledger_table_column_aggregate_free(ca);
+      result = 1;
+      break;
+    }
+  }
+  ledger_table_unlock(t);
+  return result;
+}
+
+int ledger_table_has_column_aggregate
+  (struct ledger_table const* t, int column)
+{
+  int result;
+  ledger_table_lock_shared(t);
+  result = (ledger_table_column_aggregate_find(t, column) != NULL);
+  ledger_table_unlock_shared(t);
+  return result;
+}
+
+int ledger_table_fetch_column_aggregate
+  ( struct ledger_table const* t, int column, struct ledger_bignum* sum,
+    struct ledger_bignum* min, struct ledger_bignum* max, int* count)
+{
+  int ok = 0;
+  ledger_table_lock_shared(t);
+  do {
+    struct ledger_table_column_aggregate* const ca =
+      ledger_table_column_aggregate_find(t, column);
+    if (ca == NULL) break;
+    ledger_util_lock_exclusive(t->cache_lock);
+    /* rescan if needed */{
+      ok = 1;
+      if ((ca->stale_tf || ca->extremes_stale_tf)
+      &&  (min != NULL || max != NULL || ca->stale_tf))
+      {
+        ok = ledger_table_column_aggregate_build(t, ca);
+      }
+      if (ok && sum != NULL)
+        ok = ledger_bignum_assign(sum, ca->sum);
+      if (ok && min != NULL){
+        ok = (ca->count > 0)
+          ? ledger_bignum_assign(min, ca->min)
+          : ledger_bignum_set_long(min, 0);
+      }
+      if (ok && max != NULL){
+        ok = (ca->count > 0)
+          ? ledger_bignum_assign(max, ca->max)
+          : ledger_bignum_set_long(max, 0);
+      }
+      if (ok && count != NULL)
+        *count = ca->count;
+    }
+    ledger_util_unlock_exclusive(t->cache_lock);
+  } while (0);
+  ledger_table_unlock_shared(t);
+  return ok;
+}
+
+int ledger_table_add_column_prefix
+  (struct ledger_table* t, int column, int key_column)
+{
+  int result = 0;
+  ledger_table_lock(t);
+  do {
+    struct ledger_table_column_prefix* cp;
+    int type, key_type;
+    if (column < 0 || column >= t->schema->columns)
+      break;
+    if (key_column < 0 || key_column >= t->schema->columns)
+      break;
+    type = t->schema->types[column];
+    key_type = t->schema->types[key_column];
+    if (type != LEDGER_TABLE_ID
+    &&  type != LEDGER_TABLE_INDEX
+    &&  type != LEDGER_TABLE_BIGNUM)
+      break;
+    if (key_type != LEDGER_TABLE_ID
+    &&  key_type != LEDGER_TABLE_INDEX
+    &&  key_type != LEDGER_TABLE_DATE)
+      break;
+    if (ledger_table_column_prefix_find(t, column, key_column) != NULL){
+      result = 1;
+      break;
+    }
+    cp = (struct ledger_table_column_prefix*)ledger_util_malloc
+      (sizeof(struct ledger_table_column_prefix));
+    if (cp == NULL) break;
+    cp->column = column;
+    cp->key_column = key_column;
+    cp->covered = 0;
+    cp->count = 0;
+    cp->capacity = 0;
+    cp->allocated = 0;
+    cp->keys = NULL;
+    cp->tree = NULL;
+    /* build at the first query */
+    cp->stale_tf = 1;
+    cp->value = ledger_bignum_new();
+    if (cp->value == NULL){
+      ledger_table_column_prefix_free(cp);
+      break;
+    }
+    cp->next = t->column_prefixes;
+    t->column_prefixes = cp;
+    result = 1;
+  } while (0);
+  ledger_table_unlock(t);
+  return result;
+}
+
+int ledger_table_drop_column_prefix
+  (struct ledger_table* t, int column, int key_column)
+{
+  int result = 0;
+  struct ledger_table_column_prefix** link;
+  ledger_table_lock(t);
+  for (link = &t->column_prefixes; *link != NULL; link = &(*link)->next){
+    if ((*link)->column == column && (*link)->key_column == key_column){
+      struct ledger_table_column_prefix* const cp = *link;
+      *link = cp->next;
+      ledger_table_column_prefix_free(cp);
+      result = 1;
+      break;
+    }
+  }
+  ledger_table_unlock(t);
+  return result;
+}
+
+int ledger_table_fetch_column_prefix
+  ( struct ledger_table const* t, int column, int key_column,
+    long long int key, struct ledger_bignum* sum)
+{
+  int ok = 0;
+  int current_tf;
+  int exclusive_tf = 0;
+  ledger_table_lock_shared(t);
+  do {
+    struct ledger_table_column_prefix* const cp =
+      ledger_table_column_prefix_find(t, column, key_column);
+    if (cp == NULL) break;
+    ledger_util_lock_shared(t->cache_lock);
+    current_tf = (!cp->stale_tf && cp->covered == t->rows);
+    if (!current_tf){
+      /* updating the tree needs it exclusive; the lock does not upgrade,
+       * so the update checks the tree again once held */
+      ledger_util_unlock_shared(t->cache_lock);
+      ledger_util_lock_exclusive(t->cache_lock);
+      exclusive_tf = 1;
+      current_tf = ledger_table_column_prefix_update(t, cp);
+    }
+    if (current_tf){
+      int first = 0, stop = cp->count;
+      int i;
+      /* count the entries with keys up to the bound */
+      while (first < stop){
+        int const mid = first + (stop-first)/2;
+        if (cp->keys[mid] <= key)
+          first = mid+1;
+        else stop = mid;
+      }
+      ok = ledger_bignum_set_long(sum, 0);
+      for (i = first; ok && i > 0; i -= (i & -i)){
+        ok = ledger_bignum_add_assign(sum, cp->tree[i-1]);
+      }
+    }
+    if (exclusive_tf)
+      ledger_util_unlock_exclusive(t->cache_lock);
+    else ledger_util_unlock_shared(t->cache_lock);
+  } while (0);
+  ledger_table_unlock_shared(t);
+  return ok;
+}
+
+int ledger_table_scan_column
+  ( struct ledger_table const* t, int column, unsigned char const* bits,
+    struct ledger_bignum* sum, struct ledger_bignum* min,
+    struct ledger_bignum* max, int* count)
+{
+  int ok;
+  ledger_table_lock_shared(t);
+  ok = ledger_table_scan_column_sub(t, column, bits, sum, min, max, count);
+  ledger_table_unlock_shared(t);
+  return ok;
+}
+
+int ledger_table_filter_column
+  ( struct ledger_table const* t, int column,
+    struct ledger_table_field const* low, int low_inclusive_tf,
+    struct ledger_table_field const* high, int high_inclusive_tf,
+    unsigned char* bits)
+{
+  int result = -1;
+  struct ledger_table_scan sc;
+  ledger_table_lock_shared(t);
+  do {
+    ledger_table_scan_cb cb;
+    int type;
+    if (column < 0 || column >= t->schema->columns) break;
+    type = t->schema->types[column];
+    if (!ledger_table_scan_init(&sc, type)) break;
+    sc.marks = bits;
+    /* convert the bounds */
+    switch (type){
+    case LEDGER_TABLE_ID:
+    case LEDGER_TABLE_INDEX:
+      cb = ledger_table_scan_filter_ids;
+      if (low != NULL){
+        if (low->type != LEDGER_TABLE_ID && low->type != LEDGER_TABLE_INDEX)
+          cb = NULL;
+        else sc.low = (long long int)low->id + (low_inclusive_tf ? 0 : 1);
+      }
+      if (high != NULL){
+        if (high->type != LEDGER_TABLE_ID && high->type != LEDGER_TABLE_INDEX)
+          cb = NULL;
+        else sc.high = (long long int)high->id - (high_inclusive_tf ? 0 : 1);
+      }
+      break;
+    case LEDGER_TABLE_DATE:
+      cb = ledger_table_scan_filter_dates;
+      if (low != NULL){
+        if (low->type != LEDGER_TABLE_DATE)
+          cb = NULL;
+        else if (low_inclusive_tf)
+          sc.low = low->date;
+        else if (low->date < LLONG_MAX)
+          sc.low = low->date+1;
+        else /* nothing lies above */sc.high = LLONG_MIN;
+      }
+      if (high != NULL){
+        if (high->type != LEDGER_TABLE_DATE)
+          cb = NULL;
+        else if (high_inclusive_tf)
+          sc.high = (high->date < sc.high) ? high->date : sc.high;
+        else if (high->date > LLONG_MIN)
+          sc.high = (high->date-1 < sc.high) ? high->date-1 : sc.high;
+        else /* nothing lies below */sc.low = LLONG_MAX;
+      }
+      break;
+    case LEDGER_TABLE_BIGNUM:
+      {
+        struct ledger_table_field const* const bounds[2] = {low, high};
+        struct ledger_table_amount* const amounts[2] =
+          {&sc.low_amount, &sc.high_amount};
+        int i;
+        cb = ledger_table_scan_filter_amounts;
+        for (i = 0; i < 2; ++i){
+          long long int value;
+          int point_place;
+          if (bounds[i] == NULL){
+            continue;
+          } else if (bounds[i]->type != LEDGER_TABLE_BIGNUM
+          ||  bounds[i]->bignum == NULL)
+          {
+            cb = NULL;
+          } else if (ledger_bignum_get_fixed
+              (bounds[i]->bignum, &value, &point_place))
+          {
+            amounts[i]->value.fixed = value;
+            amounts[i]->point_place = point_place;
+          } else {
+            amounts[i]->value.bignum = bounds[i]->bignum;
+            amounts[i]->point_place = LEDGER_TABLE_AMOUNT_BIG;
+          }
+        }
+        if (low != NULL)
+          sc.low_least = low_inclusive_tf ? 0 : +1;
+        if (high != NULL)
+          sc.high_most = high_inclusive_tf ? 0 : -1;
+      }break;
+    default:
+      cb = NULL;
+      break;
+    }
+    if (cb != NULL && ledger_table_scan_run(t, column, &sc, cb))
+      result = sc.count;
+    ledger_table_scan_clear(&sc);
+  } while (0);
+  ledger_table_unlock_shared(t);
+  return result;
+}
+
+int ledger_table_scale_column
+  ( struct ledger_table* t, int column,
+    struct ledger_bignum const* numerator,
+    struct ledger_bignum const* denominator, int point_place)
+{
+  int ok = 0;
+  struct ledger_bignum_rate* const rate = ledger_bignum_rate_new();
+  if (rate == NULL) return 0;
+  if (!ledger_bignum_rate_set(rate, numerator, denominator, point_place)){
+    ledger_bignum_rate_free(rate);
+    return 0;
+  }
+  ledger_table_lock(t);
+  do {
+    struct ledger_table_store const* const s = t->store;
+    union ledger_table_cell cell;
+    if (column < 0 || column >= t->schema->columns)
+      break;
+    if (t->schema->types[column] != LEDGER_TABLE_BIGNUM)
+      break;
+    /* the summaries of the column no longer hold */{
+      struct ledger_table_column_aggregate* const ca =
+        ledger_table_column_aggregate_find(t, column);
+      struct ledger_table_column_prefix* cp;
+      if (ca != NULL)
+        ca->stale_tf = 1;
+      for (cp = t->column_prefixes; cp != NULL; cp = cp->next){
+        if (cp->column == column)
+          cp->stale_tf = 1;
+      }
+      t->fingerprint_stale_tf = 1;
     }
-    result = 1;
-    while (!(a_mark.row->root_tf || b_mark.row->root_tf)){
+    if (s != NULL && s->dead_count == 0){
+      /* the column is one array: scale it in place */
+      ok = 1;
+      if (s->rows > 0){
+        ledger_table_store_cell(s, column, 0, &cell);
+        ok = ledger_table_scale_amounts(rate, cell.amount, s->rows);
+      }
+    } else if (s != NULL){
       int i;
-      struct ledger_table_row *const a_row = a_mark.row;
-      struct ledger_table_row *const b_row = b_mark.row;
-      int const *const types = a_row->schema->types;
-      int const columns = a_row->schema->columns;
-      ledger_table_schema_lock2(a_row->schema, b_row->schema);
-      /* perform field-wise comparison */
-      for (i = 0; i < columns; ++i){
-        switch (types[i]){
-        case LEDGER_TABLE_ID:
-        case LEDGER_TABLE_INDEX:
-          {
-            if (a_row->data[i].item_id != b_row->data[i].item_id)
-              result = 0;
-          }break;
-        case LEDGER_TABLE_BIGNUM:
-          {
-            if (ledger_bignum_compare(
-                a_row->data[i].bignum, b_row->data[i].bignum) != 0)
-              result = 0;
-          }break;
-        case LEDGER_TABLE_USTR:
-          {
-            if (ledger_util_ustrcmp(
-                a_row->data[i].string, b_row->data[i].string) != 0)
-              result = 0;
-          }break;
-        }
-        if (!result) break;
+      for (i = 0; i < s->rows; ++i){
+        if (s->dead[i]) continue;
+        ledger_table_store_cell(s, column, i, &cell);
+        if (!ledger_table_scale_amounts(rate, cell.amount, 1)) break;
       }
-      ledger_table_schema_unlock(a_row->schema);
-      ledger_table_schema_unlock(b_row->schema);
-      if (!result) break;
-      /* perform consistency check */{
-        if (!ledger_table_mark_add_one_checked(&a_mark)){
-          result = 0;
+      ok = (i >= s->rows);
+    } else if (t->root != NULL){
+      struct ledger_table_row* r;
+      for (r = t->root->next; r != t->root; r = r->next){
+        if (ledger_table_row_cell(r, column, &cell) != LEDGER_TABLE_BIGNUM
+        ||  !ledger_table_scale_amounts(rate, cell.amount, 1))
           break;
-        }
-        if (!ledger_table_mark_add_one_checked(&b_mark)){
-          result = 0;
-          break;
-        }
+      }
+      ok = (r == t->root);
+    } else ok = 1;
+    if (t->observers != NULL){
+      struct ledger_table_cursor cursor;
+      for (ledger_table_cursor_begin(&cursor, t);
+          !ledger_table_cursor_is_end(&cursor);
+          ledger_table_cursor_move(&cursor, +1))
+      {
+        ledger_table_observer_notify(t, LEDGER_TABLE_CELL_PUT,
+          ledger_table_cursor_mark(&cursor), column);
       }
     }
-  } while(0);
-  ledger_table_mark_clear(&a_mark);
-  ledger_table_mark_clear(&b_mark);
-  return result;
+  } while (0);
+  ledger_table_unlock(t);
+  ledger_bignum_rate_free(rate);
+  return ok;
 }
 
-struct ledger_table_mark* ledger_table_begin(struct ledger_table* t){
-  struct ledger_table_mark* m;
-  /* acquire the mark */
-  ledger_table_lock(t);
-  m = ledger_table_mark_new(t, t->root, 1);
-  ledger_table_unlock(t);
-  /* move the mark */
-  ledger_table_mark_move(m, +1);
-  return m;
+struct ledger_table_pool* ledger_table_pool_new(void){
+  struct ledger_table_pool* p = (struct ledger_table_pool*)
+    ledger_util_ref_malloc
+      (sizeof(struct ledger_table_pool), ledger_table_pool_free_cb);
+  if (p != NULL){
+    int i;
+    p->count = 0;
+    p->bucket_count = 16;
+    p->lock = ledger_util_lock_new();
+    p->buckets = (struct ledger_table_pool_entry**)ledger_util_malloc
+      (p->bucket_count*sizeof(struct ledger_table_pool_entry*));
+    if (p->lock == NULL || p->buckets == NULL){
+      ledger_util_ref_free(p);
+      return NULL;
+    }
+    for (i = 0; i < p->bucket_count; ++i){
+      p->buckets[i] = NULL;
+    }
+  }
+  return p;
 }
 
-struct ledger_table_mark* ledger_table_begin_c
-  (struct ledger_table const* t)
+struct ledger_table_pool* ledger_table_pool_acquire
+  (struct ledger_table_pool* p)
 {
-  struct ledger_table_mark* m;
-  /* acquire the mark */
-  ledger_table_lock(t);
-  m = ledger_table_mark_new(t, t->root, 0);
-  ledger_table_unlock(t);
-  /* move the mark */
-  ledger_table_mark_move(m, +1);
-  return m;
+  return (struct ledger_table_pool*)ledger_util_ref_acquire(p);
 }
 
-struct ledger_table_mark* ledger_table_end(struct ledger_table* t){
-  struct ledger_table_mark* m;
-  ledger_table_lock(t);
-  m = ledger_table_mark_new(t, t->root, 1);
-  ledger_table_unlock(t);
-  return m;
+void ledger_table_pool_free(struct ledger_table_pool* p){
+  if (p != NULL){
+    ledger_util_ref_free(p);
+  }
+  return;
 }
 
-struct ledger_table_mark* ledger_table_end_c(struct ledger_table const* t){
-  struct ledger_table_mark* m;
-  ledger_table_lock(t);
-  m = ledger_table_mark_new(t, t->root, 0);
-  ledger_table_unlock(t);
-  return m;
+int ledger_table_pool_count(struct ledger_table_pool const* p){
+  int count;
+  ledger_util_lock_shared(p->lock);
+  count = p->count;
+  ledger_util_unlock_shared(p->lock);
+  return count;
 }
 
-int ledger_table_mark_is_equal
-  (struct ledger_table_mark const* a, struct ledger_table_mark const* b)
+void ledger_table_set_pool
+  (struct ledger_table* t, struct ledger_table_pool* p)
 {
-  return (a->source == b->source &&  a->row == b->row);
+  struct ledger_table_pool* old;
+  if (p != NULL)
+    p = ledger_table_pool_acquire(p);
+  ledger_table_lock(t);
+  old = t->pool;
+  t->pool = p;
+  ledger_table_unlock(t);
+  ledger_table_pool_free(old);
+  return;
 }
 
-void ledger_table_mark_free(struct ledger_table_mark* m){
-  /* NOTE ledger_table_mark_clear(m); called by ledger_util_ref_free */
-  ledger_util_ref_free(m);
+struct ledger_table_pool* ledger_table_get_pool(struct ledger_table const* t){
+  struct ledger_table_pool* p;
+  ledger_table_lock_shared(t);
+  p = t->pool;
+  ledger_table_unlock_shared(t);
+  return p;
 }
 
-int ledger_table_get_column_count(struct ledger_table const* t){
-  int columns;
-  ledger_table_lock(t);
-  columns = t->schema != NULL ? t->schema->columns : 0;
-  ledger_table_unlock(t);
-  return columns;
+int ledger_table_get_fingerprint
+  (struct ledger_table const* t, unsigned long long int* fingerprint)
+{
+  int ok;
+  ledger_table_lock_shared(t);
+  ok = ledger_table_fingerprint_get(t, fingerprint);
+  ledger_table_unlock_shared(t);
+  return ok;
 }
 
-int ledger_table_get_column_type(struct ledger_table const* t, int i){
-  int typ;
+int ledger_table_add_observer
+  (struct ledger_table* t, ledger_table_observer_cb cb, void* arg)
+{
+  struct ledger_table_observer* ob;
+  if (cb == NULL) return 0;
+  ob = (struct ledger_table_observer*)ledger_util_malloc
+    (sizeof(struct ledger_table_observer));
+  if (ob == NULL) return 0;
+  ob->cb = cb;
+  ob->arg = arg;
   ledger_table_lock(t);
-  /* get type value */{
-    struct ledger_table_schema const* const s = t->schema;
-    if (i < 0 || i >= s->columns) typ = 0;
-    else typ = s->types[i];
+  if (t->observers == NULL)
+    t->observers = ledger_table_observer_list_new();
+  if (t->observers == NULL){
+    ledger_util_free(ob);
+    ob = NULL;
+  } else {
+    struct ledger_table_observer_list* const list = t->observers;
+    ledger_util_lock_exclusive(list->lock);
+    ob->next = list->first;
+    list->first = ob;
+    ledger_util_unlock_exclusive(list->lock);
   }
   ledger_table_unlock(t);
-  return typ;
+  return ob != NULL;
 }
 
-int ledger_table_set_column_types
-  (struct ledger_table* t, int n, int const* types)
+int ledger_table_drop_observer
+  (struct ledger_table* t, ledger_table_observer_cb cb, void* arg)
 {
-  struct ledger_table_schema *new_schema;
-  struct ledger_table_row *new_root;
-  struct ledger_table_schema *old_schema;
-  struct ledger_table_row *old_root;
-  /* validate the types */{
-    int i;
-    if (n > LEDGER_TABLE_SCHEMA_MAX) return 0;
-    for (i = 0; i < n; ++i){
-      if (types[i] >= 1 && types[i] <= 4)
-        continue;
-      else
-        break;
+  int result = 0;
+  struct ledger_table_observer** link;
+  struct ledger_table_observer_list* list;
+  ledger_table_lock(t);
+  list = t->observers;
+  if (list != NULL){
+    ledger_util_lock_exclusive(list->lock);
+    link = &list->first;
+  } else link = NULL;
+  for (; link != NULL && *link != NULL; link = &(*link)->next){
+    struct ledger_table_observer* const ob = *link;
+    if (ob->cb == cb && ob->arg == arg){
+      if (list->depth > 0){
+        /* free after the notification */
+        ob->cb = NULL;
+      } else {
+        *link = ob->next;
+        ledger_util_free(ob);
+      }
+      result = 1;
+      break;
     }
-    if (i < n) /* invalid schema so */return 0;
-  }
-  /* allocate the column schema */{
-    new_schema = ledger_table_schema_new(n, types);
-    if (new_schema == NULL) return 0;
-  }
-  /* allocate new root */{
-    new_root = ledger_table_row_new(new_schema);
-    if (new_root == NULL){
-      ledger_table_schema_free(new_schema);
-      return 0;
-    } else new_root->root_tf = 1;
-  }
-  /* reset the rows */if (ledger_table_schema_outdate(t->schema)){
-    ledger_table_drop_all_rows(t);
-    ledger_table_schema_close(t->schema);
-  } else {
-    /* either the table is closing,
-     * or someone else is changing the schema */
-    ledger_table_row_free(new_root);
-    ledger_table_schema_free(new_schema);
-    return 0;
   }
+  if (list != NULL)
+    ledger_util_unlock_exclusive(list->lock);
+  ledger_table_unlock(t);
+  return result;
+}
+
+void ledger_table_set_tombstones(struct ledger_table* t, int tf){
   ledger_table_lock(t);
-  /* exchange pointers */{
-    old_root = t->root; t->root = new_root;
-    old_schema = t->schema; t->schema = new_schema;
-  }
+  t->tombstones_tf = (tf != 0);
   ledger_table_unlock(t);
-  /* drop the old root */{
-    ledger_table_row_free(old_root);
-  }
-  /* drop the old schema */{
-    ledger_table_schema_free(old_schema);
-  }
-  return 1;
+  return;
 }
 
-int ledger_table_count_rows(struct ledger_table const* t){
-  int nrows;
+int ledger_table_get_tombstones(struct ledger_table const* t){
+  int tf;
+  ledger_table_lock_shared(t);
+  tf = t->tombstones_tf;
+  ledger_table_unlock_shared(t);
+  return tf;
+}
+
+int ledger_table_count_tombstones(struct ledger_table const* t){
+  int count;
+  ledger_table_lock_shared(t);
+  count = (t->store != NULL) ? t->store->dead_count : 0;
+  ledger_table_unlock_shared(t);
+  return count;
+}
+
+int ledger_table_vacuum(struct ledger_table* t){
+  int result;
   ledger_table_lock(t);
-  nrows = t->rows;
+  if (t->store != NULL){
+    result = ledger_table_store_vacuum(t->store);
+  } else {
+    /* linked rows are already gone, so only reindex the rest */
+    result = (t->root == NULL) || ledger_table_index_build(t);
+  }
   ledger_table_unlock(t);
-  return nrows;
+  return result;
 }
 
 int ledger_table_add_row(struct ledger_table_mark* mark){
   int result;
-  ledger_table_schema_lock(mark->row->schema);
+  ledger_table_schema_lock(ledger_table_mark_schema(mark));
   result = ledger_table_add_row_sub(mark);
-  ledger_table_schema_unlock(mark->row->schema);
+  ledger_table_schema_unlock(ledger_table_mark_schema(mark));
   return result;
 }
 
 int ledger_table_drop_row(struct ledger_table_mark* mark){
   int result;
-  ledger_table_schema_lock(mark->row->schema);
+  ledger_table_schema_lock(ledger_table_mark_schema(mark));
   result = ledger_table_drop_row_sub(mark);
-  ledger_table_schema_unlock(mark->row->schema);
+  ledger_table_schema_unlock(ledger_table_mark_schema(mark));
   return result;
 }
 
@@ -1453,9 +7258,9 @@ int ledger_table_fetch_string
   (struct ledger_table_mark const* mark, int i, unsigned char* buf, int len)
 {
   int result;
-  ledger_table_schema_lock(mark->row->schema);
+  ledger_table_schema_lock_shared(ledger_table_mark_schema(mark));
   result = ledger_table_fetch_string_sub(mark, i, buf, len);
-  ledger_table_schema_unlock(mark->row->schema);
+  ledger_table_schema_unlock_shared(ledger_table_mark_schema(mark));
   return result;
 }
 
@@ -1464,9 +7269,9 @@ int ledger_table_put_string
   (struct ledger_table_mark const* mark, int i, unsigned char const* value)
 {
   int result;
-  ledger_table_schema_lock(mark->row->schema);
+  ledger_table_schema_lock(ledger_table_mark_schema(mark));
   result = ledger_table_put_string_sub(mark, i, value);
-  ledger_table_schema_unlock(mark->row->schema);
+  ledger_table_schema_unlock(ledger_table_mark_schema(mark));
   return result;
 }
 
@@ -1475,9 +7280,9 @@ int ledger_table_fetch_bignum
   (struct ledger_table_mark const* mark, int i, struct ledger_bignum* n)
 {
   int result;
-  ledger_table_schema_lock(mark->row->schema);
+  ledger_table_schema_lock_shared(ledger_table_mark_schema(mark));
   result = ledger_table_fetch_bignum_sub(mark, i, n);
-  ledger_table_schema_unlock(mark->row->schema);
+  ledger_table_schema_unlock_shared(ledger_table_mark_schema(mark));
   return result;
 }
 
@@ -1486,18 +7291,33 @@ int ledger_table_put_bignum
     struct ledger_bignum const* value)
 {
   int result;
-  ledger_table_schema_lock(mark->row->schema);
+  ledger_table_schema_lock(ledger_table_mark_schema(mark));
   result = ledger_table_put_bignum_sub(mark, i, value);
-  ledger_table_schema_unlock(mark->row->schema);
+  ledger_table_schema_unlock(ledger_table_mark_schema(mark));
+  return result;
+}
+
+int ledger_table_fetch_fixed
+  ( struct ledger_table_mark const* mark, int i,
+    long long int* value, int* point_place)
+{
+  int result;
+  ledger_table_schema_lock_shared(ledger_table_mark_schema(mark));
+  result = ledger_table_fetch_fixed_sub(mark, i, value, point_place);
+  ledger_table_schema_unlock_shared(ledger_table_mark_schema(mark));
   return result;
 }
 
 
 void ledger_table_mark_move(struct ledger_table_mark* m, int n){
-  struct ledger_table_schema *const schema = m->row->schema;
+  struct ledger_table_schema *const schema = ledger_table_mark_schema(m);
   if (n == 0) return;
-  ledger_table_schema_lock(schema);
-  if (!ledger_table_schema_is_outdated(schema)){
+  ledger_table_schema_lock_shared(schema);
+  if (ledger_table_schema_is_outdated_sub(schema)){
+    /* no movement */;
+  } else if (m->store != NULL){
+    m->index = ledger_table_store_move(m->store, m->index, n);
+  } else {
     if (n > 0){
       int i;
       for (i = 0; i < n; ++i){
@@ -1510,17 +7330,73 @@ void ledger_table_mark_move(struct ledger_table_mark* m, int n){
       }
     }
   }
-  ledger_table_schema_unlock(schema);
+  ledger_table_schema_unlock_shared(schema);
   return;
 }
 
+int ledger_table_mark_seek(struct ledger_table_mark* m, int row_index){
+  int result;
+  struct ledger_table_schema *const schema = ledger_table_mark_schema(m);
+  ledger_table_schema_lock_shared(schema);
+  if (ledger_table_schema_is_outdated_sub(schema)){
+    result = 0;
+  } else if (m->store != NULL){
+    int index;
+    ledger_util_lock_exclusive(schema->cache_lock);
+    result = ledger_table_store_locate(m->store, row_index, &index);
+    if (result) m->index = index;
+    ledger_util_unlock_exclusive(schema->cache_lock);
+  } else {
+    struct ledger_table* const t = (struct ledger_table*)m->source;
+    ledger_util_lock_exclusive(schema->cache_lock);
+    if (!ledger_table_index_build(t)){
+      result = 0;
+    } else if (row_index < 0 || row_index > t->position_count){
+      result = 0;
+    } else {
+      ledger_table_mark_exchange(m, (row_index == t->position_count)
+          ? t->root : t->positions[row_index]);
+      result = 1;
+    }
+    ledger_util_unlock_exclusive(schema->cache_lock);
+  }
+  ledger_table_schema_unlock_shared(schema);
+  return result;
+}
+
+int ledger_table_mark_get_index(struct ledger_table_mark const* m){
+  int result;
+  struct ledger_table_schema *const schema = ledger_table_mark_schema(m);
+  ledger_table_schema_lock_shared(schema);
+  if (ledger_table_schema_is_outdated_sub(schema)){
+    result = -1;
+  } else if (m->store != NULL){
+    ledger_util_lock_exclusive(schema->cache_lock);
+    result = ledger_table_store_position(m->store, m->index);
+    ledger_util_unlock_exclusive(schema->cache_lock);
+  } else {
+    struct ledger_table* const t = (struct ledger_table*)m->source;
+    ledger_util_lock_exclusive(schema->cache_lock);
+    if (!ledger_table_index_build(t)){
+      result = -1;
+    } else if (m->row->root_tf){
+      result = t->position_count;
+    } else {
+      result = ledger_table_index_find(t, m->row);
+    }
+    ledger_util_unlock_exclusive(schema->cache_lock);
+  }
+  ledger_table_schema_unlock_shared(schema);
+  return result;
+}
+
 int ledger_table_fetch_id
   (struct ledger_table_mark const* mark, int i, int* n)
 {
   int result;
-  ledger_table_schema_lock(mark->row->schema);
+  ledger_table_schema_lock_shared(ledger_table_mark_schema(mark));
   result = ledger_table_fetch_id_sub(mark, i, n);
-  ledger_table_schema_unlock(mark->row->schema);
+  ledger_table_schema_unlock_shared(ledger_table_mark_schema(mark));
   return result;
 }
 
@@ -1529,16 +7405,100 @@ int ledger_table_put_id
   ( struct ledger_table_mark const* mark, int i, int value)
 {
   int result;
-  ledger_table_schema_lock(mark->row->schema);
+  ledger_table_schema_lock(ledger_table_mark_schema(mark));
   result = ledger_table_put_id_sub(mark, i, value);
-  ledger_table_schema_unlock(mark->row->schema);
+  ledger_table_schema_unlock(ledger_table_mark_schema(mark));
+  return result;
+}
+
+int ledger_table_fetch_date
+  (struct ledger_table_mark const* mark, int i, long long int* value)
+{
+  int result;
+  ledger_table_schema_lock_shared(ledger_table_mark_schema(mark));
+  result = ledger_table_fetch_date_sub(mark, i, value);
+  ledger_table_schema_unlock_shared(ledger_table_mark_schema(mark));
+  return result;
+}
+
+int ledger_table_put_date
+  ( struct ledger_table_mark const* mark, int i, long long int value)
+{
+  int result;
+  ledger_table_schema_lock(ledger_table_mark_schema(mark));
+  result = ledger_table_put_date_sub(mark, i, value);
+  ledger_table_schema_unlock(ledger_table_mark_schema(mark));
+  return result;
+}
+
+int ledger_table_fetch_row
+  ( struct ledger_table_mark const* mark, int n,
+    struct ledger_table_field* fields)
+{
+  int result;
+  ledger_table_schema_lock_shared(ledger_table_mark_schema(mark));
+  result = ledger_table_fetch_row_sub(mark, n, fields);
+  ledger_table_schema_unlock_shared(ledger_table_mark_schema(mark));
+  return result;
+}
+
+int ledger_table_put_row
+  ( struct ledger_table_mark const* mark, int n,
+    struct ledger_table_field const* fields)
+{
+  int result;
+  ledger_table_schema_lock(ledger_table_mark_schema(mark));
+  result = ledger_table_put_row_sub(mark, n, fields);
+  ledger_table_schema_unlock(ledger_table_mark_schema(mark));
+  return result;
+}
+
+int ledger_table_append_rows
+  ( struct ledger_table_mark* mark, int rows, int n,
+    struct ledger_table_field const* fields)
+{
+  int result = 0;
+  int added = 0;
+  struct ledger_table_schema *const schema = ledger_table_mark_schema(mark);
+  ledger_table_schema_lock(schema);
+  if (!mark->mutable_flag || rows < 0 || n < 0){
+    result = 0;
+  } else do {
+    /* make room for all rows at once */
+    if (mark->store != NULL){
+      if (mark->store->rows > INT_MAX-1-rows) break;
+      if (!ledger_table_store_reserve(mark->store, mark->store->rows+rows))
+        break;
+    }
+    for (added = 0; added < rows; ++added){
+      if (!ledger_table_add_row_sub(mark)) break;
+      if (!ledger_table_put_row_sub(mark, n, fields+((size_t)added)*n)){
+        ledger_table_drop_row_sub(mark);
+        ledger_table_mark_move(mark, +1);
+        break;
+      }
+      /* return to the original row */
+      ledger_table_mark_move(mark, +1);
+    }
+    if (added < rows){
+      /* remove the rows already added */
+      for (; added > 0; --added){
+        ledger_table_mark_move(mark, -1);
+        ledger_table_drop_row_sub(mark);
+        ledger_table_mark_move(mark, +1);
+      }
+      break;
+    }
+    result = 1;
+  } while (0);
+  ledger_table_schema_unlock(schema);
   return result;
 }
 
 int ledger_table_mark_get_type
   (struct ledger_table_mark const* m, int i)
 {
-  struct ledger_table_schema *const schema = m->row->schema;
+  struct ledger_table_schema *const schema = ledger_table_mark_schema(m);
   if (i < 0
   ||  i >= schema->columns)
     return 0;
@@ -1546,13 +7506,107 @@ int ledger_table_mark_get_type
 }
 
 int ledger_table_mark_is_valid(struct ledger_table_mark const* mark){
-  return ledger_table_schema_is_outdated(mark->row->schema);
+  return ledger_table_schema_is_outdated(ledger_table_mark_schema(mark));
 }
 
 struct ledger_table_mark* ledger_table_mark_acquire
   (struct ledger_table_mark* mark)
 {
-  return (struct ledger_table_mark*)ledger_util_ref_acquire(mark);
+  if (mark->borrowed_tf)
+    /* cursors cannot be shared */return NULL;
+  else return (struct ledger_table_mark*)ledger_util_ref_acquire(mark);
+}
+
+void ledger_table_cursor_begin
+  (struct ledger_table_cursor* c, struct ledger_table const* t)
+{
+  struct ledger_table_mark* const m = (struct ledger_table_mark*)c;
+  ledger_table_cursor_end(c, t);
+  if (m->store != NULL){
+    m->index = ledger_table_store_live_row(m->store, 0, +1);
+  } else {
+    m->row = m->row->next;
+  }
+  return;
+}
+
+void ledger_table_cursor_end
+  (struct ledger_table_cursor* c, struct ledger_table const* t)
+{
+  struct ledger_table_mark* const m = (struct ledger_table_mark*)c;
+  ledger_table_lock_shared(t);
+  m->source = t;
+  m->row = (t->store != NULL) ? NULL : t->root;
+  m->store = t->store;
+  m->index = (t->store != NULL) ? -1 : 0;
+  m->prev_mark = NULL;
+  m->next_mark = NULL;
+  m->mutable_flag = 0;
+  m->borrowed_tf = 1;
+  ledger_table_unlock_shared(t);
+  return;
+}
+
+int ledger_table_cursor_is_end(struct ledger_table_cursor const* c){
+  return ledger_table_mark_at_end((struct ledger_table_mark const*)c);
+}
+
+void ledger_table_cursor_move(struct ledger_table_cursor* c, int n){
+  struct ledger_table_mark* const m = (struct ledger_table_mark*)c;
+  if (m->store != NULL){
+    m->index = ledger_table_store_move(m->store, m->index, n);
+  } else {
+    for (; n > 0; --n){
+      m->row = m->row->next;
+    }
+    for (; n < 0; ++n){
+      m->row = m->row->prev;
+    }
+  }
+  return;
+}
+
+int ledger_table_cursor_seek(struct ledger_table_cursor* c, int row_index){
+  int result;
+  struct ledger_table_mark* const m = (struct ledger_table_mark*)c;
+  struct ledger_table* const t = (struct ledger_table*)m->source;
+  if (m->store != NULL && m->store->dead_count == 0){
+    if (row_index < 0 || row_index > m->store->rows){
+      result = 0;
+    } else {
+      m->index = (row_index == m->store->rows) ? -1 : row_index;
+      result = 1;
+    }
+  } else if (m->store != NULL){
+    int index;
+    ledger_table_lock_shared(t);
+    ledger_util_lock_exclusive(t->cache_lock);
+    result = ledger_table_store_locate(m->store, row_index, &index);
+    if (result) m->index = index;
+    ledger_util_unlock_exclusive(t->cache_lock);
+    ledger_table_unlock_shared(t);
+  } else {
+    ledger_table_lock_shared(t);
+    ledger_util_lock_exclusive(t->cache_lock);
+    if (!ledger_table_index_build(t)){
+      result = 0;
+    } else if (row_index < 0 || row_index > t->position_count){
+      result = 0;
+    } else {
+      m->row = (row_index == t->position_count)
+          ? t->root : t->positions[row_index];
+      result = 1;
+    }
+    ledger_util_unlock_exclusive(t->cache_lock);
+    ledger_table_unlock_shared(t);
+  }
+  return result;
+}
+
+struct ledger_table_mark const* ledger_table_cursor_mark
+  (struct ledger_table_cursor const* c)
+{
+  return (struct ledger_table_mark const*)c;
 }
 
 /* END   implementation */
@@ -23,7 +23,33 @@ enum ledger_table_type {
   /* unsigned character string */
   LEDGER_TABLE_USTR = 3,
   /* array index */
-  LEDGER_TABLE_INDEX = 4
+  LEDGER_TABLE_INDEX = 4,
+  /* date, packed as by `ledger_util_date_from_text` */
+  LEDGER_TABLE_DATE = 5
+};
+
+/*
+ * brief: Secondary column index kinds
+ */
+enum ledger_table_index_kind {
+  /* hash index, for equal values */
+  LEDGER_TABLE_HASH_INDEX = 1,
+  /* ordered index, for equal values and ranges */
+  LEDGER_TABLE_ORDERED_INDEX = 2
+};
+
+/*
+ * brief: Table change events
+ */
+enum ledger_table_event {
+  /* a row was added, and the mark points to it */
+  LEDGER_TABLE_ROW_ADDED = 1,
+  /* a row is about to be dropped, and the mark points to it */
+  LEDGER_TABLE_ROW_DROPPED = 2,
+  /* a cell was put, and the mark points to its row */
+  LEDGER_TABLE_CELL_PUT = 3,
+  /* the column types changed, and all rows went away */
+  LEDGER_TABLE_SCHEMA_RESET = 4
 };
 
 /*
@@ -31,17 +57,77 @@ enum ledger_table_type {
  */
 struct ledger_table;
 
+/*
+ * brief: Pool of long strings shared between tables
+ */
+struct ledger_table_pool;
+
+/*
+ * brief: Caller-described row item, for whole-row access
+ */
+struct ledger_table_field {
+  /* column index */
+  int column;
+  /* value type to use: LEDGER_TABLE_ID, LEDGER_TABLE_BIGNUM,
+   *   LEDGER_TABLE_USTR or LEDGER_TABLE_DATE */
+  int type;
+  /* identifier value */
+  int id;
+  /* packed date value, -1 for no date, or below -1 for kept text */
+  long long int date;
+  /* big number value, allocated by the caller */
+  struct ledger_bignum* bignum;
+  /* NUL-terminated text to put */
+  unsigned char const* text;
+  /* buffer to receive fetched text */
+  unsigned char* buf;
+  /* size of the fetch buffer */
+  int len;
+  /* length of the fetched text, which can exceed the buffer */
+  int text_length;
+};
+
 /*
  * brief: Table row iterator
  */
 struct ledger_table_mark;
 
+/*
+ * brief: Borrowed read-only table row iterator. A cursor lives
+ *   wherever the caller puts it and holds no references, so the
+ *   table must stay alive and unmodified while the cursor is in use;
+ *   hold the table's read lock while scanning if other threads might
+ *   modify the table. The members are private.
+ */
+struct ledger_table_cursor {
+  union {
+    void* pointers[8];
+    long long int alignment;
+  } cursor_data;
+};
+
 /*
  * Construct a new table.
  * @return the account on success, otherwise NULL
  */
 struct ledger_table* ledger_table_new(void);
 
+/*
+ * Construct a new table backed by contiguous per-column arrays.
+ * Columnar tables favor column scans and appends over insertions
+ * in the middle. Marks on a columnar table stay on their rows
+ * across insertions and deletions elsewhere in the table.
+ * @return the table on success, otherwise NULL
+ */
+struct ledger_table* ledger_table_new_columnar(void);
+
+/*
+ * Check whether a table uses the columnar storage backend.
+ * - t the table to query
+ * @return one if the table is columnar, zero otherwise
+ */
+int ledger_table_is_columnar(struct ledger_table const* t);
+
 /*
  * Acquire an old table.
  * - t the table for which to acquire a reference
@@ -55,6 +141,68 @@ struct ledger_table* ledger_table_acquire(struct ledger_table* );
  */
 void ledger_table_free(struct ledger_table* t);
 
+/*
+ * Hold a table for reading. Table functions lock the table on their own;
+ * use this lock to keep several calls consistent, such as a whole scan,
+ * while other threads might modify the table. Locks nest within a thread,
+ * and a thread holding the read lock must not modify the table. Calls
+ * made under the lock skip the atomic operations of taking it again,
+ * so long scans run faster while holding it.
+ * - t the table to lock
+ */
+void ledger_table_read_lock(struct ledger_table const* t);
+
+/*
+ * Release a table held for reading.
+ * - t the table to unlock
+ */
+void ledger_table_read_unlock(struct ledger_table const* t);
+
+/*
+ * Hold a table for writing, keeping other threads out of the table
+ * over several modifications. Locks nest within a thread, so loads
+ * that put many cells run faster while holding it.
+ * - t the table to lock
+ */
+void ledger_table_write_lock(struct ledger_table const* t);
+
+/*
+ * Release a table held for writing.
+ * - t the table to unlock
+ */
+void ledger_table_write_unlock(struct ledger_table const* t);
+
+/*
+ * Copy a table, rows and all. The copy uses the same storage backend.
+ * - t the table to copy
+ * @return the new table on success, otherwise NULL
+ */
+struct ledger_table* ledger_table_copy(struct ledger_table const* t);
+
+/*
+ * Acquire a table for another owner, such as a book snapshot.
+ * An owner must call `ledger_table_own` before changing a table.
+ * - t the table to share
+ * @return the table on success, otherwise NULL
+ */
+struct ledger_table* ledger_table_share(struct ledger_table* t);
+
+/*
+ * Release a table held by one of its owners.
+ * - t the table to release
+ */
+void ledger_table_drop_share(struct ledger_table* t);
+
+/*
+ * Prepare a table for changes by one of its owners. A table that
+ * other owners still share is copied, and the copy replaces the
+ * owner's hold on the original.
+ * - t the table held by the owner
+ * @return the table itself if unshared, a private copy otherwise,
+ *   or NULL if the copy failed (the owner keeps the original)
+ */
+struct ledger_table* ledger_table_own(struct ledger_table* t);
+
 /*
  * Compare two tables for equality.
  * - a a table
@@ -64,6 +212,18 @@ void ledger_table_free(struct ledger_table* t);
 int ledger_table_is_equal
   (struct ledger_table const* a, struct ledger_table const* b);
 
+/*
+ * Get a 64-bit hash of a table's contents. The hash is kept up to
+ * date as the table changes, so tables with different fingerprints
+ * are known to differ without comparing cells. Equal fingerprints do
+ * not prove equal tables; the hash ignores the order of rows.
+ * - t table to query
+ * - fingerprint to receive the hash
+ * @return one on success, zero otherwise
+ */
+int ledger_table_get_fingerprint
+  (struct ledger_table const* t, unsigned long long int* fingerprint);
+
 /*
  * Get a mark pointing to the first row of a table.
  * - t table to modify
@@ -114,6 +274,23 @@ void ledger_table_mark_free(struct ledger_table_mark* m);
  */
 void ledger_table_mark_move(struct ledger_table_mark* m, int n);
 
+/*
+ * Move a mark to a row by its position in the table.
+ * - m mark to move
+ * - row_index zero-based position of the row, or the row count
+ *   to move the mark to the end of the table
+ * @return one on success, zero otherwise
+ */
+int ledger_table_mark_seek(struct ledger_table_mark* m, int row_index);
+
+/*
+ * Query the position of a mark's row in the table.
+ * - m mark to query
+ * @return the zero-based position of the row, the row count if the
+ *   mark is at the end of the table, or -1 if the row is unavailable
+ */
+int ledger_table_mark_get_index(struct ledger_table_mark const* m);
+
 /*
  * Query the number of table columns.
  * - t table to query
@@ -147,6 +324,327 @@ int ledger_table_set_column_types
  */
 int ledger_table_count_rows(struct ledger_table const* t);
 
+/*
+ * Add a secondary index to a table column. Identifier, array index,
+ * string and date columns can be indexed. The index follows every change
+ * to the table's rows, and is built at the first lookup. Indexes on
+ * columns that survive a change of column types are kept.
+ * - t table to modify
+ * - column column to index
+ * - kind LEDGER_TABLE_HASH_INDEX or LEDGER_TABLE_ORDERED_INDEX
+ * @return one on success, zero otherwise
+ */
+int ledger_table_add_column_index
+  (struct ledger_table* t, int column, int kind);
+
+/*
+ * Remove the secondary index from a table column.
+ * - t table to modify
+ * - column indexed column
+ * @return one if the column had an index, zero otherwise
+ */
+int ledger_table_drop_column_index(struct ledger_table* t, int column);
+
+/*
+ * Query the secondary index of a table column.
+ * - t table to query
+ * - column column to query
+ * @return the index kind, or zero if the column has no index
+ */
+int ledger_table_get_column_index(struct ledger_table const* t, int column);
+
+/*
+ * Find rows through a secondary column index. Bounds use the `id`
+ * member for identifier and array index columns, the `date` member for
+ * date columns, and the `text` member for string columns, where unset
+ * strings equal empty strings. Hash
+ * indexes only find rows equal to a value, given as two inclusive
+ * bounds of that value.
+ * - t table to query
+ * - column indexed column
+ * - low lower bound, or NULL for none
+ * - low_inclusive_tf nonzero to include rows equal to the lower bound
+ * - high upper bound, or NULL for none
+ * - high_inclusive_tf nonzero to include rows equal to the upper bound
+ * - positions array to receive the positions of matching rows in
+ *   ascending order, to be freed with `ledger_util_free`
+ * @return the number of matching rows, or -1 if the column has no
+ *   suitable index or on failure
+ */
+int ledger_table_find_in_column_index
+  ( struct ledger_table const* t, int column,
+    struct ledger_table_field const* low, int low_inclusive_tf,
+    struct ledger_table_field const* high, int high_inclusive_tf,
+    int** positions);
+
+/*
+ * Keep running aggregates of a numeric column: the sum, the least and
+ * greatest values, and the number of cells holding a value. The
+ * aggregates follow rows and cells as they change, so queries need
+ * not scan the table.
+ * - t table to modify
+ * - column identifier, array index or big number column
+ * @return one on success, zero otherwise
+ */
+int ledger_table_add_column_aggregate(struct ledger_table* t, int column);
+
+/*
+ * Stop keeping aggregates of a column.
+ * - t table to modify
+ * - column the column
+ * @return one if the column had aggregates, zero otherwise
+ */
+int ledger_table_drop_column_aggregate(struct ledger_table* t, int column);
+
+/*
+ * Check whether a column keeps aggregates.
+ * - t table to query
+ * - column the column
+ * @return one if the column keeps aggregates, zero otherwise
+ */
+int ledger_table_has_column_aggregate
+  (struct ledger_table const* t, int column);
+
+/*
+ * Read the aggregates of a column. Unset big numbers are left out of
+ * the count and extremes; the extremes of a column with no values
+ * read as zero.
+ * - t table to query
+ * - column the column
+ * - sum number to receive the sum, or NULL
+ * - min number to receive the least value, or NULL
+ * - max number to receive the greatest value, or NULL
+ * - count to receive the number of values, or NULL
+ * @return one on success, zero if the column keeps no aggregates
+ *   or on failure
+ */
+int ledger_table_fetch_column_aggregate
+  ( struct ledger_table const* t, int column, struct ledger_bignum* sum,
+    struct ledger_bignum* min, struct ledger_bignum* max, int* count);
+
+/*
+ * Keep prefix sums of a numeric column over rows ordered by a key
+ * column, for sums of all rows with keys up to a bound. Rows appended
+ * in key order join the sums without a rebuild.
+ * - t table to modify
+ * - column identifier, array index or big number column to sum
+ * - key_column identifier, array index or date column to order by
+ * @return one on success, zero otherwise
+ */
+int ledger_table_add_column_prefix
+  (struct ledger_table* t, int column, int key_column);
+
+/*
+ * Stop keeping prefix sums of a column.
+ * - t table to modify
+ * - column the summed column
+ * - key_column the key column
+ * @return one if the table kept those sums, zero otherwise
+ */
+int ledger_table_drop_column_prefix
+  (struct ledger_table* t, int column, int key_column);
+
+/*
+ * Sum a column over the rows with keys up to a bound, using prefix
+ * sums. Unset big numbers count as zero, and unset dates sort first.
+ * - t table to query
+ * - column the summed column
+ * - key_column the key column
+ * - key inclusive upper bound: an identifier, array index or packed date
+ * - sum number to receive the sum
+ * @return one on success, zero if the table keeps no such prefix sums
+ *   or on failure
+ */
+int ledger_table_fetch_column_prefix
+  ( struct ledger_table const* t, int column, int key_column,
+    long long int key, struct ledger_bignum* sum);
+
+/*
+ * Compute the aggregates of a numeric column in one pass over its
+ * cells, whether or not the column keeps aggregates. Columnar tables
+ * are read straight from the column's cell array. Unset big numbers
+ * count as zero in the sum, and are left out of the count and
+ * extremes; the extremes of a column with no values read as zero.
+ * - t table to query
+ * - column identifier, array index or big number column
+ * - bits rows to include, one bit per row position with the least
+ *   significant bit first (see `ledger_table_filter_column`),
+ *   or NULL for every row
+ * - sum number to receive the sum, or NULL
+ * - min number to receive the least value, or NULL
+ * - max number to receive the greatest value, or NULL
+ * - count to receive the number of values, or NULL
+ * @return one on success, zero if the column is not numeric
+ *   or on failure
+ */
+int ledger_table_scan_column
+  ( struct ledger_table const* t, int column, unsigned char const* bits,
+    struct ledger_bignum* sum, struct ledger_bignum* min,
+    struct ledger_bignum* max, int* count);
+
+/*
+ * Mark the rows whose cells in a column lie between two bounds, in one
+ * pass over the column. Bounds use the `id` member for identifier and
+ * array index columns, the `date` member for date columns, and the
+ * `bignum` member for big number columns, where unset cells read as
+ * zero and unset dates as -1.
+ * - t table to query
+ * - column identifier, array index, big number or date column
+ * - low lower bound, or NULL for none
+ * - low_inclusive_tf nonzero to include rows equal to the lower bound
+ * - high upper bound, or NULL for none
+ * - high_inclusive_tf nonzero to include rows equal to the upper bound
+ * - bits bitmap of at least `(ledger_table_count_rows(t)+7)/8` bytes,
+ *   to receive one bit per row position, with the least significant
+ *   bit first; bits past the last row are cleared
+ * @return the number of marked rows, or -1 if the column cannot be
+ *   filtered by those bounds or on failure
+ */
+int ledger_table_filter_column
+  ( struct ledger_table const* t, int column,
+    struct ledger_table_field const* low, int low_inclusive_tf,
+    struct ledger_table_field const* high, int high_inclusive_tf,
+    unsigned char* bits);
+
+/*
+ * Multiply every amount in a big number column by one exact ratio,
+ * as `ledger_bignum_multiply_ratio` would, in one pass over the
+ * column. Unset cells stay unset. Amounts are scaled in place, so
+ * only products too wide to keep inline allocate. Observers hear of
+ * a cell change in every row.
+ * - t table to modify
+ * - column big number column
+ * - numerator numerator of the ratio
+ * - denominator denominator of the ratio; must not be zero
+ * - point_place centesimal places of each product
+ * @return one on success, zero if the column does not hold big
+ *   numbers or on failure, in which case some amounts may already
+ *   be scaled
+ */
+int ledger_table_scale_column
+  ( struct ledger_table* t, int column,
+    struct ledger_bignum const* numerator,
+    struct ledger_bignum const* denominator, int point_place);
+
+/*
+ * Table observer callback. Observers run with the table locked, in the
+ * thread that changed it; they may read the table, but must not change
+ * it.
+ * - arg the argument given at registration
+ * - event the change, from `enum ledger_table_event`
+ * - mark read-only mark at the row that changed, or NULL for schema resets
+ * - row position of the row that changed, or -1 for schema resets
+ * - column the column of a put cell, or -1 for other events
+ */
+typedef void (*ledger_table_observer_cb)
+  ( void* arg, int event, struct ledger_table_mark const* mark,
+    int row, int column);
+
+/*
+ * Register a callback for changes to a table. Copies made with
+ * `ledger_table_copy` do not inherit its observers. A table shared
+ * with a snapshot keeps them through the private copy that replaces
+ * it, so the observers then hear of changes on either side.
+ * - t table to observe
+ * - cb callback
+ * - arg callback argument, owned by the caller
+ * @return one on success, zero otherwise
+ */
+int ledger_table_add_observer
+  (struct ledger_table* t, ledger_table_observer_cb cb, void* arg);
+
+/*
+ * Remove a callback registered with `ledger_table_add_observer`.
+ * Observers may remove themselves or each other during a change.
+ * - t table to stop observing
+ * - cb callback
+ * - arg callback argument
+ * @return one if the observer was found, zero otherwise
+ */
+int ledger_table_drop_observer
+  (struct ledger_table* t, ledger_table_observer_cb cb, void* arg);
+
+/*
+ * Construct a new string pool. A pool keeps one copy of each distinct
+ * long string put to the tables using it.
+ * @return the pool on success, NULL otherwise
+ */
+struct ledger_table_pool* ledger_table_pool_new(void);
+
+/*
+ * Acquire a reference to a string pool.
+ * - p the pool to acquire
+ * @return the pool
+ */
+struct ledger_table_pool* ledger_table_pool_acquire
+  (struct ledger_table_pool* p);
+
+/*
+ * Release a reference to a string pool. Strings still held by
+ * tables keep the pool alive.
+ * - p the pool to release
+ */
+void ledger_table_pool_free(struct ledger_table_pool* p);
+
+/*
+ * Count the distinct strings in a pool.
+ * - p the pool to query
+ * @return the number of strings
+ */
+int ledger_table_pool_count(struct ledger_table_pool const* p);
+
+/*
+ * Set the string pool of a table. Strings too long to keep inline
+ * are put to the pool from now on; strings already in the table stay
+ * where they are. Copies of the table share its pool.
+ * - t the table to modify
+ * - p the pool to use, or NULL to stop pooling
+ */
+void ledger_table_set_pool
+  (struct ledger_table* t, struct ledger_table_pool* p);
+
+/*
+ * Get the string pool of a table.
+ * - t the table to query
+ * @return the pool, or NULL if the table does not pool its strings
+ */
+struct ledger_table_pool* ledger_table_get_pool(struct ledger_table const* t);
+
+/*
+ * Turn tombstone drops on or off. With tombstones, a row dropped from a
+ * columnar table leaves the table at once, but its slot in the column
+ * arrays stays behind until the next vacuum, and marks still on the
+ * row stay there. Linked tables unlink dropped rows at once anyway, so
+ * for them tombstones only put off reindexing.
+ * - t the table to modify
+ * - tf nonzero to leave tombstones, zero to remove rows at once
+ */
+void ledger_table_set_tombstones(struct ledger_table* t, int tf);
+
+/*
+ * Check whether a table leaves tombstones for dropped rows.
+ * - t the table to query
+ * @return one if drops leave tombstones, zero otherwise
+ */
+int ledger_table_get_tombstones(struct ledger_table const* t);
+
+/*
+ * Count the tombstones waiting for a vacuum.
+ * - t the table to query
+ * @return the number of tombstones
+ */
+int ledger_table_count_tombstones(struct ledger_table const* t);
+
+/*
+ * Compact a table in one pass. Live rows move over the tombstones,
+ * marks on tombstones move to the previous row, and the strings of
+ * a columnar table move into fresh storage in row order. Row
+ * positions stay the same.
+ * - t the table to compact
+ * @return one on success, zero otherwise
+ */
+int ledger_table_vacuum(struct ledger_table* t);
+
 /*
  * Add a row just before the mark's current position.
  * The mark will then point to the new row.
@@ -176,7 +674,8 @@ int ledger_table_fetch_string
   (struct ledger_table_mark const* mark, int i, unsigned char* buf, int len);
 
 /*
- * Put a string value to a row item.
+ * Put a string value to a row item. Date items parse the string,
+ * and keep text that is not a date as is, ordered before every date.
  * - mark any mark
  * - i column index
  * - value NUL-terminated string
@@ -206,6 +705,19 @@ int ledger_table_put_bignum
   ( struct ledger_table_mark const* mark, int i,
     struct ledger_bignum const* value);
 
+/*
+ * Fetch a row item as a fixed-point number, without allocating.
+ * - mark any mark
+ * - i column index
+ * - value integer to hold the number, in units of 100^(-point_place)
+ * - point_place integer to hold the number of centesimal places
+ * @return one on success, zero if the item is unavailable or
+ *   does not fit in a fixed-point number
+ */
+int ledger_table_fetch_fixed
+  ( struct ledger_table_mark const* mark, int i,
+    long long int* value, int* point_place);
+
 /*
  * Fetch a row item as an identifier.
  * - mark any mark
@@ -226,6 +738,67 @@ int ledger_table_fetch_id
 int ledger_table_put_id
   ( struct ledger_table_mark const* mark, int i, int value);
 
+/*
+ * Fetch a row item as a packed date. String items are parsed.
+ * Date items that hold text kept by `ledger_util_date_keep_text`
+ * give the value below -1 that stands for the text.
+ * - mark any mark
+ * - i column index
+ * - value place to store the packed date, or -1 if unset
+ * @return one on success, zero otherwise
+ */
+int ledger_table_fetch_date
+  (struct ledger_table_mark const* mark, int i, long long int* value);
+
+/*
+ * Put a packed date to a row item. String items receive the
+ * formatted date.
+ * - mark any mark
+ * - i column index
+ * - value packed date, a value standing for kept text, or
+ *   negative to unset
+ * @return one on success, zero otherwise
+ */
+int ledger_table_put_date
+  ( struct ledger_table_mark const* mark, int i, long long int value);
+
+/*
+ * Fetch several items from a row at once.
+ * - mark any mark
+ * - n number of fields
+ * - fields fields describing the items to fetch and receiving
+ *     the values
+ * @return one on success, zero otherwise
+ */
+int ledger_table_fetch_row
+  ( struct ledger_table_mark const* mark, int n,
+    struct ledger_table_field* fields);
+
+/*
+ * Put several items to a row at once.
+ * - mark a mutable mark
+ * - n number of fields
+ * - fields fields describing the items and values to put
+ * @return one on success, zero otherwise
+ */
+int ledger_table_put_row
+  ( struct ledger_table_mark const* mark, int n,
+    struct ledger_table_field const* fields);
+
+/*
+ * Add several rows just before the mark's current position.
+ * The mark keeps pointing to the same row, after the new rows.
+ * On failure, the table is left unchanged.
+ * - mark a mutable mark
+ * - rows number of rows to add
+ * - n number of fields per row
+ * - fields array of `rows*n` fields, one group of `n` fields per row
+ * @return one on success, zero otherwise
+ */
+int ledger_table_append_rows
+  ( struct ledger_table_mark* mark, int rows, int n,
+    struct ledger_table_field const* fields);
+
 /*
  * Get the column type for the row referenced by a mark.
  * - mark the mark to query
@@ -250,6 +823,55 @@ int ledger_table_mark_is_valid(struct ledger_table_mark const* mark);
 struct ledger_table_mark* ledger_table_mark_acquire
   (struct ledger_table_mark* mark);
 
+/*
+ * Point a cursor to the first row of a table.
+ * - c the cursor to set
+ * - t table to read
+ */
+void ledger_table_cursor_begin
+  (struct ledger_table_cursor* c, struct ledger_table const* t);
+
+/*
+ * Point a cursor to after the last row of a table.
+ * - c the cursor to set
+ * - t table to read
+ */
+void ledger_table_cursor_end
+  (struct ledger_table_cursor* c, struct ledger_table const* t);
+
+/*
+ * Check whether a cursor points to after the last row of its table.
+ * - c the cursor to query
+ * @return one if the cursor is at the end, zero otherwise
+ */
+int ledger_table_cursor_is_end(struct ledger_table_cursor const* c);
+
+/*
+ * Move a cursor forward `n` rows.
+ * - c cursor to move forward
+ * - n number of steps to move (can be negative)
+ */
+void ledger_table_cursor_move(struct ledger_table_cursor* c, int n);
+
+/*
+ * Move a cursor to a row given by its position.
+ * - c cursor to move
+ * - row_index the row's position, or the row count for the end
+ *   of the table
+ * @return one on success, zero otherwise
+ */
+int ledger_table_cursor_seek(struct ledger_table_cursor* c, int row_index);
+
+/*
+ * Get a constant mark view of a cursor, for use with the row
+ *   fetch functions. The view cannot be acquired, and it follows
+ *   the cursor as the cursor moves.
+ * - c the cursor to view
+ * @return a constant mark
+ */
+struct ledger_table_mark const* ledger_table_cursor_mark
+  (struct ledger_table_cursor const* c);
+
 #ifdef __cplusplus
 };
 #endif /*__cplusplus*/
@@ -3,12 +3,685 @@
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <assert.h>
 #include "../../deps/refalloc/refalloc.h"
+#if defined(LEDGER_UTIL_NO_THREADS)
+   /* locks do nothing */
+#elif defined(_WIN32)
+#  include <windows.h>
+#else
+#  include <pthread.h>
+#endif /*LEDGER_UTIL_NO_THREADS*/
+
+/*
+ * default arena chunk size
+ */
+#ifndef LEDGER_UTIL_ARENA_CHUNK
+#  define LEDGER_UTIL_ARENA_CHUNK 16384
+#endif /*LEDGER_UTIL_ARENA_CHUNK*/
+
+/*
+ * number of locks each thread can track before its hold table
+ *   moves to the heap
+ */
+#ifndef LEDGER_UTIL_LOCK_HOLD_MAX
+#  define LEDGER_UTIL_LOCK_HOLD_MAX 32
+#endif /*LEDGER_UTIL_LOCK_HOLD_MAX*/
+
+/*
+ * lock state bits: a thread holds the lock exclusive
+ */
+#define LEDGER_UTIL_LOCK_WRITER 0x40000000u
+
+/*
+ * lock state bits: threads wait on the condition, so releases
+ *   must wake them
+ */
+#define LEDGER_UTIL_LOCK_WAITERS 0x80000000u
+
+/*
+ * lock state bits: number of threads holding the lock shared
+ */
+#define LEDGER_UTIL_LOCK_READERS 0x3FFFFFFFu
+
+/*
+ * storage class for per-thread lock records
+ */
+#if defined(LEDGER_UTIL_NO_THREADS)
+#  define LEDGER_UTIL_THREAD_LOCAL
+#elif defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L)
+#  define LEDGER_UTIL_THREAD_LOCAL _Thread_local
+#elif defined(_MSC_VER)
+#  define LEDGER_UTIL_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__)
+#  define LEDGER_UTIL_THREAD_LOCAL __thread
+#else
+#  error "no thread-local storage; define LEDGER_UTIL_NO_THREADS"
+#endif /*LEDGER_UTIL_NO_THREADS*/
+
+/*
+ * Alignment helper for arena blocks
+ */
+union ledger_util_arena_align {
+  long int l;
+  double d;
+  void* p;
+  void (*f)(void);
+};
+
+/*
+ * Single bulk allocation owned by an arena
+ */
+struct ledger_util_arena_chunk {
+  /* next older chunk */
+  struct ledger_util_arena_chunk* next;
+  /* number of bytes available in `data` */
+  size_t size;
+  /* number of bytes already handed out */
+  size_t used;
+  /* block storage (C99 feature) */
+  union ledger_util_arena_align data[];
+};
+
+/*
+ * Actualization of the arena structure
+ */
+struct ledger_util_arena {
+  /* newest chunk first */
+  struct ledger_util_arena_chunk* chunks;
+  /* preferred chunk size */
+  size_t chunk_size;
+};
+
+/*
+ * Actualization of the lock structure
+ */
+struct ledger_util_lock {
+#if defined(LEDGER_UTIL_NO_THREADS)
+  /* nothing to guard */
+#elif defined(_WIN32)
+  CRITICAL_SECTION mutex;
+  CONDITION_VARIABLE cond;
+#else
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+#endif /*LEDGER_UTIL_NO_THREADS*/
+  /* whether the mutex and condition are initialized */
+  int ready_tf;
+  /* number of threads holding the lock shared, with the writer and
+   *   waiter bits; changed only by `ledger_util_lock_swap` and
+   *   `ledger_util_lock_add` */
+  unsigned int state;
+  /* number of threads waiting to hold the lock exclusive */
+  int writers_waiting;
+  /* number of threads waiting on the condition */
+  int waiting;
+};
+
+/*
+ * Record of a lock held by the current thread
+ */
+struct ledger_util_lock_hold {
+  struct ledger_util_lock* lock;
+  /* number of times the thread took the lock */
+  int depth;
+  /* whether the thread holds the lock exclusive */
+  int exclusive_tf;
+};
+
+/*
+ * number of allocations made by this library in the current thread
+ */
+static LEDGER_UTIL_THREAD_LOCAL size_t ledger_util_allocation_count = 0;
+
+/*
+ * locks held by the current thread, while they fit
+ */
+static LEDGER_UTIL_THREAD_LOCAL struct ledger_util_lock_hold
+  ledger_util_lock_hold_base[LEDGER_UTIL_LOCK_HOLD_MAX];
+
+/*
+ * locks held by the current thread, or NULL for the base table
+ */
+static LEDGER_UTIL_THREAD_LOCAL struct ledger_util_lock_hold*
+  ledger_util_lock_holds = NULL;
+
+/*
+ * number of records the current thread's hold table can take
+ */
+static LEDGER_UTIL_THREAD_LOCAL int ledger_util_lock_hold_capacity =
+  LEDGER_UTIL_LOCK_HOLD_MAX;
+
+/*
+ * number of locks held by the current thread
+ */
+static LEDGER_UTIL_THREAD_LOCAL int ledger_util_lock_hold_count = 0;
+
+/*
+ * guard for owner counts of shared objects, and for change stamps
+ *   and lock states where the compiler offers no atomic operations
+ */
+#if defined(LEDGER_UTIL_NO_THREADS)
+  /* nothing to guard */
+#elif defined(_WIN32)
+static SRWLOCK ledger_util_share_guard = SRWLOCK_INIT;
+#else
+static pthread_mutex_t ledger_util_share_guard = PTHREAD_MUTEX_INITIALIZER;
+#endif /*LEDGER_UTIL_NO_THREADS*/
+
+/*
+ * Text kept in place of a date
+ */
+struct ledger_util_date_text {
+  /* next text in the same bucket */
+  struct ledger_util_date_text* next;
+  /* hash of the text */
+  unsigned int hash;
+  /* position in the array of kept texts */
+  int index;
+  /* the text */
+  unsigned char* text;
+};
+
+/*
+ * guard for the kept date texts
+ */
+#if defined(LEDGER_UTIL_NO_THREADS)
+  /* nothing to guard */
+#elif defined(_WIN32)
+static SRWLOCK ledger_util_date_guard = SRWLOCK_INIT;
+#else
+static pthread_mutex_t ledger_util_date_guard = PTHREAD_MUTEX_INITIALIZER;
+#endif /*LEDGER_UTIL_NO_THREADS*/
+
+/*
+ * kept date texts in the order kept; text `k` stands for the
+ *   value `-2-k`
+ */
+static struct ledger_util_date_text** ledger_util_date_texts = NULL;
+
+/*
+ * hash buckets of kept date texts, as many as the array has room
+ */
+static struct ledger_util_date_text** ledger_util_date_buckets = NULL;
+
+/*
+ * number of kept date texts
+ */
+static int ledger_util_date_text_count = 0;
+
+/*
+ * room in the array of kept date texts, a power of two
+ */
+static int ledger_util_date_text_capacity = 0;
+
+/*
+ * Make room for more kept date texts, with the guard held.
+ * @return one on success, zero otherwise
+ */
+static int ledger_util_date_text_grow(void);
+
+/*
+ * Allocate a new chunk for an arena.
+ * - siz minimum number of bytes the chunk must hold
+ * @return the chunk on success, otherwise NULL
+ */
+static struct ledger_util_arena_chunk* ledger_util_arena_chunk_new
+  (size_t siz);
+
+/*
+ * Callback for cleaning up a lock.
+ * - ptr pointer to a lock
+ */
+static void ledger_util_lock_free_cb(void* ptr);
+
+/*
+ * Get the current thread's hold table.
+ * @return the first record of the table
+ */
+static struct ledger_util_lock_hold* ledger_util_lock_hold_table(void);
+
+/*
+ * Make room in the current thread's hold table for one more record.
+ * Aborts if the table cannot grow, as an untracked lock would later
+ * deadlock its own thread.
+ */
+static void ledger_util_lock_reserve(void);
+
+/*
+ * Find the current thread's record for a lock.
+ * - l the lock to look up
+ * @return the record, or NULL if the thread does not hold the lock
+ */
+static struct ledger_util_lock_hold* ledger_util_lock_find
+  (struct ledger_util_lock const* l);
+
+/*
+ * Record that the current thread took a lock. The table must have
+ * room for the record already.
+ * - l the lock taken
+ * - exclusive_tf whether the thread took the lock exclusive
+ */
+static void ledger_util_lock_track
+  (struct ledger_util_lock* l, int exclusive_tf);
+
+/*
+ * Forget a lock record of the current thread.
+ * - hold the record to remove
+ */
+static void ledger_util_lock_untrack(struct ledger_util_lock_hold* hold);
+
+/*
+ * Release one hold of a lock by the current thread, in the mode
+ * the thread first took it.
+ * - l the lock to release
+ */
+static void ledger_util_lock_release(struct ledger_util_lock* l);
+
+/*
+ * Enter the guard of a lock's counters.
+ * - l the lock to guard
+ */
+static void ledger_util_lock_enter(struct ledger_util_lock* l);
+
+/*
+ * Leave the guard of a lock's counters.
+ * - l the guarded lock
+ */
+static void ledger_util_lock_leave(struct ledger_util_lock* l);
+
+/*
+ * Wait on a lock's condition, leaving the guard in the meantime.
+ * - l the guarded lock
+ */
+static void ledger_util_lock_wait(struct ledger_util_lock* l);
+
+/*
+ * Wake all threads waiting on a lock's condition.
+ * - l the guarded lock
+ */
+static void ledger_util_lock_wake(struct ledger_util_lock* l);
+
+/*
+ * Read the state of a lock.
+ * - l the lock to query
+ * @return the reader count with the writer and waiter bits
+ */
+static unsigned int ledger_util_lock_state(struct ledger_util_lock* l);
+
+/*
+ * Replace the state of a lock, if no other thread changed it first.
+ * - l the lock to change
+ * - expected the state last read
+ * - desired the new state
+ * @return one if the state changed, zero otherwise
+ */
+static int ledger_util_lock_swap
+  (struct ledger_util_lock* l, unsigned int expected, unsigned int desired);
+
+/*
+ * Add to the state of a lock.
+ * - l the lock to change
+ * - n amount to add, wrapping around
+ * @return the state before the change
+ */
+static unsigned int ledger_util_lock_add
+  (struct ledger_util_lock* l, unsigned int n);
+
+/*
+ * Give back one count of a lock's state, waking any waiters once
+ * no thread holds the lock.
+ * - l the lock to change
+ * - n the writer bit, or one for a reader
+ */
+static void ledger_util_lock_drop(struct ledger_util_lock* l, unsigned int n);
+
+/*
+ * Take a lock shared the slow way, waiting on its condition.
+ * - l the lock to hold
+ */
+static void ledger_util_lock_shared_wait(struct ledger_util_lock* l);
+
+/*
+ * Take a lock exclusive the slow way, waiting on its condition.
+ * - l the lock to hold
+ */
+static void ledger_util_lock_exclusive_wait(struct ledger_util_lock* l);
+
+/*
+ * Stop waiting on a lock, with the guard held. The last waiter
+ * out clears the waiter bit, so releases stop taking the guard.
+ * - l the guarded lock
+ */
+static void ledger_util_lock_unwait(struct ledger_util_lock* l);
+
+/* BEGIN static implementation */
+
+struct ledger_util_arena_chunk* ledger_util_arena_chunk_new(size_t siz){
+  struct ledger_util_arena_chunk* chunk;
+  if (siz > ((~(size_t)0) - sizeof(struct ledger_util_arena_chunk)))
+    return NULL;
+  chunk = (struct ledger_util_arena_chunk*)ledger_util_malloc
+    (sizeof(struct ledger_util_arena_chunk) + siz);
+  if (chunk != NULL){
+    chunk->next = NULL;
+    chunk->size = siz;
+    chunk->used = 0;
+  }
+  return chunk;
+}
+
+void ledger_util_lock_free_cb(void* ptr){
+  struct ledger_util_lock* const l = (struct ledger_util_lock*)ptr;
+  if (l->ready_tf){
+#if defined(LEDGER_UTIL_NO_THREADS)
+    /* nothing to release */;
+#elif defined(_WIN32)
+    DeleteCriticalSection(&l->mutex);
+#else
+    pthread_cond_destroy(&l->cond);
+    pthread_mutex_destroy(&l->mutex);
+#endif /*LEDGER_UTIL_NO_THREADS*/
+    l->ready_tf = 0;
+  }
+  return;
+}
+
+struct ledger_util_lock_hold* ledger_util_lock_hold_table(void){
+  return (ledger_util_lock_holds != NULL)
+    ? ledger_util_lock_holds : ledger_util_lock_hold_base;
+}
+
+void ledger_util_lock_reserve(void){
+  struct ledger_util_lock_hold* new_holds;
+  int new_capacity;
+  if (ledger_util_lock_hold_count < ledger_util_lock_hold_capacity)
+    return;
+  if (ledger_util_lock_hold_capacity
+      > INT_MAX/2/(int)sizeof(struct ledger_util_lock_hold))
+    abort();
+  new_capacity = ledger_util_lock_hold_capacity*2;
+  /* NOTE bookkeeping, so not counted as a library allocation */
+  new_holds = (struct ledger_util_lock_hold*)malloc
+    (new_capacity*sizeof(struct ledger_util_lock_hold));
+  if (new_holds == NULL)
+    abort();
+  memcpy(new_holds, ledger_util_lock_hold_table(),
+    ledger_util_lock_hold_count*sizeof(struct ledger_util_lock_hold));
+  free(ledger_util_lock_holds);
+  ledger_util_lock_holds = new_holds;
+  ledger_util_lock_hold_capacity = new_capacity;
+  return;
+}
+
+struct ledger_util_lock_hold* ledger_util_lock_find
+  (struct ledger_util_lock const* l)
+{
+  int i;
+  struct ledger_util_lock_hold* const holds = ledger_util_lock_hold_table();
+  for (i = 0; i < ledger_util_lock_hold_count; ++i){
+    if (holds[i].lock == l)
+      return holds+i;
+  }
+  return NULL;
+}
+
+void ledger_util_lock_track(struct ledger_util_lock* l, int exclusive_tf){
+  struct ledger_util_lock_hold* const hold =
+    ledger_util_lock_hold_table()+ledger_util_lock_hold_count;
+  hold->lock = l;
+  hold->depth = 1;
+  hold->exclusive_tf = exclusive_tf;
+  ledger_util_lock_hold_count += 1;
+  return;
+}
+
+void ledger_util_lock_untrack(struct ledger_util_lock_hold* hold){
+  ledger_util_lock_hold_count -= 1;
+  *hold = ledger_util_lock_hold_table()[ledger_util_lock_hold_count];
+  /* give back a grown table once every lock is released */
+  if (ledger_util_lock_hold_count == 0 && ledger_util_lock_holds != NULL){
+    free(ledger_util_lock_holds);
+    ledger_util_lock_holds = NULL;
+    ledger_util_lock_hold_capacity = LEDGER_UTIL_LOCK_HOLD_MAX;
+  }
+  return;
+}
+
+void ledger_util_lock_release(struct ledger_util_lock* l){
+  int exclusive_tf;
+  struct ledger_util_lock_hold* const hold = ledger_util_lock_find(l);
+  assert(hold != NULL && "ledger_util_lock_release: lock not held");
+  if (hold == NULL)
+    return;
+  else if (hold->depth > 1){
+    hold->depth -= 1;
+    return;
+  }
+  exclusive_tf = hold->exclusive_tf;
+  ledger_util_lock_untrack(hold);
+  ledger_util_lock_drop(l, exclusive_tf ? LEDGER_UTIL_LOCK_WRITER : 1u);
+  return;
+}
+
+void ledger_util_lock_enter(struct ledger_util_lock* l){
+#if defined(LEDGER_UTIL_NO_THREADS)
+  (void)l;
+#elif defined(_WIN32)
+  EnterCriticalSection(&l->mutex);
+#else
+  pthread_mutex_lock(&l->mutex);
+#endif /*LEDGER_UTIL_NO_THREADS*/
+  return;
+}
+
+void ledger_util_lock_leave(struct ledger_util_lock* l){
+#if defined(LEDGER_UTIL_NO_THREADS)
+  (void)l;
+#elif defined(_WIN32)
+  LeaveCriticalSection(&l->mutex);
+#else
+  pthread_mutex_unlock(&l->mutex);
+#endif /*LEDGER_UTIL_NO_THREADS*/
+  return;
+}
+
+void ledger_util_lock_wait(struct ledger_util_lock* l){
+#if defined(LEDGER_UTIL_NO_THREADS)
+  (void)l;
+#elif defined(_WIN32)
+  SleepConditionVariableCS(&l->cond, &l->mutex, INFINITE);
+#else
+  pthread_cond_wait(&l->cond, &l->mutex);
+#endif /*LEDGER_UTIL_NO_THREADS*/
+  return;
+}
+
+void ledger_util_lock_wake(struct ledger_util_lock* l){
+#if defined(LEDGER_UTIL_NO_THREADS)
+  (void)l;
+#elif defined(_WIN32)
+  WakeAllConditionVariable(&l->cond);
+#else
+  pthread_cond_broadcast(&l->cond);
+#endif /*LEDGER_UTIL_NO_THREADS*/
+  return;
+}
+
+unsigned int ledger_util_lock_state(struct ledger_util_lock* l){
+#if defined(LEDGER_UTIL_NO_THREADS)
+  return l->state;
+#elif defined(_WIN32)
+  return (unsigned int)InterlockedCompareExchange
+    ((LONG volatile*)&l->state, 0, 0);
+#elif defined(__GNUC__)
+  return __atomic_load_n(&l->state, __ATOMIC_ACQUIRE);
+#else
+  unsigned int state;
+  pthread_mutex_lock(&ledger_util_share_guard);
+  state = l->state;
+  pthread_mutex_unlock(&ledger_util_share_guard);
+  return state;
+#endif /*LEDGER_UTIL_NO_THREADS*/
+}
+
+int ledger_util_lock_swap
+  (struct ledger_util_lock* l, unsigned int expected, unsigned int desired)
+{
+#if defined(LEDGER_UTIL_NO_THREADS)
+  if (l->state != expected) return 0;
+  l->state = desired;
+  return 1;
+#elif defined(_WIN32)
+  return (unsigned int)InterlockedCompareExchange
+    ((LONG volatile*)&l->state, (LONG)desired, (LONG)expected) == expected;
+#elif defined(__GNUC__)
+  return __atomic_compare_exchange_n(&l->state, &expected, desired, 0,
+    __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST) ? 1 : 0;
+#else
+  int result = 0;
+  pthread_mutex_lock(&ledger_util_share_guard);
+  if (l->state == expected){
+    l->state = desired;
+    result = 1;
+  }
+  pthread_mutex_unlock(&ledger_util_share_guard);
+  return result;
+#endif /*LEDGER_UTIL_NO_THREADS*/
+}
+
+unsigned int ledger_util_lock_add
+  (struct ledger_util_lock* l, unsigned int n)
+{
+#if defined(LEDGER_UTIL_NO_THREADS)
+  unsigned int const state = l->state;
+  l->state += n;
+  return state;
+#elif defined(_WIN32)
+  return (unsigned int)InterlockedExchangeAdd
+    ((LONG volatile*)&l->state, (LONG)n);
+#elif defined(__GNUC__)
+  return __atomic_fetch_add(&l->state, n, __ATOMIC_SEQ_CST);
+#else
+  unsigned int state;
+  pthread_mutex_lock(&ledger_util_share_guard);
+  state = l->state;
+  l->state += n;
+  pthread_mutex_unlock(&ledger_util_share_guard);
+  return state;
+#endif /*LEDGER_UTIL_NO_THREADS*/
+}
+
+void ledger_util_lock_drop(struct ledger_util_lock* l, unsigned int n){
+  unsigned int const state = ledger_util_lock_add(l, 0u-n);
+  /* uncontended: leave the guard alone */
+  if ((state & LEDGER_UTIL_LOCK_WAITERS)
+  &&  ((state-n) & (LEDGER_UTIL_LOCK_READERS|LEDGER_UTIL_LOCK_WRITER)) == 0)
+  {
+    ledger_util_lock_enter(l);
+    ledger_util_lock_wake(l);
+    ledger_util_lock_leave(l);
+  }
+  return;
+}
+
+void ledger_util_lock_shared_wait(struct ledger_util_lock* l){
+  ledger_util_lock_enter(l);
+  l->waiting += 1;
+  for (;;){
+    unsigned int const state = ledger_util_lock_state(l);
+    /* let waiting writers go first, unless this thread holds other locks
+     * that a writer might be waiting on */
+    if ((state & LEDGER_UTIL_LOCK_WRITER) == 0
+    &&  (l->writers_waiting == 0 || ledger_util_lock_hold_count > 0))
+    {
+      if (ledger_util_lock_swap(l, state, state+1))
+        break;
+    } else if ((state & LEDGER_UTIL_LOCK_WAITERS) == 0){
+      /* ask for a wake-up, then look again */
+      ledger_util_lock_swap(l, state, state|LEDGER_UTIL_LOCK_WAITERS);
+    } else ledger_util_lock_wait(l);
+  }
+  ledger_util_lock_unwait(l);
+  ledger_util_lock_leave(l);
+  return;
+}
+
+void ledger_util_lock_exclusive_wait(struct ledger_util_lock* l){
+  ledger_util_lock_enter(l);
+  l->waiting += 1;
+  l->writers_waiting += 1;
+  for (;;){
+    unsigned int const state = ledger_util_lock_state(l);
+    if ((state & ~LEDGER_UTIL_LOCK_WAITERS) == 0){
+      if (ledger_util_lock_swap(l, state, state|LEDGER_UTIL_LOCK_WRITER))
+        break;
+    } else if ((state & LEDGER_UTIL_LOCK_WAITERS) == 0){
+      /* ask for a wake-up, then look again */
+      ledger_util_lock_swap(l, state, state|LEDGER_UTIL_LOCK_WAITERS);
+    } else ledger_util_lock_wait(l);
+  }
+  l->writers_waiting -= 1;
+  ledger_util_lock_unwait(l);
+  ledger_util_lock_leave(l);
+  return;
+}
+
+void ledger_util_lock_unwait(struct ledger_util_lock* l){
+  l->waiting -= 1;
+  if (l->waiting == 0){
+    unsigned int state;
+    do {
+      state = ledger_util_lock_state(l);
+    } while (!ledger_util_lock_swap
+        (l, state, state & ~LEDGER_UTIL_LOCK_WAITERS));
+  }
+  return;
+}
+
+int ledger_util_date_text_grow(void){
+  int const new_capacity = (ledger_util_date_text_capacity > 0)
+    ? ledger_util_date_text_capacity*2 : 16;
+  struct ledger_util_date_text** new_texts;
+  struct ledger_util_date_text** new_buckets;
+  int i;
+  if (ledger_util_date_text_capacity
+      > INT_MAX/(4*(int)sizeof(struct ledger_util_date_text*)))
+    return 0;
+  new_texts = (struct ledger_util_date_text**)ledger_util_malloc
+    (new_capacity*sizeof(struct ledger_util_date_text*));
+  new_buckets = (struct ledger_util_date_text**)ledger_util_malloc
+    (new_capacity*sizeof(struct ledger_util_date_text*));
+  if (new_texts == NULL || new_buckets == NULL){
+    ledger_util_free(new_texts);
+    ledger_util_free(new_buckets);
+    return 0;
+  }
+  for (i = 0; i < new_capacity; ++i){
+    new_buckets[i] = NULL;
+  }
+  for (i = 0; i < ledger_util_date_text_count; ++i){
+    struct ledger_util_date_text* const entry = ledger_util_date_texts[i];
+    unsigned int const j = entry->hash&(unsigned int)(new_capacity-1);
+    new_texts[i] = entry;
+    entry->next = new_buckets[j];
+    new_buckets[j] = entry;
+  }
+  ledger_util_free(ledger_util_date_texts);
+  ledger_util_free(ledger_util_date_buckets);
+  ledger_util_date_texts = new_texts;
+  ledger_util_date_buckets = new_buckets;
+  ledger_util_date_text_capacity = new_capacity;
+  return 1;
+}
+
+/* END   static implementation */
 
 /* BEGIN implementation */
 
 void* ledger_util_malloc(size_t siz){
   if (siz == 0) return NULL;
+  ledger_util_allocation_count += 1;
   return malloc(siz);
 }
 
@@ -19,6 +692,7 @@ void ledger_util_free(void* ptr){
 
 void* ledger_util_ref_malloc(size_t siz, ledger_util_ref_dtor dtor){
   if (siz == 0) return NULL;
+  ledger_util_allocation_count += 1;
   return refalloc_malloc(siz, dtor);
 }
 
@@ -151,6 +825,190 @@ int ledger_util_atoi(unsigned char const* str){
   return atoi((char const*)str);
 }
 
+int ledger_util_date_from_text(unsigned char const* str, long long int* value){
+  /* fields: year, month, day, hour, minute, second */
+  int fields[6] = {0,0,0,0,0,0};
+  static int const widths[6] = {4,2,2,2,2,2};
+  static unsigned char const separators[6] = {0,'-','-','T',':',':'};
+  int form = 0;
+  int field_i;
+  if (str == NULL) return 0;
+  for (field_i = 0; field_i < 6; ++field_i){
+    int digit_i;
+    if (field_i > 0){
+      if (*str == 0 && (field_i == 3 || field_i == 5))
+        /* shorter form */break;
+      else if (*str != separators[field_i])
+        return 0;
+      ++str;
+    }
+    for (digit_i = 0; digit_i < widths[field_i]; ++digit_i, ++str){
+      if (*str < '0' || *str > '9') return 0;
+      fields[field_i] = fields[field_i]*10 + (*str-'0');
+    }
+  }
+  /* form: 0 date only, 1 minutes, 2 seconds, 3 seconds in UTC */
+  if (field_i == 3) form = 0;
+  else if (field_i == 5) form = 1;
+  else if (*str == 'Z'){
+    form = 3;
+    ++str;
+  } else form = 2;
+  if (*str != 0) return 0;
+  /* check the ranges */{
+    static int const month_days[12] =
+      {31,29,31,30,31,30,31,31,30,31,30,31};
+    int const year = fields[0];
+    int const leap_tf = (year%4 == 0) && (year%100 != 0 || year%400 == 0);
+    if (fields[1] < 1 || fields[1] > 12) return 0;
+    if (fields[2] < 1 || fields[2] > month_days[fields[1]-1]) return 0;
+    if (fields[1] == 2 && fields[2] == 29 && !leap_tf) return 0;
+    if (fields[3] > 23 || fields[4] > 59 || fields[5] > 60) return 0;
+  }
+  /* pack, keeping the order of the text */
+  *value = ((((((long long int)fields[0]*16 + fields[1])*32 + fields[2])
+      *32 + fields[3])*64 + fields[4])*64 + fields[5])*4 + form;
+  return 1;
+}
+
+size_t ledger_util_date_to_text
+  (long long int value, unsigned char* buf, size_t siz)
+{
+  unsigned char text[24];
+  size_t len;
+  int const form = (int)(value%4);
+  int const second = (int)((value/4)%64);
+  int const minute = (int)((value/(4*64))%64);
+  int const hour = (int)((value/(4*64*64))%32);
+  int const day = (int)((value/(4*64*64*32))%32);
+  int const month = (int)((value/(4LL*64*64*32*32))%16);
+  long long int const year = value/(4LL*64*64*32*32*16);
+  if (value < 0 || year > 9999 || month < 1 || month > 12 || day < 1)
+    return 0;
+  text[0] = (unsigned char)('0'+year/1000);
+  text[1] = (unsigned char)('0'+(year/100)%10);
+  text[2] = (unsigned char)('0'+(year/10)%10);
+  text[3] = (unsigned char)('0'+year%10);
+  text[4] = '-';
+  text[5] = (unsigned char)('0'+month/10);
+  text[6] = (unsigned char)('0'+month%10);
+  text[7] = '-';
+  text[8] = (unsigned char)('0'+day/10);
+  text[9] = (unsigned char)('0'+day%10);
+  len = 10;
+  if (form >= 1){
+    text[10] = 'T';
+    text[11] = (unsigned char)('0'+hour/10);
+    text[12] = (unsigned char)('0'+hour%10);
+    text[13] = ':';
+    text[14] = (unsigned char)('0'+minute/10);
+    text[15] = (unsigned char)('0'+minute%10);
+    len = 16;
+  }
+  if (form >= 2){
+    text[16] = ':';
+    text[17] = (unsigned char)('0'+second/10);
+    text[18] = (unsigned char)('0'+second%10);
+    len = 19;
+  }
+  if (form == 3){
+    text[19] = 'Z';
+    len = 20;
+  }
+  if (siz > 0){
+    size_t const copy_len = (len < siz) ? len : siz-1;
+    memcpy(buf, text, copy_len);
+    buf[copy_len] = 0;
+  }
+  return len;
+}
+
+int ledger_util_date_keep_text
+  (unsigned char const* str, long long int* value)
+{
+  int result = 0;
+  unsigned int hash = 2166136261u;
+  unsigned char const* p;
+  if (str == NULL) return 0;
+  /* FNV-1a */
+  for (p = str; *p != 0; ++p){
+    hash = ((hash ^ *p)*16777619u)&0xFFFFFFFFu;
+  }
+#if defined(LEDGER_UTIL_NO_THREADS)
+  /* nothing to guard */
+#elif defined(_WIN32)
+  AcquireSRWLockExclusive(&ledger_util_date_guard);
+#else
+  pthread_mutex_lock(&ledger_util_date_guard);
+#endif /*LEDGER_UTIL_NO_THREADS*/
+  do {
+    struct ledger_util_date_text* entry = NULL;
+    unsigned int j;
+    if (ledger_util_date_text_capacity > 0){
+      j = hash&(unsigned int)(ledger_util_date_text_capacity-1);
+      for (entry = ledger_util_date_buckets[j];
+          entry != NULL; entry = entry->next)
+      {
+        if (entry->hash == hash && ledger_util_ustrcmp(entry->text, str) == 0)
+          break;
+      }
+    }
+    if (entry == NULL){
+      int ok;
+      if (ledger_util_date_text_count == ledger_util_date_text_capacity
+      &&  !ledger_util_date_text_grow())
+        break;
+      entry = (struct ledger_util_date_text*)ledger_util_malloc
+        (sizeof(struct ledger_util_date_text));
+      if (entry == NULL) break;
+      entry->text = ledger_util_ustrdup(str, &ok);
+      if (!ok){
+        ledger_util_free(entry);
+        break;
+      }
+      entry->hash = hash;
+      entry->index = ledger_util_date_text_count;
+      j = hash&(unsigned int)(ledger_util_date_text_capacity-1);
+      entry->next = ledger_util_date_buckets[j];
+      ledger_util_date_buckets[j] = entry;
+      ledger_util_date_texts[ledger_util_date_text_count] = entry;
+      ledger_util_date_text_count += 1;
+    }
+    *value = -2-(long long int)entry->index;
+    result = 1;
+  } while (0);
+#if defined(LEDGER_UTIL_NO_THREADS)
+  /* nothing to guard */
+#elif defined(_WIN32)
+  ReleaseSRWLockExclusive(&ledger_util_date_guard);
+#else
+  pthread_mutex_unlock(&ledger_util_date_guard);
+#endif /*LEDGER_UTIL_NO_THREADS*/
+  return result;
+}
+
+unsigned char const* ledger_util_date_kept_text(long long int value){
+  unsigned char const* text = NULL;
+  if (value >= -1 || value < -2-(long long int)INT_MAX) return NULL;
+#if defined(LEDGER_UTIL_NO_THREADS)
+  /* nothing to guard */
+#elif defined(_WIN32)
+  AcquireSRWLockExclusive(&ledger_util_date_guard);
+#else
+  pthread_mutex_lock(&ledger_util_date_guard);
+#endif /*LEDGER_UTIL_NO_THREADS*/
+  if (-2-value < (long long int)ledger_util_date_text_count)
+    text = ledger_util_date_texts[(int)(-2-value)]->text;
+#if defined(LEDGER_UTIL_NO_THREADS)
+  /* nothing to guard */
+#elif defined(_WIN32)
+  ReleaseSRWLockExclusive(&ledger_util_date_guard);
+#else
+  pthread_mutex_unlock(&ledger_util_date_guard);
+#endif /*LEDGER_UTIL_NO_THREADS*/
+  return text;
+}
+
 int ledger_util_ustrncmp
   (unsigned char const* a, unsigned char const* b, size_t sz)
 {
@@ -172,5 +1030,249 @@ int ledger_util_ustrncmp
   else return +1;
 }
 
+size_t ledger_util_count_allocations(void){
+  return ledger_util_allocation_count;
+}
+
+struct ledger_util_arena* ledger_util_arena_new(size_t chunk_size){
+  struct ledger_util_arena* a = (struct ledger_util_arena*)ledger_util_malloc
+    (sizeof(struct ledger_util_arena));
+  if (a != NULL){
+    a->chunks = NULL;
+    a->chunk_size = (chunk_size > 0) ? chunk_size : LEDGER_UTIL_ARENA_CHUNK;
+  }
+  return a;
+}
+
+void ledger_util_arena_free(struct ledger_util_arena* a){
+  if (a != NULL){
+    struct ledger_util_arena_chunk* chunk = a->chunks;
+    while (chunk != NULL){
+      struct ledger_util_arena_chunk* const next = chunk->next;
+      ledger_util_free(chunk);
+      chunk = next;
+    }
+    ledger_util_free(a);
+  }
+  return;
+}
+
+void* ledger_util_arena_alloc(struct ledger_util_arena* a, size_t siz){
+  size_t const align = sizeof(union ledger_util_arena_align);
+  struct ledger_util_arena_chunk* chunk = a->chunks;
+  if (siz == 0) return NULL;
+  else if (siz > (~(size_t)0) - align) return NULL;
+  /* round up to keep the next block aligned */
+  siz = ((siz + align - 1) / align) * align;
+  if (chunk != NULL && chunk->size - chunk->used >= siz){
+    /* use the current chunk */;
+  } else if (siz > a->chunk_size/4){
+    /* give large blocks their own chunk, behind the current one */
+    chunk = ledger_util_arena_chunk_new(siz);
+    if (chunk == NULL) return NULL;
+    if (a->chunks != NULL){
+      chunk->next = a->chunks->next;
+      a->chunks->next = chunk;
+    } else a->chunks = chunk;
+  } else {
+    chunk = ledger_util_arena_chunk_new(a->chunk_size);
+    if (chunk == NULL) return NULL;
+    chunk->next = a->chunks;
+    a->chunks = chunk;
+  }
+  /* carve out the block */{
+    void* const out = ((unsigned char*)chunk->data) + chunk->used;
+    chunk->used += siz;
+    return out;
+  }
+}
+
+unsigned char* ledger_util_arena_ustrdup
+  (struct ledger_util_arena* a, unsigned char const* str, int* ok)
+{
+  if (str != NULL){
+    size_t len = ledger_util_ustrlen(str);
+    unsigned char* ptr;
+    if (len >= 65534){
+      /* string too long */
+      if (ok) *ok = 0;
+      return NULL;
+    } else {
+      ptr = (unsigned char*)ledger_util_arena_alloc(a, len+1);
+      if (ptr != NULL){
+        memcpy(ptr,str,len);
+        ptr[len] = 0;
+        if (ok) *ok = 1;
+      } else {
+        if (ok) *ok = 0;
+      }
+      return ptr;
+    }
+  } else {
+    if (ok) *ok = 1;
+    return NULL;
+  }
+}
+
+struct ledger_util_lock* ledger_util_lock_new(void){
+  struct ledger_util_lock* l = (struct ledger_util_lock*)
+    ledger_util_ref_malloc(sizeof(struct ledger_util_lock),
+        ledger_util_lock_free_cb);
+  if (l != NULL){
+    l->ready_tf = 0;
+    l->state = 0;
+    l->writers_waiting = 0;
+    l->waiting = 0;
+#if defined(LEDGER_UTIL_NO_THREADS)
+    l->ready_tf = 1;
+#elif defined(_WIN32)
+    InitializeCriticalSection(&l->mutex);
+    InitializeConditionVariable(&l->cond);
+    l->ready_tf = 1;
+#else
+    if (pthread_mutex_init(&l->mutex, NULL) == 0){
+      if (pthread_cond_init(&l->cond, NULL) == 0){
+        l->ready_tf = 1;
+      } else pthread_mutex_destroy(&l->mutex);
+    }
+#endif /*LEDGER_UTIL_NO_THREADS*/
+    if (!l->ready_tf){
+      ledger_util_ref_free(l);
+      l = NULL;
+    }
+  }
+  return l;
+}
+
+struct ledger_util_lock* ledger_util_lock_acquire(struct ledger_util_lock* l){
+  return (struct ledger_util_lock*)ledger_util_ref_acquire(l);
+}
+
+void ledger_util_lock_free(struct ledger_util_lock* l){
+  if (l != NULL){
+    ledger_util_ref_free(l);
+  }
+  return;
+}
+
+void ledger_util_lock_shared(struct ledger_util_lock* l){
+#if !defined(LEDGER_UTIL_NO_THREADS)
+  struct ledger_util_lock_hold* hold;
+  if (l == NULL) return;
+  hold = ledger_util_lock_find(l);
+  if (hold != NULL){
+    /* already held, shared or exclusive */
+    hold->depth += 1;
+    return;
+  }
+  ledger_util_lock_reserve();
+  /* uncontended: count the reader without the guard */
+  if (ledger_util_lock_add(l, 1u)
+      & (LEDGER_UTIL_LOCK_WRITER|LEDGER_UTIL_LOCK_WAITERS))
+  {
+    /* take the count back and wait in turn */
+    ledger_util_lock_drop(l, 1u);
+    ledger_util_lock_shared_wait(l);
+  }
+  ledger_util_lock_track(l, 0);
+#else
+  (void)l;
+#endif /*LEDGER_UTIL_NO_THREADS*/
+  return;
+}
+
+void ledger_util_unlock_shared(struct ledger_util_lock* l){
+#if !defined(LEDGER_UTIL_NO_THREADS)
+  if (l == NULL) return;
+  ledger_util_lock_release(l);
+#else
+  (void)l;
+#endif /*LEDGER_UTIL_NO_THREADS*/
+  return;
+}
+
+void ledger_util_lock_exclusive(struct ledger_util_lock* l){
+#if !defined(LEDGER_UTIL_NO_THREADS)
+  struct ledger_util_lock_hold* hold;
+  if (l == NULL) return;
+  hold = ledger_util_lock_find(l);
+  if (hold != NULL){
+    /* NOTE upgrading a shared hold is forbidden: two upgrading
+     * readers would wait on each other forever, and going on under
+     * the shared hold would let the caller write beside readers */
+    assert(hold->exclusive_tf
+      && "ledger_util_lock_exclusive: lock already held shared");
+    if (!hold->exclusive_tf)
+      abort();
+    hold->depth += 1;
+    return;
+  }
+  ledger_util_lock_reserve();
+  /* uncontended: claim the lock without the guard */
+  if (!ledger_util_lock_swap(l, 0, LEDGER_UTIL_LOCK_WRITER))
+    ledger_util_lock_exclusive_wait(l);
+  ledger_util_lock_track(l, 1);
+#else
+  (void)l;
+#endif /*LEDGER_UTIL_NO_THREADS*/
+  return;
+}
+
+void ledger_util_unlock_exclusive(struct ledger_util_lock* l){
+#if !defined(LEDGER_UTIL_NO_THREADS)
+  if (l == NULL) return;
+  ledger_util_lock_release(l);
+#else
+  (void)l;
+#endif /*LEDGER_UTIL_NO_THREADS*/
+  return;
+}
+
+int ledger_util_share_add(int* count, int n){
+  int out;
+#if defined(LEDGER_UTIL_NO_THREADS)
+  /* nothing to guard */
+#elif defined(_WIN32)
+  AcquireSRWLockExclusive(&ledger_util_share_guard);
+#else
+  pthread_mutex_lock(&ledger_util_share_guard);
+#endif /*LEDGER_UTIL_NO_THREADS*/
+  if (n < 0 && *count < -n){
+    *count = 0;
+  } else if (n > 0 && *count > INT_MAX-n){
+    *count = INT_MAX;
+  } else *count += n;
+  out = *count;
+#if defined(LEDGER_UTIL_NO_THREADS)
+  /* nothing to guard */
+#elif defined(_WIN32)
+  ReleaseSRWLockExclusive(&ledger_util_share_guard);
+#else
+  pthread_mutex_unlock(&ledger_util_share_guard);
+#endif /*LEDGER_UTIL_NO_THREADS*/
+  return out;
+}
+
+unsigned int ledger_util_stamp_add(unsigned int* stamp, unsigned int n){
+#if defined(LEDGER_UTIL_NO_THREADS)
+  *stamp += n;
+  return *stamp;
+#elif defined(_WIN32)
+  return (unsigned int)InterlockedExchangeAdd
+    ((LONG volatile*)stamp, (LONG)n) + n;
+#elif defined(__GNUC__)
+  if (n == 0)
+    return __atomic_load_n(stamp, __ATOMIC_ACQUIRE);
+  else return __atomic_add_fetch(stamp, n, __ATOMIC_SEQ_CST);
+#else
+  unsigned int out;
+  pthread_mutex_lock(&ledger_util_share_guard);
+  *stamp += n;
+  out = *stamp;
+  pthread_mutex_unlock(&ledger_util_share_guard);
+  return out;
+#endif /*LEDGER_UTIL_NO_THREADS*/
+}
+
 /* END   implementation */
 
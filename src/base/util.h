@@ -14,6 +14,18 @@ extern "C" {
 
 typedef void (*ledger_util_ref_dtor)(void*);
 
+/*
+ * brief: Bulk allocator for many small blocks
+ */
+struct ledger_util_arena;
+
+/*
+ * brief: Shared/exclusive lock. A thread may take a lock again while
+ *   already holding it. A thread holding a lock shared must not ask
+ *   for it exclusively; debug builds fail an assertion if it does.
+ */
+struct ledger_util_lock;
+
 
 /*
  * Call `malloc` from in this library.
@@ -120,6 +132,159 @@ size_t ledger_util_itoa(int n, unsigned char* buf, size_t siz, int want_plus);
  */
 int ledger_util_atoi(unsigned char const* str);
 
+/*
+ * Parse a date into a packed integer. Accepted forms are
+ * `YYYY-MM-DD`, `YYYY-MM-DDThh:mm`, `YYYY-MM-DDThh:mm:ss` and
+ * `YYYY-MM-DDThh:mm:ssZ`. Packed dates keep the form, so they format
+ * back to the same text, and compare in the same order as their text.
+ * - str the text to parse
+ * - value packed date on success
+ * @return one on success, zero if the text is not a date
+ */
+int ledger_util_date_from_text(unsigned char const* str, long long int* value);
+
+/*
+ * Format a packed date.
+ * - value packed date, non-negative
+ * - buf buffer to receive the string
+ * - siz size of buffer in bytes
+ * @return the number of bytes needed to perform the conversion,
+ *   not including a NUL terminator, or zero if not a packed date
+ */
+size_t ledger_util_date_to_text
+  (long long int value, unsigned char* buf, size_t siz);
+
+/*
+ * Keep text that is not a date in place of a packed date, such as
+ * a free-form date from a book written before date columns. The
+ * same text always gets the same value, and values of kept texts
+ * order before every packed date. Kept texts last as long as the
+ * process.
+ * - str the text to keep
+ * - value the value standing for the text, below -1, on success
+ * @return one on success, zero otherwise
+ */
+int ledger_util_date_keep_text
+  (unsigned char const* str, long long int* value);
+
+/*
+ * Get the text kept in place of a packed date.
+ * - value value from `ledger_util_date_keep_text`
+ * @return the text, or NULL if the value stands for no kept text
+ */
+unsigned char const* ledger_util_date_kept_text(long long int value);
+
+/*
+ * Query the number of heap blocks allocated through this library.
+ * The count is a statistic for benchmarks, kept separately
+ * for each thread.
+ * @return the number of allocations made so far by the current thread
+ */
+size_t ledger_util_count_allocations(void);
+
+/*
+ * Construct a new arena. Blocks from an arena are never freed
+ * individually; instead, all of them are freed with the arena.
+ * - chunk_size preferred size of each bulk allocation, or zero
+ *   for a default size
+ * @return the arena on success, otherwise NULL
+ */
+struct ledger_util_arena* ledger_util_arena_new(size_t chunk_size);
+
+/*
+ * Destroy an arena along with every block allocated from it.
+ * - a the arena to destroy
+ */
+void ledger_util_arena_free(struct ledger_util_arena* a);
+
+/*
+ * Allocate a block from an arena.
+ * - a the arena to use
+ * - siz size of block to allocate
+ * @return the block, suitably aligned for any scalar type,
+ *   otherwise NULL
+ */
+void* ledger_util_arena_alloc(struct ledger_util_arena* a, size_t siz);
+
+/*
+ * Duplicate a UTF-8 string into an arena.
+ * - a the arena to use
+ * - str string to duplicate
+ * - ok (optional) success flag
+ * @return the cloned string on success, otherwise NULL
+ */
+unsigned char* ledger_util_arena_ustrdup
+  (struct ledger_util_arena* a, unsigned char const* str, int* ok);
+
+/*
+ * Construct a new shared/exclusive lock. Locks are reference-counted.
+ * @return the lock on success, otherwise NULL
+ */
+struct ledger_util_lock* ledger_util_lock_new(void);
+
+/*
+ * Acquire a reference to a lock.
+ * - l the lock to acquire
+ * @return the lock on success, otherwise NULL
+ */
+struct ledger_util_lock* ledger_util_lock_acquire(struct ledger_util_lock* l);
+
+/*
+ * Free a reference to a lock.
+ * - l the lock to free
+ */
+void ledger_util_lock_free(struct ledger_util_lock* l);
+
+/*
+ * Hold a lock for reading, waiting for any writer to finish first.
+ * Without writers about, this takes one atomic operation, and taking
+ * a lock the thread already holds takes none.
+ * - l the lock to hold, or NULL to do nothing
+ */
+void ledger_util_lock_shared(struct ledger_util_lock* l);
+
+/*
+ * Release a lock held for reading.
+ * - l the lock to release, or NULL to do nothing
+ */
+void ledger_util_unlock_shared(struct ledger_util_lock* l);
+
+/*
+ * Hold a lock for writing, waiting for all other holders to finish first.
+ * The calling thread must not already hold the lock shared; asking to
+ * upgrade a shared hold aborts the program, in every build.
+ * - l the lock to hold, or NULL to do nothing
+ */
+void ledger_util_lock_exclusive(struct ledger_util_lock* l);
+
+/*
+ * Release a lock held for writing.
+ * - l the lock to release, or NULL to do nothing
+ */
+void ledger_util_unlock_exclusive(struct ledger_util_lock* l);
+
+/*
+ * Adjust the count of extra owners of a shared object. Containers
+ * that share an object copy it before changing it while the count
+ * is above zero. The count never goes below zero.
+ * - count the count to adjust
+ * - n amount to add (can be negative, or zero to only read the count)
+ * @return the new count
+ */
+int ledger_util_share_add(int* count, int n);
+
+/*
+ * Advance a change stamp. Caches remember the stamp they were built
+ * at and compare it to spot changes made since. The stamp wraps
+ * around instead of stopping at its largest value. Stamps change
+ * atomically where the compiler allows, so that reading one costs
+ * no more than a load.
+ * - stamp the stamp to advance
+ * - n amount to add (zero to only read the stamp)
+ * @return the new stamp
+ */
+unsigned int ledger_util_stamp_add(unsigned int* stamp, unsigned int n);
+
 #ifdef __cplusplus
 };
 #endif /*__cplusplus*/
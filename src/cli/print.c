@@ -33,19 +33,31 @@ int ledger_cli_print_account_line
   unsigned char date_text[24];
   do {
     int row_journal_id, row_entry_id;
-    if (!ledger_table_fetch_id(mark,0,&row_entry_id)){
-      result = 0;
-      break;
-    }
     struct ledger_act_path display_path;
-    if (!ledger_table_fetch_id(mark,0,&row_journal_id)){
-      result = 0;
-      break;
-    }
-    if (!ledger_table_fetch_id(mark,1,&row_entry_id)){
+    struct ledger_table_field line[5];
+    memset(line, 0, sizeof(line));
+    line[0].column = 0;
+    line[0].type = LEDGER_TABLE_ID;
+    line[1].column = 1;
+    line[1].type = LEDGER_TABLE_ID;
+    line[2].column = 2;
+    line[2].type = LEDGER_TABLE_USTR;
+    line[2].buf = amount_text;
+    line[2].len = sizeof(amount_text);
+    line[3].column = 3;
+    line[3].type = LEDGER_TABLE_USTR;
+    line[3].buf = check_text;
+    line[3].len = sizeof(check_text);
+    line[4].column = 4;
+    line[4].type = LEDGER_TABLE_USTR;
+    line[4].buf = date_text;
+    line[4].len = sizeof(date_text);
+    if (!ledger_table_fetch_row(mark, 5, line)){
       result = 0;
       break;
     }
+    row_journal_id = line[0].id;
+    row_entry_id = line[1].id;
     display_path.path[0] =
       ledger_find_journal_by_id(tracking->book, row_journal_id);
     if (display_path.path[0] >= 0){
@@ -60,24 +72,6 @@ int ledger_cli_print_account_line
         ( path_text, sizeof(path_text), display_path, tracking->book)
         < 0)
       break;
-    if (ledger_table_fetch_string
-        (mark,2,amount_text,sizeof(amount_text)) < 0)
-    {
-      result = 0;
-      break;
-    }
-    if (ledger_table_fetch_string
-        (mark,3,check_text,sizeof(check_text)) < 0)
-    {
-      result = 0;
-      break;
-    }
-    if (ledger_table_fetch_string
-        (mark,4,date_text,sizeof(date_text)) < 0)
-    {
-      result = 0;
-      break;
-    }
     fprintf(f,"  %-60s\n    %16s %24s %16s\n",
         path_text, amount_text, date_text, check_text);
     result = 1;
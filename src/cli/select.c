@@ -7,6 +7,7 @@
 #include "../base/entry.h"
 #include "../base/table.h"
 #include "../base/bignum.h"
+#include "../base/util.h"
 #include "line.h"
 #include <stdio.h>
 #include <string.h>
@@ -41,7 +42,7 @@ struct ledger_cli_select_schema ledger_cli_select_account_schema[] = {
   { LEDGER_CLI_SELECT_ENTRY, LEDGER_TABLE_ID },
   { LEDGER_CLI_SELECT_AMOUNT, LEDGER_TABLE_BIGNUM },
   { LEDGER_CLI_SELECT_CHECK, LEDGER_TABLE_USTR },
-  { LEDGER_CLI_SELECT_DATE, LEDGER_TABLE_USTR }
+  { LEDGER_CLI_SELECT_DATE, LEDGER_TABLE_DATE }
 };
 
 struct {
@@ -71,7 +72,9 @@ struct {
  * Callback data.
  */
 struct ledger_cli_select_cb {
-  /* running total */
+  /* running total, with carries deferred */
+  struct ledger_bignum_accum* accum;
+  /* final total */
   struct ledger_bignum* sum;
   /* temporary number register */
   struct ledger_bignum* tmp;
@@ -173,16 +176,23 @@ int ledger_cli_select_cmp_index(char const* cmp){
 }
 
 int ledger_cli_select_cb_init(struct ledger_cli_select_cb *data){
+  data->accum = ledger_bignum_accum_new();
+  if (data->accum == NULL) return 0;
   data->sum = ledger_bignum_new();
-  if (data->sum == NULL) return 0;
+  if (data->sum == NULL){
+    ledger_bignum_accum_free(data->accum);
+    return 0;
+  }
   data->tmp = ledger_bignum_new();
   if (data->tmp == NULL){
     ledger_bignum_free(data->sum);
+    ledger_bignum_accum_free(data->accum);
     return 0;
   } else return 1;
 }
 
 void ledger_cli_select_cb_clear(struct ledger_cli_select_cb *data){
+  ledger_bignum_accum_free(data->accum);
   ledger_bignum_free(data->sum);
   ledger_bignum_free(data->tmp);
   return;
@@ -199,7 +209,7 @@ int ledger_cli_select_iterate
       ok = ledger_table_fetch_bignum(m, data->sum_column, data->tmp);
       if (!ok) break;
     }
-    ok = ledger_bignum_add(data->sum, data->tmp, data->sum);
+    ok = ledger_bignum_accum_add(data->accum, data->tmp);
     if (!ok) break;
     ok = ledger_cli_print_account_line(data->tracking, m, stderr);
     if (!ok) break;
@@ -235,6 +245,7 @@ int ledger_cli_select(struct ledger_cli_line *tracking, int argc, char **argv){
     } else if (strcmp(argv[argi],"-c") == 0
       ||  strcmp(argv[argi],"-n") == 0
       ||  strcmp(argv[argi],"-i") == 0
+      ||  strcmp(argv[argi],"-d") == 0
     ){
       /* add a condition */
       int cond_type;
@@ -242,6 +253,8 @@ int ledger_cli_select(struct ledger_cli_line *tracking, int argc, char **argv){
         cond_type = LEDGER_SELECT_BIGNUM;
       else if (strcmp(argv[argi],"-i") == 0)
         cond_type = LEDGER_SELECT_ID;
+      else if (strcmp(argv[argi],"-d") == 0)
+        cond_type = LEDGER_SELECT_DATE;
       else
         cond_type = LEDGER_SELECT_STRING;
       if (condition_count >= 10){
@@ -290,6 +303,11 @@ int ledger_cli_select(struct ledger_cli_line *tracking, int argc, char **argv){
       "          (field) field name\n"
       "          (cmp) comparator (one of ==, <, >, !=, <=, >=)\n"
       "          (value) value against which to compare\n"
+      "  -d (field) (cmp) (value)\n"
+      "          Add a date condition for a particular field.\n"
+      "          (field) field name\n"
+      "          (cmp) comparator (one of ==, <, >, !=, <=, >=)\n"
+      "          (value) date in the form YYYY-MM-DD[Thh:mm[:ss]][Z]\n"
       "  -r\n"
       "          Reverse the linear search direction\n"
       ,stderr);
@@ -321,7 +339,20 @@ int ledger_cli_select(struct ledger_cli_line *tracking, int argc, char **argv){
             fprintf(stderr,"select: Non-existent account field requested.\n");
             result = 1;
             break;
-          } else conditions[i].column = schema_item.name;
+          }
+          conditions[i].column = schema_item.name;
+          /* compare dates by value when the text is a date */
+          if (schema_item.typ == LEDGER_TABLE_DATE
+          &&  (conditions[i].cmp&~15u) == LEDGER_SELECT_STRING)
+          {
+            long long int date_value;
+            if (ledger_util_date_from_text
+                  (conditions[i].value, &date_value))
+            {
+              conditions[i].cmp =
+                (conditions[i].cmp&15u)|LEDGER_SELECT_DATE;
+            }
+          }
         }
       }break;
     }
@@ -367,7 +398,12 @@ int ledger_cli_select(struct ledger_cli_line *tracking, int argc, char **argv){
         result = ledger_select_by_cond_c
             ( next_table, &cb_data, &ledger_cli_select_iterate,
               condition_count, conditions, direction);
-        if (!result){
+        if (!result
+        &&  !ledger_bignum_accum_get(cb_data.accum, cb_data.sum))
+        {
+          fprintf(stderr,"select: Balance out of range.\n");
+          result = 2;
+        } else if (!result){
           char numeric_buf[64];
           (void)ledger_bignum_get_text
             (cb_data.sum, (unsigned char*)numeric_buf, sizeof(numeric_buf), 1);
@@ -7,6 +7,13 @@
 #include <limits.h>
 
 
+/*
+ * number of CSV lines to add to a table at a time
+ */
+#ifndef LEDGER_IO_TABLE_BATCH
+#  define LEDGER_IO_TABLE_BATCH 64
+#endif /*LEDGER_IO_TABLE_BATCH*/
+
 /*
  * Escape a row field.
  * - mark row mark
@@ -103,7 +110,9 @@ int ledger_io_table_parse_csv(struct ledger_table* table, unsigned char *csv){
   int const column_count = ledger_table_get_column_count(table);
   char *running = (char*)csv;
   char** token_lines;
+  struct ledger_table_field* fields;
   struct ledger_table_mark *mark;
+  int batch_rows = 0;
   if (column_count == 0) return 1;
   /* allocate the token pointers */{
     token_lines = (char**)ledger_util_malloc(column_count*sizeof(char*));
@@ -111,12 +120,25 @@ int ledger_io_table_parse_csv(struct ledger_table* table, unsigned char *csv){
       return 0;
     }
   }
+  /* allocate a batch of row fields */{
+    int i;
+    fields = (struct ledger_table_field*)ledger_util_malloc
+      (LEDGER_IO_TABLE_BATCH*column_count*sizeof(struct ledger_table_field));
+    if (fields == NULL){
+      ledger_util_free(token_lines);
+      return 0;
+    }
+    memset(fields, 0,
+      LEDGER_IO_TABLE_BATCH*column_count*sizeof(struct ledger_table_field));
+    for (i = 0; i < LEDGER_IO_TABLE_BATCH*column_count; ++i){
+      fields[i].column = i%column_count;
+      fields[i].type = LEDGER_TABLE_USTR;
+    }
+  }
   mark = ledger_table_end(table);
-  while (*running){
+  if (mark == NULL) ok = 0;
+  else while (*running){
     size_t real_column_count;
-    if (!ledger_table_add_row(mark)){
-      ok = 0;break;
-    }
     running = minicsv_parse_line
       (running, token_lines, &real_column_count, column_count);
     if (real_column_count != column_count){
@@ -124,18 +146,28 @@ int ledger_io_table_parse_csv(struct ledger_table* table, unsigned char *csv){
     }
     /* fill in the fields */{
       int i;
+      struct ledger_table_field* const row_fields =
+        fields+batch_rows*column_count;
       for (i = 0; i < column_count; ++i){
-        ok = ledger_table_put_string
-          (mark, i, (unsigned char*)token_lines[i]);
-        if (!ok) break;
+        row_fields[i].text = (unsigned char const*)token_lines[i];
       }
+      batch_rows += 1;
+    }
+    /* add the rows to the end of the table */
+    if (batch_rows == LEDGER_IO_TABLE_BATCH){
+      ok = ledger_table_append_rows(mark, batch_rows, column_count, fields);
+      batch_rows = 0;
       if (!ok) break;
     }
-    /* move to end of table */
-    ledger_table_mark_move(mark, +1);
+  }
+  /* keep the lines parsed so far */
+  if (batch_rows > 0){
+    if (!ledger_table_append_rows(mark, batch_rows, column_count, fields))
+      ok = 0;
   }
   ledger_table_mark_free(mark);
   /* free the token pointers */{
+    ledger_util_free(fields);
     ledger_util_free(token_lines);
   }
   return ok;
@@ -145,12 +177,16 @@ unsigned char* ledger_io_table_print_csv(struct ledger_table const* table){
   int const column_count = ledger_table_get_column_count(table);
   size_t entire_csv_length = 0;
   unsigned char* print_paper;
+  /* keep the table still between the two passes */
+  ledger_table_read_lock(table);
   /* compute the entire csv length */{
     size_t row_point = 0;
-    struct ledger_table_mark *mark = ledger_table_begin_c(table);
-    struct ledger_table_mark *end_mark = ledger_table_end_c(table);
-    for (; !ledger_table_mark_is_equal(mark, end_mark);
-          ledger_table_mark_move(mark, +1))
+    struct ledger_table_cursor cursor;
+    struct ledger_table_mark const* const mark =
+      ledger_table_cursor_mark(&cursor);
+    for (ledger_table_cursor_begin(&cursor, table);
+          !ledger_table_cursor_is_end(&cursor);
+          ledger_table_cursor_move(&cursor, +1))
     {
       int i;
       if (row_point > 0){
@@ -158,30 +194,38 @@ unsigned char* ledger_io_table_print_csv(struct ledger_table const* table){
       }
       for (i = 0; i < column_count; ++i){
         if (i > 0) entire_csv_length += 1;/*comma*/
-        entire_csv_length += ledger_io_table_escape_text(mark,i,0,NULL);
+        if (ledger_table_get_column_type(table,i) == LEDGER_TABLE_BIGNUM){
+          /* amounts need no escapes, so measure them without rendering */
+          int const length = ledger_table_fetch_string(mark,i,NULL,0);
+          if (length > 0) entire_csv_length += length;
+        } else {
+          entire_csv_length += ledger_io_table_escape_text(mark,i,0,NULL);
+        }
       }
       row_point += 1;
     }
-    ledger_table_mark_free(end_mark);
-    ledger_table_mark_free(mark);
   }
   /* allocate the entire text */{
     if (entire_csv_length >= ~0u){
       /* avoid overflow */
+      ledger_table_read_unlock(table);
       return NULL;
     }
     print_paper = (unsigned char*)ledger_util_malloc(entire_csv_length+1);
     if (print_paper == NULL){
+      ledger_table_read_unlock(table);
       /* give up and */return NULL;
     }
   }
   /* render the entire csv */{
     size_t row_point = 0;
     size_t write_point = 0;
-    struct ledger_table_mark *mark = ledger_table_begin_c(table);
-    struct ledger_table_mark *end_mark = ledger_table_end_c(table);
-    for (; !ledger_table_mark_is_equal(mark, end_mark);
-          ledger_table_mark_move(mark, +1))
+    struct ledger_table_cursor cursor;
+    struct ledger_table_mark const* const mark =
+      ledger_table_cursor_mark(&cursor);
+    for (ledger_table_cursor_begin(&cursor, table);
+          !ledger_table_cursor_is_end(&cursor);
+          ledger_table_cursor_move(&cursor, +1))
     {
       int i;
       if (write_point >= entire_csv_length) break;
@@ -195,15 +239,26 @@ unsigned char* ledger_io_table_print_csv(struct ledger_table const* table){
           print_paper[write_point++] = ',';/*comma*/
           if (write_point >= entire_csv_length) break;
         }
-        write_point += ledger_io_table_escape_text
-          (mark,i,entire_csv_length-write_point,print_paper+write_point);
+        if (ledger_table_get_column_type(table,i) == LEDGER_TABLE_BIGNUM){
+          /* render amounts in place; the paper has room for the NUL */
+          size_t const remaining = entire_csv_length-write_point;
+          int const length = ledger_table_fetch_string
+            ( mark,i,print_paper+write_point,
+              (remaining < INT_MAX) ? (int)remaining+1 : INT_MAX);
+          if (length > 0){
+            write_point +=
+              ((size_t)length < remaining) ? (size_t)length : remaining;
+          }
+        } else {
+          write_point += ledger_io_table_escape_text
+            (mark,i,entire_csv_length-write_point,print_paper+write_point);
+        }
       }
       row_point += 1;
     }
-    ledger_table_mark_free(end_mark);
-    ledger_table_mark_free(mark);
     print_paper[write_point] = 0;
   }
+  ledger_table_read_unlock(table);
   return print_paper;
 }
 
@@ -145,6 +145,7 @@ struct ledger_luaL_select_cmp ledger_luaL_select_cmps[] = {
   { LEDGER_SELECT_NOTMORE, "<=" },
   { LEDGER_SELECT_ID, "id" },
   { LEDGER_SELECT_INDEX, "index" },
+  { LEDGER_SELECT_DATE, "date" },
   { LEDGER_SELECT_BIGNUM, "bignum" },
   { LEDGER_SELECT_STRING, "string" },
   { LEDGER_SELECT_STRING, "ustr" } /* to match ledger.table API */
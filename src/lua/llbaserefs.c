@@ -11,6 +11,7 @@
 #include "../base/util.h"
 #include "../base/bignum.h"
 #include "../base/table.h"
+#include "../base/find.h"
 #include <limits.h>
 #include <string.h>
 
@@ -330,6 +331,14 @@ static int ledger_luaL_journal_setsequence(struct lua_State *L);
  */
 static int ledger_luaL_journal_getentry(struct lua_State *L);
 
+/*
+ * `ledger.journal.getentrybyid(self~ledger.journal, v~number)`
+ * - self the journal to query
+ * - v entry identifier
+ * @return the journal's entry with that identifier, or nil
+ */
+static int ledger_luaL_journal_getentrybyid(struct lua_State *L);
+
 /*
  * `ledger.journal.getentrycount(self~ledger.journal)`
  * - self the journal to query
@@ -362,6 +371,7 @@ static const struct luaL_Reg ledger_luaL_journal_lib[] = {
   {"getentrycount", ledger_luaL_journal_getentrycount},
   {"setentrycount", ledger_luaL_journal_setentrycount},
   {"getentry", ledger_luaL_journal_getentry},
+  {"getentrybyid", ledger_luaL_journal_getentrybyid},
   {NULL, NULL}
 };
 
@@ -1293,6 +1303,31 @@ int ledger_luaL_journal_getentry(struct lua_State *L){
   return 1;
 }
 
+int ledger_luaL_journal_getentrybyid(struct lua_State *L){
+  /* ARG:
+   *   1  ~ledger.journal
+   *   2  v~number
+   * RET:
+   *   3  @return~ledger.entry|~nil
+   */
+  struct ledger_journal** j =
+    (struct ledger_journal**)luaL_checkudata
+        (L, 1, ledger_llbase_journal_meta);
+  int const v = (int)luaL_checkinteger(L, 2);
+  /* the journal's lookup index keeps this from scanning every entry */
+  int const i = ledger_find_entry_by_id(*j, v);
+  struct ledger_entry* e = (i >= 0) ? ledger_journal_get_entry(*j, i) : NULL;
+  if (e == NULL){
+    lua_pushnil(L);
+  } else if (ledger_entry_acquire(e) != e){
+    luaL_error(L, "ledger.journal.getentrybyid: Journal entry unavailable");
+  } else {
+    ledger_llbase_postentry
+      (L, e, 1, "ledger.journal.getentrybyid: Journal entry available");
+  }
+  return 1;
+}
+
 int ledger_luaL_journal_getentrycount(struct lua_State *L){
   /* ARG:
    *   1  ~ledger.journal
@@ -12,6 +12,7 @@
 
 static char const* ledger_llbase_table_meta = "ledger.table";
 static char const* ledger_llbase_tablemark_meta = "ledger.table.mark";
+static char const* ledger_llbase_tableobserver_meta = "ledger.table.observer";
 static char const* ledger_llbase_bignum_meta = "ledger.bignum";
 
 /*   BEGIN ledger/base/table { */
@@ -79,6 +80,16 @@ static int ledger_luaL_table_getcolumntypes(struct lua_State *L);
  */
 static int ledger_luaL_table_setcolumntypes(struct lua_State *L);
 
+/*
+ * `ledger.table.observe(self~ledger.table, cb~function)`
+ * - self the table to observe
+ * - cb function(event~string, row~number, column~number) to call
+ *   on each change, where the event is one of "add", "drop", "put"
+ *   and "reset"; row and column are nil where they do not apply
+ * @return an observer, which stays registered until closed or collected
+ */
+static int ledger_luaL_table_observe(struct lua_State *L);
+
 /* [INTERNAL]
  * Set a Lua table to an integer array
  * - a pointer to array
@@ -97,6 +108,7 @@ static const struct luaL_Reg ledger_luaL_table_lib[] = {
   {"endmark", ledger_luaL_table_end},
   {"getcolumntypes", ledger_luaL_table_getcolumntypes},
   {"setcolumntypes", ledger_luaL_table_setcolumntypes},
+  {"observe", ledger_luaL_table_observe},
   {NULL,NULL}
 };
 
@@ -110,6 +122,7 @@ static struct ledger_luaL_table_enum const ledger_luaL_table_types[] = {
   {LEDGER_TABLE_BIGNUM, "bignum"},
   {LEDGER_TABLE_USTR, "ustr"},
   {LEDGER_TABLE_INDEX, "index"},
+  {LEDGER_TABLE_DATE, "date"},
   {0,NULL}
 };
 
@@ -138,6 +151,23 @@ static int ledger_luaL_tablemark___eq(struct lua_State *L);
  */
 static int ledger_luaL_tablemark_move(struct lua_State *L);
 
+/*
+ * `ledger.table.mark.seek(self~ledger.table.mark, i~number)`
+ * - self mark to move
+ * - i one-based position of the target row, or one more than
+ *   the row count for the end of the table
+ * @return a success flag
+ */
+static int ledger_luaL_tablemark_seek(struct lua_State *L);
+
+/*
+ * `ledger.table.mark.index(self~ledger.table.mark)`
+ * - self mark to query
+ * @return the one-based position of the mark's row, one more than
+ *   the row count at the end of the table, or nil if unavailable
+ */
+static int ledger_luaL_tablemark_index(struct lua_State *L);
+
 /*
  * `ledger.table.mark.addrow(~ledger.table.mark)`
  * - self mark at which to add a row
@@ -173,6 +203,8 @@ static const struct luaL_Reg ledger_luaL_tablemark_lib[] = {
   {"__gc", ledger_luaL_tablemark___gc},
   {"__eq", ledger_luaL_tablemark___eq},
   {"move", ledger_luaL_tablemark_move},
+  {"seek", ledger_luaL_tablemark_seek},
+  {"index", ledger_luaL_tablemark_index},
   {"addrow", ledger_luaL_tablemark_addrow},
   {"droprow", ledger_luaL_tablemark_droprow},
   {"fetch", ledger_luaL_tablemark_fetch},
@@ -182,6 +214,59 @@ static const struct luaL_Reg ledger_luaL_tablemark_lib[] = {
 
 /* } END   ledger/base/table/mark */
 
+/*   BEGIN ledger/base/table/observer { */
+
+/*
+ * Lua table observer
+ */
+struct ledger_luaL_table_observer {
+  /* Lua state to run the callback in */
+  struct lua_State* L;
+  /* observed table, or NULL once closed */
+  struct ledger_table* t;
+  /* registry reference to the callback */
+  int ref;
+};
+
+/*
+ * `ledger.table.observer.close(self~ledger.table.observer)`
+ * - self the observer to unregister
+ */
+static int ledger_luaL_tableobserver_close(struct lua_State *L);
+
+/*
+ * Table observer callback for Lua observers.
+ * - arg the Lua observer
+ * - event the change
+ * - mark the row that changed
+ * - row position of the row that changed
+ * - column the column of a put cell
+ */
+static void ledger_luaL_tableobserver_cb
+  ( void* arg, int event, struct ledger_table_mark const* mark,
+    int row, int column);
+
+/* [INTERNAL]
+ * Call a Lua observer's function.
+ */
+static int ledger_luaL_tableobserver_cbP1(struct lua_State *L);
+
+static const struct luaL_Reg ledger_luaL_tableobserver_lib[] = {
+  {"__gc", ledger_luaL_tableobserver_close},
+  {"close", ledger_luaL_tableobserver_close},
+  {NULL,NULL}
+};
+
+static struct ledger_luaL_table_enum const ledger_luaL_table_events[] = {
+  {LEDGER_TABLE_ROW_ADDED, "add"},
+  {LEDGER_TABLE_ROW_DROPPED, "drop"},
+  {LEDGER_TABLE_CELL_PUT, "put"},
+  {LEDGER_TABLE_SCHEMA_RESET, "reset"},
+  {0,NULL}
+};
+
+/* } END   ledger/base/table/observer */
+
 /* BEGIN static implementation */
 
 /*   BEGIN ledger/base/table { */
@@ -487,6 +572,45 @@ int ledger_luaL_tablemark_move(struct lua_State *L){
   return 0;
 }
 
+int ledger_luaL_tablemark_seek(struct lua_State *L){
+  /* ARG:
+   *   1  ~ledger.table.mark
+   *   2  ~number
+   * RET:
+   *   3 @return~boolean
+   */
+  int result;
+  struct ledger_table_mark** mark =
+    (struct ledger_table_mark**)luaL_checkudata
+        (L, 1, ledger_llbase_tablemark_meta);
+  /* ensure Lua one-index adjustment `-1` */
+  lua_Integer i = lua_tointeger(L, 2)-1;
+  if (i < 0 || i > INT_MAX)
+    result = 0;
+  else
+    result = ledger_table_mark_seek(*mark, (int)i);
+  lua_pushboolean(L, result!=0);
+  return 1;
+}
+
+int ledger_luaL_tablemark_index(struct lua_State *L){
+  /* ARG:
+   *   1  ~ledger.table.mark
+   * RET:
+   *   2 @return~(number|nil)
+   */
+  int result;
+  struct ledger_table_mark** mark =
+    (struct ledger_table_mark**)luaL_checkudata
+        (L, 1, ledger_llbase_tablemark_meta);
+  result = ledger_table_mark_get_index(*mark);
+  if (result < 0)
+    lua_pushnil(L);
+  else /* ensure Lua one-index adjustment `+1` */
+    lua_pushinteger(L, ((lua_Integer)result)+1);
+  return 1;
+}
+
 int ledger_luaL_tablemark_addrow(struct lua_State *L){
   /* ARG:
    *   1  ~ledger.table.mark
@@ -558,6 +682,7 @@ int ledger_luaL_tablemark_fetch(struct lua_State *L){
           "Big number not available");
     }break;
   case LEDGER_TABLE_USTR:
+  case LEDGER_TABLE_DATE:
     {
       unsigned char *buf;
       int length;
@@ -678,6 +803,109 @@ int ledger_luaL_tablemark_put(struct lua_State *L){
 
 /* } END   ledger/base/table/mark */
 
+/*   BEGIN ledger/base/table/observer { */
+
+int ledger_luaL_table_observe(struct lua_State *L){
+  /* ARG:
+   *   1  self~ledger.table
+   *   2  cb~function
+   * RET:
+   *   3  @return~ledger.table.observer
+   */
+  struct ledger_table** t =
+    (struct ledger_table**)luaL_checkudata(L, 1, ledger_llbase_table_meta);
+  struct ledger_luaL_table_observer* ob;
+  luaL_checktype(L, 2, LUA_TFUNCTION);
+  ob = (struct ledger_luaL_table_observer*)lua_newuserdatauv
+    (L, sizeof(struct ledger_luaL_table_observer), 0);
+  /* callbacks run on the main thread, which outlives any coroutine */
+  lua_rawgeti(L, LUA_REGISTRYINDEX, LUA_RIDX_MAINTHREAD);
+  ob->L = lua_tothread(L, -1);
+  lua_pop(L, 1);
+  ob->t = NULL;
+  ob->ref = LUA_NOREF;
+  luaL_setmetatable(L, ledger_llbase_tableobserver_meta);
+  lua_pushvalue(L, 2);
+  ob->ref = luaL_ref(L, LUA_REGISTRYINDEX);
+  ob->t = ledger_table_acquire(*t);
+  if (ob->t == NULL){
+    luaL_error(L, "ledger.table.observe: table not available");
+  } else if (!ledger_table_add_observer
+      (ob->t, ledger_luaL_tableobserver_cb, ob))
+  {
+    luaL_error(L, "ledger.table.observe: observer not available");
+  }
+  return 1;
+}
+
+int ledger_luaL_tableobserver_close(struct lua_State *L){
+  /* ARG:
+   *   1  self~ledger.table.observer
+   * RET:
+   *   X
+   */
+  struct ledger_luaL_table_observer* ob =
+    (struct ledger_luaL_table_observer*)luaL_checkudata
+        (L, 1, ledger_llbase_tableobserver_meta);
+  if (ob->t != NULL){
+    ledger_table_drop_observer(ob->t, ledger_luaL_tableobserver_cb, ob);
+    ledger_table_free(ob->t);
+    ob->t = NULL;
+  }
+  luaL_unref(L, LUA_REGISTRYINDEX, ob->ref);
+  ob->ref = LUA_NOREF;
+  return 0;
+}
+
+void ledger_luaL_tableobserver_cb
+  ( void* arg, int event, struct ledger_table_mark const* mark,
+    int row, int column)
+{
+  struct ledger_luaL_table_observer* const ob =
+    (struct ledger_luaL_table_observer*)arg;
+  struct lua_State* const L = ob->L;
+  (void)mark;
+  if (!lua_checkstack(L, 5)) return;
+  lua_pushcfunction(L, ledger_luaL_tableobserver_cbP1);
+  lua_rawgeti(L, LUA_REGISTRYINDEX, ob->ref);
+  lua_pushinteger(L, (lua_Integer)event);
+  lua_pushinteger(L, (lua_Integer)row);
+  lua_pushinteger(L, (lua_Integer)column);
+  /* errors must not unwind through the table */
+  if (lua_pcall(L, 4, 0, 0) != LUA_OK)
+    lua_pop(L, 1);
+  return;
+}
+
+int ledger_luaL_tableobserver_cbP1(struct lua_State *L){
+  /* ARG:
+   *   1  cb~function
+   *   2  event~integer
+   *   3  row~integer
+   *   4  column~integer
+   * RET:
+   *   X
+   */
+  int const event = (int)lua_tointeger(L, 2);
+  lua_Integer const row = lua_tointeger(L, 3);
+  lua_Integer const column = lua_tointeger(L, 4);
+  int i;
+  lua_pushvalue(L, 1);
+  for (i = 0; ledger_luaL_table_events[i].name != NULL; ++i){
+    if (ledger_luaL_table_events[i].value == event) break;
+  }
+  lua_pushstring(L, ledger_luaL_table_events[i].name);
+  /* ensure Lua one-index adjustment `+1` */
+  if (row >= 0) lua_pushinteger(L, row+1);
+  else lua_pushnil(L);
+  if (column >= 0) lua_pushinteger(L, column+1);
+  else lua_pushnil(L);
+  lua_call(L, 3, 0);
+  return 0;
+}
+
+/* } END   ledger/base/table/observer */
+
 /* END   static implementation */
 
 /* BEGIN implementation */
@@ -697,6 +925,18 @@ void ledger_luaopen_basetable(struct lua_State *L){
       }
       lua_setfield(L, -2, "mark");
     }
+    /* add table observer lib */{
+      luaL_newlib(L, ledger_luaL_tableobserver_lib);
+      lua_pushvalue(L, -1);
+      lua_pushvalue(L, -1);
+      lua_setfield(L, -2, "__index");  /* metatable.__index = metatable */
+      lua_pushstring(L, ledger_llbase_tableobserver_meta);
+      lua_setfield(L, -2, "__name");  /* metatable.__name = tname */
+      /* registry.name = metatable */{
+        lua_setfield(L, LUA_REGISTRYINDEX, ledger_llbase_tableobserver_meta);
+      }
+      lua_setfield(L, -2, "observer");
+    }
     lua_pushvalue(L, -1);
     lua_pushvalue(L, -1);
     lua_setfield(L, -2, "__index");  /* metatable.__index = metatable */
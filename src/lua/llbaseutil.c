@@ -610,7 +610,7 @@ int ledger_luaL_bignum_tostring(struct lua_State *L){
   int ok;
   want_plus = lua_toboolean(L, 2);
   /* execute C API */{
-    size_t maxlen = ledger_bignum_get_text(*num, NULL, 0, want_plus);
+    size_t maxlen = ledger_bignum_text_length(*num, want_plus);
     outstr = ledger_util_malloc(maxlen+1);
     if (outstr == NULL){
       ok = 0;
@@ -0,0 +1,381 @@
+#include "../src/base/bignum.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static int add_bench(void);
+static int subtract_bench(void);
+static int add_assign_bench(void);
+static int accum_bench(void);
+static int compare_bench(void);
+static int set_text_bench(void);
+static int get_text_bench(void);
+static int parse_amounts_bench(void);
+static int format_amounts_bench(void);
+static int measure_amounts_bench(void);
+static int scale_amounts_bench(void);
+
+/*
+ * Prepare two operands for a benchmark, one short and one wide.
+ * - left number to receive the short operand
+ * - right number to receive the wide operand
+ * @return one on success, zero otherwise
+ */
+static int bench_operands
+  (struct ledger_bignum* left, struct ledger_bignum* right);
+
+/*
+ * Report the time taken by a benchmark.
+ * - start clock reading from the start of the benchmark
+ */
+static void bench_report(clock_t start);
+
+/*
+ * Report the throughput of an amount benchmark.
+ * - start clock reading from the start of the benchmark
+ */
+static void bench_report_amounts(clock_t start);
+
+struct bench_struct {
+  int (*fn)(void);
+  char const* name;
+};
+
+struct bench_struct bench_array[] = {
+  { add_bench, "add" },
+  { subtract_bench, "subtract" },
+  { add_assign_bench, "add in place" },
+  { accum_bench, "accumulate" },
+  { compare_bench, "compare" },
+  { set_text_bench, "set text" },
+  { get_text_bench, "get text" },
+  { parse_amounts_bench, "parse amounts" },
+  { format_amounts_bench, "format amounts" },
+  { measure_amounts_bench, "measure amounts" },
+  { scale_amounts_bench, "scale amounts" }
+};
+
+static int const bench_op_count = 1000000;
+
+static unsigned char const bench_short_text[] = "-1234.56";
+
+static unsigned char const bench_wide_text[] =
+  "98765432109876543210987654321.0123456789012345";
+
+/* amounts as they appear in a saved book */
+static char const* bench_amounts[] = {
+  "12.34", "-1500.00", "0.5", "1234567.89", "-0.07", "250",
+  "99999.99", "-42.125", "100000000.00", "3.14159265358979",
+  "-876543210987.65", "0.01"
+};
+
+static int const bench_amount_count =
+  sizeof(bench_amounts)/sizeof(bench_amounts[0]);
+
+int bench_operands
+  (struct ledger_bignum* left, struct ledger_bignum* right)
+{
+  if (left == NULL || right == NULL) return 0;
+  if (!ledger_bignum_set_text(left, bench_short_text, NULL)) return 0;
+  if (!ledger_bignum_set_text(right, bench_wide_text, NULL)) return 0;
+  return 1;
+}
+
+void bench_report(clock_t start){
+  clock_t const span = clock() - start;
+  printf("\n\t  %i operations: %.3f s (%.1f ns each)\n\t",
+      bench_op_count, (double)span/CLOCKS_PER_SEC,
+      (double)span/CLOCKS_PER_SEC*1e9/bench_op_count);
+  return;
+}
+
+void bench_report_amounts(clock_t start){
+  clock_t const span = clock() - start;
+  double const seconds = (double)span/CLOCKS_PER_SEC;
+  printf("\n\t  %i amounts: %.3f s (%.0f amounts per second)\n\t",
+      bench_op_count, seconds,
+      (seconds > 0.0) ? bench_op_count/seconds : 0.0);
+  return;
+}
+
+int add_bench(void){
+  int result = 0;
+  struct ledger_bignum* left = ledger_bignum_new();
+  struct ledger_bignum* right = ledger_bignum_new();
+  struct ledger_bignum* sum = ledger_bignum_new();
+  if (sum != NULL && bench_operands(left, right)) do {
+    int i;
+    clock_t const start = clock();
+    for (i = 0; i < bench_op_count; ++i){
+      if (!ledger_bignum_add(sum, (i&1) ? left : right, left)) break;
+    }
+    if (i < bench_op_count) break;
+    bench_report(start);
+    result = 1;
+  } while (0);
+  ledger_bignum_free(sum);
+  ledger_bignum_free(right);
+  ledger_bignum_free(left);
+  return result;
+}
+
+int subtract_bench(void){
+  int result = 0;
+  struct ledger_bignum* left = ledger_bignum_new();
+  struct ledger_bignum* right = ledger_bignum_new();
+  struct ledger_bignum* difference = ledger_bignum_new();
+  if (difference != NULL && bench_operands(left, right)) do {
+    int i;
+    clock_t const start = clock();
+    for (i = 0; i < bench_op_count; ++i){
+      if (!ledger_bignum_subtract(difference, (i&1) ? left : right, right))
+        break;
+    }
+    if (i < bench_op_count) break;
+    bench_report(start);
+    result = 1;
+  } while (0);
+  ledger_bignum_free(difference);
+  ledger_bignum_free(right);
+  ledger_bignum_free(left);
+  return result;
+}
+
+int add_assign_bench(void){
+  int result = 0;
+  struct ledger_bignum* left = ledger_bignum_new();
+  struct ledger_bignum* right = ledger_bignum_new();
+  struct ledger_bignum* sum = ledger_bignum_new();
+  if (sum != NULL && bench_operands(left, right)) do {
+    int i;
+    clock_t const start = clock();
+    for (i = 0; i < bench_op_count; ++i){
+      if (!ledger_bignum_add_assign(sum, (i&1) ? left : right)) break;
+    }
+    if (i < bench_op_count) break;
+    bench_report(start);
+    result = 1;
+  } while (0);
+  ledger_bignum_free(sum);
+  ledger_bignum_free(right);
+  ledger_bignum_free(left);
+  return result;
+}
+
+int accum_bench(void){
+  int result = 0;
+  struct ledger_bignum* left = ledger_bignum_new();
+  struct ledger_bignum* right = ledger_bignum_new();
+  struct ledger_bignum* sum = ledger_bignum_new();
+  struct ledger_bignum_accum* accum = ledger_bignum_accum_new();
+  if (sum != NULL && accum != NULL && bench_operands(left, right)) do {
+    int i;
+    clock_t const start = clock();
+    for (i = 0; i < bench_op_count; ++i){
+      if (!ledger_bignum_accum_add(accum, (i&1) ? left : right)) break;
+    }
+    if (i < bench_op_count) break;
+    if (!ledger_bignum_accum_get(accum, sum)) break;
+    bench_report(start);
+    result = 1;
+  } while (0);
+  ledger_bignum_accum_free(accum);
+  ledger_bignum_free(sum);
+  ledger_bignum_free(right);
+  ledger_bignum_free(left);
+  return result;
+}
+
+int compare_bench(void){
+  int result = 0;
+  struct ledger_bignum* left = ledger_bignum_new();
+  struct ledger_bignum* right = ledger_bignum_new();
+  if (bench_operands(left, right)) do {
+    int i;
+    int total = 0;
+    clock_t const start = clock();
+    /* compare numbers of one sign, so that the digits are read */
+    ledger_bignum_negate(left, left);
+    for (i = 0; i < bench_op_count; ++i){
+      total += ledger_bignum_compare((i&1) ? left : right, right);
+    }
+    if (total != -bench_op_count/2) break;
+    bench_report(start);
+    result = 1;
+  } while (0);
+  ledger_bignum_free(right);
+  ledger_bignum_free(left);
+  return result;
+}
+
+int set_text_bench(void){
+  int result = 0;
+  struct ledger_bignum* n = ledger_bignum_new();
+  if (n != NULL) do {
+    int i;
+    clock_t const start = clock();
+    for (i = 0; i < bench_op_count; ++i){
+      if (!ledger_bignum_set_text
+          (n, (i&1) ? bench_short_text : bench_wide_text, NULL))
+        break;
+    }
+    if (i < bench_op_count) break;
+    bench_report(start);
+    result = 1;
+  } while (0);
+  ledger_bignum_free(n);
+  return result;
+}
+
+int get_text_bench(void){
+  int result = 0;
+  struct ledger_bignum* left = ledger_bignum_new();
+  struct ledger_bignum* right = ledger_bignum_new();
+  if (bench_operands(left, right)) do {
+    int i;
+    unsigned char buf[64];
+    clock_t const start = clock();
+    for (i = 0; i < bench_op_count; ++i){
+      if (ledger_bignum_get_text((i&1) ? left : right, buf, sizeof(buf), 0)
+          >= (int)sizeof(buf))
+        break;
+    }
+    if (i < bench_op_count) break;
+    bench_report(start);
+    result = 1;
+  } while (0);
+  ledger_bignum_free(right);
+  ledger_bignum_free(left);
+  return result;
+}
+
+
+int parse_amounts_bench(void){
+  int result = 0;
+  struct ledger_bignum* n = ledger_bignum_new();
+  if (n != NULL) do {
+    int i;
+    long long int total = 0;
+    clock_t const start = clock();
+    for (i = 0; i < bench_op_count; ++i){
+      unsigned char const* const text =
+        (unsigned char const*)bench_amounts[i%bench_amount_count];
+      long long int value;
+      int point_place;
+      /* as a table takes an amount: fixed-point first */
+      if (ledger_bignum_fixed_from_text(text, &value, &point_place)){
+        total += value;
+      } else if (!ledger_bignum_set_text(n, text, NULL)){
+        break;
+      }
+    }
+    if (i < bench_op_count) break;
+    bench_report_amounts(start);
+    result = (total != 0);
+  } while (0);
+  ledger_bignum_free(n);
+  return result;
+}
+
+int format_amounts_bench(void){
+  long long int values[sizeof(bench_amounts)/sizeof(bench_amounts[0])];
+  int places[sizeof(bench_amounts)/sizeof(bench_amounts[0])];
+  int i;
+  unsigned char buf[64];
+  clock_t start;
+  for (i = 0; i < bench_amount_count; ++i){
+    if (!ledger_bignum_fixed_from_text
+        ((unsigned char const*)bench_amounts[i], values+i, places+i))
+      return 0;
+  }
+  start = clock();
+  for (i = 0; i < bench_op_count; ++i){
+    int const j = i%bench_amount_count;
+    if (ledger_bignum_fixed_to_text(values[j], places[j], buf, sizeof(buf), 0)
+        >= (int)sizeof(buf))
+      break;
+  }
+  if (i < bench_op_count) return 0;
+  bench_report_amounts(start);
+  return 1;
+}
+
+int measure_amounts_bench(void){
+  long long int values[sizeof(bench_amounts)/sizeof(bench_amounts[0])];
+  int places[sizeof(bench_amounts)/sizeof(bench_amounts[0])];
+  int i;
+  long int total = 0;
+  clock_t start;
+  for (i = 0; i < bench_amount_count; ++i){
+    if (!ledger_bignum_fixed_from_text
+        ((unsigned char const*)bench_amounts[i], values+i, places+i))
+      return 0;
+  }
+  start = clock();
+  for (i = 0; i < bench_op_count; ++i){
+    int const j = i%bench_amount_count;
+    total += ledger_bignum_fixed_text_length(values[j], places[j], 0);
+  }
+  if (total <= 0) return 0;
+  bench_report_amounts(start);
+  return 1;
+}
+
+int scale_amounts_bench(void){
+  long long int values[sizeof(bench_amounts)/sizeof(bench_amounts[0])];
+  int places[sizeof(bench_amounts)/sizeof(bench_amounts[0])];
+  int result = 0;
+  struct ledger_bignum* numerator = ledger_bignum_new();
+  struct ledger_bignum* denominator = ledger_bignum_new();
+  struct ledger_bignum_rate* rate = ledger_bignum_rate_new();
+  if (numerator != NULL && denominator != NULL && rate != NULL) do {
+    int i;
+    long long int total = 0;
+    clock_t start;
+    for (i = 0; i < bench_amount_count; ++i){
+      if (!ledger_bignum_fixed_from_text
+          ((unsigned char const*)bench_amounts[i], values+i, places+i))
+        break;
+    }
+    if (i < bench_amount_count) break;
+    /* an exchange rate quoted to five places */
+    if (!ledger_bignum_set_text
+        (numerator, (unsigned char const*)"1.08251", NULL))
+      break;
+    if (!ledger_bignum_set_long(denominator, 1)) break;
+    if (!ledger_bignum_rate_set(rate, numerator, denominator, 1)) break;
+    start = clock();
+    for (i = 0; i < bench_op_count; ++i){
+      int const j = i%bench_amount_count;
+      long long int value = values[j];
+      int point_place = places[j];
+      if (!ledger_bignum_rate_apply_fixed(rate, &value, &point_place))
+        break;
+      total += value;
+    }
+    if (i < bench_op_count) break;
+    bench_report_amounts(start);
+    result = (total != 0);
+  } while (0);
+  ledger_bignum_rate_free(rate);
+  ledger_bignum_free(denominator);
+  ledger_bignum_free(numerator);
+  return result;
+}
+
+
+int main(int argc, char **argv){
+  int pass_count = 0;
+  int const bench_count = sizeof(bench_array)/sizeof(bench_array[0]);
+  int i;
+  printf("Running %i benchmarks...\n", bench_count);
+  for (i = 0; i < bench_count; ++i){
+    int pass_value;
+    printf("\t%s... ", bench_array[i].name);
+    pass_value = ((*bench_array[i].fn)())?1:0;
+    printf("%s\n",pass_value==0?"FAILED":"DONE");
+    pass_count += pass_value;
+  }
+  printf("...%i out of %i benchmarks completed.\n", pass_count, bench_count);
+  return pass_count==bench_count?EXIT_SUCCESS:EXIT_FAILURE;
+}
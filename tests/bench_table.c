@@ -0,0 +1,215 @@
+
+#include "../src/base/table.h"
+#include "../src/base/util.h"
+#include "../src/base/bignum.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static int alloc_linked_bench(void);
+static int alloc_columnar_bench(void);
+static int scan_linked_bench(void);
+static int scan_columnar_bench(void);
+static int held_scan_linked_bench(void);
+static int held_scan_columnar_bench(void);
+
+/*
+ * Load a table with rows resembling a journal, then free it,
+ * reporting the heap allocations made along the way.
+ * - t the table to load
+ * @return one on success, zero otherwise
+ */
+static int alloc_bench_run(struct ledger_table* t);
+
+/*
+ * Load a table with rows resembling a journal, then walk it with a
+ * mark, fetching every cell one call at a time.
+ * - t the table to load
+ * - hold_tf whether to hold the table across the load and each scan
+ * @return one on success, zero otherwise
+ */
+static int scan_bench_run(struct ledger_table* t, int hold_tf);
+
+struct bench_struct {
+  int (*fn)(void);
+  char const* name;
+};
+
+struct bench_struct bench_array[] = {
+  { alloc_linked_bench, "allocations (linked rows)" },
+  { alloc_columnar_bench, "allocations (columnar)" },
+  { scan_linked_bench, "mark scan (linked rows)" },
+  { scan_columnar_bench, "mark scan (columnar)" },
+  { held_scan_linked_bench, "mark scan, table held (linked rows)" },
+  { held_scan_columnar_bench, "mark scan, table held (columnar)" }
+};
+
+/*
+ * number of passes over the table in the scan benchmark
+ */
+static int const bench_scan_passes = 10;
+
+static int const bench_row_count = 100000;
+
+int alloc_bench_run(struct ledger_table* t){
+  int result = 0;
+  struct ledger_table_mark* mark = NULL;
+  size_t load_count, free_count;
+  clock_t load_time, free_time;
+  if (t == NULL) return 0;
+  else do {
+    int i;
+    int column_types[4] =
+      { LEDGER_TABLE_ID, LEDGER_TABLE_ID, LEDGER_TABLE_BIGNUM,
+        LEDGER_TABLE_USTR };
+    if (!ledger_table_set_column_types(t, 4, column_types)) break;
+    load_count = ledger_util_count_allocations();
+    load_time = clock();
+    mark = ledger_table_end(t);
+    if (mark == NULL) break;
+    for (i = 0; i < bench_row_count; ++i){
+      if (!ledger_table_add_row(mark)) break;
+      if (!ledger_table_put_id(mark, 0, i)) break;
+      if (!ledger_table_put_id(mark, 1, i%16)) break;
+      if (!ledger_table_put_string(mark, 2,
+          (unsigned char const*)"-1234.56"))
+        break;
+      if (!ledger_table_put_string(mark, 3,
+          (unsigned char const*)"check 1001"))
+        break;
+      ledger_table_mark_move(mark, +1);
+    }
+    if (i < bench_row_count) break;
+    ledger_table_mark_free(mark);
+    mark = NULL;
+    load_time = clock() - load_time;
+    load_count = ledger_util_count_allocations() - load_count;
+    free_count = ledger_util_count_allocations();
+    free_time = clock();
+    ledger_table_free(t);
+    t = NULL;
+    free_time = clock() - free_time;
+    free_count = ledger_util_count_allocations() - free_count;
+    printf("\n\t  %i rows: load %lu allocations, %.3f s;"
+        " free %lu allocations, %.3f s\n\t",
+        bench_row_count, (unsigned long)load_count,
+        (double)load_time/CLOCKS_PER_SEC, (unsigned long)free_count,
+        (double)free_time/CLOCKS_PER_SEC);
+    result = 1;
+  } while (0);
+  ledger_table_mark_free(mark);
+  ledger_table_free(t);
+  return result;
+}
+
+int alloc_linked_bench(void){
+  return alloc_bench_run(ledger_table_new());
+}
+
+int alloc_columnar_bench(void){
+  return alloc_bench_run(ledger_table_new_columnar());
+}
+
+int scan_bench_run(struct ledger_table* t, int hold_tf){
+  int result = 0;
+  struct ledger_table_mark* mark = NULL;
+  struct ledger_bignum* amount = ledger_bignum_new();
+  clock_t load_time, scan_time;
+  if (t == NULL || amount == NULL){
+    ledger_bignum_free(amount);
+    ledger_table_free(t);
+    return 0;
+  } else do {
+    int i = 0, pass;
+    long int check = 0;
+    int column_types[4] =
+      { LEDGER_TABLE_ID, LEDGER_TABLE_ID, LEDGER_TABLE_BIGNUM,
+        LEDGER_TABLE_USTR };
+    if (!ledger_table_set_column_types(t, 4, column_types)) break;
+    load_time = clock();
+    if (hold_tf) ledger_table_write_lock(t);
+    mark = ledger_table_end(t);
+    if (mark != NULL) for (i = 0; i < bench_row_count; ++i){
+      if (!ledger_table_add_row(mark)) break;
+      if (!ledger_table_put_id(mark, 0, i)) break;
+      if (!ledger_table_put_id(mark, 1, i%16)) break;
+      if (!ledger_table_put_string(mark, 2,
+          (unsigned char const*)"-1234.56"))
+        break;
+      if (!ledger_table_put_string(mark, 3,
+          (unsigned char const*)"check 1001"))
+        break;
+      ledger_table_mark_move(mark, +1);
+    }
+    if (hold_tf) ledger_table_write_unlock(t);
+    if (mark == NULL || i < bench_row_count) break;
+    ledger_table_mark_free(mark);
+    mark = NULL;
+    load_time = clock() - load_time;
+    scan_time = clock();
+    for (pass = 0; pass < bench_scan_passes; ++pass){
+      mark = ledger_table_begin(t);
+      if (mark == NULL) break;
+      if (hold_tf) ledger_table_read_lock(t);
+      for (i = 0; i < bench_row_count; ++i){
+        unsigned char buf[16];
+        int id, journal;
+        if (!ledger_table_fetch_id(mark, 0, &id)) break;
+        if (!ledger_table_fetch_id(mark, 1, &journal)) break;
+        if (!ledger_table_fetch_bignum(mark, 2, amount)) break;
+        if (ledger_table_fetch_string(mark, 3, buf, sizeof(buf)) < 0)
+          break;
+        check += id + journal;
+        ledger_table_mark_move(mark, +1);
+      }
+      if (hold_tf) ledger_table_read_unlock(t);
+      ledger_table_mark_free(mark);
+      mark = NULL;
+      if (i < bench_row_count) break;
+    }
+    if (pass < bench_scan_passes) break;
+    scan_time = clock() - scan_time;
+    printf("\n\t  %i rows: load %.3f s; %i scans %.3f s (check %ld)\n\t",
+        bench_row_count, (double)load_time/CLOCKS_PER_SEC,
+        bench_scan_passes, (double)scan_time/CLOCKS_PER_SEC, check);
+    result = 1;
+  } while (0);
+  ledger_table_mark_free(mark);
+  ledger_bignum_free(amount);
+  ledger_table_free(t);
+  return result;
+}
+
+int scan_linked_bench(void){
+  return scan_bench_run(ledger_table_new(), 0);
+}
+
+int scan_columnar_bench(void){
+  return scan_bench_run(ledger_table_new_columnar(), 0);
+}
+
+int held_scan_linked_bench(void){
+  return scan_bench_run(ledger_table_new(), 1);
+}
+
+int held_scan_columnar_bench(void){
+  return scan_bench_run(ledger_table_new_columnar(), 1);
+}
+
+
+
+int main(int argc, char **argv){
+  int pass_count = 0;
+  int const bench_count = sizeof(bench_array)/sizeof(bench_array[0]);
+  int i;
+  printf("Running %i benchmarks...\n", bench_count);
+  for (i = 0; i < bench_count; ++i){
+    int pass_value;
+    printf("\t%s... ", bench_array[i].name);
+    pass_value = ((*bench_array[i].fn)())?1:0;
+    printf("%s\n",pass_value==0?"FAILED":"DONE");
+    pass_count += pass_value;
+  }
+  printf("...%i out of %i benchmarks completed.\n", pass_count, bench_count);
+  return pass_count==bench_count?EXIT_SUCCESS:EXIT_FAILURE;
+}
@@ -0,0 +1,294 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#  define _POSIX_C_SOURCE 200809L
+#endif /*_POSIX_C_SOURCE*/
+#include "../src/base/table.h"
+#include "../src/base/bignum.h"
+#include "../src/base/util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <pthread.h>
+#  include <time.h>
+#  include <unistd.h>
+#endif /*_WIN32*/
+
+#ifdef _WIN32
+typedef HANDLE bench_thread;
+#  define BENCH_THREAD_FN(name) DWORD WINAPI name(LPVOID arg)
+#  define BENCH_THREAD_RETURN return 0
+#else
+typedef pthread_t bench_thread;
+#  define BENCH_THREAD_FN(name) void* name(void* arg)
+#  define BENCH_THREAD_RETURN return NULL
+#endif /*_WIN32*/
+
+/*
+ * maximum number of reader threads
+ */
+#define BENCH_THREAD_MAX 8
+
+static int scaling_bench(void);
+static int held_scaling_bench(void);
+
+/*
+ * Start a thread.
+ * - th thread handle to fill
+ * - fn thread function
+ * - arg argument for the thread function
+ * @return one on success, zero otherwise
+ */
+static int bench_thread_start
+  ( bench_thread* th,
+#ifdef _WIN32
+    LPTHREAD_START_ROUTINE fn,
+#else
+    void* (*fn)(void*),
+#endif /*_WIN32*/
+    void* arg);
+
+/*
+ * Wait for a thread to finish.
+ * - th the thread to wait on
+ */
+static void bench_thread_join(bench_thread th);
+
+/*
+ * Read a monotonic clock.
+ * @return a time in seconds
+ */
+static double bench_thread_clock(void);
+
+/*
+ * Query the number of processors available.
+ * @return a processor count, at least one
+ */
+static int bench_thread_cpu_count(void);
+
+/*
+ * Time readers walking the same table row by row, first one reader
+ * alone, then more at once, and report the throughput gained.
+ * - hold_tf whether each reader holds the table for a whole walk
+ * @return one on success, zero otherwise
+ */
+static int scaling_bench_run(int hold_tf);
+
+struct bench_struct {
+  int (*fn)(void);
+  char const* name;
+};
+
+struct bench_struct bench_array[] = {
+  { scaling_bench, "reader scaling (row fetches)" },
+  { held_scaling_bench, "reader scaling (row fetches, table held)" }
+};
+
+/*
+ * State of one scaling reader
+ */
+struct scaling_arg {
+  struct ledger_table const* table;
+  int hold_tf;
+  int failures;
+};
+
+static int const bench_row_count = 20000;
+static int const bench_rounds = 20;
+
+
+int bench_thread_start
+  ( bench_thread* th,
+#ifdef _WIN32
+    LPTHREAD_START_ROUTINE fn,
+#else
+    void* (*fn)(void*),
+#endif /*_WIN32*/
+    void* arg)
+{
+#ifdef _WIN32
+  *th = CreateThread(NULL, 0, fn, arg, 0, NULL);
+  return *th != NULL;
+#else
+  return pthread_create(th, NULL, fn, arg) == 0;
+#endif /*_WIN32*/
+}
+
+void bench_thread_join(bench_thread th){
+#ifdef _WIN32
+  WaitForSingleObject(th, INFINITE);
+  CloseHandle(th);
+#else
+  pthread_join(th, NULL);
+#endif /*_WIN32*/
+  return;
+}
+
+double bench_thread_clock(void){
+#ifdef _WIN32
+  LARGE_INTEGER count, frequency;
+  QueryPerformanceCounter(&count);
+  QueryPerformanceFrequency(&frequency);
+  return (double)count.QuadPart/(double)frequency.QuadPart;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + ts.tv_nsec*1e-9;
+#endif /*_WIN32*/
+}
+
+int bench_thread_cpu_count(void){
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+  long const n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (int)n : 1;
+#endif /*_WIN32*/
+}
+
+static BENCH_THREAD_FN(scaling_main){
+  struct scaling_arg* const reader = (struct scaling_arg*)arg;
+  struct ledger_table const* const t = reader->table;
+  struct ledger_bignum* amount = ledger_bignum_new();
+  int round;
+  if (amount == NULL){
+    reader->failures += 1;
+  } else for (round = 0; round < bench_rounds; ++round){
+    struct ledger_table_mark* mark;
+    struct ledger_table_mark* end;
+    long int total = 0;
+    if (reader->hold_tf) ledger_table_read_lock(t);
+    mark = ledger_table_begin_c(t);
+    end = ledger_table_end_c(t);
+    if (mark == NULL || end == NULL){
+      reader->failures += 1;
+    } else while (!ledger_table_mark_is_equal(mark, end)){
+      int id;
+      if (ledger_table_fetch_id(mark, 0, &id) != 1
+      ||  ledger_table_fetch_bignum(mark, 1, amount) != 1)
+      {
+        reader->failures += 1;
+        break;
+      }
+      total += ledger_bignum_get_long(amount);
+      ledger_table_mark_move(mark, +1);
+    }
+    ledger_table_mark_free(end);
+    ledger_table_mark_free(mark);
+    if (reader->hold_tf) ledger_table_read_unlock(t);
+    if (total != bench_row_count) reader->failures += 1;
+  }
+  ledger_bignum_free(amount);
+  BENCH_THREAD_RETURN;
+}
+
+/*
+ * Time several readers walking the same table at once.
+ * - t the table to read
+ * - n number of reader threads
+ * - hold_tf whether each reader holds the table for a whole walk
+ * - seconds time taken by the readers
+ * @return one on success, zero otherwise
+ */
+static int scaling_bench_time
+  (struct ledger_table const* t, int n, int hold_tf, double* seconds)
+{
+  struct scaling_arg args[BENCH_THREAD_MAX];
+  bench_thread readers[BENCH_THREAD_MAX];
+  int started;
+  int i;
+  int ok = 1;
+  double start_time = bench_thread_clock();
+  for (started = 0; started < n; ++started){
+    args[started].table = t;
+    args[started].hold_tf = hold_tf;
+    args[started].failures = 0;
+    if (!bench_thread_start(readers+started, scaling_main, args+started))
+      break;
+  }
+  for (i = 0; i < started; ++i){
+    bench_thread_join(readers[i]);
+    if (args[i].failures != 0) ok = 0;
+  }
+  *seconds = bench_thread_clock() - start_time;
+  return ok && started == n;
+}
+
+int scaling_bench_run(int hold_tf){
+  int result = 0;
+  struct ledger_table* t = ledger_table_new_columnar();
+  struct ledger_bignum* one = ledger_bignum_new();
+  struct ledger_table_mark* mark = NULL;
+  if (t == NULL || one == NULL){
+    ledger_bignum_free(one);
+    ledger_table_free(t);
+    return 0;
+  } else do {
+    int column_types[2] = { LEDGER_TABLE_ID, LEDGER_TABLE_BIGNUM };
+    int const cpus = bench_thread_cpu_count();
+    double single_time;
+    int i, n;
+    if (!ledger_table_set_column_types(t, 2, column_types)) break;
+    if (!ledger_bignum_set_long(one, 1)) break;
+    mark = ledger_table_end(t);
+    if (mark == NULL) break;
+    for (i = 0; i < bench_row_count; ++i){
+      struct ledger_table_field fields[2];
+      memset(fields, 0, sizeof(fields));
+      fields[0].column = 0;
+      fields[0].type = LEDGER_TABLE_ID;
+      fields[0].id = i;
+      fields[1].column = 1;
+      fields[1].type = LEDGER_TABLE_BIGNUM;
+      fields[1].bignum = one;
+      if (!ledger_table_append_rows(mark, 1, 2, fields)) break;
+    }
+    if (i < bench_row_count) break;
+    if (!scaling_bench_time(t, 1, hold_tf, &single_time)) break;
+    printf("\n\t  processors: %i; 1 reader: %.3f s\n\t",
+        cpus, single_time);
+    for (n = 2; n <= BENCH_THREAD_MAX && n <= 2*cpus; n *= 2){
+      double multi_time;
+      if (!scaling_bench_time(t, n, hold_tf, &multi_time)) break;
+      /* `n` times the work in `multi_time` */
+      printf("  %i readers: %.3f s, %.2fx the single-reader throughput\n\t",
+          n, multi_time, (n*single_time)/multi_time);
+    }
+    if (n <= BENCH_THREAD_MAX && n <= 2*cpus) break;
+    result = 1;
+  } while (0);
+  ledger_table_mark_free(mark);
+  ledger_bignum_free(one);
+  ledger_table_free(t);
+  return result;
+}
+
+int scaling_bench(void){
+  return scaling_bench_run(0);
+}
+
+int held_scaling_bench(void){
+  return scaling_bench_run(1);
+}
+
+
+
+int main(int argc, char **argv){
+  int pass_count = 0;
+  int const bench_count = sizeof(bench_array)/sizeof(bench_array[0]);
+  int i;
+  printf("Running %i benchmarks...\n", bench_count);
+  for (i = 0; i < bench_count; ++i){
+    int pass_value;
+    printf("\t%s... ", bench_array[i].name);
+    fflush(stdout);
+    pass_value = ((*bench_array[i].fn)())?1:0;
+    printf("%s\n",pass_value==0?"FAILED":"DONE");
+    pass_count += pass_value;
+  }
+  printf("...%i out of %i benchmarks completed.\n", pass_count, bench_count);
+  return pass_count==bench_count?EXIT_SUCCESS:EXIT_FAILURE;
+}
@@ -58,7 +58,7 @@ int allocate_table_test(void){
       if (ledger_table_get_column_type(table,1) != 1) break;
       if (ledger_table_get_column_type(table,2) != 2) break;
       if (ledger_table_get_column_type(table,3) != 3) break;
-      if (ledger_table_get_column_type(table,4) != 3) break;
+      if (ledger_table_get_column_type(table,4) != LEDGER_TABLE_DATE) break;
     }
     result = 1;
   } while (0);
@@ -88,7 +88,7 @@ int acquire_table_test(void){
       if (ledger_table_get_column_type(table,1) != 1) break;
       if (ledger_table_get_column_type(table,2) != 2) break;
       if (ledger_table_get_column_type(table,3) != 3) break;
-      if (ledger_table_get_column_type(table,4) != 3) break;
+      if (ledger_table_get_column_type(table,4) != LEDGER_TABLE_DATE) break;
       ledger_table_free(table);
     }
     result = 1;
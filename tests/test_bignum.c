@@ -32,6 +32,13 @@ static int subtract_implicit_test(void);
 static int set_dot_text_test(void);
 static int set_nan_text_test(void);
 static int ninety_nine_test(void);
+static int fixed_point_test(void);
+static int assign_arithmetic_test(void);
+static int accum_test(void);
+static int text_length_test(void);
+static int round_test(void);
+static int multiply_ratio_test(void);
+static int rate_test(void);
 
 struct test_struct {
   int (*fn)(void);
@@ -64,7 +71,14 @@ struct test_struct test_array[] = {
   { subtract_implicit_test, "subtract implicit" },
   { set_dot_text_test, "set text starting with a dot" },
   { set_nan_text_test, "set non-numeric text" },
-  { ninety_nine_test, "ninety-nine" }
+  { ninety_nine_test, "ninety-nine" },
+  { fixed_point_test, "fixed point" },
+  { assign_arithmetic_test, "add and subtract in place" },
+  { accum_test, "accumulator" },
+  { text_length_test, "text length" },
+  { round_test, "round" },
+  { multiply_ratio_test, "multiply by ratio" },
+  { rate_test, "rate" }
 };
 
 
@@ -989,6 +1003,533 @@ int ninety_nine_test(void){
 }
 
 
+int fixed_point_test(void){
+  int result = 0;
+  struct ledger_bignum* ptr, * other_ptr;
+  static char const* fit_texts[] = {
+    "0", "5", "099.99", "-45.61", "0.5", ".5", "1.", "+7.125",
+    "123456789012345678", "-0.00000000000000001", "12abc",
+    "0000000000000000000000012.5", "-0.000000000000000000000000000001",
+    "9999999999999999.99"
+  };
+  static char const* unfit_texts[] = {
+    "1234567890123456789", "-0", "-0.00", "", "-", "text",
+    "1.000000000000000000", "99999999999999999.9", ".", "-.", "+"
+  };
+  ptr = ledger_bignum_new();
+  if (ptr == NULL) return 0;
+  other_ptr = ledger_bignum_new();
+  if (other_ptr == NULL){
+    ledger_bignum_free(ptr);
+    return 0;
+  }
+  do {
+    int i;
+    long long int value, other_value;
+    int point_place, other_point_place;
+    unsigned char buf[48], other_buf[48];
+    /* numbers that fit */
+    for (i = 0; i < (int)(sizeof(fit_texts)/sizeof(fit_texts[0])); ++i){
+      unsigned char const* const text = (unsigned char const*)fit_texts[i];
+      if (!ledger_bignum_fixed_from_text(text, &value, &point_place))
+        break;
+      ledger_bignum_free(ptr);
+      ptr = ledger_bignum_new();
+      if (ptr == NULL) break;
+      if (!ledger_bignum_set_text(ptr, text, NULL)) break;
+      if (!ledger_bignum_get_fixed(ptr, &other_value, &other_point_place))
+        break;
+      if (value != other_value || point_place != other_point_place)
+        break;
+      /* text output matches */
+      if (ledger_bignum_get_text(ptr, buf, sizeof(buf), 0)
+      !=  ledger_bignum_fixed_to_text
+            (value, point_place, other_buf, sizeof(other_buf), 0))
+        break;
+      if (ledger_util_ustrcmp(buf, other_buf) != 0) break;
+      if (ledger_bignum_get_text(ptr, buf, sizeof(buf), 1)
+      !=  ledger_bignum_fixed_to_text
+            (value, point_place, other_buf, sizeof(other_buf), 1))
+        break;
+      if (ledger_util_ustrcmp(buf, other_buf) != 0) break;
+      /* truncated text output matches */
+      ledger_bignum_get_text(ptr, buf, 3, 0);
+      ledger_bignum_fixed_to_text(value, point_place, other_buf, 3, 0);
+      if (ledger_util_ustrcmp(buf, other_buf) != 0) break;
+      /* round trip */
+      ledger_bignum_free(other_ptr);
+      other_ptr = ledger_bignum_new();
+      if (other_ptr == NULL) break;
+      if (!ledger_bignum_set_fixed(other_ptr, value, point_place)) break;
+      if (ledger_bignum_compare(ptr, other_ptr) != 0) break;
+      if (ledger_bignum_find_point(other_ptr) != point_place) break;
+    }
+    if (i < (int)(sizeof(fit_texts)/sizeof(fit_texts[0]))) break;
+    /* numbers that do not fit */
+    for (i = 0; i < (int)(sizeof(unfit_texts)/sizeof(unfit_texts[0])); ++i){
+      unsigned char const* const text =
+        (unsigned char const*)unfit_texts[i];
+      if (ledger_bignum_fixed_from_text(text, &value, &point_place))
+        break;
+      if (*text != 0 && text[1] == '0'){
+        if (!ledger_bignum_set_text(ptr, text, NULL)) break;
+        if (ledger_bignum_get_fixed(ptr, &value, &point_place)) break;
+      }
+    }
+    if (i < (int)(sizeof(unfit_texts)/sizeof(unfit_texts[0]))) break;
+    /* assignment keeps extra centesimal places */{
+      if (!ledger_bignum_set_text
+          (other_ptr, (unsigned char const*)"1.2345", NULL))
+        break;
+      if (!ledger_bignum_set_fixed(other_ptr, -5, 0)) break;
+      if (ledger_bignum_get_text(other_ptr, buf, sizeof(buf), 0) != 7)
+        break;
+      if (ledger_util_ustrcmp(buf, (unsigned char const*)"-5.0000") != 0)
+        break;
+    }
+    result = 1;
+  } while (0);
+  ledger_bignum_free(ptr);
+  ledger_bignum_free(other_ptr);
+  return result;
+}
+
+int assign_arithmetic_test(void){
+  int result = 0;
+  struct ledger_bignum* a, * b, * c;
+  a = ledger_bignum_new();
+  if (a == NULL) return 0;
+  b = ledger_bignum_new();
+  if (b == NULL){
+    ledger_bignum_free(a);
+    return 0;
+  }
+  c = ledger_bignum_new();
+  if (c == NULL){
+    ledger_bignum_free(a);
+    ledger_bignum_free(b);
+    return 0;
+  }
+  do {
+    static char const* pairs[][2] = {
+      { "93.45", "20.78" },
+      { "5", "0.125" },
+      { "+40.12", "-200" },
+      { "-0.01", "0.01" },
+      { "999999999999999999.99", "0.01" },
+      { "99999999999999999", "1" },
+      { "123456789012345678901234567890.5", "-0.0000000000000000001" },
+      { "-7", "-12345678901234567890" }
+    };
+    int const pair_count = sizeof(pairs)/sizeof(pairs[0]);
+    int i, j;
+    unsigned char buf[80], other_buf[80];
+    for (i = 0; i < pair_count*2; ++i){
+      int const negative = i%2;
+      /* compare against the allocating forms */
+      if (!ledger_bignum_set_text
+          (a,(unsigned char const*)pairs[i/2][0],NULL))
+        break;
+      if (!ledger_bignum_set_text
+          (b,(unsigned char const*)pairs[i/2][1],NULL))
+        break;
+      if (negative){
+        if (!ledger_bignum_subtract(c,a,b)) break;
+        if (!ledger_bignum_subtract_assign(a,b)) break;
+      } else {
+        if (!ledger_bignum_add(c,a,b)) break;
+        if (!ledger_bignum_add_assign(a,b)) break;
+      }
+      if (ledger_bignum_compare(a,c) != 0) break;
+      if (ledger_bignum_count_digits(a) != ledger_bignum_count_digits(c))
+        break;
+      if (ledger_bignum_find_point(a) != ledger_bignum_find_point(c))
+        break;
+      ledger_bignum_get_text(a,buf,sizeof(buf),0);
+      ledger_bignum_get_text(c,other_buf,sizeof(other_buf),0);
+      if (ledger_util_ustrcmp(buf,other_buf) != 0) break;
+    }
+    if (i < pair_count*2) break;
+    /* add a number to itself */
+    if (!ledger_bignum_alloc(a,0,0)) break;
+    if (!ledger_bignum_set_text(a,(unsigned char const*)"-60.5",NULL))
+      break;
+    if (!ledger_bignum_add_assign(a,a)) break;
+    if (ledger_bignum_get_text(a,buf,sizeof(buf),0) != 7) break;
+    if (ledger_util_ustrcmp(buf,(unsigned char const*)"-121.00") != 0)
+      break;
+    if (!ledger_bignum_subtract_assign(a,a)) break;
+    if (ledger_bignum_get_long(a) != 0) break;
+    /* accumulate without allocating */{
+      size_t alloc_count;
+      if (!ledger_bignum_alloc(b,0,0)) break;
+      if (!ledger_bignum_set_text
+          (b,(unsigned char const*)"12.34",NULL))
+        break;
+      if (!ledger_bignum_alloc(a,6,1)) break;
+      alloc_count = ledger_util_count_allocations();
+      for (j = 0; j < 1000; ++j){
+        if (!ledger_bignum_add_assign(a,b)) break;
+        if (j%3 == 0 && !ledger_bignum_subtract_assign(a,b)) break;
+      }
+      if (j < 1000) break;
+      if (ledger_util_count_allocations() != alloc_count) break;
+      if (ledger_bignum_get_text(a,buf,sizeof(buf),0) != 7) break;
+      if (ledger_util_ustrcmp(buf,(unsigned char const*)"8218.44") != 0)
+        break;
+    }
+    result = 1;
+  } while (0);
+  ledger_bignum_free(c);
+  ledger_bignum_free(b);
+  ledger_bignum_free(a);
+  return result;
+}
+
+int accum_test(void){
+  int result = 0;
+  struct ledger_bignum* a, * b;
+  struct ledger_bignum_accum* accum;
+  a = ledger_bignum_new();
+  if (a == NULL) return 0;
+  b = ledger_bignum_new();
+  if (b == NULL){
+    ledger_bignum_free(a);
+    return 0;
+  }
+  accum = ledger_bignum_accum_new();
+  if (accum == NULL){
+    ledger_bignum_free(a);
+    ledger_bignum_free(b);
+    return 0;
+  }
+  do {
+    static char const* addends[] = {
+      "93.45", "-20.78", "5", "0.125", "-200",
+      "999999999999999999.99", "-0.0000000000000000001",
+      "123456789012345678901234567890.5", "-12345678901234567890",
+      "0.01", "-999999999999999999999999999999"
+    };
+    int const addend_count = sizeof(addends)/sizeof(addends[0]);
+    int i;
+    unsigned char buf[80], other_buf[80];
+    /* compare against a running sum after each addend */
+    if (!ledger_bignum_alloc(a,0,0)) break;
+    for (i = 0; i < addend_count; ++i){
+      if (!ledger_bignum_alloc(b,0,0)) break;
+      if (!ledger_bignum_set_text
+          (b,(unsigned char const*)addends[i],NULL))
+        break;
+      if (!ledger_bignum_add_assign(a,b)) break;
+      if (!ledger_bignum_accum_add(accum,b)) break;
+      if (!ledger_bignum_alloc(b,0,0)) break;
+      if (!ledger_bignum_accum_get(accum,b)) break;
+      if (ledger_bignum_compare(a,b) != 0) break;
+      if (ledger_bignum_find_point(a) != ledger_bignum_find_point(b))
+        break;
+      ledger_bignum_get_text(a,buf,sizeof(buf),0);
+      ledger_bignum_get_text(b,other_buf,sizeof(other_buf),0);
+      if (ledger_util_ustrcmp(buf,other_buf) != 0) break;
+    }
+    if (i < addend_count) break;
+    /* reset to zero, which reads back as positive */
+    ledger_bignum_accum_zero(accum);
+    if (!ledger_bignum_alloc(b,0,0)) break;
+    if (!ledger_bignum_set_text(b,(unsigned char const*)"-0.5",NULL))
+      break;
+    if (!ledger_bignum_accum_add(accum,b)) break;
+    if (!ledger_bignum_accum_add_fixed(accum,50,1)) break;
+    if (!ledger_bignum_alloc(a,0,0)) break;
+    if (!ledger_bignum_accum_get(accum,a)) break;
+    if (ledger_bignum_get_text(a,buf,sizeof(buf),1) != 5) break;
+    if (ledger_util_ustrcmp(buf,(unsigned char const*)"+0.00") != 0)
+      break;
+    /* carry across many wide addends */
+    ledger_bignum_accum_zero(accum);
+    for (i = 0; i < 10000; ++i){
+      if (!ledger_bignum_accum_add_fixed(accum,999999999999999999LL,1))
+        break;
+    }
+    if (i < 10000) break;
+    if (!ledger_bignum_accum_add_fixed(accum,-12345,2)) break;
+    if (!ledger_bignum_alloc(a,0,0)) break;
+    if (!ledger_bignum_accum_get(accum,a)) break;
+    ledger_bignum_get_text(a,buf,sizeof(buf),0);
+    if (ledger_util_ustrcmp
+        (buf,(unsigned char const*)"99999999999999999898.7655") != 0)
+      break;
+    result = 1;
+  } while (0);
+  ledger_bignum_accum_free(accum);
+  ledger_bignum_free(b);
+  ledger_bignum_free(a);
+  return result;
+}
+
+int text_length_test(void){
+  int result = 0;
+  struct ledger_bignum* ptr = ledger_bignum_new();
+  if (ptr == NULL) return 0;
+  else do {
+    static char const* texts[] = {
+      "0", "-7", "0.5", "-1234.56", "000123", "-00.0010",
+      "1234567890123456789012345678901234567890",
+      "-98765432109876543210.0123456789012345678901234567",
+      "0.000000000000000000000000000000000001"
+    };
+    static long long int const values[] = {
+      0, 5, -5, 123456, 999999999999999999LL, LLONG_MAX, LLONG_MIN
+    };
+    int const text_count = sizeof(texts)/sizeof(texts[0]);
+    int const value_count = sizeof(values)/sizeof(values[0]);
+    int i, j;
+    unsigned char buf[128];
+    /* big numbers, including long runs of digits */
+    for (i = 0; i < text_count*2; ++i){
+      int const want_plus = i%2;
+      int length;
+      if (!ledger_bignum_alloc(ptr,0,0)) break;
+      if (!ledger_bignum_set_text
+          (ptr,(unsigned char const*)texts[i/2],NULL))
+        break;
+      length = ledger_bignum_text_length(ptr,want_plus);
+      if (length != ledger_bignum_get_text(ptr,buf,sizeof(buf),want_plus))
+        break;
+      if (length != (int)ledger_util_ustrlen(buf)) break;
+    }
+    if (i < text_count*2) break;
+    /* digits survive the trip through the parser unchanged */
+    if (!ledger_bignum_alloc(ptr,0,0)) break;
+    if (!ledger_bignum_set_text(ptr,(unsigned char const*)texts[7],NULL))
+      break;
+    ledger_bignum_get_text(ptr,buf,sizeof(buf),0);
+    if (ledger_util_ustrcmp(buf,(unsigned char const*)
+          "-98765432109876543210.0123456789012345678901234567") != 0)
+      break;
+    /* fixed-point integers */
+    for (i = 0; i < value_count; ++i){
+      for (j = 0; j <= 12; j += 3){
+        int const length = ledger_bignum_fixed_text_length(values[i],j,0);
+        if (length != ledger_bignum_fixed_to_text
+              (values[i],j,buf,sizeof(buf),0))
+          break;
+        if (length != (int)ledger_util_ustrlen(buf)) break;
+        /* negative numbers already have a sign */
+        if (length+(values[i] >= 0) !=
+            ledger_bignum_fixed_text_length(values[i],j,1))
+          break;
+      }
+      if (j <= 12) break;
+    }
+    if (i < value_count) break;
+    if (ledger_bignum_fixed_text_length(1,-1,0) >= 0) break;
+    ledger_bignum_fixed_to_text(LLONG_MIN,3,buf,sizeof(buf),0);
+    if (ledger_util_ustrcmp(buf,(unsigned char const*)"-9223372036854.775808")
+        != 0)
+      break;
+    result = 1;
+  } while (0);
+  ledger_bignum_free(ptr);
+  return result;
+}
+
+int round_test(void){
+  int result = 0;
+  struct ledger_bignum* ptr = ledger_bignum_new();
+  if (ptr == NULL) return 0;
+  else do {
+    static struct {
+      char const* text;
+      int point_place;
+      char const* expected;
+    } const cases[] = {
+      { "2.345", 1, "2.35" },
+      { "-2.345", 1, "-2.35" },
+      { "2.3449", 1, "2.34" },
+      { "99.995", 1, "100.00" },
+      { "-0.004", 1, "0.00" },
+      { "12.5", 0, "13" },
+      { "0.5", 0, "1" },
+      { "0.49", 0, "0" },
+      { "1.5", 3, "1.500000" },
+      { "999999999999999999.999999999999999999", 8,
+        "1000000000000000000.0000000000000000" }
+    };
+    int const case_count = sizeof(cases)/sizeof(cases[0]);
+    int i;
+    unsigned char buf[80];
+    for (i = 0; i < case_count; ++i){
+      if (!ledger_bignum_alloc(ptr,0,0)) break;
+      if (!ledger_bignum_set_text
+          (ptr,(unsigned char const*)cases[i].text,NULL))
+        break;
+      if (!ledger_bignum_round(ptr,ptr,cases[i].point_place)) break;
+      if (ledger_bignum_find_point(ptr) != cases[i].point_place) break;
+      ledger_bignum_get_text(ptr,buf,sizeof(buf),0);
+      if (ledger_util_ustrcmp
+          (buf,(unsigned char const*)cases[i].expected) != 0)
+        break;
+    }
+    if (i < case_count) break;
+    if (ledger_bignum_round(ptr,ptr,-1)) break;
+    result = 1;
+  } while (0);
+  ledger_bignum_free(ptr);
+  return result;
+}
+
+int multiply_ratio_test(void){
+  int result = 0;
+  struct ledger_bignum* ptr = ledger_bignum_new();
+  struct ledger_bignum* numerator = ledger_bignum_new();
+  struct ledger_bignum* denominator = ledger_bignum_new();
+  if (ptr != NULL && numerator != NULL && denominator != NULL) do {
+    static struct {
+      char const* text;
+      char const* numerator;
+      char const* denominator;
+      int point_place;
+      char const* expected;
+    } const cases[] = {
+      { "100", "1", "3", 2, "33.3333" },
+      { "2", "1", "3", 1, "0.67" },
+      { "-2", "1", "3", 1, "-0.67" },
+      { "1", "1", "8", 1, "0.13" },
+      { "-1", "1", "8", 1, "-0.13" },
+      { "0.05", "1", "10", 1, "0.01" },
+      { "10", "-3", "-4", 0, "8" },
+      { "0", "5", "7", 1, "0.00" },
+      { "123.45", "1.0825", "1", 1, "133.63" },
+      { "1234567.89", "0.91234", "1", 1, "1126345.67" },
+      { "123456789012345678901234567890.12", "1.5", "1", 1,
+        "185185183518518518351851851835.18" },
+      { "999999999999999999", "1000000", "1", 0,
+        "999999999999999999000000" },
+      { "1", "1", "123456789012345678901234567", 20,
+        "0.0000000000000000000000000081000000729000" },
+      { "-98765432109876543210.5", "7", "0.0003", 3,
+        "-2304526749230452674911666.666667" }
+    };
+    int const case_count = sizeof(cases)/sizeof(cases[0]);
+    int i;
+    unsigned char buf[80];
+    for (i = 0; i < case_count; ++i){
+      if (!ledger_bignum_alloc(ptr,0,0)) break;
+      if (!ledger_bignum_alloc(numerator,0,0)) break;
+      if (!ledger_bignum_alloc(denominator,0,0)) break;
+      if (!ledger_bignum_set_text
+          (ptr,(unsigned char const*)cases[i].text,NULL))
+        break;
+      if (!ledger_bignum_set_text
+          (numerator,(unsigned char const*)cases[i].numerator,NULL))
+        break;
+      if (!ledger_bignum_set_text
+          (denominator,(unsigned char const*)cases[i].denominator,NULL))
+        break;
+      if (!ledger_bignum_multiply_ratio
+          (ptr,ptr,numerator,denominator,cases[i].point_place))
+        break;
+      if (ledger_bignum_find_point(ptr) != cases[i].point_place) break;
+      ledger_bignum_get_text(ptr,buf,sizeof(buf),0);
+      if (ledger_util_ustrcmp
+          (buf,(unsigned char const*)cases[i].expected) != 0)
+        break;
+    }
+    if (i < case_count) break;
+    /* a zero denominator has no ratio */
+    if (!ledger_bignum_set_long(denominator,0)) break;
+    if (ledger_bignum_multiply_ratio(ptr,ptr,numerator,denominator,1))
+      break;
+    result = 1;
+  } while (0);
+  ledger_bignum_free(denominator);
+  ledger_bignum_free(numerator);
+  ledger_bignum_free(ptr);
+  return result;
+}
+
+int rate_test(void){
+  int result = 0;
+  struct ledger_bignum* ptr = ledger_bignum_new();
+  struct ledger_bignum* other = ledger_bignum_new();
+  struct ledger_bignum* numerator = ledger_bignum_new();
+  struct ledger_bignum* denominator = ledger_bignum_new();
+  struct ledger_bignum_rate* rate = ledger_bignum_rate_new();
+  if (ptr != NULL && other != NULL && numerator != NULL
+  &&  denominator != NULL && rate != NULL) do {
+    static char const* rates[][2] = {
+      { "1.0825", "1" }, { "1", "7" }, { "-0.91234", "1.0003" },
+      { "123456789.123456789", "0.0001" }
+    };
+    static long long int const values[] = {
+      0, 1, -1, 50, -50, 12345, -999999, 999999999999999999LL,
+      LLONG_MIN
+    };
+    int const rate_count = sizeof(rates)/sizeof(rates[0]);
+    int const value_count = sizeof(values)/sizeof(values[0]);
+    int i, j;
+    long long int value;
+    int point_place;
+    unsigned char buf[80], other_buf[80];
+    /* a fresh rate is one */
+    value = 12350;
+    point_place = 1;
+    if (!ledger_bignum_rate_apply_fixed(rate,&value,&point_place)) break;
+    if (value != 124 || point_place != 0) break;
+    /* fixed-point and big products agree */
+    for (i = 0; i < rate_count; ++i){
+      if (!ledger_bignum_set_text
+          (numerator,(unsigned char const*)rates[i][0],NULL))
+        break;
+      if (!ledger_bignum_set_text
+          (denominator,(unsigned char const*)rates[i][1],NULL))
+        break;
+      if (!ledger_bignum_rate_set(rate,numerator,denominator,1)) break;
+      for (j = 0; j < value_count; ++j){
+        if (!ledger_bignum_alloc(ptr,0,0)) break;
+        if (!ledger_bignum_set_fixed(ptr,values[j],2)) break;
+        if (!ledger_bignum_multiply_ratio
+            (other,ptr,numerator,denominator,1))
+          break;
+        if (!ledger_bignum_rate_apply(rate,ptr,ptr)) break;
+        if (ledger_bignum_compare(ptr,other) != 0) break;
+        if (ledger_bignum_find_point(ptr) != 1) break;
+        value = values[j];
+        point_place = 2;
+        if (ledger_bignum_rate_apply_fixed(rate,&value,&point_place)){
+          if (point_place != 1) break;
+          if (!ledger_bignum_set_fixed(other,value,point_place)) break;
+          if (ledger_bignum_compare(ptr,other) != 0) break;
+        } else {
+          /* the product must be too wide, and nothing changes */
+          if (value != values[j] || point_place != 2) break;
+          ledger_bignum_get_text(ptr,buf,sizeof(buf),0);
+          if (ledger_util_ustrlen(buf) <= 20) break;
+        }
+        ledger_bignum_get_text(ptr,buf,sizeof(buf),0);
+        ledger_bignum_get_text(other,other_buf,sizeof(other_buf),0);
+        if (ledger_util_ustrcmp(buf,other_buf) != 0) break;
+      }
+      if (j < value_count) break;
+    }
+    if (i < rate_count) break;
+    /* a zero denominator leaves the rate alone */
+    if (!ledger_bignum_set_long(denominator,0)) break;
+    if (ledger_bignum_rate_set(rate,numerator,denominator,1)) break;
+    value = 1;
+    point_place = 0;
+    if (!ledger_bignum_rate_apply_fixed(rate,&value,&point_place)) break;
+    if (value != 123456789123457LL || point_place != 1) break;
+    result = 1;
+  } while (0);
+  ledger_bignum_rate_free(rate);
+  ledger_bignum_free(denominator);
+  ledger_bignum_free(numerator);
+  ledger_bignum_free(other);
+  ledger_bignum_free(ptr);
+  return result;
+}
+
 int main(int argc, char **argv){
   int pass_count = 0;
   int const test_count = sizeof(test_array)/sizeof(test_array[0]);
@@ -7,6 +7,9 @@
 #include "../src/base/ledger.h"
 #include "../src/base/util.h"
 #include "../src/base/journal.h"
+#include "../src/base/account.h"
+#include "../src/base/entry.h"
+#include "../src/base/table.h"
 
 static int allocate_test(void);
 static int acquire_ref_test(void);
@@ -23,6 +26,13 @@ static int new_ledger_resize_test(void);
 static int new_ledger_equal_test(void);
 static int new_journal_resize_test(void);
 static int new_journal_equal_test(void);
+static int snapshot_test(void);
+static int snapshot_release_test(void);
+static void snapshot_observer_count
+  ( void* arg, int event, struct ledger_table_mark const* mark,
+    int row, int column);
+static int snapshot_observer_test(void);
+static int intern_strings_test(void);
 
 struct test_struct {
   int (*fn)(void);
@@ -43,7 +53,11 @@ struct test_struct test_array[] = {
   { resume_alloc_id_test, "resume_alloc_id" },
   { new_ledger_resize_test, "ledger resize" },
   { new_journal_equal_test, "journal equal" },
-  { new_journal_resize_test, "journal resize" }
+  { new_journal_resize_test, "journal resize" },
+  { snapshot_test, "snapshot" },
+  { snapshot_release_test, "snapshot release" },
+  { snapshot_observer_test, "snapshot observers" },
+  { intern_strings_test, "intern strings" }
 };
 
 
@@ -575,6 +589,228 @@ int new_journal_equal_test(void){
 
 
 
+int snapshot_test(void){
+  int result = 0;
+  struct ledger_book* ptr;
+  struct ledger_book* snap = NULL;
+  ptr = ledger_book_new();
+  if (ptr == NULL) return 0;
+  else do {
+    struct ledger_table* table;
+    struct ledger_table_mark* mark;
+    struct ledger_ledger const* snap_ledger;
+    int ok;
+    if (!ledger_book_set_ledger_count(ptr,1)) break;
+    if (!ledger_book_set_journal_count(ptr,1)) break;
+    if (!ledger_ledger_set_account_count(ledger_book_get_ledger(ptr,0),2))
+      break;
+    if (!ledger_journal_set_entry_count(ledger_book_get_journal(ptr,0),2))
+      break;
+    /* put a row in the first account */
+    table = ledger_account_get_table
+        (ledger_ledger_get_account(ledger_book_get_ledger(ptr,0),0));
+    mark = ledger_table_end(table);
+    if (mark == NULL) break;
+    ok = ledger_table_add_row(mark)
+      && ledger_table_put_string(mark, 2, (unsigned char const*)"12.50");
+    ledger_table_mark_free(mark);
+    if (!ok) break;
+    /* take the snapshot */
+    snap = ledger_book_snapshot(ptr);
+    if (snap == NULL) break;
+    if (!ledger_book_is_equal(ptr, snap)) break;
+    if (ledger_book_get_ledger_c(ptr,0) != ledger_book_get_ledger_c(snap,0))
+      break;
+    /* change the book */
+    table = ledger_account_get_table
+        (ledger_ledger_get_account(ledger_book_get_ledger(ptr,0),0));
+    if (table == NULL) break;
+    mark = ledger_table_end(table);
+    if (mark == NULL) break;
+    ok = ledger_table_add_row(mark)
+      && ledger_table_put_string(mark, 2, (unsigned char const*)"-3");
+    ledger_table_mark_free(mark);
+    if (!ok) break;
+    if (!ledger_entry_set_name
+        ( ledger_journal_get_entry(ledger_book_get_journal(ptr,0),1),
+          (unsigned char const*)"changed"))
+      break;
+    if (ledger_book_is_equal(ptr, snap)) break;
+    /* the snapshot keeps the old state */
+    snap_ledger = ledger_book_get_ledger_c(snap,0);
+    if (ledger_table_count_rows(ledger_account_get_table_c
+          (ledger_ledger_get_account_c(snap_ledger,0))) != 1)
+      break;
+    if (ledger_table_count_rows(ledger_account_get_table_c
+          (ledger_ledger_get_account_c(ledger_book_get_ledger_c(ptr,0),0)))
+        != 2)
+      break;
+    if (ledger_entry_get_name(ledger_journal_get_entry_c
+          (ledger_book_get_journal_c(snap,0),1)) != NULL)
+      break;
+    /* untouched parts stay shared */
+    if (ledger_account_get_table_c(ledger_ledger_get_account_c(snap_ledger,1))
+    !=  ledger_account_get_table_c(ledger_ledger_get_account_c
+          (ledger_book_get_ledger_c(ptr,0),1)))
+      break;
+    if (ledger_journal_get_table_c(ledger_book_get_journal_c(snap,0))
+    !=  ledger_journal_get_table_c(ledger_book_get_journal_c(ptr,0)))
+      break;
+    /* the snapshot outlives the book */
+    ledger_book_free(ptr);
+    ptr = NULL;
+    if (ledger_table_count_rows(ledger_account_get_table_c
+          (ledger_ledger_get_account_c(snap_ledger,0))) != 1)
+      break;
+    result = 1;
+  } while (0);
+  ledger_book_free(snap);
+  ledger_book_free(ptr);
+  return result;
+}
+
+int snapshot_release_test(void){
+  int result = 0;
+  struct ledger_book* ptr;
+  ptr = ledger_book_new();
+  if (ptr == NULL) return 0;
+  else do {
+    struct ledger_book* snap;
+    struct ledger_ledger* ledger;
+    struct ledger_table* table;
+    if (!ledger_book_set_ledger_count(ptr,1)) break;
+    if (!ledger_ledger_set_account_count(ledger_book_get_ledger(ptr,0),1))
+      break;
+    ledger = ledger_book_get_ledger(ptr,0);
+    table = ledger_account_get_table(ledger_ledger_get_account(ledger,0));
+    snap = ledger_book_snapshot(ptr);
+    if (snap == NULL) break;
+    ledger_book_free(snap);
+    /* with the snapshot gone, nothing gets copied */
+    if (ledger_book_get_ledger(ptr,0) != ledger) break;
+    if (ledger_account_get_table(ledger_ledger_get_account(ledger,0))
+        != table)
+      break;
+    result = 1;
+  } while (0);
+  ledger_book_free(ptr);
+  return result;
+}
+void snapshot_observer_count
+  ( void* arg, int event, struct ledger_table_mark const* mark,
+    int row, int column)
+{
+  (void)event;
+  (void)mark;
+  (void)row;
+  (void)column;
+  *(int*)arg += 1;
+  return;
+}
+
+int snapshot_observer_test(void){
+  int result = 0;
+  struct ledger_book* ptr;
+  struct ledger_book* snap = NULL;
+  ptr = ledger_book_new();
+  if (ptr == NULL) return 0;
+  else do {
+    struct ledger_table* table;
+    struct ledger_table* copy;
+    struct ledger_table_mark* mark;
+    int hits = 0;
+    int ok;
+    if (!ledger_book_set_ledger_count(ptr,1)) break;
+    if (!ledger_ledger_set_account_count(ledger_book_get_ledger(ptr,0),1))
+      break;
+    table = ledger_account_get_table
+        (ledger_ledger_get_account(ledger_book_get_ledger(ptr,0),0));
+    if (table == NULL) break;
+    if (!ledger_table_add_observer(table, snapshot_observer_count, &hits))
+      break;
+    snap = ledger_book_snapshot(ptr);
+    if (snap == NULL) break;
+    /* the book's private copy keeps the observer */
+    copy = ledger_account_get_table
+        (ledger_ledger_get_account(ledger_book_get_ledger(ptr,0),0));
+    if (copy == NULL || copy == table) break;
+    mark = ledger_table_end(copy);
+    if (mark == NULL) break;
+    ok = ledger_table_add_row(mark)
+      && ledger_table_put_string(mark, 2, (unsigned char const*)"1");
+    ledger_table_mark_free(mark);
+    if (!ok) break;
+    if (hits != 2) break;
+    /* dropping through the table first observed reaches the copy */
+    if (!ledger_table_drop_observer(table, snapshot_observer_count, &hits))
+      break;
+    mark = ledger_table_end(copy);
+    if (mark == NULL) break;
+    ok = ledger_table_add_row(mark);
+    ledger_table_mark_free(mark);
+    if (!ok) break;
+    if (hits != 2) break;
+    result = 1;
+  } while (0);
+  ledger_book_free(snap);
+  ledger_book_free(ptr);
+  return result;
+}
+
+int intern_strings_test(void){
+  int result = 0;
+  struct ledger_book* ptr;
+  struct ledger_book* snap = NULL;
+  ptr = ledger_book_new();
+  if (ptr == NULL) return 0;
+  else do {
+    unsigned char const* const check =
+      (unsigned char const*)"check number 0001234";
+    struct ledger_table_pool* pool;
+    int i;
+    if (ledger_book_get_string_pool(ptr) != NULL) break;
+    if (!ledger_book_set_ledger_count(ptr,1)) break;
+    if (!ledger_book_set_journal_count(ptr,1)) break;
+    if (!ledger_ledger_set_account_count(ledger_book_get_ledger(ptr,0),2))
+      break;
+    if (!ledger_book_intern_strings(ptr)) break;
+    pool = ledger_book_get_string_pool(ptr);
+    if (pool == NULL) break;
+    /* the same check number in every table */
+    for (i = 0; i < 3; ++i){
+      struct ledger_table* const table = (i < 2)
+        ? ledger_account_get_table
+            (ledger_ledger_get_account(ledger_book_get_ledger(ptr,0),i))
+        : ledger_journal_get_table(ledger_book_get_journal(ptr,0));
+      struct ledger_table_mark* mark;
+      int ok;
+      if (ledger_table_get_pool(table) != pool) break;
+      mark = ledger_table_end(table);
+      if (mark == NULL) break;
+      ok = ledger_table_add_row(mark)
+        && ledger_table_put_string(mark, (i < 2) ? 3 : 4, check);
+      ledger_table_mark_free(mark);
+      if (!ok) break;
+    }
+    if (i < 3) break;
+    if (ledger_table_pool_count(pool) != 1) break;
+    /* snapshots share the pool */
+    snap = ledger_book_snapshot(ptr);
+    if (snap == NULL) break;
+    if (ledger_book_get_string_pool(snap) != pool) break;
+    if (!ledger_book_is_equal(ptr, snap)) break;
+    /* calling again is harmless */
+    if (!ledger_book_intern_strings(ptr)) break;
+    if (ledger_book_get_string_pool(ptr) != pool) break;
+    if (ledger_table_pool_count(pool) != 1) break;
+    result = 1;
+  } while (0);
+  ledger_book_free(snap);
+  ledger_book_free(ptr);
+  return result;
+}
+
+
 int main(int argc, char **argv){
   int pass_count = 0;
   int const test_count = sizeof(test_array)/sizeof(test_array[0]);
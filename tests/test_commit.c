@@ -17,6 +17,7 @@
 static int zero_commit_test(void);
 static int nonzero_commit_test(void);
 static int nonzero_balance_test(void);
+static int free_date_commit_test(void);
 
 
 struct test_struct {
@@ -27,7 +28,8 @@ struct test_struct {
 struct test_struct test_array[] = {
   { zero_commit_test, "commit empty transaction" },
   { nonzero_commit_test, "commit non-empty transaction" },
-  { nonzero_balance_test, "balance non-empty transaction" }
+  { nonzero_balance_test, "balance non-empty transaction" },
+  { free_date_commit_test, "commit transaction with a free-form date" }
 };
 
 int zero_commit_test(void){
@@ -288,6 +290,117 @@ int nonzero_commit_test(void){
   return result;
 }
 
+int free_date_commit_test(void){
+  int result = 0;
+  struct ledger_transaction* transaction;
+  struct ledger_book* book;
+  transaction = ledger_transaction_new();
+  if (transaction == NULL){
+    return 0;
+  }
+  book = ledger_book_new();
+  if (book == NULL){
+    ledger_transaction_free(transaction);
+    return 0;
+  } else do {
+    int ok;
+    int i;
+    static char const* free_dates[] = {
+      "2018-11-19 06:54", "11/19/2018", "today", "2018-02-30"
+    };
+    int const free_date_count = sizeof(free_dates)/sizeof(free_dates[0]);
+    /* prepare the book */{
+      struct ledger_ledger* ledger;
+      ok = ledger_book_set_journal_count(book, 1);
+      if (!ok) break;
+      ok = ledger_book_set_ledger_count(book, 1);
+      if (!ok) break;
+      ledger = ledger_book_get_ledger(book, 0);
+      if (ledger == NULL) break;
+      ok = ledger_ledger_set_account_count(ledger, 2);
+      if (!ok) break;
+    }
+    /* prepare the transaction */{
+      struct ledger_table *const table =
+          ledger_transaction_get_table(transaction);
+      struct ledger_table_mark *const mark =
+          ledger_table_begin(table);
+      if (mark == NULL) break;
+      else do {
+        ledger_transaction_set_journal(transaction, 0);
+        ok = ledger_table_add_row(mark);
+        if (!ok) break;
+        ok = ledger_table_put_string(mark, 2,
+                      (unsigned char const*)"/ledger@0/account@0");
+        if (!ok) break;
+        ok = ledger_table_put_string(mark, 3,
+                      (unsigned char const*)"12.34");
+        if (!ok) break;
+        ledger_table_mark_move(mark, +1);
+        ok = ledger_table_add_row(mark);
+        if (!ok) break;
+        ok = ledger_table_put_string(mark, 2,
+                      (unsigned char const*)"/ledger@0/account@1");
+        if (!ok) break;
+        ok = ledger_table_put_string(mark, 3,
+                      (unsigned char const*)"-12.34");
+        if (!ok) break;
+      } while (0);
+      ledger_table_mark_free(mark);
+    }
+    if (!ok) break;
+    /* dates that do not parse are kept as text */
+    for (i = 0; i < free_date_count; ++i){
+      ok = ledger_transaction_set_date
+        (transaction, (unsigned char const*)free_dates[i]);
+      if (!ok) break;
+      if (!ledger_commit_transaction(book, transaction)) break;
+    }
+    if (i < free_date_count) break;
+    /* a good date or no date at all still commits */
+    ok = ledger_transaction_set_date
+      (transaction, (unsigned char const*)"2018-11-19T06:54");
+    if (!ok) break;
+    if (!ledger_commit_transaction(book, transaction)) break;
+    ok = ledger_transaction_set_date(transaction, NULL);
+    if (!ok) break;
+    if (!ledger_commit_transaction(book, transaction)) break;
+    /* inspect the book */{
+      struct ledger_journal const* journal =
+        ledger_book_get_journal_c(book, 0);
+      struct ledger_ledger const* ledger =
+        ledger_book_get_ledger_c(book, 0);
+      struct ledger_table const* table;
+      struct ledger_table_mark* mark;
+      if (journal == NULL || ledger == NULL) break;
+      if (ledger_journal_get_entry_count(journal) != free_date_count+2)
+        break;
+      if (ledger_table_count_rows(ledger_journal_get_table_c(journal))
+          != 2*(free_date_count+2))
+        break;
+      table = ledger_account_get_table_c
+        (ledger_ledger_get_account_c(ledger, 0));
+      if (ledger_table_count_rows(table) != free_date_count+2)
+        break;
+      mark = ledger_table_begin_c(table);
+      if (mark == NULL) break;
+      for (i = 0; i < free_date_count; ++i){
+        unsigned char buf[32];
+        int const len = ledger_table_fetch_string(mark, 4, buf, sizeof(buf));
+        if (len != (int)strlen(free_dates[i])) break;
+        if (strcmp((char const*)buf, free_dates[i]) != 0) break;
+        ledger_table_mark_move(mark, +1);
+      }
+      ledger_table_mark_free(mark);
+      if (i < free_date_count) break;
+    }
+    result = 1;
+  } while (0);
+  ledger_transaction_free(transaction);
+  ledger_book_free(book);
+  return result;
+}
+
 int nonzero_balance_test(void){
   int result = 0;
   struct ledger_transaction* transaction;
@@ -17,6 +17,10 @@ static int find_account_name_test(void);
 static int find_account_id_test(void);
 static int find_entry_name_test(void);
 static int find_entry_id_test(void);
+static int find_book_index_test(void);
+static int find_account_index_test(void);
+static int find_entry_index_test(void);
+static int find_snapshot_index_test(void);
 
 struct test_struct {
   int (*fn)(void);
@@ -30,7 +34,11 @@ struct test_struct test_array[] = {
   { find_account_name_test, "find account by name" },
   { find_account_id_test, "find account by identifier" },
   { find_entry_name_test, "find entry by name" },
-  { find_entry_id_test, "find entry by identifier" }
+  { find_entry_id_test, "find entry by identifier" },
+  { find_book_index_test, "find ledgers and journals in a large book" },
+  { find_account_index_test, "find accounts in a large ledger" },
+  { find_entry_index_test, "find entries in a large journal" },
+  { find_snapshot_index_test, "find items renamed in a snapshot" }
 };
 
 
@@ -476,6 +484,313 @@ int find_entry_id_test(void){
   return result;
 }
 
+int find_book_index_test(void){
+  int result = 0;
+  struct ledger_book* ptr;
+  ptr = ledger_book_new();
+  if (ptr == NULL) return 0;
+  else do {
+    int i, pass;
+    char buf[32];
+    if (!ledger_book_set_ledger_count(ptr,100)) break;
+    if (!ledger_book_set_journal_count(ptr,100)) break;
+    for (i = 0; i < 100; ++i){
+      struct ledger_ledger* new_ledger = ledger_book_get_ledger(ptr,i);
+      struct ledger_journal* new_journal = ledger_book_get_journal(ptr,i);
+      if (new_ledger == NULL || new_journal == NULL) break;
+      sprintf(buf, "ledger%i", i);
+      if (!ledger_ledger_set_name(new_ledger, (unsigned char const*)buf))
+        break;
+      sprintf(buf, "journal%i", i);
+      if (!ledger_journal_set_name(new_journal, (unsigned char const*)buf))
+        break;
+    }
+    if (i < 100) break;
+    /* lookups after the first use the lookup index */
+    for (pass = 0; pass < 3; ++pass){
+      for (i = 0; i < 100; ++i){
+        if (ledger_find_ledger_by_id(ptr, i) != i) break;
+        if (ledger_find_journal_by_id(ptr, i+100) != i) break;
+        sprintf(buf, "ledger%i", i);
+        if (ledger_find_ledger_by_name(ptr, (unsigned char const*)buf) != i)
+          break;
+        sprintf(buf, "journal%i", i);
+        if (ledger_find_journal_by_name(ptr, (unsigned char const*)buf) != i)
+          break;
+      }
+      if (i < 100) break;
+      if (ledger_find_ledger_by_id(ptr, 100) != -1) break;
+      if (ledger_find_journal_by_id(ptr, 99) != -1) break;
+      if (ledger_find_ledger_by_name(ptr, (unsigned char const*)"journal1")
+          != -1)
+        break;
+    }
+    if (pass < 3) break;
+    /* renames show up right away */{
+      struct ledger_journal* new_journal = ledger_book_get_journal(ptr,7);
+      if (new_journal == NULL) break;
+      if (!ledger_journal_set_name
+          (new_journal, (unsigned char const*)"journal70"))
+        break;
+      ledger_journal_set_id(new_journal, 500);
+    }
+    for (pass = 0; pass < 3; ++pass){
+      if (ledger_find_journal_by_name(ptr, (unsigned char const*)"journal70")
+          != 7)
+        break;
+      if (ledger_find_journal_by_name(ptr, (unsigned char const*)"journal7")
+          != -1)
+        break;
+      if (ledger_find_journal_by_id(ptr, 500) != 7) break;
+      if (ledger_find_journal_by_id(ptr, 107) != -1) break;
+      if (ledger_find_ledger_by_id(ptr, 7) != 7) break;
+    }
+    if (pass < 3) break;
+    result = 1;
+  } while (0);
+  ledger_book_free(ptr);
+  return result;
+}
+
+int find_account_index_test(void){
+  int result = 0;
+  struct ledger_ledger* ptr;
+  ptr = ledger_ledger_new();
+  if (ptr == NULL) return 0;
+  else do {
+    int i, pass;
+    char buf[32];
+    if (!ledger_ledger_set_account_count(ptr,200)) break;
+    for (i = 0; i < 200; ++i){
+      struct ledger_account* new_account = ledger_ledger_get_account(ptr,i);
+      if (new_account == NULL) break;
+      /* account 150 repeats the name of account 50 */
+      sprintf(buf, "account%i", i == 150 ? 50 : i);
+      if (!ledger_account_set_name(new_account, (unsigned char const*)buf))
+        break;
+    }
+    if (i < 200) break;
+    for (pass = 0; pass < 3; ++pass){
+      for (i = 0; i < 200; ++i){
+        if (ledger_find_account_by_id(ptr, i) != i) break;
+        if (i == 150) continue;
+        sprintf(buf, "account%i", i);
+        if (ledger_find_account_by_name(ptr, (unsigned char const*)buf) != i)
+          break;
+      }
+      if (i < 200) break;
+      if (ledger_find_account_by_id(ptr, 200) != -1) break;
+      if (ledger_find_account_by_id(ptr, -1) != -1) break;
+      if (ledger_find_account_by_name(ptr, (unsigned char const*)"account150")
+          != -1)
+        break;
+      if (ledger_find_account_by_name(ptr, NULL) != -1) break;
+    }
+    if (pass < 3) break;
+    /* the first of two equal names wins, even after a rename */{
+      struct ledger_account* new_account = ledger_ledger_get_account(ptr,10);
+      if (new_account == NULL) break;
+      if (!ledger_account_set_name
+          (new_account, (unsigned char const*)"account50"))
+        break;
+    }
+    for (pass = 0; pass < 3; ++pass){
+      if (ledger_find_account_by_name(ptr, (unsigned char const*)"account50")
+          != 10)
+        break;
+      if (ledger_find_account_by_name(ptr, (unsigned char const*)"account10")
+          != -1)
+        break;
+    }
+    if (pass < 3) break;
+    /* identifier changes */{
+      struct ledger_account* new_account = ledger_ledger_get_account(ptr,10);
+      if (new_account == NULL) break;
+      ledger_account_set_id(new_account, 1000);
+    }
+    for (pass = 0; pass < 3; ++pass){
+      if (ledger_find_account_by_id(ptr, 1000) != 10) break;
+      if (ledger_find_account_by_id(ptr, 10) != -1) break;
+    }
+    if (pass < 3) break;
+    /* resizing */
+    if (!ledger_ledger_set_account_count(ptr,100)) break;
+    for (pass = 0; pass < 3; ++pass){
+      if (ledger_find_account_by_id(ptr, 150) != -1) break;
+      if (ledger_find_account_by_id(ptr, 99) != 99) break;
+      if (ledger_find_account_by_name(ptr, (unsigned char const*)"account50")
+          != 10)
+        break;
+    }
+    if (pass < 3) break;
+    if (!ledger_ledger_set_account_count(ptr,120)) break;
+    for (pass = 0; pass < 3; ++pass){
+      if (ledger_find_account_by_id(ptr, 205) != 105) break;
+      if (ledger_find_account_by_id(ptr, 150) != -1) break;
+    }
+    if (pass < 3) break;
+    result = 1;
+  } while (0);
+  ledger_ledger_free(ptr);
+  return result;
+}
+
+int find_entry_index_test(void){
+  int result = 0;
+  struct ledger_journal* ptr;
+  ptr = ledger_journal_new();
+  if (ptr == NULL) return 0;
+  else do {
+    int i, pass;
+    char buf[32];
+    if (!ledger_journal_set_sequence(ptr, 1000)) break;
+    if (!ledger_journal_set_entry_count(ptr,500)) break;
+    for (i = 0; i < 500; ++i){
+      struct ledger_entry* new_entry = ledger_journal_get_entry(ptr,i);
+      if (new_entry == NULL) break;
+      sprintf(buf, "entry%i", i);
+      if (!ledger_entry_set_name(new_entry, (unsigned char const*)buf))
+        break;
+    }
+    if (i < 500) break;
+    for (pass = 0; pass < 3; ++pass){
+      for (i = 0; i < 500; ++i){
+        if (ledger_find_entry_by_id(ptr, i+1000) != i) break;
+        sprintf(buf, "entry%i", i);
+        if (ledger_find_entry_by_name(ptr, (unsigned char const*)buf) != i)
+          break;
+      }
+      if (i < 500) break;
+      if (ledger_find_entry_by_id(ptr, 999) != -1) break;
+      if (ledger_find_entry_by_id(ptr, 1500) != -1) break;
+    }
+    if (pass < 3) break;
+    /* identifiers changed in place */
+    for (i = 0; i < 500; i += 2){
+      struct ledger_entry* new_entry = ledger_journal_get_entry(ptr,i);
+      if (new_entry == NULL) break;
+      ledger_entry_set_id(new_entry, i+5000);
+    }
+    if (i < 500) break;
+    for (pass = 0; pass < 3; ++pass){
+      for (i = 0; i < 500; ++i){
+        int const item_id = (i%2 == 0) ? i+5000 : i+1000;
+        if (ledger_find_entry_by_id(ptr, item_id) != i) break;
+      }
+      if (i < 500) break;
+      if (ledger_find_entry_by_id(ptr, 1000) != -1) break;
+    }
+    if (pass < 3) break;
+    result = 1;
+  } while (0);
+  ledger_journal_free(ptr);
+  return result;
+}
+
+int find_snapshot_index_test(void){
+  int result = 0;
+  struct ledger_book* ptr;
+  struct ledger_book* snap = NULL;
+  ptr = ledger_book_new();
+  if (ptr == NULL) return 0;
+  else do {
+    int i, j, pass;
+    char buf[32];
+    if (!ledger_book_set_ledger_count(ptr,20)) break;
+    for (i = 0; i < 20; ++i){
+      struct ledger_ledger* new_ledger = ledger_book_get_ledger(ptr,i);
+      if (new_ledger == NULL) break;
+      sprintf(buf, "ledger%i", i);
+      if (!ledger_ledger_set_name(new_ledger, (unsigned char const*)buf))
+        break;
+      if (!ledger_ledger_set_account_count(new_ledger,20)) break;
+      for (j = 0; j < 20; ++j){
+        struct ledger_account* new_account =
+          ledger_ledger_get_account(new_ledger,j);
+        if (new_account == NULL) break;
+        sprintf(buf, "account%i", j);
+        if (!ledger_account_set_name(new_account, (unsigned char const*)buf))
+          break;
+      }
+      if (j < 20) break;
+    }
+    if (i < 20) break;
+    snap = ledger_book_snapshot(ptr);
+    if (snap == NULL) break;
+    /* build the lookup indices on both sides */
+    for (pass = 0; pass < 3; ++pass){
+      struct ledger_ledger const* ledger = ledger_book_get_ledger_c(snap,3);
+      if (ledger_find_ledger_by_name(ptr, (unsigned char const*)"ledger3")
+          != 3)
+        break;
+      if (ledger_find_ledger_by_name(snap, (unsigned char const*)"ledger3")
+          != 3)
+        break;
+      if (ledger_find_account_by_name
+            (ledger, (unsigned char const*)"account5") != 5)
+        break;
+    }
+    if (pass < 3) break;
+    /* rename through the snapshot's private copies */{
+      struct ledger_ledger* new_ledger = ledger_book_get_ledger(snap,3);
+      struct ledger_account* new_account;
+      if (new_ledger == NULL) break;
+      if (!ledger_ledger_set_name(new_ledger, (unsigned char const*)"moved"))
+        break;
+      /* let the private copy build its own account index */
+      for (pass = 0; pass < 3; ++pass){
+        if (ledger_find_account_by_name
+              (new_ledger, (unsigned char const*)"account5") != 5)
+          break;
+      }
+      if (pass < 3) break;
+      new_account = ledger_ledger_get_account(new_ledger,5);
+      if (new_account == NULL) break;
+      if (!ledger_account_set_name(new_account, (unsigned char const*)"moved"))
+        break;
+    }
+    /* resize an unrelated ledger in the book */{
+      struct ledger_ledger* new_ledger = ledger_book_get_ledger(ptr,4);
+      if (new_ledger == NULL) break;
+      if (!ledger_ledger_set_account_count(new_ledger,21)) break;
+    }
+    for (pass = 0; pass < 3; ++pass){
+      struct ledger_ledger const* ledger = ledger_book_get_ledger_c(snap,3);
+      struct ledger_ledger const* old_ledger =
+        ledger_book_get_ledger_c(ptr,3);
+      if (ledger_find_ledger_by_name(snap, (unsigned char const*)"moved")
+          != 3)
+        break;
+      if (ledger_find_ledger_by_name(snap, (unsigned char const*)"ledger3")
+          != -1)
+        break;
+      if (ledger_find_ledger_by_name(ptr, (unsigned char const*)"moved")
+          != -1)
+        break;
+      if (ledger_find_ledger_by_name(ptr, (unsigned char const*)"ledger3")
+          != 3)
+        break;
+      if (ledger_find_account_by_name(ledger, (unsigned char const*)"moved")
+          != 5)
+        break;
+      if (ledger_find_account_by_name
+            (ledger, (unsigned char const*)"account5") != -1)
+        break;
+      if (ledger_find_account_by_name
+            (old_ledger, (unsigned char const*)"account5") != 5)
+        break;
+      if (ledger_find_account_by_name
+            (old_ledger, (unsigned char const*)"moved") != -1)
+        break;
+    }
+    if (pass < 3) break;
+    result = 1;
+  } while (0);
+  ledger_book_free(snap);
+  ledger_book_free(ptr);
+  return result;
+}
+
 
 
 
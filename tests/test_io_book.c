@@ -4,6 +4,7 @@
 #include "../src/base/account.h"
 #include "../src/base/journal.h"
 #include "../src/base/entry.h"
+#include "../src/base/table.h"
 #include "../src/io/book.h"
 #include <stdio.h>
 #include <string.h>
@@ -17,6 +18,7 @@ static int io_write_account_test(char const* );
 static int account_journal_test(char const* );
 static int account_journal_entry_test(char const* );
 static int persist_sequence_test(char const* );
+static int free_date_test(char const* );
 
 struct test_struct {
   int (*fn)(char const* );
@@ -31,7 +33,8 @@ struct test_struct test_array[] = {
   { io_write_journal_test, "journal writing" },
   { account_journal_test, "account and journal writing" },
   { account_journal_entry_test, "account and journal entry writing" },
-  { persist_sequence_test, "sequence number persistence" }
+  { persist_sequence_test, "sequence number persistence" },
+  { free_date_test, "account lines with free-form dates" }
 };
 
 
@@ -767,8 +770,74 @@ int persist_sequence_test(char const* fn){
   return result;
 }
 
-
-
+int free_date_test(char const* fn){
+  int result = 0;
+  struct ledger_book* book, * back_book;
+  static char const* dates[3] =
+    { "19 Nov 2018", "2018-11-20", "11/21/2018" };
+  back_book = ledger_book_new();
+  if (back_book == NULL) return 0;
+  book = ledger_book_new();
+  if (book == NULL){
+    ledger_book_free(back_book);
+    return 0;
+  } else do {
+    int ok;
+    int j;
+    ok = ledger_book_set_ledger_count(book, 1);
+    if (!ok) break;
+    /* encounter the account */do {
+      struct ledger_ledger* ledger;
+      struct ledger_table_mark* mark;
+      ok = 0;
+      ledger = ledger_book_get_ledger(book,0);
+      if (ledger == NULL) break;
+      if (!ledger_ledger_set_account_count(ledger, 1)) break;
+      mark = ledger_table_begin
+        (ledger_account_get_table(ledger_ledger_get_account(ledger,0)));
+      if (mark == NULL) break;
+      for (j = 0; j < 3; ++j){
+        if (!ledger_table_add_row(mark)) break;
+        if (!ledger_table_put_id(mark, 0, 0)) break;
+        if (!ledger_table_put_id(mark, 1, j)) break;
+        if (!ledger_table_put_string(mark, 4, (unsigned char const*)dates[j]))
+          break;
+        ledger_table_mark_move(mark, +1);
+      }
+      ledger_table_mark_free(mark);
+      ok = (j == 3);
+    } while (0);
+    if (!ok) break;
+    ok = ledger_io_book_write(fn,book);
+    if (!ok) break;
+    ok = ledger_io_book_read(fn,back_book);
+    if (!ok) break;
+    if (!ledger_book_is_equal(back_book,book)) break;
+    /* check the dates */{
+      struct ledger_table_mark* mark;
+      struct ledger_ledger const* back_ledger =
+        ledger_book_get_ledger_c(back_book, 0);
+      if (back_ledger == NULL) break;
+      mark = ledger_table_begin_c(ledger_account_get_table_c
+        (ledger_ledger_get_account_c(back_ledger,0)));
+      if (mark == NULL) break;
+      for (j = 0; j < 3; ++j){
+        unsigned char buf[32];
+        if (ledger_table_fetch_string(mark, 4, buf, sizeof(buf))
+            != (int)strlen(dates[j]))
+          break;
+        if (strcmp((char const*)buf, dates[j]) != 0) break;
+        ledger_table_mark_move(mark, +1);
+      }
+      ledger_table_mark_free(mark);
+      if (j < 3) break;
+    }
+    result = 1;
+  } while (0);
+  ledger_book_free(book);
+  ledger_book_free(back_book);
+  return result;
+}
 
 int main(int argc, char **argv){
   int pass_count = 0;
@@ -9,6 +9,8 @@
 static int io_table_zero_test(char const* );
 static int io_table_nonzero_test(char const* );
 static int io_table_bigquote_test(char const* );
+static int io_table_many_rows_test(char const* );
+static int io_table_date_test(char const* );
 
 struct test_struct {
   int (*fn)(char const* );
@@ -18,7 +20,9 @@ struct test_struct {
 struct test_struct test_array[] = {
   { io_table_zero_test, "i/o table zero" },
   { io_table_nonzero_test, "i/o table nonzero" },
-  { io_table_bigquote_test, "i/o table with quotes" }
+  { io_table_bigquote_test, "i/o table with quotes" },
+  { io_table_many_rows_test, "i/o table with many rows" },
+  { io_table_date_test, "i/o table with dates" }
 };
 
 
@@ -173,6 +177,131 @@ int io_table_bigquote_test(char const* fn){
 }
 
 
+int io_table_many_rows_test(char const* fn){
+  int result = 0;
+  struct ledger_table* forward_table, * back_table;
+  back_table = ledger_table_new_columnar();
+  if (back_table == NULL) return 0;
+  forward_table = ledger_table_new();
+  if (forward_table == NULL){
+    ledger_table_free(back_table);
+    return 0;
+  } else do {
+    int ok;
+    unsigned char* full_csv_text;
+    int column_types[3] =
+      { LEDGER_TABLE_ID, LEDGER_TABLE_BIGNUM, LEDGER_TABLE_USTR };
+    int const column_count = 3;
+    /* set matched schema */{
+      if (!ledger_table_set_column_types(
+          forward_table, column_count, column_types))
+        break;
+      if (!ledger_table_set_column_types(
+          back_table, column_count, column_types))
+        break;
+    }
+    /* set rows */{
+      ok = 0;
+      struct ledger_table_mark* mark = NULL;
+      do {
+        int j;
+        int const row_count = 150;
+        mark = ledger_table_end(forward_table);
+        if (mark == NULL) break;
+        /* write the tables */{
+          for (j = 0; j < row_count; ++j){
+            if (!ledger_table_add_row(mark)) break;
+            if (!ledger_table_put_id(mark, 0, j)) break;
+            if (!ledger_table_put_id(mark, 1, j*3-100)) break;
+            if (!ledger_table_put_string(mark, 2,
+                (unsigned char*)((j%2) ? "check, \"a\"" : "")))
+              break;
+            ledger_table_mark_move(mark, +1);
+          }
+          if (j < row_count) break;
+        }
+        ok = 1;
+      } while (0);
+      ledger_table_mark_free(mark);
+    }
+    if (!ok) break;
+    full_csv_text = ledger_io_table_print_csv(forward_table);
+    if (full_csv_text == NULL) break;
+    ok = ledger_io_table_parse_csv(back_table, full_csv_text);
+    ledger_util_free(full_csv_text);
+    if (!ok) break;
+    if (!ledger_table_is_equal(back_table,forward_table)) break;
+    result = 1;
+  } while (0);
+  ledger_table_free(forward_table);
+  ledger_table_free(back_table);
+  return result;
+}
+
+int io_table_date_test(char const* fn){
+  int result = 0;
+  struct ledger_table* forward_table, * back_table;
+  static char const* dates[4] =
+    { "2021-06-30", "", "2021-07-01T08:15", "2021-07-01T08:15:30Z" };
+  back_table = ledger_table_new();
+  if (back_table == NULL) return 0;
+  forward_table = ledger_table_new_columnar();
+  if (forward_table == NULL){
+    ledger_table_free(back_table);
+    return 0;
+  } else do {
+    int ok;
+    unsigned char* full_csv_text;
+    int column_types[2] = { LEDGER_TABLE_DATE, LEDGER_TABLE_ID };
+    struct ledger_table_mark* mark = NULL;
+    if (!ledger_table_set_column_types(forward_table, 2, column_types))
+      break;
+    if (!ledger_table_set_column_types(back_table, 2, column_types))
+      break;
+    /* set rows */{
+      int j;
+      ok = 0;
+      mark = ledger_table_begin(forward_table);
+      if (mark != NULL) for (j = 0; j < 4; ++j){
+        if (!ledger_table_add_row(mark)) break;
+        if (!ledger_table_put_string(mark, 0, (unsigned char const*)dates[j]))
+          break;
+        if (!ledger_table_put_id(mark, 1, j)) break;
+        ledger_table_mark_move(mark, +1);
+        ok = (j == 3);
+      }
+      ledger_table_mark_free(mark);
+    }
+    if (!ok) break;
+    full_csv_text = ledger_io_table_print_csv(forward_table);
+    if (full_csv_text == NULL) break;
+    ok = (strstr((char const*)full_csv_text, dates[3]) != NULL);
+    if (ok) ok = ledger_io_table_parse_csv(back_table, full_csv_text);
+    ledger_util_free(full_csv_text);
+    if (!ok) break;
+    if (!ledger_table_is_equal(back_table,forward_table)) break;
+    /* a field that is not a date is kept as text */{
+      unsigned char free_csv[] = "2021-06-30,1\n2021-06-31,2\n";
+      unsigned char buf[16];
+      long long int value;
+      if (!ledger_io_table_parse_csv(back_table, free_csv)) break;
+      mark = ledger_table_begin(back_table);
+      if (mark == NULL) break;
+      /* the parse appends after the four rows already there */
+      ok = (ledger_table_mark_seek(mark, 5)
+        &&  ledger_table_fetch_string(mark, 0, buf, sizeof(buf)) == 10
+        &&  strcmp((char const*)buf, "2021-06-31") == 0
+        &&  ledger_table_fetch_date(mark, 0, &value) && value < -1);
+      ledger_table_mark_free(mark);
+      if (!ok) break;
+    }
+    result = 1;
+  } while (0);
+  ledger_table_free(forward_table);
+  ledger_table_free(back_table);
+  return result;
+}
+
 int main(int argc, char **argv){
   int pass_count = 0;
   int const test_count = sizeof(test_array)/sizeof(test_array[0]);
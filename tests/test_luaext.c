@@ -8,6 +8,8 @@ static int allocate_test(char const* );
 static int exec_str_test(char const* );
 static int exec_lib_test(char const* );
 static int exec_ledger_test(char const* );
+static int table_observe_test(char const* );
+static int journal_entry_id_test(char const* );
 
 struct test_struct {
   int (*fn)(char const* );
@@ -18,7 +20,9 @@ struct test_struct test_array[] = {
   { allocate_test, "Lua startup" },
   { exec_str_test, "Lua execute string" },
   { exec_lib_test, "Lua execute string with libraries" },
-  { exec_ledger_test, "Lua execute string with ledger library" }
+  { exec_ledger_test, "Lua execute string with ledger library" },
+  { table_observe_test, "Lua table observers" },
+  { journal_entry_id_test, "Lua journal entries by identifier" }
 };
 
 
@@ -100,6 +104,80 @@ int exec_ledger_test(char const* name){
   return ok;
 }
 
+int table_observe_test(char const* name){
+  int ok = 0;
+  struct ledger_lua* ptr;
+  (void)name;
+  ptr = ledger_lua_new();
+  if (ptr == NULL) return 0;
+  else do {
+    unsigned char const* task_name =
+      (unsigned char const*)"table observe";
+    unsigned char const* task_text =
+      (unsigned char const*)"j = require('ledger');\n"
+      "t = j.table.create();\n"
+      "t:setcolumntypes({'id','ustr'});\n"
+      "log = {};\n"
+      "ob = t:observe(function(e, r, c)\n"
+      "  log[#log+1] = e .. ':' .. tostring(r) .. ':' .. tostring(c);\n"
+      "  if e == 'drop' then error('ignored') end;\n"
+      "end);\n"
+      "m = t:endmark();\n"
+      "m:addrow();\n"
+      "m:put(2, 'x');\n"
+      "m:droprow();\n"
+      "ob:close();\n"
+      "m = t:endmark();\n"
+      "m:addrow();\n"
+      "s = table.concat(log, ' ');\n"
+      "assert(s == 'add:1:nil put:1:2 drop:1:nil', s);\n"
+      ;
+    ok = ledger_lua_openlibs(ptr);
+    if (!ok) break;
+    ok = ledger_lua_exec_str(ptr, task_name, task_text, 0, NULL);
+    if (!ok) break;
+    ok = 1;
+  } while (0);
+  ledger_lua_close(ptr);
+  return ok;
+}
+
+int journal_entry_id_test(char const* name){
+  int ok = 0;
+  struct ledger_lua* ptr;
+  (void)name;
+  ptr = ledger_lua_new();
+  if (ptr == NULL) return 0;
+  else do {
+    unsigned char const* task_name =
+      (unsigned char const*)"journal entry id";
+    unsigned char const* task_text =
+      (unsigned char const*)"j = require('ledger');\n"
+      "n = j.journal.create();\n"
+      "n:setsequence(100);\n"
+      "assert(n:setentrycount(50));\n"
+      "for i = 1, 50 do\n"
+      "  assert(n:getentrybyid(99+i):getid() == 99+i);\n"
+      "end;\n"
+      "assert(n:getentrybyid(99) == nil);\n"
+      "assert(n:getentrybyid(150) == nil);\n"
+      "n:getentry(3):setid(7);\n"
+      "assert(n:getentrybyid(102) == nil);\n"
+      "assert(n:getentrybyid(7) == n:getentry(3));\n"
+      "assert(n:setentrycount(2));\n"
+      "assert(n:getentrybyid(7) == nil);\n"
+      "assert(n:getentrybyid(101):getid() == 101);\n"
+      ;
+    ok = ledger_lua_openlibs(ptr);
+    if (!ok) break;
+    ok = ledger_lua_exec_str(ptr, task_name, task_text, 0, NULL);
+    if (!ok) break;
+    ok = 1;
+  } while (0);
+  ledger_lua_close(ptr);
+  return ok;
+}
+
 
 int main(int argc, char **argv){
   int pass_count = 0;
@@ -0,0 +1,325 @@
+#include "../src/act/select.h"
+#include "../src/base/table.h"
+#include "../src/base/util.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/* row positions collected by a selection */
+struct select_test_rows {
+  int count;
+  int positions[256];
+};
+
+static int select_test_collect(void* arg, struct ledger_table_mark const* m);
+static struct ledger_table* select_test_table(int columnar_tf);
+static int select_test_compare
+  ( struct ledger_table* plain, struct ledger_table* indexed,
+    int len, struct ledger_select_cond const cond[]);
+static int select_scan_test(void);
+static int select_hash_index_test(void);
+static int select_ordered_index_test(void);
+static int select_columnar_index_test(void);
+static struct ledger_table* select_test_date_table(void);
+static int select_date_test(void);
+
+struct test_struct {
+  int (*fn)(void);
+  char const* name;
+};
+struct test_struct test_array[] = {
+  { select_scan_test, "select by scan" },
+  { select_hash_index_test, "select through hash index" },
+  { select_ordered_index_test, "select through ordered index" },
+  { select_columnar_index_test, "select through columnar index" },
+  { select_date_test, "select by date" }
+};
+
+
+int select_test_collect(void* arg, struct ledger_table_mark const* m){
+  struct select_test_rows* const rows = (struct select_test_rows*)arg;
+  if (rows->count >= 256) return -1;
+  rows->positions[rows->count] = ledger_table_mark_get_index(m);
+  rows->count += 1;
+  return 0;
+}
+
+struct ledger_table* select_test_table(int columnar_tf){
+  struct ledger_table* t = columnar_tf
+    ? ledger_table_new_columnar() : ledger_table_new();
+  struct ledger_table_mark* mark = NULL;
+  int ok = 0;
+  if (t == NULL) return NULL;
+  else do {
+    int const column_types[2] = { LEDGER_TABLE_ID, LEDGER_TABLE_USTR };
+    int k;
+    if (!ledger_table_set_column_types(t, 2, column_types)) break;
+    mark = ledger_table_end(t);
+    if (mark == NULL) break;
+    for (k = 0; k < 120; ++k){
+      unsigned char text[8];
+      sprintf((char*)text, "n%i", k%7);
+      if (!ledger_table_add_row(mark)) break;
+      if (!ledger_table_put_id(mark, 0, (k*13)%40)) break;
+      if (!ledger_table_put_string(mark, 1, text)) break;
+      ledger_table_mark_move(mark, +1);
+    }
+    if (k < 120) break;
+    ok = 1;
+  } while (0);
+  ledger_table_mark_free(mark);
+  if (!ok){
+    ledger_table_free(t);
+    return NULL;
+  } else return t;
+}
+
+int select_test_compare
+  ( struct ledger_table* plain, struct ledger_table* indexed,
+    int len, struct ledger_select_cond const cond[])
+{
+  int dir;
+  for (dir = -1; dir <= +1; dir += 2){
+    struct select_test_rows expected, actual, actual_c;
+    expected.count = 0;
+    actual.count = 0;
+    actual_c.count = 0;
+    if (ledger_select_by_cond(plain, &expected, select_test_collect,
+          len, cond, dir) != 0)
+      return 0;
+    if (ledger_select_by_cond(indexed, &actual, select_test_collect,
+          len, cond, dir) != 0)
+      return 0;
+    if (ledger_select_by_cond_c(indexed, &actual_c, select_test_collect,
+          len, cond, dir) != 0)
+      return 0;
+    if (expected.count == 0) return 0;
+    if (expected.count != actual.count
+    ||  memcmp(expected.positions, actual.positions,
+          expected.count*sizeof(int)) != 0)
+      return 0;
+    if (expected.count != actual_c.count
+    ||  memcmp(expected.positions, actual_c.positions,
+          expected.count*sizeof(int)) != 0)
+      return 0;
+  }
+  return 1;
+}
+
+int select_scan_test(void){
+  int result = 0;
+  struct ledger_table* ptr = select_test_table(0);
+  if (ptr == NULL) return 0;
+  else do {
+    struct select_test_rows rows;
+    struct ledger_select_cond cond[2];
+    cond[0].cmp = LEDGER_SELECT_ID|LEDGER_SELECT_EQUAL;
+    cond[0].column = 0;
+    cond[0].value = (unsigned char const*)"13";
+    cond[1].cmp = LEDGER_SELECT_STRING|LEDGER_SELECT_EQUAL;
+    cond[1].column = 1;
+    cond[1].value = (unsigned char const*)"n1";
+    rows.count = 0;
+    if (ledger_select_by_cond_c(ptr, &rows, select_test_collect, 2, cond, +1)
+        != 0)
+      break;
+    /* rows 1, 41 and 81 hold 13, of which only row 1 holds "n1" */
+    if (rows.count != 1 || rows.positions[0] != 1) break;
+    result = 1;
+  } while (0);
+  ledger_table_free(ptr);
+  return result;
+}
+
+int select_hash_index_test(void){
+  int result = 0;
+  struct ledger_table* plain = select_test_table(0);
+  struct ledger_table* indexed = select_test_table(0);
+  if (plain == NULL || indexed == NULL){
+    ledger_table_free(plain);
+    ledger_table_free(indexed);
+    return 0;
+  } else do {
+    struct ledger_select_cond cond[2];
+    if (!ledger_table_add_column_index(indexed, 0, LEDGER_TABLE_HASH_INDEX))
+      break;
+    if (!ledger_table_add_column_index(indexed, 1, LEDGER_TABLE_HASH_INDEX))
+      break;
+    cond[0].cmp = LEDGER_SELECT_ID|LEDGER_SELECT_EQUAL;
+    cond[0].column = 0;
+    cond[0].value = (unsigned char const*)"13";
+    if (!select_test_compare(plain, indexed, 1, cond)) break;
+    cond[0].cmp = LEDGER_SELECT_STRING|LEDGER_SELECT_EQUAL;
+    cond[0].column = 1;
+    cond[0].value = (unsigned char const*)"n4";
+    cond[1].cmp = LEDGER_SELECT_ID|LEDGER_SELECT_MORE;
+    cond[1].column = 0;
+    cond[1].value = (unsigned char const*)"20";
+    if (!select_test_compare(plain, indexed, 2, cond)) break;
+    /* hash indexes cannot serve ranges, so this one scans */
+    if (!select_test_compare(plain, indexed, 1, cond+1)) break;
+    result = 1;
+  } while (0);
+  ledger_table_free(plain);
+  ledger_table_free(indexed);
+  return result;
+}
+
+int select_ordered_index_test(void){
+  int result = 0;
+  struct ledger_table* plain = select_test_table(0);
+  struct ledger_table* indexed = select_test_table(0);
+  if (plain == NULL || indexed == NULL){
+    ledger_table_free(plain);
+    ledger_table_free(indexed);
+    return 0;
+  } else do {
+    struct ledger_select_cond cond[2];
+    if (!ledger_table_add_column_index
+          (indexed, 0, LEDGER_TABLE_ORDERED_INDEX))
+      break;
+    if (!ledger_table_add_column_index
+          (indexed, 1, LEDGER_TABLE_ORDERED_INDEX))
+      break;
+    cond[0].cmp = LEDGER_SELECT_ID|LEDGER_SELECT_LESS;
+    cond[0].column = 0;
+    cond[0].value = (unsigned char const*)"5";
+    if (!select_test_compare(plain, indexed, 1, cond)) break;
+    cond[0].cmp = LEDGER_SELECT_ID|LEDGER_SELECT_NOTLESS;
+    cond[0].value = (unsigned char const*)"37";
+    if (!select_test_compare(plain, indexed, 1, cond)) break;
+    cond[0].cmp = LEDGER_SELECT_STRING|LEDGER_SELECT_NOTMORE;
+    cond[0].column = 1;
+    cond[0].value = (unsigned char const*)"n1";
+    cond[1].cmp = LEDGER_SELECT_ID|LEDGER_SELECT_NOTEQUAL;
+    cond[1].column = 0;
+    cond[1].value = (unsigned char const*)"0";
+    if (!select_test_compare(plain, indexed, 2, cond)) break;
+    result = 1;
+  } while (0);
+  ledger_table_free(plain);
+  ledger_table_free(indexed);
+  return result;
+}
+
+int select_columnar_index_test(void){
+  int result = 0;
+  struct ledger_table* plain = select_test_table(1);
+  struct ledger_table* indexed = select_test_table(1);
+  if (plain == NULL || indexed == NULL){
+    ledger_table_free(plain);
+    ledger_table_free(indexed);
+    return 0;
+  } else do {
+    struct ledger_select_cond cond[1];
+    if (!ledger_table_add_column_index
+          (indexed, 0, LEDGER_TABLE_ORDERED_INDEX))
+      break;
+    if (!ledger_table_add_column_index(indexed, 1, LEDGER_TABLE_HASH_INDEX))
+      break;
+    cond[0].cmp = LEDGER_SELECT_ID|LEDGER_SELECT_MORE;
+    cond[0].column = 0;
+    cond[0].value = (unsigned char const*)"30";
+    if (!select_test_compare(plain, indexed, 1, cond)) break;
+    cond[0].cmp = LEDGER_SELECT_STRING|LEDGER_SELECT_EQUAL;
+    cond[0].column = 1;
+    cond[0].value = (unsigned char const*)"n6";
+    if (!select_test_compare(plain, indexed, 1, cond)) break;
+    result = 1;
+  } while (0);
+  ledger_table_free(plain);
+  ledger_table_free(indexed);
+  return result;
+}
+
+struct ledger_table* select_test_date_table(void){
+  struct ledger_table* t = ledger_table_new_columnar();
+  struct ledger_table_mark* mark = NULL;
+  int ok = 0;
+  if (t == NULL) return NULL;
+  else do {
+    int const column_types[1] = { LEDGER_TABLE_DATE };
+    int k;
+    if (!ledger_table_set_column_types(t, 1, column_types)) break;
+    mark = ledger_table_end(t);
+    if (mark == NULL) break;
+    for (k = 0; k < 90; ++k){
+      unsigned char text[24];
+      if (k%3 == 2)
+        sprintf((char*)text, "2022-%02i-15T%02i:30", k%12+1, k%24);
+      else sprintf((char*)text, "2022-%02i-%02i", k%12+1, k%28+1);
+      if (!ledger_table_add_row(mark)) break;
+      if (!ledger_table_put_string(mark, 0, text)) break;
+      ledger_table_mark_move(mark, +1);
+    }
+    if (k < 90) break;
+    ok = 1;
+  } while (0);
+  ledger_table_mark_free(mark);
+  if (!ok){
+    ledger_table_free(t);
+    return NULL;
+  } else return t;
+}
+
+int select_date_test(void){
+  int result = 0;
+  struct ledger_table* plain = select_test_date_table();
+  struct ledger_table* indexed = select_test_date_table();
+  if (plain == NULL || indexed == NULL){
+    ledger_table_free(plain);
+    ledger_table_free(indexed);
+    return 0;
+  } else do {
+    struct select_test_rows rows;
+    struct ledger_select_cond cond[2];
+    if (!ledger_table_add_column_index
+          (indexed, 0, LEDGER_TABLE_ORDERED_INDEX))
+      break;
+    cond[0].cmp = LEDGER_SELECT_DATE|LEDGER_SELECT_NOTLESS;
+    cond[0].column = 0;
+    cond[0].value = (unsigned char const*)"2022-04-01";
+    cond[1].cmp = LEDGER_SELECT_DATE|LEDGER_SELECT_LESS;
+    cond[1].column = 0;
+    cond[1].value = (unsigned char const*)"2022-06-15T12:00";
+    if (!select_test_compare(plain, indexed, 2, cond)) break;
+    if (!select_test_compare(plain, indexed, 1, cond+1)) break;
+    cond[0].cmp = LEDGER_SELECT_DATE|LEDGER_SELECT_EQUAL;
+    cond[0].value = (unsigned char const*)"2022-02-02";
+    if (!select_test_compare(plain, indexed, 1, cond)) break;
+    /* only rows 1 and 85 fall on the second of February */
+    rows.count = 0;
+    if (ledger_select_by_cond(plain, &rows, select_test_collect,
+          1, cond, +1) != 0)
+      break;
+    if (rows.count != 2 || rows.positions[0] != 1 || rows.positions[1] != 85)
+      break;
+    /* a value that is not a date is an error */
+    cond[0].cmp = LEDGER_SELECT_DATE|LEDGER_SELECT_NOTEQUAL;
+    cond[0].value = (unsigned char const*)"March";
+    rows.count = 0;
+    if (ledger_select_by_cond(indexed, &rows, select_test_collect,
+          1, cond, +1) != -1)
+      break;
+    result = 1;
+  } while (0);
+  ledger_table_free(plain);
+  ledger_table_free(indexed);
+  return result;
+}
+
+int main(int argc, char **argv){
+  int pass_count = 0;
+  int const test_count = sizeof(test_array)/sizeof(test_array[0]);
+  int i;
+  printf("Running %i tests...\n", test_count);
+  for (i = 0; i < test_count; ++i){
+    int pass_value;
+    printf("\t%s... ", test_array[i].name);
+    pass_value = ((*test_array[i].fn)())?1:0;
+    printf("%s\n",pass_value==0?"FAILED":"PASSED");
+    pass_count += pass_value;
+  }
+  printf("...%i out of %i tests passed.\n", pass_count, test_count);
+  return pass_count==test_count?EXIT_SUCCESS:EXIT_FAILURE;
+}
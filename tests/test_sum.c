@@ -2,11 +2,16 @@
 #include "../src/base/table.h"
 #include "../src/base/sum.h"
 #include "../src/base/bignum.h"
+#include "../src/base/account.h"
+#include "../src/base/util.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
 static int simple_sum_test(void);
+static int mixed_sum_test(void);
+static int aggregate_sum_test(void);
+static int as_of_sum_test(void);
 
 
 struct test_struct {
@@ -15,7 +20,10 @@ struct test_struct {
 };
 
 struct test_struct test_array[] = {
-  { simple_sum_test, "simple sum" }
+  { simple_sum_test, "simple sum" },
+  { mixed_sum_test, "mixed sum" },
+  { aggregate_sum_test, "sum from column aggregate" },
+  { as_of_sum_test, "balance as of a date" }
 };
 
 
@@ -65,6 +73,159 @@ int simple_sum_test(void){
 
 
 
+int mixed_sum_test(void){
+  int result = 0;
+  struct ledger_bignum* sum;
+  struct ledger_table* table;
+  sum = ledger_bignum_new();
+  table = ledger_table_new_columnar();
+  if (table != NULL && sum != NULL) do {
+    int ok = 0;
+    int column_types[1] = { LEDGER_TABLE_BIGNUM };
+    static char const* amounts[] = {
+      "0.25", "1.5", "99999999999999999999.99", "", "-1.75", "-0", "7"
+    };
+    ok = ledger_table_set_column_types(table,1,column_types);
+    if (!ok) break;
+    /* iterate from the start */{
+      int i;
+      int const total_rows = sizeof(amounts)/sizeof(amounts[0]);
+      struct ledger_table_mark* mark;
+      mark = ledger_table_end(table);
+      if (mark == NULL) break;
+      for (i = 0; i < total_rows; ++i){
+        ok = ledger_table_add_row(mark);
+        if (!ok) break;
+        ok = ledger_table_put_string
+          (mark, 0, (unsigned char const*)amounts[i]);
+        if (!ok) break;
+        ledger_table_mark_move(mark, +1);
+      }
+      ledger_table_mark_free(mark);
+      mark = NULL;
+      if (!ok) break;
+    }
+    if (!ledger_sum_table_column(sum, table, 0))
+      break;
+    /* check the sum */{
+      unsigned char buf[32];
+      if (ledger_bignum_get_text(sum, buf, sizeof(buf), 0) != 24)
+        break;
+      if (strcmp((char const*)buf, "100000000000000000006.99") != 0)
+        break;
+    }
+    result = 1;
+  } while (0);
+  ledger_bignum_free(sum);
+  ledger_table_free(table);
+  return result;
+}
+
+int aggregate_sum_test(void){
+  int result = 0;
+  struct ledger_bignum* sum;
+  struct ledger_table* table;
+  sum = ledger_bignum_new();
+  table = ledger_table_new_columnar();
+  if (table != NULL && sum != NULL) do {
+    int ok = 0;
+    int column_types[1] = { LEDGER_TABLE_BIGNUM };
+    static char const* amounts[] = {
+      "0.25", "1.5", "99999999999999999999.99", "", "-1.75", "-0", "7"
+    };
+    struct ledger_table_mark* mark;
+    ok = ledger_table_set_column_types(table,1,column_types);
+    if (!ok) break;
+    ok = ledger_table_add_column_aggregate(table, 0);
+    if (!ok) break;
+    mark = ledger_table_end(table);
+    if (mark == NULL) break;
+    /* iterate from the start */{
+      int i;
+      int const total_rows = sizeof(amounts)/sizeof(amounts[0]);
+      for (i = 0; i < total_rows; ++i){
+        ok = ledger_table_add_row(mark);
+        if (!ok) break;
+        ok = ledger_table_put_string
+          (mark, 0, (unsigned char const*)amounts[i]);
+        if (!ok) break;
+        ledger_table_mark_move(mark, +1);
+      }
+    }
+    /* change the last row */
+    ledger_table_mark_move(mark, -1);
+    if (ok) ok = ledger_table_put_string(mark, 0, (unsigned char const*)"8");
+    ledger_table_mark_free(mark);
+    mark = NULL;
+    if (!ok) break;
+    if (!ledger_sum_table_column(sum, table, 0))
+      break;
+    /* check the sum */{
+      unsigned char buf[32];
+      if (ledger_bignum_get_text(sum, buf, sizeof(buf), 0) != 24)
+        break;
+      if (strcmp((char const*)buf, "100000000000000000007.99") != 0)
+        break;
+    }
+    result = 1;
+  } while (0);
+  ledger_bignum_free(sum);
+  ledger_table_free(table);
+  return result;
+}
+
+int as_of_sum_test(void){
+  int result = 0;
+  struct ledger_bignum* sum;
+  struct ledger_account* account;
+  struct ledger_table_mark* mark = NULL;
+  sum = ledger_bignum_new();
+  account = ledger_account_new();
+  if (account != NULL && sum != NULL) do {
+    static struct {
+      char const* date;
+      char const* amount;
+      char const* as_of;
+      long int balance;
+    } const lines[] = {
+      { "2020-01-05", "10", "2020-01-04", 0 },
+      { "2020-01-05T09:30", "5", "2020-01-05", 15 },
+      { "2020-02-01", "-3", "2020-01-31T23:59", 15 },
+      { "", "100", "2020-01-01", 100 },
+      { "2020-03-01", "7", "2020-02-01", 112 },
+      { "2020-01-20", "1", "2020-03-01", 120 }
+    };
+    int const line_count = sizeof(lines)/sizeof(lines[0]);
+    int i;
+    struct ledger_table* const table = ledger_account_get_table(account);
+    mark = ledger_table_end(table);
+    if (mark == NULL) break;
+    for (i = 0; i < line_count; ++i){
+      long long int date;
+      /* append the line as a commit would */
+      if (!ledger_table_add_row(mark)) break;
+      if (!ledger_table_put_string
+            (mark, 2, (unsigned char const*)lines[i].amount))
+        break;
+      if (!ledger_table_put_string
+            (mark, 4, (unsigned char const*)lines[i].date))
+        break;
+      ledger_table_mark_move(mark, +1);
+      if (!ledger_util_date_from_text
+            ((unsigned char const*)lines[i].as_of, &date))
+        break;
+      if (!ledger_sum_as_of(sum, account, date)) break;
+      if (ledger_bignum_get_long(sum) != lines[i].balance) break;
+    }
+    if (i < line_count) break;
+    result = 1;
+  } while (0);
+  ledger_table_mark_free(mark);
+  ledger_bignum_free(sum);
+  ledger_account_free(account);
+  return result;
+}
+
 int main(int argc, char **argv){
   int pass_count = 0;
   int const test_count = sizeof(test_array)/sizeof(test_array[0]);
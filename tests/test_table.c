@@ -24,6 +24,46 @@ static int set_row_id_test(void);
 static int set_row_id_index_test(void);
 static int suspend_row_test(void);
 static int suspend_lost_row_test(void);
+static int columnar_move_mark_test(void);
+static int columnar_stable_mark_test(void);
+static int columnar_equal_test(void);
+static int amount_cell_test(void);
+static int string_cell_test(void);
+static int seek_mark_test(void);
+static int cursor_test(void);
+static int row_access_test(void);
+static int copy_test(void);
+static int column_index_check
+  ( struct ledger_table const* t, int column,
+    struct ledger_table_field const* low, int low_inclusive_tf,
+    struct ledger_table_field const* high, int high_inclusive_tf);
+static int column_index_test(void);
+static int date_cell_test(void);
+static int column_aggregate_check
+  (struct ledger_table const* t, int column);
+static int column_aggregate_test(void);
+static int column_prefix_check(struct ledger_table const* t);
+static int column_prefix_test(void);
+static void observer_record
+  ( void* arg, int event, struct ledger_table_mark const* mark,
+    int row, int column);
+static void observer_dropper
+  ( void* arg, int event, struct ledger_table_mark const* mark,
+    int row, int column);
+static int observer_test(void);
+static int fingerprint_check(struct ledger_table const* t);
+static int fingerprint_test(void);
+static int string_pool_test(void);
+static int tombstone_test(void);
+static int column_scan_check
+  (struct ledger_table const* t, int column, unsigned char const* bits);
+static int column_filter_check
+  ( struct ledger_table const* t, int column,
+    struct ledger_table_field const* low, int low_inclusive_tf,
+    struct ledger_table_field const* high, int high_inclusive_tf,
+    unsigned char* bits);
+static int column_scan_test(void);
+static int scale_column_test(void);
 
 struct test_struct {
   int (*fn)(void);
@@ -48,7 +88,26 @@ struct test_struct test_array[] = {
   { move_mark_test, "mark move" },
   { nonzero_equal_test, "nonzero equal" },
   { suspend_row_test, "add a suspended row" },
-  { suspend_lost_row_test, "edit a suspended row" }
+  { suspend_lost_row_test, "edit a suspended row" },
+  { columnar_move_mark_test, "columnar mark move" },
+  { columnar_stable_mark_test, "columnar mark stability" },
+  { columnar_equal_test, "columnar equal to linked" },
+  { amount_cell_test, "amount cells" },
+  { string_cell_test, "string cells" },
+  { seek_mark_test, "mark seek" },
+  { cursor_test, "cursor" },
+  { row_access_test, "whole-row access" },
+  { copy_test, "copy" },
+  { column_index_test, "column indexes" },
+  { date_cell_test, "date cells" },
+  { column_aggregate_test, "column aggregates" },
+  { column_prefix_test, "column prefix sums" },
+  { observer_test, "observers" },
+  { fingerprint_test, "fingerprints" },
+  { string_pool_test, "string pools" },
+  { tombstone_test, "tombstones and vacuum" },
+  { column_scan_test, "column scans and filters" },
+  { scale_column_test, "scale column" }
 };
 
 
@@ -869,6 +928,2017 @@ int suspend_lost_row_test(void){
 }
 
 
+int columnar_move_mark_test(void){
+  int result = 0;
+  struct ledger_table* ptr;
+  struct ledger_table_mark* mark = NULL;
+  ptr = ledger_table_new_columnar();
+  if (ptr == NULL) return 0;
+  else do {
+    int ok;
+    int column_types[2] = { LEDGER_TABLE_ID, LEDGER_TABLE_USTR };
+    if (!ledger_table_is_columnar(ptr)) break;
+    ok = ledger_table_set_column_types(ptr,2,column_types);
+    if (!ok) break;
+    /* iterate from the start */{
+      int const row_count = 5;
+      int const count_offset = 35;
+      int i;
+      int value;
+      mark = ledger_table_begin(ptr);
+      if (mark == NULL) break;
+      for (i = 0; i < row_count; ++i){
+        ok = ledger_table_add_row(mark);
+        if (!ok) break;
+        if (ledger_table_count_rows(ptr) != i+1) break;
+        if (!ledger_table_put_id(mark, 0, i+count_offset)) break;
+        if (!ledger_table_put_string(mark, 1,
+            (unsigned char const*)"text"))
+          break;
+        ledger_table_mark_move(mark, +1);
+      }
+      if (i < row_count) break;
+      ledger_table_mark_free(mark);
+      mark = ledger_table_end(ptr);
+      if (mark == NULL) break;
+      for (i = row_count-1; i >= 0; --i){
+        ledger_table_mark_move(mark, -1);
+        if (!ledger_table_fetch_id(mark, 0, &value))
+          break;
+        if (value != i+count_offset)
+          break;
+      }
+      if (i >= 0) break;
+      /* wrap around through the end of the table */
+      ledger_table_mark_move(mark, -1);
+      /* check the end */{
+        struct ledger_table_mark* end_mark = ledger_table_end_c(ptr);
+        if (end_mark == NULL) break;
+        ok = ledger_table_mark_is_equal(mark, end_mark);
+        ledger_table_mark_free(end_mark);
+        if (!ok) break;
+      }
+      ledger_table_mark_move(mark, -2);
+      if (!ledger_table_fetch_id(mark, 0, &value)) break;
+      if (value != count_offset+row_count-2) break;
+      /* drop everything */
+      ledger_table_mark_free(mark);
+      mark = ledger_table_end(ptr);
+      if (mark == NULL) break;
+      ledger_table_mark_move(mark, -1);
+      for (i = 0; i < row_count; ++i){
+        if (!ledger_table_drop_row(mark)) break;
+      }
+      if (i < row_count) break;
+      if (ledger_table_drop_row(mark)) break;
+      if (ledger_table_count_rows(ptr) != 0) break;
+    }
+    result = 1;
+  } while (0);
+  ledger_table_mark_free(mark);
+  ledger_table_free(ptr);
+  return result;
+}
+
+int columnar_stable_mark_test(void){
+  int result = 0;
+  struct ledger_table* ptr;
+  struct ledger_table_mark* mark = NULL;
+  struct ledger_table_mark* held_mark = NULL;
+  ptr = ledger_table_new_columnar();
+  if (ptr == NULL) return 0;
+  else do {
+    int ok;
+    int value;
+    int column_types[1] = { LEDGER_TABLE_ID };
+    ok = ledger_table_set_column_types(ptr,1,column_types);
+    if (!ok) break;
+    /* add one row to hold */{
+      mark = ledger_table_begin(ptr);
+      if (mark == NULL) break;
+      if (!ledger_table_add_row(mark)) break;
+      if (!ledger_table_put_id(mark, 0, 71)) break;
+      held_mark = ledger_table_begin(ptr);
+      if (held_mark == NULL) break;
+      if (!ledger_table_mark_is_equal(mark, held_mark)) break;
+    }
+    /* insert rows around the held row */{
+      if (!ledger_table_add_row(mark)) break;
+      if (!ledger_table_put_id(mark, 0, 70)) break;
+      if (ledger_table_mark_is_equal(mark, held_mark)) break;
+      ledger_table_mark_free(mark);
+      mark = ledger_table_end(ptr);
+      if (mark == NULL) break;
+      if (!ledger_table_add_row(mark)) break;
+      if (!ledger_table_put_id(mark, 0, 72)) break;
+      if (ledger_table_count_rows(ptr) != 3) break;
+      if (!ledger_table_fetch_id(held_mark, 0, &value)) break;
+      if (value != 71) break;
+    }
+    /* drop the row before the held row */{
+      ledger_table_mark_free(mark);
+      mark = ledger_table_begin(ptr);
+      if (mark == NULL) break;
+      if (!ledger_table_drop_row(mark)) break;
+      if (!ledger_table_fetch_id(held_mark, 0, &value)) break;
+      if (value != 71) break;
+      ledger_table_mark_move(mark, +1);
+      if (!ledger_table_mark_is_equal(mark, held_mark)) break;
+    }
+    /* the held row survives the table */{
+      ledger_table_mark_free(mark);
+      mark = NULL;
+      ledger_table_free(ptr);
+      ptr = NULL;
+      if (!ledger_table_fetch_id(held_mark, 0, &value)) break;
+      if (value != 71) break;
+      if (ledger_table_add_row(held_mark)) break;
+      if (ledger_table_drop_row(held_mark)) break;
+    }
+    result = 1;
+  } while (0);
+  ledger_table_mark_free(held_mark);
+  ledger_table_mark_free(mark);
+  ledger_table_free(ptr);
+  return result;
+}
+
+int columnar_equal_test(void){
+  int result = 0;
+  struct ledger_table* ptr, * other_ptr;
+  ptr = ledger_table_new();
+  if (ptr == NULL) return 0;
+  other_ptr = ledger_table_new_columnar();
+  if (other_ptr == NULL){
+    ledger_table_free(ptr);
+    return 0;
+  }
+  int column_types[3] =
+    { LEDGER_TABLE_BIGNUM, LEDGER_TABLE_USTR, LEDGER_TABLE_ID };
+  int const column_count = 3;
+  do {
+    int j;
+    int const row_count = 3;
+    struct ledger_table* tables[2];
+    tables[0] = ptr;
+    tables[1] = other_ptr;
+    if (ledger_table_is_columnar(ptr)) break;
+    if (!ledger_table_is_equal(ptr, other_ptr)) break;
+    /* write the tables */for (j = 0; j < 2; ++j){
+      int ok = 0;
+      struct ledger_table_mark* mark = NULL;
+      if (!ledger_table_set_column_types(
+          tables[j], column_count, column_types))
+        break;
+      do {
+        int i, k;
+        mark = ledger_table_end(tables[j]);
+        if (mark == NULL) break;
+        for (k = 0; k < row_count; ++k){
+          if (!ledger_table_add_row(mark)) break;
+          for (i = 0; i < column_count; ++i){
+            if (!ledger_table_put_string(mark, i,
+                (unsigned char*)"099.99"))
+              break;
+          }
+          if (i < column_count) break;
+          ledger_table_mark_move(mark, +1);
+        }
+        if (k < row_count) break;
+        ok = 1;
+      } while (0);
+      ledger_table_mark_free(mark);
+      if (!ok) break;
+    }
+    if (j < 2) break;
+    if (!ledger_table_is_equal(ptr, other_ptr)) break;
+    if (!ledger_table_is_equal(other_ptr, ptr)) break;
+    /* change one item */{
+      int ok = 0;
+      struct ledger_table_mark* mark = ledger_table_end(other_ptr);
+      if (mark != NULL){
+        ledger_table_mark_move(mark, -1);
+        ok = ledger_table_put_string(mark, 1, (unsigned char*)"99.99");
+      }
+      ledger_table_mark_free(mark);
+      if (!ok) break;
+    }
+    if (ledger_table_is_equal(ptr, other_ptr)) break;
+    if (ledger_table_is_equal(other_ptr, ptr)) break;
+    result = 1;
+  } while (0);
+  ledger_table_free(other_ptr);
+  ledger_table_free(ptr);
+  return result;
+}
+
+
+int amount_cell_test(void){
+  int result = 0;
+  int backend;
+  struct ledger_bignum* numeric;
+  numeric = ledger_bignum_new();
+  if (numeric == NULL) return 0;
+  for (backend = 0; backend < 2; ++backend){
+    struct ledger_table* ptr;
+    struct ledger_table_mark* mark = NULL;
+    ptr = backend ? ledger_table_new_columnar() : ledger_table_new();
+    if (ptr == NULL) break;
+    result = 0;
+    do {
+      int value;
+      long long int fixed;
+      int point_place;
+      unsigned char buf[40];
+      int column_types[1] = { LEDGER_TABLE_BIGNUM };
+      if (!ledger_table_set_column_types(ptr,1,column_types)) break;
+      mark = ledger_table_begin(ptr);
+      if (mark == NULL) break;
+      if (!ledger_table_add_row(mark)) break;
+      /* unset amounts */
+      if (ledger_table_fetch_string(mark, 0, buf, sizeof(buf)) != 0) break;
+      if (!ledger_table_fetch_fixed(mark, 0, &fixed, &point_place)) break;
+      if (fixed != 0 || point_place != 0) break;
+      /* amounts keep their centesimal places */
+      if (!ledger_table_put_string(mark, 0,
+          (unsigned char const*)"1.50"))
+        break;
+      if (!ledger_table_put_id(mark, 0, -2)) break;
+      if (ledger_table_fetch_string(mark, 0, buf, sizeof(buf)) != 5) break;
+      if (strcmp((char const*)buf, "-2.00") != 0) break;
+      /* large amounts */
+      if (!ledger_table_put_string(mark, 0,
+          (unsigned char const*)"-12345678901234567890.1"))
+        break;
+      if (ledger_table_fetch_string(mark, 0, buf, sizeof(buf)) != 24) break;
+      if (strcmp((char const*)buf, "-12345678901234567890.10") != 0) break;
+      if (ledger_table_fetch_fixed(mark, 0, &fixed, &point_place)) break;
+      if (!ledger_table_fetch_bignum(mark, 0, numeric)) break;
+      if (ledger_bignum_get_text(numeric, buf, sizeof(buf), 0) != 24) break;
+      /* back to small amounts */
+      if (!ledger_bignum_set_text(numeric,
+          (unsigned char const*)"45.6", NULL))
+        break;
+      if (!ledger_table_put_bignum(mark, 0, numeric)) break;
+      if (!ledger_table_fetch_fixed(mark, 0, &fixed, &point_place)) break;
+      if (fixed != 4560 || point_place != 1) break;
+      if (!ledger_table_fetch_id(mark, 0, &value)) break;
+      if (value != 45) break;
+      if (ledger_table_fetch_string(mark, 0, buf, sizeof(buf)) != 5) break;
+      if (strcmp((char const*)buf, "45.60") != 0) break;
+      /* unset again */
+      if (!ledger_table_put_string(mark, 0, (unsigned char const*)""))
+        break;
+      if (ledger_table_fetch_string(mark, 0, buf, sizeof(buf)) != 0) break;
+      result = 1;
+    } while (0);
+    ledger_table_mark_free(mark);
+    ledger_table_free(ptr);
+    if (!result) break;
+  }
+  ledger_bignum_free(numeric);
+  return result;
+}
+
+int string_cell_test(void){
+  int result = 0;
+  int backend;
+  static char const* texts[] = {
+    "", "2018-01-01", "fifteen letters", "sixteen letters!",
+    "a much longer memo that has to be kept out of line", "1001"
+  };
+  int const text_count = sizeof(texts)/sizeof(texts[0]);
+  for (backend = 0; backend < 2; ++backend){
+    struct ledger_table* ptr;
+    struct ledger_table_mark* mark = NULL;
+    ptr = backend ? ledger_table_new_columnar() : ledger_table_new();
+    if (ptr == NULL) break;
+    result = 0;
+    do {
+      int i;
+      unsigned char buf[64];
+      size_t alloc_count;
+      int column_types[2] = { LEDGER_TABLE_USTR, LEDGER_TABLE_USTR };
+      if (!ledger_table_set_column_types(ptr,2,column_types)) break;
+      mark = ledger_table_begin(ptr);
+      if (mark == NULL) break;
+      if (!ledger_table_add_row(mark)) break;
+      /* switch between inline and out-of-line strings */
+      for (i = 0; i < text_count; ++i){
+        size_t const len = strlen(texts[i]);
+        if (!ledger_table_put_string(mark, 0,
+            (unsigned char const*)texts[i]))
+          break;
+        if (ledger_table_fetch_string(mark, 0, buf, sizeof(buf))
+            != (int)len)
+          break;
+        if (strcmp((char const*)buf, texts[i]) != 0) break;
+      }
+      if (i < text_count) break;
+      /* other cells stay untouched */
+      if (ledger_table_fetch_string(mark, 1, buf, sizeof(buf)) != 0) break;
+      if (!ledger_table_put_id(mark, 1, 123456)) break;
+      if (ledger_table_fetch_string(mark, 0, buf, sizeof(buf)) != 4) break;
+      if (strcmp((char const*)buf, "1001") != 0) break;
+      /* short strings need no allocation */
+      alloc_count = ledger_util_count_allocations();
+      if (!ledger_table_put_string(mark, 0,
+          (unsigned char const*)"check 1002"))
+        break;
+      if (ledger_util_count_allocations() != alloc_count) break;
+      if (!ledger_table_put_string(mark, 0, NULL)) break;
+      if (ledger_table_fetch_string(mark, 0, buf, sizeof(buf)) != 0) break;
+      if (ledger_table_fetch_string(mark, 1, buf, sizeof(buf)) != 6) break;
+      if (strcmp((char const*)buf, "123456") != 0) break;
+      result = 1;
+    } while (0);
+    ledger_table_mark_free(mark);
+    ledger_table_free(ptr);
+    if (!result) break;
+  }
+  return result;
+}
+
+int seek_mark_test(void){
+  int result = 0;
+  int backend;
+  for (backend = 0; backend < 2; ++backend){
+    struct ledger_table* ptr;
+    struct ledger_table_mark* mark = NULL;
+    struct ledger_table_mark* other_mark = NULL;
+    ptr = backend ? ledger_table_new_columnar() : ledger_table_new();
+    if (ptr == NULL) break;
+    result = 0;
+    do {
+      int const row_count = 100;
+      int i;
+      int value;
+      int column_types[1] = { LEDGER_TABLE_ID };
+      if (!ledger_table_set_column_types(ptr,1,column_types)) break;
+      mark = ledger_table_end(ptr);
+      if (mark == NULL) break;
+      if (ledger_table_mark_get_index(mark) != 0) break;
+      if (ledger_table_mark_seek(mark, 1)) break;
+      for (i = 0; i < row_count; ++i){
+        if (!ledger_table_add_row(mark)) break;
+        if (!ledger_table_put_id(mark, 0, i)) break;
+        if (ledger_table_mark_get_index(mark) != i) break;
+        ledger_table_mark_move(mark, +1);
+      }
+      if (i < row_count) break;
+      if (ledger_table_mark_get_index(mark) != row_count) break;
+      /* random access */
+      for (i = 0; i < row_count; i += 7){
+        int const j = (i*37)%row_count;
+        if (!ledger_table_mark_seek(mark, j)) break;
+        if (!ledger_table_fetch_id(mark, 0, &value)) break;
+        if (value != j) break;
+        if (ledger_table_mark_get_index(mark) != j) break;
+      }
+      if (i < row_count) break;
+      if (ledger_table_mark_seek(mark, -1)) break;
+      if (ledger_table_mark_seek(mark, row_count+1)) break;
+      /* insertions and deletions elsewhere */
+      other_mark = ledger_table_begin(ptr);
+      if (other_mark == NULL) break;
+      if (!ledger_table_mark_seek(other_mark, 50)) break;
+      if (!ledger_table_mark_seek(mark, 10)) break;
+      if (!ledger_table_add_row(mark)) break;
+      if (!ledger_table_put_id(mark, 0, -1)) break;
+      if (ledger_table_mark_get_index(mark) != 10) break;
+      if (!ledger_table_mark_seek(mark, 11)) break;
+      if (!ledger_table_fetch_id(mark, 0, &value)) break;
+      if (value != 10) break;
+      if (!ledger_table_mark_seek(mark, 20)) break;
+      if (!ledger_table_drop_row(mark)) break;
+      if (!ledger_table_drop_row(mark)) break;
+      if (ledger_table_mark_get_index(mark) != 18) break;
+      if (!ledger_table_fetch_id(mark, 0, &value)) break;
+      if (value != 17) break;
+      if (ledger_table_count_rows(ptr) != row_count-1) break;
+      if (!ledger_table_fetch_id(other_mark, 0, &value)) break;
+      if (value != 50) break;
+      if (ledger_table_mark_get_index(other_mark) != 49) break;
+      /* drop a row held by another mark */
+      if (!ledger_table_mark_seek(mark, 49)) break;
+      if (!ledger_table_drop_row(other_mark)) break;
+      if (ledger_table_mark_get_index(other_mark) != 48) break;
+      if (!ledger_table_mark_seek(other_mark, 49)) break;
+      if (!ledger_table_fetch_id(other_mark, 0, &value)) break;
+      if (value != 51) break;
+      if (!ledger_table_mark_seek(mark, row_count-3)) break;
+      if (!ledger_table_fetch_id(mark, 0, &value)) break;
+      if (value != row_count-1) break;
+      if (!ledger_table_mark_seek(mark, row_count-2)) break;
+      if (ledger_table_mark_get_index(mark) != row_count-2) break;
+      ledger_table_mark_move(mark, +1);
+      if (!ledger_table_fetch_id(mark, 0, &value)) break;
+      if (value != 0) break;
+      result = 1;
+    } while (0);
+    ledger_table_mark_free(other_mark);
+    ledger_table_mark_free(mark);
+    ledger_table_free(ptr);
+    if (!result) break;
+  }
+  return result;
+}
+
+int cursor_test(void){
+  int result = 0;
+  int backend;
+  for (backend = 0; backend < 2; ++backend){
+    struct ledger_table* ptr;
+    struct ledger_table_mark* mark = NULL;
+    ptr = backend ? ledger_table_new_columnar() : ledger_table_new();
+    if (ptr == NULL) break;
+    result = 0;
+    do {
+      int const row_count = 20;
+      int i;
+      int value;
+      size_t alloc_count;
+      struct ledger_table_cursor cursor;
+      struct ledger_table_mark const* const view =
+        ledger_table_cursor_mark(&cursor);
+      int column_types[2] = { LEDGER_TABLE_ID, LEDGER_TABLE_USTR };
+      if (!ledger_table_set_column_types(ptr,2,column_types)) break;
+      /* empty table */
+      ledger_table_cursor_begin(&cursor, ptr);
+      if (!ledger_table_cursor_is_end(&cursor)) break;
+      mark = ledger_table_end(ptr);
+      if (mark == NULL) break;
+      for (i = 0; i < row_count; ++i){
+        if (!ledger_table_add_row(mark)) break;
+        if (!ledger_table_put_id(mark, 0, i)) break;
+        if (!ledger_table_put_string(mark, 1, (unsigned char const*)"row"))
+          break;
+        ledger_table_mark_move(mark, +1);
+      }
+      if (i < row_count) break;
+      /* forward scan, without allocations */
+      alloc_count = ledger_util_count_allocations();
+      for (i = 0, ledger_table_cursor_begin(&cursor, ptr);
+          !ledger_table_cursor_is_end(&cursor);
+          ++i, ledger_table_cursor_move(&cursor, +1))
+      {
+        if (!ledger_table_fetch_id(view, 0, &value)) break;
+        if (value != i) break;
+      }
+      if (i != row_count) break;
+      if (ledger_util_count_allocations() != alloc_count) break;
+      if (!ledger_table_mark_is_equal(view, mark)) break;
+      /* backward scan */
+      ledger_table_cursor_end(&cursor, ptr);
+      for (i = row_count; i > 0; --i){
+        ledger_table_cursor_move(&cursor, -1);
+        if (ledger_table_cursor_is_end(&cursor)) break;
+        if (!ledger_table_fetch_id(view, 0, &value)) break;
+        if (value != i-1) break;
+      }
+      if (i > 0) break;
+      /* the view is not shareable */
+      if (ledger_table_mark_acquire((struct ledger_table_mark*)view) != NULL)
+        break;
+      result = 1;
+    } while (0);
+    ledger_table_mark_free(mark);
+    ledger_table_free(ptr);
+    if (!result) break;
+  }
+  return result;
+}
+
+int row_access_test(void){
+  int result = 0;
+  int backend;
+  struct ledger_bignum* numeric;
+  numeric = ledger_bignum_new();
+  if (numeric == NULL) return 0;
+  for (backend = 0; backend < 2; ++backend){
+    struct ledger_table* ptr;
+    struct ledger_table_mark* mark = NULL;
+    ptr = backend ? ledger_table_new_columnar() : ledger_table_new();
+    if (ptr == NULL) break;
+    result = 0;
+    do {
+      int const row_count = 10;
+      int i;
+      unsigned char buf[8];
+      struct ledger_table_field fields[30];
+      int column_types[3] =
+        { LEDGER_TABLE_ID, LEDGER_TABLE_BIGNUM, LEDGER_TABLE_USTR };
+      if (!ledger_table_set_column_types(ptr,3,column_types)) break;
+      memset(fields, 0, sizeof(fields));
+      for (i = 0; i < row_count; ++i){
+        fields[i*3+0].column = 0;
+        fields[i*3+0].type = LEDGER_TABLE_ID;
+        fields[i*3+0].id = i;
+        fields[i*3+1].column = 1;
+        fields[i*3+1].type = LEDGER_TABLE_USTR;
+        fields[i*3+1].text = (unsigned char const*)"1.25";
+        fields[i*3+2].column = 2;
+        fields[i*3+2].type = LEDGER_TABLE_USTR;
+        fields[i*3+2].text = (unsigned char const*)"check";
+      }
+      mark = ledger_table_end(ptr);
+      if (mark == NULL) break;
+      /* append in one call */
+      if (!ledger_table_append_rows(mark, 4, 3, fields)) break;
+      if (ledger_table_count_rows(ptr) != 4) break;
+      if (ledger_table_mark_get_index(mark) != 4) break;
+      /* failed appends leave the table alone */
+      fields[3*3+0].column = 7;
+      if (ledger_table_append_rows(mark, 6, 3, fields+3*2)) break;
+      if (ledger_table_count_rows(ptr) != 4) break;
+      if (ledger_table_mark_get_index(mark) != 4) break;
+      fields[3*3+0].column = 0;
+      if (!ledger_table_append_rows(mark, 6, 3, fields+3*4)) break;
+      if (ledger_table_count_rows(ptr) != row_count) break;
+      /* fetch and put whole rows */
+      if (ledger_table_fetch_row(mark, 3, fields)) break;
+      if (!ledger_table_mark_seek(mark, 7)) break;
+      fields[0].id = -5;
+      fields[1].type = LEDGER_TABLE_BIGNUM;
+      fields[1].bignum = numeric;
+      fields[2].type = LEDGER_TABLE_USTR;
+      fields[2].buf = buf;
+      fields[2].len = sizeof(buf);
+      if (!ledger_table_fetch_row(mark, 3, fields)) break;
+      if (fields[0].id != 7) break;
+      if (fields[2].text_length != 5) break;
+      if (strcmp((char const*)buf, "check") != 0) break;
+      if (ledger_bignum_get_text(numeric, buf, sizeof(buf), 0) != 4) break;
+      if (strcmp((char const*)buf, "1.25") != 0) break;
+      fields[0].id = 70;
+      if (!ledger_bignum_set_long(numeric, -3)) break;
+      fields[2].text = (unsigned char const*)"a much longer check";
+      if (!ledger_table_put_row(mark, 3, fields)) break;
+      if (!ledger_table_fetch_row(mark, 3, fields)) break;
+      if (fields[0].id != 70) break;
+      if (ledger_bignum_get_long(numeric) != -3) break;
+      if (fields[2].text_length != 19) break;
+      if (strcmp((char const*)buf, "a much ") != 0) break;
+      result = 1;
+    } while (0);
+    ledger_table_mark_free(mark);
+    ledger_table_free(ptr);
+    if (!result) break;
+  }
+  ledger_bignum_free(numeric);
+  return result;
+}
+
+int copy_test(void){
+  int result = 0;
+  int backend;
+  for (backend = 0; backend < 2; ++backend){
+    struct ledger_table* ptr;
+    struct ledger_table* copy = NULL;
+    struct ledger_table_mark* mark = NULL;
+    ptr = backend ? ledger_table_new_columnar() : ledger_table_new();
+    if (ptr == NULL) break;
+    result = 0;
+    do {
+      int k;
+      int column_types[3] =
+        { LEDGER_TABLE_BIGNUM, LEDGER_TABLE_USTR, LEDGER_TABLE_ID };
+      static char const* texts[4] = {
+        "12.5", "a string too long to keep inside the cell",
+        "123456789012345678901234.01", NULL
+      };
+      if (!ledger_table_set_column_types(ptr, 3, column_types)) break;
+      mark = ledger_table_end(ptr);
+      if (mark == NULL) break;
+      for (k = 0; k < 4; ++k){
+        if (!ledger_table_add_row(mark)) break;
+        if (!ledger_table_put_string
+            (mark, 0, (unsigned char const*)texts[k]))
+          break;
+        if (!ledger_table_put_string
+            (mark, 1, (unsigned char const*)texts[3-k]))
+          break;
+        if (!ledger_table_put_id(mark, 2, k*7)) break;
+        ledger_table_mark_move(mark, +1);
+      }
+      if (k < 4) break;
+      copy = ledger_table_copy(ptr);
+      if (copy == NULL) break;
+      if (ledger_table_is_columnar(copy) != ledger_table_is_columnar(ptr))
+        break;
+      if (ledger_table_count_rows(copy) != 4) break;
+      if (!ledger_table_is_equal(ptr, copy)) break;
+      /* the copy is independent */
+      ledger_table_mark_move(mark, -1);
+      if (!ledger_table_put_string(mark, 1, (unsigned char const*)"x"))
+        break;
+      if (ledger_table_is_equal(ptr, copy)) break;
+      result = 1;
+    } while (0);
+    ledger_table_mark_free(mark);
+    ledger_table_free(copy);
+    ledger_table_free(ptr);
+    if (!result) break;
+  }
+  return result;
+}
+
+int column_index_check
+  ( struct ledger_table const* t, int column,
+    struct ledger_table_field const* low, int low_inclusive_tf,
+    struct ledger_table_field const* high, int high_inclusive_tf)
+{
+  int ok = 1;
+  int* positions = NULL;
+  int const count = ledger_table_find_in_column_index
+    (t, column, low, low_inclusive_tf, high, high_inclusive_tf, &positions);
+  struct ledger_table_cursor cursor;
+  struct ledger_table_mark const* const mark =
+    ledger_table_cursor_mark(&cursor);
+  int position = 0;
+  int found = 0;
+  if (count < 0) return 0;
+  for (ledger_table_cursor_begin(&cursor, t);
+      ok && !ledger_table_cursor_is_end(&cursor);
+      ledger_table_cursor_move(&cursor, +1), ++position)
+  {
+    int match = 1;
+    if (ledger_table_get_column_type(t, column) == LEDGER_TABLE_USTR){
+      unsigned char buf[16];
+      int cmp;
+      if (ledger_table_fetch_string(mark, column, buf, sizeof(buf)) < 0)
+        ok = 0;
+      if (low != NULL){
+        cmp = ledger_util_ustrcmp(buf, low->text);
+        if (cmp < 0 || (cmp == 0 && !low_inclusive_tf)) match = 0;
+      }
+      if (high != NULL){
+        cmp = ledger_util_ustrcmp(buf, high->text);
+        if (cmp > 0 || (cmp == 0 && !high_inclusive_tf)) match = 0;
+      }
+    } else if (ledger_table_get_column_type(t, column) == LEDGER_TABLE_DATE){
+      long long int date;
+      if (!ledger_table_fetch_date(mark, column, &date))
+        ok = 0;
+      if (low != NULL){
+        if (date < low->date || (date == low->date && !low_inclusive_tf))
+          match = 0;
+      }
+      if (high != NULL){
+        if (date > high->date || (date == high->date && !high_inclusive_tf))
+          match = 0;
+      }
+    } else {
+      int id;
+      if (!ledger_table_fetch_id(mark, column, &id))
+        ok = 0;
+      if (low != NULL){
+        if (id < low->id || (id == low->id && !low_inclusive_tf))
+          match = 0;
+      }
+      if (high != NULL){
+        if (id > high->id || (id == high->id && !high_inclusive_tf))
+          match = 0;
+      }
+    }
+    if (match){
+      if (found >= count || positions[found] != position) ok = 0;
+      found += 1;
+    }
+  }
+  if (found != count) ok = 0;
+  ledger_util_free(positions);
+  return ok;
+}
+
+int column_index_test(void){
+  int result = 0;
+  int variant;
+  for (variant = 0; variant < 4; ++variant){
+    struct ledger_table* ptr;
+    struct ledger_table_mark* mark = NULL;
+    int const kind = (variant&1)
+      ? LEDGER_TABLE_ORDERED_INDEX : LEDGER_TABLE_HASH_INDEX;
+    ptr = (variant&2) ? ledger_table_new_columnar() : ledger_table_new();
+    result = 0;
+    if (ptr == NULL) break;
+    else do {
+      int column_types[3] =
+        { LEDGER_TABLE_ID, LEDGER_TABLE_USTR, LEDGER_TABLE_BIGNUM };
+      struct ledger_table_field id_bound, text_bound, text_high;
+      unsigned char text[8];
+      int k;
+      if (!ledger_table_set_column_types(ptr, 3, column_types)) break;
+      if (ledger_table_add_column_index(ptr, 2, kind)) break;
+      if (ledger_table_add_column_index(ptr, 3, kind)) break;
+      if (!ledger_table_add_column_index(ptr, 0, kind)) break;
+      if (!ledger_table_add_column_index(ptr, 1, kind)) break;
+      if (ledger_table_get_column_index(ptr, 0) != kind) break;
+      if (ledger_table_get_column_index(ptr, 2) != 0) break;
+      id_bound.type = LEDGER_TABLE_ID;
+      text_bound.type = LEDGER_TABLE_USTR;
+      text_high.type = LEDGER_TABLE_USTR;
+      text_bound.text = text;
+      text_high.text = (unsigned char const*)"k5";
+      /* append rows */
+      mark = ledger_table_end(ptr);
+      if (mark == NULL) break;
+      for (k = 0; k < 200; ++k){
+        sprintf((char*)text, "k%i", k%10);
+        if (!ledger_table_add_row(mark)) break;
+        if (!ledger_table_put_id(mark, 0, (k*37)%50)) break;
+        if (!ledger_table_put_string(mark, 1, text)) break;
+        ledger_table_mark_move(mark, +1);
+      }
+      if (k < 200) break;
+      id_bound.id = 11;
+      if (!column_index_check(ptr, 0, &id_bound, 1, &id_bound, 1)) break;
+      strcpy((char*)text, "k3");
+      if (!column_index_check(ptr, 1, &text_bound, 1, &text_bound, 1))
+        break;
+      if (kind == LEDGER_TABLE_HASH_INDEX){
+        int* positions = NULL;
+        if (ledger_table_find_in_column_index
+            (ptr, 0, &id_bound, 1, NULL, 0, &positions) != -1)
+          break;
+      } else {
+        if (!column_index_check(ptr, 0, &id_bound, 0, NULL, 0)) break;
+        if (!column_index_check(ptr, 1, &text_bound, 1, &text_high, 0))
+          break;
+      }
+      /* change, insert and drop rows */
+      if (!ledger_table_mark_seek(mark, 17)) break;
+      if (!ledger_table_put_id(mark, 0, 11)) break;
+      if (!ledger_table_put_string(mark, 1, (unsigned char const*)"k3"))
+        break;
+      if (!ledger_table_mark_seek(mark, 40)) break;
+      if (!ledger_table_add_row(mark)) break;
+      if (!ledger_table_put_id(mark, 0, 11)) break;
+      if (!ledger_table_mark_seek(mark, 5)) break;
+      if (!ledger_table_drop_row(mark)) break;
+      if (!ledger_table_mark_seek(mark, 150)) break;
+      if (!ledger_table_put_id(mark, 0, 11)) break;
+      if (!ledger_table_drop_row(mark)) break;
+      if (ledger_table_count_rows(ptr) != 199) break;
+      if (!column_index_check(ptr, 0, &id_bound, 1, &id_bound, 1)) break;
+      if (!column_index_check(ptr, 1, &text_bound, 1, &text_bound, 1))
+        break;
+      strcpy((char*)text, "");
+      if (!column_index_check(ptr, 1, &text_bound, 1, &text_bound, 1))
+        break;
+      if (kind == LEDGER_TABLE_ORDERED_INDEX){
+        id_bound.id = 20;
+        if (!column_index_check(ptr, 0, NULL, 0, &id_bound, 1)) break;
+      }
+      /* indexes survive a compatible schema change */
+      ledger_table_mark_free(mark);
+      mark = NULL;
+      column_types[0] = LEDGER_TABLE_BIGNUM;
+      if (!ledger_table_set_column_types(ptr, 3, column_types)) break;
+      if (ledger_table_get_column_index(ptr, 0) != 0) break;
+      if (ledger_table_get_column_index(ptr, 1) != kind) break;
+      if (!column_index_check(ptr, 1, &text_bound, 1, &text_bound, 1))
+        break;
+      if (!ledger_table_drop_column_index(ptr, 1)) break;
+      if (ledger_table_drop_column_index(ptr, 1)) break;
+      result = 1;
+    } while (0);
+    ledger_table_mark_free(mark);
+    ledger_table_free(ptr);
+    if (!result) break;
+  }
+  return result;
+}
+
+int date_cell_test(void){
+  int result = 0;
+  int variant;
+  for (variant = 0; variant < 2; ++variant){
+    struct ledger_table* ptr;
+    struct ledger_table_mark* mark = NULL;
+    ptr = variant ? ledger_table_new_columnar() : ledger_table_new();
+    result = 0;
+    if (ptr == NULL) break;
+    else do {
+      int const column_types[2] = { LEDGER_TABLE_DATE, LEDGER_TABLE_USTR };
+      struct ledger_table_field low, high;
+      unsigned char buf[32];
+      long long int value, other_value;
+      int k;
+      if (!ledger_table_set_column_types(ptr, 2, column_types)) break;
+      if (ledger_table_get_column_type(ptr, 0) != LEDGER_TABLE_DATE) break;
+      if (!ledger_table_add_column_index
+            (ptr, 0, LEDGER_TABLE_ORDERED_INDEX))
+        break;
+      mark = ledger_table_end(ptr);
+      if (mark == NULL) break;
+      for (k = 0; k < 60; ++k){
+        sprintf((char*)buf, "2020-%02i-%02i", (k*7)%12+1, k%28+1);
+        if (!ledger_table_add_row(mark)) break;
+        if (!ledger_table_put_string(mark, 0, buf)) break;
+        if (!ledger_table_put_string(mark, 1, buf)) break;
+        ledger_table_mark_move(mark, +1);
+      }
+      if (k < 60) break;
+      /* text round trip */
+      if (!ledger_table_mark_seek(mark, 3)) break;
+      if (ledger_table_fetch_string(mark, 0, buf, sizeof(buf)) != 10) break;
+      if (strcmp((char const*)buf, "2020-10-04") != 0) break;
+      if (!ledger_table_fetch_date(mark, 0, &value)) break;
+      if (!ledger_util_date_from_text(buf, &other_value)) break;
+      if (value != other_value) break;
+      /* dates are not numbers, and other text is kept as is */
+      if (ledger_table_put_id(mark, 0, 5)) break;
+      if (!ledger_table_put_string(mark, 0,
+            (unsigned char const*)"2020-02-30"))
+        break;
+      if (ledger_table_fetch_string(mark, 0, buf, sizeof(buf)) != 10) break;
+      if (strcmp((char const*)buf, "2020-02-30") != 0) break;
+      if (!ledger_table_fetch_date(mark, 0, &other_value)) break;
+      if (other_value >= -1) break;
+      if (!ledger_table_put_date(mark, 1, other_value)) break;
+      if (ledger_table_fetch_string(mark, 1, buf, sizeof(buf)) != 10) break;
+      if (strcmp((char const*)buf, "2020-02-30") != 0) break;
+      if (!ledger_table_put_date(mark, 0, value)) break;
+      if (!ledger_table_put_date(mark, 1, value)) break;
+      if (!ledger_table_fetch_date(mark, 0, &other_value)) break;
+      if (value != other_value) break;
+      /* text columns take dates as text */
+      if (!ledger_table_fetch_date(mark, 1, &other_value)) break;
+      if (value != other_value) break;
+      if (!ledger_table_put_date(mark, 1, value+1)) break;
+      if (ledger_table_fetch_string(mark, 1, buf, sizeof(buf)) != 16) break;
+      if (strcmp((char const*)buf, "2020-10-04T00:00") != 0) break;
+      /* clear a date */
+      if (!ledger_table_put_string(mark, 0, NULL)) break;
+      if (!ledger_table_fetch_date(mark, 0, &other_value)) break;
+      if (other_value != -1) break;
+      if (ledger_table_fetch_string(mark, 0, buf, sizeof(buf)) != 0) break;
+      /* date ranges through the index */
+      low.type = LEDGER_TABLE_DATE;
+      high.type = LEDGER_TABLE_DATE;
+      if (!ledger_util_date_from_text
+            ((unsigned char const*)"2020-03-01", &low.date))
+        break;
+      if (!ledger_util_date_from_text
+            ((unsigned char const*)"2020-06-30", &high.date))
+        break;
+      if (!column_index_check(ptr, 0, &low, 1, &high, 0)) break;
+      if (!column_index_check(ptr, 0, NULL, 0, &low, 1)) break;
+      result = 1;
+    } while (0);
+    ledger_table_mark_free(mark);
+    ledger_table_free(ptr);
+    if (!result) break;
+  }
+  return result;
+}
+
+int column_aggregate_check(struct ledger_table const* t, int column){
+  int ok = 0;
+  struct ledger_bignum* sum = ledger_bignum_new();
+  struct ledger_bignum* min = ledger_bignum_new();
+  struct ledger_bignum* max = ledger_bignum_new();
+  struct ledger_bignum* value = ledger_bignum_new();
+  struct ledger_bignum* expected = ledger_bignum_new();
+  if (sum != NULL && min != NULL && max != NULL
+  &&  value != NULL && expected != NULL) do
+  {
+    struct ledger_table_cursor cursor;
+    struct ledger_table_mark const* const mark =
+      ledger_table_cursor_mark(&cursor);
+    int count, expected_count = 0;
+    if (!ledger_table_fetch_column_aggregate(t, column, sum, min, max, &count))
+      break;
+    if (!ledger_bignum_set_long(expected, 0)) break;
+    ok = 1;
+    for (ledger_table_cursor_begin(&cursor, t);
+        ok && !ledger_table_cursor_is_end(&cursor);
+        ledger_table_cursor_move(&cursor, +1))
+    {
+      unsigned char buf[40];
+      /* unset cells hold no value */
+      if (ledger_table_get_column_type(t, column) == LEDGER_TABLE_BIGNUM
+      &&  ledger_table_fetch_string(mark, column, buf, sizeof(buf)) == 0)
+        continue;
+      if (!ledger_table_fetch_bignum(mark, column, value)){
+        ok = 0;
+        break;
+      }
+      expected_count += 1;
+      if (!ledger_bignum_add(expected, expected, value)) ok = 0;
+      /* the extremes must bound every value, and occur */
+      if (ledger_bignum_compare(value, min) < 0) ok = 0;
+      if (ledger_bignum_compare(value, max) > 0) ok = 0;
+      if (ledger_bignum_compare(value, min) == 0) ok |= 2;
+      if (ledger_bignum_compare(value, max) == 0) ok |= 4;
+    }
+    if (expected_count > 0 && ok != 7) ok = 0;
+    if (expected_count != count) ok = 0;
+    if (ledger_bignum_compare(expected, sum) != 0) ok = 0;
+  } while (0);
+  ledger_bignum_free(sum);
+  ledger_bignum_free(min);
+  ledger_bignum_free(max);
+  ledger_bignum_free(value);
+  ledger_bignum_free(expected);
+  return ok != 0;
+}
+
+int column_aggregate_test(void){
+  int result = 0;
+  int variant;
+  for (variant = 0; variant < 2; ++variant){
+    struct ledger_table* ptr;
+    struct ledger_table* copy = NULL;
+    struct ledger_table_mark* mark = NULL;
+    struct ledger_bignum* n = ledger_bignum_new();
+    ptr = variant ? ledger_table_new_columnar() : ledger_table_new();
+    result = 0;
+    if (ptr == NULL || n == NULL){
+      ledger_bignum_free(n);
+      ledger_table_free(ptr);
+      break;
+    } else do {
+      int column_types[3] =
+        { LEDGER_TABLE_ID, LEDGER_TABLE_BIGNUM, LEDGER_TABLE_USTR };
+      int k;
+      if (!ledger_table_set_column_types(ptr, 3, column_types)) break;
+      if (ledger_table_add_column_aggregate(ptr, 2)) break;
+      if (ledger_table_add_column_aggregate(ptr, 3)) break;
+      if (!ledger_table_add_column_aggregate(ptr, 1)) break;
+      if (!ledger_table_has_column_aggregate(ptr, 1)) break;
+      if (ledger_table_has_column_aggregate(ptr, 0)) break;
+      /* empty columns */
+      if (!column_aggregate_check(ptr, 1)) break;
+      mark = ledger_table_end(ptr);
+      if (mark == NULL) break;
+      for (k = 0; k < 40; ++k){
+        unsigned char text[16];
+        if (!ledger_table_add_row(mark)) break;
+        if (!ledger_table_put_id(mark, 0, (k*7)%23)) break;
+        if (k%5 == 4){
+          /* leave unset */;
+        } else if (k%2){
+          sprintf((char*)text, "%i.%02i", k*3-50, k);
+          if (!ledger_table_put_string(mark, 1, text)) break;
+        } else {
+          if (!ledger_bignum_set_long(n, 1000-k*k)) break;
+          if (!ledger_table_put_bignum(mark, 1, n)) break;
+        }
+        ledger_table_mark_move(mark, +1);
+      }
+      if (k < 40) break;
+      /* aggregates added to a full table scan it once */
+      if (!ledger_table_add_column_aggregate(ptr, 0)) break;
+      if (!column_aggregate_check(ptr, 0)) break;
+      if (!column_aggregate_check(ptr, 1)) break;
+      /* change the extremes, insert and drop */
+      if (!ledger_table_mark_seek(mark, 0)) break;
+      if (!ledger_table_put_string(mark, 1, (unsigned char const*)"-3.5"))
+        break;
+      if (!ledger_table_put_id(mark, 0, 100)) break;
+      if (!column_aggregate_check(ptr, 1)) break;
+      if (!ledger_table_mark_seek(mark, 39)) break;
+      if (!ledger_table_put_string(mark, 1, NULL)) break;
+      if (!ledger_table_mark_seek(mark, 12)) break;
+      if (!ledger_table_add_row(mark)) break;
+      if (!ledger_table_put_string(mark, 1,
+            (unsigned char const*)"123456789012345678901234.5"))
+        break;
+      if (!column_aggregate_check(ptr, 1)) break;
+      if (!ledger_table_drop_row(mark)) break;
+      if (!ledger_table_mark_seek(mark, 3)) break;
+      if (!ledger_table_drop_row(mark)) break;
+      if (!column_aggregate_check(ptr, 0)) break;
+      if (!column_aggregate_check(ptr, 1)) break;
+      /* copies keep the aggregates */
+      copy = ledger_table_copy(ptr);
+      if (copy == NULL) break;
+      if (!ledger_table_has_column_aggregate(copy, 1)) break;
+      if (!column_aggregate_check(copy, 1)) break;
+      /* schema changes keep the aggregates that still fit */
+      ledger_table_mark_free(mark);
+      mark = NULL;
+      column_types[0] = LEDGER_TABLE_USTR;
+      if (!ledger_table_set_column_types(ptr, 3, column_types)) break;
+      if (ledger_table_has_column_aggregate(ptr, 0)) break;
+      if (!ledger_table_has_column_aggregate(ptr, 1)) break;
+      if (!column_aggregate_check(ptr, 1)) break;
+      if (!ledger_table_drop_column_aggregate(ptr, 1)) break;
+      if (ledger_table_drop_column_aggregate(ptr, 1)) break;
+      if (ledger_table_fetch_column_aggregate(ptr, 1, n, NULL, NULL, NULL))
+        break;
+      result = 1;
+    } while (0);
+    ledger_table_mark_free(mark);
+    ledger_table_free(copy);
+    ledger_table_free(ptr);
+    ledger_bignum_free(n);
+    if (!result) break;
+  }
+  return result;
+}
+
+int column_prefix_check(struct ledger_table const* t){
+  int ok = 0;
+  struct ledger_bignum* sum = ledger_bignum_new();
+  struct ledger_bignum* value = ledger_bignum_new();
+  struct ledger_bignum* expected = ledger_bignum_new();
+  if (sum != NULL && value != NULL && expected != NULL){
+    int key;
+    ok = 1;
+    for (key = -2; ok && key <= 32; ++key){
+      struct ledger_table_cursor cursor;
+      struct ledger_table_mark const* const mark =
+        ledger_table_cursor_mark(&cursor);
+      if (!ledger_table_fetch_column_prefix(t, 1, 0, key, sum)){
+        ok = 0;
+        break;
+      }
+      if (!ledger_bignum_set_long(expected, 0)) ok = 0;
+      for (ledger_table_cursor_begin(&cursor, t);
+          ok && !ledger_table_cursor_is_end(&cursor);
+          ledger_table_cursor_move(&cursor, +1))
+      {
+        int id;
+        if (!ledger_table_fetch_id(mark, 0, &id)) ok = 0;
+        else if (id > key) continue;
+        if (!ledger_table_fetch_bignum(mark, 1, value)) ok = 0;
+        else if (!ledger_bignum_add(expected, expected, value)) ok = 0;
+      }
+      if (ledger_bignum_compare(expected, sum) != 0) ok = 0;
+    }
+  }
+  ledger_bignum_free(sum);
+  ledger_bignum_free(value);
+  ledger_bignum_free(expected);
+  return ok;
+}
+
+int column_prefix_test(void){
+  int result = 0;
+  int variant;
+  for (variant = 0; variant < 2; ++variant){
+    struct ledger_table* ptr;
+    struct ledger_table* copy = NULL;
+    struct ledger_table_mark* mark = NULL;
+    ptr = variant ? ledger_table_new_columnar() : ledger_table_new();
+    result = 0;
+    if (ptr == NULL) break;
+    else do {
+      int column_types[3] =
+        { LEDGER_TABLE_ID, LEDGER_TABLE_BIGNUM, LEDGER_TABLE_USTR };
+      struct ledger_bignum* n;
+      int k;
+      if (!ledger_table_set_column_types(ptr, 3, column_types)) break;
+      if (ledger_table_add_column_prefix(ptr, 2, 0)) break;
+      if (ledger_table_add_column_prefix(ptr, 1, 2)) break;
+      if (!ledger_table_add_column_prefix(ptr, 1, 0)) break;
+      if (!column_prefix_check(ptr)) break;
+      mark = ledger_table_end(ptr);
+      if (mark == NULL) break;
+      /* append in key order, querying along the way */
+      for (k = 0; k < 60; ++k){
+        unsigned char text[16];
+        if (!ledger_table_add_row(mark)) break;
+        if (!ledger_table_put_id(mark, 0, k/2)) break;
+        sprintf((char*)text, "%i.5", (k*17)%40-20);
+        if (k%7 != 3 && !ledger_table_put_string(mark, 1, text)) break;
+        ledger_table_mark_move(mark, +1);
+        if (k%13 == 0 && !column_prefix_check(ptr)) break;
+      }
+      if (k < 60) break;
+      if (!column_prefix_check(ptr)) break;
+      /* append out of order */
+      if (!ledger_table_add_row(mark)) break;
+      if (!ledger_table_put_id(mark, 0, 4)) break;
+      if (!ledger_table_put_string(mark, 1, (unsigned char const*)"1000"))
+        break;
+      if (!column_prefix_check(ptr)) break;
+      /* change, insert and drop rows inside the tree */
+      if (!ledger_table_mark_seek(mark, 10)) break;
+      if (!ledger_table_put_id(mark, 0, 25)) break;
+      if (!column_prefix_check(ptr)) break;
+      if (!ledger_table_put_string(mark, 1, (unsigned char const*)"-7"))
+        break;
+      if (!column_prefix_check(ptr)) break;
+      if (!ledger_table_add_row(mark)) break;
+      if (!ledger_table_put_id(mark, 0, 1)) break;
+      n = ledger_bignum_new();
+      if (n == NULL) break;
+      if (ledger_bignum_set_long(n, 300)) ledger_table_put_bignum(mark, 1, n);
+      ledger_bignum_free(n);
+      if (!column_prefix_check(ptr)) break;
+      if (!ledger_table_mark_seek(mark, 30)) break;
+      if (!ledger_table_drop_row(mark)) break;
+      if (!column_prefix_check(ptr)) break;
+      /* copies keep the prefix sums */
+      copy = ledger_table_copy(ptr);
+      if (copy == NULL) break;
+      if (!column_prefix_check(copy)) break;
+      /* schema changes keep the prefix sums that still fit */
+      ledger_table_mark_free(mark);
+      mark = NULL;
+      column_types[2] = LEDGER_TABLE_ID;
+      if (!ledger_table_set_column_types(ptr, 3, column_types)) break;
+      if (!column_prefix_check(ptr)) break;
+      if (!ledger_table_drop_column_prefix(ptr, 1, 0)) break;
+      if (ledger_table_drop_column_prefix(ptr, 1, 0)) break;
+      n = ledger_bignum_new();
+      if (n == NULL) break;
+      k = ledger_table_fetch_column_prefix(ptr, 1, 0, 10, n);
+      ledger_bignum_free(n);
+      if (k) break;
+      result = 1;
+    } while (0);
+    ledger_table_mark_free(mark);
+    ledger_table_free(copy);
+    ledger_table_free(ptr);
+    if (!result) break;
+  }
+  return result;
+}
+
+struct observer_log {
+  struct ledger_table* t;
+  int count;
+  int events[16];
+  int rows[16];
+  int columns[16];
+};
+
+void observer_record
+  ( void* arg, int event, struct ledger_table_mark const* mark,
+    int row, int column)
+{
+  struct observer_log* const log = (struct observer_log*)arg;
+  if (log->count < 16){
+    log->events[log->count] = event;
+    /* record -2 if the mark disagrees with the row */
+    log->rows[log->count] = (mark == NULL || row < 0)
+      ? row
+      : (ledger_table_mark_get_index(mark) == row ? row : -2);
+    log->columns[log->count] = column;
+  }
+  log->count += 1;
+  return;
+}
+
+void observer_dropper
+  ( void* arg, int event, struct ledger_table_mark const* mark,
+    int row, int column)
+{
+  struct observer_log* const log = (struct observer_log*)arg;
+  (void)event;
+  (void)mark;
+  (void)row;
+  (void)column;
+  log->count += 1;
+  ledger_table_drop_observer(log->t, observer_dropper, arg);
+  return;
+}
+
+int observer_test(void){
+  int result = 0;
+  int variant;
+  for (variant = 0; variant < 2; ++variant){
+    struct ledger_table* ptr;
+    struct ledger_table* copy = NULL;
+    struct ledger_table_mark* mark = NULL;
+    struct observer_log log = {NULL};
+    struct observer_log drops = {NULL};
+    ptr = variant ? ledger_table_new_columnar() : ledger_table_new();
+    result = 0;
+    if (ptr == NULL) break;
+    else do {
+      int column_types[2] = { LEDGER_TABLE_ID, LEDGER_TABLE_USTR };
+      int const expect_events[] = {
+          LEDGER_TABLE_ROW_ADDED, LEDGER_TABLE_CELL_PUT,
+          LEDGER_TABLE_ROW_ADDED, LEDGER_TABLE_CELL_PUT,
+          LEDGER_TABLE_ROW_DROPPED, LEDGER_TABLE_SCHEMA_RESET
+        };
+      int const expect_rows[] = { 0, 0, 0, 0, 1, -1 };
+      int const expect_columns[] = { -1, 1, -1, 0, -1, -1 };
+      int i;
+      if (!ledger_table_set_column_types(ptr, 2, column_types)) break;
+      if (!ledger_table_add_observer(ptr, observer_record, &log)) break;
+      drops.t = ptr;
+      if (!ledger_table_add_observer(ptr, observer_dropper, &drops)) break;
+      mark = ledger_table_end(ptr);
+      if (mark == NULL) break;
+      if (!ledger_table_add_row(mark)) break;
+      if (!ledger_table_put_string(mark, 1, (unsigned char const*)"a"))
+        break;
+      if (!ledger_table_mark_seek(mark, 0)) break;
+      if (!ledger_table_add_row(mark)) break;
+      if (!ledger_table_put_id(mark, 0, 7)) break;
+      /* failed puts go unreported */
+      if (ledger_table_put_id(mark, 5, 7) > 0) break;
+      /* copies do not inherit observers */
+      copy = ledger_table_copy(ptr);
+      if (copy == NULL) break;
+      {
+        struct ledger_table_mark* copy_mark = ledger_table_begin(copy);
+        if (copy_mark == NULL) break;
+        i = ledger_table_drop_row(copy_mark);
+        ledger_table_mark_free(copy_mark);
+        if (!i) break;
+      }
+      if (!ledger_table_mark_seek(mark, 1)) break;
+      if (!ledger_table_drop_row(mark)) break;
+      if (!ledger_table_set_column_types(ptr, 2, column_types)) break;
+      /* check the log */
+      if (log.count != 6) break;
+      for (i = 0; i < 6; ++i){
+        if (log.events[i] != expect_events[i]) break;
+        if (log.rows[i] != expect_rows[i]) break;
+        if (log.columns[i] != expect_columns[i]) break;
+      }
+      if (i < 6) break;
+      /* the dropper saw one change, then left */
+      if (drops.count != 1) break;
+      if (ledger_table_drop_observer(ptr, observer_dropper, &drops)) break;
+      if (!ledger_table_drop_observer(ptr, observer_record, &log)) break;
+      ledger_table_mark_free(mark);
+      mark = ledger_table_end(ptr);
+      if (mark == NULL) break;
+      if (!ledger_table_add_row(mark)) break;
+      if (log.count != 6) break;
+      result = 1;
+    } while (0);
+    ledger_table_mark_free(mark);
+    ledger_table_free(copy);
+    ledger_table_free(ptr);
+    if (!result) break;
+  }
+  return result;
+}
+
+int fingerprint_check(struct ledger_table const* t){
+  /* the running fingerprint must match a fresh copy's */
+  int result = 0;
+  struct ledger_table* copy = ledger_table_copy(t);
+  if (copy != NULL) do {
+    unsigned long long int a, b;
+    if (!ledger_table_get_fingerprint(t, &a)) break;
+    if (!ledger_table_get_fingerprint(copy, &b)) break;
+    if (a != b) break;
+    if (!ledger_table_is_equal(t, copy)) break;
+    result = 1;
+  } while (0);
+  ledger_table_free(copy);
+  return result;
+}
+
+int fingerprint_test(void){
+  int result = 0;
+  int variant;
+  for (variant = 0; variant < 2; ++variant){
+    struct ledger_table* ptr;
+    struct ledger_table* other = NULL;
+    struct ledger_table_mark* mark = NULL;
+    struct ledger_table_mark* other_mark = NULL;
+    ptr = variant ? ledger_table_new_columnar() : ledger_table_new();
+    other = ledger_table_new();
+    result = 0;
+    if (ptr == NULL || other == NULL) break;
+    else do {
+      int const column_types[4] = {
+          LEDGER_TABLE_ID, LEDGER_TABLE_BIGNUM,
+          LEDGER_TABLE_USTR, LEDGER_TABLE_DATE
+        };
+      unsigned long long int a, b;
+      int k;
+      if (!ledger_table_set_column_types(ptr, 4, column_types)) break;
+      if (!ledger_table_set_column_types(other, 4, column_types)) break;
+      if (!ledger_table_get_fingerprint(ptr, &a)) break;
+      if (a != 0u) break;
+      mark = ledger_table_end(ptr);
+      other_mark = ledger_table_end(other);
+      if (mark == NULL || other_mark == NULL) break;
+      /* fill with assorted values */
+      for (k = 0; k < 40; ++k){
+        unsigned char text[48];
+        if (!ledger_table_add_row(mark)) break;
+        if (!ledger_table_put_id(mark, 0, k%9)) break;
+        if (k%5 == 4)
+          sprintf((char*)text, "%i123456789012345678901234.%i", k, k%3);
+        else
+          sprintf((char*)text, "%i.%i0", k-20, k%10);
+        if (k%6 != 1 && !ledger_table_put_string(mark, 1, text)) break;
+        if (k%4 != 2 && !ledger_table_put_string(mark, 2, text)) break;
+        if (k%3 == 0 && !ledger_table_put_date(mark, 3, k*1000)) break;
+        ledger_table_mark_move(mark, +1);
+      }
+      if (k < 40) break;
+      if (!fingerprint_check(ptr)) break;
+      /* change and drop rows */
+      if (!ledger_table_mark_seek(mark, 7)) break;
+      if (!ledger_table_put_string(mark, 1, (unsigned char const*)"-0.5"))
+        break;
+      if (!ledger_table_put_string(mark, 2, NULL)) break;
+      if (!ledger_table_drop_row(mark)) break;
+      if (!ledger_table_mark_seek(mark, 3)) break;
+      if (!ledger_table_put_id(mark, 1, 12)) break;
+      if (!ledger_table_put_date(mark, 3, -1)) break;
+      if (!fingerprint_check(ptr)) break;
+      /* amounts that compare equal hash equal */
+      for (k = 0; k < 3; ++k){
+        static char const* const texts[3] = { "1.50", "2.0000", "0.05" };
+        if (!ledger_table_add_row(other_mark)) break;
+        if (!ledger_table_put_string
+            (other_mark, 1, (unsigned char const*)texts[k]))
+          break;
+      }
+      if (k < 3) break;
+      {
+        struct ledger_table* big = ledger_table_new();
+        struct ledger_table_mark* big_mark = NULL;
+        int ok = 0;
+        if (big != NULL) do {
+          if (!ledger_table_set_column_types(big, 4, column_types)) break;
+          big_mark = ledger_table_end(big);
+          if (big_mark == NULL) break;
+          for (k = 0; k < 3; ++k){
+            static char const* const texts[3] = { "1.5", "2", "0.050" };
+            if (!ledger_table_add_row(big_mark)) break;
+            /* promote, then put a small value with a long fraction */
+            if (!ledger_table_put_string(big_mark, 1,
+                (unsigned char const*)"987654321.00000000000000000000000001"))
+              break;
+            if (!ledger_table_put_string
+                (big_mark, 1, (unsigned char const*)texts[k]))
+              break;
+          }
+          if (k < 3) break;
+          if (!ledger_table_get_fingerprint(big, &a)) break;
+          if (!ledger_table_get_fingerprint(other, &b)) break;
+          if (a != b) break;
+          if (!ledger_table_is_equal(big, other)) break;
+          /* zero amounts hash like unset amounts */
+          if (!ledger_table_drop_row(big_mark)) break;
+          if (!ledger_table_mark_seek(big_mark, 0)) break;
+          if (!ledger_table_drop_row(big_mark)) break;
+          if (!ledger_table_mark_seek(big_mark, 0)) break;
+          if (!ledger_table_put_string
+              (big_mark, 1, (unsigned char const*)"-0.00"))
+            break;
+          if (!ledger_table_get_fingerprint(big, &a)) break;
+          if (a != 0u) break;
+          ok = 1;
+        } while (0);
+        ledger_table_mark_free(big_mark);
+        ledger_table_free(big);
+        if (!ok) break;
+      }
+      /* differing tables are told apart */
+      if (!ledger_table_put_string
+          (other_mark, 2, (unsigned char const*)"x"))
+        break;
+      if (!ledger_table_get_fingerprint(other, &a)) break;
+      if (!ledger_table_put_string
+          (other_mark, 2, (unsigned char const*)"y"))
+        break;
+      if (!ledger_table_get_fingerprint(other, &b)) break;
+      if (a == b) break;
+      if (!ledger_table_put_string
+          (other_mark, 2, (unsigned char const*)"x"))
+        break;
+      if (!ledger_table_get_fingerprint(other, &b)) break;
+      if (a != b) break;
+      /* schema resets clear the fingerprint */
+      ledger_table_mark_free(mark);
+      mark = NULL;
+      if (!ledger_table_set_column_types(ptr, 4, column_types)) break;
+      if (!ledger_table_get_fingerprint(ptr, &a)) break;
+      if (a != 0u) break;
+      result = 1;
+    } while (0);
+    ledger_table_mark_free(mark);
+    ledger_table_mark_free(other_mark);
+    ledger_table_free(other);
+    ledger_table_free(ptr);
+    if (!result) break;
+  }
+  return result;
+}
+int string_pool_test(void){
+  int result = 0;
+  struct ledger_table_pool* pool;
+  struct ledger_table* tables[2] = { NULL, NULL };
+  struct ledger_table* copy = NULL;
+  struct ledger_table_mark* marks[2] = { NULL, NULL };
+  pool = ledger_table_pool_new();
+  if (pool == NULL) return 0;
+  else do {
+    int const column_types[2] = { LEDGER_TABLE_ID, LEDGER_TABLE_USTR };
+    static char const* const texts[3] = {
+        "a string long enough to spill", "short", "another long string"
+      };
+    unsigned char buf[64];
+    int i, k;
+    tables[0] = ledger_table_new();
+    tables[1] = ledger_table_new_columnar();
+    if (tables[0] == NULL || tables[1] == NULL) break;
+    for (i = 0; i < 2; ++i){
+      if (!ledger_table_set_column_types(tables[i], 2, column_types)) break;
+      marks[i] = ledger_table_end(tables[i]);
+      if (marks[i] == NULL) break;
+      /* strings put before the pool stay private */
+      if (!ledger_table_add_row(marks[i])) break;
+      if (!ledger_table_put_string
+          (marks[i], 1, (unsigned char const*)texts[2]))
+        break;
+      ledger_table_mark_move(marks[i], +1);
+      ledger_table_set_pool(tables[i], pool);
+      if (ledger_table_get_pool(tables[i]) != pool) break;
+    }
+    if (i < 2) break;
+    if (ledger_table_pool_count(pool) != 0) break;
+    /* repeated strings are stored once across tables */
+    for (k = 0; k < 12; ++k){
+      i = k%2;
+      if (!ledger_table_add_row(marks[i])) break;
+      if (!ledger_table_put_string
+          (marks[i], 1, (unsigned char const*)texts[k%3]))
+        break;
+      ledger_table_mark_move(marks[i], +1);
+    }
+    if (k < 12) break;
+    if (ledger_table_pool_count(pool) != 2) break;
+    for (i = 0; i < 2; ++i){
+      if (!ledger_table_mark_seek(marks[i], 1)) break;
+      if (ledger_table_fetch_string(marks[i], 1, buf, sizeof(buf)) <= 0)
+        break;
+      if (strcmp((char const*)buf, texts[i]) != 0) break;
+    }
+    if (i < 2) break;
+    /* pooled and private strings compare by value */
+    if (!ledger_table_mark_seek(marks[0], 0)) break;
+    if (!ledger_table_put_string
+        (marks[0], 1, (unsigned char const*)texts[0]))
+      break;
+    if (!ledger_table_mark_seek(marks[0], 1)) break;
+    if (!ledger_table_put_string
+        (marks[0], 1, (unsigned char const*)texts[2]))
+      break;
+    if (ledger_table_pool_count(pool) != 2) break;
+    /* copies share the pooled strings */
+    copy = ledger_table_copy(tables[1]);
+    if (copy == NULL) break;
+    if (ledger_table_get_pool(copy) != pool) break;
+    if (!ledger_table_is_equal(copy, tables[1])) break;
+    if (ledger_table_pool_count(pool) != 2) break;
+    /* strings leave the pool with their last cell */
+    if (!ledger_table_put_string
+        (marks[0], 1, (unsigned char const*)"yet another long string"))
+      break;
+    if (ledger_table_pool_count(pool) != 3) break;
+    if (!ledger_table_drop_row(marks[0])) break;
+    if (ledger_table_pool_count(pool) != 2) break;
+    for (i = 0; i < 2; ++i){
+      ledger_table_mark_free(marks[i]);
+      marks[i] = NULL;
+      ledger_table_free(tables[i]);
+      tables[i] = NULL;
+    }
+    if (ledger_table_pool_count(pool) != 2) break;
+    ledger_table_free(copy);
+    copy = NULL;
+    if (ledger_table_pool_count(pool) != 0) break;
+    result = 1;
+  } while (0);
+  ledger_table_mark_free(marks[0]);
+  ledger_table_mark_free(marks[1]);
+  ledger_table_free(copy);
+  ledger_table_free(tables[0]);
+  ledger_table_free(tables[1]);
+  ledger_table_pool_free(pool);
+  return result;
+}
+
+int tombstone_test(void){
+  int result = 0;
+  struct ledger_table* tables[2] = { NULL, NULL };
+  int variant;
+  for (variant = 0; variant < 2; ++variant){
+    struct ledger_table* const ptr = variant
+      ? ledger_table_new_columnar() : ledger_table_new();
+    struct ledger_table_mark* mark = NULL;
+    struct ledger_table_mark* held = NULL;
+    tables[variant] = ptr;
+    result = 0;
+    if (ptr == NULL) break;
+    else do {
+      int const column_types[2] = { LEDGER_TABLE_ID, LEDGER_TABLE_USTR };
+      struct ledger_table_field key;
+      unsigned char buf[64];
+      int i, id;
+      if (!ledger_table_set_column_types(ptr, 2, column_types)) break;
+      if (!ledger_table_add_column_index(ptr, 0, LEDGER_TABLE_HASH_INDEX))
+        break;
+      if (!ledger_table_add_column_index(ptr, 1, LEDGER_TABLE_ORDERED_INDEX))
+        break;
+      if (!ledger_table_add_column_aggregate(ptr, 0)) break;
+      mark = ledger_table_end(ptr);
+      if (mark == NULL) break;
+      for (i = 0; i < 10; ++i){
+        /* every other string spills out of line */
+        sprintf((char*)buf, (i%2) ? "%i" : "row %i with a long name", i);
+        if (!ledger_table_add_row(mark)) break;
+        if (!ledger_table_put_id(mark, 0, i)) break;
+        if (!ledger_table_put_string(mark, 1, buf)) break;
+        ledger_table_mark_move(mark, +1);
+      }
+      if (i < 10) break;
+      /* hold a mark on a row about to go */
+      held = ledger_table_begin(ptr);
+      if (held == NULL) break;
+      if (!ledger_table_mark_seek(held, 4)) break;
+      ledger_table_set_tombstones(ptr, 1);
+      if (!ledger_table_get_tombstones(ptr)) break;
+      /* drop the even rows */
+      if (!ledger_table_mark_seek(mark, 0)) break;
+      while (ledger_table_mark_get_index(mark) < ledger_table_count_rows(ptr)){
+        if (!ledger_table_fetch_id(mark, 0, &id)) break;
+        if (id%2 == 0 && !ledger_table_drop_row(mark)) break;
+        ledger_table_mark_move(mark, +1);
+      }
+      if (ledger_table_mark_get_index(mark) != 5) break;
+      if (ledger_table_count_rows(ptr) != 5) break;
+      if (ledger_table_count_tombstones(ptr) != (variant ? 5 : 0)) break;
+      /* the dropped rows are gone for readers */
+      for (i = 0; i < 5; ++i){
+        if (!ledger_table_mark_seek(mark, i)) break;
+        if (ledger_table_mark_get_index(mark) != i) break;
+        if (!ledger_table_fetch_id(mark, 0, &id) || id != 2*i+1) break;
+      }
+      if (i < 5) break;
+      ledger_table_mark_move(mark, +1);
+      if (ledger_table_mark_get_index(mark) != 5) break;
+      ledger_table_mark_move(mark, -2);
+      if (!ledger_table_fetch_id(mark, 0, &id) || id != 7) break;
+      if (variant){
+        /* marks left on a tombstone see nothing there */
+        if (ledger_table_fetch_id(held, 0, &id) >= 0) break;
+        if (ledger_table_drop_row(held)) break;
+        if (ledger_table_mark_get_index(held) != 2) break;
+      }
+      /* derived data skips the tombstones */
+      key.type = LEDGER_TABLE_ID;
+      key.id = 5;
+      if (!column_index_check(ptr, 0, &key, 1, &key, 1)) break;
+      key.type = LEDGER_TABLE_USTR;
+      key.text = (unsigned char const*)"5";
+      if (!column_index_check(ptr, 1, NULL, 0, &key, 1)) break;
+      if (!column_aggregate_check(ptr, 0)) break;
+      if (!fingerprint_check(ptr)) break;
+      /* rows still come and go */
+      if (!ledger_table_mark_seek(mark, 5)) break;
+      if (!ledger_table_add_row(mark)) break;
+      if (!ledger_table_put_id(mark, 0, 11)) break;
+      if (!ledger_table_put_string
+          (mark, 1, (unsigned char const*)"row 11 with a long name"))
+        break;
+      if (!ledger_table_mark_seek(mark, 0)) break;
+      if (!ledger_table_add_row(mark)) break;
+      if (!ledger_table_put_id(mark, 0, -1)) break;
+      if (ledger_table_mark_get_index(mark) != 0) break;
+      if (!column_index_check(ptr, 1, NULL, 0, &key, 1)) break;
+      key.type = LEDGER_TABLE_ID;
+      key.id = -1;
+      if (!column_index_check(ptr, 0, &key, 1, &key, 1)) break;
+      if (!ledger_table_drop_row(mark)) break;
+      /* compact the table */
+      if (!ledger_table_vacuum(ptr)) break;
+      if (ledger_table_count_tombstones(ptr) != 0) break;
+      if (ledger_table_count_rows(ptr) != 6) break;
+      for (i = 0; i < 6; ++i){
+        if (!ledger_table_mark_seek(mark, i)) break;
+        if (!ledger_table_fetch_id(mark, 0, &id) || id != 2*i+1) break;
+        if (ledger_table_fetch_string(mark, 1, buf, sizeof(buf)) <= 0) break;
+        if (id == 11 && strcmp((char const*)buf, "row 11 with a long name"))
+          break;
+        if (id != 11 && atoi((char const*)buf) != id) break;
+      }
+      if (i < 6) break;
+      if (variant){
+        /* marks on tombstones land on the previous row */
+        if (ledger_table_mark_get_index(held) != 1) break;
+        if (!ledger_table_fetch_id(held, 0, &id) || id != 3) break;
+      }
+      for (i = -1; i < 12; ++i){
+        key.id = i;
+        if (!column_index_check(ptr, 0, &key, 1, &key, 1)) break;
+      }
+      if (i < 12) break;
+      if (!column_aggregate_check(ptr, 0)) break;
+      if (!fingerprint_check(ptr)) break;
+      /* drops without tombstones leave nothing behind */
+      ledger_table_set_tombstones(ptr, 0);
+      if (!ledger_table_mark_seek(mark, 0)) break;
+      if (!ledger_table_drop_row(mark)) break;
+      if (ledger_table_count_tombstones(ptr) != 0) break;
+      if (ledger_table_count_rows(ptr) != 5) break;
+      result = 1;
+    } while (0);
+    ledger_table_mark_free(held);
+    ledger_table_mark_free(mark);
+    if (!result) break;
+  }
+  /* both backends end up with the same rows */
+  if (result && !ledger_table_is_equal(tables[0], tables[1]))
+    result = 0;
+  ledger_table_free(tables[0]);
+  ledger_table_free(tables[1]);
+  return result;
+}
+
+
+int column_scan_check
+  (struct ledger_table const* t, int column, unsigned char const* bits)
+{
+  int ok = 0;
+  struct ledger_bignum* sum = ledger_bignum_new();
+  struct ledger_bignum* min = ledger_bignum_new();
+  struct ledger_bignum* max = ledger_bignum_new();
+  struct ledger_bignum* value = ledger_bignum_new();
+  struct ledger_bignum* expected = ledger_bignum_new();
+  if (sum != NULL && min != NULL && max != NULL
+  &&  value != NULL && expected != NULL) do
+  {
+    struct ledger_table_cursor cursor;
+    struct ledger_table_mark const* const mark =
+      ledger_table_cursor_mark(&cursor);
+    int count, expected_count = 0;
+    int position = 0;
+    if (!ledger_table_scan_column(t, column, bits, sum, min, max, &count))
+      break;
+    if (!ledger_bignum_set_long(expected, 0)) break;
+    ok = 1;
+    for (ledger_table_cursor_begin(&cursor, t);
+        ok && !ledger_table_cursor_is_end(&cursor);
+        ledger_table_cursor_move(&cursor, +1), ++position)
+    {
+      unsigned char buf[40];
+      if (bits != NULL && !((bits[position/8] >> (position%8)) & 1))
+        continue;
+      /* unset cells hold no value */
+      if (ledger_table_get_column_type(t, column) == LEDGER_TABLE_BIGNUM
+      &&  ledger_table_fetch_string(mark, column, buf, sizeof(buf)) == 0)
+        continue;
+      if (!ledger_table_fetch_bignum(mark, column, value)){
+        ok = 0;
+        break;
+      }
+      expected_count += 1;
+      if (!ledger_bignum_add(expected, expected, value)) ok = 0;
+      /* the extremes must bound every value, and occur */
+      if (ledger_bignum_compare(value, min) < 0) ok = 0;
+      if (ledger_bignum_compare(value, max) > 0) ok = 0;
+      if (ledger_bignum_compare(value, min) == 0) ok |= 2;
+      if (ledger_bignum_compare(value, max) == 0) ok |= 4;
+    }
+    if (expected_count > 0 && ok != 7) ok = 0;
+    if (expected_count == 0
+    &&  (ledger_bignum_get_long(min) != 0 || ledger_bignum_get_long(max) != 0))
+      ok = 0;
+    if (expected_count != count) ok = 0;
+    if (ledger_bignum_compare(expected, sum) != 0) ok = 0;
+  } while (0);
+  ledger_bignum_free(sum);
+  ledger_bignum_free(min);
+  ledger_bignum_free(max);
+  ledger_bignum_free(value);
+  ledger_bignum_free(expected);
+  return ok != 0;
+}
+
+int column_filter_check
+  ( struct ledger_table const* t, int column,
+    struct ledger_table_field const* low, int low_inclusive_tf,
+    struct ledger_table_field const* high, int high_inclusive_tf,
+    unsigned char* bits)
+{
+  int ok = 1;
+  int const count = ledger_table_filter_column
+    (t, column, low, low_inclusive_tf, high, high_inclusive_tf, bits);
+  struct ledger_table_cursor cursor;
+  struct ledger_table_mark const* const mark =
+    ledger_table_cursor_mark(&cursor);
+  struct ledger_bignum* value = ledger_bignum_new();
+  int position = 0;
+  int found = 0;
+  if (count < 0 || value == NULL){
+    ledger_bignum_free(value);
+    return 0;
+  }
+  for (ledger_table_cursor_begin(&cursor, t);
+      ok && !ledger_table_cursor_is_end(&cursor);
+      ledger_table_cursor_move(&cursor, +1), ++position)
+  {
+    int match = 1;
+    int low_cmp = 0, high_cmp = 0;
+    if (ledger_table_get_column_type(t, column) == LEDGER_TABLE_BIGNUM){
+      if (!ledger_table_fetch_bignum(mark, column, value))
+        ok = 0;
+      if (low != NULL)
+        low_cmp = ledger_bignum_compare(value, low->bignum);
+      if (high != NULL)
+        high_cmp = ledger_bignum_compare(value, high->bignum);
+    } else if (ledger_table_get_column_type(t, column) == LEDGER_TABLE_DATE){
+      long long int date;
+      if (!ledger_table_fetch_date(mark, column, &date))
+        ok = 0;
+      if (low != NULL)
+        low_cmp = (date < low->date) ? -1 : (date > low->date);
+      if (high != NULL)
+        high_cmp = (date < high->date) ? -1 : (date > high->date);
+    } else {
+      int id;
+      if (!ledger_table_fetch_id(mark, column, &id))
+        ok = 0;
+      if (low != NULL)
+        low_cmp = (id < low->id) ? -1 : (id > low->id);
+      if (high != NULL)
+        high_cmp = (id < high->id) ? -1 : (id > high->id);
+    }
+    if (low != NULL && (low_cmp < 0 || (low_cmp == 0 && !low_inclusive_tf)))
+      match = 0;
+    if (high != NULL
+    &&  (high_cmp > 0 || (high_cmp == 0 && !high_inclusive_tf)))
+      match = 0;
+    if (((bits[position/8] >> (position%8)) & 1) != match) ok = 0;
+    found += match;
+  }
+  ledger_bignum_free(value);
+  return ok && found == count;
+}
+
+int column_scan_test(void){
+  int result = 0;
+  int variant;
+  for (variant = 0; variant < 3; ++variant){
+    struct ledger_table* ptr;
+    struct ledger_table_mark* mark = NULL;
+    struct ledger_bignum* n = ledger_bignum_new();
+    struct ledger_bignum* m = ledger_bignum_new();
+    ptr = variant ? ledger_table_new_columnar() : ledger_table_new();
+    result = 0;
+    if (ptr == NULL || n == NULL || m == NULL){
+      ledger_bignum_free(m);
+      ledger_bignum_free(n);
+      ledger_table_free(ptr);
+      break;
+    } else do {
+      int const column_types[4] = {
+        LEDGER_TABLE_ID, LEDGER_TABLE_BIGNUM,
+        LEDGER_TABLE_DATE, LEDGER_TABLE_USTR
+      };
+      static char const* amount_bounds[] = {
+        "-100.5", "0", "500", "500.00", "999999999999999999",
+        "123456789012345678901234.5"
+      };
+      unsigned char bits[128];
+      struct ledger_table_field low, high;
+      int k;
+      if (!ledger_table_set_column_types(ptr, 4, column_types)) break;
+      /* empty columns */
+      if (!column_scan_check(ptr, 0, NULL)) break;
+      if (!column_scan_check(ptr, 1, NULL)) break;
+      mark = ledger_table_end(ptr);
+      if (mark == NULL) break;
+      /* more rows than one group of gathered cells */
+      for (k = 0; k < 600; ++k){
+        unsigned char text[40];
+        if (!ledger_table_add_row(mark)) break;
+        if (!ledger_table_put_id(mark, 0, (k%13 == 0) ? -5 : (k*37)%101))
+          break;
+        if (k%7 == 0){
+          /* leave unset */;
+        } else if (k%11 == 0){
+          sprintf((char*)text, "%s123456789012345678901234.5",
+              (k%2) ? "-" : "");
+          if (!ledger_table_put_string(mark, 1, text)) break;
+        } else if (k%5 == 1){
+          /* large enough to overflow an inline sum */
+          if (!ledger_table_put_string(mark, 1,
+                (unsigned char const*)"999999999999999999"))
+            break;
+        } else {
+          static char const* formats[3] = { "%i", "%i.5", "%i.125" };
+          sprintf((char*)text, formats[k%3], k*13-3000);
+          if (!ledger_table_put_string(mark, 1, text)) break;
+        }
+        if (!ledger_table_put_date
+            (mark, 2, (k%9 == 0) ? -1 : (long long int)(k%50)*1000+4))
+          break;
+        ledger_table_mark_move(mark, +1);
+      }
+      if (k < 600) break;
+      if (variant == 2){
+        /* scan around tombstones */
+        ledger_table_set_tombstones(ptr, 1);
+        for (k = 0; k < 150; ++k){
+          if (!ledger_table_mark_seek(mark, k*3)) break;
+          if (!ledger_table_drop_row(mark)) break;
+        }
+        if (k < 150) break;
+        if (ledger_table_count_tombstones(ptr) != 150) break;
+      }
+      /* whole columns */
+      if (!column_scan_check(ptr, 0, NULL)) break;
+      if (!column_scan_check(ptr, 1, NULL)) break;
+      if (ledger_table_scan_column(ptr, 2, NULL, n, NULL, NULL, NULL)) break;
+      if (ledger_table_scan_column(ptr, 3, NULL, n, NULL, NULL, NULL)) break;
+      /* identifiers */
+      low.type = LEDGER_TABLE_ID;
+      low.id = 20;
+      high.type = LEDGER_TABLE_ID;
+      high.id = 60;
+      if (!column_filter_check(ptr, 0, &low, 1, &high, 0, bits)) break;
+      if (!column_scan_check(ptr, 1, bits)) break;
+      if (!column_scan_check(ptr, 0, bits)) break;
+      if (!column_filter_check(ptr, 0, &low, 0, NULL, 0, bits)) break;
+      if (!column_filter_check(ptr, 0, NULL, 0, &low, 1, bits)) break;
+      if (!column_filter_check(ptr, 0, &high, 1, &high, 1, bits)) break;
+      low.id = -1;
+      if (!column_filter_check(ptr, 0, &low, 1, &low, 1, bits)) break;
+      if (!column_scan_check(ptr, 1, bits)) break;
+      /* dates */
+      low.type = LEDGER_TABLE_DATE;
+      low.date = 10004;
+      high.type = LEDGER_TABLE_DATE;
+      high.date = 30004;
+      if (!column_filter_check(ptr, 2, &low, 0, &high, 1, bits)) break;
+      if (!column_scan_check(ptr, 1, bits)) break;
+      if (!column_filter_check(ptr, 2, NULL, 0, &high, 0, bits)) break;
+      if (!column_scan_check(ptr, 1, bits)) break;
+      if (!column_filter_check(ptr, 2, &low, 1, NULL, 0, bits)) break;
+      /* amounts, against inline and promoted bounds */
+      low.type = LEDGER_TABLE_BIGNUM;
+      low.bignum = n;
+      high.type = LEDGER_TABLE_BIGNUM;
+      high.bignum = m;
+      for (k = 0; k < 6; ++k){
+        int j;
+        if (!ledger_bignum_set_text(n,
+              (unsigned char const*)amount_bounds[k], NULL))
+          break;
+        if (!column_filter_check(ptr, 1, &low, 1, NULL, 0, bits)) break;
+        if (!column_filter_check(ptr, 1, NULL, 0, &low, 0, bits)) break;
+        if (!column_filter_check(ptr, 1, &low, 1, &low, 1, bits)) break;
+        if (!column_scan_check(ptr, 1, bits)) break;
+        for (j = k; j < 6; ++j){
+          if (!ledger_bignum_set_text(m,
+                (unsigned char const*)amount_bounds[j], NULL))
+            break;
+          if (!column_filter_check(ptr, 1, &low, 0, &high, 1, bits)) break;
+          if (!column_scan_check(ptr, 1, bits)) break;
+          if (!column_scan_check(ptr, 0, bits)) break;
+        }
+        if (j < 6) break;
+      }
+      if (k < 6) break;
+      /* mismatched bounds and columns */
+      if (ledger_table_filter_column(ptr, 0, &low, 1, NULL, 0, bits) >= 0)
+        break;
+      if (ledger_table_filter_column(ptr, 3, NULL, 0, NULL, 0, bits) >= 0)
+        break;
+      result = 1;
+    } while (0);
+    ledger_table_mark_free(mark);
+    ledger_table_free(ptr);
+    ledger_bignum_free(m);
+    ledger_bignum_free(n);
+    if (!result) break;
+  }
+  return result;
+}
+
+int scale_column_test(void){
+  int result = 0;
+  int variant;
+  for (variant = 0; variant < 3; ++variant){
+    struct ledger_table* ptr;
+    struct ledger_table_mark* mark = NULL;
+    struct ledger_bignum* n = ledger_bignum_new();
+    struct ledger_bignum* numerator = ledger_bignum_new();
+    struct ledger_bignum* denominator = ledger_bignum_new();
+    struct ledger_bignum* sum = ledger_bignum_new();
+    struct observer_log log = {NULL};
+    ptr = variant ? ledger_table_new_columnar() : ledger_table_new();
+    result = 0;
+    if (ptr == NULL || n == NULL || numerator == NULL
+    ||  denominator == NULL || sum == NULL)
+    {
+      ledger_bignum_free(sum);
+      ledger_bignum_free(denominator);
+      ledger_bignum_free(numerator);
+      ledger_bignum_free(n);
+      ledger_table_free(ptr);
+      break;
+    } else do {
+      int const column_types[2] = { LEDGER_TABLE_ID, LEDGER_TABLE_BIGNUM };
+      static char expected[300][64];
+      unsigned char buf[64];
+      int k, rows;
+      if (!ledger_table_set_column_types(ptr, 2, column_types)) break;
+      mark = ledger_table_end(ptr);
+      if (mark == NULL) break;
+      for (k = 0; k < 300; ++k){
+        unsigned char text[48];
+        if (!ledger_table_add_row(mark)) break;
+        if (!ledger_table_put_id(mark, 0, k)) break;
+        if (k%7 == 0){
+          /* leave unset */;
+        } else if (k%11 == 0){
+          sprintf((char*)text, "%s123456789012345678901234.5",
+              (k%2) ? "-" : "");
+          if (!ledger_table_put_string(mark, 1, text)) break;
+        } else if (k%5 == 1){
+          /* inline now, too wide once scaled */
+          if (!ledger_table_put_string(mark, 1,
+                (unsigned char const*)"999999999999999999"))
+            break;
+        } else {
+          sprintf((char*)text, "%i.125", k*13-2000);
+          if (!ledger_table_put_string(mark, 1, text)) break;
+        }
+        ledger_table_mark_move(mark, +1);
+      }
+      if (k < 300) break;
+      if (variant == 2){
+        /* scale around tombstones */
+        ledger_table_set_tombstones(ptr, 1);
+        for (k = 0; k < 50; ++k){
+          if (!ledger_table_mark_seek(mark, k*4)) break;
+          if (!ledger_table_drop_row(mark)) break;
+        }
+        if (k < 50) break;
+      }
+      rows = ledger_table_count_rows(ptr);
+      if (!ledger_table_add_column_aggregate(ptr, 1)) break;
+      if (!ledger_table_fetch_column_aggregate(ptr, 1, sum, NULL, NULL, NULL))
+        break;
+      /* work out each product one number at a time */
+      if (!ledger_bignum_set_text
+          (numerator, (unsigned char const*)"-1.0825", NULL))
+        break;
+      if (!ledger_bignum_set_long(denominator, 3)) break;
+      for (k = 0; k < rows; ++k){
+        if (!ledger_table_mark_seek(mark, k)) break;
+        ledger_table_fetch_string(mark, 1, buf, sizeof(buf));
+        if (buf[0] == 0){
+          expected[k][0] = 0;
+          continue;
+        }
+        if (!ledger_bignum_alloc(n, 0, 0)) break;
+        if (!ledger_bignum_set_text(n, buf, NULL)) break;
+        if (!ledger_bignum_multiply_ratio(n, n, numerator, denominator, 1))
+          break;
+        ledger_bignum_get_text(n, (unsigned char*)expected[k], 64, 0);
+      }
+      if (k < rows) break;
+      log.t = ptr;
+      if (!ledger_table_add_observer(ptr, observer_record, &log)) break;
+      if (!ledger_table_scale_column(ptr, 1, numerator, denominator, 1))
+        break;
+      if (log.count != rows) break;
+      for (k = 0; k < rows; ++k){
+        if (!ledger_table_mark_seek(mark, k)) break;
+        ledger_table_fetch_string(mark, 1, buf, sizeof(buf));
+        if (strcmp((char const*)buf, expected[k]) != 0) break;
+      }
+      if (k < rows) break;
+      /* the summaries follow the new amounts */
+      if (!column_scan_check(ptr, 1, NULL)) break;
+      if (!ledger_table_fetch_column_aggregate(ptr, 1, sum, NULL, NULL, NULL))
+        break;
+      if (!ledger_table_scan_column(ptr, 1, NULL, n, NULL, NULL, NULL)) break;
+      if (ledger_bignum_compare(sum, n) != 0) break;
+      if (!fingerprint_check(ptr)) break;
+      /* only big number columns scale, and only by a ratio */
+      if (ledger_table_scale_column(ptr, 0, numerator, denominator, 1))
+        break;
+      if (!ledger_bignum_set_long(denominator, 0)) break;
+      if (ledger_table_scale_column(ptr, 1, numerator, denominator, 1))
+        break;
+      if (log.count != rows) break;
+      result = 1;
+    } while (0);
+    ledger_table_drop_observer(ptr, observer_record, &log);
+    ledger_table_mark_free(mark);
+    ledger_table_free(ptr);
+    ledger_bignum_free(sum);
+    ledger_bignum_free(denominator);
+    ledger_bignum_free(numerator);
+    ledger_bignum_free(n);
+    if (!result) break;
+  }
+  return result;
+}
 
 int main(int argc, char **argv){
   int pass_count = 0;
@@ -0,0 +1,745 @@
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#  define _POSIX_C_SOURCE 200809L
+#endif /*_POSIX_C_SOURCE*/
+#include "../src/base/book.h"
+#include "../src/base/ledger.h"
+#include "../src/base/account.h"
+#include "../src/base/journal.h"
+#include "../src/base/table.h"
+#include "../src/base/bignum.h"
+#include "../src/base/sum.h"
+#include "../src/base/util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <pthread.h>
+#endif /*_WIN32*/
+
+#ifdef _WIN32
+typedef HANDLE test_thread;
+#  define TEST_THREAD_FN(name) DWORD WINAPI name(LPVOID arg)
+#  define TEST_THREAD_RETURN return 0
+#else
+typedef pthread_t test_thread;
+#  define TEST_THREAD_FN(name) void* name(void* arg)
+#  define TEST_THREAD_RETURN return NULL
+#endif /*_WIN32*/
+
+/*
+ * maximum number of reader threads
+ */
+#define TEST_THREAD_MAX 8
+
+static int lock_nesting_test(void);
+static int lock_many_test(void);
+static int book_readers_test(void);
+static int mark_churn_test(void);
+static int snapshot_readers_test(void);
+static int row_readers_test(void);
+
+/*
+ * Start a thread.
+ * - th thread handle to fill
+ * - fn thread function
+ * - arg argument for the thread function
+ * @return one on success, zero otherwise
+ */
+static int test_thread_start
+  ( test_thread* th,
+#ifdef _WIN32
+    LPTHREAD_START_ROUTINE fn,
+#else
+    void* (*fn)(void*),
+#endif /*_WIN32*/
+    void* arg);
+
+/*
+ * Wait for a thread to finish.
+ * - th the thread to wait on
+ */
+static void test_thread_join(test_thread th);
+
+/*
+ * Append rows with whole amounts to a table, all at once.
+ * - t the table to modify, with an amount in column `column`
+ * - column the amount column
+ * - rows number of rows to append
+ * - amount amount to put in each row
+ * @return one on success, zero otherwise
+ */
+static int test_thread_append
+  (struct ledger_table* t, int column, int rows, int amount);
+
+struct test_struct {
+  int (*fn)(void);
+  char const* name;
+};
+
+struct test_struct test_array[] = {
+  { lock_nesting_test, "lock nesting" },
+  { lock_many_test, "many locks held at once" },
+  { book_readers_test, "book readers with a writer" },
+  { mark_churn_test, "mark churn" },
+  { snapshot_readers_test, "snapshot readers with a writer" },
+  { row_readers_test, "row readers with a writer" }
+};
+
+/*
+ * State shared by the book reader threads
+ */
+struct book_readers_state {
+  struct ledger_book* book;
+  /* number of transactions to post */
+  int posts;
+  /* set by the writer, under the book's write lock */
+  int done_tf;
+  /* per-thread results */
+  int reads[TEST_THREAD_MAX];
+  int failures[TEST_THREAD_MAX];
+};
+
+struct book_readers_arg {
+  struct book_readers_state* state;
+  int index;
+};
+
+/*
+ * State shared by the mark churn threads
+ */
+struct mark_churn_state {
+  struct ledger_table* table;
+  struct ledger_util_lock* done_lock;
+  int done_tf;
+  int failures[TEST_THREAD_MAX];
+};
+
+struct mark_churn_arg {
+  struct mark_churn_state* state;
+  int index;
+};
+
+/*
+ * State shared by the row reader threads
+ */
+struct row_readers_state {
+  struct ledger_table* table;
+  struct ledger_util_lock* done_lock;
+  /* number of balanced row pairs to append */
+  int pairs;
+  int done_tf;
+  /* per-thread results */
+  int reads[TEST_THREAD_MAX];
+  int failures[TEST_THREAD_MAX];
+};
+
+struct row_readers_arg {
+  struct row_readers_state* state;
+  int index;
+};
+
+static int const book_readers_count = 4;
+
+
+int test_thread_start
+  ( test_thread* th,
+#ifdef _WIN32
+    LPTHREAD_START_ROUTINE fn,
+#else
+    void* (*fn)(void*),
+#endif /*_WIN32*/
+    void* arg)
+{
+#ifdef _WIN32
+  *th = CreateThread(NULL, 0, fn, arg, 0, NULL);
+  return *th != NULL;
+#else
+  return pthread_create(th, NULL, fn, arg) == 0;
+#endif /*_WIN32*/
+}
+
+void test_thread_join(test_thread th){
+#ifdef _WIN32
+  WaitForSingleObject(th, INFINITE);
+  CloseHandle(th);
+#else
+  pthread_join(th, NULL);
+#endif /*_WIN32*/
+  return;
+}
+
+int test_thread_append
+  (struct ledger_table* t, int column, int rows, int amount)
+{
+  int result = 0;
+  struct ledger_table_mark* mark = ledger_table_end(t);
+  struct ledger_table_field* fields = (struct ledger_table_field*)malloc
+    (rows * sizeof(struct ledger_table_field));
+  struct ledger_bignum* value = ledger_bignum_new();
+  if (mark != NULL && fields != NULL && value != NULL) do {
+    int i;
+    if (!ledger_bignum_set_long(value, amount)) break;
+    memset(fields, 0, rows * sizeof(struct ledger_table_field));
+    for (i = 0; i < rows; ++i){
+      fields[i].column = column;
+      fields[i].type = LEDGER_TABLE_BIGNUM;
+      fields[i].bignum = value;
+    }
+    /* readers never see a row without its amount */
+    result = ledger_table_append_rows(mark, rows, 1, fields);
+  } while (0);
+  ledger_bignum_free(value);
+  free(fields);
+  ledger_table_mark_free(mark);
+  return result;
+}
+
+
+
+int lock_nesting_test(void){
+  int result = 0;
+  struct ledger_util_lock* lock = ledger_util_lock_new();
+  struct ledger_util_lock* other = ledger_util_lock_new();
+  if (lock == NULL || other == NULL){
+    ledger_util_lock_free(lock);
+    ledger_util_lock_free(other);
+    return 0;
+  } else do {
+    /* shared within shared */
+    ledger_util_lock_shared(lock);
+    ledger_util_lock_shared(lock);
+    ledger_util_unlock_shared(lock);
+    ledger_util_unlock_shared(lock);
+    /* shared within exclusive, and exclusive within that */
+    ledger_util_lock_exclusive(lock);
+    ledger_util_lock_shared(lock);
+    ledger_util_lock_exclusive(lock);
+    ledger_util_unlock_exclusive(lock);
+    ledger_util_unlock_shared(lock);
+    ledger_util_unlock_exclusive(lock);
+    /* two locks at once */
+    ledger_util_lock_shared(lock);
+    ledger_util_lock_exclusive(other);
+    ledger_util_unlock_shared(lock);
+    ledger_util_unlock_exclusive(other);
+    /* the locks must be free again */
+    ledger_util_lock_exclusive(lock);
+    ledger_util_unlock_exclusive(lock);
+    ledger_util_lock_exclusive(other);
+    ledger_util_unlock_exclusive(other);
+    /* NULL locks do nothing */
+    ledger_util_lock_shared(NULL);
+    ledger_util_unlock_shared(NULL);
+    result = 1;
+  } while (0);
+  ledger_util_lock_free(other);
+  ledger_util_lock_free(lock);
+  return result;
+}
+
+int lock_many_test(void){
+  int result = 0;
+  struct ledger_util_lock* locks[100];
+  int const lock_count = sizeof(locks)/sizeof(locks[0]);
+  int i;
+  for (i = 0; i < lock_count; ++i){
+    locks[i] = ledger_util_lock_new();
+    if (locks[i] == NULL) break;
+  }
+  if (i == lock_count) do {
+    /* more locks than the initial hold table, all still nesting */
+    for (i = 0; i < lock_count; ++i){
+      if (i%2 == 0) ledger_util_lock_exclusive(locks[i]);
+      else ledger_util_lock_shared(locks[i]);
+    }
+    ledger_util_lock_exclusive(locks[0]);
+    ledger_util_lock_shared(locks[lock_count-1]);
+    ledger_util_lock_exclusive(locks[lock_count-2]);
+    ledger_util_unlock_exclusive(locks[lock_count-2]);
+    ledger_util_unlock_shared(locks[lock_count-1]);
+    ledger_util_unlock_exclusive(locks[0]);
+    for (i = 0; i < lock_count; ++i){
+      if (i%2 == 0) ledger_util_unlock_exclusive(locks[i]);
+      else ledger_util_unlock_shared(locks[i]);
+    }
+    /* the locks must be free again */
+    for (i = 0; i < lock_count; ++i){
+      ledger_util_lock_exclusive(locks[i]);
+      ledger_util_unlock_exclusive(locks[i]);
+    }
+    result = 1;
+  } while (0);
+  while (i > 0){
+    i -= 1;
+    ledger_util_lock_free(locks[i]);
+  }
+  return result;
+}
+
+static TEST_THREAD_FN(book_writer_main){
+  struct book_readers_state* const state = (struct book_readers_state*)arg;
+  struct ledger_book* const book = state->book;
+  int i;
+  for (i = 0; i < state->posts; ++i){
+    struct ledger_ledger* ledger;
+    struct ledger_journal* journal;
+    ledger_book_write_lock(book);
+    ledger = ledger_book_get_ledger(book, 0);
+    journal = ledger_book_get_journal(book, 0);
+    /* post a balanced transaction */
+    test_thread_append(ledger_account_get_table
+        (ledger_ledger_get_account(ledger, 0)), 2, 1, +(i%7+1));
+    test_thread_append(ledger_account_get_table
+        (ledger_ledger_get_account(ledger, 1)), 2, 1, -(i%7+1));
+    ledger_journal_set_entry_count
+      (journal, ledger_journal_get_entry_count(journal)+1);
+    if (i+1 == state->posts)
+      state->done_tf = 1;
+    ledger_book_write_unlock(book);
+  }
+  TEST_THREAD_RETURN;
+}
+
+static TEST_THREAD_FN(book_reader_main){
+  struct book_readers_arg* const reader = (struct book_readers_arg*)arg;
+  struct book_readers_state* const state = reader->state;
+  struct ledger_book const* const book = state->book;
+  struct ledger_bignum* debits = ledger_bignum_new();
+  struct ledger_bignum* credits = ledger_bignum_new();
+  int done_tf = 0;
+  if (debits == NULL || credits == NULL){
+    state->failures[reader->index] += 1;
+  } else while (!done_tf){
+    struct ledger_ledger const* ledger;
+    struct ledger_journal const* journal;
+    struct ledger_table const* debit_table;
+    struct ledger_table const* credit_table;
+    ledger_book_read_lock(book);
+    done_tf = state->done_tf;
+    ledger = ledger_book_get_ledger_c(book, 0);
+    journal = ledger_book_get_journal_c(book, 0);
+    debit_table = ledger_account_get_table_c
+        (ledger_ledger_get_account_c(ledger, 0));
+    credit_table = ledger_account_get_table_c
+        (ledger_ledger_get_account_c(ledger, 1));
+    /* a reader sees whole transactions only */
+    if (!ledger_sum_table_column(debits, debit_table, 2)
+    ||  !ledger_sum_table_column(credits, credit_table, 2)
+    ||  ledger_bignum_get_long(debits) != -ledger_bignum_get_long(credits)
+    ||  ledger_table_count_rows(debit_table)
+          != ledger_journal_get_entry_count(journal)
+    ||  ledger_table_count_rows(credit_table)
+          != ledger_journal_get_entry_count(journal))
+    {
+      state->failures[reader->index] += 1;
+    }
+    state->reads[reader->index] += 1;
+    ledger_book_read_unlock(book);
+  }
+  ledger_bignum_free(credits);
+  ledger_bignum_free(debits);
+  TEST_THREAD_RETURN;
+}
+
+static TEST_THREAD_FN(snapshot_reader_main){
+  struct book_readers_arg* const reader = (struct book_readers_arg*)arg;
+  struct book_readers_state* const state = reader->state;
+  struct ledger_bignum* debits = ledger_bignum_new();
+  struct ledger_bignum* credits = ledger_bignum_new();
+  int done_tf = 0;
+  if (debits == NULL || credits == NULL){
+    state->failures[reader->index] += 1;
+  } else while (!done_tf){
+    struct ledger_book* snap;
+    struct ledger_ledger const* ledger;
+    struct ledger_journal const* journal;
+    struct ledger_table const* debit_table;
+    struct ledger_table const* credit_table;
+    ledger_book_read_lock(state->book);
+    done_tf = state->done_tf;
+    snap = ledger_book_snapshot(state->book);
+    ledger_book_read_unlock(state->book);
+    if (snap == NULL){
+      state->failures[reader->index] += 1;
+      break;
+    }
+    /* the writer keeps posting while the snapshot is read */
+    ledger = ledger_book_get_ledger_c(snap, 0);
+    journal = ledger_book_get_journal_c(snap, 0);
+    debit_table = ledger_account_get_table_c
+        (ledger_ledger_get_account_c(ledger, 0));
+    credit_table = ledger_account_get_table_c
+        (ledger_ledger_get_account_c(ledger, 1));
+    if (!ledger_sum_table_column(debits, debit_table, 2)
+    ||  !ledger_sum_table_column(credits, credit_table, 2)
+    ||  ledger_bignum_get_long(debits) != -ledger_bignum_get_long(credits)
+    ||  ledger_table_count_rows(debit_table)
+          != ledger_journal_get_entry_count(journal)
+    ||  ledger_table_count_rows(credit_table)
+          != ledger_journal_get_entry_count(journal))
+    {
+      state->failures[reader->index] += 1;
+    }
+    state->reads[reader->index] += 1;
+    ledger_book_free(snap);
+  }
+  ledger_bignum_free(credits);
+  ledger_bignum_free(debits);
+  TEST_THREAD_RETURN;
+}
+
+/*
+ * Run reader threads against a book while one thread posts to it.
+ * - reader_main the reader thread function
+ * @return one on success, zero otherwise
+ */
+static int book_readers_run
+  (
+#ifdef _WIN32
+    LPTHREAD_START_ROUTINE reader_main
+#else
+    void* (*reader_main)(void*)
+#endif /*_WIN32*/
+  )
+{
+  int result = 0;
+  struct book_readers_state state;
+  struct book_readers_arg args[TEST_THREAD_MAX];
+  test_thread readers[TEST_THREAD_MAX];
+  test_thread writer;
+  int started = 0;
+  int writer_tf = 0;
+  memset(&state, 0, sizeof(state));
+  state.posts = 2000;
+  state.book = ledger_book_new();
+  if (state.book == NULL) return 0;
+  else do {
+    int i;
+    if (!ledger_book_set_ledger_count(state.book, 1)) break;
+    if (!ledger_book_set_journal_count(state.book, 1)) break;
+    if (!ledger_ledger_set_account_count
+        (ledger_book_get_ledger(state.book, 0), 2))
+      break;
+    for (started = 0; started < book_readers_count; ++started){
+      args[started].state = &state;
+      args[started].index = started;
+      if (!test_thread_start(readers+started, reader_main, args+started))
+        break;
+    }
+    writer_tf = test_thread_start(&writer, book_writer_main, &state);
+    if (!writer_tf){
+      /* let the readers stop */
+      ledger_book_write_lock(state.book);
+      state.done_tf = 1;
+      ledger_book_write_unlock(state.book);
+    }
+    if (writer_tf) test_thread_join(writer);
+    for (i = 0; i < started; ++i){
+      test_thread_join(readers[i]);
+    }
+    if (!writer_tf || started < book_readers_count) break;
+    /* check the results */
+    for (i = 0; i < started; ++i){
+      if (state.failures[i] != 0 || state.reads[i] == 0) break;
+    }
+    if (i < started) break;
+    if (ledger_journal_get_entry_count(ledger_book_get_journal(state.book, 0))
+        != state.posts)
+      break;
+    result = 1;
+  } while (0);
+  ledger_book_free(state.book);
+  return result;
+}
+
+int book_readers_test(void){
+  return book_readers_run(book_reader_main);
+}
+
+int snapshot_readers_test(void){
+  return book_readers_run(snapshot_reader_main);
+}
+
+static TEST_THREAD_FN(mark_churn_main){
+  struct mark_churn_arg* const churn = (struct mark_churn_arg*)arg;
+  struct mark_churn_state* const state = churn->state;
+  struct ledger_table const* const t = state->table;
+  int done_tf = 0;
+  while (!done_tf){
+    struct ledger_table_mark* mark = ledger_table_begin_c(t);
+    struct ledger_table_mark* end = ledger_table_end_c(t);
+    int steps;
+    if (mark == NULL || end == NULL){
+      state->failures[churn->index] += 1;
+    } else for (steps = 0; steps < 100000; ++steps){
+      /* rows may vanish under the mark at any time */
+      long long int value;
+      int point_place;
+      if (ledger_table_mark_is_equal(mark, end)) break;
+      if (ledger_table_fetch_fixed(mark, 0, &value, &point_place)
+      &&  value != 1)
+      {
+        state->failures[churn->index] += 1;
+      }
+      (void)ledger_table_mark_get_index(mark);
+      ledger_table_mark_move(mark, +1);
+    }
+    ledger_table_mark_free(end);
+    ledger_table_mark_free(mark);
+    ledger_util_lock_shared(state->done_lock);
+    done_tf = state->done_tf;
+    ledger_util_unlock_shared(state->done_lock);
+  }
+  TEST_THREAD_RETURN;
+}
+
+/*
+ * Churn marks on a table from several threads while one thread
+ * adds and drops rows.
+ * - t the table to churn
+ * @return one on success, zero otherwise
+ */
+static int mark_churn_run(struct ledger_table* t){
+  int result = 0;
+  struct mark_churn_state state;
+  struct mark_churn_arg args[TEST_THREAD_MAX];
+  test_thread readers[TEST_THREAD_MAX];
+  int started = 0;
+  memset(&state, 0, sizeof(state));
+  state.table = t;
+  state.done_lock = ledger_util_lock_new();
+  if (t == NULL || state.done_lock == NULL){
+    ledger_util_lock_free(state.done_lock);
+    ledger_table_free(t);
+    return 0;
+  } else do {
+    int i;
+    int ok = 1;
+    int column_types[1] = { LEDGER_TABLE_BIGNUM };
+    if (!ledger_table_set_column_types(t, 1, column_types)) break;
+    if (!test_thread_append(t, 0, 64, 1)) break;
+    for (started = 0; started < book_readers_count; ++started){
+      args[started].state = &state;
+      args[started].index = started;
+      if (!test_thread_start(readers+started, mark_churn_main, args+started))
+        break;
+    }
+    /* add at the end, drop from the front */
+    for (i = 0; ok && i < 4000; ++i){
+      struct ledger_table_mark* front = ledger_table_begin(t);
+      if (front == NULL){
+        ok = 0;
+        break;
+      }
+      ok = ledger_table_drop_row(front);
+      ledger_table_mark_free(front);
+      if (ok) ok = test_thread_append(t, 0, 1, 1);
+    }
+    ledger_util_lock_exclusive(state.done_lock);
+    state.done_tf = 1;
+    ledger_util_unlock_exclusive(state.done_lock);
+    for (i = 0; i < started; ++i){
+      test_thread_join(readers[i]);
+    }
+    if (!ok || started < book_readers_count) break;
+    for (i = 0; i < started; ++i){
+      if (state.failures[i] != 0) break;
+    }
+    if (i < started) break;
+    if (ledger_table_count_rows(t) != 64) break;
+    result = 1;
+  } while (0);
+  ledger_util_lock_free(state.done_lock);
+  ledger_table_free(t);
+  return result;
+}
+
+int mark_churn_test(void){
+  if (!mark_churn_run(ledger_table_new())) return 0;
+  if (!mark_churn_run(ledger_table_new_columnar())) return 0;
+  return 1;
+}
+
+/*
+ * Walk a table row by row, checking that its rows come in balanced
+ * pairs: pair `k` holds the number `k` in both rows, and amounts that
+ * cancel out.
+ * - t table with a pair number and an amount in each row
+ * - hold_tf whether to hold the table for the whole walk
+ * @return the number of pairs seen, or -1 if the rows do not pair up
+ */
+static int row_readers_walk(struct ledger_table const* t, int hold_tf){
+  int pairs = -1;
+  struct ledger_table_mark* mark;
+  struct ledger_table_mark* end;
+  struct ledger_bignum* amount = ledger_bignum_new();
+  if (hold_tf) ledger_table_read_lock(t);
+  mark = ledger_table_begin_c(t);
+  end = ledger_table_end_c(t);
+  if (mark != NULL && end != NULL && amount != NULL){
+    int count = 0;
+    int ok = 1;
+    /* rows only ever arrive in whole pairs at the end */
+    while (ok && !ledger_table_mark_is_equal(mark, end)){
+      int id, half;
+      long int debit = 0;
+      for (half = 0; ok && half < 2; ++half){
+        if (half > 0 && ledger_table_mark_is_equal(mark, end)){
+          ok = 0;
+          break;
+        }
+        ok = (ledger_table_fetch_id(mark, 0, &id) == 1 && id == count
+          &&  ledger_table_fetch_bignum(mark, 1, amount) == 1);
+        if (!ok) break;
+        if (half == 0){
+          debit = ledger_bignum_get_long(amount);
+          ok = (debit == count%7+1);
+        } else ok = (ledger_bignum_get_long(amount) == -debit);
+        ledger_table_mark_move(mark, +1);
+      }
+      count += 1;
+    }
+    if (ok) pairs = count;
+  }
+  ledger_table_mark_free(end);
+  ledger_table_mark_free(mark);
+  if (hold_tf) ledger_table_read_unlock(t);
+  ledger_bignum_free(amount);
+  return pairs;
+}
+
+static TEST_THREAD_FN(row_reader_main){
+  struct row_readers_arg* const reader = (struct row_readers_arg*)arg;
+  struct row_readers_state* const state = reader->state;
+  struct ledger_bignum* sum = ledger_bignum_new();
+  int done_tf = 0;
+  int last_pairs = 0;
+  if (sum == NULL){
+    state->failures[reader->index] += 1;
+    done_tf = 1;
+  }
+  while (!done_tf){
+    int pairs;
+    ledger_util_lock_shared(state->done_lock);
+    done_tf = state->done_tf;
+    ledger_util_unlock_shared(state->done_lock);
+    /* alternate between holding the table and locking per call */
+    pairs = row_readers_walk(state->table, state->reads[reader->index]%2);
+    if (pairs < last_pairs || (done_tf && pairs != state->pairs))
+      state->failures[reader->index] += 1;
+    else last_pairs = pairs;
+    /* pairs balance, so every prefix of the table sums to zero */
+    if (!ledger_table_fetch_column_prefix(state->table, 1, 0, pairs, sum)
+    ||  ledger_bignum_get_long(sum) != 0)
+      state->failures[reader->index] += 1;
+    state->reads[reader->index] += 1;
+  }
+  ledger_bignum_free(sum);
+  TEST_THREAD_RETURN;
+}
+
+/*
+ * Read a table row by row and by prefix sums from several threads
+ * while one thread appends balanced pairs of rows.
+ * - t the table to read
+ * @return one on success, zero otherwise
+ */
+static int row_readers_run(struct ledger_table* t){
+  int result = 0;
+  struct row_readers_state state;
+  struct row_readers_arg args[TEST_THREAD_MAX];
+  test_thread readers[TEST_THREAD_MAX];
+  struct ledger_bignum* debit = ledger_bignum_new();
+  struct ledger_bignum* credit = ledger_bignum_new();
+  int started = 0;
+  memset(&state, 0, sizeof(state));
+  state.table = t;
+  state.pairs = 2000;
+  state.done_lock = ledger_util_lock_new();
+  if (t == NULL || state.done_lock == NULL
+  ||  debit == NULL || credit == NULL)
+  {
+    ledger_util_lock_free(state.done_lock);
+    ledger_bignum_free(credit);
+    ledger_bignum_free(debit);
+    ledger_table_free(t);
+    return 0;
+  } else do {
+    int i;
+    int ok = 1;
+    int column_types[2] = { LEDGER_TABLE_ID, LEDGER_TABLE_BIGNUM };
+    if (!ledger_table_set_column_types(t, 2, column_types)) break;
+    if (!ledger_table_add_column_prefix(t, 1, 0)) break;
+    for (started = 0; started < book_readers_count; ++started){
+      args[started].state = &state;
+      args[started].index = started;
+      if (!test_thread_start(readers+started, row_reader_main, args+started))
+        break;
+    }
+    /* append each pair in one call, so readers never see half */
+    for (i = 0; ok && i < state.pairs; ++i){
+      struct ledger_table_field fields[4];
+      struct ledger_table_mark* const mark = ledger_table_end(t);
+      memset(fields, 0, sizeof(fields));
+      ok = (mark != NULL
+        &&  ledger_bignum_set_long(debit, i%7+1)
+        &&  ledger_bignum_set_long(credit, -(i%7+1)));
+      fields[0].column = 0;
+      fields[0].type = LEDGER_TABLE_ID;
+      fields[0].id = i;
+      fields[1].column = 1;
+      fields[1].type = LEDGER_TABLE_BIGNUM;
+      fields[1].bignum = debit;
+      fields[2] = fields[0];
+      fields[3] = fields[1];
+      fields[3].bignum = credit;
+      if (ok) ok = ledger_table_append_rows(mark, 2, 2, fields);
+      ledger_table_mark_free(mark);
+    }
+    ledger_util_lock_exclusive(state.done_lock);
+    state.done_tf = 1;
+    ledger_util_unlock_exclusive(state.done_lock);
+    for (i = 0; i < started; ++i){
+      test_thread_join(readers[i]);
+    }
+    if (!ok || started < book_readers_count) break;
+    for (i = 0; i < started; ++i){
+      if (state.failures[i] != 0 || state.reads[i] == 0) break;
+    }
+    if (i < started) break;
+    if (row_readers_walk(t, 0) != state.pairs) break;
+    result = 1;
+  } while (0);
+  ledger_util_lock_free(state.done_lock);
+  ledger_bignum_free(credit);
+  ledger_bignum_free(debit);
+  ledger_table_free(t);
+  return result;
+}
+
+int row_readers_test(void){
+  if (!row_readers_run(ledger_table_new())) return 0;
+  if (!row_readers_run(ledger_table_new_columnar())) return 0;
+  return 1;
+}
+
+
+int main(int argc, char **argv){
+  int pass_count = 0;
+  int const test_count = sizeof(test_array)/sizeof(test_array[0]);
+  int i;
+  printf("Running %i tests...\n", test_count);
+  for (i = 0; i < test_count; ++i){
+    int pass_value;
+    printf("\t%s... ", test_array[i].name);
+    fflush(stdout);
+    pass_value = ((*test_array[i].fn)())?1:0;
+    printf("%s\n",pass_value==0?"FAILED":"PASSED");
+    pass_count += pass_value;
+  }
+  printf("...%i out of %i tests passed.\n", pass_count, test_count);
+  return pass_count==test_count?EXIT_SUCCESS:EXIT_FAILURE;
+}
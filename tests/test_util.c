@@ -22,6 +22,9 @@ static int atoi_test(void);
 static int string_ndup_test(void);
 static int string_ncmp_test(void);
 static int trivial_string_ncmp_test(void);
+static int arena_test(void);
+static int date_test(void);
+static int date_text_test(void);
 
 struct test_struct {
   int (*fn)(void);
@@ -44,7 +47,10 @@ struct test_struct test_array[] = {
   { atoi_test, "string to integer" },
   { string_ndup_test, "string length-restricted duplicate" },
   { string_ncmp_test, "string length-restricted compare" },
-  { trivial_string_ncmp_test, "trivial string length-restricted compare" }
+  { trivial_string_ncmp_test, "trivial string length-restricted compare" },
+  { arena_test, "arena" },
+  { date_test, "date packing" },
+  { date_text_test, "text kept in place of dates" }
 };
 
 
@@ -339,6 +345,117 @@ int string_ncmp_test(void){
 
 
 
+int arena_test(void){
+  int result = 0;
+  struct ledger_util_arena* arena;
+  arena = ledger_util_arena_new(64);
+  if (arena == NULL) return 0;
+  else do {
+    int ok;
+    int i;
+    unsigned char* text;
+    unsigned char* other_text;
+    void* block;
+    if (ledger_util_arena_alloc(arena, 0) != NULL) break;
+    /* many small strings */
+    text = ledger_util_arena_ustrdup
+      (arena, (unsigned char const*)"text", &ok);
+    if (!ok) break;
+    if (text == NULL) break;
+    for (i = 0; i < 100; ++i){
+      other_text = ledger_util_arena_ustrdup
+        (arena, (unsigned char const*)"other", &ok);
+      if (!ok || other_text == NULL) break;
+      if (other_text == text) break;
+    }
+    if (i < 100) break;
+    if (strcmp((char const*)text, "text")) break;
+    if (strcmp((char const*)other_text, "other")) break;
+    /* null strings */
+    other_text = ledger_util_arena_ustrdup(arena, NULL, &ok);
+    if (!ok) break;
+    if (other_text != NULL) break;
+    /* a block larger than a chunk */
+    block = ledger_util_arena_alloc(arena, 1000);
+    if (block == NULL) break;
+    memset(block, 0x55, 1000);
+    if (strcmp((char const*)text, "text")) break;
+    result = 1;
+  } while (0);
+  ledger_util_arena_free(arena);
+  return result;
+}
+
+int date_test(void){
+  static char const* good[] = {
+    "2019-03-04", "2019-03-04T05:06", "2019-03-04T05:06:07",
+    "2019-03-04T05:06:07Z", "2000-02-29", "0001-01-01", "9999-12-31"
+  };
+  static char const* bad[] = {
+    "", "2019", "2019-3-04", "2019-13-01", "2019-02-29", "1900-02-29",
+    "2019-04-31", "2019-03-04T", "2019-03-04T24:00", "2019-03-04T05:06:",
+    "2019-03-04T05:06:07Y", "2019-03-04 "
+  };
+  int const good_count = sizeof(good)/sizeof(good[0]);
+  int const bad_count = sizeof(bad)/sizeof(bad[0]);
+  int i;
+  long long int previous = -1;
+  for (i = 0; i < good_count; ++i){
+    long long int value = -1;
+    unsigned char buf[24];
+    if (!ledger_util_date_from_text((unsigned char const*)good[i], &value))
+      return 0;
+    if (ledger_util_date_to_text(value, buf, sizeof(buf)) != strlen(good[i]))
+      return 0;
+    if (strcmp((char const*)buf, good[i]) != 0) return 0;
+    /* truncated output still reports the full length */
+    if (ledger_util_date_to_text(value, buf, 5) != strlen(good[i]))
+      return 0;
+    if (strcmp((char const*)buf, "2019") != 0 && i < 4) return 0;
+    /* packed order follows text order */
+    if (i > 0 && i < 4 && value <= previous) return 0;
+    previous = value;
+  }
+  for (i = 0; i < bad_count; ++i){
+    long long int value = 7;
+    if (ledger_util_date_from_text((unsigned char const*)bad[i], &value))
+      return 0;
+    if (value != 7) return 0;
+  }
+  if (ledger_util_date_from_text(NULL, &previous)) return 0;
+  if (ledger_util_date_to_text(-1, NULL, 0) != 0) return 0;
+  return 1;
+}
+
+int date_text_test(void){
+  long long int values[40];
+  int i;
+  for (i = 0; i < 40; ++i){
+    unsigned char buf[16];
+    sprintf((char*)buf, "day %i", i);
+    if (!ledger_util_date_keep_text(buf, &values[i])) return 0;
+    if (values[i] >= -1) return 0;
+    if (i > 0 && values[i] == values[i-1]) return 0;
+  }
+  /* the same text gives the same value, after the table grew */
+  for (i = 0; i < 40; ++i){
+    unsigned char buf[16];
+    long long int value;
+    unsigned char const* text;
+    sprintf((char*)buf, "day %i", i);
+    if (!ledger_util_date_keep_text(buf, &value)) return 0;
+    if (value != values[i]) return 0;
+    text = ledger_util_date_kept_text(value);
+    if (text == NULL || strcmp((char const*)text, (char const*)buf) != 0)
+      return 0;
+  }
+  if (ledger_util_date_kept_text(-1) != NULL) return 0;
+  if (ledger_util_date_kept_text(0) != NULL) return 0;
+  if (ledger_util_date_kept_text(-1000000) != NULL) return 0;
+  if (ledger_util_date_keep_text(NULL, &values[0])) return 0;
+  return 1;
+}
+
 int main(int argc, char **argv){
   int pass_count = 0;
   int const test_count = sizeof(test_array)/sizeof(test_array[0]);